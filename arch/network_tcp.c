@@ -21,6 +21,10 @@
 
 #include <string.h>  // memset
 
+#ifdef UA_DEBUG_CAPTURE_PKGS
+#include <stdio.h>
+#endif
+
 #ifndef MSG_NOSIGNAL
 #define MSG_NOSIGNAL 0
 #endif
@@ -165,8 +169,21 @@ connection_recv(UA_Connection *connection, UA_ByteString *response,
 typedef struct ConnectionEntry {
     UA_Connection connection;
     LIST_ENTRY(ConnectionEntry) pointers;
+#ifdef UA_DEBUG_CAPTURE_PKGS
+    UA_UInt32 captureId;
+#endif
 } ConnectionEntry;
 
+/* Socket of another subsystem that is selected together with the
+ * connections. The callback is NULL if the socket was unwatched during the
+ * dispatch. The entry is then removed afterwards. */
+typedef struct WatchedSocketEntry {
+    LIST_ENTRY(WatchedSocketEntry) pointers;
+    UA_SOCKET sockfd;
+    UA_ServerNetworkLayerSocketCallback callback;
+    void *context;
+} WatchedSocketEntry;
+
 typedef struct {
     const UA_Logger *logger;
     UA_UInt16 port;
@@ -175,8 +192,112 @@ typedef struct {
     UA_UInt16 serverSocketsSize;
     LIST_HEAD(, ConnectionEntry) connections;
     UA_UInt16 connectionsSize;
+    LIST_HEAD(, WatchedSocketEntry) watchedSockets;
+    UA_Boolean dispatchingWatched;
+#ifdef UA_DEBUG_CAPTURE_PKGS
+    FILE *capture;
+    UA_DateTime captureStart;
+    UA_UInt32 captureLastId;
+#endif
 } ServerNetworkLayerTCP;
 
+#ifdef UA_DEBUG_CAPTURE_PKGS
+
+static void
+captureWriteUInt32(UA_Byte *pos, UA_UInt32 v) {
+    pos[0] = (UA_Byte)v;
+    pos[1] = (UA_Byte)(v >> 8);
+    pos[2] = (UA_Byte)(v >> 16);
+    pos[3] = (UA_Byte)(v >> 24);
+}
+
+static void
+captureWriteInt64(UA_Byte *pos, UA_Int64 v) {
+    captureWriteUInt32(pos, (UA_UInt32)(UA_UInt64)v);
+    captureWriteUInt32(&pos[4], (UA_UInt32)((UA_UInt64)v >> 32));
+}
+
+static void
+captureRecord(ServerNetworkLayerTCP *layer, ConnectionEntry *e,
+              UA_CaptureRecordType type, const UA_ByteString *content) {
+    if(!layer->capture || e->captureId == 0)
+        return;
+    size_t length = content ? content->length : 0;
+    UA_Byte header[UA_CAPTURE_RECORDHEADERSIZE];
+    captureWriteInt64(header, UA_DateTime_nowMonotonic() - layer->captureStart);
+    captureWriteUInt32(&header[8], e->captureId);
+    header[12] = (UA_Byte)type;
+    captureWriteUInt32(&header[13], (UA_UInt32)length);
+    if(fwrite(header, UA_CAPTURE_RECORDHEADERSIZE, 1, layer->capture) != 1 ||
+       (length > 0 && fwrite(content->data, length, 1, layer->capture) != 1)) {
+        UA_LOG_ERROR(layer->logger, UA_LOGCATEGORY_NETWORK,
+                     "Writing the capture failed. Stop capturing.");
+        fclose(layer->capture);
+        layer->capture = NULL;
+    }
+}
+
+static void
+captureOpened(ServerNetworkLayerTCP *layer, ConnectionEntry *e) {
+    e->captureId = 0;
+    if(!layer->capture)
+        return;
+    e->captureId = ++layer->captureLastId;
+    captureRecord(layer, e, UA_CAPTURERECORDTYPE_OPENED, NULL);
+}
+
+static void
+captureClosed(ServerNetworkLayerTCP *layer, ConnectionEntry *e) {
+    captureRecord(layer, e, UA_CAPTURERECORDTYPE_CLOSED, NULL);
+}
+
+/* Server connections use this send function while the capture runs. The
+ * UA_Connection is the first member of the ConnectionEntry. */
+static UA_StatusCode
+connection_write_capture(UA_Connection *connection, UA_ByteString *buf) {
+    ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP*)connection->handle;
+    if(connection->state != UA_CONNECTIONSTATE_CLOSED)
+        captureRecord(layer, (ConnectionEntry*)connection,
+                      UA_CAPTURERECORDTYPE_SENT, buf);
+    return connection_write(connection, buf);
+}
+
+UA_StatusCode
+UA_ServerNetworkLayerTCP_capture(UA_ServerNetworkLayer *nl, const char *filename) {
+    ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP *)nl->handle;
+    if(!layer)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* Stop the running capture. Connections opened before a new capture are
+     * not recorded (captureId is zero). */
+    if(layer->capture) {
+        fclose(layer->capture);
+        layer->capture = NULL;
+        ConnectionEntry *e;
+        LIST_FOREACH(e, &layer->connections, pointers)
+            e->captureId = 0;
+    }
+    if(!filename)
+        return UA_STATUSCODE_GOOD;
+
+    layer->capture = fopen(filename, "wb");
+    if(!layer->capture)
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    layer->captureStart = UA_DateTime_nowMonotonic();
+    UA_Byte header[UA_CAPTURE_HEADERSIZE];
+    captureWriteUInt32(header, UA_CAPTURE_MAGIC);
+    captureWriteUInt32(&header[4], UA_CAPTURE_VERSION);
+    captureWriteInt64(&header[8], UA_DateTime_now());
+    if(fwrite(header, UA_CAPTURE_HEADERSIZE, 1, layer->capture) != 1) {
+        fclose(layer->capture);
+        layer->capture = NULL;
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+#endif /* UA_DEBUG_CAPTURE_PKGS */
+
 static void
 ServerNetworkLayerTCP_freeConnection(UA_Connection *connection) {
     UA_free(connection);
@@ -197,6 +318,9 @@ purgeFirstConnectionWithoutChannel(ServerNetworkLayerTCP *layer) {
     ConnectionEntry *e;
     LIST_FOREACH(e, &layer->connections, pointers) {
         if(e->connection.channel == NULL) {
+#ifdef UA_DEBUG_CAPTURE_PKGS
+            captureClosed(layer, e);
+#endif
             LIST_REMOVE(e, pointers);
             layer->connectionsSize--;
             UA_close(e->connection.sockfd);
@@ -270,6 +394,12 @@ ServerNetworkLayerTCP_add(UA_ServerNetworkLayer *nl, ServerNetworkLayerTCP *laye
     c->state = UA_CONNECTIONSTATE_OPENING;
     c->openingDate = UA_DateTime_nowMonotonic();
 
+#ifdef UA_DEBUG_CAPTURE_PKGS
+    captureOpened(layer, e);
+    if(layer->capture)
+        c->send = connection_write_capture;
+#endif
+
     layer->connectionsSize++;
 
     /* Add to the linked list */
@@ -481,16 +611,88 @@ setFDSet(ServerNetworkLayerTCP *layer, fd_set *fdset) {
             highestfd = (UA_Int32)e->connection.sockfd;
     }
 
+    WatchedSocketEntry *w;
+    LIST_FOREACH(w, &layer->watchedSockets, pointers) {
+        UA_fd_set(w->sockfd, fdset);
+        if((UA_Int32)w->sockfd > highestfd)
+            highestfd = (UA_Int32)w->sockfd;
+    }
+
     return highestfd;
 }
 
+static UA_StatusCode
+ServerNetworkLayerTCP_watchSocket(UA_ServerNetworkLayer *nl, UA_SOCKET sockfd,
+                                  UA_ServerNetworkLayerSocketCallback callback,
+                                  void *context) {
+    ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP *)nl->handle;
+    if(!layer || !callback || sockfd == UA_INVALID_SOCKET)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    WatchedSocketEntry *w;
+    LIST_FOREACH(w, &layer->watchedSockets, pointers) {
+        if(w->sockfd == sockfd && w->callback)
+            return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    w = (WatchedSocketEntry*)UA_malloc(sizeof(WatchedSocketEntry));
+    if(!w)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    w->sockfd = sockfd;
+    w->callback = callback;
+    w->context = context;
+    LIST_INSERT_HEAD(&layer->watchedSockets, w, pointers);
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+ServerNetworkLayerTCP_unwatchSocket(UA_ServerNetworkLayer *nl, UA_SOCKET sockfd) {
+    ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP *)nl->handle;
+    if(!layer)
+        return;
+    WatchedSocketEntry *w;
+    LIST_FOREACH(w, &layer->watchedSockets, pointers) {
+        if(w->sockfd != sockfd || !w->callback)
+            continue;
+        /* Removed after the dispatch loop */
+        if(layer->dispatchingWatched) {
+            w->callback = NULL;
+            return;
+        }
+        LIST_REMOVE(w, pointers);
+        UA_free(w);
+        return;
+    }
+}
+
+static void
+dispatchWatchedSockets(ServerNetworkLayerTCP *layer, UA_Server *server,
+                       fd_set *fdset) {
+    layer->dispatchingWatched = true;
+    WatchedSocketEntry *w;
+    LIST_FOREACH(w, &layer->watchedSockets, pointers) {
+        if(w->callback && UA_fd_isset(w->sockfd, fdset))
+            w->callback(server, w->sockfd, w->context);
+    }
+    layer->dispatchingWatched = false;
+
+    /* Remove the entries that were unwatched from within the callbacks */
+    WatchedSocketEntry *w_tmp;
+    LIST_FOREACH_SAFE(w, &layer->watchedSockets, pointers, w_tmp) {
+        if(w->callback)
+            continue;
+        LIST_REMOVE(w, pointers);
+        UA_free(w);
+    }
+}
+
 static UA_StatusCode
 ServerNetworkLayerTCP_listen(UA_ServerNetworkLayer *nl, UA_Server *server,
                              UA_UInt16 timeout) {
     /* Every open socket can generate two jobs */
     ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP *)nl->handle;
 
-    if(layer->serverSocketsSize == 0)
+    if(layer->serverSocketsSize == 0 && LIST_EMPTY(&layer->watchedSockets))
         return UA_STATUSCODE_GOOD;
 
     /* Listen on open sockets (including the server) */
@@ -506,6 +708,9 @@ ServerNetworkLayerTCP_listen(UA_ServerNetworkLayer *nl, UA_Server *server,
         return UA_STATUSCODE_GOOD;
     }
 
+    /* Process the watched sockets of other subsystems */
+    dispatchWatchedSockets(layer, server, &fdset);
+
     /* Accept new connections via the server sockets */
     for(UA_UInt16 i = 0; i < layer->serverSocketsSize; i++) {
         if(!UA_fd_isset(layer->serverSockets[i], &fdset))
@@ -536,6 +741,9 @@ ServerNetworkLayerTCP_listen(UA_ServerNetworkLayer *nl, UA_Server *server,
             UA_LOG_INFO(layer->logger, UA_LOGCATEGORY_NETWORK,
                         "Connection %i | Closed by the server (no Hello Message)",
                          (int)(e->connection.sockfd));
+#ifdef UA_DEBUG_CAPTURE_PKGS
+            captureClosed(layer, e);
+#endif
             LIST_REMOVE(e, pointers);
             layer->connectionsSize--;
             UA_close(e->connection.sockfd);
@@ -559,6 +767,9 @@ ServerNetworkLayerTCP_listen(UA_ServerNetworkLayer *nl, UA_Server *server,
         UA_StatusCode retval = connection_recv(&e->connection, &buf, 0);
 
         if(retval == UA_STATUSCODE_GOOD) {
+#ifdef UA_DEBUG_CAPTURE_PKGS
+            captureRecord(layer, e, UA_CAPTURERECORDTYPE_RECEIVED, &buf);
+#endif
             /* Process packets */
             UA_Server_processBinaryMessage(server, &e->connection, &buf);
             connection_releaserecvbuffer(&e->connection, &buf);
@@ -567,6 +778,9 @@ ServerNetworkLayerTCP_listen(UA_ServerNetworkLayer *nl, UA_Server *server,
             UA_LOG_INFO(layer->logger, UA_LOGCATEGORY_NETWORK,
                         "Connection %i | Closed",
                         (int)(e->connection.sockfd));
+#ifdef UA_DEBUG_CAPTURE_PKGS
+            captureClosed(layer, e);
+#endif
             LIST_REMOVE(e, pointers);
             layer->connectionsSize--;
             UA_close(e->connection.sockfd);
@@ -614,6 +828,9 @@ ServerNetworkLayerTCP_clear(UA_ServerNetworkLayer *nl) {
      * running. So this is safe. */
     ConnectionEntry *e, *e_tmp;
     LIST_FOREACH_SAFE(e, &layer->connections, pointers, e_tmp) {
+#ifdef UA_DEBUG_CAPTURE_PKGS
+        captureClosed(layer, e);
+#endif
         LIST_REMOVE(e, pointers);
         layer->connectionsSize--;
         UA_close(e->connection.sockfd);
@@ -623,6 +840,18 @@ ServerNetworkLayerTCP_clear(UA_ServerNetworkLayer *nl) {
         }
     }
 
+    /* The sockets are owned (and closed) by the subsystem that watches them */
+    WatchedSocketEntry *w, *w_tmp;
+    LIST_FOREACH_SAFE(w, &layer->watchedSockets, pointers, w_tmp) {
+        LIST_REMOVE(w, pointers);
+        UA_free(w);
+    }
+
+#ifdef UA_DEBUG_CAPTURE_PKGS
+    if(layer->capture)
+        fclose(layer->capture);
+#endif
+
     /* Free the layer */
     UA_free(layer);
 }
@@ -637,6 +866,8 @@ UA_ServerNetworkLayerTCP(UA_ConnectionConfig config, UA_UInt16 port,
     nl.start = ServerNetworkLayerTCP_start;
     nl.listen = ServerNetworkLayerTCP_listen;
     nl.stop = ServerNetworkLayerTCP_stop;
+    nl.watchSocket = ServerNetworkLayerTCP_watchSocket;
+    nl.unwatchSocket = ServerNetworkLayerTCP_unwatchSocket;
     nl.handle = NULL;
 
     ServerNetworkLayerTCP *layer = (ServerNetworkLayerTCP*)
@@ -90,7 +90,7 @@ connection_send(UA_Connection *connection, UA_ByteString *buf) {
         return UA_STATUSCODE_BADCONNECTIONCLOSED;
     }
 
-    BufferEntry *entry = (BufferEntry *)malloc(sizeof(BufferEntry));
+    BufferEntry *entry = (BufferEntry *)UA_malloc(sizeof(BufferEntry));
     entry->msg = *buf;
     SIMPLEQ_INSERT_TAIL(&buffer->messages, entry, next);
     lws_callback_on_writable(buffer->wsi);
@@ -139,9 +139,9 @@ callback_opcua(struct lws *wsi, enum lws_callback_reasons reason, void *user, vo
             if(!wsi)
                 break;
             ServerNetworkLayerWS *layer = (ServerNetworkLayerWS *)lws_context_user(vhd->context);
-            UA_Connection *c = (UA_Connection *)malloc(sizeof(UA_Connection));
+            UA_Connection *c = (UA_Connection *)UA_malloc(sizeof(UA_Connection));
             ConnectionUserData *buffer =
-                (ConnectionUserData *)malloc(sizeof(ConnectionUserData));
+                (ConnectionUserData *)UA_malloc(sizeof(ConnectionUserData));
             SIMPLEQ_INIT(&buffer->messages);
             buffer->wsi = wsi;
             memset(c, 0, sizeof(UA_Connection));
@@ -192,6 +192,33 @@ extern UA_THREAD_LOCAL void * (*UA_reallocSingleton)(void *ptr, size_t size);
 # define UA_EXPORT /* fallback to default */
 #endif
 
+/**
+ * Memory Accounting
+ * -----------------
+ * The flag ``UA_ENABLE_MEMORY_ACCOUNTING`` routes ``UA_malloc`` etc. through an
+ * accounting layer. Every allocation is attributed to the subsystem that is
+ * active in the current thread and the counters are kept per subsystem (see
+ * ``UA_getMemoryStatistics``). The accounting layer prepends a small header
+ * with the size and the subsystem to every allocation. So memory from
+ * ``UA_malloc`` must be released with ``UA_free`` and memory from the C library
+ * must not be released with ``UA_free``. The memory is taken from the malloc
+ * singletons if they are enabled, otherwise from the C library. */
+
+#ifdef UA_ENABLE_MEMORY_ACCOUNTING
+UA_EXPORT void * UA_mallocAccounted(size_t size);
+UA_EXPORT void UA_freeAccounted(void *ptr);
+UA_EXPORT void * UA_callocAccounted(size_t nelem, size_t elsize);
+UA_EXPORT void * UA_reallocAccounted(void *ptr, size_t size);
+# undef UA_malloc
+# undef UA_free
+# undef UA_calloc
+# undef UA_realloc
+# define UA_malloc(size) UA_mallocAccounted(size)
+# define UA_free(ptr) UA_freeAccounted(ptr)
+# define UA_calloc(num, size) UA_callocAccounted(num, size)
+# define UA_realloc(ptr, size) UA_reallocAccounted(ptr, size)
+#endif
+
 /**
  * Threadsafe functions
  * --------------------
@@ -235,6 +262,16 @@ extern UA_THREAD_LOCAL void * (*UA_reallocSingleton)(void *ptr, size_t size);
 # define UA_UNLIKELY(x) x
 #endif
 
+/**
+ * Prefetching
+ * -----------
+ * Hint to load memory into the cache before it is accessed. */
+#if defined(__GNUC__) || defined(__clang__)
+# define UA_PREFETCH(p) __builtin_prefetch(p)
+#else
+# define UA_PREFETCH(p)
+#endif
+
 /**
  * Function attributes
  * ------------------- */
@@ -712,6 +712,20 @@ UA_Client_removeCallback(UA_Client *client, UA_UInt64 callbackId);
 UA_EXPORT const UA_DataType *
 UA_Client_findDataType(UA_Client *client, const UA_NodeId *typeId);
 
+/* Generate the DataType descriptors for DataTypes of the server from their
+ * DataTypeDefinition attribute. DataTypes referenced by the structure fields
+ * are loaded as well. Types that are already known are skipped. Afterwards,
+ * values of the types are decoded natively (not as an undecoded
+ * ExtensionObject) and the types are found with UA_Client_findDataType.
+ *
+ * The generated types are chained in front of the customDataTypes of the
+ * configuration. The customDataTypes can be replaced later on. The generated
+ * types remain valid until the client is deleted. See
+ * UA_DataTypeArray_generate for the supported definitions. */
+UA_StatusCode UA_EXPORT
+UA_Client_loadDataTypes(UA_Client *client, size_t typeIdsSize,
+                        const UA_NodeId *typeIds);
+
 /**
  * .. toctree::
  *
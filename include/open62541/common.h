@@ -224,6 +224,47 @@ typedef struct {
     size_t sessionAbortCount;            /* only used by servers */
 } UA_SessionStatistics;
 
+#ifdef UA_ENABLE_MEMORY_ACCOUNTING
+
+/**
+ * With memory accounting enabled, the heap memory is additionally counted per
+ * subsystem. An allocation is attributed to the subsystem that was active when
+ * it was made, also if the memory changes owners later on. Allocations that
+ * cannot be attributed (including those of the application) are counted as
+ * ``UA_MEMORYTAG_OTHER``. The counters are process-wide. */
+
+typedef enum {
+    UA_MEMORYTAG_OTHER = 0,
+    UA_MEMORYTAG_SECURECHANNEL, /* Connections, SecureChannels, chunk buffers */
+    UA_MEMORYTAG_SERVICE,       /* Decoding, processing and encoding of requests */
+    UA_MEMORYTAG_SESSION,       /* Sessions */
+    UA_MEMORYTAG_NODESTORE,     /* Nodes of the information model */
+    UA_MEMORYTAG_SUBSCRIPTION,  /* Subscriptions, MonitoredItems, notification
+                                 * and retransmission queues */
+    UA_MEMORYTAG_HISTORY,       /* Historical data */
+    UA_MEMORYTAG_PUBSUB         /* Publishing and receiving of PubSub messages */
+} UA_MemoryTag;
+
+#define UA_MEMORYTAGSSIZE 8
+
+typedef struct {
+    size_t currentBytes;        /* Bytes in use */
+    size_t cumulatedBytes;      /* Bytes allocated since the start */
+    size_t cumulatedAllocCount;
+    size_t cumulatedFreeCount;
+} UA_MemoryStatistics;
+
+/* Copy the counters of all subsystems. The array is indexed by the
+ * UA_MemoryTag. The allocation rate is the difference between two calls. */
+void UA_EXPORT
+UA_getMemoryStatistics(UA_MemoryStatistics stats[UA_MEMORYTAGSSIZE]);
+
+/* Human-readable name of the subsystem */
+UA_EXPORT const char *
+UA_MemoryTag_name(UA_MemoryTag tag);
+
+#endif
+
 /**
  * .. include:: util.rst */
 
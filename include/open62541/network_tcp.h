@@ -27,6 +27,43 @@ UA_ServerNetworkLayer UA_EXPORT
 UA_ServerNetworkLayerTCP(UA_ConnectionConfig config, UA_UInt16 port,
                          UA_UInt16 maxConnections);
 
+/* Capture files record the chunks received and sent by the connections of a
+ * server network layer. They can be replayed against a server with the
+ * ua-replay tool. All numbers are encoded in little-endian.
+ *
+ * - File header: Magic "UACP" (UInt32), version (UInt32), start of the capture
+ *   (DateTime).
+ * - Record: Time since the start of the capture (Int64, 100ns ticks), the
+ *   connection (UInt32, counts up from 1), the record type (Byte), the length
+ *   (UInt32) and then the content. Opened and closed records have no content.
+ *   Received records contain what was read from the socket and may contain
+ *   partial or several chunks. Sent records contain one chunk each. */
+
+#define UA_CAPTURE_MAGIC 0x50434155 /* "UACP" */
+#define UA_CAPTURE_VERSION 1
+#define UA_CAPTURE_HEADERSIZE 16
+#define UA_CAPTURE_RECORDHEADERSIZE 17
+
+typedef enum {
+    UA_CAPTURERECORDTYPE_OPENED = 0,
+    UA_CAPTURERECORDTYPE_RECEIVED = 1,
+    UA_CAPTURERECORDTYPE_SENT = 2,
+    UA_CAPTURERECORDTYPE_CLOSED = 3
+} UA_CaptureRecordType;
+
+#ifdef UA_DEBUG_CAPTURE_PKGS
+/* Start recording the traffic of a TCP server network layer to a file. A
+ * running capture is stopped first. Set the filename to NULL to only stop the
+ * capture. The capture is stopped when the network layer is cleaned up.
+ *
+ * @param nl A network layer created with UA_ServerNetworkLayerTCP
+ * @param filename The capture file. Overwritten if it exists.
+ * @return Returns UA_STATUSCODE_BADRESOURCEUNAVAILABLE if the file cannot be
+ *         opened */
+UA_StatusCode UA_EXPORT
+UA_ServerNetworkLayerTCP_capture(UA_ServerNetworkLayer *nl, const char *filename);
+#endif
+
 /* Open a non-blocking client TCP socket. The connection might not be fully
  * opened yet. Drop into the _poll function withe a timeout to complete the
  * connection. */
@@ -146,6 +146,12 @@ UA_Server_processBinaryMessage(UA_Server *server, UA_Connection *connection,
 void UA_EXPORT
 UA_Server_removeConnection(UA_Server *server, UA_Connection *connection);
 
+/* Callback for a socket of another subsystem that is watched by the network
+ * layer. Executed from within listen when the socket has become readable. */
+typedef void
+(*UA_ServerNetworkLayerSocketCallback)(UA_Server *server, UA_SOCKET sockfd,
+                                       void *context);
+
 struct UA_ServerNetworkLayer {
     void *handle; /* Internal data */
 
@@ -177,6 +183,23 @@ struct UA_ServerNetworkLayer {
     UA_StatusCode (*listen)(UA_ServerNetworkLayer *nl, UA_Server *server,
                             UA_UInt16 timeout);
 
+    /* Watch an additional socket in listen. So other subsystems (e.g. PubSub)
+     * process arriving messages right away instead of polling their sockets.
+     * Only one callback can be registered per socket. Optional, can be NULL.
+     *
+     * @param nl The network layer
+     * @param sockfd The socket to watch
+     * @param callback Executed from within listen when the socket is readable
+     * @param context Passed to the callback
+     * @return Returns UA_STATUSCODE_GOOD or an error code. */
+    UA_StatusCode (*watchSocket)(UA_ServerNetworkLayer *nl, UA_SOCKET sockfd,
+                                 UA_ServerNetworkLayerSocketCallback callback,
+                                 void *context);
+
+    /* Stop watching the socket. Can be called from within the callback.
+     * Must be set if watchSocket is set. */
+    void (*unwatchSocket)(UA_ServerNetworkLayer *nl, UA_SOCKET sockfd);
+
     /* Close the network socket and all open connections. Afterwards, the
      * network layer can be safely deleted.
      *
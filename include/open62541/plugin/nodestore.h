@@ -319,6 +319,17 @@ UA_NodePointer_toExpandedNodeId(UA_NodePointer np);
 UA_NodeId UA_EXPORT
 UA_NodePointer_toNodeId(UA_NodePointer np);
 
+/* Cannot fail. The NodePointer points directly to the node. Only nodestores
+ * that keep the node memory valid for as long as the NodePointer is stored
+ * should create them. Copies of such a NodePointer (UA_NodePointer_copy) fall
+ * back to the NodeId of the node. */
+UA_NodePointer UA_EXPORT
+UA_NodePointer_fromNode(const UA_NodeHead *node);
+
+/* Returns NULL if the NodePointer is not a direct pointer to a node */
+UA_EXPORT const UA_NodeHead *
+UA_NodePointer_toNode(UA_NodePointer np);
+
 /**
  * Base Node Attributes
  * --------------------
@@ -341,21 +352,31 @@ typedef struct {
 typedef struct {
     UA_ReferenceTarget target;   /* Has to be the first entry */
     UA_UInt32 targetIdHash;      /* Hash of the targetId */
+    UA_UInt32 slabIndex;         /* Position in a bulk allocation (starting at
+                                  * one). Zero if allocated individually. */
     struct aa_entry idTreeEntry; /* Binary-Tree for fast lookup */
     struct aa_entry nameTreeEntry;
 } UA_ReferenceTargetTreeElem;
 
 /* List of reference targets with the same reference type and direction. Uses
- * either an array or a tree structure. The SDK will not change the type of
- * reference target structure internally. The nodestore implementations may
- * switch internally when a node is updated.
+ * either an array (optionally with a hash index) or a tree structure. The SDK
+ * will not change the type of reference target structure internally. The
+ * nodestore implementations may switch internally when a node is updated.
  *
- * The recommendation is to switch to a tree once the number of refs > 8. */
+ * The recommendation is to add the hash index once the number of refs > 8. It
+ * uses less memory than the tree and has constant-time lookups. */
 typedef struct {
     union {
         /* Organize the references in an array. Uses less memory, but incurs
          * lookups in linear time. Recommended if the number of references is
-         * known to be small. */
+         * known to be small. The array grows geometrically. The allocated
+         * capacity is implied by targetsSize (rounded up to the next power of
+         * two).
+         *
+         * With the hash index, the array is kept and can be iterated as
+         * usual. The index is allocated in front of the array. It contains
+         * an open-addressing hash-map for the target id and a sorted
+         * (lazily rebuilt) list for the target BrowseName hash. */
         UA_ReferenceTarget *array;
 
         /* Organize the references in a tree for fast lookup */
@@ -368,6 +389,7 @@ typedef struct {
     UA_Boolean hasRefTree; /* RefTree or RefArray? */
     UA_Byte referenceTypeIndex;
     UA_Boolean isInverse;
+    UA_Boolean hasRefIndex; /* RefArray with hash index? */
 } UA_NodeReferenceKind;
 
 /* Iterate over the references. Assumes that "prev" points to a
@@ -384,6 +406,11 @@ UA_NodeReferenceKind_iterate(const UA_NodeReferenceKind *rk,
 UA_EXPORT UA_StatusCode
 UA_NodeReferenceKind_switch(UA_NodeReferenceKind *rk);
 
+/* Add the hash index to the array representation (from the tree if required)
+ * or remove it again. Does nothing upon error (e.g. out-of-memory). */
+UA_EXPORT UA_StatusCode
+UA_NodeReferenceKind_switchIndex(UA_NodeReferenceKind *rk);
+
 /* Every Node starts with these attributes */
 struct UA_NodeHead {
     UA_NodeId nodeId;
@@ -393,11 +420,17 @@ struct UA_NodeHead {
     UA_LocalizedText description;
     UA_UInt32 writeMask;
     size_t referencesSize;
-    UA_NodeReferenceKind *references;
+    UA_NodeReferenceKind *references; /* Capacity implied by referencesSize
+                                       * (next power of two) */
 
     /* Members specific to open62541 */
     void *context;
     UA_Boolean constructed; /* Constructors were called */
+
+    /* Compacted DisplayName and Description. The LocalizedText members above
+     * are empty if the node is compacted. See UA_Node_compactAttributes. */
+    UA_Byte compactFlags; /* Zero if the node is not compacted */
+    UA_Byte *compactAttributes; /* Encoded attributes. Can be NULL. */
 };
 
 /**
@@ -992,6 +1025,23 @@ typedef struct {
     /* Execute a callback for every node in the nodestore. */
     void (*iterate)(void *nsCtx, UA_NodestoreVisitor visitor,
                     void *visitorCtx);
+
+    /* Optional methods. They are appended at the end to keep the layout of
+     * the struct for existing nodestore implementations. */
+
+    /* Similar to ``getNode``. But the node is identified by a NodePointer,
+     * typically the target of a reference. Nodestores that resolve references
+     * into direct node pointers skip the NodeId lookup here. Can be NULL. Then
+     * the NodePointer is converted to a NodeId and ``getNode`` is used. */
+    const UA_Node * (*getNodeFromPtr)(void *nsCtx, UA_NodePointer ptr);
+
+    /* Hint that the nodes for the ``nodeIdsSize`` NodeIds are looked up with
+     * ``getNode`` shortly after. Services with many operations call this
+     * before processing them one by one. Nodestores can overlap the cache
+     * misses of the lookups, e.g. by hashing all NodeIds up front and
+     * prefetching the memory. Can be NULL. */
+    void (*prefetchNodes)(void *nsCtx, size_t nodeIdsSize,
+                          const UA_NodeId **nodeIds);
 } UA_Nodestore;
 
 /* Attributes must be of a matching type (VariableAttributes, ObjectAttributes,
@@ -1017,6 +1067,15 @@ UA_Node_addReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForward,
                      const UA_ExpandedNodeId *targetNodeId,
                      UA_UInt32 targetBrowseNameHash);
 
+/* Add several references of the same type and direction. Targets that already
+ * exist are skipped. The arrays and tree elements for the targets are allocated
+ * once for the entire batch. Upon failure, a subset of the targets may have
+ * been added. */
+UA_StatusCode UA_EXPORT
+UA_Node_addReferences(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForward,
+                      size_t targetsSize, const UA_ExpandedNodeId *targetNodeIds,
+                      const UA_UInt32 *targetBrowseNameHashes);
+
 /* Delete a single reference from the node */
 UA_StatusCode UA_EXPORT
 UA_Node_deleteReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForward,
@@ -1036,6 +1095,47 @@ UA_Node_deleteReferences(UA_Node *node);
 void UA_EXPORT
 UA_Node_clear(UA_Node *node);
 
+/* Compact the rarely read DisplayName and Description attributes. A
+ * DisplayName equal to the BrowseName (without locale) and an empty Description
+ * are not stored at all. Otherwise they are encoded into a single buffer that
+ * is decoded when the attribute is read. Does nothing if the node is already
+ * compacted.
+ *
+ * The DisplayName and Description of a node that might be compacted must only
+ * be accessed with UA_Node_readDisplayName and UA_Node_readDescription. Call
+ * UA_Node_expandAttributes before they are modified. */
+UA_StatusCode UA_EXPORT
+UA_Node_compactAttributes(UA_Node *node);
+
+/* Decode the compacted attributes back into the NodeHead */
+UA_StatusCode UA_EXPORT
+UA_Node_expandAttributes(UA_Node *node);
+
+/* Get a copy of the DisplayName and Description */
+UA_StatusCode UA_EXPORT
+UA_Node_readDisplayName(const UA_Node *node, UA_LocalizedText *out);
+
+UA_StatusCode UA_EXPORT
+UA_Node_readDescription(const UA_Node *node, UA_LocalizedText *out);
+
+/* Move the value of a VariableNode (or VariableTypeNode) into an immutable
+ * reference-counted payload (see UA_Variant_share). Copies of the node
+ * (UA_Node_copy) and of the value (e.g. for the Read service) then share the
+ * value instead of making a deep copy. Does nothing if the value is already
+ * shared, borrowed (UA_VARIANT_DATA_NODELETE) or if the variable has a
+ * DataSource. */
+UA_StatusCode UA_EXPORT
+UA_VariableNode_shareValue(UA_VariableNode *node);
+
+/* Replace a shared value with a private copy before it is modified in-situ */
+UA_StatusCode UA_EXPORT
+UA_VariableNode_unshareValue(UA_VariableNode *node);
+
+/* Release the shared value without making a copy. The DataValue of the node
+ * is reset afterwards. */
+void UA_EXPORT
+UA_VariableNode_releaseValue(UA_VariableNode *node);
+
 _UA_END_DECLS
 
 #endif /* UA_SERVER_NODES_H_ */
@@ -55,7 +55,10 @@ struct UA_PubSubChannel {
     UA_UInt32 publisherId; /* unique identifier */
     UA_PubSubChannelState state;
     UA_PubSubConnectionConfig *connectionConfig; /* link to parent connection config */
-    UA_SOCKET sockfd;
+    UA_SOCKET sockfd; /* If receive is implemented, the socket is watched by the
+                       * server network layer. Subscribers then receive as soon
+                       * as the socket is readable. Set to UA_INVALID_SOCKET if
+                       * the channel has no socket that can be selected on. */
     void *handle; /* implementation specific data */
     /*@info for handle: each network implementation should provide an structure
     * UA_PubSubChannelData[ImplementationName] This structure can be used by the
@@ -72,7 +75,9 @@ struct UA_PubSubChannel {
     /* Remove subscription to an specified message source, e.g. multicast group or topic */
     UA_StatusCode (*unregist)(UA_PubSubChannel *channel, UA_ExtensionObject *transportSettings);
 
-    /* Receive messages. A regist to the message source is needed before. */
+    /* Receive messages. A regist to the message source is needed before. The
+     * timeout is in us. With a timeout of zero, only the messages that are
+     * already queued are received without blocking. */
     UA_StatusCode (*receive)(UA_PubSubChannel *channel,
                              UA_ExtensionObject *transportSettings,
                              UA_PubSubReceiveCallback receiveCallback,
@@ -289,6 +289,24 @@ typedef struct {
     UA_StatusCode (*compareCertificate)(const void *channelContext,
                                         const UA_ByteString *certificate)
     UA_FUNC_ATTR_WARN_UNUSED_RESULT;
+
+    /* Optional. Policies with an ephemeral key exchange (ECC) derive the
+     * SecureChannel nonce from a per-channel key pair. If set, these replace
+     * the symmetric module's generateNonce/generateKey for the channel keys.
+     *
+     * @param channelContext the context to work on. The ephemeral private key
+     *                       of the latest nonce is kept there.
+     * @param out the nonce (the ephemeral public key) is written here. The
+     *            ByteString is preallocated with secureChannelNonceLength. */
+    UA_StatusCode (*generateNonce)(void *channelContext, UA_ByteString *out)
+    UA_FUNC_ATTR_WARN_UNUSED_RESULT;
+
+    /* Derives keying material from the local ephemeral key and the remote
+     * nonce. The arguments are the same as for the symmetric generateKey. One
+     * of secret and seed is the local nonce, the other one the remote nonce. */
+    UA_StatusCode (*generateKey)(void *channelContext, const UA_ByteString *secret,
+                                 const UA_ByteString *seed, UA_ByteString *out)
+    UA_FUNC_ATTR_WARN_UNUSED_RESULT;
 } UA_SecurityPolicyChannelModule;
 
 struct UA_SecurityPolicy {
@@ -159,6 +159,21 @@ struct UA_ServerConfig {
      *   ModellingRule of their InstanceDeclaration */
     UA_Boolean modellingRulesOnInstances;
 
+    /* The variables of new instances share the value with the variables of the
+     * type definition (copy-on-write) instead of making a deep copy. The shared
+     * value is immutable. The instance gets a private copy once the value is
+     * written. See UA_VariableNode_shareValue. Disabled by default. */
+    UA_Boolean shareTypeChildValues;
+
+    /* Values written to VariableNodes are stored as a shared payload (see
+     * UA_VariableNode_shareValue) if the value data has at least this many
+     * bytes. This includes the heap-allocated content of the elements, such as
+     * the characters of a String array. Read responses, MonitoredItem
+     * samples and notifications then reference the payload instead of making a
+     * deep copy. The payload is copied only when it is modified with an index
+     * range. The default of zero disables sharing. */
+    size_t sharedValueMinSize;
+
     /**
      * .. note:: See the section for :ref:`node lifecycle
      *    handling<node-lifecycle>`. */
@@ -196,6 +211,13 @@ struct UA_ServerConfig {
     UA_UInt16 maxSessions;
     UA_Double maxSessionTimeout; /* in ms */
 
+    /* Registered Nodes. RegisterNodes returns numeric aliases that Read and
+     * Write resolve to the node without a Nodestore lookup. The other services
+     * of the session accept the aliases as well. They are replaced with the
+     * registered NodeIds before the service runs. 0 -> disabled, the
+     * registered NodeIds are returned unchanged. */
+    UA_UInt32 maxRegisteredNodesPerSession;
+
     /* Operation limits */
     UA_UInt32 maxNodesPerRead;
     UA_UInt32 maxNodesPerWrite;
@@ -295,6 +317,17 @@ struct UA_ServerConfig {
     UA_Boolean deleteEventCapability;
     UA_Boolean deleteAtTimeDataCapability;
 #endif
+
+    /* Tracing */
+#ifdef UA_ENABLE_TRACING
+    /* Trace every n-th request of every server thread. 0 disables the
+     * tracing. See UA_Server_exportTrace. */
+    UA_UInt32 tracingSampleInterval;
+
+    /* Size of the ring buffer of every thread (in spans). The oldest spans are
+     * overwritten. Applies to threads that have not yet recorded a trace. */
+    UA_UInt32 tracingBufferSize;
+#endif
 };
 
 void UA_EXPORT
@@ -1601,6 +1634,33 @@ UA_Server_updateCertificate(UA_Server *server,
                             UA_Boolean closeSessions,
                             UA_Boolean closeSecureChannels);
 
+#ifdef UA_ENABLE_TRACING
+/**
+ * Tracing
+ * -------
+ * With ``tracingSampleInterval`` set in the server configuration, every n-th
+ * request is traced. The trace of a request is a tree of spans with start and
+ * end time for decoding, the service call, nodestore lookups, AccessControl
+ * callbacks, DataSource reads, encoding and sending. The spans are kept in a
+ * ring buffer per thread until they are exported. */
+
+typedef enum {
+    UA_TRACEFORMAT_CHROME = 0, /* Trace-event JSON for chrome://tracing and
+                                * Perfetto */
+    UA_TRACEFORMAT_OTLP = 1    /* OpenTelemetry OTLP/JSON. One
+                                * ExportTraceServiceRequest per line and trace,
+                                * as written by the OpenTelemetry file
+                                * exporter. */
+} UA_TraceFormat;
+
+/* Export the recorded spans and remove them from the buffers. The output is
+ * allocated and must be cleared by the caller. It can be written to a file
+ * as-is. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_exportTrace(UA_Server *server, UA_TraceFormat format,
+                      UA_ByteString *out);
+#endif
+
 /**
  * Utility Functions
  * ----------------- */
@@ -1619,6 +1679,89 @@ UA_StatusCode UA_EXPORT UA_THREADSAFE
 UA_Server_getNamespaceByName(UA_Server *server, const UA_String namespaceUri,
                              size_t* foundIndex);
 
+/**
+ * Parallel Nodeset Loading
+ * ------------------------
+ * Large information models (e.g. several companion specifications) are
+ * usually added at startup by the functions generated with the nodeset
+ * compiler. ``UA_Server_loadNodesets`` runs a list of such loaders in
+ * dependency order. Loaders whose dependencies are satisfied form a "wave".
+ * The loaders of a wave each build their nodes on a separate staging server
+ * (in parallel threads if the library is built with multithreading). A
+ * staging server reads the nodes of the namespaces loaded before and keeps
+ * new nodes to itself. After all loaders of the wave returned successfully,
+ * their nodes are published into the server in a single step. If a loader
+ * fails, nothing of its wave is published.
+ *
+ * Nodes of namespaces that were loaded before can only receive additional
+ * references from a loader (as done by the generated code). Other changes to
+ * these nodes are not published. New ReferenceTypes are published immediately,
+ * as the ReferenceTypeIndex is global in the server.
+ *
+ * The staging server is passed to the loader and the node lifecycle callbacks
+ * during the loading. These callbacks must not keep the pointer to the staging
+ * server and must be safe to be called from different threads. */
+
+typedef struct {
+    /* The namespace populated by the loader. It is added to the server before
+     * any loader runs. So all loaders see the same namespace indices. */
+    const char *namespaceUri;
+
+    /* Namespaces that have to be loaded before. These are either provided by
+     * other loaders in the list or already present in the server. */
+    size_t dependenciesSize;
+    const char **dependencies;
+
+    /* For example the function generated by the nodeset compiler */
+    UA_StatusCode (*load)(UA_Server *server);
+} UA_NodesetLoader;
+
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_loadNodesets(UA_Server *server, size_t loadersSize,
+                       const UA_NodesetLoader *loaders);
+
+/**
+ * NodeSet2 XML Loading
+ * --------------------
+ * Information models in the NodeSet2 XML format can be loaded at runtime
+ * without the nodeset compiler. The document is parsed as a stream and only
+ * a bounded window of the nodes is held in memory. The namespaces of the
+ * document are added to the server and the indices are mapped accordingly.
+ * Aliases are resolved. The nodes are inserted in batches. References to
+ * nodes that are defined later in the document are added when the target
+ * becomes available. The type checks, the instantiation of missing mandatory
+ * children and the node constructors run after the entire document has been
+ * loaded. So the order of the nodes in the document does not matter.
+ *
+ * Values of the builtin types (scalars and ``ListOf`` arrays) are decoded.
+ * Values that are ExtensionObjects or XmlElements are skipped, as are the
+ * DataType definitions. If the document is malformed, the nodes loaded up to
+ * that point are removed again.
+ *
+ * The document is read via a callback. For example to read from a file::
+ *
+ *    static size_t
+ *    readFile(void *context, UA_Byte *buf, size_t bufSize) {
+ *        return fread(buf, 1, bufSize, (FILE*)context);
+ *    }
+ *
+ *    FILE *f = fopen("Opc.Ua.Di.NodeSet2.xml", "rb");
+ *    UA_StatusCode res = UA_Server_loadNodesetXml(server, readFile, f);
+ *    fclose(f); */
+
+#ifdef UA_ENABLE_NODESET_XML
+
+/* Reads up to bufSize bytes of the document into buf. Returns the number of
+ * bytes read. Zero is returned at the end of the document. */
+typedef size_t (*UA_NodesetXmlReadCallback)(void *context, UA_Byte *buf,
+                                            size_t bufSize);
+
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_loadNodesetXml(UA_Server *server, UA_NodesetXmlReadCallback read,
+                         void *readContext);
+
+#endif
+
 /**
 * .. _async-operations:
 *
@@ -1713,6 +1856,9 @@ typedef struct {
    UA_NetworkStatistics ns;
    UA_SecureChannelStatistics scs;
    UA_SessionStatistics ss;
+#ifdef UA_ENABLE_MEMORY_ACCOUNTING
+   UA_MemoryStatistics ms[UA_MEMORYTAGSSIZE]; /* Process-wide, per subsystem */
+#endif
 } UA_ServerStatistics;
 
 UA_ServerStatistics UA_EXPORT
@@ -750,6 +750,18 @@ typedef struct {
 #ifdef UA_ENABLE_PUBSUB_ENCRYPTION
     UA_PubSubSecurityPolicy *securityPolicy;
 #endif
+
+    /* non std. field. Receive as soon as a message arrives instead of polling
+     * in the subscribingInterval. The socket of the connection is then watched
+     * by a server network layer that supports it (see watchSocket). The
+     * subscribingInterval and the timeout are not used. The ReaderGroup falls
+     * back to polling if the socket cannot be watched, e.g. with a custom
+     * callback or a blocking socket.
+     *
+     * A message is decoded once for all event-driven ReaderGroups of the
+     * connection. The event-driven ReaderGroups with the rtLevel
+     * UA_PUBSUB_RT_FIXED_SIZE decode the message on their own fast path. */
+    UA_Boolean enableEventDrivenReception;
 } UA_ReaderGroupConfig;
 
 void UA_EXPORT
@@ -688,9 +688,13 @@ typedef struct UA_DataType UA_DataType;
 
 typedef enum {
     UA_VARIANT_DATA,         /* The data has the same lifecycle as the variant */
-    UA_VARIANT_DATA_NODELETE /* The data is "borrowed" by the variant and is
-                              * not deleted when the variant is cleared up.
-                              * The array dimensions also borrowed. */
+    UA_VARIANT_DATA_NODELETE, /* The data is "borrowed" by the variant and is
+                               * not deleted when the variant is cleared up.
+                               * The array dimensions also borrowed. */
+    UA_VARIANT_DATA_SHARED    /* The data is an immutable reference-counted
+                               * payload that is shared between copies of the
+                               * variant. The array dimensions are owned by the
+                               * variant. See UA_Variant_share. */
 } UA_VariantStorageType;
 
 typedef struct {
@@ -702,6 +706,13 @@ typedef struct {
     UA_UInt32 *arrayDimensions;   /* The length of each dimension */
 } UA_Variant;
 
+/* Header of the immutable payload of variants with UA_VARIANT_DATA_SHARED. The
+ * value describes the shared elements (without array dimensions). */
+typedef struct {
+    size_t refCount;
+    UA_Variant value;
+} UA_SharedVariant;
+
 /* Returns true if the variant has no value defined (contains neither an array
  * nor a scalar value).
  *
@@ -783,6 +794,39 @@ UA_StatusCode UA_EXPORT
 UA_Variant_setArrayCopy(UA_Variant *v, const void * UA_RESTRICT array,
                         size_t arraySize, const UA_DataType *type);
 
+/* Move the data of the variant into an immutable reference-counted payload
+ * (UA_VARIANT_DATA_SHARED). Afterwards, copying the variant (also as part of
+ * structures such as UA_DataValue) only increases the reference count instead
+ * of making a deep copy. The payload is deleted together with the last variant
+ * that references it. Borrowed data (UA_VARIANT_DATA_NODELETE) is copied into
+ * the payload. Empty variants and empty arrays are left unchanged.
+ *
+ * Shared data must not be modified in place. Use UA_Variant_unshare to get a
+ * private copy first. UA_Variant_setRange and UA_Variant_setRangeCopy do this
+ * internally.
+ *
+ * @param v The variant
+ * @return Returns UA_STATUSCODE_GOOD or an error code */
+UA_StatusCode UA_EXPORT
+UA_Variant_share(UA_Variant *v);
+
+/* Turn a shared variant back into a variant with UA_VARIANT_DATA storage. The
+ * data is deep-copied only if the payload is still referenced by other
+ * variants. Does nothing if the variant is not shared.
+ *
+ * @param v The variant
+ * @return Returns UA_STATUSCODE_GOOD or an error code */
+UA_StatusCode UA_EXPORT
+UA_Variant_unshare(UA_Variant *v);
+
+/* Returns the header of the shared payload or NULL if the variant is not
+ * shared.
+ *
+ * @param v The variant
+ * @return The shared payload */
+UA_SharedVariant UA_EXPORT *
+UA_Variant_getShared(const UA_Variant *v);
+
 /* Copy the variant, but use only a subset of the (multidimensional) array into
  * a variant. Returns an error code if the variant is not an array or if the
  * indicated range does not fit.
@@ -795,6 +839,22 @@ UA_StatusCode UA_EXPORT
 UA_Variant_copyRange(const UA_Variant *src, UA_Variant * UA_RESTRICT dst,
                      const UA_NumericRange range);
 
+/* Zero-copy variant of UA_Variant_copyRange for ranges that map onto a
+ * contiguous part of the array (e.g. entire rows of a matrix). The target
+ * variant points into the source array with UA_VARIANT_DATA_NODELETE and has
+ * no array dimensions (the shape follows from the range). It is only valid as
+ * long as the source array is not modified or deleted. Returns
+ * UA_STATUSCODE_BADNOTSUPPORTED if the range is not contiguous or reaches into
+ * the array elements. Then UA_Variant_copyRange can be used instead.
+ *
+ * @param src The source variant
+ * @param dst The target variant
+ * @param range The range of the viewed data
+ * @return Returns UA_STATUSCODE_GOOD or an error code */
+UA_StatusCode UA_EXPORT
+UA_Variant_viewRange(const UA_Variant *src, UA_Variant *dst,
+                     const UA_NumericRange range);
+
 /* Insert a range of data into an existing variant. The data array cannot be
  * reused afterwards if it contains types without a fixed size (e.g. strings)
  * since the members are moved into the variant and take on its lifecycle.
@@ -1071,6 +1131,18 @@ UA_init(void *p, const UA_DataType *type) {
 UA_StatusCode UA_EXPORT
 UA_copy(const void *src, void *dst, const UA_DataType *type);
 
+/* Compares the content of two variables of the same type. Arrays of numeric
+ * types are compared with memcmp. All other types are compared member by
+ * member without allocating memory. Note that floating point values are compared by
+ * their bit pattern (0.0 != -0.0 and NaN == NaN for the same bits).
+ *
+ * @param p1 The memory location of the first variable
+ * @param p2 The memory location of the second variable
+ * @param type The datatype description
+ * @return Whether the content is equal */
+UA_Boolean UA_EXPORT
+UA_equal(const void *p1, const void *p2, const UA_DataType *type);
+
 /* Deletes the dynamically allocated content of a variable (e.g. resets all
  * arrays to undefined arrays). Afterwards, the variable can be safely deleted
  * without causing memory leaks. But the variable is not initialized and may
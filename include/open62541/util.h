@@ -188,6 +188,43 @@ UA_EXPORT UA_StatusCode
 UA_RelativePath_parse(UA_RelativePath *rp, const UA_String str);
 #endif
 
+/**
+ * Runtime DataType Generation
+ * ---------------------------
+ * DataTypes that are not known at compile time can be generated from their
+ * DataTypeDefinition attribute (a ``UA_StructureDefinition`` or
+ * ``UA_EnumDefinition``). The generated ``UA_DataType`` descriptors have the
+ * same memory layout (member padding, memSize, overlayable flags) as the
+ * structures generated by the nodeset compiler. So values of these types are
+ * decoded and encoded by the standard routines at native speed. The generated
+ * types can reference each other and the types in the ``customTypes`` array
+ * (and the builtin types). Abstract field types are represented as Variant,
+ * ExtensionObject for Structure and Int32 for enumerations. Bitfield clusters,
+ * structures with subtyped values and multi-dimensional fields are not
+ * supported.
+ *
+ * The returned array points to ``customTypes`` as its ``next`` element. It
+ * can be used directly as the custom types of a client or server
+ * configuration. The ``customTypes`` must outlive the returned array.
+ *
+ * @param typesSize The number of types to generate
+ * @param typeIds The NodeIds of the DataTypes
+ * @param browseNames The BrowseNames used as the type names. Can be NULL.
+ * @param definitions The DataTypeDefinition attributes of the DataTypes
+ * @param customTypes Additional types that can be referenced. Can be NULL.
+ * @param out Pointer to the generated DataTypeArray */
+UA_EXPORT UA_StatusCode
+UA_DataTypeArray_generate(size_t typesSize, const UA_NodeId *typeIds,
+                          const UA_QualifiedName *browseNames,
+                          const UA_Variant *definitions,
+                          const UA_DataTypeArray *customTypes,
+                          UA_DataTypeArray **out);
+
+/* Delete a DataTypeArray created by UA_DataTypeArray_generate. Values using
+ * the generated types must be cleared beforehand. */
+UA_EXPORT void
+UA_DataTypeArray_delete(UA_DataTypeArray *types);
+
 /**
  * Convenience macros for complex types
  * ------------------------------------ */
@@ -1,6 +1,7 @@
 #include <open62541/plugin/securitypolicy.h>
 #include <open62541/plugin/pki.h>
 #include <open62541/types.h>
+#include <open62541/util.h>
 
 #if defined(UA_ENABLE_ENCRYPTION_MBEDTLS) || defined(UA_ENABLE_PUBSUB_ENCRYPTION)
 
@@ -31,6 +32,144 @@ mbedtls_hmac(mbedtls_md_context_t *context, const UA_ByteString *key,
     mbedtls_md_hmac_finish(context, out);
 }
 
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_init(UA_mbedTLS_SymmetricContext *sc,
+                                 mbedtls_md_type_t mdType) {
+    memset(sc, 0, sizeof(UA_mbedTLS_SymmetricContext));
+    mbedtls_aes_init(&sc->localAesContext);
+    mbedtls_aes_init(&sc->remoteAesContext);
+    mbedtls_md_init(&sc->localHmacContext);
+    mbedtls_md_init(&sc->remoteHmacContext);
+
+    const mbedtls_md_info_t *mdInfo = mbedtls_md_info_from_type(mdType);
+    if(mbedtls_md_setup(&sc->localHmacContext, mdInfo, 1) != 0 ||
+       mbedtls_md_setup(&sc->remoteHmacContext, mdInfo, 1) != 0) {
+        UA_mbedTLS_SymmetricContext_clear(sc);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_mbedTLS_SymmetricContext_clear(UA_mbedTLS_SymmetricContext *sc) {
+    mbedtls_aes_free(&sc->localAesContext);
+    mbedtls_aes_free(&sc->remoteAesContext);
+    mbedtls_md_free(&sc->localHmacContext);
+    mbedtls_md_free(&sc->remoteHmacContext);
+    sc->localEncryptingKeySet = false;
+    sc->remoteEncryptingKeySet = false;
+    sc->localSigningKeySet = false;
+    sc->remoteSigningKeySet = false;
+}
+
+/* hmac_starts stores the inner and outer key pads in the context. They are
+ * reused by hmac_reset for every message. */
+static UA_StatusCode
+setHmacKey(mbedtls_md_context_t *ctx, UA_Boolean *keySet,
+           const UA_ByteString *key) {
+    *keySet = (mbedtls_md_hmac_starts(ctx, key->data, key->length) == 0);
+    return (*keySet) ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADINTERNALERROR;
+}
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_setLocalSigningKey(UA_mbedTLS_SymmetricContext *sc,
+                                               const UA_ByteString *key) {
+    return setHmacKey(&sc->localHmacContext, &sc->localSigningKeySet, key);
+}
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_setRemoteSigningKey(UA_mbedTLS_SymmetricContext *sc,
+                                                const UA_ByteString *key) {
+    return setHmacKey(&sc->remoteHmacContext, &sc->remoteSigningKeySet, key);
+}
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_setLocalEncryptingKey(UA_mbedTLS_SymmetricContext *sc,
+                                                  const UA_ByteString *key) {
+    /* Keylength in bits */
+    unsigned int keylength = (unsigned int)(key->length * 8);
+    sc->localEncryptingKeySet =
+        (mbedtls_aes_setkey_enc(&sc->localAesContext, key->data, keylength) == 0);
+    return (sc->localEncryptingKeySet) ?
+        UA_STATUSCODE_GOOD : UA_STATUSCODE_BADINTERNALERROR;
+}
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_setRemoteEncryptingKey(UA_mbedTLS_SymmetricContext *sc,
+                                                   const UA_ByteString *key) {
+    unsigned int keylength = (unsigned int)(key->length * 8);
+    sc->remoteEncryptingKeySet =
+        (mbedtls_aes_setkey_dec(&sc->remoteAesContext, key->data, keylength) == 0);
+    return (sc->remoteEncryptingKeySet) ?
+        UA_STATUSCODE_GOOD : UA_STATUSCODE_BADINTERNALERROR;
+}
+
+static UA_StatusCode
+computeHmac(mbedtls_md_context_t *ctx, UA_Boolean keySet,
+            const UA_ByteString *message, unsigned char *out) {
+    if(!keySet ||
+       mbedtls_md_hmac_reset(ctx) != 0 ||
+       mbedtls_md_hmac_update(ctx, message->data, message->length) != 0 ||
+       mbedtls_md_hmac_finish(ctx, out) != 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_sign(UA_mbedTLS_SymmetricContext *sc,
+                                 const UA_ByteString *message,
+                                 unsigned char *signature) {
+    return computeHmac(&sc->localHmacContext, sc->localSigningKeySet,
+                       message, signature);
+}
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_verify(UA_mbedTLS_SymmetricContext *sc,
+                                   const UA_ByteString *message,
+                                   const UA_ByteString *signature) {
+    unsigned char mac[MBEDTLS_MD_MAX_SIZE];
+    size_t macLength = mbedtls_md_get_size(sc->remoteHmacContext.md_info);
+    if(signature->length != macLength)
+        return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
+    UA_StatusCode retval = computeHmac(&sc->remoteHmacContext,
+                                       sc->remoteSigningKeySet, message, mac);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    if(!UA_constantTimeEqual(signature->data, mac, macLength))
+        return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+cryptCbc(mbedtls_aes_context *ctx, UA_Boolean keySet, int mode,
+         const UA_ByteString *iv, UA_ByteString *data) {
+    if(!keySet || iv->length != 16 || data->length % 16 != 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* mbedtls_aes_crypt_cbc updates the IV. mbedTLS' AES allows in-place
+     * encryption and decryption. */
+    unsigned char ivCopy[16];
+    memcpy(ivCopy, iv->data, 16);
+    if(mbedtls_aes_crypt_cbc(ctx, mode, data->length, ivCopy,
+                             data->data, data->data) != 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_encrypt(UA_mbedTLS_SymmetricContext *sc,
+                                    const UA_ByteString *iv, UA_ByteString *data) {
+    return cryptCbc(&sc->localAesContext, sc->localEncryptingKeySet,
+                    MBEDTLS_AES_ENCRYPT, iv, data);
+}
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_decrypt(UA_mbedTLS_SymmetricContext *sc,
+                                    const UA_ByteString *iv, UA_ByteString *data) {
+    return cryptCbc(&sc->remoteAesContext, sc->remoteEncryptingKeySet,
+                    MBEDTLS_AES_DECRYPT, iv, data);
+}
+
 UA_StatusCode
 mbedtls_generateKey(mbedtls_md_context_t *context,
                     const UA_ByteString *secret, const UA_ByteString *seed,
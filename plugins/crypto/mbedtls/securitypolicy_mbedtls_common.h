@@ -11,6 +11,7 @@
 
 #if defined(UA_ENABLE_ENCRYPTION_MBEDTLS) || defined(UA_ENABLE_PUBSUB_ENCRYPTION)
 
+#include <mbedtls/aes.h>
 #include <mbedtls/md.h>
 #include <mbedtls/x509_crt.h>
 #include <mbedtls/ctr_drbg.h>
@@ -33,6 +34,63 @@ void
 mbedtls_hmac(mbedtls_md_context_t *context, const UA_ByteString *key,
              const UA_ByteString *in, unsigned char *out);
 
+/* The symmetric cipher and HMAC contexts of a SecureChannel. The AES key
+ * schedules and the HMAC key pads are computed once when the keys are set (per
+ * SecurityToken) and then reused for every chunk. */
+typedef struct {
+    mbedtls_aes_context localAesContext;  /* encrypts with the local key */
+    mbedtls_aes_context remoteAesContext; /* decrypts with the remote key */
+    mbedtls_md_context_t localHmacContext;
+    mbedtls_md_context_t remoteHmacContext;
+    UA_Boolean localEncryptingKeySet;
+    UA_Boolean remoteEncryptingKeySet;
+    UA_Boolean localSigningKeySet;
+    UA_Boolean remoteSigningKeySet;
+} UA_mbedTLS_SymmetricContext;
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_init(UA_mbedTLS_SymmetricContext *sc,
+                                 mbedtls_md_type_t mdType);
+
+void
+UA_mbedTLS_SymmetricContext_clear(UA_mbedTLS_SymmetricContext *sc);
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_setLocalSigningKey(UA_mbedTLS_SymmetricContext *sc,
+                                               const UA_ByteString *key);
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_setRemoteSigningKey(UA_mbedTLS_SymmetricContext *sc,
+                                                const UA_ByteString *key);
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_setLocalEncryptingKey(UA_mbedTLS_SymmetricContext *sc,
+                                                  const UA_ByteString *key);
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_setRemoteEncryptingKey(UA_mbedTLS_SymmetricContext *sc,
+                                                   const UA_ByteString *key);
+
+/* The signature has the length of the digest */
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_sign(UA_mbedTLS_SymmetricContext *sc,
+                                 const UA_ByteString *message,
+                                 unsigned char *signature);
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_verify(UA_mbedTLS_SymmetricContext *sc,
+                                   const UA_ByteString *message,
+                                   const UA_ByteString *signature);
+
+/* AES-CBC in place. The IV is not modified. */
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_encrypt(UA_mbedTLS_SymmetricContext *sc,
+                                    const UA_ByteString *iv, UA_ByteString *data);
+
+UA_StatusCode
+UA_mbedTLS_SymmetricContext_decrypt(UA_mbedTLS_SymmetricContext *sc,
+                                    const UA_ByteString *iv, UA_ByteString *data);
+
 UA_StatusCode
 mbedtls_generateKey(mbedtls_md_context_t *context,
                     const UA_ByteString *secret, const UA_ByteString *seed,
@@ -54,12 +54,9 @@ typedef struct {
 typedef struct {
     Aes128Sha256PsaOaep_PolicyContext *policyContext;
 
-    UA_ByteString localSymSigningKey;
-    UA_ByteString localSymEncryptingKey;
+    UA_mbedTLS_SymmetricContext symmetricContext;
     UA_ByteString localSymIv;
 
-    UA_ByteString remoteSymSigningKey;
-    UA_ByteString remoteSymEncryptingKey;
     UA_ByteString remoteSymIv;
 
     mbedtls_x509_crt remoteCertificate;
@@ -228,30 +225,17 @@ sym_verify_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelContext *cc,
                                   const UA_ByteString *signature) {
     if(cc == NULL || message == NULL || signature == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
-
-    /* Compute MAC */
-    if(signature->length != UA_SHA256_LENGTH)
-        return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
-    Aes128Sha256PsaOaep_PolicyContext *pc = cc->policyContext;
-    unsigned char mac[UA_SHA256_LENGTH];
-    mbedtls_hmac(&pc->sha256MdContext, &cc->remoteSymSigningKey, message, mac);
-
-    /* Compare with Signature */
-    if(!UA_constantTimeEqual(signature->data, mac, UA_SHA256_LENGTH))
-        return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
-    return UA_STATUSCODE_GOOD;
+    return UA_mbedTLS_SymmetricContext_verify(&cc->symmetricContext, message, signature);
 }
 
 static UA_StatusCode
-sym_sign_sp_aes128sha256rsaoaep(const Aes128Sha256PsaOaep_ChannelContext *cc,
+sym_sign_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelContext *cc,
                                 const UA_ByteString *message,
                                 UA_ByteString *signature) {
     if(signature->length != UA_SHA256_LENGTH)
         return UA_STATUSCODE_BADINTERNALERROR;
-
-    mbedtls_hmac(&cc->policyContext->sha256MdContext, &cc->localSymSigningKey,
-                 message, signature->data);
-    return UA_STATUSCODE_GOOD;
+    return UA_mbedTLS_SymmetricContext_sign(&cc->symmetricContext, message,
+                                            signature->data);
 }
 
 static size_t
@@ -280,70 +264,21 @@ sym_getPlainTextBlockSize_sp_aes128sha256rsaoaep(const void *channelContext) {
 }
 
 static UA_StatusCode
-sym_encrypt_sp_aes128sha256rsaoaep(const Aes128Sha256PsaOaep_ChannelContext *cc,
+sym_encrypt_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelContext *cc,
                                    UA_ByteString *data) {
     if(cc == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
-
-    if(cc->localSymIv.length != UA_SECURITYPOLICY_AES128SHA256RSAOAEP_SYM_ENCRYPTION_BLOCK_SIZE)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    size_t plainTextBlockSize = UA_SECURITYPOLICY_AES128SHA256RSAOAEP_SYM_PLAIN_TEXT_BLOCK_SIZE;
-
-    if(data->length % plainTextBlockSize != 0)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    /* Keylength in bits */
-    unsigned int keylength = (unsigned int)(cc->localSymEncryptingKey.length * 8);
-    mbedtls_aes_context aesContext;
-    int mbedErr = mbedtls_aes_setkey_enc(&aesContext, cc->localSymEncryptingKey.data, keylength);
-    if(mbedErr)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    UA_ByteString ivCopy;
-    UA_StatusCode retval = UA_ByteString_copy(&cc->localSymIv, &ivCopy);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-
-    mbedErr = mbedtls_aes_crypt_cbc(&aesContext, MBEDTLS_AES_ENCRYPT, data->length,
-                                    ivCopy.data, data->data, data->data);
-    if(mbedErr)
-        retval = UA_STATUSCODE_BADINTERNALERROR;
-    UA_ByteString_clear(&ivCopy);
-    return retval;
+    return UA_mbedTLS_SymmetricContext_encrypt(&cc->symmetricContext,
+                                               &cc->localSymIv, data);
 }
 
 static UA_StatusCode
-sym_decrypt_sp_aes128sha256rsaoaep(const Aes128Sha256PsaOaep_ChannelContext *cc,
+sym_decrypt_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelContext *cc,
                                    UA_ByteString *data) {
     if(cc == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
-
-    size_t encryptionBlockSize = UA_SECURITYPOLICY_AES128SHA256RSAOAEP_SYM_ENCRYPTION_BLOCK_SIZE;
-
-    if(cc->remoteSymIv.length != encryptionBlockSize)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    if(data->length % encryptionBlockSize != 0)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    unsigned int keylength = (unsigned int)(cc->remoteSymEncryptingKey.length * 8);
-    mbedtls_aes_context aesContext;
-    int mbedErr = mbedtls_aes_setkey_dec(&aesContext, cc->remoteSymEncryptingKey.data, keylength);
-    if(mbedErr)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    UA_ByteString ivCopy;
-    UA_StatusCode retval = UA_ByteString_copy(&cc->remoteSymIv, &ivCopy);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-
-    mbedErr = mbedtls_aes_crypt_cbc(&aesContext, MBEDTLS_AES_DECRYPT, data->length,
-                                    ivCopy.data, data->data, data->data);
-    if(mbedErr)
-        retval = UA_STATUSCODE_BADINTERNALERROR;
-    UA_ByteString_clear(&ivCopy);
-    return retval;
+    return UA_mbedTLS_SymmetricContext_decrypt(&cc->symmetricContext,
+                                               &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -395,12 +330,8 @@ parseRemoteCertificate_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelContext
 
 static void
 channelContext_deleteContext_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_ChannelContext *cc) {
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
+    UA_mbedTLS_SymmetricContext_clear(&cc->symmetricContext);
     UA_ByteString_clear(&cc->localSymIv);
-
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
     UA_ByteString_clear(&cc->remoteSymIv);
 
     mbedtls_x509_crt_free(&cc->remoteCertificate);
@@ -425,18 +356,21 @@ channelContext_newContext_sp_aes128sha256rsaoaep(const UA_SecurityPolicy *securi
     /* Initialize the channel context */
     cc->policyContext = (Aes128Sha256PsaOaep_PolicyContext *)securityPolicy->policyContext;
 
-    UA_ByteString_init(&cc->localSymSigningKey);
-    UA_ByteString_init(&cc->localSymEncryptingKey);
     UA_ByteString_init(&cc->localSymIv);
-
-    UA_ByteString_init(&cc->remoteSymSigningKey);
-    UA_ByteString_init(&cc->remoteSymEncryptingKey);
     UA_ByteString_init(&cc->remoteSymIv);
 
     mbedtls_x509_crt_init(&cc->remoteCertificate);
 
+    UA_StatusCode retval =
+        UA_mbedTLS_SymmetricContext_init(&cc->symmetricContext, MBEDTLS_MD_SHA256);
+    if(retval != UA_STATUSCODE_GOOD) {
+        channelContext_deleteContext_sp_aes128sha256rsaoaep(cc);
+        *pp_contextData = NULL;
+        return retval;
+    }
+
     // TODO: this can be optimized so that we dont allocate memory before parsing the certificate
-    UA_StatusCode retval = parseRemoteCertificate_sp_aes128sha256rsaoaep(cc, remoteCertificate);
+    retval = parseRemoteCertificate_sp_aes128sha256rsaoaep(cc, remoteCertificate);
     if(retval != UA_STATUSCODE_GOOD) {
         channelContext_deleteContext_sp_aes128sha256rsaoaep(cc);
         *pp_contextData = NULL;
@@ -450,8 +384,7 @@ channelContext_setLocalSymEncryptingKey_sp_aes128sha256rsaoaep(Aes128Sha256PsaOa
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_mbedTLS_SymmetricContext_setLocalEncryptingKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -460,8 +393,7 @@ channelContext_setLocalSymSigningKey_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep_
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_mbedTLS_SymmetricContext_setLocalSigningKey(&cc->symmetricContext, key);
 }
 
 
@@ -481,8 +413,7 @@ channelContext_setRemoteSymEncryptingKey_sp_aes128sha256rsaoaep(Aes128Sha256PsaO
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_mbedTLS_SymmetricContext_setRemoteEncryptingKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -491,8 +422,7 @@ channelContext_setRemoteSymSigningKey_sp_aes128sha256rsaoaep(Aes128Sha256PsaOaep
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_mbedTLS_SymmetricContext_setRemoteSigningKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
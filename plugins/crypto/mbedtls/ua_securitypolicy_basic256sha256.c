@@ -55,12 +55,9 @@ typedef struct {
 typedef struct {
     Basic256Sha256_PolicyContext *policyContext;
 
-    UA_ByteString localSymSigningKey;
-    UA_ByteString localSymEncryptingKey;
+    UA_mbedTLS_SymmetricContext symmetricContext;
     UA_ByteString localSymIv;
 
-    UA_ByteString remoteSymSigningKey;
-    UA_ByteString remoteSymEncryptingKey;
     UA_ByteString remoteSymIv;
 
     mbedtls_x509_crt remoteCertificate;
@@ -236,31 +233,17 @@ sym_verify_sp_basic256sha256(Basic256Sha256_ChannelContext *cc,
                              const UA_ByteString *signature) {
     if(cc == NULL || message == NULL || signature == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
-
-    /* Compute MAC */
-    if(signature->length != UA_SHA256_LENGTH)
-        return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
-
-    Basic256Sha256_PolicyContext *pc = cc->policyContext;
-    unsigned char mac[UA_SHA256_LENGTH];
-    mbedtls_hmac(&pc->sha256MdContext, &cc->remoteSymSigningKey, message, mac);
-
-    /* Compare with Signature */
-    if(!UA_constantTimeEqual(signature->data, mac, UA_SHA256_LENGTH))
-        return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
-    return UA_STATUSCODE_GOOD;
+    return UA_mbedTLS_SymmetricContext_verify(&cc->symmetricContext, message, signature);
 }
 
 static UA_StatusCode
-sym_sign_sp_basic256sha256(const Basic256Sha256_ChannelContext *cc,
+sym_sign_sp_basic256sha256(Basic256Sha256_ChannelContext *cc,
                            const UA_ByteString *message,
                            UA_ByteString *signature) {
     if(signature->length != UA_SHA256_LENGTH)
         return UA_STATUSCODE_BADINTERNALERROR;
-
-    mbedtls_hmac(&cc->policyContext->sha256MdContext, &cc->localSymSigningKey,
-                 message, signature->data);
-    return UA_STATUSCODE_GOOD;
+    return UA_mbedTLS_SymmetricContext_sign(&cc->symmetricContext, message,
+                                            signature->data);
 }
 
 static size_t
@@ -289,69 +272,21 @@ sym_getPlainTextBlockSize_sp_basic256sha256(const void *channelContext) {
 }
 
 static UA_StatusCode
-sym_encrypt_sp_basic256sha256(const Basic256Sha256_ChannelContext *cc,
+sym_encrypt_sp_basic256sha256(Basic256Sha256_ChannelContext *cc,
                               UA_ByteString *data) {
     if(cc == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
-
-    if(cc->localSymIv.length != UA_SECURITYPOLICY_BASIC256SHA256_SYM_ENCRYPTION_BLOCK_SIZE)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    size_t plainTextBlockSize = UA_SECURITYPOLICY_BASIC256SHA256_SYM_PLAIN_TEXT_BLOCK_SIZE;
-
-    if(data->length % plainTextBlockSize != 0)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    /* Keylength in bits */
-    unsigned int keylength = (unsigned int)(cc->localSymEncryptingKey.length * 8);
-    mbedtls_aes_context aesContext;
-    int mbedErr = mbedtls_aes_setkey_enc(&aesContext, cc->localSymEncryptingKey.data, keylength);
-    if(mbedErr)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    UA_ByteString ivCopy;
-    UA_StatusCode retval = UA_ByteString_copy(&cc->localSymIv, &ivCopy);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-
-    mbedErr = mbedtls_aes_crypt_cbc(&aesContext, MBEDTLS_AES_ENCRYPT, data->length,
-                                    ivCopy.data, data->data, data->data);
-    if(mbedErr)
-        retval = UA_STATUSCODE_BADINTERNALERROR;
-    UA_ByteString_clear(&ivCopy);
-    return retval;
+    return UA_mbedTLS_SymmetricContext_encrypt(&cc->symmetricContext,
+                                               &cc->localSymIv, data);
 }
 
 static UA_StatusCode
-sym_decrypt_sp_basic256sha256(const Basic256Sha256_ChannelContext *cc,
+sym_decrypt_sp_basic256sha256(Basic256Sha256_ChannelContext *cc,
                               UA_ByteString *data) {
     if(cc == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
-
-    size_t encryptionBlockSize = UA_SECURITYPOLICY_BASIC256SHA256_SYM_ENCRYPTION_BLOCK_SIZE;
-    if(cc->remoteSymIv.length != encryptionBlockSize)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    if(data->length % encryptionBlockSize != 0)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    unsigned int keylength = (unsigned int)(cc->remoteSymEncryptingKey.length * 8);
-    mbedtls_aes_context aesContext;
-    int mbedErr = mbedtls_aes_setkey_dec(&aesContext, cc->remoteSymEncryptingKey.data, keylength);
-    if(mbedErr)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    UA_ByteString ivCopy;
-    UA_StatusCode retval = UA_ByteString_copy(&cc->remoteSymIv, &ivCopy);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-
-    mbedErr = mbedtls_aes_crypt_cbc(&aesContext, MBEDTLS_AES_DECRYPT, data->length,
-                                    ivCopy.data, data->data, data->data);
-    if(mbedErr)
-        retval = UA_STATUSCODE_BADINTERNALERROR;
-    UA_ByteString_clear(&ivCopy);
-    return retval;
+    return UA_mbedTLS_SymmetricContext_decrypt(&cc->symmetricContext,
+                                               &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -402,12 +337,8 @@ parseRemoteCertificate_sp_basic256sha256(Basic256Sha256_ChannelContext *cc,
 
 static void
 channelContext_deleteContext_sp_basic256sha256(Basic256Sha256_ChannelContext *cc) {
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
+    UA_mbedTLS_SymmetricContext_clear(&cc->symmetricContext);
     UA_ByteString_clear(&cc->localSymIv);
-
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
     UA_ByteString_clear(&cc->remoteSymIv);
 
     mbedtls_x509_crt_free(&cc->remoteCertificate);
@@ -432,18 +363,21 @@ channelContext_newContext_sp_basic256sha256(const UA_SecurityPolicy *securityPol
     /* Initialize the channel context */
     cc->policyContext = (Basic256Sha256_PolicyContext *)securityPolicy->policyContext;
 
-    UA_ByteString_init(&cc->localSymSigningKey);
-    UA_ByteString_init(&cc->localSymEncryptingKey);
     UA_ByteString_init(&cc->localSymIv);
-
-    UA_ByteString_init(&cc->remoteSymSigningKey);
-    UA_ByteString_init(&cc->remoteSymEncryptingKey);
     UA_ByteString_init(&cc->remoteSymIv);
 
     mbedtls_x509_crt_init(&cc->remoteCertificate);
 
+    UA_StatusCode retval =
+        UA_mbedTLS_SymmetricContext_init(&cc->symmetricContext, MBEDTLS_MD_SHA256);
+    if(retval != UA_STATUSCODE_GOOD) {
+        channelContext_deleteContext_sp_basic256sha256(cc);
+        *pp_contextData = NULL;
+        return retval;
+    }
+
     // TODO: this can be optimized so that we dont allocate memory before parsing the certificate
-    UA_StatusCode retval = parseRemoteCertificate_sp_basic256sha256(cc, remoteCertificate);
+    retval = parseRemoteCertificate_sp_basic256sha256(cc, remoteCertificate);
     if(retval != UA_STATUSCODE_GOOD) {
         channelContext_deleteContext_sp_basic256sha256(cc);
         *pp_contextData = NULL;
@@ -457,8 +391,7 @@ channelContext_setLocalSymEncryptingKey_sp_basic256sha256(Basic256Sha256_Channel
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_mbedTLS_SymmetricContext_setLocalEncryptingKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -467,8 +400,7 @@ channelContext_setLocalSymSigningKey_sp_basic256sha256(Basic256Sha256_ChannelCon
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_mbedTLS_SymmetricContext_setLocalSigningKey(&cc->symmetricContext, key);
 }
 
 
@@ -488,8 +420,7 @@ channelContext_setRemoteSymEncryptingKey_sp_basic256sha256(Basic256Sha256_Channe
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_mbedTLS_SymmetricContext_setRemoteEncryptingKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -498,8 +429,7 @@ channelContext_setRemoteSymSigningKey_sp_basic256sha256(Basic256Sha256_ChannelCo
     if(key == NULL || cc == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_mbedTLS_SymmetricContext_setRemoteSigningKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
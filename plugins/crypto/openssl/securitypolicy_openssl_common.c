@@ -25,6 +25,16 @@ modification history
 #include <openssl/hmac.h>
 #include <openssl/aes.h>
 #include <openssl/pem.h>
+#include <openssl/crypto.h>
+#include <openssl/ec.h>
+#include <openssl/ecdsa.h>
+#include <openssl/bn.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(LIBRESSL_VERSION_NUMBER)
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
+
+#include <limits.h>
 
 #include "securitypolicy_openssl_common.h"
 #include "ua_openssl_version_abstraction.h"
@@ -646,6 +656,9 @@ UA_OpenSSL_Encrypt (const UA_ByteString * iv,
         ret = UA_STATUSCODE_BADINTERNALERROR;
         goto errout;
     }
+    /* The plaintext is already padded to the block size. With padding enabled,
+     * EVP_EncryptFinal() appends a full padding block beyond the buffer. */
+    EVP_CIPHER_CTX_set_padding (ctx, 0);
     opensslRet = EVP_EncryptUpdate (ctx, data->data, &outLen,
                                     plainTxt.data, (int) plainTxt.length);
     if (opensslRet != 1) {
@@ -875,6 +888,520 @@ UA_OpenSSL_AES_128_CBC_Encrypt (const UA_ByteString * iv,
     return UA_OpenSSL_Encrypt (iv, key, EVP_aes_128_cbc (), data);
 }
 
+/* HMAC_Init_ex() would rehash the key for every message. Instead the states
+ * after the key pads (RFC 2104) are kept and copied per message. */
+#define UA_OPENSSL_HMAC_MAX_BLOCK_SIZE 128
+
+static void
+UA_OpenSSL_HMAC_Context_clear (UA_OpenSSL_HMAC_Context * hc) {
+    if (hc->inner != NULL)
+        EVP_MD_CTX_destroy (hc->inner);
+    if (hc->outer != NULL)
+        EVP_MD_CTX_destroy (hc->outer);
+    if (hc->work != NULL)
+        EVP_MD_CTX_destroy (hc->work);
+    memset (hc, 0, sizeof (UA_OpenSSL_HMAC_Context));
+}
+
+static UA_StatusCode
+UA_OpenSSL_HMAC_Context_setKey (UA_OpenSSL_HMAC_Context * hc,
+                                const EVP_MD *            md,
+                                const UA_ByteString *     key) {
+    unsigned char keyBlock[UA_OPENSSL_HMAC_MAX_BLOCK_SIZE];
+    unsigned char pad[UA_OPENSSL_HMAC_MAX_BLOCK_SIZE];
+    size_t        blockSize = (size_t) EVP_MD_block_size (md);
+    UA_StatusCode ret = UA_STATUSCODE_BADINTERNALERROR;
+
+    UA_OpenSSL_HMAC_Context_clear (hc);
+    if (blockSize > UA_OPENSSL_HMAC_MAX_BLOCK_SIZE)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* Keys longer than the block size are hashed first */
+    memset (keyBlock, 0, sizeof (keyBlock));
+    if (key->length > blockSize) {
+        if (EVP_Digest (key->data, key->length, keyBlock, NULL, md, NULL) != 1)
+            return UA_STATUSCODE_BADINTERNALERROR;
+    } else if (key->length > 0) {
+        memcpy (keyBlock, key->data, key->length);
+    }
+
+    hc->inner = EVP_MD_CTX_create ();
+    hc->outer = EVP_MD_CTX_create ();
+    hc->work = EVP_MD_CTX_create ();
+    if (hc->inner == NULL || hc->outer == NULL || hc->work == NULL) {
+        ret = UA_STATUSCODE_BADOUTOFMEMORY;
+        goto errout;
+    }
+
+    for (size_t i = 0; i < blockSize; i++)
+        pad[i] = (unsigned char) (keyBlock[i] ^ 0x36);
+    if (EVP_DigestInit_ex (hc->inner, md, NULL) != 1 ||
+        EVP_DigestUpdate (hc->inner, pad, blockSize) != 1)
+        goto errout;
+
+    for (size_t i = 0; i < blockSize; i++)
+        pad[i] = (unsigned char) (keyBlock[i] ^ 0x5c);
+    if (EVP_DigestInit_ex (hc->outer, md, NULL) != 1 ||
+        EVP_DigestUpdate (hc->outer, pad, blockSize) != 1)
+        goto errout;
+
+    ret = UA_STATUSCODE_GOOD;
+
+errout:
+    OPENSSL_cleanse (keyBlock, sizeof (keyBlock));
+    OPENSSL_cleanse (pad, sizeof (pad));
+    if (ret != UA_STATUSCODE_GOOD)
+        UA_OpenSSL_HMAC_Context_clear (hc);
+    return ret;
+}
+
+static UA_StatusCode
+UA_OpenSSL_HMAC_Context_compute (UA_OpenSSL_HMAC_Context * hc,
+                                 const UA_ByteString *     message,
+                                 unsigned char *           out,
+                                 unsigned int *            outLen) {
+    unsigned char innerHash[EVP_MAX_MD_SIZE];
+    unsigned int  innerLen = 0;
+
+    /* No key was set */
+    if (hc->inner == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    if (EVP_MD_CTX_copy_ex (hc->work, hc->inner) != 1 ||
+        EVP_DigestUpdate (hc->work, message->data, message->length) != 1 ||
+        EVP_DigestFinal_ex (hc->work, innerHash, &innerLen) != 1 ||
+        EVP_MD_CTX_copy_ex (hc->work, hc->outer) != 1 ||
+        EVP_DigestUpdate (hc->work, innerHash, innerLen) != 1 ||
+        EVP_DigestFinal_ex (hc->work, out, outLen) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+UA_OpenSSL_Cipher_setKey (EVP_CIPHER_CTX **    ctx,
+                          const EVP_CIPHER *   cipher,
+                          const UA_ByteString * key,
+                          int                  enc) {
+    if (key->length != (size_t) EVP_CIPHER_key_length (cipher))
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    if (*ctx == NULL) {
+        *ctx = EVP_CIPHER_CTX_new ();
+        if (*ctx == NULL)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    /* The key schedule is computed here. The IV is set per chunk. */
+    if (EVP_CipherInit_ex (*ctx, cipher, NULL, key->data, NULL, enc) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    EVP_CIPHER_CTX_set_padding (*ctx, 0);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+UA_OpenSSL_Cipher_crypt (EVP_CIPHER_CTX *      ctx,
+                         const UA_ByteString * iv,
+                         UA_ByteString *       data  /* [in/out]*/) {
+    int outLen = 0;
+    int tmpLen = 0;
+
+    /* No key was set */
+    if (ctx == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    if (iv->length != (size_t) EVP_CIPHER_CTX_iv_length (ctx) ||
+        data->length > INT_MAX)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* Reset the IV and keep the key schedule and direction. CBC works in place
+     * when input and output are the same buffer. */
+    if (EVP_CipherInit_ex (ctx, NULL, NULL, NULL, iv->data, -1) != 1 ||
+        EVP_CipherUpdate (ctx, data->data, &outLen,
+                          data->data, (int) data->length) != 1 ||
+        EVP_CipherFinal_ex (ctx, data->data + outLen, &tmpLen) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    data->length = (size_t) (outLen + tmpLen);
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_OpenSSL_SymmetricContext_init (UA_OpenSSL_SymmetricContext * sc,
+                                  const EVP_CIPHER *            cipher,
+                                  const EVP_MD *                md) {
+    memset (sc, 0, sizeof (UA_OpenSSL_SymmetricContext));
+    sc->cipher = cipher;
+    sc->md = md;
+}
+
+void
+UA_OpenSSL_SymmetricContext_clear (UA_OpenSSL_SymmetricContext * sc) {
+    if (sc->encryptContext != NULL)
+        EVP_CIPHER_CTX_free (sc->encryptContext);
+    if (sc->decryptContext != NULL)
+        EVP_CIPHER_CTX_free (sc->decryptContext);
+    UA_OpenSSL_HMAC_Context_clear (&sc->signContext);
+    UA_OpenSSL_HMAC_Context_clear (&sc->verifyContext);
+    UA_OpenSSL_SymmetricContext_init (sc, sc->cipher, sc->md);
+}
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_setLocalSigningKey (UA_OpenSSL_SymmetricContext * sc,
+                                                const UA_ByteString *         key) {
+    return UA_OpenSSL_HMAC_Context_setKey (&sc->signContext, sc->md, key);
+}
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_setRemoteSigningKey (UA_OpenSSL_SymmetricContext * sc,
+                                                 const UA_ByteString *         key) {
+    return UA_OpenSSL_HMAC_Context_setKey (&sc->verifyContext, sc->md, key);
+}
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_setLocalEncryptingKey (UA_OpenSSL_SymmetricContext * sc,
+                                                   const UA_ByteString *         key) {
+    return UA_OpenSSL_Cipher_setKey (&sc->encryptContext, sc->cipher, key, 1);
+}
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_setRemoteEncryptingKey (UA_OpenSSL_SymmetricContext * sc,
+                                                    const UA_ByteString *         key) {
+    return UA_OpenSSL_Cipher_setKey (&sc->decryptContext, sc->cipher, key, 0);
+}
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_sign (UA_OpenSSL_SymmetricContext * sc,
+                                  const UA_ByteString *         message,
+                                  UA_ByteString *               signature) {
+    unsigned int macLen = 0;
+    if (signature->length != (size_t) EVP_MD_size (sc->md))
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_OpenSSL_HMAC_Context_compute (&sc->signContext, message,
+                                            signature->data, &macLen);
+}
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_verify (UA_OpenSSL_SymmetricContext * sc,
+                                    const UA_ByteString *         message,
+                                    const UA_ByteString *         signature) {
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    unsigned int  macLen = 0;
+    UA_StatusCode ret = UA_OpenSSL_HMAC_Context_compute (&sc->verifyContext,
+                                                         message, mac, &macLen);
+    if (ret != UA_STATUSCODE_GOOD)
+        return ret;
+    if (signature->length != macLen ||
+        !UA_constantTimeEqual (signature->data, mac, macLen))
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_encrypt (UA_OpenSSL_SymmetricContext * sc,
+                                     const UA_ByteString *         iv,
+                                     UA_ByteString *               data  /* [in/out]*/) {
+    return UA_OpenSSL_Cipher_crypt (sc->encryptContext, iv, data);
+}
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_decrypt (UA_OpenSSL_SymmetricContext * sc,
+                                     const UA_ByteString *         iv,
+                                     UA_ByteString *               data  /* [in/out]*/) {
+    return UA_OpenSSL_Cipher_crypt (sc->decryptContext, iv, data);
+}
+
+/* ECC */
+
+/* Large enough for the uncompressed point (0x04|X|Y) of NIST P-521 */
+#define UA_OPENSSL_ECC_MAX_POINT_LENGTH (1 + 2 * 66)
+
+static size_t
+UA_OpenSSL_ECC_CoordinateSize (EVP_PKEY * key) {
+    return (size_t) ((EVP_PKEY_bits (key) + 7) / 8);
+}
+
+/* Returns the length of the uncompressed public point. Zero upon failure. */
+static size_t
+UA_OpenSSL_ECC_EncodePoint (EVP_PKEY *      key,
+                            unsigned char * point,
+                            size_t          pointSize) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(LIBRESSL_VERSION_NUMBER)
+    size_t pointLen = 0;
+    if (EVP_PKEY_get_octet_string_param (key, OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY,
+                                         point, pointSize, &pointLen) != 1)
+        return 0;
+    return pointLen;
+#else
+    const EC_KEY * ecKey = get_pkey_ec (key);
+    if (ecKey == NULL)
+        return 0;
+    return EC_POINT_point2oct (EC_KEY_get0_group (ecKey), EC_KEY_get0_public_key (ecKey),
+                               POINT_CONVERSION_UNCOMPRESSED, point, pointSize, NULL);
+#endif
+}
+
+/* Creates a public key on the curve of the local key. Decoding the point also
+ * checks that it is on the curve. */
+static EVP_PKEY *
+UA_OpenSSL_ECC_DecodePoint (EVP_PKEY *            localKey,
+                            const unsigned char * point,
+                            size_t                pointLen) {
+    EVP_PKEY * key = NULL;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(LIBRESSL_VERSION_NUMBER)
+    char group[64];
+    if (EVP_PKEY_get_utf8_string_param (localKey, OSSL_PKEY_PARAM_GROUP_NAME,
+                                        group, sizeof (group), NULL) != 1)
+        return NULL;
+    OSSL_PARAM params[3];
+    params[0] = OSSL_PARAM_construct_utf8_string (OSSL_PKEY_PARAM_GROUP_NAME, group, 0);
+    params[1] = OSSL_PARAM_construct_octet_string (OSSL_PKEY_PARAM_PUB_KEY,
+                                                   (void *) (uintptr_t) point, pointLen);
+    params[2] = OSSL_PARAM_construct_end ();
+    EVP_PKEY_CTX * ctx = EVP_PKEY_CTX_new_from_name (NULL, "EC", NULL);
+    if (ctx == NULL)
+        return NULL;
+    if (EVP_PKEY_fromdata_init (ctx) != 1 ||
+        EVP_PKEY_fromdata (ctx, &key, EVP_PKEY_PUBLIC_KEY, params) != 1)
+        key = NULL;
+    EVP_PKEY_CTX_free (ctx);
+#else
+    const EC_KEY * localEcKey = get_pkey_ec (localKey);
+    if (localEcKey == NULL)
+        return NULL;
+    EC_KEY * ecKey = EC_KEY_new ();
+    key = EVP_PKEY_new ();
+    if (ecKey == NULL || key == NULL ||
+        EC_KEY_set_group (ecKey, EC_KEY_get0_group (localEcKey)) != 1 ||
+        EC_KEY_oct2key (ecKey, point, pointLen, NULL) != 1 ||
+        EVP_PKEY_assign_EC_KEY (key, ecKey) != 1) {
+        EC_KEY_free (ecKey);
+        EVP_PKEY_free (key);
+        return NULL;
+    }
+#endif
+    return key;
+}
+
+UA_StatusCode
+UA_OpenSSL_ECDSA_SHA256_Sign (const UA_ByteString * message,
+                              EVP_PKEY *            privateKey,
+                              UA_ByteString *       outSignature) {
+    if (privateKey == NULL || EVP_PKEY_base_id (privateKey) != EVP_PKEY_EC)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    size_t coordSize = UA_OpenSSL_ECC_CoordinateSize (privateKey);
+    if (outSignature->length != 2 * coordSize)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    EVP_MD_CTX * mdctx = EVP_MD_CTX_create ();
+    if (mdctx == NULL)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* The EVP interface returns the DER encoding of the signature */
+    UA_StatusCode ret = UA_STATUSCODE_BADINTERNALERROR;
+    unsigned char * der = NULL;
+    ECDSA_SIG * sig = NULL;
+    size_t derLen = 0;
+    if (EVP_DigestSignInit (mdctx, NULL, EVP_sha256 (), NULL, privateKey) != 1 ||
+        EVP_DigestSign (mdctx, NULL, &derLen, message->data, message->length) != 1)
+        goto errout;
+    der = (unsigned char *) OPENSSL_malloc (derLen);
+    if (der == NULL) {
+        ret = UA_STATUSCODE_BADOUTOFMEMORY;
+        goto errout;
+    }
+    if (EVP_DigestSign (mdctx, der, &derLen, message->data, message->length) != 1)
+        goto errout;
+
+    /* Fixed-length r|s instead of the DER encoding */
+    const unsigned char * pos = der;
+    sig = d2i_ECDSA_SIG (NULL, &pos, (long) derLen);
+    if (sig == NULL)
+        goto errout;
+    const BIGNUM * r = NULL;
+    const BIGNUM * s = NULL;
+    ECDSA_SIG_get0 (sig, &r, &s);
+    if (BN_bn2binpad (r, outSignature->data, (int) coordSize) == (int) coordSize &&
+        BN_bn2binpad (s, outSignature->data + coordSize, (int) coordSize) == (int) coordSize)
+        ret = UA_STATUSCODE_GOOD;
+
+errout:
+    ECDSA_SIG_free (sig);
+    OPENSSL_free (der);
+    EVP_MD_CTX_destroy (mdctx);
+    return ret;
+}
+
+UA_StatusCode
+UA_OpenSSL_ECDSA_SHA256_Verify (const UA_ByteString * message,
+                                X509 *                publicKeyX509,
+                                const UA_ByteString * signature) {
+    EVP_PKEY * evpPublicKey = X509_get_pubkey (publicKeyX509);
+    if (evpPublicKey == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* A signature that cannot be valid for the key fails the check */
+    UA_StatusCode ret = UA_STATUSCODE_BADSECURITYCHECKSFAILED;
+    ECDSA_SIG * sig = NULL;
+    BIGNUM * r = NULL;
+    BIGNUM * s = NULL;
+    unsigned char * der = NULL;
+    EVP_MD_CTX * mdctx = NULL;
+    size_t coordSize = UA_OpenSSL_ECC_CoordinateSize (evpPublicKey);
+    if (EVP_PKEY_base_id (evpPublicKey) != EVP_PKEY_EC ||
+        signature->length != 2 * coordSize)
+        goto errout;
+
+    /* Back to the DER encoding for the EVP interface */
+    r = BN_bin2bn (signature->data, (int) coordSize, NULL);
+    s = BN_bin2bn (signature->data + coordSize, (int) coordSize, NULL);
+    sig = ECDSA_SIG_new ();
+    if (r == NULL || s == NULL || sig == NULL) {
+        ret = UA_STATUSCODE_BADOUTOFMEMORY;
+        goto errout;
+    }
+    ECDSA_SIG_set0 (sig, r, s); /* The signature takes ownership */
+    r = NULL;
+    s = NULL;
+    int derLen = i2d_ECDSA_SIG (sig, &der);
+    mdctx = EVP_MD_CTX_create ();
+    if (derLen <= 0 || mdctx == NULL ||
+        EVP_DigestVerifyInit (mdctx, NULL, EVP_sha256 (), NULL, evpPublicKey) != 1) {
+        ret = UA_STATUSCODE_BADINTERNALERROR;
+        goto errout;
+    }
+    if (EVP_DigestVerify (mdctx, der, (size_t) derLen,
+                          message->data, message->length) == 1)
+        ret = UA_STATUSCODE_GOOD;
+
+errout:
+    EVP_MD_CTX_destroy (mdctx);
+    OPENSSL_free (der);
+    BN_free (r);
+    BN_free (s);
+    ECDSA_SIG_free (sig);
+    EVP_PKEY_free (evpPublicKey);
+    return ret;
+}
+
+UA_StatusCode
+UA_OpenSSL_ECC_GenerateKey (int             curveNid,
+                            EVP_PKEY **     keyPair,
+                            UA_ByteString * publicKey) {
+    EVP_PKEY_CTX * ctx = EVP_PKEY_CTX_new_id (EVP_PKEY_EC, NULL);
+    if (ctx == NULL)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    EVP_PKEY * key = NULL;
+    if (EVP_PKEY_keygen_init (ctx) != 1 ||
+        EVP_PKEY_CTX_set_ec_paramgen_curve_nid (ctx, curveNid) != 1 ||
+        EVP_PKEY_keygen (ctx, &key) != 1) {
+        EVP_PKEY_CTX_free (ctx);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    EVP_PKEY_CTX_free (ctx);
+
+    /* Strip the uncompressed point prefix */
+    unsigned char point[UA_OPENSSL_ECC_MAX_POINT_LENGTH];
+    size_t pointLen = UA_OpenSSL_ECC_EncodePoint (key, point, sizeof (point));
+    if (publicKey->length != 2 * UA_OpenSSL_ECC_CoordinateSize (key) ||
+        pointLen != publicKey->length + 1) {
+        EVP_PKEY_free (key);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    memcpy (publicKey->data, &point[1], publicKey->length);
+    *keyPair = key;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* HKDF (RFC 5869) with SHA256. The output length is out->length. */
+static UA_StatusCode
+UA_OpenSSL_HKDF_SHA256 (const UA_ByteString * salt,
+                        const UA_ByteString * ikm,
+                        const UA_ByteString * info,
+                        UA_ByteString *       out) {
+    if (out->length > 255 * SHA256_DIGEST_LENGTH)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* Extract */
+    unsigned char prk[SHA256_DIGEST_LENGTH];
+    unsigned int prkLen = 0;
+    if (HMAC (EVP_sha256(), salt->data, (int) salt->length,
+              ikm->data, ikm->length, prk, &prkLen) == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* Expand: T(i) = HMAC(PRK, T(i-1) | info | i) */
+    unsigned char * block = (unsigned char *)
+        UA_malloc (SHA256_DIGEST_LENGTH + info->length + 1);
+    if (block == NULL) {
+        OPENSSL_cleanse (prk, sizeof (prk));
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    UA_StatusCode ret = UA_STATUSCODE_GOOD;
+    unsigned char t[SHA256_DIGEST_LENGTH];
+    unsigned int tLen = 0;
+    unsigned char counter = 1;
+    for (size_t pos = 0; pos < out->length; counter++) {
+        memcpy (block, t, tLen);
+        memcpy (block + tLen, info->data, info->length);
+        block[tLen + info->length] = counter;
+        if (HMAC (EVP_sha256(), prk, (int) prkLen, block,
+                  tLen + info->length + 1, t, &tLen) == NULL) {
+            ret = UA_STATUSCODE_BADINTERNALERROR;
+            break;
+        }
+        size_t n = out->length - pos;
+        if (n > tLen)
+            n = tLen;
+        memcpy (out->data + pos, t, n);
+        pos += n;
+    }
+
+    OPENSSL_cleanse (prk, sizeof (prk));
+    OPENSSL_cleanse (t, sizeof (t));
+    UA_free (block);
+    return ret;
+}
+
+UA_StatusCode
+UA_OpenSSL_ECC_DeriveKeys (EVP_PKEY *            localKey,
+                           const UA_ByteString * remotePublicKey,
+                           const UA_ByteString * salt,
+                           UA_ByteString *       out) {
+    if (localKey == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    size_t coordSize = UA_OpenSSL_ECC_CoordinateSize (localKey);
+    if (remotePublicKey->length != 2 * coordSize)
+        return UA_STATUSCODE_BADNONCEINVALID;
+
+    unsigned char point[UA_OPENSSL_ECC_MAX_POINT_LENGTH];
+    point[0] = POINT_CONVERSION_UNCOMPRESSED;
+    memcpy (&point[1], remotePublicKey->data, remotePublicKey->length);
+    EVP_PKEY * remoteKey =
+        UA_OpenSSL_ECC_DecodePoint (localKey, point, remotePublicKey->length + 1);
+    if (remoteKey == NULL)
+        return UA_STATUSCODE_BADNONCEINVALID;
+
+    /* The shared secret is the X coordinate of the product */
+    unsigned char secret[UA_OPENSSL_ECC_MAX_POINT_LENGTH];
+    size_t secretLen = sizeof (secret);
+    UA_StatusCode ret = UA_STATUSCODE_BADINTERNALERROR;
+    EVP_PKEY_CTX * ctx = EVP_PKEY_CTX_new (localKey, NULL);
+    if (ctx == NULL || EVP_PKEY_derive_init (ctx) != 1)
+        goto errout;
+    if (EVP_PKEY_derive_set_peer (ctx, remoteKey) != 1) {
+        ret = UA_STATUSCODE_BADNONCEINVALID;
+        goto errout;
+    }
+    if (EVP_PKEY_derive (ctx, secret, &secretLen) != 1 || secretLen != coordSize)
+        goto errout;
+
+    UA_ByteString ikm = {coordSize, secret};
+    ret = UA_OpenSSL_HKDF_SHA256 (salt, &ikm, salt, out);
+
+errout:
+    OPENSSL_cleanse (secret, sizeof (secret));
+    EVP_PKEY_CTX_free (ctx);
+    EVP_PKEY_free (remoteKey);
+    return ret;
+}
+
 EVP_PKEY *
 UA_OpenSSL_LoadPrivateKey(const UA_ByteString *privateKey) {
     const unsigned char * pkData = privateKey->data;
@@ -885,6 +1412,8 @@ UA_OpenSSL_LoadPrivateKey(const UA_ByteString *privateKey) {
     if (len > 1 && pkData[0] == 0x30 && pkData[1] == 0x82) { // Magic number for DER encoded keys
         result = d2i_PrivateKey(EVP_PKEY_RSA, NULL,
                                           &pkData, len);
+    } else if (len > 1 && pkData[0] == 0x30) { // Shorter DER keys (ECC)
+        result = d2i_AutoPrivateKey(NULL, &pkData, len);
     } else {
         BIO *bio = NULL;
         bio = BIO_new_mem_buf((void *) privateKey->data, (int) privateKey->length);
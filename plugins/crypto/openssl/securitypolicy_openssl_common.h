@@ -17,6 +17,7 @@
 
 #include <openssl/x509.h>
 #include <openssl/evp.h>
+#include <openssl/ec.h>
 
 _UA_BEGIN_DECLS
 
@@ -125,6 +126,98 @@ UA_OpenSSL_AES_128_CBC_Encrypt(const UA_ByteString *iv,
                                const UA_ByteString *key, 
                                UA_ByteString *data  /* [in/out]*/);
 
+/* HMAC with a fixed key. The digest states after absorbing the inner and
+ * outer key pads are computed once when the key is set. Signing a message then
+ * only copies these states instead of rehashing the key. */
+typedef struct {
+    EVP_MD_CTX *inner;
+    EVP_MD_CTX *outer;
+    EVP_MD_CTX *work;
+} UA_OpenSSL_HMAC_Context;
+
+/* The symmetric cipher and HMAC contexts of a SecureChannel. They are set up
+ * when the keys are derived (once per SecurityToken) and reused for every
+ * chunk. Only the IV is reset per chunk. Padding is always disabled, the
+ * SecureChannel pads the plaintext to the cipher block size. */
+typedef struct {
+    const EVP_CIPHER *cipher;
+    const EVP_MD *md;
+    EVP_CIPHER_CTX *encryptContext; /* local encrypting key */
+    EVP_CIPHER_CTX *decryptContext; /* remote encrypting key */
+    UA_OpenSSL_HMAC_Context signContext;   /* local signing key */
+    UA_OpenSSL_HMAC_Context verifyContext; /* remote signing key */
+} UA_OpenSSL_SymmetricContext;
+
+void
+UA_OpenSSL_SymmetricContext_init(UA_OpenSSL_SymmetricContext *sc,
+                                 const EVP_CIPHER *cipher, const EVP_MD *md);
+
+void
+UA_OpenSSL_SymmetricContext_clear(UA_OpenSSL_SymmetricContext *sc);
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_setLocalSigningKey(UA_OpenSSL_SymmetricContext *sc,
+                                               const UA_ByteString *key);
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_setRemoteSigningKey(UA_OpenSSL_SymmetricContext *sc,
+                                                const UA_ByteString *key);
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_setLocalEncryptingKey(UA_OpenSSL_SymmetricContext *sc,
+                                                  const UA_ByteString *key);
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_setRemoteEncryptingKey(UA_OpenSSL_SymmetricContext *sc,
+                                                   const UA_ByteString *key);
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_sign(UA_OpenSSL_SymmetricContext *sc,
+                                 const UA_ByteString *message,
+                                 UA_ByteString *signature);
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_verify(UA_OpenSSL_SymmetricContext *sc,
+                                   const UA_ByteString *message,
+                                   const UA_ByteString *signature);
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_encrypt(UA_OpenSSL_SymmetricContext *sc,
+                                    const UA_ByteString *iv,
+                                    UA_ByteString *data /* [in/out]*/);
+
+UA_StatusCode
+UA_OpenSSL_SymmetricContext_decrypt(UA_OpenSSL_SymmetricContext *sc,
+                                    const UA_ByteString *iv,
+                                    UA_ByteString *data /* [in/out]*/);
+
+/* ECDSA with a fixed-length signature. The signature is the concatenation of
+ * r and s, each padded to the coordinate size of the curve (64 bytes for
+ * NIST P-256). */
+UA_StatusCode
+UA_OpenSSL_ECDSA_SHA256_Sign(const UA_ByteString *message,
+                             EVP_PKEY *privateKey,
+                             UA_ByteString *outSignature);
+
+UA_StatusCode
+UA_OpenSSL_ECDSA_SHA256_Verify(const UA_ByteString *message,
+                               X509 *publicKeyX509,
+                               const UA_ByteString *signature);
+
+/* Generates an ephemeral key pair on the curve. The public key is written to
+ * the preallocated buffer as the concatenation of the X and Y coordinates
+ * (without the uncompressed point prefix). */
+UA_StatusCode
+UA_OpenSSL_ECC_GenerateKey(int curveNid, EVP_PKEY **keyPair,
+                           UA_ByteString *publicKey);
+
+/* ECDH between the local ephemeral key and the remote public key (X|Y),
+ * followed by HKDF-SHA256 with the salt also used as the info argument. The
+ * output length is out->length. */
+UA_StatusCode
+UA_OpenSSL_ECC_DeriveKeys(EVP_PKEY *localKey, const UA_ByteString *remotePublicKey,
+                          const UA_ByteString *salt, UA_ByteString *out);
+
 EVP_PKEY *
 UA_OpenSSL_LoadPrivateKey(const UA_ByteString *privateKey);
 
@@ -35,11 +35,8 @@ typedef struct {
 } Policy_Context_Aes128Sha256RsaOaep;
 
 typedef struct {
-    UA_ByteString localSymSigningKey;
-    UA_ByteString localSymEncryptingKey;
+    UA_OpenSSL_SymmetricContext symmetricContext;
     UA_ByteString localSymIv;
-    UA_ByteString remoteSymSigningKey;
-    UA_ByteString remoteSymEncryptingKey;
     UA_ByteString remoteSymIv;
 
     Policy_Context_Aes128Sha256RsaOaep *policyContext;
@@ -120,12 +117,10 @@ UA_ChannelModule_Aes128Sha256RsaOaep_New_Context(const UA_SecurityPolicy *securi
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    UA_ByteString_init(&context->localSymSigningKey);
-    UA_ByteString_init(&context->localSymEncryptingKey);
     UA_ByteString_init(&context->localSymIv);
-    UA_ByteString_init(&context->remoteSymSigningKey);
-    UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
+    UA_OpenSSL_SymmetricContext_init(&context->symmetricContext,
+                                     EVP_aes_128_cbc(), EVP_sha256());
 
     UA_StatusCode retval =
         UA_copyCertificate(&context->remoteCertificate, remoteCertificate);
@@ -163,11 +158,8 @@ UA_ChannelModule_Aes128Sha256RsaOaep_Delete_Context(void *channelContext) {
             (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
         X509_free(cc->remoteCertificateX509);
         UA_ByteString_clear(&cc->remoteCertificate);
-        UA_ByteString_clear(&cc->localSymSigningKey);
-        UA_ByteString_clear(&cc->localSymEncryptingKey);
+        UA_OpenSSL_SymmetricContext_clear(&cc->symmetricContext);
         UA_ByteString_clear(&cc->localSymIv);
-        UA_ByteString_clear(&cc->remoteSymSigningKey);
-        UA_ByteString_clear(&cc->remoteSymEncryptingKey);
         UA_ByteString_clear(&cc->remoteSymIv);
 
         UA_LOG_INFO(
@@ -327,8 +319,7 @@ UA_ChannelModule_Aes128Sha256RsaOaep_setLocalSymSigningKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_OpenSSL_SymmetricContext_setLocalSigningKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -338,8 +329,7 @@ UA_ChannelM_Aes128Sha256RsaOaep_setLocalSymEncryptingKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_OpenSSL_SymmetricContext_setLocalEncryptingKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -377,8 +367,7 @@ UA_ChannelM_Aes128Sha256RsaOaep_setRemoteSymSigningKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_OpenSSL_SymmetricContext_setRemoteSigningKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -388,8 +377,7 @@ UA_ChannelM_Aes128Sha256RsaOaep_setRemoteSymEncryptingKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_OpenSSL_SymmetricContext_setRemoteEncryptingKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -438,7 +426,7 @@ UA_SymSig_Aes128Sha256RsaOaep_verify(void *channelContext, const UA_ByteString *
 
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature);
+    return UA_OpenSSL_SymmetricContext_verify(&cc->symmetricContext, message, signature);
 }
 
 static UA_StatusCode
@@ -450,7 +438,7 @@ UA_SymSig_Aes128Sha256RsaOaep_sign(void *channelContext, const UA_ByteString *me
 
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_SymmetricContext_sign(&cc->symmetricContext, message, signature);
 }
 
 static size_t
@@ -464,8 +452,7 @@ UA_SymEn_Aes128Sha256RsaOaep_decrypt(void *channelContext, UA_ByteString *data)
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_AES_128_CBC_Decrypt(&cc->remoteSymIv, &cc->remoteSymEncryptingKey,
-                                          data);
+    return UA_OpenSSL_SymmetricContext_decrypt(&cc->symmetricContext, &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -475,8 +462,7 @@ UA_SymEn_Aes128Sha256RsaOaep_encrypt(void *channelContext, UA_ByteString *data)
 
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_AES_128_CBC_Encrypt(&cc->localSymIv, &cc->localSymEncryptingKey,
-                                          data);
+    return UA_OpenSSL_SymmetricContext_encrypt(&cc->symmetricContext, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
@@ -31,11 +31,8 @@ typedef struct {
 } Policy_Context_Basic128Rsa15;
 
 typedef struct {
-    UA_ByteString             localSymSigningKey;  
-    UA_ByteString             localSymEncryptingKey; 
+    UA_OpenSSL_SymmetricContext symmetricContext;
     UA_ByteString             localSymIv; 
-    UA_ByteString             remoteSymSigningKey;
-    UA_ByteString             remoteSymEncryptingKey;
     UA_ByteString             remoteSymIv;
 
     Policy_Context_Basic128Rsa15 * policyContext;
@@ -113,12 +110,10 @@ UA_ChannelModule_Basic128Rsa15_New_Context (const UA_SecurityPolicy * securityPo
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    UA_ByteString_init(&context->localSymSigningKey);
-    UA_ByteString_init(&context->localSymEncryptingKey);
     UA_ByteString_init(&context->localSymIv);
-    UA_ByteString_init(&context->remoteSymSigningKey);
-    UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
+    UA_OpenSSL_SymmetricContext_init(&context->symmetricContext,
+                                     EVP_aes_128_cbc(), EVP_sha1());
 
     UA_StatusCode retval = UA_copyCertificate (&context->remoteCertificate, 
                                                remoteCertificate);
@@ -156,11 +151,8 @@ UA_ChannelModule_Basic128Rsa15_Delete_Context (void * channelContext) {
                                               channelContext;
         X509_free (cc->remoteCertificateX509);                                           
         UA_ByteString_clear (&cc->remoteCertificate); 
-        UA_ByteString_clear (&cc->localSymSigningKey);
-        UA_ByteString_clear (&cc->localSymEncryptingKey);
+        UA_OpenSSL_SymmetricContext_clear(&cc->symmetricContext);
         UA_ByteString_clear (&cc->localSymIv);
-        UA_ByteString_clear (&cc->remoteSymSigningKey);
-        UA_ByteString_clear (&cc->remoteSymEncryptingKey);
         UA_ByteString_clear (&cc->remoteSymIv);
         UA_LOG_INFO (cc->policyContext->logger, 
                  UA_LOGCATEGORY_SECURITYPOLICY, 
@@ -178,8 +170,7 @@ UA_ChannelModule_Basic128Rsa15_setLocalSymSigningKey (void *                chan
     }
 
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_OpenSSL_SymmetricContext_setLocalSigningKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -190,8 +181,7 @@ UA_ChannelModule_Basic128Rsa15_setLocalSymEncryptingKey (void *                c
     }
 
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_OpenSSL_SymmetricContext_setLocalEncryptingKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -214,8 +204,7 @@ UA_ChannelModule_Basic128Rsa15_setRemoteSymSigningKey (void *                cha
     }
 
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_OpenSSL_SymmetricContext_setRemoteSigningKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -226,8 +215,7 @@ UA_ChannelModule_Basic128Rsa15_setRemoteSymEncryptingKey (void *
     }
 
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_OpenSSL_SymmetricContext_setRemoteEncryptingKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -446,7 +434,7 @@ UA_SymEn_Basic128Rsa15_Encrypt (void *channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    return UA_OpenSSL_AES_128_CBC_Encrypt (&cc->localSymIv, &cc->localSymEncryptingKey, data);
+    return UA_OpenSSL_SymmetricContext_encrypt(&cc->symmetricContext, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
@@ -455,7 +443,7 @@ UA_SymEn_Basic128Rsa15_Decrypt (void *                    channelContext,
     if(channelContext == NULL || data == NULL)
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;    
-    return UA_OpenSSL_AES_128_CBC_Decrypt (&cc->remoteSymIv, &cc->remoteSymEncryptingKey, data);
+    return UA_OpenSSL_SymmetricContext_decrypt(&cc->symmetricContext, &cc->remoteSymIv, data);
 }
 
 static size_t 
@@ -476,9 +464,7 @@ UA_SymSig_Basic128Rsa15_Verify (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA1_Verify (message, 
-                                        &cc->remoteSymSigningKey, 
-                                        signature);   
+    return UA_OpenSSL_SymmetricContext_verify(&cc->symmetricContext, message, signature);
 }
 
 static UA_StatusCode 
@@ -489,7 +475,7 @@ UA_SymSig_Basic128Rsa15_Sign (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA1_Sign (message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_SymmetricContext_sign(&cc->symmetricContext, message, signature);
 }
 
 /* the main entry of Basic128Rsa15 */
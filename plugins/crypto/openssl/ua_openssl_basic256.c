@@ -29,11 +29,8 @@ typedef struct {
 } Policy_Context_Basic256;
 
 typedef struct {
-    UA_ByteString             localSymSigningKey;  
-    UA_ByteString             localSymEncryptingKey; 
+    UA_OpenSSL_SymmetricContext symmetricContext;
     UA_ByteString             localSymIv; 
-    UA_ByteString             remoteSymSigningKey;
-    UA_ByteString             remoteSymEncryptingKey;
     UA_ByteString             remoteSymIv;
 
     Policy_Context_Basic256 * policyContext;
@@ -111,12 +108,10 @@ UA_ChannelModule_Basic256_New_Context (const UA_SecurityPolicy * securityPolicy,
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    UA_ByteString_init(&context->localSymSigningKey);
-    UA_ByteString_init(&context->localSymEncryptingKey);
     UA_ByteString_init(&context->localSymIv);
-    UA_ByteString_init(&context->remoteSymSigningKey);
-    UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
+    UA_OpenSSL_SymmetricContext_init(&context->symmetricContext,
+                                     EVP_aes_256_cbc(), EVP_sha1());
 
     UA_StatusCode retval = UA_copyCertificate (&context->remoteCertificate, 
                                                remoteCertificate);
@@ -154,11 +149,8 @@ UA_ChannelModule_Basic256_Delete_Context (void * channelContext) {
                                            channelContext;
         X509_free (cc->remoteCertificateX509);                                           
         UA_ByteString_clear (&cc->remoteCertificate); 
-        UA_ByteString_clear (&cc->localSymSigningKey);
-        UA_ByteString_clear (&cc->localSymEncryptingKey);
+        UA_OpenSSL_SymmetricContext_clear(&cc->symmetricContext);
         UA_ByteString_clear (&cc->localSymIv);
-        UA_ByteString_clear (&cc->remoteSymSigningKey);
-        UA_ByteString_clear (&cc->remoteSymEncryptingKey);
         UA_ByteString_clear (&cc->remoteSymIv);
         UA_LOG_INFO (cc->policyContext->logger, 
                  UA_LOGCATEGORY_SECURITYPOLICY, 
@@ -204,8 +196,7 @@ UA_ChannelModule_Basic256_setLocalSymSigningKey (void *                channelCo
     }
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_OpenSSL_SymmetricContext_setLocalSigningKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -216,8 +207,7 @@ UA_ChannelModule_Basic256_setLocalSymEncryptingKey (void *                channe
     }
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_OpenSSL_SymmetricContext_setLocalEncryptingKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -240,8 +230,7 @@ UA_ChannelModule_Basic256_setRemoteSymSigningKey (void *                channelC
     }
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_OpenSSL_SymmetricContext_setRemoteSigningKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -252,8 +241,7 @@ UA_ChannelModule_Basic256_setRemoteSymEncryptingKey (void *                chann
     }
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_OpenSSL_SymmetricContext_setRemoteEncryptingKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -447,7 +435,7 @@ UA_SymEn_Basic256_Encrypt (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_AES_256_CBC_Encrypt (&cc->localSymIv, &cc->localSymEncryptingKey, data);
+    return UA_OpenSSL_SymmetricContext_encrypt(&cc->symmetricContext, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
@@ -456,7 +444,7 @@ UA_SymEn_Basic256_Decrypt (void *                    channelContext,
     if(channelContext == NULL || data == NULL)
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;    
-    return UA_OpenSSL_AES_256_CBC_Decrypt (&cc->remoteSymIv, &cc->remoteSymEncryptingKey, data);
+    return UA_OpenSSL_SymmetricContext_decrypt(&cc->symmetricContext, &cc->remoteSymIv, data);
 }
 
 static size_t 
@@ -478,9 +466,7 @@ UA_SymSig_Basic256_Verify (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA1_Verify (message, 
-                                        &cc->remoteSymSigningKey, 
-                                        signature);   
+    return UA_OpenSSL_SymmetricContext_verify(&cc->symmetricContext, message, signature);
 }
 
 static UA_StatusCode 
@@ -491,7 +477,7 @@ UA_SymSig_Basic256_Sign (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA1_Sign (message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_SymmetricContext_sign(&cc->symmetricContext, message, signature);
 }
 
 /* the main entry of Basic256 */
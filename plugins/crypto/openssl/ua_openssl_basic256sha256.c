@@ -36,11 +36,8 @@ typedef struct {
 } Policy_Context_Basic256Sha256;
 
 typedef struct {
-    UA_ByteString localSymSigningKey;  
-    UA_ByteString localSymEncryptingKey; 
+    UA_OpenSSL_SymmetricContext symmetricContext;
     UA_ByteString localSymIv; 
-    UA_ByteString remoteSymSigningKey;
-    UA_ByteString remoteSymEncryptingKey;
     UA_ByteString remoteSymIv;
 
     Policy_Context_Basic256Sha256 *policyContext;
@@ -110,12 +107,10 @@ UA_ChannelModule_New_Context(const UA_SecurityPolicy * securityPolicy,
     if(context == NULL)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
-    UA_ByteString_init(&context->localSymSigningKey);
-    UA_ByteString_init(&context->localSymEncryptingKey);
     UA_ByteString_init(&context->localSymIv);
-    UA_ByteString_init(&context->remoteSymSigningKey);
-    UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
+    UA_OpenSSL_SymmetricContext_init(&context->symmetricContext,
+                                     EVP_aes_256_cbc(), EVP_sha256());
 
     UA_StatusCode retval =
         UA_copyCertificate(&context->remoteCertificate, remoteCertificate);
@@ -151,11 +146,8 @@ UA_ChannelModule_Delete_Context(void * channelContext) {
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *)channelContext;
     X509_free(cc->remoteCertificateX509);                                           
     UA_ByteString_clear(&cc->remoteCertificate); 
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
+    UA_OpenSSL_SymmetricContext_clear(&cc->symmetricContext);
     UA_ByteString_clear(&cc->localSymIv);
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
     UA_ByteString_clear(&cc->remoteSymIv);
     
     UA_LOG_INFO(cc->policyContext->logger, UA_LOGCATEGORY_SECURITYPOLICY, 
@@ -311,8 +303,7 @@ UA_ChannelModule_Basic256Sha256_setLocalSymSigningKey(void * channelContext,
     if(key == NULL || channelContext == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_OpenSSL_SymmetricContext_setLocalSigningKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -321,8 +312,7 @@ UA_ChannelM_Basic256Sha256_setLocalSymEncryptingKey(void * channelContext,
     if(key == NULL || channelContext == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_OpenSSL_SymmetricContext_setLocalEncryptingKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -358,8 +348,7 @@ UA_ChannelM_Basic256Sha256_setRemoteSymSigningKey(void *channelContext,
     if(key == NULL || channelContext == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_OpenSSL_SymmetricContext_setRemoteSigningKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -368,8 +357,7 @@ UA_ChannelM_Basic256Sha256_setRemoteSymEncryptingKey(void *channelContext,
     if(key == NULL || channelContext == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_OpenSSL_SymmetricContext_setRemoteEncryptingKey(&cc->symmetricContext, key);
 }
 
 static UA_StatusCode
@@ -414,7 +402,7 @@ UA_SymSig_Basic256Sha256_verify(void *channelContext, const UA_ByteString *messa
         return UA_STATUSCODE_BADINTERNALERROR;
     
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature);   
+    return UA_OpenSSL_SymmetricContext_verify(&cc->symmetricContext, message, signature);
 }
 
 static UA_StatusCode 
@@ -424,7 +412,7 @@ UA_SymSig_Basic256Sha256_sign(void *channelContext, const UA_ByteString *message
         return UA_STATUSCODE_BADINTERNALERROR;
     
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_SymmetricContext_sign(&cc->symmetricContext, message, signature);
 }
 
 static size_t
@@ -437,8 +425,7 @@ UA_SymEn_Basic256Sha256_decrypt(void *channelContext, UA_ByteString *data) {
     if(channelContext == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_AES_256_CBC_Decrypt(&cc->remoteSymIv,
-                                          &cc->remoteSymEncryptingKey, data);
+    return UA_OpenSSL_SymmetricContext_decrypt(&cc->symmetricContext, &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -447,7 +434,7 @@ UA_SymEn_Basic256Sha256_encrypt(void *channelContext, UA_ByteString *data) {
         return UA_STATUSCODE_BADINTERNALERROR;
     
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_AES_256_CBC_Encrypt(&cc->localSymIv, &cc->localSymEncryptingKey, data);
+    return UA_OpenSSL_SymmetricContext_encrypt(&cc->symmetricContext, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
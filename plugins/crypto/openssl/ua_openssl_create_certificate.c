@@ -277,23 +277,41 @@ UA_CreateCertificate(const UA_Logger *logger,
 
     switch(certFormat) {
         case UA_CERTIFICATEFORMAT_DER: {
-            int tmpLen = i2d_PrivateKey(pkey, &outPrivateKey->data);
+            /* The DER buffers are allocated by OpenSSL. Copy them so that they
+             * can be released with UA_ByteString_clear. */
+            UA_ByteString tmpDer = UA_BYTESTRING_NULL;
+            int tmpLen = i2d_PrivateKey(pkey, &tmpDer.data);
             if(tmpLen <= 0) {
                 UA_LOG_ERROR(logger, UA_LOGCATEGORY_SECURECHANNEL,
                             "Create Certificate: Create private DER key failed.");
                 errRet = UA_STATUSCODE_BADINTERNALERROR;
                 goto cleanup;
             }
-            outPrivateKey->length = (size_t) tmpLen;
+            tmpDer.length = (size_t) tmpLen;
+            errRet = UA_ByteString_copy(&tmpDer, outPrivateKey);
+            OPENSSL_free(tmpDer.data);
+            if(errRet != UA_STATUSCODE_GOOD) {
+                UA_LOG_ERROR(logger, UA_LOGCATEGORY_SECURECHANNEL,
+                            "Create Certificate: Copy DER PKey failed.");
+                goto cleanup;
+            }
 
-            tmpLen = i2d_X509(x509, &outCertificate->data);
+            tmpDer = UA_BYTESTRING_NULL;
+            tmpLen = i2d_X509(x509, &tmpDer.data);
             if(tmpLen <= 0) {
                 UA_LOG_ERROR(logger, UA_LOGCATEGORY_SECURECHANNEL,
                             "Create Certificate: Create DER-certificate failed.");
                 errRet = UA_STATUSCODE_BADINTERNALERROR;
                 goto cleanup;
             }
-            outCertificate->length = (size_t) tmpLen;
+            tmpDer.length = (size_t) tmpLen;
+            errRet = UA_ByteString_copy(&tmpDer, outCertificate);
+            OPENSSL_free(tmpDer.data);
+            if(errRet != UA_STATUSCODE_GOOD) {
+                UA_LOG_ERROR(logger, UA_LOGCATEGORY_SECURECHANNEL,
+                            "Create Certificate: Copy DER Certificate failed.");
+                goto cleanup;
+            }
             break;
         }
         case UA_CERTIFICATEFORMAT_PEM: {
@@ -0,0 +1,561 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <open62541/plugin/securitypolicy_default.h>
+#include <open62541/util.h>
+
+#if defined(UA_ENABLE_ENCRYPTION_OPENSSL) || defined(UA_ENABLE_ENCRYPTION_LIBRESSL)
+
+#include "securitypolicy_openssl_common.h"
+
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+#include <openssl/rand.h>
+#include <openssl/x509.h>
+
+/* ECC_nistP256 (OPC UA 1.05). The SecureChannel keys are derived from an
+ * ephemeral ECDH key exchange. The nonces are the ephemeral public keys. The
+ * OPN messages are signed with ECDSA but not encrypted. */
+
+#define UA_SHA256_LENGTH 32 /* 256 bit */
+#define UA_SECURITYPOLICY_ECCNISTP256_CURVE NID_X9_62_prime256v1
+#define UA_SECURITYPOLICY_ECCNISTP256_SIGNATURE_LENGTH 64 /* r|s */
+#define UA_SECURITYPOLICY_ECCNISTP256_NONCE_LENGTH 64 /* X|Y */
+#define UA_SECURITYPOLICY_ECCNISTP256_SYM_SIGNING_KEY_LENGTH 32
+#define UA_SECURITYPOLICY_ECCNISTP256_SYM_ENCRYPTION_KEY_LENGTH 16
+#define UA_SECURITYPOLICY_ECCNISTP256_SYM_ENCRYPTION_BLOCK_SIZE 16
+
+typedef struct {
+    EVP_PKEY *localPrivateKey;
+    UA_ByteString localCertThumbprint;
+    UA_ApplicationType applicationType;
+    const UA_Logger *logger;
+} Policy_Context_EccNistP256;
+
+typedef struct {
+    UA_OpenSSL_SymmetricContext symmetricContext;
+    UA_ByteString localSymIv;
+    UA_ByteString remoteSymIv;
+
+    /* Ephemeral key pair of the latest local nonce */
+    EVP_PKEY *ephemeralKey;
+    UA_ByteString ephemeralPublicKey;
+
+    Policy_Context_EccNistP256 *policyContext;
+    UA_ByteString remoteCertificate;
+    X509 *remoteCertificateX509; /* X509 */
+} Channel_Context_EccNistP256;
+
+/* create the policy context */
+
+static UA_StatusCode
+UA_Policy_EccNistP256_New_Context(UA_SecurityPolicy *securityPolicy,
+                                  UA_ApplicationType applicationType,
+                                  const UA_ByteString localPrivateKey,
+                                  const UA_Logger *logger) {
+    Policy_Context_EccNistP256 *context = (Policy_Context_EccNistP256 *)
+        UA_malloc(sizeof(Policy_Context_EccNistP256));
+    if(context == NULL)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    context->localPrivateKey = UA_OpenSSL_LoadPrivateKey(&localPrivateKey);
+    if(!context->localPrivateKey || EVP_PKEY_base_id(context->localPrivateKey) != EVP_PKEY_EC) {
+        EVP_PKEY_free(context->localPrivateKey);
+        UA_free(context);
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    }
+
+    UA_StatusCode retval = UA_Openssl_X509_GetCertificateThumbprint(
+        &securityPolicy->localCertificate, &context->localCertThumbprint, true);
+    if(retval != UA_STATUSCODE_GOOD) {
+        EVP_PKEY_free(context->localPrivateKey);
+        UA_free(context);
+        return retval;
+    }
+
+    context->applicationType = applicationType;
+    context->logger = logger;
+    securityPolicy->policyContext = context;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* clear the policy context */
+
+static void
+UA_Policy_EccNistP256_Clear_Context(UA_SecurityPolicy *policy) {
+    if(policy == NULL)
+        return;
+
+    UA_ByteString_clear(&policy->localCertificate);
+
+    Policy_Context_EccNistP256 *pc = (Policy_Context_EccNistP256 *)policy->policyContext;
+    if(pc == NULL)
+        return;
+
+    EVP_PKEY_free(pc->localPrivateKey);
+    UA_ByteString_clear(&pc->localCertThumbprint);
+    UA_free(pc);
+}
+
+/* create the channel context */
+
+static UA_StatusCode
+UA_ChannelModule_EccNistP256_New_Context(const UA_SecurityPolicy *securityPolicy,
+                                         const UA_ByteString *remoteCertificate,
+                                         void **channelContext) {
+    if(securityPolicy == NULL || remoteCertificate == NULL || channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    Channel_Context_EccNistP256 *context = (Channel_Context_EccNistP256 *)
+        UA_malloc(sizeof(Channel_Context_EccNistP256));
+    if(context == NULL)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    UA_ByteString_init(&context->localSymIv);
+    UA_ByteString_init(&context->remoteSymIv);
+    UA_ByteString_init(&context->ephemeralPublicKey);
+    context->ephemeralKey = NULL;
+    UA_OpenSSL_SymmetricContext_init(&context->symmetricContext,
+                                     EVP_aes_128_cbc(), EVP_sha256());
+
+    UA_StatusCode retval =
+        UA_copyCertificate(&context->remoteCertificate, remoteCertificate);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_free(context);
+        return retval;
+    }
+
+    /* decode to X509 */
+    context->remoteCertificateX509 = UA_OpenSSL_LoadCertificate(&context->remoteCertificate);
+    if(context->remoteCertificateX509 == NULL) {
+        UA_ByteString_clear(&context->remoteCertificate);
+        UA_free(context);
+        return UA_STATUSCODE_BADCERTIFICATECHAININCOMPLETE;
+    }
+
+    context->policyContext = (Policy_Context_EccNistP256 *)securityPolicy->policyContext;
+    *channelContext = context;
+
+    UA_LOG_INFO(securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
+                "The EccNistP256 security policy channel with openssl is created.");
+    return UA_STATUSCODE_GOOD;
+}
+
+/* delete the channel context */
+
+static void
+UA_ChannelModule_EccNistP256_Delete_Context(void *channelContext) {
+    if(channelContext == NULL)
+        return;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+    X509_free(cc->remoteCertificateX509);
+    UA_ByteString_clear(&cc->remoteCertificate);
+    UA_OpenSSL_SymmetricContext_clear(&cc->symmetricContext);
+    UA_ByteString_clear(&cc->localSymIv);
+    UA_ByteString_clear(&cc->remoteSymIv);
+    EVP_PKEY_free(cc->ephemeralKey);
+    UA_ByteString_clear(&cc->ephemeralPublicKey);
+
+    UA_LOG_INFO(cc->policyContext->logger, UA_LOGCATEGORY_SECURITYPOLICY,
+                "The EccNistP256 security policy channel with openssl is deleted.");
+    UA_free(cc);
+}
+
+/* Creates a new ephemeral key pair. The public key is the nonce. */
+
+static UA_StatusCode
+UA_ChannelModule_EccNistP256_generateNonce(void *channelContext, UA_ByteString *out) {
+    if(channelContext == NULL || out == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+
+    EVP_PKEY *key = NULL;
+    UA_StatusCode retval =
+        UA_OpenSSL_ECC_GenerateKey(UA_SECURITYPOLICY_ECCNISTP256_CURVE, &key, out);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    UA_ByteString_clear(&cc->ephemeralPublicKey);
+    retval = UA_ByteString_copy(out, &cc->ephemeralPublicKey);
+    if(retval != UA_STATUSCODE_GOOD) {
+        EVP_PKEY_free(key);
+        return retval;
+    }
+    EVP_PKEY_free(cc->ephemeralKey);
+    cc->ephemeralKey = key;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The keys of a party are derived with the salt
+ * L | "opcua-client" or "opcua-server" | OwnNonce | OtherNonce.
+ * The SecureChannel calls generateKey with the own nonce of the key owner as
+ * the seed (the same argument order as for P_SHA). */
+
+static UA_StatusCode
+UA_ChannelModule_EccNistP256_generateKey(void *channelContext,
+                                         const UA_ByteString *secret,
+                                         const UA_ByteString *seed,
+                                         UA_ByteString *out) {
+    if(channelContext == NULL || secret == NULL || seed == NULL || out == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+    if(cc->ephemeralKey == NULL || out->length > UA_UINT16_MAX)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* Which nonce is the remote public key? */
+    const UA_ByteString *remoteNonce;
+    UA_Boolean seedIsLocal = UA_ByteString_equal(seed, &cc->ephemeralPublicKey);
+    if(seedIsLocal)
+        remoteNonce = secret;
+    else if(UA_ByteString_equal(secret, &cc->ephemeralPublicKey))
+        remoteNonce = seed;
+    else
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    UA_Boolean localIsClient =
+        (cc->policyContext->applicationType == UA_APPLICATIONTYPE_CLIENT);
+    const UA_String label = (seedIsLocal == localIsClient) ?
+        UA_STRING("opcua-client") : UA_STRING("opcua-server");
+
+    UA_ByteString salt;
+    UA_StatusCode retval =
+        UA_ByteString_allocBuffer(&salt, 2 + label.length + seed->length + secret->length);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    salt.data[0] = (UA_Byte)out->length;
+    salt.data[1] = (UA_Byte)(out->length >> 8);
+    UA_Byte *pos = &salt.data[2];
+    memcpy(pos, label.data, label.length);
+    pos += label.length;
+    memcpy(pos, seed->data, seed->length);
+    pos += seed->length;
+    memcpy(pos, secret->data, secret->length);
+
+    retval = UA_OpenSSL_ECC_DeriveKeys(cc->ephemeralKey, remoteNonce, &salt, out);
+    UA_ByteString_clear(&salt);
+    return retval;
+}
+
+/* Verifies the signature of the message using the provided keys in the context.
+ * AsymmetricSignatureAlgorithm_ECDSA-SHA2-256
+ */
+
+static UA_StatusCode
+UA_AsySig_EccNistP256_Verify(void *channelContext, const UA_ByteString *message,
+                             const UA_ByteString *signature) {
+    if(message == NULL || signature == NULL || channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+    return UA_OpenSSL_ECDSA_SHA256_Verify(message, cc->remoteCertificateX509, signature);
+}
+
+static UA_StatusCode
+UA_AsySig_EccNistP256_Sign(void *channelContext, const UA_ByteString *message,
+                           UA_ByteString *signature) {
+    if(channelContext == NULL || message == NULL || signature == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+    return UA_OpenSSL_ECDSA_SHA256_Sign(message, cc->policyContext->localPrivateKey,
+                                        signature);
+}
+
+static size_t
+UA_AsySig_EccNistP256_getSignatureSize(const void *channelContext) {
+    return UA_SECURITYPOLICY_ECCNISTP256_SIGNATURE_LENGTH;
+}
+
+/* No asymmetric encryption. The block sizes are only defined for
+ * completeness. */
+
+static size_t
+UA_AsymEn_EccNistP256_getBlockSize(const void *channelContext) {
+    return 1;
+}
+
+static size_t
+UA_AsymEn_EccNistP256_getKeyLength(const void *channelContext) {
+    return 0;
+}
+
+/* Compares the supplied certificate with the certificate
+ * in the endpoint context
+ */
+
+static UA_StatusCode
+UA_compareCertificateThumbprint_EccNistP256(const UA_SecurityPolicy *securityPolicy,
+                                            const UA_ByteString *certificateThumbprint) {
+    if(securityPolicy == NULL || certificateThumbprint == NULL)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    Policy_Context_EccNistP256 *pc =
+        (Policy_Context_EccNistP256 *)securityPolicy->policyContext;
+    if(!UA_ByteString_equal(certificateThumbprint, &pc->localCertThumbprint))
+        return UA_STATUSCODE_BADCERTIFICATEINVALID;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Generates a thumbprint for the specified certificate */
+
+static UA_StatusCode
+UA_makeCertificateThumbprint_EccNistP256(const UA_SecurityPolicy *securityPolicy,
+                                         const UA_ByteString *certificate,
+                                         UA_ByteString *thumbprint) {
+    return UA_Openssl_X509_GetCertificateThumbprint(certificate, thumbprint, false);
+}
+
+/* Random nonces for the session. The SecureChannel nonces are generated in the
+ * channel module. */
+
+static UA_StatusCode
+UA_Sym_EccNistP256_generateNonce(void *policyContext, UA_ByteString *out) {
+    if(RAND_bytes(out->data, (int)out->length) != 1)
+        return UA_STATUSCODE_BADUNEXPECTEDERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+UA_Sym_EccNistP256_generateKey(void *policyContext, const UA_ByteString *secret,
+                               const UA_ByteString *seed, UA_ByteString *out) {
+    /* The keys are derived with the ephemeral key in the channel context */
+    return UA_STATUSCODE_BADINTERNALERROR;
+}
+
+static size_t
+UA_SymEn_EccNistP256_getKeyLength(const void *channelContext) {
+    return UA_SECURITYPOLICY_ECCNISTP256_SYM_ENCRYPTION_KEY_LENGTH;
+}
+
+static size_t
+UA_SymEn_EccNistP256_getBlockSize(const void *channelContext) {
+    return UA_SECURITYPOLICY_ECCNISTP256_SYM_ENCRYPTION_BLOCK_SIZE;
+}
+
+static size_t
+UA_SymSig_EccNistP256_getKeyLength(const void *channelContext) {
+    return UA_SECURITYPOLICY_ECCNISTP256_SYM_SIGNING_KEY_LENGTH;
+}
+
+static size_t
+UA_SymSig_EccNistP256_getSignatureSize(const void *channelContext) {
+    return UA_SHA256_LENGTH;
+}
+
+static UA_StatusCode
+UA_ChannelM_EccNistP256_setLocalSymSigningKey(void *channelContext,
+                                              const UA_ByteString *key) {
+    if(key == NULL || channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+    return UA_OpenSSL_SymmetricContext_setLocalSigningKey(&cc->symmetricContext, key);
+}
+
+static UA_StatusCode
+UA_ChannelM_EccNistP256_setLocalSymEncryptingKey(void *channelContext,
+                                                 const UA_ByteString *key) {
+    if(key == NULL || channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+    return UA_OpenSSL_SymmetricContext_setLocalEncryptingKey(&cc->symmetricContext, key);
+}
+
+static UA_StatusCode
+UA_ChannelM_EccNistP256_setLocalSymIv(void *channelContext, const UA_ByteString *iv) {
+    if(iv == NULL || channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+    UA_ByteString_clear(&cc->localSymIv);
+    return UA_ByteString_copy(iv, &cc->localSymIv);
+}
+
+static UA_StatusCode
+UA_ChannelM_EccNistP256_setRemoteSymSigningKey(void *channelContext,
+                                               const UA_ByteString *key) {
+    if(key == NULL || channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+    return UA_OpenSSL_SymmetricContext_setRemoteSigningKey(&cc->symmetricContext, key);
+}
+
+static UA_StatusCode
+UA_ChannelM_EccNistP256_setRemoteSymEncryptingKey(void *channelContext,
+                                                  const UA_ByteString *key) {
+    if(key == NULL || channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+    return UA_OpenSSL_SymmetricContext_setRemoteEncryptingKey(&cc->symmetricContext, key);
+}
+
+static UA_StatusCode
+UA_ChannelM_EccNistP256_setRemoteSymIv(void *channelContext, const UA_ByteString *iv) {
+    if(iv == NULL || channelContext == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+    UA_ByteString_clear(&cc->remoteSymIv);
+    return UA_ByteString_copy(iv, &cc->remoteSymIv);
+}
+
+static UA_StatusCode
+UA_SymSig_EccNistP256_verify(void *channelContext, const UA_ByteString *message,
+                             const UA_ByteString *signature) {
+    if(channelContext == NULL || message == NULL || signature == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+    return UA_OpenSSL_SymmetricContext_verify(&cc->symmetricContext, message, signature);
+}
+
+static UA_StatusCode
+UA_SymSig_EccNistP256_sign(void *channelContext, const UA_ByteString *message,
+                           UA_ByteString *signature) {
+    if(channelContext == NULL || message == NULL || signature == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+    return UA_OpenSSL_SymmetricContext_sign(&cc->symmetricContext, message, signature);
+}
+
+static UA_StatusCode
+UA_SymEn_EccNistP256_decrypt(void *channelContext, UA_ByteString *data) {
+    if(channelContext == NULL || data == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+    return UA_OpenSSL_SymmetricContext_decrypt(&cc->symmetricContext, &cc->remoteSymIv, data);
+}
+
+static UA_StatusCode
+UA_SymEn_EccNistP256_encrypt(void *channelContext, UA_ByteString *data) {
+    if(channelContext == NULL || data == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_EccNistP256 *cc = (Channel_Context_EccNistP256 *)channelContext;
+    return UA_OpenSSL_SymmetricContext_encrypt(&cc->symmetricContext, &cc->localSymIv, data);
+}
+
+static UA_StatusCode
+UA_ChannelM_EccNistP256_compareCertificate(const void *channelContext,
+                                           const UA_ByteString *certificate) {
+    if(channelContext == NULL || certificate == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    const Channel_Context_EccNistP256 *cc = (const Channel_Context_EccNistP256 *)channelContext;
+    return UA_OpenSSL_X509_compare(certificate, cc->remoteCertificateX509);
+}
+
+/* the main entry of EccNistP256 */
+
+UA_StatusCode
+UA_SecurityPolicy_EccNistP256(UA_SecurityPolicy *policy,
+                              UA_ApplicationType applicationType,
+                              const UA_ByteString localCertificate,
+                              const UA_ByteString localPrivateKey,
+                              const UA_Logger *logger) {
+    UA_SecurityPolicyAsymmetricModule *const asymmetricModule = &policy->asymmetricModule;
+    UA_SecurityPolicySymmetricModule *const symmetricModule = &policy->symmetricModule;
+    UA_SecurityPolicyChannelModule *const channelModule = &policy->channelModule;
+    UA_StatusCode retval;
+
+    UA_LOG_INFO(logger, UA_LOGCATEGORY_SECURITYPOLICY,
+                "The EccNistP256 security policy with openssl is added.");
+
+    UA_Openssl_Init();
+    memset(policy, 0, sizeof(UA_SecurityPolicy));
+    policy->logger = logger;
+    policy->policyUri =
+        UA_STRING("http://opcfoundation.org/UA/SecurityPolicy#ECC_nistP256\0");
+
+    /* set ChannelModule context  */
+
+    channelModule->newContext = UA_ChannelModule_EccNistP256_New_Context;
+    channelModule->deleteContext = UA_ChannelModule_EccNistP256_Delete_Context;
+    channelModule->setLocalSymSigningKey = UA_ChannelM_EccNistP256_setLocalSymSigningKey;
+    channelModule->setLocalSymEncryptingKey =
+        UA_ChannelM_EccNistP256_setLocalSymEncryptingKey;
+    channelModule->setLocalSymIv = UA_ChannelM_EccNistP256_setLocalSymIv;
+    channelModule->setRemoteSymSigningKey = UA_ChannelM_EccNistP256_setRemoteSymSigningKey;
+    channelModule->setRemoteSymEncryptingKey =
+        UA_ChannelM_EccNistP256_setRemoteSymEncryptingKey;
+    channelModule->setRemoteSymIv = UA_ChannelM_EccNistP256_setRemoteSymIv;
+    channelModule->compareCertificate = UA_ChannelM_EccNistP256_compareCertificate;
+    channelModule->generateNonce = UA_ChannelModule_EccNistP256_generateNonce;
+    channelModule->generateKey = UA_ChannelModule_EccNistP256_generateKey;
+
+    /* Copy the certificate and add a NULL to the end */
+
+    retval = UA_copyCertificate(&policy->localCertificate, &localCertificate);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* AsymmetricModule - signature algorithm */
+
+    UA_SecurityPolicySignatureAlgorithm *asySigAlgorithm =
+        &asymmetricModule->cryptoModule.signatureAlgorithm;
+    asySigAlgorithm->uri =
+        UA_STRING("http://www.w3.org/2001/04/xmldsig-more#ecdsa-sha256\0");
+    asySigAlgorithm->verify = UA_AsySig_EccNistP256_Verify;
+    asySigAlgorithm->sign = UA_AsySig_EccNistP256_Sign;
+    asySigAlgorithm->getRemoteSignatureSize = UA_AsySig_EccNistP256_getSignatureSize;
+    asySigAlgorithm->getLocalSignatureSize = UA_AsySig_EccNistP256_getSignatureSize;
+    asySigAlgorithm->getLocalKeyLength = NULL;
+    asySigAlgorithm->getRemoteKeyLength = NULL;
+
+    /* AsymmetricModule encryption algorithm. The uri stays empty and
+     * encrypt/decrypt are NULL. */
+
+    UA_SecurityPolicyEncryptionAlgorithm *asymEncryAlg =
+        &asymmetricModule->cryptoModule.encryptionAlgorithm;
+    asymEncryAlg->getRemotePlainTextBlockSize = UA_AsymEn_EccNistP256_getBlockSize;
+    asymEncryAlg->getRemoteBlockSize = UA_AsymEn_EccNistP256_getBlockSize;
+    asymEncryAlg->getRemoteKeyLength = UA_AsymEn_EccNistP256_getKeyLength;
+    asymEncryAlg->getLocalKeyLength = UA_AsymEn_EccNistP256_getKeyLength;
+
+    /* asymmetricModule */
+
+    asymmetricModule->compareCertificateThumbprint =
+        UA_compareCertificateThumbprint_EccNistP256;
+    asymmetricModule->makeCertificateThumbprint = UA_makeCertificateThumbprint_EccNistP256;
+
+    /* SymmetricModule */
+
+    symmetricModule->secureChannelNonceLength = UA_SECURITYPOLICY_ECCNISTP256_NONCE_LENGTH;
+    symmetricModule->generateNonce = UA_Sym_EccNistP256_generateNonce;
+    symmetricModule->generateKey = UA_Sym_EccNistP256_generateKey;
+
+    /* Symmetric encryption Algorithm */
+
+    UA_SecurityPolicyEncryptionAlgorithm *symEncryptionAlgorithm =
+        &symmetricModule->cryptoModule.encryptionAlgorithm;
+    symEncryptionAlgorithm->uri = UA_STRING("http://www.w3.org/2001/04/xmlenc#aes128-cbc\0");
+    symEncryptionAlgorithm->getLocalKeyLength = UA_SymEn_EccNistP256_getKeyLength;
+    symEncryptionAlgorithm->getRemoteKeyLength = UA_SymEn_EccNistP256_getKeyLength;
+    symEncryptionAlgorithm->getRemoteBlockSize = UA_SymEn_EccNistP256_getBlockSize;
+    symEncryptionAlgorithm->getRemotePlainTextBlockSize = UA_SymEn_EccNistP256_getBlockSize;
+    symEncryptionAlgorithm->decrypt = UA_SymEn_EccNistP256_decrypt;
+    symEncryptionAlgorithm->encrypt = UA_SymEn_EccNistP256_encrypt;
+
+    /* Symmetric signature Algorithm */
+
+    UA_SecurityPolicySignatureAlgorithm *symSignatureAlgorithm =
+        &symmetricModule->cryptoModule.signatureAlgorithm;
+    symSignatureAlgorithm->uri = UA_STRING("http://www.w3.org/2000/09/xmldsig#hmac-sha2-256\0");
+    symSignatureAlgorithm->getLocalKeyLength = UA_SymSig_EccNistP256_getKeyLength;
+    symSignatureAlgorithm->getRemoteKeyLength = UA_SymSig_EccNistP256_getKeyLength;
+    symSignatureAlgorithm->getRemoteSignatureSize = UA_SymSig_EccNistP256_getSignatureSize;
+    symSignatureAlgorithm->getLocalSignatureSize = UA_SymSig_EccNistP256_getSignatureSize;
+    symSignatureAlgorithm->verify = UA_SymSig_EccNistP256_verify;
+    symSignatureAlgorithm->sign = UA_SymSig_EccNistP256_sign;
+
+    retval = UA_Policy_EccNistP256_New_Context(policy, applicationType,
+                                               localPrivateKey, logger);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&policy->localCertificate);
+        return retval;
+    }
+    policy->clear = UA_Policy_EccNistP256_Clear_Context;
+
+    /* Use the same signature algorithm as the asymmetric component for
+       certificate signing (see standard) */
+
+    policy->certificateSigningAlgorithm =
+        policy->asymmetricModule.cryptoModule.signatureAlgorithm;
+
+    return UA_STATUSCODE_GOOD;
+}
+
+#endif
@@ -31,6 +31,12 @@
 #define get_pkey_rsa(evp) EVP_PKEY_get0_RSA(evp)
 #endif
 
+#if OPENSSL_VERSION_NUMBER < 0x1010000fL || defined(LIBRESSL_VERSION_NUMBER)
+#define get_pkey_ec(evp) ((evp)->pkey.ec)
+#else
+#define get_pkey_ec(evp) EVP_PKEY_get0_EC_KEY(evp)
+#endif
+
 #if OPENSSL_VERSION_NUMBER < 0x1010000fL || defined(LIBRESSL_VERSION_NUMBER)
 #define X509_get0_subject_key_id(PX509_CERT) (const ASN1_OCTET_STRING *)X509_get_ext_d2i(PX509_CERT, NID_subject_key_identifier, NULL, NULL);
 #endif
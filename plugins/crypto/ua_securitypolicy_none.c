@@ -181,6 +181,8 @@ UA_SecurityPolicy_None(UA_SecurityPolicy *policy, const UA_ByteString localCerti
     policy->channelModule.setRemoteSymSigningKey = setContextValue_none;
     policy->channelModule.setRemoteSymIv = setContextValue_none;
     policy->channelModule.compareCertificate = compareCertificate_none;
+    policy->channelModule.generateNonce = NULL;
+    policy->channelModule.generateKey = NULL;
     policy->updateCertificateAndPrivateKey = updateCertificateAndPrivateKey_none;
     policy->clear = policy_clear_none;
 
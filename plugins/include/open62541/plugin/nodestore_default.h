@@ -18,6 +18,33 @@ _UA_BEGIN_DECLS
 UA_EXPORT UA_StatusCode
 UA_Nodestore_HashMap(UA_Nodestore *ns);
 
+/* The HashMap Nodestore with "pointer swizzling". References to local nodes
+ * are resolved into direct pointers to the target node. Following references
+ * (e.g. during Browse or the recursive browsing of the hierarchy) then no
+ * longer requires a hash-map lookup. The pointers remain valid when a node is
+ * replaced. A removed node leaves a small tombstone behind (the NodeId) as long
+ * as pointers to it remain. References added to a node in-situ are resolved
+ * when the node is released. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_HashMapSwizzled(UA_Nodestore *ns);
+
+typedef struct {
+    /* Pointer swizzling, see UA_Nodestore_HashMapSwizzled */
+    UA_Boolean swizzle;
+
+    /* Compact the DisplayName and Description of the nodes once they are
+     * inserted or released after an edit. DisplayNames equal to the BrowseName
+     * and empty Descriptions take up no memory. Other values are kept in an
+     * encoded buffer and decoded on demand. This reduces the resident memory
+     * of large information models. See UA_Node_compactAttributes. */
+    UA_Boolean compactAttributes;
+} UA_NodestoreHashMapOptions;
+
+/* The HashMap Nodestore with additional options */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_HashMapWithOptions(UA_Nodestore *ns,
+                                const UA_NodestoreHashMapOptions *options);
+
 /* The ZipTree Nodestore holds all nodes in RAM in a tree structure. The lookup
  * time is about O(log n). Adding/removing nodes does not require resizing of
  * the underlying array with the linear overhead.
@@ -46,6 +46,20 @@ UA_SecurityPolicy_Aes128Sha256RsaOaep(UA_SecurityPolicy *policy,
 
 #endif
 
+#if defined(UA_ENABLE_ENCRYPTION_OPENSSL) || defined(UA_ENABLE_ENCRYPTION_LIBRESSL)
+
+/* ECC_nistP256 requires a NIST P-256 certificate and private key. The
+ * SecureChannel keys are derived from an ephemeral key exchange. The
+ * applicationType selects the side for the key derivation. */
+UA_EXPORT UA_StatusCode
+UA_SecurityPolicy_EccNistP256(UA_SecurityPolicy *policy,
+                              UA_ApplicationType applicationType,
+                              const UA_ByteString localCertificate,
+                              const UA_ByteString localPrivateKey,
+                              const UA_Logger *logger);
+
+#endif
+
 #ifdef UA_ENABLE_PUBSUB_ENCRYPTION
 
 UA_EXPORT UA_StatusCode
@@ -199,6 +199,22 @@ UA_ServerConfig_addSecurityPolicyAes128Sha256RsaOaep(UA_ServerConfig *config,
                                                      const UA_ByteString *certificate,
                                                      const UA_ByteString *privateKey);
 
+#if defined(UA_ENABLE_ENCRYPTION_OPENSSL) || defined(UA_ENABLE_ENCRYPTION_LIBRESSL)
+/* Adds the security policy ``SecurityPolicy#ECC_nistP256`` to the server. The
+ * certificate and private key are for the NIST P-256 curve. The policy is not
+ * part of UA_ServerConfig_addAllSecurityPolicies, since it requires a
+ * different certificate than the RSA policies.
+ *
+ * @param config The configuration to manipulate
+ * @param certificate The server certificate.
+ * @param privateKey The private key that corresponds to the certificate.
+ */
+UA_EXPORT UA_StatusCode
+UA_ServerConfig_addSecurityPolicyEccNistP256(UA_ServerConfig *config,
+                                             const UA_ByteString *certificate,
+                                             const UA_ByteString *privateKey);
+#endif
+
 /* Adds all supported security policies and sets up certificate
  * validation procedures.
  *
@@ -114,7 +114,7 @@ connectMqtt(UA_PubSubChannelDataMQTT* channelData){
         char *mqttCaFilePath = NULL;
         if (channelData->mqttCaFilePath.length > 0) {
             /* Convert tls certificate path UA_String to char* null terminated */
-            mqttCaFilePath = (char*)calloc(1,channelData->mqttCaFilePath.length + 1);
+            mqttCaFilePath = (char*)UA_calloc(1,channelData->mqttCaFilePath.length + 1);
             if(!mqttCaFilePath){
                 UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "PubSub MQTT: Connection creation failed. Out of memory.");
                 // TODO: There are several places in the existing code where channelData->connection is freed but not set to NULL
@@ -128,7 +128,7 @@ connectMqtt(UA_PubSubChannelDataMQTT* channelData){
         char *mqttCaPath = NULL;
         if (channelData->mqttCaPath.length > 0) {
             /* Convert tls CA path UA_String to char* null terminated */
-            mqttCaPath = (char*)calloc(1,channelData->mqttCaPath.length + 1);
+            mqttCaPath = (char*)UA_calloc(1,channelData->mqttCaPath.length + 1);
             if(!mqttCaPath){
                 UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "PubSub MQTT: Connection creation failed. Out of memory.");
                 UA_free(mqttCaFilePath);
@@ -140,7 +140,7 @@ connectMqtt(UA_PubSubChannelDataMQTT* channelData){
         char *mqttClientCertPath = NULL;
         if (channelData->mqttClientCertPath.length > 0) {
             /* Convert tls client cert path UA_String to char* null terminated */
-            mqttClientCertPath = (char*)calloc(1,channelData->mqttClientCertPath.length + 1);
+            mqttClientCertPath = (char*)UA_calloc(1,channelData->mqttClientCertPath.length + 1);
             if(!mqttClientCertPath){
                 UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "PubSub MQTT: Connection creation failed. Out of memory.");
                 UA_free(mqttCaFilePath);
@@ -153,7 +153,7 @@ connectMqtt(UA_PubSubChannelDataMQTT* channelData){
         char *mqttClientKeyPath = NULL;
         if (channelData->mqttClientKeyPath.length > 0) {
             /* Convert tls client key path UA_String to char* null terminated */
-            mqttClientKeyPath = (char*)calloc(1,channelData->mqttClientKeyPath.length + 1);
+            mqttClientKeyPath = (char*)UA_calloc(1,channelData->mqttClientKeyPath.length + 1);
             if(!mqttClientKeyPath){
                 UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "PubSub MQTT: Connection creation failed. Out of memory.");
                 UA_free(mqttCaFilePath);
@@ -329,7 +329,7 @@ connectMqtt(UA_PubSubChannelDataMQTT* channelData){
     client->publish_response_callback_state = channelData;
 
     /* Convert clientId UA_String to char* null terminated */
-    char* clientId = (char*)calloc(1,channelData->mqttClientId->length + 1);
+    char* clientId = (char*)UA_calloc(1,channelData->mqttClientId->length + 1);
     if(!clientId){
         UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "PubSub MQTT: Connection creation failed. Out of memory.");
         freeTLS(channelData);
@@ -342,7 +342,7 @@ connectMqtt(UA_PubSubChannelDataMQTT* channelData){
     char *username = NULL;
     if (channelData->mqttUsername.length > 0) {
         /* Convert username UA_String to char* null terminated */
-        username = (char*)calloc(1,channelData->mqttUsername.length + 1);
+        username = (char*)UA_calloc(1,channelData->mqttUsername.length + 1);
         if(!username){
             UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "PubSub MQTT: Connection creation failed. Out of memory.");
             freeTLS(channelData);
@@ -357,7 +357,7 @@ connectMqtt(UA_PubSubChannelDataMQTT* channelData){
     char *password = NULL;
     if (channelData->mqttPassword.length > 0) {
         /* Convert password UA_String to char* null terminated */
-        password = (char*)calloc(1,channelData->mqttPassword.length + 1);
+        password = (char*)UA_calloc(1,channelData->mqttPassword.length + 1);
         if(!password){
             UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "PubSub MQTT: Connection creation failed. Out of memory.");
             freeTLS(channelData);
@@ -192,6 +192,7 @@ setDefaultConfig(UA_ServerConfig *conf) {
     /* conf->nodeLifecycle.createOptionalChild = NULL; */
     /* conf->nodeLifecycle.generateChildNodeId = NULL; */
     conf->modellingRulesOnInstances = UA_TRUE;
+    conf->shareTypeChildValues = UA_FALSE;
 
     /* Limits for SecureChannels */
     conf->maxSecureChannels = 40;
@@ -200,6 +201,7 @@ setDefaultConfig(UA_ServerConfig *conf) {
     /* Limits for Sessions */
     conf->maxSessions = 100;
     conf->maxSessionTimeout = 60.0 * 60.0 * 1000.0; /* 1h */
+    conf->maxRegisteredNodesPerSession = 0; /* disabled */
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     /* Limits for Subscriptions */
@@ -222,6 +224,11 @@ setDefaultConfig(UA_ServerConfig *conf) {
     conf->discoveryCleanupTimeout = 60 * 60;
 #endif
 
+#ifdef UA_ENABLE_TRACING
+    conf->tracingSampleInterval = 0; /* disabled */
+    conf->tracingBufferSize = 4096;
+#endif
+
 #ifdef UA_ENABLE_HISTORIZING
     /* conf->accessHistoryDataCapability = UA_FALSE; */
     /* conf->maxReturnDataValues = 0; */
@@ -617,6 +624,43 @@ UA_ServerConfig_addSecurityPolicyAes128Sha256RsaOaep(UA_ServerConfig *config,
     return UA_STATUSCODE_GOOD;
 }
 
+#if defined(UA_ENABLE_ENCRYPTION_OPENSSL) || defined(UA_ENABLE_ENCRYPTION_LIBRESSL)
+UA_EXPORT UA_StatusCode
+UA_ServerConfig_addSecurityPolicyEccNistP256(UA_ServerConfig *config,
+                                             const UA_ByteString *certificate,
+                                             const UA_ByteString *privateKey) {
+    /* Allocate the SecurityPolicies */
+    UA_SecurityPolicy *tmp = (UA_SecurityPolicy *)
+        UA_realloc(config->securityPolicies,
+                   sizeof(UA_SecurityPolicy) * (1 + config->securityPoliciesSize));
+    if(!tmp)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    config->securityPolicies = tmp;
+
+    /* Populate the SecurityPolicies */
+    UA_ByteString localCertificate = UA_BYTESTRING_NULL;
+    UA_ByteString localPrivateKey  = UA_BYTESTRING_NULL;
+    if(certificate)
+        localCertificate = *certificate;
+    if(privateKey)
+       localPrivateKey = *privateKey;
+    UA_StatusCode retval =
+        UA_SecurityPolicy_EccNistP256(&config->securityPolicies[config->securityPoliciesSize],
+                                      UA_APPLICATIONTYPE_SERVER, localCertificate,
+                                      localPrivateKey, &config->logger);
+    if(retval != UA_STATUSCODE_GOOD) {
+        if(config->securityPoliciesSize == 0) {
+            UA_free(config->securityPolicies);
+            config->securityPolicies = NULL;
+        }
+        return retval;
+    }
+
+    config->securityPoliciesSize++;
+    return UA_STATUSCODE_GOOD;
+}
+#endif
+
 /* Always returns UA_STATUSCODE_GOOD. Logs a warning if policies could not be added. */
 UA_EXPORT UA_StatusCode
 UA_ServerConfig_addAllSecurityPolicies(UA_ServerConfig *config,
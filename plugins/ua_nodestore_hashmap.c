@@ -9,6 +9,8 @@
 #include <open62541/util.h>
 #include <open62541/plugin/nodestore_default.h>
 
+#include "open62541_queue.h"
+
 #ifndef container_of
 #define container_of(ptr, type, member) \
     (type *)((uintptr_t)ptr - offsetof(type,member))
@@ -21,13 +23,41 @@
  * - Matching NodeId: Return the entry
  * - NULL: Abort the search */
 
+/* Pointer swizzling (optional): References to local nodes are replaced by
+ * direct pointers to the target entry. The entries that are pointed to must
+ * remain at the same memory location. Hence a node replacement is "swapped" into
+ * the existing (stable) entry once no reader has a pointer to either version.
+ * Until then the replacement is pending and returned for new lookups.
+ *
+ * Removed nodes that are still the target of swizzled pointers are kept as a
+ * (node-)tombstone with only the NodeId remaining. Lookups via a swizzled
+ * pointer to a tombstone fall back to the NodeId. So a node that is re-added
+ * with the same NodeId is found. */
+
 typedef struct UA_NodeMapEntry {
-    struct UA_NodeMapEntry *orig; /* the version this is a copy from (or NULL) */
-    UA_UInt16 refCount; /* How many consumers have a reference to the node? */
+    struct UA_NodeMapEntry *orig; /* the version this is a copy from (or NULL).
+                                   * For a pending replacement: the stable entry
+                                   * it will be swapped into. */
+    struct UA_NodeMapEntry *pending; /* Newer version of the node, not yet
+                                      * swapped into the stable entry */
+    LIST_ENTRY(UA_NodeMapEntry) tombstones;
+    UA_UInt32 swizzleCount; /* Number of swizzled pointers to the entry */
+    UA_UInt32 swizzleTargets; /* Number of reference targets in the last
+                               * swizzling pass. Rerun if this changes. */
+    struct UA_NodeMapEntry **swizzled; /* Targets of the swizzled pointers in
+                                        * the node (one per pointer) */
+    UA_UInt32 swizzledSize;
+    UA_UInt32 version; /* Replacements of the stable entry. Copies store the
+                        * version they were made from. */
+    UA_UInt32 refCount; /* How many consumers have a reference to the node? */
     UA_Boolean deleted; /* Node was marked as deleted and can be deleted when refCount == 0 */
+    UA_Boolean tombstone; /* Deleted and only kept for the swizzled pointers */
     UA_Node node;
 } UA_NodeMapEntry;
 
+/* List of removed nodes kept as tombstones */
+LIST_HEAD(UA_NodeMapTombstones, UA_NodeMapEntry);
+
 #define UA_NODEMAP_MINSIZE 64
 #define UA_NODEMAP_TOMBSTONE ((UA_NodeMapEntry*)0x01)
 
@@ -45,6 +75,12 @@ typedef struct {
     /* Maps ReferenceTypeIndex to the NodeId of the ReferenceType */
     UA_NodeId referenceTypeIds[UA_REFERENCETYPESET_MAX];
     UA_Byte referenceTypeCounter;
+
+    /* Pointer swizzling */
+    UA_Boolean swizzle;
+    struct UA_NodeMapTombstones tombstones;
+
+    UA_Boolean compactAttributes;
 } UA_NodeMap;
 
 /*********************/
@@ -148,37 +184,36 @@ expand(UA_NodeMap *ns) {
     return UA_STATUSCODE_GOOD;
 }
 
-static UA_NodeMapEntry *
-createEntry(UA_NodeClass nodeClass) {
-    size_t size = sizeof(UA_NodeMapEntry) - sizeof(UA_Node);
+static size_t
+nodeSize(UA_NodeClass nodeClass) {
     switch(nodeClass) {
     case UA_NODECLASS_OBJECT:
-        size += sizeof(UA_ObjectNode);
-        break;
+        return sizeof(UA_ObjectNode);
     case UA_NODECLASS_VARIABLE:
-        size += sizeof(UA_VariableNode);
-        break;
+        return sizeof(UA_VariableNode);
     case UA_NODECLASS_METHOD:
-        size += sizeof(UA_MethodNode);
-        break;
+        return sizeof(UA_MethodNode);
     case UA_NODECLASS_OBJECTTYPE:
-        size += sizeof(UA_ObjectTypeNode);
-        break;
+        return sizeof(UA_ObjectTypeNode);
     case UA_NODECLASS_VARIABLETYPE:
-        size += sizeof(UA_VariableTypeNode);
-        break;
+        return sizeof(UA_VariableTypeNode);
     case UA_NODECLASS_REFERENCETYPE:
-        size += sizeof(UA_ReferenceTypeNode);
-        break;
+        return sizeof(UA_ReferenceTypeNode);
     case UA_NODECLASS_DATATYPE:
-        size += sizeof(UA_DataTypeNode);
-        break;
+        return sizeof(UA_DataTypeNode);
     case UA_NODECLASS_VIEW:
-        size += sizeof(UA_ViewNode);
-        break;
+        return sizeof(UA_ViewNode);
     default:
-        return NULL;
+        return 0;
     }
+}
+
+static UA_NodeMapEntry *
+createEntry(UA_NodeClass nodeClass) {
+    size_t size = nodeSize(nodeClass);
+    if(size == 0)
+        return NULL;
+    size += sizeof(UA_NodeMapEntry) - sizeof(UA_Node);
     UA_NodeMapEntry *entry = (UA_NodeMapEntry*)UA_calloc(1, size);
     if(!entry)
         return NULL;
@@ -189,22 +224,275 @@ createEntry(UA_NodeClass nodeClass) {
 static void
 deleteNodeMapEntry(UA_NodeMapEntry *entry) {
     UA_Node_clear(&entry->node);
+    UA_free(entry->swizzled);
     UA_free(entry);
 }
 
+static UA_NodeMapSlot *
+findOccupiedSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid);
+
+static void
+cleanupNodeMapEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry);
+
+/*********************/
+/* Pointer Swizzling */
+/*********************/
+
+/* Returns the current version of the node behind a stable entry */
+static UA_NodeMapEntry *
+currentEntry(UA_NodeMapEntry *entry) {
+    return (entry->pending) ? entry->pending : entry;
+}
+
+static size_t
+countTargets(const UA_NodeHead *head) {
+    size_t count = 0;
+    for(size_t i = 0; i < head->referencesSize; i++)
+        count += head->references[i].targetsSize;
+    return count;
+}
+
+static void
+freeTombstones(struct UA_NodeMapTombstones *list);
+
+/* Reduce the swizzleCount of a target. Tombstones without remaining pointers
+ * are moved to the unused list. */
+static void
+releaseSwizzleTarget(UA_NodeMapEntry *target, struct UA_NodeMapTombstones *unused) {
+    UA_assert(target->swizzleCount > 0);
+    target->swizzleCount--;
+    if(target->tombstone && target->swizzleCount == 0) {
+        LIST_REMOVE(target, tombstones);
+        LIST_INSERT_HEAD(unused, target, tombstones);
+    }
+}
+
+/* Swizzled pointers can be removed from the node in-situ, e.g. when the server
+ * deletes a reference. Release the targets that are no longer pointed to and
+ * shrink the list of swizzled targets to the remaining pointers. */
+static void
+releaseRemovedSwizzled(UA_NodeMapEntry *entry) {
+    UA_NodeHead *head = &entry->node.head;
+    UA_UInt32 remaining = 0;
+    for(size_t i = 0; i < head->referencesSize; i++) {
+        const UA_ReferenceTarget *t = NULL;
+        while((t = UA_NodeReferenceKind_iterate(&head->references[i], t))) {
+            if(UA_NodePointer_toNode(t->targetId))
+                remaining++;
+        }
+    }
+    if(remaining == entry->swizzledSize)
+        return;
+
+    /* Count the remaining pointers before the previous ones are released. So
+     * no tombstone that is still pointed to becomes unused. */
+    for(size_t i = 0; i < head->referencesSize; i++) {
+        const UA_ReferenceTarget *t = NULL;
+        while((t = UA_NodeReferenceKind_iterate(&head->references[i], t))) {
+            const UA_NodeHead *th = UA_NodePointer_toNode(t->targetId);
+            if(!th)
+                continue;
+            UA_NodeMapEntry *target = container_of(th, UA_NodeMapEntry, node.head);
+            target->swizzleCount++;
+        }
+    }
+
+    struct UA_NodeMapTombstones unused;
+    LIST_INIT(&unused);
+    for(size_t i = 0; i < entry->swizzledSize; i++)
+        releaseSwizzleTarget(entry->swizzled[i], &unused);
+    freeTombstones(&unused);
+
+    /* Store the remaining targets. The list only shrinks. */
+    entry->swizzledSize = 0;
+    if(remaining == 0) {
+        UA_free(entry->swizzled);
+        entry->swizzled = NULL;
+        return;
+    }
+    for(size_t i = 0; i < head->referencesSize; i++) {
+        const UA_ReferenceTarget *t = NULL;
+        while((t = UA_NodeReferenceKind_iterate(&head->references[i], t))) {
+            const UA_NodeHead *th = UA_NodePointer_toNode(t->targetId);
+            if(th)
+                entry->swizzled[entry->swizzledSize++] =
+                    container_of(th, UA_NodeMapEntry, node.head);
+        }
+    }
+}
+
+/* Append to the list of swizzled targets. The capacity is doubled when the
+ * size reaches a power of two. */
+static UA_Boolean
+addSwizzled(UA_NodeMapEntry *entry, UA_NodeMapEntry *target) {
+    UA_UInt32 size = entry->swizzledSize;
+    if(size == 0 || (size >= 4 && (size & (size - 1)) == 0)) {
+        UA_UInt32 capacity = (size == 0) ? 4 : size * 2;
+        UA_NodeMapEntry **list = (UA_NodeMapEntry**)
+            UA_realloc(entry->swizzled, capacity * sizeof(UA_NodeMapEntry*));
+        if(!list)
+            return false;
+        entry->swizzled = list;
+    }
+    entry->swizzled[entry->swizzledSize++] = target;
+    return true;
+}
+
+/* Replace the NodeId of local reference targets with a pointer to the (stable)
+ * entry of the target node. Only done when nobody holds a pointer to the node
+ * (refCount == 0). The NodeId that is removed from the reference can be still
+ * in use otherwise. */
+static void
+swizzleEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    UA_NodeHead *head = &entry->node.head;
+    UA_UInt32 targets = (UA_UInt32)countTargets(head);
+    if(targets == entry->swizzleTargets)
+        return; /* Nothing changed since the last pass */
+    entry->swizzleTargets = targets;
+    releaseRemovedSwizzled(entry);
+
+    for(size_t i = 0; i < head->referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &head->references[i];
+        const UA_ReferenceTarget *t = NULL;
+        while((t = UA_NodeReferenceKind_iterate(rk, t))) {
+            if(!UA_NodePointer_isLocal(t->targetId) ||
+               UA_NodePointer_toNode(t->targetId))
+                continue;
+            UA_NodeId id = UA_NodePointer_toNodeId(t->targetId);
+            UA_NodeMapSlot *slot = findOccupiedSlot(ns, &id);
+            if(!slot)
+                continue;
+            /* Out of memory. The remaining targets keep the NodeId. */
+            if(!addSwizzled(entry, slot->entry))
+                return;
+            /* The order of the tree elements is not changed. The targetId is
+             * compared via the NodeId of the target node. */
+            UA_NodePointer *tp = (UA_NodePointer*)(uintptr_t)&t->targetId;
+            UA_NodePointer_clear(tp);
+            *tp = UA_NodePointer_fromNode(&slot->entry->node.head);
+            slot->entry->swizzleCount++;
+        }
+    }
+}
+
+static void
+freeTombstones(struct UA_NodeMapTombstones *list) {
+    UA_NodeMapEntry *entry, *entry_tmp;
+    LIST_FOREACH_SAFE(entry, list, tombstones, entry_tmp) {
+        LIST_REMOVE(entry, tombstones);
+        UA_NodeId_clear(&entry->node.head.nodeId);
+        UA_free(entry);
+    }
+}
+
+/* Reduce the swizzleCount of the targets of swizzled pointers in the node.
+ * Tombstones without remaining pointers are moved to the unused list. They
+ * are freed by the caller once the node is no longer accessed. (The swizzled
+ * pointers still point to the tombstones.) */
+static void
+unswizzleEntry(UA_NodeMapEntry *entry, struct UA_NodeMapTombstones *unused) {
+    for(size_t i = 0; i < entry->swizzledSize; i++)
+        releaseSwizzleTarget(entry->swizzled[i], unused);
+    UA_free(entry->swizzled);
+    entry->swizzled = NULL;
+    entry->swizzledSize = 0;
+    entry->swizzleTargets = 0;
+}
+
+static void
+deleteSwizzledEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    struct UA_NodeMapTombstones unused;
+    LIST_INIT(&unused);
+    unswizzleEntry(entry, &unused);
+
+    if(entry->swizzleCount == 0) {
+        deleteNodeMapEntry(entry);
+    } else {
+        /* Keep the NodeId for the lookup via the swizzled pointers. Removing
+         * the references does not compare the (swizzled) targets. */
+        UA_NodeId id = entry->node.head.nodeId;
+        UA_NodeId_init(&entry->node.head.nodeId);
+        UA_Node_clear(&entry->node);
+        entry->node.head.nodeId = id;
+        entry->tombstone = true;
+        LIST_INSERT_HEAD(&ns->tombstones, entry, tombstones);
+    }
+
+    freeTombstones(&unused);
+}
+
+/* Move the pending replacement into the stable entry once nobody holds a
+ * pointer to either version. The NodeId of the stable entry is not replaced
+ * as it may be in use via the swizzled pointers. */
 static void
-cleanupNodeMapEntry(UA_NodeMapEntry *entry) {
+trySwapPending(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    UA_NodeMapEntry *pending = entry->pending;
+    if(!pending || entry->refCount > 0 || pending->refCount > 0)
+        return;
+
+    size_t size = nodeSize(entry->node.head.nodeClass);
+    UA_Node tmp;
+    memcpy(&tmp, &entry->node, size);
+    memcpy(&entry->node, &pending->node, size);
+    memcpy(&pending->node, &tmp, size);
+    UA_NodeId id = entry->node.head.nodeId;
+    entry->node.head.nodeId = pending->node.head.nodeId;
+    pending->node.head.nodeId = id;
+
+    /* The previous version is now in the pending entry. Together with the
+     * targets of its swizzled pointers. (The copy has no swizzled pointers.) */
+    UA_assert(pending->swizzledSize == 0);
+    pending->swizzled = entry->swizzled;
+    pending->swizzledSize = entry->swizzledSize;
+    entry->swizzled = NULL;
+    entry->swizzledSize = 0;
+    entry->swizzleTargets = 0;
+    entry->pending = NULL;
+    pending->orig = NULL;
+    deleteSwizzledEntry(ns, pending);
+
+    cleanupNodeMapEntry(ns, entry);
+}
+
+/* Adds the entry. Removes a previous version that no longer has users. */
+static void
+cleanupNodeMapEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
     if(entry->refCount > 0)
         return;
     if(entry->deleted) {
-        deleteNodeMapEntry(entry);
+        if(ns->swizzle)
+            deleteSwizzledEntry(ns, entry);
+        else
+            deleteNodeMapEntry(entry);
         return;
     }
+
+    if(ns->swizzle) {
+        if(entry->orig) {
+            /* Pending replacement of a stable entry */
+            trySwapPending(ns, entry->orig);
+            return;
+        }
+        if(entry->pending) {
+            trySwapPending(ns, entry);
+            return;
+        }
+    }
+
     for(size_t i = 0; i < entry->node.head.referencesSize; i++) {
         UA_NodeReferenceKind *rk = &entry->node.head.references[i];
-        if(rk->targetsSize > 16 && !rk->hasRefTree)
-            UA_NodeReferenceKind_switch(rk);
+        /* Add the hash index. The targets are moved but swizzled pointers
+         * remain valid. */
+        if(rk->targetsSize > 16 && !rk->hasRefTree && !rk->hasRefIndex)
+            UA_NodeReferenceKind_switchIndex(rk);
     }
+
+    /* Ignore errors. The node remains uncompacted. */
+    if(ns->compactAttributes)
+        UA_Node_compactAttributes(&entry->node);
+
+    if(ns->swizzle)
+        swizzleEntry(ns, entry);
 }
 
 static UA_NodeMapSlot *
@@ -259,8 +547,59 @@ UA_NodeMap_getNode(void *context, const UA_NodeId *nodeid) {
     UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
     if(!slot)
         return NULL;
-    ++slot->entry->refCount;
-    return &slot->entry->node;
+    UA_NodeMapEntry *entry = currentEntry(slot->entry);
+    ++entry->refCount;
+    return &entry->node;
+}
+
+/* The prefetch is done in two passes over a batch. First all NodeIds are
+ * hashed and the first candidate slot is prefetched. Then the entries of the
+ * (now cached) slots are prefetched. So the cache misses of the subsequent
+ * lookups overlap instead of stalling one after the other. */
+#define UA_NODEMAP_BATCHSIZE 32
+
+static void
+UA_NodeMap_prefetchNodes(void *context, size_t nodeIdsSize,
+                         const UA_NodeId **nodeIds) {
+    UA_NodeMap *ns = (UA_NodeMap*)context;
+    UA_UInt32 indices[UA_NODEMAP_BATCHSIZE];
+    for(size_t i = 0; i < nodeIdsSize; i += UA_NODEMAP_BATCHSIZE) {
+        size_t n = nodeIdsSize - i;
+        if(n > UA_NODEMAP_BATCHSIZE)
+            n = UA_NODEMAP_BATCHSIZE;
+
+        for(size_t j = 0; j < n; j++) {
+            indices[j] = mod(UA_NodeId_hash(nodeIds[i+j]), ns->size);
+            UA_PREFETCH(&ns->slots[indices[j]]);
+        }
+
+        for(size_t j = 0; j < n; j++) {
+            UA_NodeMapEntry *entry = ns->slots[indices[j]].entry;
+            if(entry > UA_NODEMAP_TOMBSTONE)
+                UA_PREFETCH(&entry->node.head.nodeId);
+        }
+    }
+}
+
+static const UA_Node *
+UA_NodeMap_getNodeFromPtr(void *context, UA_NodePointer ptr) {
+    if(!UA_NodePointer_isLocal(ptr))
+        return NULL;
+    const UA_NodeHead *head = UA_NodePointer_toNode(ptr);
+    if(!head) {
+        UA_NodeId id = UA_NodePointer_toNodeId(ptr);
+        return UA_NodeMap_getNode(context, &id);
+    }
+
+    /* The node was removed. Maybe another node with the same NodeId was added
+     * in the meantime. */
+    UA_NodeMapEntry *entry = container_of(head, UA_NodeMapEntry, node.head);
+    if(entry->deleted)
+        return UA_NodeMap_getNode(context, &head->nodeId);
+
+    entry = currentEntry(entry);
+    ++entry->refCount;
+    return &entry->node;
 }
 
 static void
@@ -271,7 +610,7 @@ UA_NodeMap_releaseNode(void *context, const UA_Node *node) {
     UA_assert(&entry->node == node);
     UA_assert(entry->refCount > 0);
     --entry->refCount;
-    cleanupNodeMapEntry(entry);
+    cleanupNodeMapEntry((UA_NodeMap*)context, entry);
 }
 
 static UA_StatusCode
@@ -281,13 +620,14 @@ UA_NodeMap_getNodeCopy(void *context, const UA_NodeId *nodeid,
     UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
     if(!slot)
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
-    UA_NodeMapEntry *entry = slot->entry;
+    UA_NodeMapEntry *entry = currentEntry(slot->entry);
     UA_NodeMapEntry *newItem = createEntry(entry->node.head.nodeClass);
     if(!newItem)
         return UA_STATUSCODE_BADOUTOFMEMORY;
     UA_StatusCode retval = UA_Node_copy(&entry->node, &newItem->node);
     if(retval == UA_STATUSCODE_GOOD) {
         newItem->orig = entry; /* Store the pointer to the original */
+        newItem->version = slot->entry->version;
         *outNode = &newItem->node;
     } else {
         deleteNodeMapEntry(newItem);
@@ -306,8 +646,13 @@ UA_NodeMap_removeNode(void *context, const UA_NodeId *nodeid) {
     slot->entry = UA_NODEMAP_TOMBSTONE;
     UA_atomic_sync(); /* Set the tombstone before cleaning up. E.g. if the
                        * nodestore is accessed from an interrupt. */
+    if(entry->pending) {
+        entry->pending->deleted = true;
+        cleanupNodeMapEntry(ns, entry->pending);
+        entry->pending = NULL;
+    }
     entry->deleted = true;
-    cleanupNodeMapEntry(entry);
+    cleanupNodeMapEntry(ns, entry);
     --ns->count;
     /* Downsize the hashmap if it is very empty */
     if(ns->count * 8 < ns->size && ns->size > UA_NODEMAP_MINSIZE)
@@ -403,12 +748,22 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
         ns->referenceTypeCounter++;
     }
 
+    /* Ignore errors. The node remains uncompacted. */
+    if(ns->compactAttributes)
+        UA_Node_compactAttributes(node);
+
     /* Insert the node */
     UA_NodeMapEntry *newEntry = container_of(node, UA_NodeMapEntry, node);
     slot->nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
     UA_atomic_sync(); /* Set the hash first */
     slot->entry = newEntry;
     ++ns->count;
+
+    /* Resolve the references to the already existing nodes */
+    if(ns->swizzle) {
+        newEntry->orig = NULL;
+        swizzleEntry(ns, newEntry);
+    }
     return retval;
 }
 
@@ -425,17 +780,44 @@ UA_NodeMap_replaceNode(void *context, UA_Node *node) {
     }
 
     /* The node was already updated since the copy was made? */
-    UA_NodeMapEntry *oldEntry = slot->entry;
+    UA_NodeMapEntry *oldEntry = currentEntry(slot->entry);
     if(oldEntry != newEntry->orig) {
         deleteNodeMapEntry(newEntry);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+    /* Ignore errors. The node remains uncompacted. */
+    if(ns->compactAttributes)
+        UA_Node_compactAttributes(node);
+
+    /* Keep the stable entry. The new version is pending until it can be
+     * swapped into the stable entry. */
+    if(ns->swizzle) {
+        UA_NodeMapEntry *stable = slot->entry;
+        if(newEntry->version != stable->version) {
+            deleteNodeMapEntry(newEntry);
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        if(stable->node.head.nodeClass != node->head.nodeClass) {
+            deleteNodeMapEntry(newEntry);
+            return UA_STATUSCODE_BADNODECLASSINVALID;
+        }
+        stable->version++;
+        newEntry->orig = stable;
+        stable->pending = newEntry;
+        if(oldEntry != stable) {
+            oldEntry->deleted = true;
+            cleanupNodeMapEntry(ns, oldEntry);
+        }
+        trySwapPending(ns, stable);
+        return UA_STATUSCODE_GOOD;
+    }
+
     /* Replace the entry */
     slot->entry = newEntry;
     UA_atomic_sync();
     oldEntry->deleted = true;
-    cleanupNodeMapEntry(oldEntry);
+    cleanupNodeMapEntry(ns, oldEntry);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -455,10 +837,11 @@ UA_NodeMap_iterate(void *context, UA_NodestoreVisitor visitor,
         UA_NodeMapSlot *slot = &ns->slots[i];
         if(slot->entry > UA_NODEMAP_TOMBSTONE) {
             /* The visitor can delete the node. So refcount here. */
-            slot->entry->refCount++;
-            visitor(visitorContext, &slot->entry->node);
-            slot->entry->refCount--;
-            cleanupNodeMapEntry(slot->entry);
+            UA_NodeMapEntry *entry = currentEntry(slot->entry);
+            entry->refCount++;
+            visitor(visitorContext, &entry->node);
+            entry->refCount--;
+            cleanupNodeMapEntry(ns, entry);
         }
     }
 }
@@ -472,16 +855,34 @@ UA_NodeMap_delete(void *context) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
     UA_UInt32 size = ns->size;
     UA_NodeMapSlot *slots = ns->slots;
+
+    /* Release the swizzled pointers before the target nodes are deleted */
+    struct UA_NodeMapTombstones unused;
+    LIST_INIT(&unused);
+    if(ns->swizzle) {
+        for(UA_UInt32 i = 0; i < size; ++i) {
+            if(slots[i].entry > UA_NODEMAP_TOMBSTONE)
+                unswizzleEntry(slots[i].entry, &unused);
+        }
+    }
+
     for(UA_UInt32 i = 0; i < size; ++i) {
         if(slots[i].entry > UA_NODEMAP_TOMBSTONE) {
             /* On debugging builds, check that all nodes were release */
             UA_assert(slots[i].entry->refCount == 0);
             /* Delete the node */
+            if(slots[i].entry->pending)
+                deleteNodeMapEntry(slots[i].entry->pending);
             deleteNodeMapEntry(slots[i].entry);
         }
     }
     UA_free(ns->slots);
 
+    /* All swizzled pointers were released above */
+    UA_assert(LIST_EMPTY(&ns->tombstones));
+    freeTombstones(&unused);
+    freeTombstones(&ns->tombstones);
+
     /* Clean up the ReferenceTypes index array */
     for(size_t i = 0; i < ns->referenceTypeCounter; i++)
         UA_NodeId_clear(&ns->referenceTypeIds[i]);
@@ -489,8 +890,8 @@ UA_NodeMap_delete(void *context) {
     UA_free(ns);
 }
 
-UA_StatusCode
-UA_Nodestore_HashMap(UA_Nodestore *ns) {
+static UA_StatusCode
+createNodeMap(UA_Nodestore *ns, const UA_NodestoreHashMapOptions *options) {
     /* Allocate and initialize the nodemap */
     UA_NodeMap *nodemap = (UA_NodeMap*)UA_malloc(sizeof(UA_NodeMap));
     if(!nodemap)
@@ -506,6 +907,9 @@ UA_Nodestore_HashMap(UA_Nodestore *ns) {
     }
 
     nodemap->referenceTypeCounter = 0;
+    nodemap->swizzle = options->swizzle;
+    nodemap->compactAttributes = options->compactAttributes;
+    LIST_INIT(&nodemap->tombstones);
 
     /* Populate the nodestore */
     ns->context = nodemap;
@@ -520,5 +924,28 @@ UA_Nodestore_HashMap(UA_Nodestore *ns) {
     ns->removeNode = UA_NodeMap_removeNode;
     ns->getReferenceTypeId = UA_NodeMap_getReferenceTypeId;
     ns->iterate = UA_NodeMap_iterate;
+    ns->getNodeFromPtr = (options->swizzle) ? UA_NodeMap_getNodeFromPtr : NULL;
+    ns->prefetchNodes = UA_NodeMap_prefetchNodes;
     return UA_STATUSCODE_GOOD;
 }
+
+UA_StatusCode
+UA_Nodestore_HashMap(UA_Nodestore *ns) {
+    UA_NodestoreHashMapOptions options;
+    memset(&options, 0, sizeof(UA_NodestoreHashMapOptions));
+    return createNodeMap(ns, &options);
+}
+
+UA_StatusCode
+UA_Nodestore_HashMapSwizzled(UA_Nodestore *ns) {
+    UA_NodestoreHashMapOptions options;
+    memset(&options, 0, sizeof(UA_NodestoreHashMapOptions));
+    options.swizzle = true;
+    return createNodeMap(ns, &options);
+}
+
+UA_StatusCode
+UA_Nodestore_HashMapWithOptions(UA_Nodestore *ns,
+                                const UA_NodestoreHashMapOptions *options) {
+    return createNodeMap(ns, options);
+}
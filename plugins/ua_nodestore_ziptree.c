@@ -21,7 +21,7 @@ typedef struct NodeEntry NodeEntry;
 struct NodeEntry {
     ZIP_ENTRY(NodeEntry) zipfields;
     UA_UInt32 nodeIdHash;
-    UA_UInt16 refCount; /* How many consumers have a reference to the node? */
+    UA_UInt32 refCount; /* How many consumers have a reference to the node? */
     UA_Boolean deleted; /* Node was marked as deleted and can be deleted when refCount == 0 */
     NodeEntry *orig;    /* If a copy is made to replace a node, track that we
                          * replace only the node from which the copy was made.
@@ -115,8 +115,8 @@ cleanupEntry(NodeEntry *entry) {
     UA_NodeHead *head = (UA_NodeHead*)&entry->nodeId;
     for(size_t i = 0; i < head->referencesSize; i++) {
         UA_NodeReferenceKind *rk = &head->references[i];
-        if(rk->targetsSize > 16 && !rk->hasRefTree)
-            UA_NodeReferenceKind_switch(rk);
+        if(rk->targetsSize > 16 && !rk->hasRefTree && !rk->hasRefIndex)
+            UA_NodeReferenceKind_switchIndex(rk);
     }
 }
 
@@ -380,6 +380,10 @@ UA_Nodestore_ZipTree(UA_Nodestore *ns) {
     ns->removeNode = zipNsRemoveNode;
     ns->getReferenceTypeId = zipNsGetReferenceTypeId;
     ns->iterate = zipNsIterate;
+
+    /* Reset the optional hooks of a previous nodestore in the same struct */
+    ns->getNodeFromPtr = NULL;
+    ns->prefetchNodes = NULL;
     
     return UA_STATUSCODE_GOOD;
 }
@@ -571,7 +571,10 @@ UA_PubSubChannelUDPMC_receive(UA_PubSubChannel *channel,
     timeoutValue.tv_sec  = (long int)(timeout / 1000000);
     timeoutValue.tv_usec = (long int)(timeout % 1000000);
     do {
-        if(timeout > 0) {
+        /* Without a timeout, only the messages that are already queued are
+         * received. The socket is blocking and recvfrom would wait for the
+         * next message. */
+        if(timeout > 0 || rcvCount > 0) {
             UA_fd_set(channel->sockfd, &fdset);
             /* Select API will return the remaining time in the struct
              * timeval */
@@ -619,6 +622,9 @@ UA_PubSubChannelUDPMC_receive(UA_PubSubChannel *channel,
         }
 
         rcvCount++;
+        if(timeout == 0)
+            continue;
+
         UA_DateTime endTime = UA_DateTime_nowMonotonic();
         UA_DateTime receiveDuration = endTime - beforeRecvTime;
 
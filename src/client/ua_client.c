@@ -101,6 +101,14 @@ UA_Client_clear(UA_Client *client) {
 
     /* Delete the timed work */
     UA_Timer_clear(&client->timer);
+
+    /* Delete the runtime-generated DataTypes */
+    while(client->dataTypes && client->dataTypes != client->dataTypesTail) {
+        UA_DataTypeArray *next = (UA_DataTypeArray*)(uintptr_t)client->dataTypes->next;
+        UA_DataTypeArray_delete(client->dataTypes);
+        client->dataTypes = next;
+    }
+    client->dataTypes = NULL;
 }
 
 void
@@ -277,7 +285,7 @@ processAsyncResponse(UA_Client *client, UA_UInt32 requestId, const UA_NodeId *re
 
     /* Decode the response */
     retval = UA_decodeBinaryInternal(responseMessage, offset, &response, responseType,
-                                     client->config.customDataTypes);
+                                     UA_Client_getCustomDataTypes(client));
 
  process:
     if(retval != UA_STATUSCODE_GOOD) {
@@ -354,7 +362,7 @@ processServiceResponse(void *application, UA_SecureChannel *channel,
             UA_init(rd->response, rd->responseType);
             retval = UA_decodeBinaryInternal(message, &offset, rd->response,
                                              &UA_TYPES[UA_TYPES_SERVICEFAULT],
-                                             rd->client->config.customDataTypes);
+                                             UA_Client_getCustomDataTypes(rd->client));
             if(retval != UA_STATUSCODE_GOOD)
                 ((UA_ResponseHeader*)rd->response)->serviceResult = retval;
             UA_LOG_INFO(&rd->client->config.logger, UA_LOGCATEGORY_CLIENT,
@@ -379,7 +387,7 @@ processServiceResponse(void *application, UA_SecureChannel *channel,
 
     /* Decode the response */
     retval = UA_decodeBinaryInternal(message, &offset, rd->response, rd->responseType,
-                                     rd->client->config.customDataTypes);
+                                     UA_Client_getCustomDataTypes(rd->client));
 
 finish:
     UA_NodeId_clear(&responseId);
@@ -734,7 +742,140 @@ UA_Client_run_iterate(UA_Client *client, UA_UInt32 timeout) {
     return client->connectStatus;
 }
 
+void
+UA_Client_relinkDataTypes(UA_Client *client) {
+    UA_DataTypeArray *last = client->dataTypes;
+    while(last->next != client->dataTypesTail)
+        last = (UA_DataTypeArray*)(uintptr_t)last->next;
+    last->next = client->config.customDataTypes;
+    client->dataTypesTail = client->config.customDataTypes;
+}
+
 const UA_DataType *
 UA_Client_findDataType(UA_Client *client, const UA_NodeId *typeId) {
-    return UA_findDataTypeWithCustom(typeId, client->config.customDataTypes);
+    return UA_findDataTypeWithCustom(typeId, UA_Client_getCustomDataTypes(client));
+}
+
+/* Add the type to the list if it is not known yet. Types from namespace zero
+ * are not loaded. They are either builtin or abstract. */
+static UA_StatusCode
+addUnknownType(UA_Client *client, UA_NodeId **ids, size_t *idsSize,
+               const UA_NodeId *typeId) {
+    if(typeId->namespaceIndex == 0 || UA_Client_findDataType(client, typeId))
+        return UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < *idsSize; i++) {
+        if(UA_NodeId_equal(&(*ids)[i], typeId))
+            return UA_STATUSCODE_GOOD;
+    }
+    return UA_Array_appendCopy((void**)ids, idsSize, typeId,
+                               &UA_TYPES[UA_TYPES_NODEID]);
+}
+
+/* Read the BrowseName and DataTypeDefinition of the types from position pos
+ * onwards. The (unknown) field types are appended to the ids. */
+static UA_StatusCode
+readDataTypeDefinitions(UA_Client *client, UA_NodeId **ids, size_t *idsSize,
+                        size_t pos, UA_QualifiedName **names, size_t *namesSize,
+                        UA_Variant **defs, size_t *defsSize) {
+    size_t batch = *idsSize - pos;
+    UA_ReadValueId *rvi = (UA_ReadValueId*)
+        UA_Array_new(batch * 2, &UA_TYPES[UA_TYPES_READVALUEID]);
+    if(!rvi)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    for(size_t i = 0; i < batch; i++) {
+        rvi[2*i].nodeId = (*ids)[pos + i]; /* Shallow copy */
+        rvi[2*i].attributeId = UA_ATTRIBUTEID_BROWSENAME;
+        rvi[2*i+1].nodeId = (*ids)[pos + i];
+        rvi[2*i+1].attributeId = UA_ATTRIBUTEID_DATATYPEDEFINITION;
+    }
+
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = rvi;
+    request.nodesToReadSize = batch * 2;
+    UA_ReadResponse response = UA_Client_Service_read(client, request);
+    UA_free(rvi); /* The NodeIds are shallow copies */
+
+    UA_StatusCode res = response.responseHeader.serviceResult;
+    if(res == UA_STATUSCODE_GOOD && response.resultsSize != batch * 2)
+        res = UA_STATUSCODE_BADUNEXPECTEDERROR;
+
+    for(size_t i = 0; i < batch && res == UA_STATUSCODE_GOOD; i++) {
+        UA_DataValue *name = &response.results[2*i];
+        UA_DataValue *def = &response.results[2*i+1];
+        res = def->hasStatus ? def->status : UA_STATUSCODE_GOOD;
+        if(res != UA_STATUSCODE_GOOD)
+            break;
+        if(!UA_Variant_hasScalarType(&def->value,
+                                     &UA_TYPES[UA_TYPES_STRUCTUREDEFINITION]) &&
+           !UA_Variant_hasScalarType(&def->value,
+                                     &UA_TYPES[UA_TYPES_ENUMDEFINITION])) {
+            res = UA_STATUSCODE_BADNOTSUPPORTED;
+            break;
+        }
+
+        /* Collect the field types */
+        if(def->value.type == &UA_TYPES[UA_TYPES_STRUCTUREDEFINITION]) {
+            const UA_StructureDefinition *sd =
+                (const UA_StructureDefinition*)def->value.data;
+            for(size_t j = 0; j < sd->fieldsSize && res == UA_STATUSCODE_GOOD; j++)
+                res = addUnknownType(client, ids, idsSize, &sd->fields[j].dataType);
+        }
+
+        /* Move the name and definition */
+        UA_QualifiedName qn;
+        UA_QualifiedName_init(&qn);
+        if(UA_Variant_hasScalarType(&name->value, &UA_TYPES[UA_TYPES_QUALIFIEDNAME])) {
+            qn = *(UA_QualifiedName*)name->value.data;
+            UA_QualifiedName_init((UA_QualifiedName*)name->value.data);
+        }
+        res |= UA_Array_append((void**)names, namesSize, &qn,
+                               &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+        res |= UA_Array_append((void**)defs, defsSize, &def->value,
+                               &UA_TYPES[UA_TYPES_VARIANT]);
+        UA_QualifiedName_clear(&qn);
+    }
+
+    UA_ReadResponse_clear(&response);
+    return res;
+}
+
+UA_StatusCode
+UA_Client_loadDataTypes(UA_Client *client, size_t typeIdsSize,
+                        const UA_NodeId *typeIds) {
+    UA_NodeId *ids = NULL;
+    size_t idsSize = 0;
+    UA_QualifiedName *names = NULL;
+    size_t namesSize = 0;
+    UA_Variant *defs = NULL;
+    size_t defsSize = 0;
+
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < typeIdsSize && res == UA_STATUSCODE_GOOD; i++)
+        res = addUnknownType(client, &ids, &idsSize, &typeIds[i]);
+
+    /* Read in rounds until all referenced types are known */
+    size_t pos = 0;
+    while(res == UA_STATUSCODE_GOOD && pos < idsSize) {
+        size_t end = idsSize;
+        res = readDataTypeDefinitions(client, &ids, &idsSize, pos,
+                                      &names, &namesSize, &defs, &defsSize);
+        pos = end;
+    }
+
+    /* Generate and prepend to the custom types */
+    if(res == UA_STATUSCODE_GOOD && idsSize > 0) {
+        UA_DataTypeArray *types = NULL;
+        const UA_DataTypeArray *custom = UA_Client_getCustomDataTypes(client);
+        res = UA_DataTypeArray_generate(idsSize, ids, names, defs, custom, &types);
+        if(res == UA_STATUSCODE_GOOD) {
+            client->dataTypes = types;
+            client->dataTypesTail = client->config.customDataTypes;
+        }
+    }
+
+    UA_Array_delete(ids, idsSize, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_Array_delete(names, namesSize, &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+    UA_Array_delete(defs, defsSize, &UA_TYPES[UA_TYPES_VARIANT]);
+    return res;
 }
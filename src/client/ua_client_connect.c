@@ -118,6 +118,14 @@ encryptUserIdentityToken(UA_Client *client, const UA_String *userTokenSecurityPo
         return UA_STATUSCODE_BADSECURITYPOLICYREJECTED;
     }
 
+    /* ECC policies exchange keys without asymmetric encryption. They cannot
+     * transport the legacy encrypted token secret. */
+    if(!sp->asymmetricModule.cryptoModule.encryptionAlgorithm.encrypt) {
+        UA_LOG_WARNING(&client->config.logger, UA_LOGCATEGORY_NETWORK,
+                       "The SecurityPolicy for the UserToken cannot encrypt");
+        return UA_STATUSCODE_BADSECURITYPOLICYREJECTED;
+    }
+
     /* Create a temp channel context */
 
     void *channelContext;
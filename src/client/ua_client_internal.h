@@ -152,8 +152,28 @@ struct UA_Client {
     UA_UInt32 monitoredItemHandles;
     UA_UInt16 currentlyOutStandingPublishRequests;
 #endif
+
+    /* DataTypes generated at runtime from the DataTypeDefinition attribute.
+     * The arrays are chained in front of the customDataTypes from the
+     * configuration (dataTypesTail). */
+    UA_DataTypeArray *dataTypes;
+    const UA_DataTypeArray *dataTypesTail;
 };
 
+/* Link the runtime-generated types to the current customDataTypes of the
+ * configuration. They can be replaced after types were generated. */
+void UA_Client_relinkDataTypes(UA_Client *client);
+
+/* The custom types used for decoding. Includes the runtime-generated types. */
+static UA_INLINE const UA_DataTypeArray *
+UA_Client_getCustomDataTypes(UA_Client *client) {
+    if(!client->dataTypes)
+        return client->config.customDataTypes;
+    if(client->dataTypesTail != client->config.customDataTypes)
+        UA_Client_relinkDataTypes(client);
+    return client->dataTypes;
+}
+
 void notifyClientState(UA_Client *client);
 void processERRResponse(UA_Client *client, const UA_ByteString *chunk);
 void processACKResponse(UA_Client *client, const UA_ByteString *chunk);
@@ -75,6 +75,10 @@ typedef struct UA_PubSubConnection {
     UA_UInt16 configurationFreezeCounter;
     UA_Boolean isRegistered; /* Subscriber requires connection channel regist */
     UA_Boolean configurationFrozen;
+    /* The channel socket is watched by the server network layer while there
+     * are event-driven ReaderGroups */
+    UA_ServerNetworkLayer *watchingLayer;
+    size_t eventDrivenReaderGroups;
 } UA_PubSubConnection;
 
 UA_StatusCode
@@ -231,6 +235,11 @@ typedef struct UA_DataSetReader {
     UA_ServerCallback msgRcvTimeoutTimerCallback;
     UA_UInt64 msgRcvTimeoutTimerId;
     UA_Boolean msgRcvTimeoutTimerRunning;
+    /* Set by the default monitoring. The running timer is not restarted for
+     * every message. When it expires, it is re-armed from the monotonic time
+     * of the last received message. */
+    UA_Boolean msgRcvTimeoutRearmLazy;
+    UA_DateTime lastMessageReceived;
 #endif
 } UA_DataSetReader;
 
@@ -301,6 +310,8 @@ struct UA_ReaderGroup {
     /* for simplified information access */
     UA_UInt32 readersCount;
     UA_UInt64 subscribeCallbackId;
+    UA_Boolean eventDriven; /* Receive when the socket is readable instead of
+                             * in the subscribe callback */
     UA_PubSubState state;
     UA_Boolean configurationFrozen;
 
@@ -350,6 +361,10 @@ UA_ReaderGroup_removeSubscribeCallback(UA_Server *server, UA_ReaderGroup *reader
 void
 UA_ReaderGroup_subscribeCallback(UA_Server *server, UA_ReaderGroup *readerGroup);
 
+/* Stop the event-driven reception on the connection socket */
+void
+UA_PubSubConnection_unwatchSocket(UA_PubSubConnection *connection);
+
 /*********************************************************/
 /*               Reading Message handling                */
 /*********************************************************/
@@ -373,9 +388,16 @@ UA_StatusCode
 decodeNetworkMessage(UA_Server *server, UA_ByteString *buffer, size_t *pos,
                      UA_NetworkMessage *nm, UA_PubSubConnection *connection);
 
+/* Waits up to timeout (in us) for messages. Without a timeout, only the
+ * messages that are already queued are received. */
 UA_StatusCode
 receiveBufferedNetworkMessage(UA_Server *server, UA_ReaderGroup *readerGroup,
-                              UA_PubSubConnection *connection);
+                              UA_PubSubConnection *connection, UA_UInt32 timeout);
+
+/* Receives the queued messages of the connection for all event-driven
+ * ReaderGroups */
+UA_StatusCode
+receiveEventDrivenNetworkMessages(UA_Server *server, UA_PubSubConnection *connection);
 
 #endif /* UA_ENABLE_PUBSUB */
 
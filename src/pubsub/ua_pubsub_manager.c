@@ -371,6 +371,37 @@ UA_PubSubManager_removeRepeatedPubSubCallback(UA_Server *server, UA_UInt64 callb
 
 #ifdef UA_ENABLE_PUBSUB_MONITORING
 
+static UA_StatusCode
+addMessageReceiveTimeoutTimer(UA_Server *server, UA_DataSetReader *reader,
+                              UA_DateTime deadline);
+
+/* Messages received while the timer is running only update the timestamp of
+ * the last message. When the timer expires, it is re-armed if a message was
+ * received within the MessageReceiveTimeout. So the timer is touched at most
+ * once per MessageReceiveTimeout instead of for every message. */
+static void
+handleMessageReceiveTimeoutTimer(UA_Server *server, void *data) {
+    UA_DataSetReader *reader = (UA_DataSetReader*)data;
+    UA_DateTime deadline = reader->lastMessageReceived + (UA_DateTime)
+        (reader->config.messageReceiveTimeout * UA_DATETIME_MSEC);
+    if(deadline > UA_DateTime_nowMonotonic() &&
+       addMessageReceiveTimeoutTimer(server, reader, deadline) == UA_STATUSCODE_GOOD)
+        return;
+
+    /* The next received message starts a new timer */
+    reader->msgRcvTimeoutTimerRunning = false;
+    reader->msgRcvTimeoutTimerCallback(server, reader);
+}
+
+static UA_StatusCode
+addMessageReceiveTimeoutTimer(UA_Server *server, UA_DataSetReader *reader,
+                              UA_DateTime deadline) {
+    return UA_Timer_addTimedCallback(&server->timer,
+                                     (UA_ApplicationCallback)handleMessageReceiveTimeoutTimer,
+                                     server, reader, deadline,
+                                     &reader->msgRcvTimeoutTimerId);
+}
+
 static UA_StatusCode
 UA_PubSubComponent_createMonitoring(UA_Server *server, UA_NodeId Id, UA_PubSubComponentEnumType eComponentType, 
                                     UA_PubSubMonitoringType eMonitoringType, void *data, UA_ServerCallback callback) {
@@ -389,6 +420,7 @@ UA_PubSubComponent_createMonitoring(UA_Server *server, UA_NodeId Id, UA_PubSubCo
                     UA_LOG_DEBUG(&server->config.logger, UA_LOGCATEGORY_SERVER, "UA_PubSubComponent_createMonitoring(): DataSetReader '%.*s' "
                         "- MessageReceiveTimeout", (UA_Int32) reader->config.name.length, reader->config.name.data);
                     reader->msgRcvTimeoutTimerCallback = callback;
+                    reader->msgRcvTimeoutRearmLazy = true;
                     break;
                 default:
                     UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_SERVER, "UA_PubSubComponent_createMonitoring(): DataSetReader '%.*s' "
@@ -427,8 +459,8 @@ UA_PubSubComponent_startMonitoring(UA_Server *server, UA_NodeId Id, UA_PubSubCom
                     /* use a timed callback, because one notification is enough, 
                     we assume that MessageReceiveTimeout configuration is in [ms], we do not handle or check fractions */
                     UA_UInt64 interval = (UA_UInt64)(reader->config.messageReceiveTimeout * UA_DATETIME_MSEC);
-                    ret = UA_Timer_addTimedCallback(&server->timer, (UA_ApplicationCallback) reader->msgRcvTimeoutTimerCallback, 
-                        server, reader, UA_DateTime_nowMonotonic() + (UA_DateTime) interval, &(reader->msgRcvTimeoutTimerId));
+                    ret = addMessageReceiveTimeoutTimer(server, reader,
+                                                        UA_DateTime_nowMonotonic() + (UA_DateTime) interval);
                     if (ret == UA_STATUSCODE_GOOD) {
                         UA_LOG_DEBUG(&server->config.logger, UA_LOGCATEGORY_SERVER,
                             "UA_PubSubComponent_startMonitoring(): DataSetReader '%.*s'- MessageReceiveTimeout: MessageReceiveTimeout = '%f' "
@@ -515,9 +547,14 @@ UA_PubSubComponent_updateMonitoringInterval(UA_Server *server, UA_NodeId Id, UA_
             UA_DataSetReader *reader = (UA_DataSetReader*) data;
             switch (eMonitoringType) {
                 case UA_PUBSUB_MONITORING_MESSAGE_RECEIVE_TIMEOUT: {
-                    ret = UA_Timer_changeRepeatedCallback(&server->timer, reader->msgRcvTimeoutTimerId,
-                                                          reader->config.messageReceiveTimeout, NULL,
-                                                          UA_TIMER_HANDLE_CYCLEMISS_WITH_CURRENTTIME);
+                    /* The expired timer is started again with the next message */
+                    if(!reader->msgRcvTimeoutTimerRunning)
+                        break;
+                    /* Re-arm the timer from the last received message */
+                    UA_Timer_removeCallback(&server->timer, reader->msgRcvTimeoutTimerId);
+                    UA_UInt64 interval = (UA_UInt64)(reader->config.messageReceiveTimeout * UA_DATETIME_MSEC);
+                    ret = addMessageReceiveTimeoutTimer(server, reader,
+                                                        reader->lastMessageReceived + (UA_DateTime) interval);
                     if (ret == UA_STATUSCODE_GOOD) {
                         UA_LOG_DEBUG(&server->config.logger, UA_LOGCATEGORY_SERVER,
                             "UA_PubSubComponent_updateMonitoringInterval(): DataSetReader '%.*s' - MessageReceiveTimeout: new MessageReceiveTimeout = '%f' "
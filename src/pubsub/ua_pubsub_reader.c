@@ -1041,6 +1041,8 @@ UA_DataSetReader_checkMessageReceiveTimeout(UA_Server *server,
     assert(server != 0);
     assert(dsr != 0);
 
+    dsr->lastMessageReceived = UA_DateTime_nowMonotonic();
+
     /* If previous reader state was error (because we haven't received messages
      * and ran into timeout) we should set the state back to operational */
     if(dsr->state == UA_PUBSUBSTATE_ERROR) {
@@ -1052,6 +1054,11 @@ UA_DataSetReader_checkMessageReceiveTimeout(UA_Server *server,
         }
     }
 
+    /* The running timer of the default monitoring picks up the timestamp of
+     * the last message when it expires */
+    if(dsr->msgRcvTimeoutRearmLazy && dsr->msgRcvTimeoutTimerRunning)
+        return;
+
     /* Stop message receive timeout timer */
     UA_StatusCode res;
     if(dsr->msgRcvTimeoutTimerRunning) {
@@ -1168,9 +1175,11 @@ processMessageWithReader(UA_Server *server, UA_ReaderGroup *readerGroup,
     }
 }
 
-UA_StatusCode
-UA_Server_processNetworkMessage(UA_Server *server, UA_PubSubConnection *connection,
-                                UA_NetworkMessage* msg) {
+/* Event-driven ReaderGroups with fixed offsets are skipped if skipEventDrivenRT
+ * is set. They decode the message on their own fast path. */
+static UA_StatusCode
+processNetworkMessage(UA_Server *server, UA_PubSubConnection *connection,
+                      UA_NetworkMessage* msg, UA_Boolean skipEventDrivenRT) {
     if(!msg || !connection)
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
@@ -1188,6 +1197,9 @@ UA_Server_processNetworkMessage(UA_Server *server, UA_PubSubConnection *connecti
     UA_ReaderGroup *readerGroup;
     UA_DataSetReader *reader;
     LIST_FOREACH(readerGroup, &connection->readerGroups, listEntry) {
+        if(skipEventDrivenRT && readerGroup->eventDriven &&
+           readerGroup->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE)
+            continue;
         LIST_FOREACH(reader, &readerGroup->readers, listEntry) {
             UA_StatusCode retval = checkReaderIdentifier(server, msg, reader);
             if(retval == UA_STATUSCODE_GOOD) {
@@ -1206,6 +1218,12 @@ UA_Server_processNetworkMessage(UA_Server *server, UA_PubSubConnection *connecti
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+UA_Server_processNetworkMessage(UA_Server *server, UA_PubSubConnection *connection,
+                                UA_NetworkMessage* msg) {
+    return processNetworkMessage(server, connection, msg, false);
+}
+
 /********************************************************************************
  * Functionality related to decoding, decrypting and processing network messages
  * as a subscriber
@@ -1303,7 +1321,7 @@ static
 UA_StatusCode
 decodeAndProcessNetworkMessage(UA_Server *server, UA_ReaderGroup *readerGroup,
                                UA_PubSubConnection *connection,
-                               UA_ByteString *buffer) {
+                               UA_ByteString *buffer, UA_Boolean skipEventDrivenRT) {
     UA_NetworkMessage nm;
     memset(&nm, 0, sizeof(UA_NetworkMessage));
     size_t currentPosition = 0;
@@ -1313,7 +1331,7 @@ decodeAndProcessNetworkMessage(UA_Server *server, UA_ReaderGroup *readerGroup,
     UA_CHECK_STATUS_WARN(rv, goto cleanup, &server->config.logger, UA_LOGCATEGORY_SERVER,
                          "Subscribe failed. verify, decrypt and decode network message failed.");
 
-    rv = UA_Server_processNetworkMessage(server, connection, &nm);
+    rv = processNetworkMessage(server, connection, &nm, skipEventDrivenRT);
     // TODO: check what action to perform on error (nothing?)
     UA_CHECK_STATUS_WARN(rv, (void)0, &server->config.logger, UA_LOGCATEGORY_SERVER,
                          "Subscribe failed. process network message failed.");
@@ -1382,7 +1400,7 @@ decodeAndProcessFun(UA_PubSubChannel *channel, void *cbContext,
     UA_ByteString mutableBuffer = {buffer->length, buffer->data};
     UA_RGContext *ctx = (UA_RGContext*) cbContext;
     return decodeAndProcessNetworkMessage(ctx->server, ctx->readerGroup,
-                                          ctx->connection, &mutableBuffer);
+                                          ctx->connection, &mutableBuffer, false);
 }
 
 static UA_StatusCode
@@ -1394,9 +1412,50 @@ decodeAndProcessFunRT(UA_PubSubChannel *channel, void *cbContext,
                                             ctx->connection, &mutableBuffer);
 }
 
+/* A message received from a watched socket is processed for every event-driven
+ * ReaderGroup of the connection. The event-driven ReaderGroups with fixed
+ * offsets decode the message on their fast path. The generic decoding is done
+ * once for all others and dispatches the message to the DataSetReaders of all
+ * remaining ReaderGroups of the connection. */
+static UA_StatusCode
+decodeAndDispatchFun(UA_PubSubChannel *channel, void *cbContext,
+                     const UA_ByteString *buffer) {
+    UA_ByteString mutableBuffer = {buffer->length, buffer->data};
+    UA_RGContext *ctx = (UA_RGContext*) cbContext;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_ReaderGroup *readerGroup;
+    LIST_FOREACH(readerGroup, &ctx->connection->readerGroups, listEntry) {
+        if(readerGroup->eventDriven &&
+           readerGroup->config.rtLevel != UA_PUBSUB_RT_FIXED_SIZE) {
+            res = decodeAndProcessNetworkMessage(ctx->server, NULL, ctx->connection,
+                                                 &mutableBuffer, true);
+            break;
+        }
+    }
+    LIST_FOREACH(readerGroup, &ctx->connection->readerGroups, listEntry) {
+        if(readerGroup->eventDriven &&
+           readerGroup->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE)
+            decodeAndProcessNetworkMessageRT(ctx->server, readerGroup,
+                                             ctx->connection, &mutableBuffer);
+    }
+    return res;
+}
+
+UA_StatusCode
+receiveEventDrivenNetworkMessages(UA_Server *server, UA_PubSubConnection *connection) {
+    UA_RGContext ctx = {server, connection, NULL};
+    UA_StatusCode rv =
+        connection->channel->receive(connection->channel, NULL,
+                                     decodeAndDispatchFun, &ctx, 0);
+    UA_CHECK_WARN(!UA_StatusCode_isBad(rv), return rv,
+                  &server->config.logger, UA_LOGCATEGORY_SERVER,
+                  "SubscribeCallback(): Connection receive failed!");
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 receiveBufferedNetworkMessage(UA_Server *server, UA_ReaderGroup *readerGroup,
-                              UA_PubSubConnection *connection) {
+                              UA_PubSubConnection *connection, UA_UInt32 timeout) {
     UA_RGContext ctx = {server, connection, readerGroup};
     UA_PubSubReceiveCallback receiveCB;
     if(readerGroup->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE)
@@ -1408,8 +1467,7 @@ receiveBufferedNetworkMessage(UA_Server *server, UA_ReaderGroup *readerGroup,
      * use it here instead of a NULL pointer. */
     UA_StatusCode rv =
         connection->channel->receive(connection->channel, NULL,
-                                     receiveCB, &ctx,
-                                     readerGroup->config.timeout);
+                                     receiveCB, &ctx, timeout);
 
     // TODO attention: here rv is ok if UA_STATUSCODE_GOOD != rv
     UA_CHECK_WARN(!UA_StatusCode_isBad(rv), return rv,
@@ -21,6 +21,9 @@
 #include "ua_pubsub_ns0.h"
 #endif
 
+#define UA_READERGROUP_DEFAULT_SUBSCRIBINGINTERVAL 5.0 /* ms */
+#define UA_READERGROUP_DEFAULT_TIMEOUT 1000 /* us */
+
 UA_ReaderGroup *
 UA_ReaderGroup_findRGbyId(UA_Server *server, UA_NodeId identifier) {
     UA_PubSubConnection *pubSubConnection;
@@ -137,15 +140,15 @@ UA_Server_addReaderGroup(UA_Server *server, UA_NodeId connectionIdentifier,
     retval |= UA_ReaderGroupConfig_copy(readerGroupConfig, &newGroup->config);
     /* Check user configured params and define it accordingly */
     if(newGroup->config.subscribingInterval <= 0.0)
-        newGroup->config.subscribingInterval = 5; // Set default to 5 ms
+        newGroup->config.subscribingInterval = UA_READERGROUP_DEFAULT_SUBSCRIBINGINTERVAL;
 
     if(newGroup->config.enableBlockingSocket)
         newGroup->config.timeout = 0; // Set timeout to 0 for blocking socket
 
     if((!newGroup->config.enableBlockingSocket) && (!newGroup->config.timeout))
-        newGroup->config.timeout = 1000; /* Set default to 1ms socket timeout
-                                            when non-blocking socket allows with
-                                            zero timeout */
+        newGroup->config.timeout = UA_READERGROUP_DEFAULT_TIMEOUT; /* Set default to 1ms
+                                            socket timeout when non-blocking
+                                            socket allows with zero timeout */
 
     LIST_INSERT_HEAD(&currentConnectionContext->readerGroups, newGroup, listEntry);
     currentConnectionContext->readerGroupsSize++;
@@ -638,9 +641,8 @@ UA_Server_unfreezeReaderGroupConfiguration(UA_Server *server,
 
 /* This triggers the collection and reception of NetworkMessages and the
  * contained DataSetMessages. */
-void
-UA_ReaderGroup_subscribeCallback(UA_Server *server,
-                                 UA_ReaderGroup *readerGroup) {
+static void
+subscribeReaderGroup(UA_Server *server, UA_ReaderGroup *readerGroup) {
     // TODO: feedback for debug-assert vs runtime-check
     UA_assert(server);
     UA_assert(readerGroup);
@@ -657,14 +659,111 @@ UA_ReaderGroup_subscribeCallback(UA_Server *server,
         return;
     }
 
-    receiveBufferedNetworkMessage(server, readerGroup, connection);
+    receiveBufferedNetworkMessage(server, readerGroup, connection,
+                                  readerGroup->config.timeout);
+}
+
+void
+UA_ReaderGroup_subscribeCallback(UA_Server *server,
+                                 UA_ReaderGroup *readerGroup) {
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_PUBSUB);
+    subscribeReaderGroup(server, readerGroup);
+    UA_MEMORYTAG_END();
+}
+
+/* Event-driven reception. The socket of the connection is watched by the
+ * server network layer. A message is received as soon as it arrives, without
+ * a polling timer and without a blocking select. */
+
+static void
+connectionSocketCallback(UA_Server *server, UA_SOCKET sockfd, void *context) {
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_PUBSUB);
+    receiveEventDrivenNetworkMessages(server, (UA_PubSubConnection*)context);
+    UA_MEMORYTAG_END();
+}
+
+static UA_ServerNetworkLayer *
+getWatchingNetworkLayer(UA_Server *server) {
+    for(size_t i = 0; i < server->config.networkLayersSize; i++) {
+        if(server->config.networkLayers[i].watchSocket)
+            return &server->config.networkLayers[i];
+    }
+    return NULL;
+}
+
+/* Returns UA_STATUSCODE_BADNOTSUPPORTED if the ReaderGroup has to poll */
+static UA_StatusCode
+addEventDrivenReception(UA_Server *server, UA_ReaderGroup *readerGroup) {
+    if(!readerGroup->config.enableEventDrivenReception)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    if(readerGroup->config.pubsubManagerCallback.addCustomCallback ||
+       readerGroup->config.enableBlockingSocket) {
+        UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                       "Event-driven reception is not possible with a custom "
+                       "callback or a blocking socket. The ReaderGroup polls.");
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+
+    UA_PubSubConnection *connection =
+        UA_PubSubConnection_findConnectionbyId(server, readerGroup->linkedConnection);
+    if(!connection || !connection->channel || !connection->channel->receive ||
+       connection->channel->sockfd == UA_INVALID_SOCKET)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+
+    if(!connection->watchingLayer) {
+        UA_ServerNetworkLayer *nl = getWatchingNetworkLayer(server);
+        if(!nl) {
+            UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                           "No server network layer can watch the socket of "
+                           "the connection. The ReaderGroup polls.");
+            return UA_STATUSCODE_BADNOTSUPPORTED;
+        }
+        UA_StatusCode res =
+            nl->watchSocket(nl, connection->channel->sockfd,
+                            connectionSocketCallback, connection);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        connection->watchingLayer = nl;
+    }
+
+    connection->eventDrivenReaderGroups++;
+    readerGroup->eventDriven = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_PubSubConnection_unwatchSocket(UA_PubSubConnection *connection) {
+    if(!connection->watchingLayer)
+        return;
+    connection->watchingLayer->unwatchSocket(connection->watchingLayer,
+                                             connection->channel->sockfd);
+    connection->watchingLayer = NULL;
+    connection->eventDrivenReaderGroups = 0;
+}
+
+static void
+removeEventDrivenReception(UA_Server *server, UA_ReaderGroup *readerGroup) {
+    readerGroup->eventDriven = false;
+    UA_PubSubConnection *connection =
+        UA_PubSubConnection_findConnectionbyId(server, readerGroup->linkedConnection);
+    if(!connection || connection->eventDrivenReaderGroups == 0)
+        return;
+    connection->eventDrivenReaderGroups--;
+    if(connection->eventDrivenReaderGroups == 0)
+        UA_PubSubConnection_unwatchSocket(connection);
 }
 
 /* Add new subscribeCallback. The first execution is triggered directly after
- * creation. */
+ * creation. ReaderGroups with enableEventDrivenReception receive event-driven
+ * if the channel has a socket and a network layer of the server can watch
+ * it. */
 UA_StatusCode
 UA_ReaderGroup_addSubscribeCallback(UA_Server *server, UA_ReaderGroup *readerGroup) {
-    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    UA_StatusCode retval = addEventDrivenReception(server, readerGroup);
+    if(retval == UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_GOOD;
+
+    retval = UA_STATUSCODE_GOOD;
     if(readerGroup->config.pubsubManagerCallback.addCustomCallback)
         retval = readerGroup->config.pubsubManagerCallback.
             addCustomCallback(server, readerGroup->identifier,
@@ -703,6 +802,10 @@ UA_ReaderGroup_addSubscribeCallback(UA_Server *server, UA_ReaderGroup *readerGro
 
 void
 UA_ReaderGroup_removeSubscribeCallback(UA_Server *server, UA_ReaderGroup *readerGroup) {
+    if(readerGroup->eventDriven) {
+        removeEventDrivenReception(server, readerGroup);
+        return;
+    }
     if(readerGroup->config.pubsubManagerCallback.removeCustomCallback)
         readerGroup->config.pubsubManagerCallback.
             removeCustomCallback(server, readerGroup->identifier,
@@ -22,10 +22,6 @@
 #include "ua_pubsub_ns0.h"
 #endif
 
-#ifdef UA_ENABLE_PUBSUB_DELTAFRAMES
-#include "ua_types_encoding_binary.h"
-#endif
-
 /* Forward declaration */
 static void
 UA_DataSetField_clear(UA_DataSetField *field);
@@ -111,6 +107,7 @@ UA_PubSubConnection_clear(UA_Server *server, UA_PubSubConnection *connection) {
         UA_Server_removeReaderGroup(server, readerGroups->identifier);
 
     UA_NodeId_clear(&connection->identifier);
+    UA_PubSubConnection_unwatchSocket(connection);
     if(connection->channel)
         connection->channel->close(connection->channel);
 
@@ -912,58 +909,34 @@ UA_DataSetFieldConfig_clear(UA_DataSetFieldConfig *dataSetFieldConfig) {
 /*               PublishValues handling                  */
 /*********************************************************/
 
-/* Compare two variants. Internally used for value change detection. */
 #ifdef UA_ENABLE_PUBSUB_DELTAFRAMES
-static UA_Boolean
-valueChangedVariant(UA_Variant *oldValue, UA_Variant *newValue) {
-    if(!oldValue || !newValue)
-        return false;
-
-    size_t oldValueEncodingSize = UA_calcSizeBinary(oldValue, &UA_TYPES[UA_TYPES_VARIANT]);
-    size_t newValueEncodingSize = UA_calcSizeBinary(newValue, &UA_TYPES[UA_TYPES_VARIANT]);
-    if(oldValueEncodingSize == 0 || newValueEncodingSize == 0)
-        return false;
-
-    if(oldValueEncodingSize != newValueEncodingSize)
-        return true;
-
-    UA_ByteString oldValueEncoding = {0};
-    UA_StatusCode res = UA_ByteString_allocBuffer(&oldValueEncoding, oldValueEncodingSize);
-    if(res != UA_STATUSCODE_GOOD)
-        return false;
-
-    UA_ByteString newValueEncoding = {0};
-    res = UA_ByteString_allocBuffer(&newValueEncoding, newValueEncodingSize);
-    if(res != UA_STATUSCODE_GOOD) {
-        UA_ByteString_clear(&oldValueEncoding);
-        return false;
+/* Store a sampled value in the snapshot of the last published values. The
+ * memory of pointer-free values with the same type and length is reused, so
+ * that numeric fields are updated without allocating. If the copy fails, the
+ * previous sample is kept. */
+static UA_StatusCode
+storeLastSample(UA_DataSetWriterSample *ls, const UA_DataValue *value) {
+    UA_Variant *lv = &ls->value.value;
+    const UA_Variant *v = &value->value;
+    if(lv->type && lv->type == v->type && lv->type->pointerFree &&
+       lv->storageType == UA_VARIANT_DATA &&
+       lv->arrayLength == v->arrayLength &&
+       lv->arrayDimensionsSize == 0 && v->arrayDimensionsSize == 0 &&
+       lv->data > UA_EMPTY_ARRAY_SENTINEL && v->data > UA_EMPTY_ARRAY_SENTINEL) {
+        size_t length = (v->arrayLength > 0) ? v->arrayLength : 1;
+        memcpy(lv->data, v->data, v->type->memSize * length);
+        UA_Variant storage = *lv;
+        ls->value = *value;
+        ls->value.value = storage;
+        return UA_STATUSCODE_GOOD;
     }
-
-    UA_Byte *bufPosOldValue = oldValueEncoding.data;
-    const UA_Byte *bufEndOldValue = &oldValueEncoding.data[oldValueEncoding.length];
-    UA_Byte *bufPosNewValue = newValueEncoding.data;
-    const UA_Byte *bufEndNewValue = &newValueEncoding.data[newValueEncoding.length];
-
-    UA_Boolean compareResult = false; /* default */
-
-    res = UA_encodeBinaryInternal(oldValue, &UA_TYPES[UA_TYPES_VARIANT],
-                                  &bufPosOldValue, &bufEndOldValue, NULL, NULL);
-    if(res != UA_STATUSCODE_GOOD)
-        goto cleanup;
-
-    res = UA_encodeBinaryInternal(newValue, &UA_TYPES[UA_TYPES_VARIANT],
-                                  &bufPosNewValue, &bufEndNewValue, NULL, NULL);
+    UA_DataValue copy;
+    UA_StatusCode res = UA_DataValue_copy(value, &copy);
     if(res != UA_STATUSCODE_GOOD)
-        goto cleanup;
-
-    oldValueEncoding.length = (uintptr_t)bufPosOldValue - (uintptr_t)oldValueEncoding.data;
-    newValueEncoding.length = (uintptr_t)bufPosNewValue - (uintptr_t)newValueEncoding.data;
-    compareResult = !UA_ByteString_equal(&oldValueEncoding, &newValueEncoding);
-
- cleanup:
-    UA_ByteString_clear(&oldValueEncoding);
-    UA_ByteString_clear(&newValueEncoding);
-    return compareResult;
+        return res;
+    UA_DataValue_clear(&ls->value);
+    ls->value = copy;
+    return UA_STATUSCODE_GOOD;
 }
 #endif
 
@@ -1056,8 +1029,11 @@ UA_PubSubDataSetWriter_generateKeyFrameMessage(UA_Server *server,
 
 #ifdef UA_ENABLE_PUBSUB_DELTAFRAMES
         /* Update lastValue store */
-        UA_DataValue_clear(&dataSetWriter->lastSamples[counter].value);
-        UA_DataValue_copy(dfv, &dataSetWriter->lastSamples[counter].value);
+        UA_StatusCode res = storeLastSample(&dataSetWriter->lastSamples[counter], dfv);
+        if(res != UA_STATUSCODE_GOOD)
+            UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                           "PubSub Publish: Storing the last sample failed with %s",
+                           UA_StatusCode_name(res));
 #endif
 
         counter++;
@@ -1090,20 +1066,20 @@ UA_PubSubDataSetWriter_generateDeltaFrameMessage(UA_Server *server,
         UA_DataValue_init(&value);
         UA_PubSubDataSetField_sampleValue(server, dsf, &value);
 
-        /* Check if the value has changed */
+        /* Check if the value has changed. The typed comparison does not
+         * allocate. */
         UA_DataSetWriterSample *ls = &dataSetWriter->lastSamples[counter];
-        if(valueChangedVariant(&ls->value.value, &value.value)) {
-            /* increase fieldCount for current delta message */
-            dataSetMessage->data.deltaFrameData.fieldCount++;
-            ls->valueChanged = true;
-
-            /* Update last stored sample */
-            UA_DataValue_clear(&ls->value);
-            ls->value = value;
-        } else {
-            UA_DataValue_clear(&value);
-            ls->valueChanged = false;
+        ls->valueChanged = false;
+        if(!UA_equal(&ls->value.value, &value.value, &UA_TYPES[UA_TYPES_VARIANT])) {
+            /* Update last stored sample. If that fails, the field is sent
+             * with the next delta frame. */
+            if(storeLastSample(ls, &value) == UA_STATUSCODE_GOOD) {
+                /* increase fieldCount for current delta message */
+                dataSetMessage->data.deltaFrameData.fieldCount++;
+                ls->valueChanged = true;
+            }
         }
+        UA_DataValue_clear(&value);
 
         counter++;
     }
@@ -1296,9 +1272,12 @@ UA_DataSetWriter_generateDataSetMessage(UA_Server *server,
      * are currently used. */
     if(dsm) {
 #ifdef UA_ENABLE_PUBSUB_DELTAFRAMES
-        /* Check if the PublishedDataSet version has changed -> if yes flush the
-         * lastValue store and send a KeyFrame */
-    if(dataSetWriter->connectedDataSetVersion.majorVersion !=
+        /* Check if the PublishedDataSet version or the number of fields has
+         * changed -> if yes flush the lastValue store and send a KeyFrame. The
+         * version is derived from the current time and can be unchanged if
+         * fields are added right after the DataSetWriter. */
+    if(dataSetWriter->lastSamplesCount != currentDataSet->fieldSize ||
+       dataSetWriter->connectedDataSetVersion.majorVersion !=
        currentDataSet->dataSetMetaData.configurationVersion.majorVersion ||
        dataSetWriter->connectedDataSetVersion.minorVersion !=
        currentDataSet->dataSetMetaData.configurationVersion.minorVersion) {
@@ -958,8 +958,8 @@ sendBufferedNetworkMessage(UA_Server *server, UA_PubSubConnection *connection,
 
 /* This callback triggers the collection and publish of NetworkMessages and the
  * contained DataSetMessages. */
-void
-UA_WriterGroup_publishCallback(UA_Server *server, UA_WriterGroup *writerGroup) {
+static void
+publishWriterGroup(UA_Server *server, UA_WriterGroup *writerGroup) {
     UA_LOG_DEBUG(&server->config.logger, UA_LOGCATEGORY_SERVER, "Publish Callback");
 
     // TODO: review if its okay to force correct value from caller side instead
@@ -1130,6 +1130,13 @@ UA_WriterGroup_publishCallback(UA_Server *server, UA_WriterGroup *writerGroup) {
         UA_DataSetMessage_clear(&dsmStore[i]);
 }
 
+void
+UA_WriterGroup_publishCallback(UA_Server *server, UA_WriterGroup *writerGroup) {
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_PUBSUB);
+    publishWriterGroup(server, writerGroup);
+    UA_MEMORYTAG_END();
+}
+
 /* Add new publishCallback. The first execution is triggered directly after
  * creation. */
 UA_StatusCode
@@ -126,8 +126,13 @@ destroyMulticastDiscoveryServer(UA_DiscoveryManager *dm) {
 
 void
 UA_DiscoveryManager_init(UA_DiscoveryManager *dm, UA_Server *server) {
-    LIST_INIT(&dm->registeredServers);
+    TAILQ_INIT(&dm->registeredServers);
     dm->registeredServersSize = 0;
+    memset(dm->registeredServersHash, 0,
+           sizeof(registeredServer_list_entry*) * REGISTERED_SERVER_HASH_SIZE);
+#ifdef UA_ENABLE_DISCOVERY_SEMAPHORE
+    LIST_INIT(&dm->semaphoreServers);
+#endif
     LIST_INIT(&dm->periodicServerRegisterCallbacks);
     dm->registerServerCallback = NULL;
     dm->registerServerCallbackData = NULL;
@@ -155,8 +160,8 @@ UA_DiscoveryManager_init(UA_DiscoveryManager *dm, UA_Server *server) {
 void
 UA_DiscoveryManager_clear(UA_DiscoveryManager *dm, UA_Server *server) {
     registeredServer_list_entry *rs, *rs_tmp;
-    LIST_FOREACH_SAFE(rs, &dm->registeredServers, pointers, rs_tmp) {
-        LIST_REMOVE(rs, pointers);
+    TAILQ_FOREACH_SAFE(rs, &dm->registeredServers, pointers, rs_tmp) {
+        TAILQ_REMOVE(&dm->registeredServers, rs, pointers);
         UA_RegisteredServer_clear(&rs->registeredServer);
         UA_free(rs);
     }
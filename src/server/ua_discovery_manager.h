@@ -22,12 +22,24 @@ _UA_BEGIN_DECLS
 
 #ifdef UA_ENABLE_DISCOVERY
 
+/* The registered servers are kept in a list sorted by lastSeen (the oldest
+ * registration first) and in a hash map by serverUri. With a uniform timeout,
+ * the expired registrations are always at the front of the list. */
+#define REGISTERED_SERVER_HASH_SIZE 1000
+
 typedef struct registeredServer_list_entry {
-    LIST_ENTRY(registeredServer_list_entry) pointers;
+    TAILQ_ENTRY(registeredServer_list_entry) pointers;
+    struct registeredServer_list_entry *hashNext; /* Next in the hash bucket */
+#ifdef UA_ENABLE_DISCOVERY_SEMAPHORE
+    /* Only linked if the semaphoreFilePath is set */
+    LIST_ENTRY(registeredServer_list_entry) semaphorePointers;
+#endif
     UA_RegisteredServer registeredServer;
     UA_DateTime lastSeen;
 } registeredServer_list_entry;
 
+TAILQ_HEAD(registeredServer_list, registeredServer_list_entry);
+
 struct PeriodicServerRegisterCallback {
     UA_UInt64 id;
     UA_Double this_interval;
@@ -75,8 +87,12 @@ typedef struct serverOnNetwork_hash_entry {
 
 typedef struct {
     LIST_HEAD(, periodicServerRegisterCallback_entry) periodicServerRegisterCallbacks;
-    LIST_HEAD(, registeredServer_list_entry) registeredServers;
+    struct registeredServer_list registeredServers;
     size_t registeredServersSize;
+    registeredServer_list_entry *registeredServersHash[REGISTERED_SERVER_HASH_SIZE];
+#ifdef UA_ENABLE_DISCOVERY_SEMAPHORE
+    LIST_HEAD(, registeredServer_list_entry) semaphoreServers;
+#endif
     UA_Server_registerServerCallback registerServerCallback;
     void* registerServerCallbackData;
 
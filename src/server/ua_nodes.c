@@ -50,7 +50,13 @@ UA_NodePointer_copy(UA_NodePointer in, UA_NodePointer *out) {
     in.immediate &= ~(uintptr_t)UA_NODEPOINTER_MASK;
     switch(tag) {
     case UA_NODEPOINTER_TAG_NODE:
-        in.id = &in.node->nodeId;
+        /* Direct node pointers are not copied. Use the NodeId instead. */
+        in = UA_NodePointer_fromNodeId(&in.node->nodeId);
+        if((in.immediate & UA_NODEPOINTER_MASK) == UA_NODEPOINTER_TAG_IMMEDIATE) {
+            *out = in;
+            break;
+        }
+        in.immediate &= ~(uintptr_t)UA_NODEPOINTER_MASK;
         goto nodeid; /* fallthrough */
     case UA_NODEPOINTER_TAG_NODEID:
     nodeid:
@@ -101,12 +107,12 @@ UA_NodePointer_order(UA_NodePointer p1, UA_NodePointer p2) {
     /* Extract the tag and resolve pointers to nodes */
     UA_Byte tag1 = p1.immediate & UA_NODEPOINTER_MASK;
     if(tag1 == UA_NODEPOINTER_TAG_NODE) {
-        p1 = UA_NodePointer_fromNodeId(&p1.node->nodeId);
+        p1 = UA_NodePointer_fromNodeId(&UA_NodePointer_toNode(p1)->nodeId);
         tag1 = p1.immediate & UA_NODEPOINTER_MASK;
     }
     UA_Byte tag2 = p2.immediate & UA_NODEPOINTER_MASK;
     if(tag2 == UA_NODEPOINTER_TAG_NODE) {
-        p2 = UA_NodePointer_fromNodeId(&p2.node->nodeId);
+        p2 = UA_NodePointer_fromNodeId(&UA_NodePointer_toNode(p2)->nodeId);
         tag2 = p2.immediate & UA_NODEPOINTER_MASK;
     }
 
@@ -114,10 +120,13 @@ UA_NodePointer_order(UA_NodePointer p1, UA_NodePointer p2) {
     if(tag1 != tag2)
         return (tag1 > tag2) ? UA_ORDER_MORE : UA_ORDER_LESS;
 
-    /* Immediate */
-    if(UA_LIKELY(tag1 == UA_NODEPOINTER_TAG_IMMEDIATE))
+    /* Immediate (can be equal after resolving a node pointer) */
+    if(UA_LIKELY(tag1 == UA_NODEPOINTER_TAG_IMMEDIATE)) {
+        if(p1.immediate == p2.immediate)
+            return UA_ORDER_EQ;
         return (p1.immediate > p2.immediate) ?
             UA_ORDER_MORE : UA_ORDER_LESS;
+    }
 
     /* Compare from pointers */
     p1.immediate &= ~(uintptr_t)UA_NODEPOINTER_MASK;
@@ -200,7 +209,7 @@ UA_NodePointer_toExpandedNodeId(UA_NodePointer np) {
     /* Resolve node pointer to get the NodeId */
     UA_Byte tag = np.immediate & UA_NODEPOINTER_MASK;
     if(tag == UA_NODEPOINTER_TAG_NODE) {
-        np = UA_NodePointer_fromNodeId(&np.node->nodeId);
+        np = UA_NodePointer_fromNodeId(&UA_NodePointer_toNode(np)->nodeId);
         tag = np.immediate & UA_NODEPOINTER_MASK;
     }
 
@@ -217,6 +226,22 @@ UA_NodePointer_toExpandedNodeId(UA_NodePointer np) {
     return en;
 }
 
+UA_NodePointer
+UA_NodePointer_fromNode(const UA_NodeHead *node) {
+    UA_NodePointer np;
+    np.node = node;
+    np.immediate |= UA_NODEPOINTER_TAG_NODE;
+    return np;
+}
+
+const UA_NodeHead *
+UA_NodePointer_toNode(UA_NodePointer np) {
+    if((np.immediate & UA_NODEPOINTER_MASK) != UA_NODEPOINTER_TAG_NODE)
+        return NULL;
+    np.immediate &= ~(uintptr_t)UA_NODEPOINTER_MASK;
+    return np.node;
+}
+
 /**************/
 /* References */
 /**************/
@@ -255,6 +280,402 @@ const struct aa_head refNameTree =
     { NULL, cmpRefTargetName, offsetof(UA_ReferenceTargetTreeElem, nameTreeEntry),
       offsetof(UA_ReferenceTarget, targetNameHash) };
 
+/* The arrays of ReferenceKinds and ReferenceTargets grow geometrically. The
+ * capacity is not stored. It is implied by the size as the next power of two.
+ * So adding n references one-by-one reallocs only log(n) times. */
+static size_t
+refsCapacity(size_t size) {
+    if(size == 0)
+        return 0;
+    size_t capacity = 1;
+    while(capacity < size)
+        capacity <<= 1;
+    return capacity;
+}
+
+/* Tree elements that are created together (bulk insert, switch from the array
+ * representation, node copy) are allocated in a single slab. Every element
+ * knows its position in the slab. The slab is freed with the last element. */
+typedef struct {
+    size_t live; /* Number of elements not yet freed */
+} UA_RefTreeSlab;
+
+static UA_ReferenceTargetTreeElem *
+allocTreeElems(size_t count) {
+    if(count == 1) {
+        UA_ReferenceTargetTreeElem *elem = (UA_ReferenceTargetTreeElem*)
+            UA_malloc(sizeof(UA_ReferenceTargetTreeElem));
+        if(elem)
+            elem->slabIndex = 0;
+        return elem;
+    }
+    if(count == 0 || count > UA_UINT32_MAX)
+        return NULL;
+    UA_RefTreeSlab *slab = (UA_RefTreeSlab*)
+        UA_malloc(sizeof(UA_RefTreeSlab) +
+                  (sizeof(UA_ReferenceTargetTreeElem) * count));
+    if(!slab)
+        return NULL;
+    slab->live = count;
+    UA_ReferenceTargetTreeElem *elems = (UA_ReferenceTargetTreeElem*)&slab[1];
+    for(size_t i = 0; i < count; i++)
+        elems[i].slabIndex = (UA_UInt32)i + 1;
+    return elems;
+}
+
+static void
+freeTreeElem(UA_ReferenceTargetTreeElem *elem) {
+    if(elem->slabIndex == 0) {
+        UA_free(elem);
+        return;
+    }
+    UA_ReferenceTargetTreeElem *elems = elem - (elem->slabIndex - 1);
+    UA_RefTreeSlab *slab = &((UA_RefTreeSlab*)(uintptr_t)elems)[-1];
+    slab->live--;
+    if(slab->live == 0)
+        UA_free(slab);
+}
+
+/* Takes ownership of the targetId (no copy). Cannot fail. */
+static void
+insertTreeElem(UA_NodeReferenceKind *rk, UA_ReferenceTargetTreeElem *entry,
+               UA_NodePointer targetId, UA_UInt32 targetNameHash) {
+    entry->target.targetId = targetId;
+    entry->target.targetNameHash = targetNameHash;
+    UA_ExpandedNodeId en = UA_NodePointer_toExpandedNodeId(targetId);
+    entry->targetIdHash = UA_ExpandedNodeId_hash(&en);
+
+    /* Insert to the id lookup binary search tree. Only the root is kept in refs
+     * to save space. */
+    struct aa_head _refIdTree = refIdTree;
+    _refIdTree.root = rk->targets.tree.idTreeRoot;
+    aa_insert(&_refIdTree, entry);
+    rk->targets.tree.idTreeRoot = _refIdTree.root;
+
+    /* Insert to the name lookup binary search tree */
+    struct aa_head _refNameTree = refNameTree;
+    _refNameTree.root = rk->targets.tree.nameTreeRoot;
+    aa_insert(&_refNameTree, entry);
+    rk->targets.tree.nameTreeRoot = _refNameTree.root;
+
+    rk->targetsSize++;
+}
+
+/* The hash index is allocated in front of the targets array. The slots of the
+ * open-addressing hash-map (linear probing) point into the array. The name
+ * index is a list of the array positions sorted by the BrowseName hash. It is
+ * rebuilt lazily for the next lookup by name after a modification. */
+typedef struct {
+    UA_UInt32 hash; /* Hash of the targetId */
+    UA_UInt32 pos;  /* Position in the targets array + 1. Zero if empty. */
+} UA_RefIndexSlot;
+
+typedef struct {
+    UA_UInt32 nameHash;
+    UA_UInt32 pos;
+} UA_RefIndexName;
+
+typedef struct {
+    UA_RefIndexSlot *slots;
+    size_t slotsSize; /* Power of two, at least twice the array capacity */
+    UA_RefIndexName *names;
+    size_t namesSize; /* Zero if the name index needs to be rebuilt */
+} UA_RefIndex;
+
+static UA_RefIndex *
+refIndex(const UA_NodeReferenceKind *rk) {
+    UA_assert(rk->hasRefIndex);
+    return &((UA_RefIndex*)(uintptr_t)rk->targets.array)[-1];
+}
+
+static UA_UInt32
+targetHash(UA_NodePointer targetId) {
+    UA_ExpandedNodeId en = UA_NodePointer_toExpandedNodeId(targetId);
+    return UA_ExpandedNodeId_hash(&en);
+}
+
+static void
+indexInsertSlot(UA_RefIndexSlot *slots, size_t slotsSize,
+                UA_UInt32 hash, UA_UInt32 pos) {
+    size_t mask = slotsSize - 1;
+    size_t i = hash & mask;
+    while(slots[i].pos != 0)
+        i = (i + 1) & mask;
+    slots[i].hash = hash;
+    slots[i].pos = pos + 1;
+}
+
+/* Returns the slot that points to the array position */
+static UA_RefIndexSlot *
+indexFindSlot(UA_RefIndex *ri, UA_UInt32 hash, size_t pos) {
+    size_t mask = ri->slotsSize - 1;
+    size_t i = hash & mask;
+    while(ri->slots[i].pos != 0) {
+        if(ri->slots[i].pos == pos + 1)
+            return &ri->slots[i];
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+/* Remove the slot without leaving a tombstone. Move later entries of the
+ * probing sequence into the gap. */
+static void
+indexRemoveSlot(UA_RefIndex *ri, UA_RefIndexSlot *slot) {
+    size_t mask = ri->slotsSize - 1;
+    size_t i = (size_t)(slot - ri->slots);
+    size_t j = i;
+    while(true) {
+        j = (j + 1) & mask;
+        if(ri->slots[j].pos == 0)
+            break;
+        size_t k = ri->slots[j].hash & mask; /* Home position */
+        if((j > i && (k <= i || k > j)) || (j < i && (k <= i && k > j))) {
+            ri->slots[i] = ri->slots[j];
+            i = j;
+        }
+    }
+    ri->slots[i].pos = 0;
+}
+
+static UA_StatusCode
+indexResizeSlots(UA_NodeReferenceKind *rk, size_t slotsSize) {
+    UA_RefIndex *ri = refIndex(rk);
+    UA_RefIndexSlot *slots = (UA_RefIndexSlot*)
+        UA_calloc(slotsSize, sizeof(UA_RefIndexSlot));
+    if(!slots)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    for(size_t i = 0; i < ri->slotsSize; i++) {
+        if(ri->slots[i].pos != 0)
+            indexInsertSlot(slots, slotsSize, ri->slots[i].hash,
+                            ri->slots[i].pos - 1);
+    }
+    UA_free(ri->slots);
+    ri->slots = slots;
+    ri->slotsSize = slotsSize;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Realloc the array (with the index in front) to the capacity */
+static UA_StatusCode
+reallocTargets(UA_NodeReferenceKind *rk, size_t capacity) {
+    if(!rk->hasRefIndex) {
+        UA_ReferenceTarget *newRefs = (UA_ReferenceTarget*)
+            UA_realloc(rk->targets.array, sizeof(UA_ReferenceTarget) * capacity);
+        if(!newRefs)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        rk->targets.array = newRefs;
+        return UA_STATUSCODE_GOOD;
+    }
+    UA_RefIndex *ri = (UA_RefIndex*)
+        UA_realloc(refIndex(rk), sizeof(UA_RefIndex) +
+                   (sizeof(UA_ReferenceTarget) * capacity));
+    if(!ri)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    rk->targets.array = (UA_ReferenceTarget*)&ri[1];
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Ensure the capacity for additional targets in the array representation */
+static UA_StatusCode
+reserveTargets(UA_NodeReferenceKind *rk, size_t add) {
+    UA_assert(!rk->hasRefTree);
+    size_t newSize = rk->targetsSize + add;
+    if(newSize <= refsCapacity(rk->targetsSize))
+        return UA_STATUSCODE_GOOD;
+    UA_StatusCode res = reallocTargets(rk, refsCapacity(newSize));
+    if(res != UA_STATUSCODE_GOOD || !rk->hasRefIndex)
+        return res;
+    size_t slotsSize = refsCapacity(newSize) * 2;
+    if(slotsSize <= refIndex(rk)->slotsSize)
+        return UA_STATUSCODE_GOOD;
+    return indexResizeSlots(rk, slotsSize);
+}
+
+/* Append to the array. The capacity was reserved before. Takes ownership of
+ * the targetId (no copy). */
+static void
+appendTarget(UA_NodeReferenceKind *rk, UA_NodePointer targetId,
+             UA_UInt32 targetNameHash) {
+    UA_ReferenceTarget *t = &rk->targets.array[rk->targetsSize];
+    t->targetId = targetId;
+    t->targetNameHash = targetNameHash;
+    if(rk->hasRefIndex) {
+        UA_RefIndex *ri = refIndex(rk);
+        indexInsertSlot(ri->slots, ri->slotsSize, targetHash(targetId),
+                        (UA_UInt32)rk->targetsSize);
+        ri->namesSize = 0;
+    }
+    rk->targetsSize++;
+}
+
+/* Remove the target from the array. The last target is moved into the gap.
+ * Does not shrink the array. */
+static void
+removeTarget(UA_NodeReferenceKind *rk, UA_ReferenceTarget *target) {
+    size_t pos = (size_t)(target - rk->targets.array);
+    size_t last = rk->targetsSize - 1;
+    if(rk->hasRefIndex) {
+        UA_RefIndex *ri = refIndex(rk);
+        UA_RefIndexSlot *slot = indexFindSlot(ri, targetHash(target->targetId), pos);
+        UA_assert(slot);
+        indexRemoveSlot(ri, slot);
+        if(pos != last) {
+            slot = indexFindSlot(ri, targetHash(rk->targets.array[last].targetId), last);
+            UA_assert(slot);
+            slot->pos = (UA_UInt32)pos + 1;
+        }
+        ri->namesSize = 0;
+    }
+    UA_NodePointer_clear(&target->targetId);
+    if(pos != last)
+        *target = rk->targets.array[last];
+    rk->targetsSize--;
+}
+
+static void
+clearTargetsArray(UA_NodeReferenceKind *rk) {
+    for(size_t i = 0; i < rk->targetsSize; i++)
+        UA_NodePointer_clear(&rk->targets.array[i].targetId);
+    if(rk->hasRefIndex) {
+        UA_RefIndex *ri = refIndex(rk);
+        UA_free(ri->slots);
+        UA_free(ri->names);
+        UA_free(ri);
+    } else {
+        UA_free(rk->targets.array);
+    }
+    rk->targets.array = NULL;
+    rk->hasRefIndex = false;
+    rk->targetsSize = 0;
+}
+
+static int
+cmpRefIndexName(const void *a, const void *b) {
+    const UA_RefIndexName *aa = (const UA_RefIndexName*)a;
+    const UA_RefIndexName *bb = (const UA_RefIndexName*)b;
+    if(aa->nameHash != bb->nameHash)
+        return (aa->nameHash < bb->nameHash) ? -1 : 1;
+    if(aa->pos != bb->pos)
+        return (aa->pos < bb->pos) ? -1 : 1;
+    return 0;
+}
+
+/* Rebuild the sorted name index if required */
+static UA_Boolean
+indexUpdateNames(UA_NodeReferenceKind *rk) {
+    UA_RefIndex *ri = refIndex(rk);
+    if(ri->namesSize == rk->targetsSize)
+        return true;
+    UA_RefIndexName *names = (UA_RefIndexName*)
+        UA_realloc(ri->names, sizeof(UA_RefIndexName) * rk->targetsSize);
+    if(!names)
+        return false;
+    for(size_t i = 0; i < rk->targetsSize; i++) {
+        names[i].nameHash = rk->targets.array[i].targetNameHash;
+        names[i].pos = (UA_UInt32)i;
+    }
+    qsort(names, rk->targetsSize, sizeof(UA_RefIndexName), cmpRefIndexName);
+    ri->names = names;
+    ri->namesSize = rk->targetsSize;
+    return true;
+}
+
+const UA_ReferenceTarget *
+UA_NodeReferenceKind_iterateName(UA_NodeReferenceKind *rk,
+                                 UA_UInt32 nameHash, size_t *cursor) {
+    UA_assert(rk->hasRefIndex);
+
+    /* Linear search if the name index cannot be built */
+    if(!indexUpdateNames(rk)) {
+        for(; *cursor < rk->targetsSize; (*cursor)++) {
+            if(rk->targets.array[*cursor].targetNameHash == nameHash)
+                return &rk->targets.array[(*cursor)++];
+        }
+        return NULL;
+    }
+
+    /* Binary search for the first matching entry */
+    UA_RefIndex *ri = refIndex(rk);
+    if(*cursor == 0) {
+        size_t lo = 0, hi = ri->namesSize;
+        while(lo < hi) {
+            size_t mid = lo + ((hi - lo) / 2);
+            if(ri->names[mid].nameHash < nameHash)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        *cursor = lo + 1;
+    }
+
+    /* Return the next matching entry */
+    size_t i = *cursor - 1;
+    if(i >= ri->namesSize || ri->names[i].nameHash != nameHash)
+        return NULL;
+    (*cursor)++;
+    return &rk->targets.array[ri->names[i].pos];
+}
+
+UA_StatusCode
+UA_NodeReferenceKind_switchIndex(UA_NodeReferenceKind *rk) {
+    /* From tree to array first */
+    if(rk->hasRefTree) {
+        UA_StatusCode res = UA_NodeReferenceKind_switch(rk);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+
+    size_t capacity = refsCapacity(rk->targetsSize);
+
+    /* Remove the index */
+    if(rk->hasRefIndex) {
+        UA_RefIndex *ri = refIndex(rk);
+        UA_ReferenceTarget *array = NULL;
+        if(capacity > 0) {
+            array = (UA_ReferenceTarget*)
+                UA_malloc(sizeof(UA_ReferenceTarget) * capacity);
+            if(!array)
+                return UA_STATUSCODE_BADOUTOFMEMORY;
+            memcpy(array, rk->targets.array,
+                   sizeof(UA_ReferenceTarget) * rk->targetsSize);
+        }
+        UA_free(ri->slots);
+        UA_free(ri->names);
+        UA_free(ri);
+        rk->targets.array = array;
+        rk->hasRefIndex = false;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Add the index in front of the array */
+    size_t slotsSize = (capacity > 0) ? capacity * 2 : 2;
+    UA_RefIndexSlot *slots = (UA_RefIndexSlot*)
+        UA_calloc(slotsSize, sizeof(UA_RefIndexSlot));
+    if(!slots)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_RefIndex *ri = (UA_RefIndex*)
+        UA_malloc(sizeof(UA_RefIndex) + (sizeof(UA_ReferenceTarget) * capacity));
+    if(!ri) {
+        UA_free(slots);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    ri->slots = slots;
+    ri->slotsSize = slotsSize;
+    ri->names = NULL;
+    ri->namesSize = 0;
+    UA_ReferenceTarget *array = (UA_ReferenceTarget*)&ri[1];
+    for(size_t i = 0; i < rk->targetsSize; i++) {
+        array[i] = rk->targets.array[i];
+        indexInsertSlot(slots, slotsSize, targetHash(array[i].targetId),
+                        (UA_UInt32)i);
+    }
+    UA_free(rk->targets.array);
+    rk->targets.array = array;
+    rk->hasRefIndex = true;
+    return UA_STATUSCODE_GOOD;
+}
+
 const UA_ReferenceTarget *
 UA_NodeReferenceKind_iterate(const UA_NodeReferenceKind *rk,
                              const UA_ReferenceTarget *prev) {
@@ -268,7 +689,7 @@ UA_NodeReferenceKind_iterate(const UA_NodeReferenceKind *rk,
         return (const UA_ReferenceTarget*)aa_next(&_refIdTree, prev);
     }
     if(prev == NULL) /* Return start of the array */
-        return rk->targets.array;
+        return (rk->targetsSize > 0) ? rk->targets.array : NULL;
     if(prev + 1 >= &rk->targets.array[rk->targetsSize])
         return NULL; /* End of the array */
     return prev + 1; /* Next element in the array */
@@ -286,7 +707,7 @@ moveTreeToArray(UA_ReferenceTarget *array, size_t *pos,
     moveTreeToArray(array, pos, elem->idTreeEntry.right);
     array[*pos] = elem->target;
     (*pos)++;
-    UA_free(elem);
+    freeTreeElem(elem);
 }
 
 UA_StatusCode
@@ -294,7 +715,7 @@ UA_NodeReferenceKind_switch(UA_NodeReferenceKind *rk) {
     if(rk->hasRefTree) {
         /* From tree to array */
         UA_ReferenceTarget *array = (UA_ReferenceTarget*)
-            UA_malloc(sizeof(UA_ReferenceTarget) * rk->targetsSize);
+            UA_malloc(sizeof(UA_ReferenceTarget) * refsCapacity(rk->targetsSize));
         if(!array)
             return UA_STATUSCODE_BADOUTOFMEMORY;
         size_t pos = 0;
@@ -304,31 +725,31 @@ UA_NodeReferenceKind_switch(UA_NodeReferenceKind *rk) {
         return UA_STATUSCODE_GOOD;
     }
 
-    /* From array to tree */
+    /* From array to tree. Allocate the tree elements in one slab and move the
+     * targets over. */
+    if(rk->hasRefIndex) {
+        UA_StatusCode res = UA_NodeReferenceKind_switchIndex(rk);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    if(rk->targetsSize == 0) {
+        UA_free(rk->targets.array);
+        rk->targets.tree.idTreeRoot = NULL;
+        rk->targets.tree.nameTreeRoot = NULL;
+        rk->hasRefTree = true;
+        return UA_STATUSCODE_GOOD;
+    }
+    UA_ReferenceTargetTreeElem *elems = allocTreeElems(rk->targetsSize);
+    if(!elems)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
     UA_NodeReferenceKind newRk = *rk;
     newRk.hasRefTree = true;
+    newRk.targetsSize = 0;
     newRk.targets.tree.idTreeRoot = NULL;
     newRk.targets.tree.nameTreeRoot = NULL;
-    for(size_t i = 0; i < rk->targetsSize; i++) {
-        UA_StatusCode res =
-            addReferenceTarget(&newRk, rk->targets.array[i].targetId,
-                               rk->targets.array[i].targetNameHash);
-        if(res != UA_STATUSCODE_GOOD) {
-            struct aa_head _refIdTree = refIdTree;
-            _refIdTree.root = newRk.targets.tree.idTreeRoot;
-            while(_refIdTree.root) {
-                UA_ReferenceTargetTreeElem *elem = (UA_ReferenceTargetTreeElem*)
-                    ((uintptr_t)_refIdTree.root -
-                     offsetof(UA_ReferenceTargetTreeElem, idTreeEntry));
-                aa_remove(&_refIdTree, elem);
-                UA_NodePointer_clear(&elem->target.targetId);
-                UA_free(elem);
-            }
-            return res;
-        }
-    }
     for(size_t i = 0; i < rk->targetsSize; i++)
-        UA_NodePointer_clear(&rk->targets.array[i].targetId);
+        insertTreeElem(&newRk, &elems[i], rk->targets.array[i].targetId,
+                       rk->targets.array[i].targetNameHash);
     UA_free(rk->targets.array);
     *rk = newRk;
     return UA_STATUSCODE_GOOD;
@@ -350,6 +771,21 @@ UA_NodeReferenceKind_findTarget(const UA_NodeReferenceKind *rk,
         return (const UA_ReferenceTarget*)aa_find(&_refIdTree, &tmpTarget);
     }
 
+    /* Return from the hash index */
+    if(rk->hasRefIndex) {
+        UA_RefIndex *ri = refIndex(rk);
+        UA_UInt32 hash = UA_ExpandedNodeId_hash(targetId);
+        size_t mask = ri->slotsSize - 1;
+        for(size_t i = hash & mask; ri->slots[i].pos != 0; i = (i + 1) & mask) {
+            if(ri->slots[i].hash != hash)
+                continue;
+            const UA_ReferenceTarget *t = &rk->targets.array[ri->slots[i].pos - 1];
+            if(UA_NodePointer_equal(targetP, t->targetId))
+                return t;
+        }
+        return NULL;
+    }
+
     /* Return from the array */
     for(size_t i = 0; i < rk->targetsSize; i++) {
         if(UA_NodePointer_equal(targetP, rk->targets.array[i].targetId))
@@ -362,10 +798,248 @@ const UA_Node *
 UA_NODESTORE_GETFROMREF(UA_Server *server, UA_NodePointer target) {
     if(!UA_NodePointer_isLocal(target))
         return NULL;
+    if(server->config.nodestore.getNodeFromPtr)
+        return server->config.nodestore.
+            getNodeFromPtr(server->config.nodestore.context, target);
     UA_NodeId id = UA_NodePointer_toNodeId(target);
     return UA_NODESTORE_GET(server, &id);
 }
 
+void
+UA_NODESTORE_PREFETCH(UA_Server *server, size_t nodeIdsSize,
+                      const UA_NodeId **nodeIds) {
+    UA_Nodestore *ns = &server->config.nodestore;
+    if(!ns->prefetchNodes || nodeIdsSize == 0)
+        return;
+    UA_TRACE_BEGIN(UA_TRACESTAGE_NODESTORE, NULL);
+    ns->prefetchNodes(ns->context, nodeIdsSize, nodeIds);
+    UA_TRACE_END();
+}
+
+/* The target structure (array or tree) is allocated once for all targets */
+static UA_StatusCode
+copyReferenceKind(const UA_NodeReferenceKind *src, UA_NodeReferenceKind *dst) {
+    dst->referenceTypeIndex = src->referenceTypeIndex;
+    dst->isInverse = src->isInverse;
+    dst->hasRefTree = src->hasRefTree;
+    dst->hasRefIndex = false;
+    dst->targetsSize = 0;
+    if(src->targetsSize == 0)
+        return UA_STATUSCODE_GOOD;
+
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    const UA_ReferenceTarget *t = NULL;
+    if(!src->hasRefTree) {
+        res = reserveTargets(dst, src->targetsSize);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        while((t = UA_NodeReferenceKind_iterate(src, t))) {
+            UA_ReferenceTarget *dt = &dst->targets.array[dst->targetsSize];
+            res = UA_NodePointer_copy(t->targetId, &dt->targetId);
+            if(res != UA_STATUSCODE_GOOD)
+                break;
+            dt->targetNameHash = t->targetNameHash;
+            dst->targetsSize++;
+        }
+        if(dst->targetsSize == 0) {
+            UA_free(dst->targets.array);
+            dst->targets.array = NULL;
+        }
+        if(res == UA_STATUSCODE_GOOD && src->hasRefIndex)
+            res = UA_NodeReferenceKind_switchIndex(dst);
+        return res;
+    }
+
+    UA_ReferenceTargetTreeElem *elems = allocTreeElems(src->targetsSize);
+    if(!elems)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    size_t i = 0;
+    while((t = UA_NodeReferenceKind_iterate(src, t))) {
+        UA_NodePointer targetId;
+        res = UA_NodePointer_copy(t->targetId, &targetId);
+        if(res != UA_STATUSCODE_GOOD)
+            break;
+        insertTreeElem(dst, &elems[i], targetId, t->targetNameHash);
+        i++;
+    }
+    /* Release the unused elements */
+    for(size_t j = i; j < src->targetsSize; j++)
+        freeTreeElem(&elems[j]);
+    return res;
+}
+
+/**********************/
+/* Compact Attributes */
+/**********************/
+
+/* The compacted attributes are encoded in the binary format behind a
+ * UA_UInt32 with the size of the buffer. The flags in the NodeHead define
+ * which attributes are contained. */
+#define UA_NODE_COMPACT 0x01
+#define UA_NODE_COMPACT_DISPLAYNAME_BROWSENAME 0x02
+#define UA_NODE_COMPACT_DISPLAYNAME 0x04
+#define UA_NODE_COMPACT_DESCRIPTION 0x08
+
+static UA_Boolean
+isEmptyLocalizedText(const UA_LocalizedText *lt) {
+    return (lt->locale.length == 0 && lt->text.length == 0);
+}
+
+static size_t
+compactSize(const UA_Byte *compact) {
+    UA_UInt32 size;
+    memcpy(&size, compact, sizeof(UA_UInt32));
+    return size;
+}
+
+UA_StatusCode
+UA_Node_compactAttributes(UA_Node *node) {
+    UA_NodeHead *head = &node->head;
+    if(head->compactFlags != 0)
+        return UA_STATUSCODE_GOOD;
+
+    /* Which attributes need to be encoded? */
+    UA_Byte flags = UA_NODE_COMPACT;
+    size_t size = 0;
+    if(head->displayName.locale.length == 0 &&
+       UA_String_equal(&head->displayName.text, &head->browseName.name)) {
+        flags |= UA_NODE_COMPACT_DISPLAYNAME_BROWSENAME;
+    } else if(!isEmptyLocalizedText(&head->displayName)) {
+        flags |= UA_NODE_COMPACT_DISPLAYNAME;
+        size += UA_calcSizeBinary(&head->displayName,
+                                  &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    }
+    if(!isEmptyLocalizedText(&head->description)) {
+        flags |= UA_NODE_COMPACT_DESCRIPTION;
+        size += UA_calcSizeBinary(&head->description,
+                                  &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    }
+
+    /* Encode */
+    UA_Byte *compact = NULL;
+    if(size > 0) {
+        size += sizeof(UA_UInt32);
+        if(size > UA_UINT32_MAX)
+            return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+        compact = (UA_Byte*)UA_malloc(size);
+        if(!compact)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        UA_UInt32 size32 = (UA_UInt32)size;
+        memcpy(compact, &size32, sizeof(UA_UInt32));
+        UA_Byte *pos = compact + sizeof(UA_UInt32);
+        const UA_Byte *end = compact + size;
+        UA_StatusCode res = UA_STATUSCODE_GOOD;
+        if(flags & UA_NODE_COMPACT_DISPLAYNAME)
+            res |= UA_encodeBinaryInternal(&head->displayName,
+                                           &UA_TYPES[UA_TYPES_LOCALIZEDTEXT],
+                                           &pos, &end, NULL, NULL);
+        if(flags & UA_NODE_COMPACT_DESCRIPTION)
+            res |= UA_encodeBinaryInternal(&head->description,
+                                           &UA_TYPES[UA_TYPES_LOCALIZEDTEXT],
+                                           &pos, &end, NULL, NULL);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(compact);
+            return res;
+        }
+    }
+
+    UA_LocalizedText_clear(&head->displayName);
+    UA_LocalizedText_clear(&head->description);
+    head->compactFlags = flags;
+    head->compactAttributes = compact;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+readCompactAttribute(const UA_NodeHead *head, UA_Byte flag,
+                     UA_LocalizedText *out) {
+    UA_LocalizedText_init(out);
+    if(flag == UA_NODE_COMPACT_DISPLAYNAME &&
+       (head->compactFlags & UA_NODE_COMPACT_DISPLAYNAME_BROWSENAME))
+        return UA_String_copy(&head->browseName.name, &out->text);
+    if(!(head->compactFlags & flag))
+        return UA_STATUSCODE_GOOD; /* Empty */
+
+    /* The Description comes after the DisplayName */
+    UA_ByteString buf;
+    buf.length = compactSize(head->compactAttributes);
+    buf.data = head->compactAttributes;
+    size_t offset = sizeof(UA_UInt32);
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(flag == UA_NODE_COMPACT_DESCRIPTION &&
+       (head->compactFlags & UA_NODE_COMPACT_DISPLAYNAME)) {
+        res = UA_decodeBinaryInternal(&buf, &offset, out,
+                                      &UA_TYPES[UA_TYPES_LOCALIZEDTEXT], NULL);
+        UA_LocalizedText_clear(out);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return UA_decodeBinaryInternal(&buf, &offset, out,
+                                   &UA_TYPES[UA_TYPES_LOCALIZEDTEXT], NULL);
+}
+
+UA_StatusCode
+UA_Node_readDisplayName(const UA_Node *node, UA_LocalizedText *out) {
+    if(node->head.compactFlags == 0)
+        return UA_LocalizedText_copy(&node->head.displayName, out);
+    return readCompactAttribute(&node->head, UA_NODE_COMPACT_DISPLAYNAME, out);
+}
+
+UA_StatusCode
+UA_Node_readDescription(const UA_Node *node, UA_LocalizedText *out) {
+    if(node->head.compactFlags == 0)
+        return UA_LocalizedText_copy(&node->head.description, out);
+    return readCompactAttribute(&node->head, UA_NODE_COMPACT_DESCRIPTION, out);
+}
+
+UA_StatusCode
+UA_Node_expandAttributes(UA_Node *node) {
+    UA_NodeHead *head = &node->head;
+    if(head->compactFlags == 0)
+        return UA_STATUSCODE_GOOD;
+    UA_LocalizedText displayName, description;
+    UA_StatusCode res = UA_Node_readDisplayName(node, &displayName);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    res = UA_Node_readDescription(node, &description);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LocalizedText_clear(&displayName);
+        return res;
+    }
+    UA_free(head->compactAttributes);
+    head->compactAttributes = NULL;
+    head->compactFlags = 0;
+    head->displayName = displayName;
+    head->description = description;
+    return UA_STATUSCODE_GOOD;
+}
+
+/*****************/
+/* Shared Values */
+/*****************/
+
+UA_StatusCode
+UA_VariableNode_shareValue(UA_VariableNode *node) {
+    /* Only share values owned by the node */
+    if(node->valueSource != UA_VALUESOURCE_DATA ||
+       node->value.data.value.value.storageType != UA_VARIANT_DATA)
+        return UA_STATUSCODE_GOOD;
+    return UA_Variant_share(&node->value.data.value.value);
+}
+
+UA_StatusCode
+UA_VariableNode_unshareValue(UA_VariableNode *node) {
+    if(node->valueSource != UA_VALUESOURCE_DATA)
+        return UA_STATUSCODE_GOOD;
+    return UA_Variant_unshare(&node->value.data.value.value);
+}
+
+void
+UA_VariableNode_releaseValue(UA_VariableNode *node) {
+    if(node->valueSource == UA_VALUESOURCE_DATA)
+        UA_DataValue_clear(&node->value.data.value);
+}
+
 /* General node handling methods. There is no UA_Node_new() method here.
  * Creating nodes is part of the Nodestore layer */
 
@@ -379,6 +1053,9 @@ void UA_Node_clear(UA_Node *node) {
     UA_QualifiedName_clear(&head->browseName);
     UA_LocalizedText_clear(&head->displayName);
     UA_LocalizedText_clear(&head->description);
+    UA_free(head->compactAttributes);
+    head->compactAttributes = NULL;
+    head->compactFlags = 0;
 
     /* Delete unique content of the nodeclass */
     switch(head->nodeClass) {
@@ -396,8 +1073,7 @@ void UA_Node_clear(UA_Node *node) {
                         &UA_TYPES[UA_TYPES_INT32]);
         p->arrayDimensions = NULL;
         p->arrayDimensionsSize = 0;
-        if(p->valueSource == UA_VALUESOURCE_DATA)
-            UA_DataValue_clear(&p->value.data.value);
+        UA_VariableNode_releaseValue(p);
         break;
     }
     case UA_NODECLASS_REFERENCETYPE: {
@@ -511,6 +1187,15 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
     dsthead->writeMask = srchead->writeMask;
     dsthead->context = srchead->context;
     dsthead->constructed = srchead->constructed;
+    dsthead->compactFlags = srchead->compactFlags;
+    if(srchead->compactAttributes) {
+        size_t size = compactSize(srchead->compactAttributes);
+        dsthead->compactAttributes = (UA_Byte*)UA_malloc(size);
+        if(dsthead->compactAttributes)
+            memcpy(dsthead->compactAttributes, srchead->compactAttributes, size);
+        else
+            retval |= UA_STATUSCODE_BADOUTOFMEMORY;
+    }
     if(retval != UA_STATUSCODE_GOOD) {
         UA_Node_clear(dst);
         return retval;
@@ -520,7 +1205,8 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
     dsthead->references = NULL;
     if(srchead->referencesSize > 0) {
         dsthead->references = (UA_NodeReferenceKind*)
-            UA_calloc(srchead->referencesSize, sizeof(UA_NodeReferenceKind));
+            UA_calloc(refsCapacity(srchead->referencesSize),
+                      sizeof(UA_NodeReferenceKind));
         if(!dsthead->references) {
             UA_Node_clear(dst);
             return UA_STATUSCODE_BADOUTOFMEMORY;
@@ -528,20 +1214,11 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
         dsthead->referencesSize = srchead->referencesSize;
 
         for(size_t i = 0; i < srchead->referencesSize; ++i) {
-            UA_NodeReferenceKind *srefs = &srchead->references[i];
-            UA_NodeReferenceKind *drefs = &dsthead->references[i];
-            drefs->referenceTypeIndex = srefs->referenceTypeIndex;
-            drefs->isInverse = srefs->isInverse;
-            drefs->hasRefTree = srefs->hasRefTree; /* initially empty */
-
-            /* Copy all the targets */
-            const UA_ReferenceTarget *t = NULL;
-            while((t = UA_NodeReferenceKind_iterate(srefs, t))) {
-                retval = addReferenceTarget(drefs, t->targetId, t->targetNameHash);
-                if(retval != UA_STATUSCODE_GOOD) {
-                    UA_Node_clear(dst);
-                    return retval;
-                }
+            retval = copyReferenceKind(&srchead->references[i],
+                                       &dsthead->references[i]);
+            if(retval != UA_STATUSCODE_GOOD) {
+                UA_Node_clear(dst);
+                return retval;
             }
         }
     }
@@ -802,86 +1479,80 @@ addReferenceTarget(UA_NodeReferenceKind *rk, UA_NodePointer targetId,
                    UA_UInt32 targetNameHash) {
     /* Insert into array */
     if(!rk->hasRefTree) {
-        UA_ReferenceTarget *newRefs = (UA_ReferenceTarget*)
-            UA_realloc(rk->targets.array,
-                       sizeof(UA_ReferenceTarget) * (rk->targetsSize + 1));
-        if(!newRefs)
-            return UA_STATUSCODE_BADOUTOFMEMORY;
-        rk->targets.array = newRefs;
+        UA_StatusCode retval = reserveTargets(rk, 1);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
 
-        UA_StatusCode retval =
-            UA_NodePointer_copy(targetId,
-                                &rk->targets.array[rk->targetsSize].targetId);
-        rk->targets.array[rk->targetsSize].targetNameHash = targetNameHash;
+        UA_NodePointer targetCopy;
+        retval = UA_NodePointer_copy(targetId, &targetCopy);
         if(retval != UA_STATUSCODE_GOOD) {
-            if(rk->targetsSize == 0) {
-                UA_free(rk->targets.array);
-                rk->targets.array = NULL;
-            }
+            if(rk->targetsSize == 0)
+                clearTargetsArray(rk);
             return retval;
         }
-        rk->targetsSize++;
+        appendTarget(rk, targetCopy, targetNameHash);
         return UA_STATUSCODE_GOOD;
     }
 
     /* Insert into tree */
-    UA_ReferenceTargetTreeElem *entry = (UA_ReferenceTargetTreeElem*)
-        UA_malloc(sizeof(UA_ReferenceTargetTreeElem));
+    UA_ReferenceTargetTreeElem *entry = allocTreeElems(1);
     if(!entry)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
-    UA_StatusCode retval =
-        UA_NodePointer_copy(targetId, &entry->target.targetId);
+    UA_NodePointer targetCopy;
+    UA_StatusCode retval = UA_NodePointer_copy(targetId, &targetCopy);
     if(retval != UA_STATUSCODE_GOOD) {
-        UA_free(entry);
+        freeTreeElem(entry);
         return retval;
     }
 
     /* <-- The point of no return --> */
 
-    UA_ExpandedNodeId en = UA_NodePointer_toExpandedNodeId(targetId);
-    entry->targetIdHash = UA_ExpandedNodeId_hash(&en);
-    entry->target.targetNameHash = targetNameHash;
-
-    /* Insert to the id lookup binary search tree. Only the root is kept in refs
-     * to save space. */
-    struct aa_head _refIdTree = refIdTree;
-    _refIdTree.root = rk->targets.tree.idTreeRoot;
-    aa_insert(&_refIdTree, entry);
-    rk->targets.tree.idTreeRoot = _refIdTree.root;
+    insertTreeElem(rk, entry, targetCopy, targetNameHash);
+    return UA_STATUSCODE_GOOD;
+}
 
-    /* Insert to the name lookup binary search tree */
-    struct aa_head _refNameTree = refNameTree;
-    _refNameTree.root = rk->targets.tree.nameTreeRoot;
-    aa_insert(&_refNameTree, entry);
-    rk->targets.tree.nameTreeRoot = _refNameTree.root;
+/* Returns an empty ReferenceKind at the end of the array. Increase
+ * referencesSize only once the first target was added. */
+static UA_NodeReferenceKind *
+reserveReferenceKind(UA_NodeHead *head, UA_Byte refTypeIndex,
+                     UA_Boolean isForward) {
+    size_t capacity = refsCapacity(head->referencesSize);
+    if(head->referencesSize + 1 > capacity) {
+        UA_NodeReferenceKind *refs = (UA_NodeReferenceKind*)
+            UA_realloc(head->references, sizeof(UA_NodeReferenceKind) *
+                       refsCapacity(head->referencesSize + 1));
+        if(!refs)
+            return NULL;
+        head->references = refs;
+    }
 
-    rk->targetsSize++;
+    UA_NodeReferenceKind *newRef = &head->references[head->referencesSize];
+    memset(newRef, 0, sizeof(UA_NodeReferenceKind));
+    newRef->referenceTypeIndex = refTypeIndex;
+    newRef->isInverse = !isForward;
+    return newRef;
+}
 
-    return UA_STATUSCODE_GOOD;
+static void
+releaseReferenceKind(UA_NodeHead *head) {
+    if(head->referencesSize > 0)
+        return;
+    UA_free(head->references);
+    head->references = NULL;
 }
 
 static UA_StatusCode
 addReferenceKind(UA_NodeHead *head, UA_Byte refTypeIndex, UA_Boolean isForward,
                  const UA_NodePointer target, UA_UInt32 targetBrowseNameHash) {
-    UA_NodeReferenceKind *refs = (UA_NodeReferenceKind*)
-        UA_realloc(head->references,
-                   sizeof(UA_NodeReferenceKind) * (head->referencesSize+1));
-    if(!refs)
+    UA_NodeReferenceKind *newRef =
+        reserveReferenceKind(head, refTypeIndex, isForward);
+    if(!newRef)
         return UA_STATUSCODE_BADOUTOFMEMORY;
-    head->references = refs;
-
-    UA_NodeReferenceKind *newRef = &refs[head->referencesSize];
-    memset(newRef, 0, sizeof(UA_NodeReferenceKind));
-    newRef->referenceTypeIndex = refTypeIndex;
-    newRef->isInverse = !isForward;
     UA_StatusCode retval =
         addReferenceTarget(newRef, target, targetBrowseNameHash);
     if(retval != UA_STATUSCODE_GOOD) {
-        if(head->referencesSize == 0) {
-            UA_free(head->references);
-            head->references = NULL;
-        }
+        releaseReferenceKind(head);
         return retval;
     }
 
@@ -923,6 +1594,84 @@ UA_Node_addReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForward,
 
 }
 
+/* Add the targets that don't exist already to the ReferenceKind */
+static UA_StatusCode
+addReferenceTargets(UA_NodeReferenceKind *rk, size_t targetsSize,
+                    const UA_ExpandedNodeId *targetNodeIds,
+                    const UA_UInt32 *targetBrowseNameHashes) {
+    /* Insert into the array. Grow only once. */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(!rk->hasRefTree) {
+        res = reserveTargets(rk, targetsSize);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        for(size_t i = 0; i < targetsSize; i++) {
+            if(UA_NodeReferenceKind_findTarget(rk, &targetNodeIds[i]))
+                continue; /* Duplicate */
+            UA_NodePointer targetId;
+            res = UA_NodePointer_copy(UA_NodePointer_fromExpandedNodeId(&targetNodeIds[i]),
+                                      &targetId);
+            if(res != UA_STATUSCODE_GOOD)
+                break;
+            appendTarget(rk, targetId, targetBrowseNameHashes[i]);
+        }
+        if(rk->targetsSize == 0)
+            clearTargetsArray(rk);
+        return res;
+    }
+
+    /* Insert into the tree. Allocate the elements in one slab. */
+    UA_ReferenceTargetTreeElem *elems = allocTreeElems(targetsSize);
+    if(!elems)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    size_t i = 0;
+    for(; i < targetsSize; i++) {
+        if(UA_NodeReferenceKind_findTarget(rk, &targetNodeIds[i])) {
+            freeTreeElem(&elems[i]); /* Duplicate */
+            continue;
+        }
+        UA_NodePointer targetId;
+        res = UA_NodePointer_copy(UA_NodePointer_fromExpandedNodeId(&targetNodeIds[i]),
+                                  &targetId);
+        if(res != UA_STATUSCODE_GOOD)
+            break;
+        insertTreeElem(rk, &elems[i], targetId, targetBrowseNameHashes[i]);
+    }
+    for(; i < targetsSize; i++)
+        freeTreeElem(&elems[i]); /* Release the unused elements */
+    return res;
+}
+
+UA_StatusCode
+UA_Node_addReferences(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForward,
+                      size_t targetsSize, const UA_ExpandedNodeId *targetNodeIds,
+                      const UA_UInt32 *targetBrowseNameHashes) {
+    if(targetsSize == 0)
+        return UA_STATUSCODE_GOOD;
+
+    /* Add to the existing ReferenceKind */
+    UA_NodeHead *head = &node->head;
+    for(size_t i = 0; i < head->referencesSize; ++i) {
+        UA_NodeReferenceKind *rk = &head->references[i];
+        if(rk->isInverse == isForward || rk->referenceTypeIndex != refTypeIndex)
+            continue;
+        return addReferenceTargets(rk, targetsSize, targetNodeIds,
+                                   targetBrowseNameHashes);
+    }
+
+    /* Add new ReferenceKind for the targets */
+    UA_NodeReferenceKind *rk = reserveReferenceKind(head, refTypeIndex, isForward);
+    if(!rk)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = addReferenceTargets(rk, targetsSize, targetNodeIds,
+                                            targetBrowseNameHashes);
+    if(rk->targetsSize > 0)
+        head->referencesSize++;
+    else
+        releaseReferenceKind(head);
+    return res;
+}
+
 UA_StatusCode
 UA_Node_deleteReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForward,
                         const UA_ExpandedNodeId *targetNodeId) {
@@ -944,27 +1693,23 @@ UA_Node_deleteReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForwar
             continue;
 
         /* Ok, delete the reference. Cannot fail */
-        refs->targetsSize--;
-
         if(!refs->hasRefTree) {
             /* Remove from array */
-            UA_NodePointer_clear(&target->targetId);
+            removeTarget(refs, target);
 
-            /* Elements remaining. Realloc. */
+            /* Elements remaining. Shrink when the implied capacity drops. The
+             * hash index keeps its slots. */
             if(refs->targetsSize > 0) {
-                if(target != &refs->targets.array[refs->targetsSize])
-                    *target = refs->targets.array[refs->targetsSize];
-                UA_ReferenceTarget *newRefs = (UA_ReferenceTarget*)
-                    UA_realloc(refs->targets.array,
-                               sizeof(UA_ReferenceTarget) * refs->targetsSize);
-                if(newRefs)
-                    refs->targets.array = newRefs;
+                size_t capacity = refsCapacity(refs->targetsSize);
+                if(capacity < refsCapacity(refs->targetsSize + 1))
+                    reallocTargets(refs, capacity);
                 return UA_STATUSCODE_GOOD; /* Realloc allowed to fail */
             }
 
             /* Remove the last target. Remove the ReferenceKind below */
-            UA_free(refs->targets.array);
+            clearTargetsArray(refs);
         } else {
+            refs->targetsSize--;
             /* Remove from the tree */
             _refIdTree.root = refs->targets.tree.idTreeRoot;
             aa_remove(&_refIdTree, target);
@@ -975,7 +1720,7 @@ UA_Node_deleteReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForwar
             refs->targets.tree.nameTreeRoot = _refNameTree.root;
 
             UA_NodePointer_clear(&target->targetId);
-            UA_free(target);
+            freeTreeElem((UA_ReferenceTargetTreeElem*)target);
             if(refs->targets.tree.idTreeRoot)
                 return UA_STATUSCODE_GOOD; /* At least one target remains */
         }
@@ -988,11 +1733,14 @@ UA_Node_deleteReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForwar
              * be shrinked down. */
             if(i != head->referencesSize)
                 head->references[i] = head->references[node->head.referencesSize];
-            UA_NodeReferenceKind *newRefs = (UA_NodeReferenceKind*)
-                UA_realloc(head->references,
-                           sizeof(UA_NodeReferenceKind) * head->referencesSize);
-            if(newRefs)
-                head->references = newRefs;
+            size_t capacity = refsCapacity(head->referencesSize);
+            if(capacity < refsCapacity(head->referencesSize + 1)) {
+                UA_NodeReferenceKind *newRefs = (UA_NodeReferenceKind*)
+                    UA_realloc(head->references,
+                               sizeof(UA_NodeReferenceKind) * capacity);
+                if(newRefs)
+                    head->references = newRefs;
+            }
         } else {
             /* No remaining references of any ReferenceType */
             UA_free(head->references);
@@ -1016,9 +1764,7 @@ UA_Node_deleteReferencesSubset(UA_Node *node, const UA_ReferenceTypeSet *keepSet
         /* Remove all target entries. Don't remove entries from browseName tree.
          * The entire ReferenceKind will be removed anyway. */
         if(!refs->hasRefTree) {
-            for(size_t j = 0; j < refs->targetsSize; j++)
-                UA_NodePointer_clear(&refs->targets.array[j].targetId);
-            UA_free(refs->targets.array);
+            clearTargetsArray(refs);
         } else {
             _refIdTree.root = refs->targets.tree.idTreeRoot;
             while(_refIdTree.root) {
@@ -1027,7 +1773,7 @@ UA_Node_deleteReferencesSubset(UA_Node *node, const UA_ReferenceTypeSet *keepSet
                      offsetof(UA_ReferenceTargetTreeElem, idTreeEntry));
                 aa_remove(&_refIdTree, elem);
                 UA_NodePointer_clear(&elem->target.targetId);
-                UA_free(elem);
+                freeTreeElem(elem);
             }
         }
 
@@ -1043,8 +1789,8 @@ UA_Node_deleteReferencesSubset(UA_Node *node, const UA_ReferenceTypeSet *keepSet
     if(head->referencesSize > 0) {
         /* Realloc to save memory. Ignore if realloc fails. */
         UA_NodeReferenceKind *refs = (UA_NodeReferenceKind*)
-            UA_realloc(head->references,
-                       sizeof(UA_NodeReferenceKind) * head->referencesSize);
+            UA_realloc(head->references, sizeof(UA_NodeReferenceKind) *
+                       refsCapacity(head->referencesSize));
         if(refs)
             head->references = refs;
     } else {
@@ -160,8 +160,9 @@ static void
 serverExecuteRepeatedCallback(UA_Server *server, UA_ApplicationCallback cb,
                               void *callbackApplication, void *data);
 
-/* The server needs to be stopped before it can be deleted */
-void UA_Server_delete(UA_Server *server) {
+/* Clean up everything except for the configuration */
+static void
+UA_Server_clear(UA_Server *server) {
     UA_LOCK(&server->serviceMutex);
 
     UA_Server_deleteSecureChannels(server);
@@ -204,6 +205,8 @@ void UA_Server_delete(UA_Server *server) {
     UA_AsyncManager_clear(&server->asyncManager, server);
 #endif
 
+    UA_DiscoveryCache_clear(&server->discoveryCache);
+
     /* Clean up the Admin Session */
     UA_Session_clear(&server->adminSession, server);
 
@@ -214,14 +217,23 @@ void UA_Server_delete(UA_Server *server) {
              (UA_TimerExecutionCallback)serverExecuteRepeatedCallback, server);
     UA_Timer_clear(&server->timer);
 
-    /* Clean up the config */
-    UA_ServerConfig_clean(&server->config);
-
 #if UA_MULTITHREADING >= 100
     UA_LOCK_DESTROY(&server->networkMutex);
     UA_LOCK_DESTROY(&server->serviceMutex);
 #endif
 
+#ifdef UA_ENABLE_TRACING
+    UA_TraceManager_clear(&server->traceManager);
+#endif
+}
+
+/* The server needs to be stopped before it can be deleted */
+void UA_Server_delete(UA_Server *server) {
+    UA_Server_clear(server);
+
+    /* Clean up the config */
+    UA_ServerConfig_clean(&server->config);
+
     /* Delete the server itself */
     UA_free(server);
 }
@@ -249,29 +261,19 @@ UA_Boolean UA_Server_NodestoreIsConfigured(UA_Server *server) {
     return server->config.nodestore.getNode != NULL;
 }
 
-static UA_Server *
-UA_Server_init(UA_Server *server) {
-
-    UA_StatusCode res = UA_STATUSCODE_GOOD;
-    UA_CHECK_FATAL(UA_Server_NodestoreIsConfigured(server), goto cleanup,
-                    &server->config.logger, UA_LOGCATEGORY_SERVER,
-                    "No Nodestore configured in the server"
-                   );
-
-    /* Init start time to zero, the actual start time will be sampled in
-     * UA_Server_run_startup() */
-    server->startTime = 0;
-
-    /* Set a seed for non-cyptographic randomness */
-#ifndef UA_ENABLE_DETERMINISTIC_RNG
-    UA_random_seed((UA_UInt64)UA_DateTime_now());
-#endif
-
+/* Initialize the members that don't depend on the configuration. The server
+ * memory is zeroed out before. */
+static void
+UA_Server_initBase(UA_Server *server) {
 #if UA_MULTITHREADING >= 100
     UA_LOCK_INIT(&server->networkMutex);
     UA_LOCK_INIT(&server->serviceMutex);
 #endif
 
+#ifdef UA_ENABLE_TRACING
+    UA_TraceManager_init(&server->traceManager);
+#endif
+
     /* Initialize the handling of repeated callbacks */
     UA_Timer_init(&server->timer);
 
@@ -281,15 +283,6 @@ UA_Server_init(UA_Server *server) {
     server->adminSession.sessionId.identifier.guid.data1 = 1;
     server->adminSession.validTill = UA_INT64_MAX;
 
-    /* Create Namespaces 0 and 1
-     * Ns1 will be filled later with the uri from the app description */
-    server->namespaces = (UA_String *)UA_Array_new(2, &UA_TYPES[UA_TYPES_STRING]);
-    UA_CHECK_MEM(server->namespaces, goto cleanup);
-
-    server->namespaces[0] = UA_STRING_ALLOC("http://opcfoundation.org/UA/");
-    server->namespaces[1] = UA_STRING_NULL;
-    server->namespacesSize = 2;
-
     /* Initialize SecureChannel */
     TAILQ_INIT(&server->channels);
     /* TODO: use an ID that is likely to be unique after a restart */
@@ -303,13 +296,45 @@ UA_Server_init(UA_Server *server) {
 #if UA_MULTITHREADING >= 100
     UA_AsyncManager_init(&server->asyncManager, server);
 #endif
+}
+
+static UA_Server *
+UA_Server_init(UA_Server *server) {
+
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_CHECK_FATAL(UA_Server_NodestoreIsConfigured(server), goto cleanup,
+                    &server->config.logger, UA_LOGCATEGORY_SERVER,
+                    "No Nodestore configured in the server"
+                   );
+
+    /* Init start time to zero, the actual start time will be sampled in
+     * UA_Server_run_startup() */
+    server->startTime = 0;
+
+    /* Set a seed for non-cyptographic randomness */
+#ifndef UA_ENABLE_DETERMINISTIC_RNG
+    UA_random_seed((UA_UInt64)UA_DateTime_now());
+#endif
+
+    UA_Server_initBase(server);
+
+    /* Create Namespaces 0 and 1
+     * Ns1 will be filled later with the uri from the app description */
+    server->namespaces = (UA_String *)UA_Array_new(2, &UA_TYPES[UA_TYPES_STRING]);
+    UA_CHECK_MEM(server->namespaces, goto cleanup);
+
+    server->namespaces[0] = UA_STRING_ALLOC("http://opcfoundation.org/UA/");
+    server->namespaces[1] = UA_STRING_NULL;
+    server->namespacesSize = 2;
 
     /* Add a regular callback for cleanup and maintenance. With a 10s interval. */
     UA_Server_addRepeatedCallback(server, (UA_ServerCallback)UA_Server_cleanup, NULL,
                                   10000.0, NULL);
 
     /* Initialize namespace 0*/
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_NODESTORE);
     res = UA_Server_initNS0(server);
+    UA_MEMORYTAG_END();
     UA_CHECK_STATUS(res, goto cleanup);
 
 #ifdef UA_ENABLE_PUBSUB
@@ -349,6 +374,43 @@ UA_Server_newWithConfig(UA_ServerConfig *config) {
     return UA_Server_init(server);
 }
 
+UA_Server *
+UA_Server_newStaging(UA_Server *server, const UA_Nodestore *nodestore) {
+    UA_Server *staging = (UA_Server *)UA_calloc(1, sizeof(UA_Server));
+    UA_CHECK_MEM(staging, return NULL);
+
+    /* Borrow the configuration. Only the nodestore is replaced. The members
+     * that are released by UA_Server_clear stay with the server. */
+    staging->config = server->config;
+    staging->config.nodestore = *nodestore;
+#ifdef UA_ENABLE_PUBSUB
+    staging->config.pubSubConfig.transportLayers = NULL;
+    staging->config.pubSubConfig.transportLayersSize = 0;
+#endif
+#ifdef UA_ENABLE_DISCOVERY_MULTICAST
+    staging->config.mdnsEnabled = false;
+#endif
+    UA_Server_initBase(staging);
+
+    /* The namespaces of the server are taken over with the same indices */
+    UA_StatusCode res =
+        UA_Array_copy(server->namespaces, server->namespacesSize,
+                      (void**)&staging->namespaces, &UA_TYPES[UA_TYPES_STRING]);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_Server_deleteStaging(staging);
+        return NULL;
+    }
+    staging->namespacesSize = server->namespacesSize;
+    return staging;
+}
+
+void
+UA_Server_deleteStaging(UA_Server *staging) {
+    /* The configuration is borrowed. Don't clean it up. */
+    UA_Server_clear(staging);
+    UA_free(staging);
+}
+
 /* Returns if the server should be shut down immediately */
 static UA_Boolean
 setServerShutdown(UA_Server *server) {
@@ -461,6 +523,10 @@ UA_Server_updateCertificate(UA_Server *server,
         }
     }
 
+    UA_LOCK(&server->serviceMutex);
+    UA_DiscoveryCache_clear(&server->discoveryCache);
+    UA_UNLOCK(&server->serviceMutex);
+
     size_t i = 0;
     while(i < server->config.endpointsSize) {
         UA_EndpointDescription *ed = &server->config.endpoints[i];
@@ -518,6 +584,9 @@ verifyServerApplicationURI(const UA_Server *server) {
 
 UA_ServerStatistics UA_Server_getStatistics(UA_Server *server)
 {
+#ifdef UA_ENABLE_MEMORY_ACCOUNTING
+   UA_getMemoryStatistics(server->serverStats.ms);
+#endif
    return server->serverStats;
 }
 
@@ -622,6 +691,9 @@ UA_Server_run_startup(UA_Server *server) {
         startMulticastDiscoveryServer(server);
 #endif
 
+    /* The discovery urls have changed */
+    UA_DiscoveryCache_clear(&server->discoveryCache);
+
     server->state = UA_SERVERLIFECYCLE_FRESH;
 
     return result;
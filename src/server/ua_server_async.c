@@ -386,8 +386,9 @@ setMethodNodeAsync(UA_Server *server, UA_Session *session,
 UA_StatusCode
 UA_Server_setMethodNodeAsync(UA_Server *server, const UA_NodeId id,
                              UA_Boolean isAsync) {
-    return UA_Server_editNode(server, &server->adminSession, &id,
-                              (UA_EditNodeCallback)setMethodNodeAsync, &isAsync);
+    return UA_Server_editNodeKeepShared(server, &server->adminSession, &id,
+                                        (UA_EditNodeCallback)setMethodNodeAsync,
+                                        &isAsync);
 }
 
 UA_StatusCode
@@ -455,6 +455,7 @@ sendResponse(UA_Server *server, UA_Session *session, UA_SecureChannel *channel,
     UA_assert(mc.buf_end <= &mc.messageBuffer.data[mc.messageBuffer.length]);
 
     /* Encode the response type */
+    UA_TRACE_BEGIN(UA_TRACESTAGE_ENCODE, NULL);
     retval = UA_MessageContext_encode(&mc, &responseType->binaryEncodingId,
                                       &UA_TYPES[UA_TYPES_NODEID]);
     if(retval != UA_STATUSCODE_GOOD)
@@ -462,11 +463,47 @@ sendResponse(UA_Server *server, UA_Session *session, UA_SecureChannel *channel,
 
     /* Encode the response */
     retval = UA_MessageContext_encode(&mc, response, responseType);
+    UA_TRACE_END();
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
 
     /* Finish / send out */
-    return UA_MessageContext_finish(&mc);
+    UA_TRACE_BEGIN(UA_TRACESTAGE_SEND, NULL);
+    retval = UA_MessageContext_finish(&mc);
+    UA_TRACE_END();
+    return retval;
+}
+
+/* Send a response where everything after the ResponseHeader is already
+ * encoded. The responseHeader must have the requestHandle already set. */
+static UA_StatusCode
+sendPreEncodedResponse(UA_Server *server, UA_SecureChannel *channel,
+                       UA_UInt32 requestId, UA_ResponseHeader *responseHeader,
+                       const UA_DataType *responseType, const UA_ByteString *body) {
+    responseHeader->timestamp = UA_DateTime_now();
+    UA_LOG_DEBUG_CHANNEL(&server->config.logger, channel,
+                         "Sending a pre-encoded response for RequestId %u",
+                         (unsigned)requestId);
+
+    UA_MessageContext mc;
+    UA_StatusCode retval = UA_MessageContext_begin(&mc, channel, requestId, UA_MESSAGETYPE_MSG);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    retval = UA_MessageContext_encode(&mc, &responseType->binaryEncodingId,
+                                      &UA_TYPES[UA_TYPES_NODEID]);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    retval = UA_MessageContext_encode(&mc, responseHeader,
+                                      &UA_TYPES[UA_TYPES_RESPONSEHEADER]);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    retval = UA_MessageContext_encodeRaw(&mc, body);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    UA_TRACE_BEGIN(UA_TRACESTAGE_SEND, NULL);
+    retval = UA_MessageContext_finish(&mc);
+    UA_TRACE_END();
+    return retval;
 }
 
 /* A Session is "bound" to a SecureChannel if it was created by the
@@ -503,7 +540,7 @@ static const UA_String securityPolicyNone =
 
 static UA_StatusCode
 processMSGDecoded(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
-                  UA_Service service, const UA_Request *request,
+                  UA_Service service, UA_Request *request,
                   const UA_DataType *requestType, UA_Response *response,
                   const UA_DataType *responseType, UA_Boolean sessionRequired) {
     const UA_RequestHeader *requestHeader = &request->requestHeader;
@@ -526,7 +563,9 @@ processMSGDecoded(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 reques
        requestType == &UA_TYPES[UA_TYPES_ACTIVATESESSIONREQUEST] ||
        requestType == &UA_TYPES[UA_TYPES_CLOSESESSIONREQUEST]) {
         UA_LOCK(&server->serviceMutex);
+        UA_TRACE_BEGIN(UA_TRACESTAGE_SERVICE, NULL);
         ((UA_ChannelService)service)(server, channel, request, response);
+        UA_TRACE_END();
         UA_UNLOCK(&server->serviceMutex);
 #ifdef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
         /* Store the authentication token so we can help fuzzing by setting
@@ -600,11 +639,34 @@ processMSGDecoded(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 reques
     /* Update the session lifetime */
     UA_Session_updateLifetime(session);
 
+    /* The discovery responses are sent from the cache of pre-encoded bodies.
+     * The cache entry can be replaced as soon as the service mutex is released.
+     * So a copy of the body is sent without holding the mutex. */
+    if(requestType == &UA_TYPES[UA_TYPES_GETENDPOINTSREQUEST] ||
+       requestType == &UA_TYPES[UA_TYPES_FINDSERVERSREQUEST]) {
+        UA_ByteString body = UA_BYTESTRING_NULL;
+        UA_LOCK(&server->serviceMutex);
+        UA_TRACE_BEGIN(UA_TRACESTAGE_SERVICE, NULL);
+        UA_Boolean cached = UA_DiscoveryCache_get(server, session, request, requestType,
+                                                  response, responseType, &body);
+        UA_TRACE_END();
+        UA_UNLOCK(&server->serviceMutex);
+        if(!cached)
+            return sendResponse(server, session, channel, requestId, response, responseType);
+        UA_StatusCode retval =
+            sendPreEncodedResponse(server, channel, requestId,
+                                   &response->responseHeader, responseType, &body);
+        UA_ByteString_clear(&body);
+        return retval;
+    }
+
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     /* The publish request is not answered immediately */
     if(requestType == &UA_TYPES[UA_TYPES_PUBLISHREQUEST]) {
         UA_LOCK(&server->serviceMutex);
+        UA_TRACE_BEGIN(UA_TRACESTAGE_SERVICE, NULL);
         Service_Publish(server, session, &request->publishRequest, requestId);
+        UA_TRACE_END();
         UA_UNLOCK(&server->serviceMutex);
         return UA_STATUSCODE_GOOD;
     }
@@ -615,8 +677,11 @@ processMSGDecoded(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 reques
     if(requestType == &UA_TYPES[UA_TYPES_CALLREQUEST]) {
         UA_Boolean finished = true;
         UA_LOCK(&server->serviceMutex);
+        UA_TRACE_BEGIN(UA_TRACESTAGE_SERVICE, NULL);
+        UA_Session_resolveRegisteredNodeIds(session, request, requestType);
         Service_CallAsync(server, session, requestId, &request->callRequest,
                           &response->callResponse, &finished);
+        UA_TRACE_END();
         UA_UNLOCK(&server->serviceMutex);
 
         /* Async method calls remain. Don't send a response now */
@@ -630,11 +695,47 @@ processMSGDecoded(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 reques
 
     /* Dispatch the synchronous service call and send the response */
     UA_LOCK(&server->serviceMutex);
+    UA_TRACE_BEGIN(UA_TRACESTAGE_SERVICE, NULL);
+    /* Replace the RegisterNodes handles with the registered NodeIds. Read and
+     * Write use the pinned nodes of the handles directly. UnregisterNodes
+     * takes the handles as its argument. */
+    if(requestType != &UA_TYPES[UA_TYPES_READREQUEST] &&
+       requestType != &UA_TYPES[UA_TYPES_WRITEREQUEST] &&
+       requestType != &UA_TYPES[UA_TYPES_UNREGISTERNODESREQUEST])
+        UA_Session_resolveRegisteredNodeIds(session, request, requestType);
     service(server, session, request, response);
+    UA_TRACE_END();
     UA_UNLOCK(&server->serviceMutex);
     return sendResponse(server, session, channel, requestId, response, responseType);
 }
 
+#ifdef UA_ENABLE_MEMORY_ACCOUNTING
+/* The subsystem that keeps the memory allocated by the service */
+static UA_MemoryTag
+serviceMemoryTag(const UA_DataType *requestType) {
+    if(requestType == &UA_TYPES[UA_TYPES_CREATESESSIONREQUEST] ||
+       requestType == &UA_TYPES[UA_TYPES_ACTIVATESESSIONREQUEST] ||
+       requestType == &UA_TYPES[UA_TYPES_REGISTERNODESREQUEST])
+        return UA_MEMORYTAG_SESSION;
+    if(requestType == &UA_TYPES[UA_TYPES_ADDNODESREQUEST])
+        return UA_MEMORYTAG_NODESTORE;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    if(requestType == &UA_TYPES[UA_TYPES_CREATESUBSCRIPTIONREQUEST] ||
+       requestType == &UA_TYPES[UA_TYPES_MODIFYSUBSCRIPTIONREQUEST] ||
+       requestType == &UA_TYPES[UA_TYPES_PUBLISHREQUEST] ||
+       requestType == &UA_TYPES[UA_TYPES_CREATEMONITOREDITEMSREQUEST] ||
+       requestType == &UA_TYPES[UA_TYPES_MODIFYMONITOREDITEMSREQUEST] ||
+       requestType == &UA_TYPES[UA_TYPES_SETTRIGGERINGREQUEST])
+        return UA_MEMORYTAG_SUBSCRIPTION;
+#endif
+#ifdef UA_ENABLE_HISTORIZING
+    if(requestType == &UA_TYPES[UA_TYPES_HISTORYUPDATEREQUEST])
+        return UA_MEMORYTAG_HISTORY;
+#endif
+    return UA_MEMORYTAG_SERVICE;
+}
+#endif
+
 static UA_StatusCode
 processMSG(UA_Server *server, UA_SecureChannel *channel,
            UA_UInt32 requestId, const UA_ByteString *msg) {
@@ -675,11 +776,16 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
                                             requestId, UA_STATUSCODE_BADSERVICEUNSUPPORTED);
     }
     UA_assert(responseType);
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+    UA_TRACE_NAME(requestType->typeName);
+#endif
 
     /* Decode the request */
     UA_Request request;
+    UA_TRACE_BEGIN(UA_TRACESTAGE_DECODE, NULL);
     retval = UA_decodeBinaryInternal(msg, &offset, &request,
                                      requestType, server->config.customDataTypes);
+    UA_TRACE_END();
     if(retval != UA_STATUSCODE_GOOD) {
         UA_LOG_DEBUG_CHANNEL(&server->config.logger, channel,
                              "Could not decode the request with StatusCode %s",
@@ -718,8 +824,10 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
     UA_Response response;
     UA_init(&response, responseType);
     response.responseHeader.requestHandle = requestHeader->requestHandle;
+    UA_MEMORYTAG_BEGIN(serviceMemoryTag(requestType));
     retval = processMSGDecoded(server, channel, requestId, service, &request, requestType,
                                &response, responseType, sessionRequired);
+    UA_MEMORYTAG_END();
 
     /* Clean up */
     UA_clear(&request, requestType);
@@ -744,10 +852,19 @@ processSecureChannelMessage(void *application, UA_SecureChannel *channel,
         UA_LOG_TRACE_CHANNEL(&server->config.logger, channel, "Process an OPN message");
         retval = processOPN(server, channel, requestId, message);
         break;
-    case UA_MESSAGETYPE_MSG:
+    case UA_MESSAGETYPE_MSG: {
         UA_LOG_TRACE_CHANNEL(&server->config.logger, channel, "Process a MSG");
+#ifdef UA_ENABLE_TRACING
+        UA_Trace_beginRequest(server);
+#endif
+        UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_SERVICE);
         retval = processMSG(server, channel, requestId, message);
+        UA_MEMORYTAG_END();
+#ifdef UA_ENABLE_TRACING
+        UA_Trace_endRequest(server);
+#endif
         break;
+    }
     case UA_MESSAGETYPE_CLO:
         UA_LOG_TRACE_CHANNEL(&server->config.logger, channel, "Process a CLO");
         Service_CloseSecureChannel(server, channel); /* Regular close */
@@ -799,6 +916,7 @@ UA_Server_processBinaryMessage(UA_Server *server, UA_Connection *connection,
     UA_TcpErrorMessage error;
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
     UA_SecureChannel *channel = connection->channel;
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_SECURECHANNEL);
 
     /* Add a SecureChannel to a new connection */
     if(!channel) {
@@ -824,6 +942,7 @@ UA_Server_processBinaryMessage(UA_Server *server, UA_Connection *connection,
         goto error;
     }
 
+    UA_MEMORYTAG_END();
     return;
 
  error:
@@ -832,6 +951,7 @@ UA_Server_processBinaryMessage(UA_Server *server, UA_Connection *connection,
     error.reason = UA_STRING_NULL;
     UA_Connection_sendError(connection, &error);
     connection->close(connection);
+    UA_MEMORYTAG_END();
 }
 
 void
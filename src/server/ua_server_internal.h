@@ -23,6 +23,7 @@
 #include "ua_connection_internal.h"
 #include "ua_session.h"
 #include "ua_server_async.h"
+#include "ua_server_tracing.h"
 #include "ua_timer.h"
 #include "ua_util_internal.h"
 #include "ziptree.h"
@@ -77,6 +78,33 @@ typedef struct session_list_entry {
     UA_Session session;
 } session_list_entry;
 
+/* Pre-encoded GetEndpoints and FindServers responses. Clients call these
+ * services before every connection. The entries are keyed by the encoded
+ * request without the RequestHeader (endpointUrl, localeIds and the
+ * profileUris/serverUris filter). The body is the encoded response without the
+ * ResponseHeader. The cache is emptied when the endpoints, certificates or
+ * registered servers change. */
+#define UA_DISCOVERYCACHE_SIZE 8
+
+typedef struct {
+    const UA_DataType *requestType; /* NULL for an empty entry */
+    UA_ByteString key;
+    UA_ByteString body;
+} UA_DiscoveryCacheEntry;
+
+typedef struct {
+    UA_DiscoveryCacheEntry entries[UA_DISCOVERYCACHE_SIZE];
+    size_t next; /* Round-robin replacement */
+
+    /* Detect when the config was changed behind the back of the server */
+    const UA_EndpointDescription *endpoints;
+    size_t endpointsSize;
+    size_t networkLayersSize;
+    UA_UInt32 descriptionHash; /* ApplicationDescription and discovery urls */
+
+    size_t hits; /* Statistics */
+} UA_DiscoveryCache;
+
 typedef enum {
     UA_SERVERLIFECYCLE_FRESH,
     UA_SERVERLIFECYLE_RUNNING
@@ -107,6 +135,10 @@ struct UA_Server {
                               * maintenance) uses this Session with all possible
                               * access rights (Session Id: 1) */
 
+    /* Incremented when a node is replaced or removed in the Nodestore.
+     * Pointers to pinned nodes are re-resolved when this changes. */
+    UA_UInt64 nodestoreVersion;
+
     /* Namespaces */
     size_t namespacesSize;
     UA_String *namespaces;
@@ -118,10 +150,17 @@ struct UA_Server {
      * the parent and member instantiation */
     UA_Boolean bootstrapNS0;
 
+    /* Nodes for which the callback returns true are edited on a copy that
+     * replaces the original, also without UA_ENABLE_IMMUTABLE_NODES. Set for
+     * the staging servers of the nodeset loader. So their edits never modify
+     * the nodes of the server in-situ. */
+    UA_Boolean (*copyOnEdit)(UA_Server *server, const UA_Node *node);
+
     /* Discovery */
 #ifdef UA_ENABLE_DISCOVERY
     UA_DiscoveryManager discoveryManager;
 #endif
+    UA_DiscoveryCache discoveryCache;
 
     /* Subscriptions */
 #ifdef UA_ENABLE_SUBSCRIPTIONS
@@ -154,8 +193,29 @@ struct UA_Server {
 
     /* Statistics */
     UA_ServerStatistics serverStats;
+
+#ifdef UA_ENABLE_TRACING
+    UA_TraceManager traceManager;
+#endif
 };
 
+/******************/
+/* Staging Server */
+/******************/
+
+/* Create a server that borrows the configuration of the server but uses the
+ * given nodestore. All members are initialized as in UA_Server_new. But no
+ * namespace zero is created and the staging server is never run. The
+ * namespace array is copied from the server. So the namespace indices match.
+ * The staging server must be deleted before the server. */
+UA_Server *
+UA_Server_newStaging(UA_Server *server, const UA_Nodestore *nodestore);
+
+/* Delete the staging server. The nodestore and the borrowed configuration are
+ * not cleaned up. */
+void
+UA_Server_deleteStaging(UA_Server *staging);
+
 /***********************/
 /* References Handling */
 /***********************/
@@ -166,6 +226,15 @@ const UA_ReferenceTarget *
 UA_NodeReferenceKind_findTarget(const UA_NodeReferenceKind *rk,
                                 const UA_ExpandedNodeId *targetId);
 
+/* Iterate the targets with the given BrowseName hash in an array with hash
+ * index (rk->hasRefIndex). Start with *cursor == 0. Returns NULL when no
+ * further target matches. The sorted name index is rebuilt lazily during the
+ * lookup. Hence the rk is modified. This requires that the node is not
+ * accessed concurrently. */
+const UA_ReferenceTarget *
+UA_NodeReferenceKind_iterateName(UA_NodeReferenceKind *rk,
+                                 UA_UInt32 nameHash, size_t *cursor);
+
 /**************************/
 /* SecureChannel Handling */
 /**************************/
@@ -238,9 +307,15 @@ UA_Server_getSessionById(UA_Server *server, const UA_NodeId *sessionId);
 /* Node Handling */
 /*****************/
 
+/* Replaces a value payload that is shared copy-on-write (e.g. with the
+ * variables of the type definition) with a private copy. Then the value can be
+ * modified in-situ. */
+UA_StatusCode UA_Node_unshareValue(UA_Node *node);
+
 /* Calls the callback with the node retrieved from the nodestore on top of the
  * stack. Either a copy or the original node for in-situ editing. Depends on
- * multithreading and the nodestore.*/
+ * multithreading and the nodestore. The callback never sees a shared value
+ * payload (see UA_Node_unshareValue). */
 typedef UA_StatusCode (*UA_EditNodeCallback)(UA_Server*, UA_Session*,
                                              UA_Node *node, void*);
 UA_StatusCode UA_Server_editNode(UA_Server *server, UA_Session *session,
@@ -248,6 +323,14 @@ UA_StatusCode UA_Server_editNode(UA_Server *server, UA_Session *session,
                                  UA_EditNodeCallback callback,
                                  void *data);
 
+/* Same as UA_Server_editNode. But a shared value payload stays shared. Only for
+ * callbacks that do not modify the value attribute, e.g. that edit the
+ * references, the context or the callbacks of the node. */
+UA_StatusCode UA_Server_editNodeKeepShared(UA_Server *server, UA_Session *session,
+                                           const UA_NodeId *nodeId,
+                                           UA_EditNodeCallback callback,
+                                           void *data);
+
 /*********************/
 /* Utility Functions */
 /*********************/
@@ -319,13 +402,34 @@ UA_StatusCode
 sendResponse(UA_Server *server, UA_Session *session, UA_SecureChannel *channel,
              UA_UInt32 requestId, UA_Response *response, const UA_DataType *responseType);
 
+/* Remove all pre-encoded discovery responses */
+void
+UA_DiscoveryCache_clear(UA_DiscoveryCache *dc);
+
+/* Copies the pre-encoded response body for a GetEndpoints or FindServers
+ * request. On a cache miss, the service is called and its result is encoded
+ * into the cache. Returns false if the request cannot be answered from the
+ * cache. Then the response contains the service result to be sent in the normal
+ * way. The copy of the body can be sent after the service mutex is released. */
+UA_Boolean
+UA_DiscoveryCache_get(UA_Server *server, UA_Session *session,
+                      const UA_Request *request, const UA_DataType *requestType,
+                      UA_Response *response, const UA_DataType *responseType,
+                      UA_ByteString *body);
+
 /* Many services come as an array of operations. This function generalizes the
- * processing of the operations. */
+ * processing of the operations. The optional prefetch callback is called
+ * before each chunk of up to UA_NODESTORE_BATCHSIZE operations is processed,
+ * e.g. to prefetch the nodes of the chunk from the nodestore. */
 typedef void (*UA_ServiceOperation)(UA_Server *server, UA_Session *session,
                                     const void *context,
                                     const void *requestOperation,
                                     void *responseOperation);
 
+typedef void (*UA_ServiceOperationsPrefetch)(UA_Server *server, UA_Session *session,
+                                             const void *requestOperations,
+                                             size_t requestOperationsSize);
+
 UA_StatusCode
 UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
                                    UA_ServiceOperation operationCallback,
@@ -333,7 +437,8 @@ UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
                                    const size_t *requestOperations,
                                    const UA_DataType *requestOperationsType,
                                    size_t *responseOperations,
-                                   const UA_DataType *responseOperationsType)
+                                   const UA_DataType *responseOperationsType,
+                                   UA_ServiceOperationsPrefetch prefetchCallback)
     UA_FUNC_ATTR_WARN_UNUSED_RESULT;
 
 /******************************************/
@@ -343,6 +448,11 @@ UA_StatusCode
 deleteNode(UA_Server *server, const UA_NodeId nodeId,
            UA_Boolean deleteReferences);
 
+/* Remove the references to this node from the other nodes */
+void
+removeIncomingReferences(UA_Server *server, UA_Session *session,
+                         const UA_NodeHead *head);
+
 UA_StatusCode
 addNode(UA_Server *server, const UA_NodeClass nodeClass, const UA_NodeId *requestedNewNodeId,
         const UA_NodeId *parentNodeId, const UA_NodeId *referenceTypeId,
@@ -588,13 +698,33 @@ UA_StatusCode writeNs0VariableArray(UA_Server *server, UA_UInt32 id, void *v,
 #define UA_NODESTORE_DELETE(server, node)                               \
     server->config.nodestore.deleteNode(server->config.nodestore.context, node)
 
+#ifndef UA_ENABLE_TRACING
 #define UA_NODESTORE_GET(server, nodeid)                                \
     server->config.nodestore.getNode(server->config.nodestore.context, nodeid)
+#else
+static UA_INLINE const UA_Node *
+UA_NODESTORE_GET(UA_Server *server, const UA_NodeId *nodeId) {
+    UA_TRACE_BEGIN(UA_TRACESTAGE_NODESTORE, NULL);
+    const UA_Node *node =
+        server->config.nodestore.getNode(server->config.nodestore.context, nodeId);
+    UA_TRACE_END();
+    return node;
+}
+#endif
 
 /* Returns NULL if the target is an external Reference (per the ExpandedNodeId) */
 const UA_Node *
 UA_NODESTORE_GETFROMREF(UA_Server *server, UA_NodePointer target);
 
+/* Services with many operations prefetch the nodes in batches of up to
+ * UA_NODESTORE_BATCHSIZE before processing the operations. A no-op if the
+ * nodestore has no prefetchNodes. */
+#define UA_NODESTORE_BATCHSIZE 64
+
+void
+UA_NODESTORE_PREFETCH(UA_Server *server, size_t nodeIdsSize,
+                      const UA_NodeId **nodeIds);
+
 #define UA_NODESTORE_RELEASE(server, node)                              \
     server->config.nodestore.releaseNode(server->config.nodestore.context, node)
 
@@ -607,10 +737,12 @@ UA_NODESTORE_GETFROMREF(UA_Server *server, UA_NodePointer target);
                                         node, addedNodeId)
 
 #define UA_NODESTORE_REPLACE(server, node)                              \
-    server->config.nodestore.replaceNode(server->config.nodestore.context, node)
+    (++(server)->nodestoreVersion,                                      \
+     server->config.nodestore.replaceNode(server->config.nodestore.context, node))
 
 #define UA_NODESTORE_REMOVE(server, nodeId)                             \
-    server->config.nodestore.removeNode(server->config.nodestore.context, nodeId)
+    (++(server)->nodestoreVersion,                                      \
+     server->config.nodestore.removeNode(server->config.nodestore.context, nodeId))
 
 #define UA_NODESTORE_GETREFERENCETYPEID(server, index)                  \
     server->config.nodestore.getReferenceTypeId(server->config.nodestore.context, \
@@ -0,0 +1,1940 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ua_server_internal.h"
+
+#include <errno.h>
+#include <stdlib.h>
+
+#define UA_XML_CHUNKSIZE 65536
+#define UA_XML_MAXATTRIBUTES 24
+#define UA_XML_MAXTOKEN (16u * 1024u * 1024u) /* Longest tag or text content */
+#define UA_NODESETXML_BATCHSIZE 1024          /* Nodes inserted per lock */
+
+/*****************/
+/* XML Tokenizer */
+/*****************/
+
+/* A minimal streaming XML tokenizer. The document is read in chunks. Only the
+ * current tag and the text content since the last tag are buffered. Comments,
+ * processing instructions and the DOCTYPE are skipped. CDATA sections are added
+ * to the text content. Namespace prefixes of the element names are removed.
+ * All returned strings are zero-terminated (without counting the zero in the
+ * length). */
+
+typedef struct {
+    UA_String name;
+    UA_String value;
+} UA_XmlAttribute;
+
+typedef enum {
+    UA_XMLSTATE_TEXT,
+    UA_XMLSTATE_TAG,
+    UA_XMLSTATE_COMMENT,
+    UA_XMLSTATE_CDATA
+} UA_XmlState;
+
+typedef struct {
+    UA_XmlState state;
+    UA_Byte quote;   /* Inside a quoted attribute value of a tag */
+    size_t marker;   /* Count of '-' or ']' at the end of a comment or CDATA */
+
+    UA_Byte *tag;
+    size_t tagLen;
+    size_t tagCap;
+
+    UA_Byte *text;
+    size_t textLen;
+    size_t textCap;
+    size_t textDecoded; /* The text up to here is already decoded (CDATA) */
+} UA_XmlTokenizer;
+
+static UA_StatusCode
+xmlReserve(UA_Byte **buf, size_t *cap, size_t len) {
+    if(len < *cap)
+        return UA_STATUSCODE_GOOD; /* Always leave room for the terminating zero */
+    if(len >= UA_XML_MAXTOKEN)
+        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    size_t newCap = (*cap > 0) ? *cap * 2 : 256;
+    while(newCap <= len)
+        newCap *= 2;
+    UA_Byte *newBuf = (UA_Byte*)UA_realloc(*buf, newCap);
+    if(!newBuf)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    *buf = newBuf;
+    *cap = newCap;
+    return UA_STATUSCODE_GOOD;
+}
+
+static size_t
+utf8Encode(UA_UInt32 c, UA_Byte *out) {
+    if(c < 0x80) {
+        out[0] = (UA_Byte)c;
+        return 1;
+    }
+    if(c < 0x800) {
+        out[0] = (UA_Byte)(0xC0 | (c >> 6));
+        out[1] = (UA_Byte)(0x80 | (c & 0x3F));
+        return 2;
+    }
+    if(c < 0x10000) {
+        out[0] = (UA_Byte)(0xE0 | (c >> 12));
+        out[1] = (UA_Byte)(0x80 | ((c >> 6) & 0x3F));
+        out[2] = (UA_Byte)(0x80 | (c & 0x3F));
+        return 3;
+    }
+    out[0] = (UA_Byte)(0xF0 | (c >> 18));
+    out[1] = (UA_Byte)(0x80 | ((c >> 12) & 0x3F));
+    out[2] = (UA_Byte)(0x80 | ((c >> 6) & 0x3F));
+    out[3] = (UA_Byte)(0x80 | (c & 0x3F));
+    return 4;
+}
+
+/* Decode the predefined entities and character references in-situ. The
+ * decoded string is never longer than the input. Returns the new length. */
+static size_t
+xmlDecodeEntities(UA_Byte *s, size_t len) {
+    UA_Byte *amp = (UA_Byte*)memchr(s, '&', len);
+    if(!amp)
+        return len;
+    size_t in = (size_t)(amp - s), out = in;
+    while(in < len) {
+        if(s[in] != '&') {
+            s[out++] = s[in++];
+            continue;
+        }
+        UA_Byte *semi = (UA_Byte*)memchr(&s[in], ';', len - in);
+        size_t entLen = semi ? (size_t)(semi - &s[in]) + 1 : 0;
+        const char *ent = (const char*)&s[in + 1];
+        UA_Byte c = 0;
+        if(entLen == 4 && strncmp(ent, "lt", 2) == 0)
+            c = '<';
+        else if(entLen == 4 && strncmp(ent, "gt", 2) == 0)
+            c = '>';
+        else if(entLen == 5 && strncmp(ent, "amp", 3) == 0)
+            c = '&';
+        else if(entLen == 6 && strncmp(ent, "quot", 4) == 0)
+            c = '"';
+        else if(entLen == 6 && strncmp(ent, "apos", 4) == 0)
+            c = '\'';
+        if(c != 0) {
+            s[out++] = c;
+            in += entLen;
+            continue;
+        }
+        if(entLen > 3 && entLen < 12 && ent[0] == '#') {
+            /* Character reference. The encoding is at most as long as the
+             * reference ("&#xFFFF;" vs. three bytes) */
+            UA_Boolean hex = (ent[1] == 'x' || ent[1] == 'X');
+            UA_UInt32 cp = 0;
+            UA_Boolean valid = true;
+            for(size_t i = hex ? 2 : 1; i < entLen - 2; i++) {
+                char d = ent[i];
+                if(d >= '0' && d <= '9')
+                    cp = cp * (hex ? 16u : 10u) + (UA_UInt32)(d - '0');
+                else if(hex && d >= 'a' && d <= 'f')
+                    cp = cp * 16u + (UA_UInt32)(d - 'a' + 10);
+                else if(hex && d >= 'A' && d <= 'F')
+                    cp = cp * 16u + (UA_UInt32)(d - 'A' + 10);
+                else
+                    valid = false;
+            }
+            if(valid && cp > 0 && cp <= 0x10FFFF) {
+                UA_Byte enc[4];
+                size_t encLen = utf8Encode(cp, enc);
+                if(encLen <= entLen) {
+                    memcpy(&s[out], enc, encLen);
+                    out += encLen;
+                    in += entLen;
+                    continue;
+                }
+            }
+        }
+        /* Unknown entity. Keep as is. */
+        s[out++] = s[in++];
+    }
+    return out;
+}
+
+static UA_Boolean
+xmlIsSpace(UA_Byte c) {
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+}
+
+/* Remove the namespace prefix */
+static UA_String
+xmlLocalName(UA_Byte *name, size_t nameLen) {
+    UA_String s = {nameLen, name};
+    UA_Byte *colon = (UA_Byte*)memchr(name, ':', nameLen);
+    if(colon) {
+        s.data = colon + 1;
+        s.length = nameLen - (size_t)(s.data - name);
+    }
+    return s;
+}
+
+static UA_Boolean
+xmlNameEq(const UA_String *s, const char *name) {
+    size_t len = strlen(name);
+    return (s->length == len && memcmp(s->data, name, len) == 0);
+}
+
+static void
+xmlClearTokenizer(UA_XmlTokenizer *t) {
+    UA_free(t->tag);
+    UA_free(t->text);
+    memset(t, 0, sizeof(UA_XmlTokenizer));
+}
+
+/**********************/
+/* NodeSet2 Structure */
+/**********************/
+
+typedef struct {
+    UA_NodeId refTypeId;
+    UA_NodeId targetId;
+    UA_Boolean isForward;
+    UA_Boolean added;    /* The forward direction was added during insert */
+    UA_Byte refTypeIndex;
+} UA_XmlReference;
+
+typedef struct {
+    UA_NodeClass nodeClass;
+    UA_NodeId nodeId;
+    UA_QualifiedName browseName;
+    const UA_DataType *attributesType;
+    union {
+        UA_NodeAttributes node;
+        UA_ObjectAttributes object;
+        UA_VariableAttributes variable;
+        UA_MethodAttributes method;
+        UA_ObjectTypeAttributes objectType;
+        UA_VariableTypeAttributes variableType;
+        UA_ReferenceTypeAttributes referenceType;
+        UA_DataTypeAttributes dataType;
+        UA_ViewAttributes view;
+    } attr;
+    size_t refsSize;
+    UA_XmlReference *refs;
+} UA_XmlNode;
+
+typedef struct {
+    UA_String alias;
+    UA_NodeId nodeId;
+} UA_XmlAlias;
+
+/* Reference whose target or ReferenceType was not yet defined when the source
+ * was inserted */
+typedef struct UA_XmlPendingReference {
+    struct UA_XmlPendingReference *next;
+    UA_NodeId sourceId;
+    UA_NodeId refTypeId;
+    UA_Boolean isForward;
+} UA_XmlPendingReference;
+
+/* The pending references are grouped by their target. They are retried when
+ * the target is inserted. The others are added after the document has been
+ * read. */
+typedef struct {
+    struct aa_entry treeEntry;
+    UA_NodeId targetId; /* Key of the tree */
+    UA_XmlPendingReference *refs;
+    UA_XmlPendingReference *lastRef;
+} UA_XmlPendingTarget;
+
+typedef struct {
+    UA_NodeId nodeId;
+    UA_NodeClass nodeClass;
+} UA_XmlLoadedNode;
+
+typedef struct {
+    UA_NodeId refTypeId;
+    UA_Byte refTypeIndex;
+} UA_XmlRefTypeIndex;
+
+typedef enum {
+    UA_XMLSECTION_NONE,
+    UA_XMLSECTION_NAMESPACEURIS,
+    UA_XMLSECTION_ALIASES,
+    UA_XMLSECTION_NODE
+} UA_XmlSection;
+
+typedef struct {
+    UA_Server *server;
+    UA_XmlTokenizer tok;
+
+    size_t depth;
+    size_t skipDepth; /* Ignore the subtree of the element at this depth */
+    UA_XmlSection section;
+
+    /* Map from the namespace indices of the document to the server. The
+     * namespace zero is always the first entry. */
+    size_t nsMapSize;
+    UA_UInt16 *nsMap;
+
+    /* Sorted by the alias name after the Aliases element */
+    size_t aliasesSize;
+    UA_XmlAlias *aliases;
+    UA_String currentAlias;
+
+    /* Batch of nodes that are parsed but not yet inserted */
+    size_t nodesSize;
+    UA_XmlNode *nodes;
+    UA_Boolean inNode;
+    UA_Boolean inReferences;
+    UA_Boolean hasDisplayName;
+    UA_Boolean hasDescription;
+    UA_Boolean hasInverseName;
+    UA_String locale;
+    UA_XmlReference currentRef;
+
+    /* Value of the current node */
+    UA_Variant *valueTarget;
+    size_t valueDepth;     /* Depth of the Value element */
+    size_t valueElemDepth; /* Depth of the elements with the content */
+    const UA_DataType *valueType;
+    UA_Boolean valueArray;
+    UA_Boolean valueDone;
+    void *valueArr;
+    size_t valueArrSize;
+    size_t valueArrCap;
+    UA_String *valueField;
+    UA_String fieldA; /* Locale, NamespaceIndex */
+    UA_String fieldB; /* Text, Name, Identifier, String, Code */
+
+    /* Cache of the ReferenceTypeIndex */
+    size_t refTypeIndicesSize;
+    UA_XmlRefTypeIndex *refTypeIndices;
+
+    struct aa_head pending; /* UA_XmlPendingTarget */
+
+    size_t loadedSize;
+    size_t loadedCap;
+    UA_XmlLoadedNode *loaded;
+
+    UA_StatusCode result; /* First error while inserting the nodes */
+} UA_NodesetXmlLoader;
+
+static UA_StatusCode
+growArray(void **arr, size_t *cap, size_t size, size_t elemSize) {
+    if(size < *cap)
+        return UA_STATUSCODE_GOOD;
+    size_t newCap = (*cap > 0) ? *cap * 2 : 64;
+    void *newArr = UA_realloc(*arr, newCap * elemSize);
+    if(!newArr)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    *arr = newArr;
+    *cap = newCap;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+clearXmlNode(UA_XmlNode *xn) {
+    UA_NodeId_clear(&xn->nodeId);
+    UA_QualifiedName_clear(&xn->browseName);
+    if(xn->attributesType)
+        UA_clear(&xn->attr, xn->attributesType);
+    for(size_t i = 0; i < xn->refsSize; i++) {
+        UA_NodeId_clear(&xn->refs[i].refTypeId);
+        UA_NodeId_clear(&xn->refs[i].targetId);
+    }
+    UA_free(xn->refs);
+    memset(xn, 0, sizeof(UA_XmlNode));
+}
+
+static void
+clearValueState(UA_NodesetXmlLoader *l) {
+    if(l->valueArr) {
+        UA_Array_delete(l->valueArr, l->valueArrSize, l->valueType);
+        l->valueArr = NULL;
+    }
+    l->valueArrSize = 0;
+    l->valueArrCap = 0;
+    l->valueType = NULL;
+    l->valueTarget = NULL;
+    l->valueDepth = 0;
+    l->valueElemDepth = 0;
+    l->valueArray = false;
+    l->valueDone = false;
+    l->valueField = NULL;
+    UA_String_clear(&l->fieldA);
+    UA_String_clear(&l->fieldB);
+}
+
+/******************/
+/* Content Values */
+/******************/
+
+static UA_String
+trimString(UA_String s) {
+    while(s.length > 0 && xmlIsSpace(s.data[0])) {
+        s.data++;
+        s.length--;
+    }
+    while(s.length > 0 && xmlIsSpace(s.data[s.length - 1]))
+        s.length--;
+    return s;
+}
+
+/* The strings from the tokenizer are zero-terminated */
+static UA_StatusCode
+parseInt64(const UA_String *s, UA_Int64 min, UA_Int64 max, UA_Int64 *out) {
+    if(!s->data)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    const char *str = (const char*)s->data;
+    char *end = NULL;
+    errno = 0;
+    long long v = strtoll(str, &end, 10);
+    if(end == str || errno != 0 || v < min || v > max)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    while(xmlIsSpace((UA_Byte)*end))
+        end++;
+    if(*end != 0)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    *out = (UA_Int64)v;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+parseUInt64(const UA_String *s, UA_UInt64 max, UA_UInt64 *out) {
+    if(!s->data)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    const char *str = (const char*)s->data;
+    while(xmlIsSpace((UA_Byte)*str))
+        str++;
+    if(*str == '-')
+        return UA_STATUSCODE_BADDECODINGERROR;
+    char *end = NULL;
+    errno = 0;
+    unsigned long long v = strtoull(str, &end, 10);
+    if(end == str || errno != 0 || v > max)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    while(xmlIsSpace((UA_Byte)*end))
+        end++;
+    if(*end != 0)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    *out = (UA_UInt64)v;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+parseDouble(const UA_String *s, UA_Double *out) {
+    if(!s->data)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    const char *str = (const char*)s->data;
+    char *end = NULL;
+    UA_Double v = strtod(str, &end);
+    if(end == str)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    while(xmlIsSpace((UA_Byte)*end))
+        end++;
+    if(*end != 0)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    *out = v;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+parseBoolean(const UA_String *s, UA_Boolean *out) {
+    UA_String t = trimString(*s);
+    if(xmlNameEq(&t, "true") || xmlNameEq(&t, "1")) {
+        *out = true;
+        return UA_STATUSCODE_GOOD;
+    }
+    if(xmlNameEq(&t, "false") || xmlNameEq(&t, "0")) {
+        *out = false;
+        return UA_STATUSCODE_GOOD;
+    }
+    return UA_STATUSCODE_BADDECODINGERROR;
+}
+
+static UA_StatusCode
+parseDigits(const UA_Byte **pos, const UA_Byte *end, size_t digits, UA_UInt16 *out) {
+    UA_UInt16 v = 0;
+    for(size_t i = 0; i < digits; i++) {
+        if(*pos >= end || **pos < '0' || **pos > '9')
+            return UA_STATUSCODE_BADDECODINGERROR;
+        v = (UA_UInt16)(v * 10 + (**pos - '0'));
+        (*pos)++;
+    }
+    *out = v;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* xs:dateTime, e.g. 2021-03-04T05:06:07.123Z or 2021-03-04T05:06:07+01:00 */
+static UA_StatusCode
+parseDateTime(const UA_String *s, UA_DateTime *out) {
+    UA_String t = trimString(*s);
+    const UA_Byte *pos = t.data, *end = t.data + t.length;
+    UA_DateTimeStruct dts;
+    memset(&dts, 0, sizeof(UA_DateTimeStruct));
+    UA_StatusCode res = parseDigits(&pos, end, 4, &dts.year);
+    if(res != UA_STATUSCODE_GOOD || pos >= end || *pos++ != '-')
+        return UA_STATUSCODE_BADDECODINGERROR;
+    res = parseDigits(&pos, end, 2, &dts.month);
+    if(res != UA_STATUSCODE_GOOD || pos >= end || *pos++ != '-')
+        return UA_STATUSCODE_BADDECODINGERROR;
+    res = parseDigits(&pos, end, 2, &dts.day);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    if(pos < end) {
+        if(*pos++ != 'T')
+            return UA_STATUSCODE_BADDECODINGERROR;
+        res = parseDigits(&pos, end, 2, &dts.hour);
+        if(res != UA_STATUSCODE_GOOD || pos >= end || *pos++ != ':')
+            return UA_STATUSCODE_BADDECODINGERROR;
+        res = parseDigits(&pos, end, 2, &dts.min);
+        if(res != UA_STATUSCODE_GOOD || pos >= end || *pos++ != ':')
+            return UA_STATUSCODE_BADDECODINGERROR;
+        res = parseDigits(&pos, end, 2, &dts.sec);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    if(dts.month < 1 || dts.month > 12 || dts.day < 1 || dts.day > 31 ||
+       dts.hour > 23 || dts.min > 59 || dts.sec > 60)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    /* Fractional seconds in 100ns resolution */
+    UA_DateTime frac = 0;
+    if(pos < end && *pos == '.') {
+        pos++;
+        UA_DateTime scale = UA_DATETIME_SEC / 10;
+        while(pos < end && *pos >= '0' && *pos <= '9') {
+            frac += (*pos - '0') * scale;
+            scale /= 10;
+            pos++;
+        }
+    }
+
+    /* Timezone */
+    UA_DateTime offset = 0;
+    if(pos < end && *pos == 'Z') {
+        pos++;
+    } else if(pos < end && (*pos == '+' || *pos == '-')) {
+        UA_Boolean neg = (*pos == '-');
+        pos++;
+        UA_UInt16 h = 0, m = 0;
+        res = parseDigits(&pos, end, 2, &h);
+        if(res != UA_STATUSCODE_GOOD || pos >= end || *pos++ != ':')
+            return UA_STATUSCODE_BADDECODINGERROR;
+        res = parseDigits(&pos, end, 2, &m);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        offset = ((UA_DateTime)h * 60 + m) * 60 * UA_DATETIME_SEC;
+        if(neg)
+            offset = -offset;
+    }
+    if(pos != end)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    *out = UA_DateTime_fromStruct(dts) + frac - offset;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+mapNamespace(UA_NodesetXmlLoader *l, UA_UInt16 *nsIndex) {
+    if(*nsIndex == 0)
+        return UA_STATUSCODE_GOOD;
+    if(*nsIndex >= l->nsMapSize)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    *nsIndex = l->nsMap[*nsIndex];
+    return UA_STATUSCODE_GOOD;
+}
+
+static int
+compareAlias(const void *a, const void *b) {
+    const UA_String *s1 = &((const UA_XmlAlias*)a)->alias;
+    const UA_String *s2 = &((const UA_XmlAlias*)b)->alias;
+    if(s1->length != s2->length)
+        return (s1->length < s2->length) ? -1 : 1;
+    if(s1->length == 0)
+        return 0;
+    return memcmp(s1->data, s2->data, s1->length);
+}
+
+/* NodeIds are given either as an alias or in the string format */
+static UA_StatusCode
+parseNodeId(UA_NodesetXmlLoader *l, const UA_String *s, UA_NodeId *out) {
+    UA_String t = trimString(*s);
+    if(l->aliasesSize > 0) {
+        UA_XmlAlias key;
+        key.alias = t;
+        const UA_XmlAlias *alias = (const UA_XmlAlias*)
+            bsearch(&key, l->aliases, l->aliasesSize, sizeof(UA_XmlAlias), compareAlias);
+        if(alias)
+            return UA_NodeId_copy(&alias->nodeId, out);
+    }
+    UA_StatusCode res = UA_NodeId_parse(out, t);
+    if(res != UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    res = mapNamespace(l, &out->namespaceIndex);
+    if(res != UA_STATUSCODE_GOOD)
+        UA_NodeId_clear(out);
+    return res;
+}
+
+/* Format "1:Name". Without the prefix the name is in namespace zero. */
+static UA_StatusCode
+parseQualifiedName(UA_NodesetXmlLoader *l, const UA_String *s, UA_QualifiedName *out) {
+    UA_String name = *s;
+    UA_UInt16 ns = 0;
+    size_t i = 0;
+    UA_UInt32 idx = 0;
+    while(i < name.length && name.data[i] >= '0' && name.data[i] <= '9' && idx <= UA_UINT16_MAX) {
+        idx = idx * 10 + (UA_UInt32)(name.data[i] - '0');
+        i++;
+    }
+    if(i > 0 && i < name.length && name.data[i] == ':' && idx <= UA_UINT16_MAX) {
+        ns = (UA_UInt16)idx;
+        name.data += i + 1;
+        name.length -= i + 1;
+    }
+    UA_StatusCode res = mapNamespace(l, &ns);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    out->namespaceIndex = ns;
+    return UA_String_copy(&name, &out->name);
+}
+
+/* Comma-separated list of dimension lengths */
+static UA_StatusCode
+parseArrayDimensions(const UA_String *s, size_t *dimsSize, UA_UInt32 **dims) {
+    UA_String t = trimString(*s);
+    if(t.length == 0)
+        return UA_STATUSCODE_GOOD;
+    size_t count = 1;
+    for(size_t i = 0; i < t.length; i++) {
+        if(t.data[i] == ',')
+            count++;
+    }
+    UA_UInt32 *d = (UA_UInt32*)UA_Array_new(count, &UA_TYPES[UA_TYPES_UINT32]);
+    if(!d)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    size_t pos = 0;
+    for(size_t i = 0; i < count; i++) {
+        UA_UInt64 v = 0;
+        size_t digits = 0;
+        while(pos < t.length && xmlIsSpace(t.data[pos]))
+            pos++;
+        while(pos < t.length && t.data[pos] >= '0' && t.data[pos] <= '9' && v <= UA_UINT32_MAX) {
+            v = v * 10 + (UA_UInt64)(t.data[pos] - '0');
+            pos++;
+            digits++;
+        }
+        while(pos < t.length && xmlIsSpace(t.data[pos]))
+            pos++;
+        if(digits == 0 || v > UA_UINT32_MAX ||
+           (pos < t.length && t.data[pos++] != ',')) {
+            UA_free(d);
+            return UA_STATUSCODE_BADDECODINGERROR;
+        }
+        d[i] = (UA_UInt32)v;
+    }
+    *dims = d;
+    *dimsSize = count;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Value types that are decoded from the XML content */
+static const struct {
+    const char *name;
+    UA_UInt16 typeIndex;
+} xmlValueTypes[] = {
+    {"Boolean", UA_TYPES_BOOLEAN}, {"SByte", UA_TYPES_SBYTE},
+    {"Byte", UA_TYPES_BYTE}, {"Int16", UA_TYPES_INT16},
+    {"UInt16", UA_TYPES_UINT16}, {"Int32", UA_TYPES_INT32},
+    {"UInt32", UA_TYPES_UINT32}, {"Int64", UA_TYPES_INT64},
+    {"UInt64", UA_TYPES_UINT64}, {"Float", UA_TYPES_FLOAT},
+    {"Double", UA_TYPES_DOUBLE}, {"String", UA_TYPES_STRING},
+    {"DateTime", UA_TYPES_DATETIME}, {"Guid", UA_TYPES_GUID},
+    {"ByteString", UA_TYPES_BYTESTRING}, {"NodeId", UA_TYPES_NODEID},
+    {"ExpandedNodeId", UA_TYPES_EXPANDEDNODEID},
+    {"StatusCode", UA_TYPES_STATUSCODE},
+    {"QualifiedName", UA_TYPES_QUALIFIEDNAME},
+    {"LocalizedText", UA_TYPES_LOCALIZEDTEXT}
+};
+
+static const UA_DataType *
+lookupValueType(const UA_String *name) {
+    for(size_t i = 0; i < sizeof(xmlValueTypes) / sizeof(xmlValueTypes[0]); i++) {
+        if(xmlNameEq(name, xmlValueTypes[i].name))
+            return &UA_TYPES[xmlValueTypes[i].typeIndex];
+    }
+    return NULL;
+}
+
+/* Decode the value from the text content or the fields of the element */
+static UA_StatusCode
+decodeValue(UA_NodesetXmlLoader *l, const UA_DataType *type,
+            const UA_String *text, void *dst) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_Int64 i = 0;
+    UA_UInt64 u = 0;
+    UA_Double d = 0.0;
+    switch(type->typeKind) {
+    case UA_DATATYPEKIND_BOOLEAN:
+        return parseBoolean(text, (UA_Boolean*)dst);
+    case UA_DATATYPEKIND_SBYTE:
+        res = parseInt64(text, UA_SBYTE_MIN, UA_SBYTE_MAX, &i);
+        *(UA_SByte*)dst = (UA_SByte)i;
+        return res;
+    case UA_DATATYPEKIND_INT16:
+        res = parseInt64(text, UA_INT16_MIN, UA_INT16_MAX, &i);
+        *(UA_Int16*)dst = (UA_Int16)i;
+        return res;
+    case UA_DATATYPEKIND_INT32:
+        res = parseInt64(text, UA_INT32_MIN, UA_INT32_MAX, &i);
+        *(UA_Int32*)dst = (UA_Int32)i;
+        return res;
+    case UA_DATATYPEKIND_INT64:
+        res = parseInt64(text, UA_INT64_MIN, UA_INT64_MAX, &i);
+        *(UA_Int64*)dst = i;
+        return res;
+    case UA_DATATYPEKIND_BYTE:
+        res = parseUInt64(text, UA_BYTE_MAX, &u);
+        *(UA_Byte*)dst = (UA_Byte)u;
+        return res;
+    case UA_DATATYPEKIND_UINT16:
+        res = parseUInt64(text, UA_UINT16_MAX, &u);
+        *(UA_UInt16*)dst = (UA_UInt16)u;
+        return res;
+    case UA_DATATYPEKIND_UINT32:
+        res = parseUInt64(text, UA_UINT32_MAX, &u);
+        *(UA_UInt32*)dst = (UA_UInt32)u;
+        return res;
+    case UA_DATATYPEKIND_UINT64:
+        res = parseUInt64(text, UA_UINT64_MAX, &u);
+        *(UA_UInt64*)dst = u;
+        return res;
+    case UA_DATATYPEKIND_FLOAT:
+        res = parseDouble(text, &d);
+        *(UA_Float*)dst = (UA_Float)d;
+        return res;
+    case UA_DATATYPEKIND_DOUBLE:
+        return parseDouble(text, (UA_Double*)dst);
+    case UA_DATATYPEKIND_STRING:
+        return UA_String_copy(text, (UA_String*)dst);
+    case UA_DATATYPEKIND_DATETIME:
+        return parseDateTime(text, (UA_DateTime*)dst);
+    case UA_DATATYPEKIND_BYTESTRING: {
+        UA_String t = trimString(*text);
+        if(t.length == 0)
+            return UA_STATUSCODE_GOOD;
+        return UA_ByteString_fromBase64((UA_ByteString*)dst, &t);
+    }
+    case UA_DATATYPEKIND_GUID:
+        res = UA_Guid_parse((UA_Guid*)dst, trimString(l->fieldB));
+        return (res == UA_STATUSCODE_GOOD) ? res : UA_STATUSCODE_BADDECODINGERROR;
+    case UA_DATATYPEKIND_STATUSCODE:
+        res = parseUInt64(&l->fieldB, UA_UINT32_MAX, &u);
+        *(UA_StatusCode*)dst = (UA_StatusCode)u;
+        return res;
+    case UA_DATATYPEKIND_NODEID:
+        return parseNodeId(l, &l->fieldB, (UA_NodeId*)dst);
+    case UA_DATATYPEKIND_EXPANDEDNODEID:
+        return parseNodeId(l, &l->fieldB, &((UA_ExpandedNodeId*)dst)->nodeId);
+    case UA_DATATYPEKIND_QUALIFIEDNAME: {
+        UA_QualifiedName *qn = (UA_QualifiedName*)dst;
+        if(l->fieldA.length > 0) {
+            res = parseUInt64(&l->fieldA, UA_UINT16_MAX, &u);
+            qn->namespaceIndex = (UA_UInt16)u;
+            res |= mapNamespace(l, &qn->namespaceIndex);
+            if(res != UA_STATUSCODE_GOOD)
+                return UA_STATUSCODE_BADDECODINGERROR;
+        }
+        return UA_String_copy(&l->fieldB, &qn->name);
+    }
+    case UA_DATATYPEKIND_LOCALIZEDTEXT: {
+        UA_LocalizedText *lt = (UA_LocalizedText*)dst;
+        res = UA_String_copy(&l->fieldA, &lt->locale);
+        res |= UA_String_copy(&l->fieldB, &lt->text);
+        return res;
+    }
+    default:
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+}
+
+static UA_StatusCode
+valueStart(UA_NodesetXmlLoader *l, const UA_String *name) {
+    size_t d = l->depth;
+
+    /* The element below Value defines the type */
+    if(d == l->valueDepth + 1) {
+        if(l->valueDone) {
+            l->skipDepth = d;
+            return UA_STATUSCODE_GOOD;
+        }
+        UA_String typeName = *name;
+        l->valueArray = (name->length > 6 && memcmp(name->data, "ListOf", 6) == 0);
+        if(l->valueArray) {
+            typeName.data += 6;
+            typeName.length -= 6;
+        }
+        l->valueType = lookupValueType(&typeName);
+        if(!l->valueType) {
+            /* ExtensionObject, XmlElement, ... */
+            l->valueDone = true;
+            l->skipDepth = d;
+            return UA_STATUSCODE_GOOD;
+        }
+        l->valueElemDepth = l->valueArray ? d + 1 : d;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Fields of the element */
+    if(d == l->valueElemDepth + 1) {
+        if(xmlNameEq(name, "Locale") || xmlNameEq(name, "NamespaceIndex"))
+            l->valueField = &l->fieldA;
+        else if(xmlNameEq(name, "Text") || xmlNameEq(name, "Name") ||
+                xmlNameEq(name, "Identifier") || xmlNameEq(name, "String") ||
+                xmlNameEq(name, "Code"))
+            l->valueField = &l->fieldB;
+        else
+            l->skipDepth = d;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Array element */
+    if(d != l->valueElemDepth)
+        l->skipDepth = d;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+valueEnd(UA_NodesetXmlLoader *l, size_t d, UA_String *text) {
+    /* Field content */
+    if(d == l->valueElemDepth + 1) {
+        if(!l->valueField)
+            return UA_STATUSCODE_GOOD;
+        UA_String_clear(l->valueField);
+        UA_StatusCode res = UA_String_copy(text, l->valueField);
+        l->valueField = NULL;
+        return res;
+    }
+
+    /* Decode the element */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    const UA_DataType *type = l->valueType;
+    if(d == l->valueElemDepth) {
+        if(!l->valueArray) {
+            void *v = UA_new(type);
+            if(!v)
+                return UA_STATUSCODE_BADOUTOFMEMORY;
+            res = decodeValue(l, type, text, v);
+            if(res != UA_STATUSCODE_GOOD) {
+                UA_delete(v, type);
+                return res;
+            }
+            UA_Variant_setScalar(l->valueTarget, v, type);
+            l->valueDone = true;
+        } else {
+            res = growArray(&l->valueArr, &l->valueArrCap,
+                            l->valueArrSize, type->memSize);
+            if(res != UA_STATUSCODE_GOOD)
+                return res;
+            void *v = (void*)((uintptr_t)l->valueArr + l->valueArrSize * type->memSize);
+            UA_init(v, type);
+            res = decodeValue(l, type, text, v);
+            if(res != UA_STATUSCODE_GOOD) {
+                UA_clear(v, type);
+                return res;
+            }
+            l->valueArrSize++;
+        }
+        UA_String_clear(&l->fieldA);
+        UA_String_clear(&l->fieldB);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* End of the ListOf element */
+    if(l->valueArray && d == l->valueDepth + 1) {
+        if(l->valueArrSize > 0) {
+            UA_Variant_setArray(l->valueTarget, l->valueArr, l->valueArrSize, type);
+        } else {
+            UA_free(l->valueArr);
+            UA_Variant_setArray(l->valueTarget, UA_EMPTY_ARRAY_SENTINEL, 0, type);
+        }
+        l->valueArr = NULL;
+        l->valueArrSize = 0;
+        l->valueDone = true;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/*********************/
+/* Node Construction */
+/*********************/
+
+static const struct {
+    const char *name;
+    UA_NodeClass nodeClass;
+    UA_UInt16 attributesType;
+} xmlNodeClasses[] = {
+    {"UAObject", UA_NODECLASS_OBJECT, UA_TYPES_OBJECTATTRIBUTES},
+    {"UAVariable", UA_NODECLASS_VARIABLE, UA_TYPES_VARIABLEATTRIBUTES},
+    {"UAMethod", UA_NODECLASS_METHOD, UA_TYPES_METHODATTRIBUTES},
+    {"UAObjectType", UA_NODECLASS_OBJECTTYPE, UA_TYPES_OBJECTTYPEATTRIBUTES},
+    {"UAVariableType", UA_NODECLASS_VARIABLETYPE, UA_TYPES_VARIABLETYPEATTRIBUTES},
+    {"UADataType", UA_NODECLASS_DATATYPE, UA_TYPES_DATATYPEATTRIBUTES},
+    {"UAReferenceType", UA_NODECLASS_REFERENCETYPE, UA_TYPES_REFERENCETYPEATTRIBUTES},
+    {"UAView", UA_NODECLASS_VIEW, UA_TYPES_VIEWATTRIBUTES}
+};
+
+#define UA_XML_NODECLASSES (sizeof(xmlNodeClasses) / sizeof(xmlNodeClasses[0]))
+
+static UA_StatusCode
+parseNodeAttribute(UA_NodesetXmlLoader *l, UA_XmlNode *xn, const UA_XmlAttribute *a) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_Int64 i = 0;
+    UA_UInt64 u = 0;
+    const UA_String *n = &a->name;
+    const UA_String *v = &a->value;
+    UA_NodeClass nc = xn->nodeClass;
+    UA_Boolean variable = (nc == UA_NODECLASS_VARIABLE || nc == UA_NODECLASS_VARIABLETYPE);
+
+    if(xmlNameEq(n, "NodeId")) {
+        UA_NodeId_clear(&xn->nodeId);
+        return parseNodeId(l, v, &xn->nodeId);
+    }
+    if(xmlNameEq(n, "BrowseName")) {
+        UA_QualifiedName_clear(&xn->browseName);
+        return parseQualifiedName(l, v, &xn->browseName);
+    }
+    if(xmlNameEq(n, "WriteMask")) {
+        res = parseUInt64(v, UA_UINT32_MAX, &u);
+        xn->attr.node.writeMask = (UA_UInt32)u;
+        return res;
+    }
+    if(xmlNameEq(n, "UserWriteMask")) {
+        res = parseUInt64(v, UA_UINT32_MAX, &u);
+        xn->attr.node.userWriteMask = (UA_UInt32)u;
+        return res;
+    }
+    if(xmlNameEq(n, "EventNotifier") &&
+       (nc == UA_NODECLASS_OBJECT || nc == UA_NODECLASS_VIEW)) {
+        res = parseUInt64(v, UA_BYTE_MAX, &u);
+        if(nc == UA_NODECLASS_OBJECT)
+            xn->attr.object.eventNotifier = (UA_Byte)u;
+        else
+            xn->attr.view.eventNotifier = (UA_Byte)u;
+        return res;
+    }
+    if(xmlNameEq(n, "IsAbstract")) {
+        switch(nc) {
+        case UA_NODECLASS_OBJECTTYPE:
+            return parseBoolean(v, &xn->attr.objectType.isAbstract);
+        case UA_NODECLASS_VARIABLETYPE:
+            return parseBoolean(v, &xn->attr.variableType.isAbstract);
+        case UA_NODECLASS_DATATYPE:
+            return parseBoolean(v, &xn->attr.dataType.isAbstract);
+        case UA_NODECLASS_REFERENCETYPE:
+            return parseBoolean(v, &xn->attr.referenceType.isAbstract);
+        default:
+            return UA_STATUSCODE_GOOD;
+        }
+    }
+    if(nc == UA_NODECLASS_REFERENCETYPE && xmlNameEq(n, "Symmetric"))
+        return parseBoolean(v, &xn->attr.referenceType.symmetric);
+    if(nc == UA_NODECLASS_VIEW && xmlNameEq(n, "ContainsNoLoops"))
+        return parseBoolean(v, &xn->attr.view.containsNoLoops);
+    if(nc == UA_NODECLASS_METHOD && xmlNameEq(n, "Executable"))
+        return parseBoolean(v, &xn->attr.method.executable);
+    if(nc == UA_NODECLASS_METHOD && xmlNameEq(n, "UserExecutable"))
+        return parseBoolean(v, &xn->attr.method.userExecutable);
+
+    /* The common attributes of Variable and VariableType have the same layout */
+    if(!variable)
+        return UA_STATUSCODE_GOOD;
+    UA_VariableAttributes *va = &xn->attr.variable;
+    if(xmlNameEq(n, "DataType")) {
+        UA_NodeId_clear(&va->dataType);
+        return parseNodeId(l, v, &va->dataType);
+    }
+    if(xmlNameEq(n, "ValueRank")) {
+        res = parseInt64(v, UA_INT32_MIN, UA_INT32_MAX, &i);
+        va->valueRank = (UA_Int32)i;
+        return res;
+    }
+    if(xmlNameEq(n, "ArrayDimensions")) {
+        UA_Array_delete(va->arrayDimensions, va->arrayDimensionsSize,
+                        &UA_TYPES[UA_TYPES_UINT32]);
+        va->arrayDimensions = NULL;
+        va->arrayDimensionsSize = 0;
+        return parseArrayDimensions(v, &va->arrayDimensionsSize, &va->arrayDimensions);
+    }
+    if(nc != UA_NODECLASS_VARIABLE)
+        return UA_STATUSCODE_GOOD;
+    if(xmlNameEq(n, "AccessLevel")) {
+        res = parseUInt64(v, UA_BYTE_MAX, &u);
+        va->accessLevel = (UA_Byte)u;
+        return res;
+    }
+    if(xmlNameEq(n, "UserAccessLevel")) {
+        res = parseUInt64(v, UA_BYTE_MAX, &u);
+        va->userAccessLevel = (UA_Byte)u;
+        return res;
+    }
+    if(xmlNameEq(n, "MinimumSamplingInterval"))
+        return parseDouble(v, &va->minimumSamplingInterval);
+    if(xmlNameEq(n, "Historizing"))
+        return parseBoolean(v, &va->historizing);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+nodeStart(UA_NodesetXmlLoader *l, size_t nc, UA_XmlAttribute *attrs, size_t attrsSize) {
+    UA_XmlNode *xn = &l->nodes[l->nodesSize];
+    memset(xn, 0, sizeof(UA_XmlNode));
+    xn->nodeClass = xmlNodeClasses[nc].nodeClass;
+    xn->attributesType = &UA_TYPES[xmlNodeClasses[nc].attributesType];
+
+    /* Defaults of the NodeSet2 schema */
+    switch(xn->nodeClass) {
+    case UA_NODECLASS_VARIABLE:
+        xn->attr.variable.accessLevel = UA_ACCESSLEVELMASK_READ;
+        xn->attr.variable.userAccessLevel = UA_ACCESSLEVELMASK_READ;
+        /* fallthrough */
+    case UA_NODECLASS_VARIABLETYPE:
+        xn->attr.variable.valueRank = UA_VALUERANK_SCALAR;
+        xn->attr.variable.dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATATYPE);
+        break;
+    case UA_NODECLASS_METHOD:
+        xn->attr.method.executable = true;
+        xn->attr.method.userExecutable = true;
+        break;
+    default:
+        break;
+    }
+
+    l->inNode = true;
+    l->hasDisplayName = false;
+    l->hasDescription = false;
+    l->hasInverseName = false;
+
+    for(size_t i = 0; i < attrsSize; i++) {
+        UA_StatusCode res = parseNodeAttribute(l, xn, &attrs[i]);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_LOG_WARNING(&l->server->config.logger, UA_LOGCATEGORY_SERVER,
+                           "NodeSet2 XML: Invalid attribute %.*s=\"%.*s\"",
+                           (int)attrs[i].name.length, attrs[i].name.data,
+                           (int)attrs[i].value.length, attrs[i].value.data);
+            return res;
+        }
+    }
+
+    if(UA_NodeId_isNull(&xn->nodeId) || xn->browseName.name.length == 0) {
+        UA_LOG_WARNING(&l->server->config.logger, UA_LOGCATEGORY_SERVER,
+                       "NodeSet2 XML: Node without a NodeId or BrowseName");
+        return UA_STATUSCODE_BADDECODINGERROR;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+localizedTextEnd(UA_NodesetXmlLoader *l, UA_LocalizedText *lt,
+                 UA_Boolean *done, const UA_String *text) {
+    if(*done) {
+        /* Only the first translation is used */
+        UA_String_clear(&l->locale);
+        return UA_STATUSCODE_GOOD;
+    }
+    *done = true;
+    UA_LocalizedText_clear(lt);
+    lt->locale = l->locale;
+    UA_String_init(&l->locale);
+    return UA_String_copy(text, &lt->text);
+}
+
+static UA_StatusCode
+referenceEnd(UA_NodesetXmlLoader *l, const UA_String *text) {
+    UA_XmlNode *xn = &l->nodes[l->nodesSize];
+    UA_StatusCode res = parseNodeId(l, text, &l->currentRef.targetId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(&l->server->config.logger, UA_LOGCATEGORY_SERVER,
+                       "NodeSet2 XML: Invalid reference target %.*s",
+                       (int)text->length, text->data);
+        return res;
+    }
+    UA_XmlReference *refs = (UA_XmlReference*)
+        UA_realloc(xn->refs, (xn->refsSize + 1) * sizeof(UA_XmlReference));
+    if(!refs)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    xn->refs = refs;
+    refs[xn->refsSize++] = l->currentRef;
+    memset(&l->currentRef, 0, sizeof(UA_XmlReference));
+    return UA_STATUSCODE_GOOD;
+}
+
+/*************/
+/* Insertion */
+/*************/
+
+static UA_Boolean
+getRefTypeIndex(UA_NodesetXmlLoader *l, const UA_NodeId *refTypeId, UA_Byte *index) {
+    for(size_t i = 0; i < l->refTypeIndicesSize; i++) {
+        if(UA_NodeId_equal(&l->refTypeIndices[i].refTypeId, refTypeId)) {
+            *index = l->refTypeIndices[i].refTypeIndex;
+            return true;
+        }
+    }
+
+    const UA_Node *refType = UA_NODESTORE_GET(l->server, refTypeId);
+    if(!refType)
+        return false;
+    if(refType->head.nodeClass != UA_NODECLASS_REFERENCETYPE) {
+        UA_NODESTORE_RELEASE(l->server, refType);
+        return false;
+    }
+    *index = refType->referenceTypeNode.referenceTypeIndex;
+    UA_NODESTORE_RELEASE(l->server, refType);
+
+    /* Add to the cache */
+    UA_XmlRefTypeIndex *c = (UA_XmlRefTypeIndex*)
+        UA_realloc(l->refTypeIndices,
+                   (l->refTypeIndicesSize + 1) * sizeof(UA_XmlRefTypeIndex));
+    if(!c)
+        return true;
+    l->refTypeIndices = c;
+    if(UA_NodeId_copy(refTypeId, &c[l->refTypeIndicesSize].refTypeId) == UA_STATUSCODE_GOOD)
+        c[l->refTypeIndicesSize++].refTypeIndex = *index;
+    return true;
+}
+
+struct UA_XmlReverseReference {
+    UA_Byte refTypeIndex;
+    UA_Boolean isForward;
+    const UA_ExpandedNodeId *targetNodeId;
+    UA_UInt32 targetBrowseNameHash;
+};
+
+static UA_StatusCode
+addReverseReference(UA_Server *server, UA_Session *session, UA_Node *node,
+                    const struct UA_XmlReverseReference *info) {
+    return UA_Node_addReference(node, info->refTypeIndex, info->isForward,
+                                info->targetNodeId, info->targetBrowseNameHash);
+}
+
+static void
+setResult(UA_NodesetXmlLoader *l, UA_StatusCode res) {
+    if(l->result == UA_STATUSCODE_GOOD)
+        l->result = res;
+}
+
+static enum aa_cmp
+cmpPendingTarget(const void *a, const void *b) {
+    return (enum aa_cmp)UA_NodeId_order((const UA_NodeId*)a, (const UA_NodeId*)b);
+}
+
+static void
+deletePendingTarget(UA_XmlPendingTarget *pt) {
+    UA_XmlPendingReference *p, *next = pt->refs;
+    while((p = next)) {
+        next = p->next;
+        UA_NodeId_clear(&p->sourceId);
+        UA_NodeId_clear(&p->refTypeId);
+        UA_free(p);
+    }
+    UA_NodeId_clear(&pt->targetId);
+    UA_free(pt);
+}
+
+/* Append to the pending references of the target. Takes the ReferenceType and
+ * the target NodeId of the reference. */
+static UA_StatusCode
+addPendingReference(UA_NodesetXmlLoader *l, const UA_NodeId *sourceId,
+                    UA_XmlReference *r) {
+    UA_XmlPendingReference *p = (UA_XmlPendingReference*)
+        UA_malloc(sizeof(UA_XmlPendingReference));
+    if(!p)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = UA_NodeId_copy(sourceId, &p->sourceId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(p);
+        return res;
+    }
+
+    UA_XmlPendingTarget *pt = (UA_XmlPendingTarget*)aa_find(&l->pending, &r->targetId);
+    if(!pt) {
+        pt = (UA_XmlPendingTarget*)UA_calloc(1, sizeof(UA_XmlPendingTarget));
+        if(!pt) {
+            UA_NodeId_clear(&p->sourceId);
+            UA_free(p);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        pt->targetId = r->targetId;
+        UA_NodeId_init(&r->targetId);
+        aa_insert(&l->pending, pt);
+    }
+
+    p->next = NULL;
+    p->refTypeId = r->refTypeId;
+    p->isForward = r->isForward;
+    UA_NodeId_init(&r->refTypeId);
+    if(pt->lastRef)
+        pt->lastRef->next = p;
+    else
+        pt->refs = p;
+    pt->lastRef = p;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Insert the node directly into the nodestore. References to nodes that exist
+ * already are added in both directions. The other references are added after
+ * the batch of the target node has been inserted. */
+static void
+insertNode(UA_NodesetXmlLoader *l, UA_XmlNode *xn) {
+    UA_Server *server = l->server;
+    UA_Node *node = UA_NODESTORE_NEW(server, xn->nodeClass);
+    if(!node) {
+        setResult(l, UA_STATUSCODE_BADOUTOFMEMORY);
+        return;
+    }
+    UA_StatusCode res = UA_NodeId_copy(&xn->nodeId, &node->head.nodeId);
+    node->head.browseName = xn->browseName;
+    UA_QualifiedName_init(&xn->browseName);
+    res |= UA_Node_setAttributes(node, &xn->attr, xn->attributesType);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_NODESTORE_DELETE(server, node);
+        setResult(l, res);
+        return;
+    }
+
+    /* Forward direction to the existing targets */
+    for(size_t i = 0; i < xn->refsSize; i++) {
+        UA_XmlReference *r = &xn->refs[i];
+        if(!getRefTypeIndex(l, &r->refTypeId, &r->refTypeIndex))
+            continue;
+        const UA_Node *target = UA_NODESTORE_GET(server, &r->targetId);
+        if(!target)
+            continue;
+        UA_UInt32 targetHash = UA_QualifiedName_hash(&target->head.browseName);
+        UA_NODESTORE_RELEASE(server, target);
+        UA_ExpandedNodeId targetId;
+        UA_ExpandedNodeId_init(&targetId);
+        targetId.nodeId = r->targetId;
+        res = UA_Node_addReference(node, r->refTypeIndex, r->isForward,
+                                   &targetId, targetHash);
+        if(res == UA_STATUSCODE_BADDUPLICATEREFERENCENOTALLOWED)
+            res = UA_STATUSCODE_GOOD;
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_NODESTORE_DELETE(server, node);
+            setResult(l, res);
+            return;
+        }
+        r->added = true;
+    }
+
+    /* Insert. The node is deleted by the nodestore upon failure. */
+    UA_UInt32 sourceHash = UA_QualifiedName_hash(&node->head.browseName);
+    res = UA_NODESTORE_INSERT(server, node, NULL);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_NODEID_WARNING(&xn->nodeId,
+            UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                           "NodeSet2 XML: Could not add the node %.*s (%s)",
+                           (int)nodeIdStr.length, nodeIdStr.data,
+                           UA_StatusCode_name(res)));
+        setResult(l, res);
+        return;
+    }
+
+    /* Reverse direction */
+    UA_ExpandedNodeId sourceId;
+    UA_ExpandedNodeId_init(&sourceId);
+    sourceId.nodeId = xn->nodeId;
+    struct UA_XmlReverseReference info;
+    info.targetNodeId = &sourceId;
+    info.targetBrowseNameHash = sourceHash;
+    for(size_t i = 0; i < xn->refsSize; i++) {
+        UA_XmlReference *r = &xn->refs[i];
+        if(r->added) {
+            info.refTypeIndex = r->refTypeIndex;
+            info.isForward = !r->isForward;
+            res = UA_Server_editNodeKeepShared(server, &server->adminSession,
+                                               &r->targetId,
+                                               (UA_EditNodeCallback)addReverseReference,
+                                               &info);
+            if(res != UA_STATUSCODE_GOOD &&
+               res != UA_STATUSCODE_BADDUPLICATEREFERENCENOTALLOWED)
+                setResult(l, res);
+            continue;
+        }
+
+        /* Move to the pending references */
+        res = addPendingReference(l, &xn->nodeId, r);
+        if(res != UA_STATUSCODE_GOOD)
+            setResult(l, res);
+    }
+
+    /* Remember the node for the deferred checks */
+    res = growArray((void**)&l->loaded, &l->loadedCap, l->loadedSize,
+                    sizeof(UA_XmlLoadedNode));
+    if(res != UA_STATUSCODE_GOOD) {
+        setResult(l, res);
+        return;
+    }
+    l->loaded[l->loadedSize].nodeId = xn->nodeId;
+    l->loaded[l->loadedSize].nodeClass = xn->nodeClass;
+    UA_NodeId_init(&xn->nodeId);
+    l->loadedSize++;
+}
+
+/* Add the pending references to the target. Retained are only the references
+ * that cannot be added yet. In the final pass, they are logged instead. */
+static void
+addPendingTarget(UA_NodesetXmlLoader *l, UA_XmlPendingTarget *pt,
+                 UA_Boolean final) {
+    UA_ExpandedNodeId targetId;
+    UA_ExpandedNodeId_init(&targetId);
+    targetId.nodeId = pt->targetId;
+    UA_XmlPendingReference **next = &pt->refs;
+    UA_XmlPendingReference *p;
+    pt->lastRef = NULL;
+    while((p = *next)) {
+        UA_StatusCode res = UA_Server_addReference(l->server, p->sourceId, p->refTypeId,
+                                                   targetId, p->isForward);
+        /* Both directions were already added from the other side */
+        if(res != UA_STATUSCODE_GOOD &&
+           res != UA_STATUSCODE_BADDUPLICATEREFERENCENOTALLOWED) {
+            if(!final) {
+                pt->lastRef = p;
+                next = &p->next;
+                continue;
+            }
+            /* References into namespaces that are not loaded are common. So
+             * this is not an error of the loading. */
+            UA_LOG_NODEID_WARNING(&p->sourceId,
+                UA_LOG_WARNING(&l->server->config.logger, UA_LOGCATEGORY_SERVER,
+                               "NodeSet2 XML: Could not add a reference of the "
+                               "node %.*s (%s)", (int)nodeIdStr.length, nodeIdStr.data,
+                               UA_StatusCode_name(res)));
+        }
+        *next = p->next;
+        UA_NodeId_clear(&p->sourceId);
+        UA_NodeId_clear(&p->refTypeId);
+        UA_free(p);
+    }
+}
+
+/* Add the pending references to the nodes inserted since loadedStart. The
+ * references to other targets are not retried. Their target is not defined
+ * yet or the ReferenceType was missing. This is left to the final pass. */
+static void
+addPendingReferences(UA_NodesetXmlLoader *l, size_t loadedStart) {
+    for(size_t i = loadedStart; i < l->loadedSize; i++) {
+        UA_XmlPendingTarget *pt = (UA_XmlPendingTarget*)
+            aa_find(&l->pending, &l->loaded[i].nodeId);
+        if(!pt)
+            continue;
+        addPendingTarget(l, pt, false);
+        if(pt->refs)
+            continue;
+        aa_remove(&l->pending, pt);
+        deletePendingTarget(pt);
+    }
+}
+
+/* Final pass after the document has been read */
+static void
+addRemainingReferences(UA_NodesetXmlLoader *l) {
+    UA_XmlPendingTarget *pt;
+    while((pt = (UA_XmlPendingTarget*)aa_min(&l->pending))) {
+        aa_remove(&l->pending, pt);
+        addPendingTarget(l, pt, true);
+        deletePendingTarget(pt);
+    }
+}
+
+static void
+insertBatch(UA_NodesetXmlLoader *l) {
+    size_t loadedStart = l->loadedSize;
+    UA_LOCK(&l->server->serviceMutex);
+    for(size_t i = 0; i < l->nodesSize; i++) {
+        insertNode(l, &l->nodes[i]);
+        clearXmlNode(&l->nodes[i]);
+    }
+    UA_UNLOCK(&l->server->serviceMutex);
+    l->nodesSize = 0;
+    addPendingReferences(l, loadedStart);
+}
+
+/***************/
+/* SAX Handler */
+/***************/
+
+static UA_StatusCode
+startElement(UA_NodesetXmlLoader *l, const UA_String *name,
+             UA_XmlAttribute *attrs, size_t attrsSize) {
+    l->depth++;
+    if(l->skipDepth > 0)
+        return UA_STATUSCODE_GOOD;
+
+    size_t d = l->depth;
+    if(d == 1)
+        return xmlNameEq(name, "UANodeSet") ?
+            UA_STATUSCODE_GOOD : UA_STATUSCODE_BADDECODINGERROR;
+
+    if(d == 2) {
+        if(xmlNameEq(name, "NamespaceUris")) {
+            l->section = UA_XMLSECTION_NAMESPACEURIS;
+            return UA_STATUSCODE_GOOD;
+        }
+        if(xmlNameEq(name, "Aliases")) {
+            l->section = UA_XMLSECTION_ALIASES;
+            return UA_STATUSCODE_GOOD;
+        }
+        for(size_t i = 0; i < UA_XML_NODECLASSES; i++) {
+            if(xmlNameEq(name, xmlNodeClasses[i].name)) {
+                l->section = UA_XMLSECTION_NODE;
+                return nodeStart(l, i, attrs, attrsSize);
+            }
+        }
+        /* Models, Extensions, ... */
+        l->skipDepth = d;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    switch(l->section) {
+    case UA_XMLSECTION_NAMESPACEURIS:
+        if(d != 3 || !xmlNameEq(name, "Uri"))
+            l->skipDepth = d;
+        return UA_STATUSCODE_GOOD;
+
+    case UA_XMLSECTION_ALIASES:
+        if(d != 3 || !xmlNameEq(name, "Alias")) {
+            l->skipDepth = d;
+            return UA_STATUSCODE_GOOD;
+        }
+        UA_String_clear(&l->currentAlias);
+        for(size_t i = 0; i < attrsSize; i++) {
+            if(xmlNameEq(&attrs[i].name, "Alias"))
+                return UA_String_copy(&attrs[i].value, &l->currentAlias);
+        }
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    case UA_XMLSECTION_NODE:
+        if(d == 3) {
+            if(xmlNameEq(name, "DisplayName") || xmlNameEq(name, "Description") ||
+               xmlNameEq(name, "InverseName")) {
+                UA_String_clear(&l->locale);
+                for(size_t i = 0; i < attrsSize; i++) {
+                    if(xmlNameEq(&attrs[i].name, "Locale"))
+                        return UA_String_copy(&attrs[i].value, &l->locale);
+                }
+                return UA_STATUSCODE_GOOD;
+            }
+            if(xmlNameEq(name, "References")) {
+                l->inReferences = true;
+                return UA_STATUSCODE_GOOD;
+            }
+            UA_XmlNode *xn = &l->nodes[l->nodesSize];
+            if(xmlNameEq(name, "Value") &&
+               (xn->nodeClass == UA_NODECLASS_VARIABLE ||
+                xn->nodeClass == UA_NODECLASS_VARIABLETYPE)) {
+                clearValueState(l);
+                l->valueTarget = &xn->attr.variable.value;
+                l->valueDepth = d;
+                return UA_STATUSCODE_GOOD;
+            }
+            /* Definition, Extensions, RolePermissions, ... */
+            l->skipDepth = d;
+            return UA_STATUSCODE_GOOD;
+        }
+        if(d == 4 && l->inReferences) {
+            if(!xmlNameEq(name, "Reference")) {
+                l->skipDepth = d;
+                return UA_STATUSCODE_GOOD;
+            }
+            memset(&l->currentRef, 0, sizeof(UA_XmlReference));
+            l->currentRef.isForward = true;
+            UA_Boolean hasType = false;
+            for(size_t i = 0; i < attrsSize; i++) {
+                UA_StatusCode res = UA_STATUSCODE_GOOD;
+                if(xmlNameEq(&attrs[i].name, "ReferenceType")) {
+                    res = parseNodeId(l, &attrs[i].value, &l->currentRef.refTypeId);
+                    hasType = true;
+                } else if(xmlNameEq(&attrs[i].name, "IsForward")) {
+                    res = parseBoolean(&attrs[i].value, &l->currentRef.isForward);
+                }
+                if(res != UA_STATUSCODE_GOOD) {
+                    UA_LOG_WARNING(&l->server->config.logger, UA_LOGCATEGORY_SERVER,
+                                   "NodeSet2 XML: Invalid reference attribute "
+                                   "%.*s=\"%.*s\"",
+                                   (int)attrs[i].name.length, attrs[i].name.data,
+                                   (int)attrs[i].value.length, attrs[i].value.data);
+                    return res;
+                }
+            }
+            return hasType ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADDECODINGERROR;
+        }
+        if(l->valueDepth > 0)
+            return valueStart(l, name);
+        l->skipDepth = d;
+        return UA_STATUSCODE_GOOD;
+
+    default:
+        l->skipDepth = d;
+        return UA_STATUSCODE_GOOD;
+    }
+}
+
+static UA_StatusCode
+endElement(UA_NodesetXmlLoader *l, const UA_String *name, UA_String *text) {
+    if(l->depth == 0)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    size_t d = l->depth--;
+    if(l->skipDepth > 0) {
+        if(d == l->skipDepth)
+            l->skipDepth = 0;
+        return UA_STATUSCODE_GOOD;
+    }
+    if(d == 1)
+        return UA_STATUSCODE_GOOD;
+
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(d == 2) {
+        if(l->section == UA_XMLSECTION_ALIASES) {
+            qsort(l->aliases, l->aliasesSize, sizeof(UA_XmlAlias), compareAlias);
+        } else if(l->section == UA_XMLSECTION_NODE) {
+            l->inNode = false;
+            l->nodesSize++;
+            if(l->nodesSize == UA_NODESETXML_BATCHSIZE)
+                insertBatch(l);
+        }
+        l->section = UA_XMLSECTION_NONE;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    switch(l->section) {
+    case UA_XMLSECTION_NAMESPACEURIS: {
+        UA_String uri = trimString(*text);
+        uri.data[uri.length] = 0;
+        UA_UInt16 *nsMap = (UA_UInt16*)
+            UA_realloc(l->nsMap, (l->nsMapSize + 1) * sizeof(UA_UInt16));
+        if(!nsMap)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        l->nsMap = nsMap;
+        nsMap[l->nsMapSize++] = UA_Server_addNamespace(l->server, (const char*)uri.data);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    case UA_XMLSECTION_ALIASES: {
+        UA_XmlAlias *aliases = (UA_XmlAlias*)
+            UA_realloc(l->aliases, (l->aliasesSize + 1) * sizeof(UA_XmlAlias));
+        if(!aliases)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        l->aliases = aliases;
+        UA_XmlAlias *alias = &aliases[l->aliasesSize];
+        size_t aliasesSize = l->aliasesSize;
+        l->aliasesSize = 0; /* No recursive alias lookup */
+        res = parseNodeId(l, text, &alias->nodeId);
+        l->aliasesSize = aliasesSize;
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        alias->alias = l->currentAlias;
+        UA_String_init(&l->currentAlias);
+        l->aliasesSize++;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    case UA_XMLSECTION_NODE: {
+        UA_XmlNode *xn = &l->nodes[l->nodesSize];
+        if(d == 3) {
+            if(xmlNameEq(name, "DisplayName"))
+                return localizedTextEnd(l, &xn->attr.node.displayName,
+                                        &l->hasDisplayName, text);
+            if(xmlNameEq(name, "Description"))
+                return localizedTextEnd(l, &xn->attr.node.description,
+                                        &l->hasDescription, text);
+            if(xmlNameEq(name, "InverseName")) {
+                if(xn->nodeClass != UA_NODECLASS_REFERENCETYPE) {
+                    UA_String_clear(&l->locale);
+                    return UA_STATUSCODE_GOOD;
+                }
+                return localizedTextEnd(l, &xn->attr.referenceType.inverseName,
+                                        &l->hasInverseName, text);
+            }
+            if(xmlNameEq(name, "References"))
+                l->inReferences = false;
+            else if(l->valueDepth > 0)
+                clearValueState(l);
+            return UA_STATUSCODE_GOOD;
+        }
+        if(d == 4 && l->inReferences)
+            return referenceEnd(l, text);
+        if(l->valueDepth > 0) {
+            res = valueEnd(l, d, text);
+            if(res != UA_STATUSCODE_GOOD) {
+                UA_LOG_NODEID_WARNING(&xn->nodeId,
+                    UA_LOG_WARNING(&l->server->config.logger, UA_LOGCATEGORY_SERVER,
+                                   "NodeSet2 XML: Invalid value for the node %.*s",
+                                   (int)nodeIdStr.length, nodeIdStr.data));
+            }
+        }
+        return res;
+    }
+
+    default:
+        return UA_STATUSCODE_GOOD;
+    }
+}
+
+/*************/
+/* Tokenizer */
+/*************/
+
+static UA_StatusCode
+processTag(UA_NodesetXmlLoader *l) {
+    UA_XmlTokenizer *t = &l->tok;
+    UA_Byte *tag = t->tag;
+    size_t len = t->tagLen;
+    if(len == 0)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    /* Processing instruction or DOCTYPE */
+    if(tag[0] == '?' || tag[0] == '!')
+        return UA_STATUSCODE_GOOD;
+
+    /* End tag */
+    if(tag[0] == '/') {
+        size_t nameLen = 1;
+        while(nameLen < len && !xmlIsSpace(tag[nameLen]))
+            nameLen++;
+        UA_String name = xmlLocalName(&tag[1], nameLen - 1);
+        UA_String text;
+        text.length = t->textDecoded +
+            xmlDecodeEntities(&t->text[t->textDecoded], t->textLen - t->textDecoded);
+        text.data = t->text;
+        text.data[text.length] = 0;
+        UA_StatusCode res = endElement(l, &name, &text);
+        t->textLen = 0;
+        t->textDecoded = 0;
+        return res;
+    }
+
+    /* Start tag */
+    UA_Boolean selfClosing = (tag[len - 1] == '/');
+    if(selfClosing)
+        len--;
+    size_t pos = 0;
+    while(pos < len && !xmlIsSpace(tag[pos]))
+        pos++;
+    UA_String name = xmlLocalName(tag, pos);
+
+    UA_XmlAttribute attrs[UA_XML_MAXATTRIBUTES];
+    size_t attrsSize = 0;
+    while(true) {
+        while(pos < len && xmlIsSpace(tag[pos]))
+            pos++;
+        if(pos >= len)
+            break;
+        if(attrsSize == UA_XML_MAXATTRIBUTES)
+            return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+        UA_XmlAttribute *a = &attrs[attrsSize];
+        size_t nameStart = pos;
+        while(pos < len && tag[pos] != '=' && !xmlIsSpace(tag[pos]))
+            pos++;
+        a->name = xmlLocalName(&tag[nameStart], pos - nameStart);
+        while(pos < len && xmlIsSpace(tag[pos]))
+            pos++;
+        if(pos >= len || tag[pos] != '=')
+            return UA_STATUSCODE_BADDECODINGERROR;
+        pos++;
+        while(pos < len && xmlIsSpace(tag[pos]))
+            pos++;
+        if(pos >= len || (tag[pos] != '"' && tag[pos] != '\''))
+            return UA_STATUSCODE_BADDECODINGERROR;
+        UA_Byte quote = tag[pos++];
+        UA_Byte *valueEnd = (UA_Byte*)memchr(&tag[pos], quote, len - pos);
+        if(!valueEnd)
+            return UA_STATUSCODE_BADDECODINGERROR;
+        a->value.data = &tag[pos];
+        a->value.length = xmlDecodeEntities(&tag[pos], (size_t)(valueEnd - &tag[pos]));
+        a->value.data[a->value.length] = 0; /* Overwrites the quote at the latest */
+        pos = (size_t)(valueEnd - tag) + 1;
+        /* Namespace declarations are not attributes of the element */
+        if(a->name.data == &tag[nameStart] + 6 && memcmp(&tag[nameStart], "xmlns:", 6) == 0)
+            continue;
+        if(xmlNameEq(&a->name, "xmlns"))
+            continue;
+        attrsSize++;
+    }
+
+    UA_StatusCode res = startElement(l, &name, attrs, attrsSize);
+    t->textLen = 0;
+    t->textDecoded = 0;
+    if(res != UA_STATUSCODE_GOOD || !selfClosing)
+        return res;
+    UA_String empty = {0, t->text};
+    t->text[0] = 0;
+    return endElement(l, &name, &empty);
+}
+
+static UA_StatusCode
+processChunk(UA_NodesetXmlLoader *l, const UA_Byte *buf, size_t len) {
+    UA_XmlTokenizer *t = &l->tok;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    size_t pos = 0;
+    while(pos < len) {
+        UA_Byte c;
+        switch(t->state) {
+        case UA_XMLSTATE_TEXT: {
+            const UA_Byte *lt = (const UA_Byte*)memchr(&buf[pos], '<', len - pos);
+            size_t n = lt ? (size_t)(lt - &buf[pos]) : len - pos;
+            /* The text of skipped elements is not buffered */
+            if(n > 0 && l->skipDepth == 0) {
+                res = xmlReserve(&t->text, &t->textCap, t->textLen + n);
+                if(res != UA_STATUSCODE_GOOD)
+                    return res;
+                memcpy(&t->text[t->textLen], &buf[pos], n);
+                t->textLen += n;
+            }
+            pos += n;
+            if(lt) {
+                pos++;
+                t->state = UA_XMLSTATE_TAG;
+                t->tagLen = 0;
+                t->quote = 0;
+            }
+            break;
+        }
+
+        case UA_XMLSTATE_TAG:
+            /* Regular tags are copied in bulk up to the closing bracket.
+             * Comments and CDATA sections start with '!'. */
+            if(t->tagLen > 0 && t->tag[0] != '!') {
+                size_t start = pos;
+                for(; pos < len; pos++) {
+                    c = buf[pos];
+                    if(t->quote != 0) {
+                        if(c == t->quote)
+                            t->quote = 0;
+                    } else if(c == '"' || c == '\'') {
+                        t->quote = c;
+                    } else if(c == '>') {
+                        break;
+                    }
+                }
+                res = xmlReserve(&t->tag, &t->tagCap, t->tagLen + (pos - start));
+                if(res != UA_STATUSCODE_GOOD)
+                    return res;
+                memcpy(&t->tag[t->tagLen], &buf[start], pos - start);
+                t->tagLen += pos - start;
+                if(pos == len)
+                    break;
+                pos++;
+                res = processTag(l);
+                if(res != UA_STATUSCODE_GOOD)
+                    return res;
+                t->state = UA_XMLSTATE_TEXT;
+                break;
+            }
+            c = buf[pos++];
+            if(t->quote == 0 && c == '>') {
+                res = processTag(l);
+                if(res != UA_STATUSCODE_GOOD)
+                    return res;
+                t->state = UA_XMLSTATE_TEXT;
+                break;
+            }
+            res = xmlReserve(&t->tag, &t->tagCap, t->tagLen + 1);
+            if(res != UA_STATUSCODE_GOOD)
+                return res;
+            t->tag[t->tagLen++] = c;
+            if(t->quote != 0) {
+                if(c == t->quote)
+                    t->quote = 0;
+            } else if(c == '"' || c == '\'') {
+                t->quote = c;
+            } else if(t->tagLen == 3 && memcmp(t->tag, "!--", 3) == 0) {
+                t->state = UA_XMLSTATE_COMMENT;
+                t->marker = 0;
+            } else if(t->tagLen == 8 && memcmp(t->tag, "![CDATA[", 8) == 0) {
+                /* Decode the text before the CDATA section */
+                t->textLen = t->textDecoded +
+                    xmlDecodeEntities(&t->text[t->textDecoded],
+                                      t->textLen - t->textDecoded);
+                t->state = UA_XMLSTATE_CDATA;
+                t->marker = 0;
+            }
+            break;
+
+        case UA_XMLSTATE_COMMENT:
+            c = buf[pos++];
+            if(c == '>' && t->marker >= 2)
+                t->state = UA_XMLSTATE_TEXT;
+            else
+                t->marker = (c == '-') ? t->marker + 1 : 0;
+            break;
+
+        case UA_XMLSTATE_CDATA:
+            c = buf[pos++];
+            if(c == '>' && t->marker >= 2) {
+                t->textLen -= 2; /* Remove the "]]" */
+                t->textDecoded = t->textLen;
+                t->state = UA_XMLSTATE_TEXT;
+                break;
+            }
+            t->marker = (c == ']') ? t->marker + 1 : 0;
+            res = xmlReserve(&t->text, &t->textCap, t->textLen + 1);
+            if(res != UA_STATUSCODE_GOOD)
+                return res;
+            t->text[t->textLen++] = c;
+            break;
+
+        default:
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/***********************/
+/* Deferred Operations */
+/***********************/
+
+/* Remove the inserted nodes and their references from the existing nodes. The
+ * deferred checks have not run yet. So there are no instantiated children and
+ * no constructors were called. */
+static void
+removeLoadedNodes(UA_NodesetXmlLoader *l) {
+    UA_Server *server = l->server;
+    UA_LOCK(&server->serviceMutex);
+    for(size_t i = l->loadedSize; i > 0; i--) {
+        const UA_Node *node = UA_NODESTORE_GET(server, &l->loaded[i-1].nodeId);
+        if(!node)
+            continue;
+        removeIncomingReferences(server, &server->adminSession, &node->head);
+        UA_NODESTORE_RELEASE(server, node);
+        UA_NODESTORE_REMOVE(server, &l->loaded[i-1].nodeId);
+    }
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+/* Type-check and instantiate after all nodes and references are present.
+ * ReferenceTypes first, as the others may use them for the browsing. Then the
+ * types, as the instances are checked against them. */
+static void
+finishNodes(UA_NodesetXmlLoader *l) {
+    for(size_t pass = 0; pass < 3; pass++) {
+        for(size_t i = 0; i < l->loadedSize; i++) {
+            UA_NodeClass nc = l->loaded[i].nodeClass;
+            size_t nodePass = 2;
+            if(nc == UA_NODECLASS_REFERENCETYPE)
+                nodePass = 0;
+            else if(nc == UA_NODECLASS_DATATYPE || nc == UA_NODECLASS_OBJECTTYPE ||
+                    nc == UA_NODECLASS_VARIABLETYPE)
+                nodePass = 1;
+            if(nodePass != pass)
+                continue;
+            /* The node is removed upon failure */
+            UA_StatusCode res = UA_Server_addNode_finish(l->server, l->loaded[i].nodeId);
+            if(res != UA_STATUSCODE_GOOD) {
+                UA_LOG_NODEID_WARNING(&l->loaded[i].nodeId,
+                    UA_LOG_WARNING(&l->server->config.logger, UA_LOGCATEGORY_SERVER,
+                                   "NodeSet2 XML: The node %.*s was removed after a "
+                                   "failed check (%s)", (int)nodeIdStr.length,
+                                   nodeIdStr.data, UA_StatusCode_name(res)));
+                setResult(l, res);
+            }
+        }
+    }
+}
+
+static void
+clearLoader(UA_NodesetXmlLoader *l) {
+    xmlClearTokenizer(&l->tok);
+    clearValueState(l);
+    UA_free(l->nsMap);
+    for(size_t i = 0; i < l->aliasesSize; i++) {
+        UA_String_clear(&l->aliases[i].alias);
+        UA_NodeId_clear(&l->aliases[i].nodeId);
+    }
+    UA_free(l->aliases);
+    UA_String_clear(&l->currentAlias);
+    UA_String_clear(&l->locale);
+    UA_NodeId_clear(&l->currentRef.refTypeId);
+    UA_NodeId_clear(&l->currentRef.targetId);
+    if(l->nodes) {
+        /* Including the node that was in parsing */
+        size_t count = l->inNode ? l->nodesSize + 1 : l->nodesSize;
+        for(size_t i = 0; i < count; i++)
+            clearXmlNode(&l->nodes[i]);
+        UA_free(l->nodes);
+    }
+    for(size_t i = 0; i < l->refTypeIndicesSize; i++)
+        UA_NodeId_clear(&l->refTypeIndices[i].refTypeId);
+    UA_free(l->refTypeIndices);
+    UA_XmlPendingTarget *pt;
+    while((pt = (UA_XmlPendingTarget*)aa_min(&l->pending))) {
+        aa_remove(&l->pending, pt);
+        deletePendingTarget(pt);
+    }
+    for(size_t i = 0; i < l->loadedSize; i++)
+        UA_NodeId_clear(&l->loaded[i].nodeId);
+    UA_free(l->loaded);
+}
+
+UA_StatusCode
+UA_Server_loadNodesetXml(UA_Server *server, UA_NodesetXmlReadCallback read,
+                         void *readContext) {
+    if(!server || !read)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    UA_NodesetXmlLoader l;
+    memset(&l, 0, sizeof(UA_NodesetXmlLoader));
+    l.server = server;
+    aa_init(&l.pending, cmpPendingTarget, offsetof(UA_XmlPendingTarget, treeEntry),
+            offsetof(UA_XmlPendingTarget, targetId));
+    l.nodes = (UA_XmlNode*)UA_calloc(UA_NODESETXML_BATCHSIZE, sizeof(UA_XmlNode));
+    l.nsMap = (UA_UInt16*)UA_calloc(1, sizeof(UA_UInt16)); /* ns0 maps to ns0 */
+    l.nsMapSize = 1;
+    UA_Byte *chunk = (UA_Byte*)UA_malloc(UA_XML_CHUNKSIZE);
+    UA_StatusCode res = xmlReserve(&l.tok.text, &l.tok.textCap, 0);
+    res |= xmlReserve(&l.tok.tag, &l.tok.tagCap, 0);
+    if(!l.nodes || !l.nsMap || !chunk || res != UA_STATUSCODE_GOOD) {
+        UA_free(chunk);
+        clearLoader(&l);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    /* Parse and insert the nodes. The document may start with a BOM. */
+    UA_Boolean first = true;
+    size_t len;
+    while((len = read(readContext, chunk, UA_XML_CHUNKSIZE)) > 0) {
+        size_t offset = 0;
+        if(first && len >= 3 && chunk[0] == 0xEF && chunk[1] == 0xBB && chunk[2] == 0xBF)
+            offset = 3;
+        first = false;
+        res = processChunk(&l, &chunk[offset], len - offset);
+        if(res != UA_STATUSCODE_GOOD)
+            break;
+    }
+    UA_free(chunk);
+    if(res == UA_STATUSCODE_GOOD &&
+       (l.depth != 0 || l.tok.state != UA_XMLSTATE_TEXT || first))
+        res = UA_STATUSCODE_BADDECODINGERROR; /* Truncated document */
+
+    /* Roll back the nodes inserted so far */
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                       "NodeSet2 XML: Could not parse the document (%s). "
+                       "Removing the loaded nodes.", UA_StatusCode_name(res));
+        removeLoadedNodes(&l);
+        clearLoader(&l);
+        return res;
+    }
+
+    /* Insert the remaining nodes. Then the deferred references and checks. */
+    if(l.nodesSize > 0)
+        insertBatch(&l);
+    addRemainingReferences(&l);
+    finishNodes(&l);
+
+    if(res == UA_STATUSCODE_GOOD)
+        res = l.result;
+    clearLoader(&l);
+    return res;
+}
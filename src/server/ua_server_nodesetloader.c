@@ -0,0 +1,842 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ua_server_internal.h"
+
+/* Run the loaders of a wave in parallel threads */
+#if UA_MULTITHREADING >= 100 && defined(UA_ARCHITECTURE_POSIX)
+#define UA_NODESETLOADER_THREADS
+#endif
+
+/*********************/
+/* Staging Nodestore */
+/*********************/
+
+/* The staging nodestore is an overlay over the nodestore of the server. Nodes
+ * that are not found in the overlay are read from the server nodestore. New
+ * nodes are kept in the overlay until they are published. Edits of server
+ * nodes create a "shadow" copy in the overlay. The node memory is always
+ * allocated by the server nodestore. So new nodes can be inserted there
+ * without another copy.
+ *
+ * The staging server edits the nodes of the server nodestore on a copy
+ * (copyOnEdit). The edited copy becomes a shadow in the overlay. So the nodes
+ * of the server nodestore are never modified in-situ and a failed wave leaves
+ * no trace. Staged nodes are edited in-situ.
+ *
+ * Several staging nodestores of the same wave access the server nodestore
+ * concurrently. The accesses are serialized with a shared lock. The server
+ * nodestore is not modified during the wave, so the returned nodes can be
+ * read without holding the lock.
+ *
+ * The server nodestore assigns the ReferenceTypeIndex of a new ReferenceType
+ * upon insertion. But the index is needed right away for the references. So
+ * the indices of the new ReferenceTypes are allocated for all staging
+ * nodestores of a wave, starting after the last index in use by the server
+ * nodestore. The ReferenceTypes of a wave are published first and in the order
+ * of their index. Then the server nodestore assigns the same indices. */
+
+typedef struct UA_RetiredNode {
+    struct UA_RetiredNode *next;
+    UA_Node *node;
+} UA_RetiredNode;
+
+typedef struct {
+    struct aa_entry treeEntry;
+    UA_NodeId nodeId;         /* Key of the tree */
+    UA_Node *node;            /* Current version. NULL if removed. */
+    UA_RetiredNode *retired;  /* Replaced versions that are still in use */
+    size_t refCount;          /* Number of getNode without a release */
+    UA_Boolean shadow;        /* Shadows a node from the server nodestore */
+} UA_StagingEntry;
+
+typedef struct UA_StagingNodestore UA_StagingNodestore;
+
+/* ReferenceTypes that are staged in the current wave */
+typedef struct {
+    UA_Boolean initialized; /* The first index is looked up lazily */
+    UA_Byte firstIndex;     /* First index after the server ReferenceTypes */
+    UA_Byte nextIndex;
+    UA_NodeId ids[UA_REFERENCETYPESET_MAX];
+    UA_StagingNodestore *owners[UA_REFERENCETYPESET_MAX];
+} UA_StagingReferenceTypes;
+
+struct UA_StagingNodestore {
+    struct aa_head nodes;
+    UA_Nodestore *base;
+    UA_StagingReferenceTypes *refTypes; /* Shared in the wave */
+#if UA_MULTITHREADING >= 100
+    UA_Lock *baseLock;
+#endif
+};
+
+static enum aa_cmp
+cmpStagingNodeId(const void *a, const void *b) {
+    return (enum aa_cmp)UA_NodeId_order((const UA_NodeId*)a, (const UA_NodeId*)b);
+}
+
+static UA_StagingEntry *
+findStagingEntry(UA_StagingNodestore *sns, const UA_NodeId *nodeId) {
+    return (UA_StagingEntry*)aa_find(&sns->nodes, nodeId);
+}
+
+static UA_Boolean
+baseHasNode(UA_StagingNodestore *sns, const UA_NodeId *nodeId) {
+    UA_LOCK(sns->baseLock);
+    const UA_Node *node = sns->base->getNode(sns->base->context, nodeId);
+    if(node)
+        sns->base->releaseNode(sns->base->context, node);
+    UA_UNLOCK(sns->baseLock);
+    return (node != NULL);
+}
+
+static void
+deleteBaseNode(UA_StagingNodestore *sns, UA_Node *node) {
+    UA_LOCK(sns->baseLock);
+    sns->base->deleteNode(sns->base->context, node);
+    UA_UNLOCK(sns->baseLock);
+}
+
+static void
+UA_StagingReferenceTypes_clear(UA_StagingReferenceTypes *rt) {
+    if(rt->initialized) {
+        for(size_t i = rt->firstIndex; i < rt->nextIndex; i++)
+            UA_NodeId_clear(&rt->ids[i]);
+    }
+    memset(rt, 0, sizeof(UA_StagingReferenceTypes));
+}
+
+static void
+findNextReferenceTypeIndex(void *visitorCtx, const UA_Node *node) {
+    if(node->head.nodeClass != UA_NODECLASS_REFERENCETYPE)
+        return;
+    UA_Byte *next = (UA_Byte*)visitorCtx;
+    UA_Byte index = node->referenceTypeNode.referenceTypeIndex;
+    if(index >= *next)
+        *next = (UA_Byte)(index + 1);
+}
+
+/* Assign the next ReferenceTypeIndex of the wave to a new ReferenceType */
+static UA_StatusCode
+stageReferenceTypeIndex(UA_StagingNodestore *sns, UA_ReferenceTypeNode *node) {
+    UA_StagingReferenceTypes *rt = sns->refTypes;
+    UA_StatusCode res = UA_STATUSCODE_BADINTERNALERROR;
+    UA_LOCK(sns->baseLock);
+    if(!rt->initialized) {
+        sns->base->iterate(sns->base->context, findNextReferenceTypeIndex,
+                           &rt->firstIndex);
+        rt->nextIndex = rt->firstIndex;
+        rt->initialized = true;
+    }
+    if(rt->nextIndex < UA_REFERENCETYPESET_MAX)
+        res = UA_NodeId_copy(&node->head.nodeId, &rt->ids[rt->nextIndex]);
+    if(res == UA_STATUSCODE_GOOD) {
+        rt->owners[rt->nextIndex] = sns;
+        node->referenceTypeIndex = rt->nextIndex;
+        node->subTypes = UA_REFTYPESET(rt->nextIndex);
+        rt->nextIndex++;
+    }
+    UA_UNLOCK(sns->baseLock);
+    return res;
+}
+
+/* Delete the current version or keep it until it is released */
+static void
+retireStagingNode(UA_StagingNodestore *sns, UA_StagingEntry *entry) {
+    if(!entry->node)
+        return;
+    if(entry->refCount == 0) {
+        deleteBaseNode(sns, entry->node);
+    } else {
+        UA_RetiredNode *rn = (UA_RetiredNode*)UA_malloc(sizeof(UA_RetiredNode));
+        if(!rn) {
+            /* Leak the node rather than freeing memory that is in use */
+            entry->node = NULL;
+            return;
+        }
+        rn->node = entry->node;
+        rn->next = entry->retired;
+        entry->retired = rn;
+    }
+    entry->node = NULL;
+}
+
+static void
+freeRetiredNodes(UA_StagingNodestore *sns, UA_StagingEntry *entry) {
+    UA_RetiredNode *rn, *next = entry->retired;
+    while((rn = next)) {
+        next = rn->next;
+        deleteBaseNode(sns, rn->node);
+        UA_free(rn);
+    }
+    entry->retired = NULL;
+}
+
+static UA_Boolean
+isStagingNode(const UA_StagingEntry *entry, const UA_Node *node) {
+    if(entry->node == node)
+        return true;
+    for(UA_RetiredNode *rn = entry->retired; rn; rn = rn->next) {
+        if(rn->node == node)
+            return true;
+    }
+    return false;
+}
+
+static void
+UA_StagingNodestore_clear(void *nsCtx) {
+    UA_StagingNodestore *sns = (UA_StagingNodestore*)nsCtx;
+    UA_StagingEntry *entry;
+    while((entry = (UA_StagingEntry*)aa_min(&sns->nodes))) {
+        aa_remove(&sns->nodes, entry);
+        UA_assert(entry->refCount == 0);
+        if(entry->node)
+            deleteBaseNode(sns, entry->node);
+        freeRetiredNodes(sns, entry);
+        UA_NodeId_clear(&entry->nodeId);
+        UA_free(entry);
+    }
+}
+
+static UA_Node *
+UA_StagingNodestore_newNode(void *nsCtx, UA_NodeClass nodeClass) {
+    UA_StagingNodestore *sns = (UA_StagingNodestore*)nsCtx;
+    UA_LOCK(sns->baseLock);
+    UA_Node *node = sns->base->newNode(sns->base->context, nodeClass);
+    UA_UNLOCK(sns->baseLock);
+    return node;
+}
+
+static void
+UA_StagingNodestore_deleteNode(void *nsCtx, UA_Node *node) {
+    deleteBaseNode((UA_StagingNodestore*)nsCtx, node);
+}
+
+static const UA_Node *
+UA_StagingNodestore_getNode(void *nsCtx, const UA_NodeId *nodeId) {
+    UA_StagingNodestore *sns = (UA_StagingNodestore*)nsCtx;
+    UA_StagingEntry *entry = findStagingEntry(sns, nodeId);
+    if(entry) {
+        if(!entry->node)
+            return NULL; /* Removed */
+        entry->refCount++;
+        return entry->node;
+    }
+    UA_LOCK(sns->baseLock);
+    const UA_Node *node = sns->base->getNode(sns->base->context, nodeId);
+    UA_UNLOCK(sns->baseLock);
+    return node;
+}
+
+static void
+UA_StagingNodestore_releaseNode(void *nsCtx, const UA_Node *node) {
+    if(!node)
+        return;
+    UA_StagingNodestore *sns = (UA_StagingNodestore*)nsCtx;
+    UA_StagingEntry *entry = findStagingEntry(sns, &node->head.nodeId);
+    if(entry && isStagingNode(entry, node)) {
+        UA_assert(entry->refCount > 0);
+        entry->refCount--;
+        if(entry->refCount == 0)
+            freeRetiredNodes(sns, entry);
+        return;
+    }
+    /* The node was taken from the server nodestore. Possibly before a shadow
+     * copy was created. */
+    UA_LOCK(sns->baseLock);
+    sns->base->releaseNode(sns->base->context, node);
+    UA_UNLOCK(sns->baseLock);
+}
+
+static UA_StatusCode
+UA_StagingNodestore_getNodeCopy(void *nsCtx, const UA_NodeId *nodeId,
+                                UA_Node **outNode) {
+    UA_StagingNodestore *sns = (UA_StagingNodestore*)nsCtx;
+    UA_StagingEntry *entry = findStagingEntry(sns, nodeId);
+    if(entry) {
+        if(!entry->node)
+            return UA_STATUSCODE_BADNODEIDUNKNOWN;
+        UA_Node *copy =
+            UA_StagingNodestore_newNode(sns, entry->node->head.nodeClass);
+        if(!copy)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        UA_StatusCode res = UA_Node_copy(entry->node, copy);
+        if(res != UA_STATUSCODE_GOOD) {
+            deleteBaseNode(sns, copy);
+            return res;
+        }
+        *outNode = copy;
+        return UA_STATUSCODE_GOOD;
+    }
+    UA_LOCK(sns->baseLock);
+    UA_StatusCode res = sns->base->getNodeCopy(sns->base->context, nodeId, outNode);
+    UA_UNLOCK(sns->baseLock);
+    return res;
+}
+
+static UA_StagingEntry *
+addStagingEntry(UA_StagingNodestore *sns, UA_Node *node) {
+    UA_StagingEntry *entry = (UA_StagingEntry*)UA_calloc(1, sizeof(UA_StagingEntry));
+    if(!entry)
+        return NULL;
+    if(UA_NodeId_copy(&node->head.nodeId, &entry->nodeId) != UA_STATUSCODE_GOOD) {
+        UA_free(entry);
+        return NULL;
+    }
+    entry->node = node;
+    aa_insert(&sns->nodes, entry);
+    return entry;
+}
+
+static UA_StatusCode
+UA_StagingNodestore_insertNode(void *nsCtx, UA_Node *node, UA_NodeId *addedNodeId) {
+    UA_StagingNodestore *sns = (UA_StagingNodestore*)nsCtx;
+
+    /* Create a random numeric NodeId. Starting at 50,000 as in the default
+     * nodestores. Must not collide with the server and the staged nodes. */
+    UA_NodeId *nodeId = &node->head.nodeId;
+    if(nodeId->identifierType == UA_NODEIDTYPE_NUMERIC &&
+       nodeId->identifier.numeric == 0) {
+        do {
+            UA_LOCK(sns->baseLock); /* The random generator is global */
+            nodeId->identifier.numeric =
+                50000 + (UA_UInt32_random() % (UA_UINT32_MAX - 50000));
+            UA_UNLOCK(sns->baseLock);
+        } while(findStagingEntry(sns, nodeId) || baseHasNode(sns, nodeId));
+    }
+
+    /* The NodeId exists already? */
+    UA_StagingEntry *entry = findStagingEntry(sns, nodeId);
+    if((entry && entry->node) || (!entry && baseHasNode(sns, nodeId))) {
+        deleteBaseNode(sns, node);
+        return UA_STATUSCODE_BADNODEIDEXISTS;
+    }
+
+    if(addedNodeId) {
+        UA_StatusCode res = UA_NodeId_copy(nodeId, addedNodeId);
+        if(res != UA_STATUSCODE_GOOD) {
+            deleteBaseNode(sns, node);
+            return res;
+        }
+    }
+
+    /* Reuse the entry of a removed node */
+    if(!entry)
+        entry = addStagingEntry(sns, node);
+    if(!entry) {
+        if(addedNodeId)
+            UA_NodeId_clear(addedNodeId);
+        deleteBaseNode(sns, node);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    entry->node = node;
+
+    /* The index is allocated last. So it is never left unused. */
+    if(node->head.nodeClass == UA_NODECLASS_REFERENCETYPE) {
+        UA_StatusCode res = stageReferenceTypeIndex(sns, &node->referenceTypeNode);
+        if(res != UA_STATUSCODE_GOOD) {
+            if(addedNodeId)
+                UA_NodeId_clear(addedNodeId);
+            entry->node = NULL;
+            deleteBaseNode(sns, node);
+            return res;
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+UA_StagingNodestore_replaceNode(void *nsCtx, UA_Node *node) {
+    UA_StagingNodestore *sns = (UA_StagingNodestore*)nsCtx;
+    UA_StagingEntry *entry = findStagingEntry(sns, &node->head.nodeId);
+    if(entry) {
+        if(!entry->node) {
+            deleteBaseNode(sns, node);
+            return UA_STATUSCODE_BADNODEIDUNKNOWN;
+        }
+        retireStagingNode(sns, entry);
+        entry->node = node;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Shadow the node from the server nodestore */
+    if(!baseHasNode(sns, &node->head.nodeId)) {
+        deleteBaseNode(sns, node);
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    }
+    entry = addStagingEntry(sns, node);
+    if(!entry) {
+        deleteBaseNode(sns, node);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    entry->shadow = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+UA_StagingNodestore_removeNode(void *nsCtx, const UA_NodeId *nodeId) {
+    UA_StagingNodestore *sns = (UA_StagingNodestore*)nsCtx;
+    UA_StagingEntry *entry = findStagingEntry(sns, nodeId);
+    if(!entry)
+        return (baseHasNode(sns, nodeId)) ?
+            UA_STATUSCODE_BADNOTSUPPORTED : UA_STATUSCODE_BADNODEIDUNKNOWN;
+    if(entry->shadow)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    if(!entry->node)
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    /* Removing would leave a gap in the ReferenceTypeIndex */
+    if(entry->node->head.nodeClass == UA_NODECLASS_REFERENCETYPE)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    retireStagingNode(sns, entry);
+    return UA_STATUSCODE_GOOD;
+}
+
+static const UA_NodeId *
+UA_StagingNodestore_getReferenceTypeId(void *nsCtx, UA_Byte refTypeIndex) {
+    UA_StagingNodestore *sns = (UA_StagingNodestore*)nsCtx;
+    UA_StagingReferenceTypes *rt = sns->refTypes;
+    const UA_NodeId *id;
+    UA_LOCK(sns->baseLock);
+    if(rt->initialized && refTypeIndex >= rt->firstIndex &&
+       refTypeIndex < rt->nextIndex)
+        id = &rt->ids[refTypeIndex];
+    else
+        id = sns->base->getReferenceTypeId(sns->base->context, refTypeIndex);
+    UA_UNLOCK(sns->baseLock);
+    return id;
+}
+
+/* Only the staged nodes are visited */
+static void
+UA_StagingNodestore_iterate(void *nsCtx, UA_NodestoreVisitor visitor,
+                            void *visitorCtx) {
+    UA_StagingNodestore *sns = (UA_StagingNodestore*)nsCtx;
+    UA_StagingEntry *entry = (UA_StagingEntry*)aa_min(&sns->nodes);
+    while(entry) {
+        UA_StagingEntry *next = (UA_StagingEntry*)aa_next(&sns->nodes, entry);
+        if(entry->node) {
+            entry->refCount++;
+            visitor(visitorCtx, entry->node);
+            entry->refCount--;
+            if(entry->refCount == 0)
+                freeRetiredNodes(sns, entry);
+        }
+        entry = next;
+    }
+}
+
+static void
+UA_StagingNodestore_init(UA_StagingNodestore *sns, UA_Nodestore *base,
+                         UA_StagingReferenceTypes *refTypes, UA_Nodestore *ns) {
+    aa_init(&sns->nodes, cmpStagingNodeId, offsetof(UA_StagingEntry, treeEntry),
+            offsetof(UA_StagingEntry, nodeId));
+    sns->base = base;
+    sns->refTypes = refTypes;
+    memset(ns, 0, sizeof(UA_Nodestore));
+    ns->context = sns;
+    ns->clear = UA_StagingNodestore_clear;
+    ns->newNode = UA_StagingNodestore_newNode;
+    ns->deleteNode = UA_StagingNodestore_deleteNode;
+    ns->getNode = UA_StagingNodestore_getNode;
+    ns->releaseNode = UA_StagingNodestore_releaseNode;
+    ns->getNodeCopy = UA_StagingNodestore_getNodeCopy;
+    ns->insertNode = UA_StagingNodestore_insertNode;
+    ns->replaceNode = UA_StagingNodestore_replaceNode;
+    ns->removeNode = UA_StagingNodestore_removeNode;
+    ns->getReferenceTypeId = UA_StagingNodestore_getReferenceTypeId;
+    ns->iterate = UA_StagingNodestore_iterate;
+    ns->getNodeFromPtr = NULL; /* Resolve the NodeId for the shadow copies */
+}
+
+/* Add the references of the shadow copy to the current version of the node in
+ * the server nodestore. Several loaders of a wave may have added references to
+ * the same node. */
+static UA_StatusCode
+mergeShadowNode(UA_Nodestore *base, const UA_Node *shadow) {
+    UA_Node *node = NULL;
+    UA_StatusCode res = base->getNodeCopy(base->context, &shadow->head.nodeId, &node);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    for(size_t i = 0; i < shadow->head.referencesSize; i++) {
+        const UA_NodeReferenceKind *rk = &shadow->head.references[i];
+        if(rk->targetsSize == 0)
+            continue;
+        UA_ExpandedNodeId *ids = (UA_ExpandedNodeId*)
+            UA_malloc(sizeof(UA_ExpandedNodeId) * rk->targetsSize);
+        UA_UInt32 *hashes = (UA_UInt32*)UA_malloc(sizeof(UA_UInt32) * rk->targetsSize);
+        if(!ids || !hashes) {
+            UA_free(ids);
+            UA_free(hashes);
+            base->deleteNode(base->context, node);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        size_t count = 0;
+        const UA_ReferenceTarget *t = NULL;
+        while((t = UA_NodeReferenceKind_iterate(rk, t))) {
+            ids[count] = UA_NodePointer_toExpandedNodeId(t->targetId);
+            hashes[count] = t->targetNameHash;
+            count++;
+        }
+        res = UA_Node_addReferences(node, rk->referenceTypeIndex, !rk->isInverse,
+                                    count, ids, hashes);
+        UA_free(ids);
+        UA_free(hashes);
+        if(res != UA_STATUSCODE_GOOD) {
+            base->deleteNode(base->context, node);
+            return res;
+        }
+    }
+
+    /* New subtypes of a ReferenceType */
+    if(node->head.nodeClass == UA_NODECLASS_REFERENCETYPE)
+        node->referenceTypeNode.subTypes =
+            UA_ReferenceTypeSet_union(node->referenceTypeNode.subTypes,
+                                      shadow->referenceTypeNode.subTypes);
+
+    return base->replaceNode(base->context, node);
+}
+
+/* Insert the staged ReferenceTypes of the wave in the order of their index.
+ * Restore the subtypes that were added while the ReferenceType was staged.
+ * The server nodestore resets them upon insertion. */
+static UA_StatusCode
+publishStagingReferenceTypes(UA_Server *server, UA_StagingReferenceTypes *rt) {
+    if(!rt->initialized)
+        return UA_STATUSCODE_GOOD;
+    UA_Nodestore *base = &server->config.nodestore;
+    for(UA_Byte i = rt->firstIndex; i < rt->nextIndex; i++) {
+        UA_StagingNodestore *sns = rt->owners[i];
+        UA_StagingEntry *entry = findStagingEntry(sns, &rt->ids[i]);
+        UA_StatusCode res = UA_STATUSCODE_BADINTERNALERROR;
+        if(entry && entry->node) {
+            aa_remove(&sns->nodes, entry);
+            UA_assert(entry->refCount == 0);
+            UA_assert(entry->retired == NULL);
+            UA_ReferenceTypeSet subTypes = entry->node->referenceTypeNode.subTypes;
+            res = base->insertNode(base->context, entry->node, NULL);
+            UA_NodeId_clear(&entry->nodeId);
+            UA_free(entry);
+            const UA_NodeId *id = base->getReferenceTypeId(base->context, i);
+            if(res == UA_STATUSCODE_GOOD && (!id || !UA_NodeId_equal(id, &rt->ids[i])))
+                res = UA_STATUSCODE_BADINTERNALERROR;
+            UA_ReferenceTypeSet own = UA_REFTYPESET(i);
+            UA_Node *node = NULL;
+            if(res == UA_STATUSCODE_GOOD &&
+               memcmp(&subTypes, &own, sizeof(UA_ReferenceTypeSet)) != 0)
+                res = base->getNodeCopy(base->context, &rt->ids[i], &node);
+            if(node) {
+                node->referenceTypeNode.subTypes = subTypes;
+                res = base->replaceNode(base->context, node);
+            }
+        }
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_LOG_NODEID_ERROR(&rt->ids[i],
+                UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                             "Could not publish the staged ReferenceType %.*s "
+                             "with the index %u (%s)", (int)nodeIdStr.length,
+                             nodeIdStr.data, (unsigned)i, UA_StatusCode_name(res)));
+            return res;
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Move the staged nodes into the server nodestore. The staging nodestore is
+ * empty afterwards. Continues after an error and returns the first one. */
+static UA_StatusCode
+publishStagingNodestore(UA_Server *server, UA_StagingNodestore *sns) {
+    UA_Nodestore *base = sns->base;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_StagingEntry *entry;
+    while((entry = (UA_StagingEntry*)aa_min(&sns->nodes))) {
+        aa_remove(&sns->nodes, entry);
+        UA_assert(entry->refCount == 0);
+        UA_assert(entry->retired == NULL);
+        if(entry->node) {
+            UA_StatusCode res2;
+            if(entry->shadow) {
+                /* The merged node replaces the node in the server nodestore.
+                 * Pointers to the old node are resolved again. */
+                ++server->nodestoreVersion;
+                res2 = mergeShadowNode(base, entry->node);
+                base->deleteNode(base->context, entry->node);
+            } else {
+                /* Takes ownership of the node also upon failure */
+                res2 = base->insertNode(base->context, entry->node, NULL);
+            }
+            if(res2 != UA_STATUSCODE_GOOD) {
+                UA_LOG_NODEID_WARNING(&entry->nodeId,
+                    UA_LOG_WARNING(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                                   "Could not publish the staged node %.*s (%s)",
+                                   (int)nodeIdStr.length, nodeIdStr.data,
+                                   UA_StatusCode_name(res2)));
+                if(res == UA_STATUSCODE_GOOD)
+                    res = res2;
+            }
+        }
+        UA_NodeId_clear(&entry->nodeId);
+        UA_free(entry);
+    }
+    return res;
+}
+
+/******************/
+/* Staging Server */
+/******************/
+
+/* The staging server is created with UA_Server_newStaging. It borrows the
+ * configuration of the server and uses the staging nodestore. */
+
+/* Nodes that are not in the overlay belong to the server nodestore */
+static UA_Boolean
+isServerNode(UA_Server *staging, const UA_Node *node) {
+    UA_StagingNodestore *sns = (UA_StagingNodestore*)staging->config.nodestore.context;
+    UA_StagingEntry *entry = findStagingEntry(sns, &node->head.nodeId);
+    return (!entry || !isStagingNode(entry, node));
+}
+
+typedef struct {
+    UA_Server *staging;
+    UA_StagingNodestore sns;
+    const UA_NodesetLoader *loader;
+    UA_StatusCode result;
+} UA_NodesetStaging;
+
+static UA_StatusCode
+UA_NodesetStaging_init(UA_NodesetStaging *st, UA_Server *server,
+                       const UA_NodesetLoader *loader,
+                       UA_StagingReferenceTypes *refTypes) {
+    st->loader = loader;
+    st->result = UA_STATUSCODE_GOOD;
+    UA_Nodestore ns;
+    UA_StagingNodestore_init(&st->sns, &server->config.nodestore, refTypes, &ns);
+    st->staging = UA_Server_newStaging(server, &ns);
+    if(!st->staging)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    st->staging->copyOnEdit = isServerNode;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Delete the staging server. The staging nodestore is not cleared. */
+static void
+UA_NodesetStaging_finish(UA_NodesetStaging *st) {
+    if(!st->staging)
+        return;
+    UA_Server_deleteStaging(st->staging);
+    st->staging = NULL;
+}
+
+static void *
+runNodesetLoader(void *data) {
+    UA_NodesetStaging *st = (UA_NodesetStaging*)data;
+    st->result = st->loader->load(st->staging);
+    return NULL;
+}
+
+/****************/
+/* Nodeset Load */
+/****************/
+
+static UA_Boolean
+dependenciesLoaded(size_t loadersSize,
+                   const UA_NodesetLoader *loaders, const UA_Boolean *loaded,
+                   const UA_NodesetLoader *loader) {
+    for(size_t i = 0; i < loader->dependenciesSize; i++) {
+        const char *dep = loader->dependencies[i];
+        for(size_t j = 0; j < loadersSize; j++) {
+            if(strcmp(loaders[j].namespaceUri, dep) == 0 && !loaded[j])
+                return false;
+        }
+    }
+    return true;
+}
+
+/* Add the namespaces the staging servers registered on their own. All
+ * stagings started with the namespaces of the server. So the indices only
+ * match if no two stagings added different namespaces. */
+static UA_StatusCode
+publishStagingNamespaces(UA_Server *server, size_t namespacesSize,
+                         UA_NodesetStaging *st) {
+    UA_Server *staging = st->staging;
+    for(size_t i = namespacesSize; i < staging->namespacesSize; i++) {
+        UA_UInt16 ns = addNamespace(server, staging->namespaces[i]);
+        if(ns != i) {
+            UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                         "The nodeset loader for %s registered the namespace "
+                         UA_PRINTF_STRING_FORMAT " with a conflicting index. "
+                         "Declare it as a dependency.", st->loader->namespaceUri,
+                         UA_PRINTF_STRING_DATA(staging->namespaces[i]));
+            return UA_STATUSCODE_BADINVALIDSTATE;
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+loadNodesetWave(UA_Server *server, size_t waveSize, UA_NodesetStaging *wave) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+
+#ifdef UA_NODESETLOADER_THREADS
+    /* Run the loaders in parallel. The last one in the current thread. */
+    pthread_t *threads = (pthread_t*)UA_calloc(waveSize, sizeof(pthread_t));
+    UA_Boolean *started = (UA_Boolean*)UA_calloc(waveSize, sizeof(UA_Boolean));
+    if(!threads || !started) {
+        UA_free(threads);
+        UA_free(started);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    for(size_t i = 0; i + 1 < waveSize; i++)
+        started[i] = (pthread_create(&threads[i], NULL, runNodesetLoader, &wave[i]) == 0);
+    for(size_t i = 0; i < waveSize; i++) {
+        if(i + 1 == waveSize || !started[i])
+            runNodesetLoader(&wave[i]); /* Fall back to the current thread */
+    }
+    for(size_t i = 0; i + 1 < waveSize; i++) {
+        if(started[i])
+            pthread_join(threads[i], NULL);
+    }
+    UA_free(threads);
+    UA_free(started);
+#else
+    for(size_t i = 0; i < waveSize; i++)
+        runNodesetLoader(&wave[i]);
+#endif
+
+    for(size_t i = 0; i < waveSize; i++) {
+        if(wave[i].result == UA_STATUSCODE_GOOD)
+            continue;
+        UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                     "The nodeset loader for %s failed with %s",
+                     wave[i].loader->namespaceUri,
+                     UA_StatusCode_name(wave[i].result));
+        if(res == UA_STATUSCODE_GOOD)
+            res = wave[i].result;
+    }
+    return res;
+}
+
+UA_StatusCode
+UA_Server_loadNodesets(UA_Server *server, size_t loadersSize,
+                       const UA_NodesetLoader *loaders) {
+    if(loadersSize == 0)
+        return UA_STATUSCODE_GOOD;
+
+    UA_LOCK(&server->serviceMutex);
+
+#if UA_MULTITHREADING >= 100
+    UA_Lock baseLock;
+    UA_LOCK_INIT(&baseLock);
+#endif
+    UA_StagingReferenceTypes refTypes;
+    memset(&refTypes, 0, sizeof(UA_StagingReferenceTypes));
+
+    size_t loadedCount = 0;
+    UA_NodesetStaging *wave = (UA_NodesetStaging*)
+        UA_calloc(loadersSize, sizeof(UA_NodesetStaging));
+    UA_Boolean *loaded = (UA_Boolean*)UA_calloc(loadersSize, sizeof(UA_Boolean));
+    UA_Boolean *inWave = (UA_Boolean*)UA_calloc(loadersSize, sizeof(UA_Boolean));
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(!wave || !loaded || !inWave) {
+        res = UA_STATUSCODE_BADOUTOFMEMORY;
+        goto cleanup;
+    }
+
+    /* Dependencies are either loaded here or already present in the server */
+    for(size_t i = 0; i < loadersSize; i++) {
+        for(size_t j = 0; j < loaders[i].dependenciesSize; j++) {
+            const char *dep = loaders[i].dependencies[j];
+            UA_Boolean found = false;
+            for(size_t k = 0; k < loadersSize && !found; k++)
+                found = (strcmp(loaders[k].namespaceUri, dep) == 0);
+            size_t nsIndex;
+            if(!found && getNamespaceByName(server, UA_STRING((char*)(uintptr_t)dep),
+                                            &nsIndex) != UA_STATUSCODE_GOOD) {
+                UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                             "The nodeset loader for %s depends on the unknown "
+                             "namespace %s", loaders[i].namespaceUri, dep);
+                res = UA_STATUSCODE_BADNOTFOUND;
+                goto cleanup;
+            }
+        }
+    }
+
+    /* Add all namespaces upfront. Then the indices don't depend on the
+     * execution order of the loaders. */
+    for(size_t i = 0; i < loadersSize; i++)
+        addNamespace(server, UA_STRING((char*)(uintptr_t)loaders[i].namespaceUri));
+
+    while(loadedCount < loadersSize) {
+        /* Collect the wave of loaders with all dependencies satisfied */
+        size_t waveSize = 0;
+        for(size_t i = 0; i < loadersSize; i++) {
+            inWave[i] = (!loaded[i] &&
+                         dependenciesLoaded(loadersSize, loaders, loaded, &loaders[i]));
+            if(!inWave[i])
+                continue;
+            res = UA_NodesetStaging_init(&wave[waveSize], server,
+                                         &loaders[i], &refTypes);
+#if UA_MULTITHREADING >= 100
+            wave[waveSize].sns.baseLock = &baseLock;
+#endif
+            waveSize++;
+            if(res != UA_STATUSCODE_GOOD)
+                break;
+        }
+        if(waveSize == 0) {
+            UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                         "Cyclic dependencies between the nodeset loaders");
+            res = UA_STATUSCODE_BADINVALIDARGUMENT;
+        }
+
+        /* Build the nodes in the staging servers */
+        if(res == UA_STATUSCODE_GOOD) {
+            UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                        "Loading %u nodeset(s) in parallel", (unsigned)waveSize);
+            res = loadNodesetWave(server, waveSize, wave);
+        }
+
+        /* Publish the wave in one step */
+        size_t namespacesSize = server->namespacesSize;
+        for(size_t i = 0; i < waveSize; i++) {
+            if(res == UA_STATUSCODE_GOOD)
+                res = publishStagingNamespaces(server, namespacesSize, &wave[i]);
+        }
+        for(size_t i = 0; i < waveSize; i++)
+            UA_NodesetStaging_finish(&wave[i]);
+        UA_Boolean publish = (res == UA_STATUSCODE_GOOD);
+        if(publish)
+            res = publishStagingReferenceTypes(server, &refTypes);
+        for(size_t i = 0; i < waveSize; i++) {
+            if(publish) {
+                UA_StatusCode res2 = publishStagingNodestore(server, &wave[i].sns);
+                if(res == UA_STATUSCODE_GOOD)
+                    res = res2;
+            }
+            UA_StagingNodestore_clear(&wave[i].sns);
+        }
+        UA_StagingReferenceTypes_clear(&refTypes);
+        memset(wave, 0, sizeof(UA_NodesetStaging) * waveSize);
+        if(res != UA_STATUSCODE_GOOD)
+            break;
+
+        for(size_t i = 0; i < loadersSize; i++) {
+            if(!inWave[i])
+                continue;
+            loaded[i] = true;
+            loadedCount++;
+        }
+    }
+
+ cleanup:
+#if UA_MULTITHREADING >= 100
+    UA_LOCK_DESTROY(&baseLock);
+#endif
+    UA_free(wave);
+    UA_free(loaded);
+    UA_free(inWave);
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
@@ -0,0 +1,336 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ua_server_internal.h"
+
+#ifdef UA_ENABLE_TRACING
+
+UA_THREAD_LOCAL UA_TraceContext UA_traceContext;
+
+/* The address identifies the thread */
+static UA_THREAD_LOCAL char traceThreadMarker;
+
+static const char *traceStageNames[] = {
+    "request", "decode", "service", "nodestore",
+    "accesscontrol", "datasource", "encode", "send"};
+
+void
+UA_TraceManager_init(UA_TraceManager *tm) {
+    LIST_INIT(&tm->buffers);
+    tm->buffersSize = 0;
+    tm->serverId = (UA_UInt64)UA_UInt32_random() << 32 | UA_UInt32_random();
+    UA_LOCK_INIT(&tm->lock);
+}
+
+void
+UA_TraceManager_clear(UA_TraceManager *tm) {
+    UA_TraceBuffer *tb, *tb_tmp;
+    LIST_FOREACH_SAFE(tb, &tm->buffers, pointers, tb_tmp) {
+        LIST_REMOVE(tb, pointers);
+        UA_free(tb->spans);
+        UA_free(tb);
+    }
+    tm->buffersSize = 0;
+    UA_LOCK_DESTROY(&tm->lock);
+}
+
+/**********************/
+/* Recording of Spans */
+/**********************/
+
+void
+UA_Trace_beginSpan(UA_TraceStage stage, const char *name) {
+    UA_TraceContext *ctx = &UA_traceContext;
+    if(ctx->dropped > 0 || ctx->depth == UA_TRACE_MAXDEPTH ||
+       ctx->spansSize == UA_TRACE_MAXSPANS) {
+        ctx->dropped++;
+        return;
+    }
+    UA_TraceSpan *span = &ctx->spans[ctx->spansSize];
+    span->traceId = ctx->traceId;
+    span->name = name;
+    span->stage = (UA_Byte)stage;
+    span->index = (UA_UInt16)(ctx->spansSize + 1);
+    span->parent = (ctx->depth > 0) ? ctx->stack[ctx->depth - 1] : 0;
+    span->end = 0;
+    ctx->stack[ctx->depth++] = span->index;
+    ctx->spansSize++;
+    span->start = UA_DateTime_nowMonotonic();
+}
+
+void
+UA_Trace_endSpan(void) {
+    UA_TraceContext *ctx = &UA_traceContext;
+    if(ctx->dropped > 0) {
+        ctx->dropped--;
+        return;
+    }
+    if(ctx->depth == 0)
+        return;
+    UA_UInt16 index = ctx->stack[--ctx->depth];
+    ctx->spans[index - 1].end = UA_DateTime_nowMonotonic();
+}
+
+void
+UA_Trace_beginRequest(UA_Server *server) {
+    UA_TraceContext *ctx = &UA_traceContext;
+    UA_UInt32 interval = server->config.tracingSampleInterval;
+    if(interval == 0 || ctx->traceId != 0)
+        return;
+    if(++ctx->sampleCounter < interval)
+        return;
+    ctx->sampleCounter = 0;
+    ctx->traceId = (UA_UInt64)UA_UInt32_random() << 32 | UA_UInt32_random();
+    if(ctx->traceId == 0)
+        ctx->traceId = 1;
+    ctx->depth = 0;
+    ctx->dropped = 0;
+    ctx->spansSize = 0;
+    UA_Trace_beginSpan(UA_TRACESTAGE_REQUEST, NULL);
+}
+
+static UA_TraceBuffer *
+getTraceBuffer(UA_Server *server) {
+    UA_TraceManager *tm = &server->traceManager;
+    UA_TraceBuffer *tb;
+    LIST_FOREACH(tb, &tm->buffers, pointers) {
+        if(tb->thread == &traceThreadMarker)
+            return tb;
+    }
+
+    size_t size = server->config.tracingBufferSize;
+    if(size < UA_TRACE_MAXSPANS)
+        size = UA_TRACE_MAXSPANS;
+    tb = (UA_TraceBuffer*)UA_calloc(1, sizeof(UA_TraceBuffer));
+    if(!tb)
+        return NULL;
+    tb->spans = (UA_TraceSpan*)UA_malloc(size * sizeof(UA_TraceSpan));
+    if(!tb->spans) {
+        UA_free(tb);
+        return NULL;
+    }
+    tb->spansSize = size;
+    tb->thread = &traceThreadMarker;
+    tb->threadIndex = ++tm->buffersSize;
+    LIST_INSERT_HEAD(&tm->buffers, tb, pointers);
+    return tb;
+}
+
+void
+UA_Trace_endRequest(UA_Server *server) {
+    UA_TraceContext *ctx = &UA_traceContext;
+    if(ctx->traceId == 0)
+        return;
+
+    /* Close the spans left open by early returns */
+    ctx->dropped = 0;
+    while(ctx->depth > 0)
+        UA_Trace_endSpan();
+
+    /* Move the spans to the ring buffer of the thread */
+    UA_LOCK(&server->traceManager.lock);
+    UA_TraceBuffer *tb = getTraceBuffer(server);
+    if(tb) {
+        for(size_t i = 0; i < ctx->spansSize; i++) {
+            tb->spans[tb->next] = ctx->spans[i];
+            tb->next = (tb->next + 1) % tb->spansSize;
+        }
+        tb->count += ctx->spansSize;
+        if(tb->count > tb->spansSize)
+            tb->count = tb->spansSize;
+    }
+    UA_UNLOCK(&server->traceManager.lock);
+
+    ctx->traceId = 0;
+    ctx->spansSize = 0;
+}
+
+/**********/
+/* Export */
+/**********/
+
+typedef struct {
+    UA_ByteString *out;
+    size_t pos;
+    UA_StatusCode res;
+} TraceWriter;
+
+static void
+writeRaw(TraceWriter *w, const char *str, size_t len) {
+    if(w->res != UA_STATUSCODE_GOOD)
+        return;
+    if(w->pos + len > w->out->length) {
+        size_t newLength = (w->out->length > 0) ? w->out->length : 4096;
+        while(newLength < w->pos + len)
+            newLength *= 2;
+        UA_Byte *data = (UA_Byte*)UA_realloc(w->out->data, newLength);
+        if(!data) {
+            w->res = UA_STATUSCODE_BADOUTOFMEMORY;
+            return;
+        }
+        w->out->data = data;
+        w->out->length = newLength;
+    }
+    memcpy(&w->out->data[w->pos], str, len);
+    w->pos += len;
+}
+
+static void
+writeStr(TraceWriter *w, const char *str) {
+    writeRaw(w, str, strlen(str));
+}
+
+#define WRITEFORMAT_BUFSIZE 192
+
+#define writeFormat(w, ...) do {                                        \
+        char buf_[WRITEFORMAT_BUFSIZE];                                 \
+        int len_ = UA_snprintf(buf_, WRITEFORMAT_BUFSIZE, __VA_ARGS__); \
+        if(len_ < 0 || len_ >= WRITEFORMAT_BUFSIZE)                     \
+            (w)->res = UA_STATUSCODE_BADINTERNALERROR;                  \
+        else                                                            \
+            writeRaw(w, buf_, (size_t)len_);                            \
+    } while(0)
+
+/* Write a JSON string with escaping */
+static void
+writeJsonString(TraceWriter *w, const UA_String *s) {
+    writeRaw(w, "\"", 1);
+    for(size_t i = 0; i < s->length; i++) {
+        UA_Byte c = s->data[i];
+        if(c == '"' || c == '\\')
+            writeFormat(w, "\\%c", c);
+        else if(c < 0x20)
+            writeFormat(w, "\\u%04x", c);
+        else
+            writeRaw(w, (const char*)&c, 1);
+    }
+    writeRaw(w, "\"", 1);
+}
+
+static const char *
+spanName(const UA_TraceSpan *span) {
+    return span->name ? span->name : traceStageNames[span->stage];
+}
+
+static UA_UInt64
+spanId(const UA_TraceSpan *span, UA_UInt16 index) {
+    return (span->traceId << 16) | index;
+}
+
+/* Monotonic time in 100ns ticks printed as microseconds */
+static void
+writeMicroseconds(TraceWriter *w, UA_DateTime t) {
+    writeFormat(w, "%" PRIi64 ".%d", (UA_Int64)(t / UA_DATETIME_USEC),
+                (int)(t % UA_DATETIME_USEC));
+}
+
+static void
+exportChromeSpan(TraceWriter *w, const UA_TraceSpan *span, UA_UInt32 threadIndex,
+                 UA_Boolean first) {
+    writeStr(w, first ? "\n" : ",\n");
+    writeFormat(w, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":",
+                spanName(span), traceStageNames[span->stage]);
+    writeMicroseconds(w, span->start);
+    writeStr(w, ",\"dur\":");
+    writeMicroseconds(w, span->end - span->start);
+    writeFormat(w, ",\"pid\":1,\"tid\":%u,\"args\":{\"traceId\":\"%016" PRIx64
+                "\",\"spanId\":\"%016" PRIx64 "\"", (unsigned)threadIndex,
+                span->traceId, spanId(span, span->index));
+    if(span->parent > 0)
+        writeFormat(w, ",\"parentSpanId\":\"%016" PRIx64 "\"",
+                    spanId(span, span->parent));
+    writeStr(w, "}}");
+}
+
+static void
+beginOtlpTrace(TraceWriter *w, const UA_String *serviceName) {
+    writeStr(w, "{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":"
+             "\"service.name\",\"value\":{\"stringValue\":");
+    writeJsonString(w, serviceName);
+    writeStr(w, "}}]},\"scopeSpans\":[{\"scope\":{\"name\":\"open62541\"},\"spans\":[");
+}
+
+static void
+exportOtlpSpan(TraceWriter *w, const UA_TraceSpan *span, UA_UInt64 serverId,
+               UA_UInt32 threadIndex, UA_DateTime toUnix, UA_Boolean first) {
+    if(!first)
+        writeStr(w, ",");
+    writeFormat(w, "{\"traceId\":\"%016" PRIx64 "%016" PRIx64 "\",\"spanId\":\"%016"
+                PRIx64 "\"", serverId, span->traceId, spanId(span, span->index));
+    if(span->parent > 0)
+        writeFormat(w, ",\"parentSpanId\":\"%016" PRIx64 "\"", spanId(span, span->parent));
+    /* Kind 2 is SERVER, 1 is INTERNAL */
+    writeFormat(w, ",\"name\":\"%s\",\"kind\":%d", spanName(span),
+                (span->stage == UA_TRACESTAGE_REQUEST) ? 2 : 1);
+    writeFormat(w, ",\"startTimeUnixNano\":\"%" PRIi64 "00\"", (UA_Int64)(span->start + toUnix));
+    writeFormat(w, ",\"endTimeUnixNano\":\"%" PRIi64 "00\"", (UA_Int64)(span->end + toUnix));
+    writeFormat(w, ",\"attributes\":[{\"key\":\"opcua.stage\",\"value\":{\"stringValue\":"
+                "\"%s\"}},{\"key\":\"thread.id\",\"value\":{\"intValue\":\"%u\"}}]}",
+                traceStageNames[span->stage], (unsigned)threadIndex);
+}
+
+UA_StatusCode
+UA_Server_exportTrace(UA_Server *server, UA_TraceFormat format, UA_ByteString *out) {
+    if(format != UA_TRACEFORMAT_CHROME && format != UA_TRACEFORMAT_OTLP)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    UA_ByteString_init(out);
+    TraceWriter w = {out, 0, UA_STATUSCODE_GOOD};
+
+    /* Offset from the monotonic time to unix time */
+    UA_DateTime toUnix = UA_DateTime_now() - UA_DateTime_nowMonotonic() -
+        UA_DATETIME_UNIX_EPOCH;
+    const UA_String *serviceName = &server->config.applicationDescription.applicationUri;
+    UA_String defaultServiceName = UA_STRING("open62541");
+    if(serviceName->length == 0)
+        serviceName = &defaultServiceName;
+
+    if(format == UA_TRACEFORMAT_CHROME)
+        writeStr(&w, "{\"traceEvents\":[");
+
+    UA_Boolean first = true;
+    UA_TraceManager *tm = &server->traceManager;
+    UA_LOCK(&tm->lock);
+    UA_TraceBuffer *tb;
+    LIST_FOREACH(tb, &tm->buffers, pointers) {
+        /* The spans of a trace are consecutive in the buffer. If the oldest
+         * trace was partially overwritten, its root span is missing. */
+        size_t pos = (tb->next + tb->spansSize - tb->count) % tb->spansSize;
+        UA_UInt64 currentTrace = 0;
+        for(size_t i = 0; i < tb->count; i++) {
+            const UA_TraceSpan *span = &tb->spans[(pos + i) % tb->spansSize];
+            if(format == UA_TRACEFORMAT_CHROME) {
+                exportChromeSpan(&w, span, tb->threadIndex, first);
+                first = false;
+                continue;
+            }
+            /* One line per trace */
+            UA_Boolean newTrace = (span->traceId != currentTrace);
+            if(newTrace) {
+                if(currentTrace != 0)
+                    writeStr(&w, "]}]}]}\n");
+                beginOtlpTrace(&w, serviceName);
+                currentTrace = span->traceId;
+            }
+            exportOtlpSpan(&w, span, tm->serverId, tb->threadIndex, toUnix, newTrace);
+        }
+        if(currentTrace != 0)
+            writeStr(&w, "]}]}]}\n");
+        /* Remove the exported spans */
+        tb->count = 0;
+    }
+    UA_UNLOCK(&tm->lock);
+
+    if(format == UA_TRACEFORMAT_CHROME)
+        writeStr(&w, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+    if(w.res != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(out);
+        return w.res;
+    }
+    out->length = w.pos;
+    return UA_STATUSCODE_GOOD;
+}
+
+#endif /* UA_ENABLE_TRACING */
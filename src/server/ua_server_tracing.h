@@ -0,0 +1,123 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_SERVER_TRACING_H_
+#define UA_SERVER_TRACING_H_
+
+#include <open62541/server.h>
+
+#include "open62541_queue.h"
+#include "ua_util_internal.h"
+
+_UA_BEGIN_DECLS
+
+#ifdef UA_ENABLE_TRACING
+
+/* Sampled tracing of the request processing. For every n-th request
+ * (config.tracingSampleInterval), the processing stages are recorded as a tree
+ * of spans. The spans of the current request are collected in a thread-local
+ * context without locking. When the request is done, the spans are moved to
+ * the ring buffer of the thread. The buffers are exported with
+ * UA_Server_exportTrace.
+ *
+ * If the current request is not sampled, every trace point costs a single
+ * check of a thread-local variable. */
+
+typedef enum {
+    UA_TRACESTAGE_REQUEST = 0,   /* Root span from the decoded chunk to sending */
+    UA_TRACESTAGE_DECODE,        /* Decoding the request */
+    UA_TRACESTAGE_SERVICE,       /* The service implementation */
+    UA_TRACESTAGE_NODESTORE,     /* Getting a node from the nodestore */
+    UA_TRACESTAGE_ACCESSCONTROL, /* Callback into the AccessControl plugin */
+    UA_TRACESTAGE_DATASOURCE,    /* Reading from a DataSource */
+    UA_TRACESTAGE_ENCODE,        /* Encoding the response */
+    UA_TRACESTAGE_SEND           /* Finishing and sending the last chunk */
+} UA_TraceStage;
+
+#define UA_TRACE_MAXDEPTH 16
+#define UA_TRACE_MAXSPANS 256
+
+typedef struct {
+    UA_UInt64 traceId;
+    const char *name;  /* Static string, NULL to use the name of the stage */
+    UA_DateTime start; /* Monotonic time */
+    UA_DateTime end;
+    UA_UInt16 index;   /* Position in the trace, the request has index 1 */
+    UA_UInt16 parent;  /* Index of the parent span, 0 for the request */
+    UA_Byte stage;
+} UA_TraceSpan;
+
+/* Ring buffer of one thread */
+typedef struct UA_TraceBuffer {
+    LIST_ENTRY(UA_TraceBuffer) pointers;
+    const void *thread; /* Address of a thread-local variable */
+    UA_UInt32 threadIndex;
+    UA_TraceSpan *spans;
+    size_t spansSize;
+    size_t next;  /* Position of the next write */
+    size_t count; /* Number of valid spans */
+} UA_TraceBuffer;
+
+typedef struct {
+    LIST_HEAD(, UA_TraceBuffer) buffers;
+    UA_UInt32 buffersSize;
+    UA_UInt64 serverId; /* Upper half of the 128bit trace ids in exports */
+#if UA_MULTITHREADING >= 100
+    UA_Lock lock; /* Protects the buffers */
+#endif
+} UA_TraceManager;
+
+/* State of the current request of a thread */
+typedef struct {
+    UA_UInt64 traceId; /* Zero if the current request is not sampled */
+    UA_UInt32 sampleCounter;
+    size_t depth;
+    size_t dropped; /* Open spans that did not fit into the context */
+    UA_UInt16 stack[UA_TRACE_MAXDEPTH];
+    size_t spansSize;
+    UA_TraceSpan spans[UA_TRACE_MAXSPANS];
+} UA_TraceContext;
+
+extern UA_THREAD_LOCAL UA_TraceContext UA_traceContext;
+
+void UA_TraceManager_init(UA_TraceManager *tm);
+void UA_TraceManager_clear(UA_TraceManager *tm);
+
+/* Decide whether the request is sampled and open the root span */
+void UA_Trace_beginRequest(UA_Server *server);
+
+/* Close the root span and move the spans into the ring buffer */
+void UA_Trace_endRequest(UA_Server *server);
+
+void UA_Trace_beginSpan(UA_TraceStage stage, const char *name);
+void UA_Trace_endSpan(void);
+
+#define UA_TRACE_BEGIN(stage, name) do {            \
+        if(UA_traceContext.traceId != 0)            \
+            UA_Trace_beginSpan(stage, name);        \
+    } while(0)
+
+#define UA_TRACE_END() do {                         \
+        if(UA_traceContext.traceId != 0)            \
+            UA_Trace_endSpan();                     \
+    } while(0)
+
+/* Set the name of the root span once the request type is known */
+#define UA_TRACE_NAME(n) do {                       \
+        if(UA_traceContext.traceId != 0)            \
+            UA_traceContext.spans[0].name = n;      \
+    } while(0)
+
+#else
+
+#define UA_TRACE_BEGIN(stage, name) do {} while(0)
+#define UA_TRACE_END() do {} while(0)
+#define UA_TRACE_NAME(n) do {} while(0)
+
+#endif /* UA_ENABLE_TRACING */
+
+_UA_END_DECLS
+
+#endif /* UA_SERVER_TRACING_H_ */
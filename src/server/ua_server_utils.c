@@ -267,21 +267,37 @@ getAllInterfaceChildNodeIds(UA_Server *server, const UA_NodeId *objectNode,
     return UA_STATUSCODE_GOOD;
 }
 
-/* For mulithreading: make a copy of the node, edit and replace.
- * For singlethreading: edit the original */
 UA_StatusCode
-UA_Server_editNode(UA_Server *server, UA_Session *session,
-                   const UA_NodeId *nodeId, UA_EditNodeCallback callback,
-                   void *data) {
+UA_Node_unshareValue(UA_Node *node) {
+    if(node->head.nodeClass != UA_NODECLASS_VARIABLE &&
+       node->head.nodeClass != UA_NODECLASS_VARIABLETYPE)
+        return UA_STATUSCODE_GOOD;
+    /* VariableTypeNodes have the same layout for the value attribute */
+    return UA_VariableNode_unshareValue((UA_VariableNode*)node);
+}
+
+/* For mulithreading: make a copy of the node, edit and replace.
+ * For singlethreading: edit the original (unless copyOnEdit is set) */
+static UA_StatusCode
+editNode(UA_Server *server, UA_Session *session,
+         const UA_NodeId *nodeId, UA_EditNodeCallback callback,
+         void *data, UA_Boolean unshare) {
 #ifndef UA_ENABLE_IMMUTABLE_NODES
     /* Get the node and process it in-situ */
-    const UA_Node *node = UA_NODESTORE_GET(server, nodeId);
-    if(!node)
+    const UA_Node *orig = UA_NODESTORE_GET(server, nodeId);
+    if(!orig)
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
-    UA_StatusCode retval = callback(server, session, (UA_Node*)(uintptr_t)node, data);
-    UA_NODESTORE_RELEASE(server, node);
-    return retval;
-#else
+    if(!server->copyOnEdit || !server->copyOnEdit(server, orig)) {
+        UA_StatusCode retval = UA_STATUSCODE_GOOD;
+        if(unshare)
+            retval = UA_Node_unshareValue((UA_Node*)(uintptr_t)orig);
+        if(retval == UA_STATUSCODE_GOOD)
+            retval = callback(server, session, (UA_Node*)(uintptr_t)orig, data);
+        UA_NODESTORE_RELEASE(server, orig);
+        return retval;
+    }
+    UA_NODESTORE_RELEASE(server, orig);
+#endif
     UA_StatusCode retval;
     do {
         /* Get an editable copy of the node */
@@ -290,8 +306,12 @@ UA_Server_editNode(UA_Server *server, UA_Session *session,
         if(retval != UA_STATUSCODE_GOOD)
             return retval;
 
-        /* Run the operation on the copy */
-        retval = callback(server, session, node, data);
+        /* Run the operation on the copy. The copy references the same shared
+         * value payload as the original. */
+        if(unshare)
+            retval = UA_Node_unshareValue(node);
+        if(retval == UA_STATUSCODE_GOOD)
+            retval = callback(server, session, node, data);
         if(retval != UA_STATUSCODE_GOOD) {
             UA_NODESTORE_DELETE(server, node);
             return retval;
@@ -301,7 +321,26 @@ UA_Server_editNode(UA_Server *server, UA_Session *session,
         retval = UA_NODESTORE_REPLACE(server, node);
     } while(retval != UA_STATUSCODE_GOOD);
     return retval;
-#endif
+}
+
+UA_StatusCode
+UA_Server_editNode(UA_Server *server, UA_Session *session,
+                   const UA_NodeId *nodeId, UA_EditNodeCallback callback,
+                   void *data) {
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_NODESTORE);
+    UA_StatusCode retval = editNode(server, session, nodeId, callback, data, true);
+    UA_MEMORYTAG_END();
+    return retval;
+}
+
+UA_StatusCode
+UA_Server_editNodeKeepShared(UA_Server *server, UA_Session *session,
+                             const UA_NodeId *nodeId, UA_EditNodeCallback callback,
+                             void *data) {
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_NODESTORE);
+    UA_StatusCode retval = editNode(server, session, nodeId, callback, data, false);
+    UA_MEMORYTAG_END();
+    return retval;
 }
 
 UA_StatusCode
@@ -310,7 +349,8 @@ UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
                                    const void *context, const size_t *requestOperations,
                                    const UA_DataType *requestOperationsType,
                                    size_t *responseOperations,
-                                   const UA_DataType *responseOperationsType) {
+                                   const UA_DataType *responseOperationsType,
+                                   UA_ServiceOperationsPrefetch prefetchCallback) {
     size_t ops = *requestOperations;
     if(ops == 0)
         return UA_STATUSCODE_BADNOTHINGTODO;
@@ -326,6 +366,12 @@ UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
     /* No padding after size_t */
     uintptr_t reqOp = *(uintptr_t*)((uintptr_t)requestOperations + sizeof(size_t));
     for(size_t i = 0; i < ops; i++) {
+        if(prefetchCallback && ops > 1 && i % UA_NODESTORE_BATCHSIZE == 0) {
+            size_t chunk = ops - i;
+            if(chunk > UA_NODESTORE_BATCHSIZE)
+                chunk = UA_NODESTORE_BATCHSIZE;
+            prefetchCallback(server, session, (void*)reqOp, chunk);
+        }
         operationCallback(server, session, context, (void*)reqOp, (void*)respOp);
         reqOp += requestOperationsType->memSize;
         respOp += responseOperationsType->memSize;
@@ -41,11 +41,13 @@ getUserWriteMask(UA_Server *server, const UA_Session *session,
         return 0xFFFFFFFF; /* the local admin user has all rights */
     UA_UInt32 mask = head->writeMask;
     UA_UNLOCK(&server->serviceMutex);
+    UA_TRACE_BEGIN(UA_TRACESTAGE_ACCESSCONTROL, "getUserRightsMask");
     mask &= server->config.accessControl.
         getUserRightsMask(server, &server->config.accessControl,
                           session ? &session->sessionId : NULL,
                           session ? session->sessionHandle : NULL,
                           &head->nodeId, head->context);
+    UA_TRACE_END();
     UA_LOCK(&server->serviceMutex);
     return mask;
 }
@@ -65,11 +67,13 @@ getUserAccessLevel(UA_Server *server, const UA_Session *session,
         return 0xFF; /* the local admin user has all rights */
     UA_Byte retval = node->accessLevel;
     UA_UNLOCK(&server->serviceMutex);
+    UA_TRACE_BEGIN(UA_TRACESTAGE_ACCESSCONTROL, "getUserAccessLevel");
     retval &= server->config.accessControl.
         getUserAccessLevel(server, &server->config.accessControl,
                            session ? &session->sessionId : NULL,
                            session ? session->sessionHandle : NULL,
                            &node->head.nodeId, node->head.context);
+    UA_TRACE_END();
     UA_LOCK(&server->serviceMutex);
     return retval;
 }
@@ -81,12 +85,14 @@ getUserExecutable(UA_Server *server, const UA_Session *session,
         return true; /* the local admin user has all rights */
     UA_UNLOCK(&server->serviceMutex);
     UA_Boolean userExecutable = node->executable;
+    UA_TRACE_BEGIN(UA_TRACESTAGE_ACCESSCONTROL, "getUserExecutable");
     userExecutable &=
         server->config.accessControl.
         getUserExecutable(server, &server->config.accessControl,
                           session ? &session->sessionId : NULL,
                           session ? session->sessionHandle : NULL,
                           &node->head.nodeId, node->head.context);
+    UA_TRACE_END();
     UA_LOCK(&server->serviceMutex);
     return userExecutable;
 }
@@ -159,12 +165,14 @@ readValueAttributeFromDataSource(UA_Server *server, UA_Session *session,
     UA_DataValue v2;
     UA_DataValue_init(&v2);
     UA_UNLOCK(&server->serviceMutex);
+    UA_TRACE_BEGIN(UA_TRACESTAGE_DATASOURCE, NULL);
     UA_StatusCode retval = vn->value.dataSource.
         read(server,
              session ? &session->sessionId : NULL,
              session ? session->sessionHandle : NULL,
              &vn->head.nodeId, vn->head.context,
              sourceTimeStamp, rangeptr, &v2);
+    UA_TRACE_END();
     UA_LOCK(&server->serviceMutex);
     if(v2.hasValue && v2.value.storageType == UA_VARIANT_DATA_NODELETE) {
         retval = UA_DataValue_copy(&v2, v);
@@ -333,6 +341,23 @@ getStructureDefinition(const UA_DataType *type, UA_StructureDefinition *def) {
 }
 #endif
 
+/* The DisplayName and Description might be compacted in the node */
+static UA_StatusCode
+readLocalizedTextAttribute(const UA_Node *node, UA_UInt32 attributeId,
+                           UA_Variant *v) {
+    UA_LocalizedText *lt = UA_LocalizedText_new();
+    if(!lt)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = (attributeId == UA_ATTRIBUTEID_DISPLAYNAME) ?
+        UA_Node_readDisplayName(node, lt) : UA_Node_readDescription(node, lt);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LocalizedText_delete(lt);
+        return res;
+    }
+    UA_Variant_setScalar(v, lt, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    return UA_STATUSCODE_GOOD;
+}
+
 /* Returns a datavalue that may point into the node via the
  * UA_VARIANT_DATA_NODELETE tag. Don't access the returned DataValue once the
  * node has been released! */
@@ -381,12 +406,8 @@ ReadWithNode(const UA_Node *node, UA_Server *server, UA_Session *session,
                                           &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
         break;
     case UA_ATTRIBUTEID_DISPLAYNAME:
-        retval = UA_Variant_setScalarCopy(&v->value, &node->head.displayName,
-                                          &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
-        break;
     case UA_ATTRIBUTEID_DESCRIPTION:
-        retval = UA_Variant_setScalarCopy(&v->value, &node->head.description,
-                                          &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+        retval = readLocalizedTextAttribute(node, id->attributeId, &v->value);
         break;
     case UA_ATTRIBUTEID_WRITEMASK:
         retval = UA_Variant_setScalarCopy(&v->value, &node->head.writeMask,
@@ -563,6 +584,17 @@ ReadWithNode(const UA_Node *node, UA_Server *server, UA_Session *session,
 static void
 Operation_Read(UA_Server *server, UA_Session *session, UA_ReadRequest *request,
                UA_ReadValueId *rvi, UA_DataValue *result) {
+    /* Registered nodes are pinned by the session. No lookup required. */
+    if(UA_Session_isRegisteredNodeHandle(session, &rvi->nodeId)) {
+        const UA_Node *rnode =
+            UA_Session_getRegisteredNodePtr(server, session, &rvi->nodeId);
+        if(rnode) {
+            ReadWithNode(rnode, server, session, request->timestampsToReturn,
+                         rvi, result);
+            return;
+        }
+    }
+
     /* Get the node */
     const UA_Node *node = UA_NODESTORE_GET(server, &rvi->nodeId);
 
@@ -576,6 +608,32 @@ Operation_Read(UA_Server *server, UA_Session *session, UA_ReadRequest *request,
     }
 }
 
+/* Prefetch the nodes for a chunk of operations from the nodestore. Registered
+ * node handles are resolved by the session without a nodestore lookup. */
+static void
+prefetchOperationNodes(UA_Server *server, UA_Session *session, const void *ops,
+                       size_t opsSize, const UA_DataType *opType,
+                       size_t nodeIdOffset) {
+    const UA_NodeId *nodeIds[UA_NODESTORE_BATCHSIZE];
+    size_t nodeIdsSize = 0;
+    uintptr_t op = (uintptr_t)ops;
+    for(size_t i = 0; i < opsSize && i < UA_NODESTORE_BATCHSIZE; i++) {
+        const UA_NodeId *id = (const UA_NodeId*)(op + nodeIdOffset);
+        if(!UA_Session_isRegisteredNodeHandle(session, id))
+            nodeIds[nodeIdsSize++] = id;
+        op += opType->memSize;
+    }
+    UA_NODESTORE_PREFETCH(server, nodeIdsSize, nodeIds);
+}
+
+static void
+prefetchRead(UA_Server *server, UA_Session *session,
+             const UA_ReadValueId *rvis, size_t rvisSize) {
+    prefetchOperationNodes(server, session, rvis, rvisSize,
+                           &UA_TYPES[UA_TYPES_READVALUEID],
+                           offsetof(UA_ReadValueId, nodeId));
+}
+
 void
 Service_Read(UA_Server *server, UA_Session *session,
              const UA_ReadRequest *request, UA_ReadResponse *response) {
@@ -609,7 +667,8 @@ Service_Read(UA_Server *server, UA_Session *session,
                                            request, &request->nodesToReadSize,
                                            &UA_TYPES[UA_TYPES_READVALUEID],
                                            &response->resultsSize,
-                                           &UA_TYPES[UA_TYPES_DATAVALUE]);
+                                           &UA_TYPES[UA_TYPES_DATAVALUE],
+                                           (UA_ServiceOperationsPrefetch)prefetchRead);
 }
 
 UA_DataValue
@@ -1020,6 +1079,9 @@ adjustValueType(UA_Server *server, UA_Variant *value,
     if(targetDataType == &UA_TYPES[UA_TYPES_BYTE] &&
        value->type == &UA_TYPES[UA_TYPES_BYTESTRING] &&
        UA_Variant_isScalar(value)) {
+        /* Never adjust a shared payload in-situ. Get a private copy first. */
+        if(UA_Variant_unshare(value) != UA_STATUSCODE_GOOD)
+            return;
         UA_ByteString *str = (UA_ByteString*)value->data;
         value->type = &UA_TYPES[UA_TYPES_BYTE];
         value->arrayLength = str->length;
@@ -1199,14 +1261,33 @@ writeDataTypeAttribute(UA_Server *server, UA_Session *session,
     return UA_STATUSCODE_GOOD;
 }
 
+/* Does the value data reach the minimum size? Heap-allocated content of the
+ * elements (e.g. the characters of a String array) is counted as well. */
+static UA_Boolean
+valueReachesSize(const UA_Variant *v, size_t minSize) {
+    size_t length = UA_Variant_isScalar(v) ? 1 : v->arrayLength;
+    if(length * v->type->memSize >= minSize)
+        return true;
+    if(v->type->pointerFree)
+        return false;
+    return UA_calcSizeBinary(v, &UA_TYPES[UA_TYPES_VARIANT]) >= minSize;
+}
+
 static UA_StatusCode
-writeValueAttributeWithoutRange(UA_VariableNode *node, const UA_DataValue *value) {
+writeValueAttributeWithoutRange(UA_VariableNode *node, const UA_DataValue *value,
+                                size_t sharedValueMinSize) {
     UA_DataValue new_value;
     UA_StatusCode retval = UA_DataValue_copy(value, &new_value);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
-    UA_DataValue_clear(&node->value.data.value);
+    UA_VariableNode_releaseValue(node);
     node->value.data.value = new_value;
+
+    /* Move large values into a shared payload. Ignore errors, the value is
+     * then kept as a private copy. */
+    if(sharedValueMinSize > 0 && new_value.hasValue && new_value.value.type &&
+       valueReachesSize(&new_value.value, sharedValueMinSize))
+        UA_VariableNode_shareValue(node);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -1233,10 +1314,14 @@ writeValueAttributeWithRange(UA_VariableNode *node, const UA_DataValue *value,
                         &v->type->typeId))
         return UA_STATUSCODE_BADTYPEMISMATCH;
 
+    /* Get a private copy if the value is shared */
+    UA_StatusCode retval = UA_VariableNode_unshareValue(node);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
     /* Write the value */
-    UA_StatusCode retval =
-        UA_Variant_setRangeCopy(&node->value.data.value.value,
-                                v->data, v->arrayLength, *rangeptr);
+    retval = UA_Variant_setRangeCopy(&node->value.data.value.value,
+                                     v->data, v->arrayLength, *rangeptr);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
 
@@ -1271,8 +1356,11 @@ writeNodeValueAttribute(UA_Server *server, UA_Session *session,
     }
 
     /* Created an editable version. The data is not touched. Only the variant
-     * "container". */
+     * "container". The editable version borrows a shared payload. The payload
+     * is then copied when the value is written. */
     UA_DataValue adjustedValue = *value;
+    if(adjustedValue.value.storageType == UA_VARIANT_DATA_SHARED)
+        adjustedValue.value.storageType = UA_VARIANT_DATA_NODELETE;
 
     /* Type checking. May change the type of editableValue */
     if(value->hasValue && value->value.type) {
@@ -1313,7 +1401,8 @@ writeNodeValueAttribute(UA_Server *server, UA_Session *session,
             /* Ok, do it */
             if(node->valueSource == UA_VALUESOURCE_DATA) {
                 if(!rangeptr)
-                    retval = writeValueAttributeWithoutRange(node, &adjustedValue);
+                    retval = writeValueAttributeWithoutRange(node, &adjustedValue,
+                                                             server->config.sharedValueMinSize);
                 else
                     retval = writeValueAttributeWithRange(node, &adjustedValue, rangeptr);
 
@@ -1325,10 +1414,12 @@ writeNodeValueAttribute(UA_Server *server, UA_Session *session,
                    node->head.nodeClass == UA_NODECLASS_VARIABLE &&
                    server->config.historyDatabase.setValue) {
                     UA_UNLOCK(&server->serviceMutex);
+                    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_HISTORY);
                     server->config.historyDatabase.
                         setValue(server, server->config.historyDatabase.context,
                                  &session->sessionId, session->sessionHandle,
                                  &node->head.nodeId, node->historizing, &adjustedValue);
+                    UA_MEMORYTAG_END();
                     UA_LOCK(&server->serviceMutex);
                 }
 #endif
@@ -1483,12 +1574,18 @@ copyAttributeIntoNode(UA_Server *server, UA_Session *session,
     case UA_ATTRIBUTEID_DISPLAYNAME:
         CHECK_USERWRITEMASK(UA_WRITEMASK_DISPLAYNAME);
         CHECK_DATATYPE_SCALAR(LOCALIZEDTEXT);
+        retval = UA_Node_expandAttributes(node);
+        if(retval != UA_STATUSCODE_GOOD)
+            break;
         retval = updateLocalizedText((const UA_LocalizedText *)value,
                                      &node->head.displayName);
         break;
     case UA_ATTRIBUTEID_DESCRIPTION:
         CHECK_USERWRITEMASK(UA_WRITEMASK_DESCRIPTION);
         CHECK_DATATYPE_SCALAR(LOCALIZEDTEXT);
+        retval = UA_Node_expandAttributes(node);
+        if(retval != UA_STATUSCODE_GOOD)
+            break;
         retval = updateLocalizedText((const UA_LocalizedText *)value,
                                      &node->head.description);
         break;
@@ -1620,11 +1717,47 @@ static void
 Operation_Write(UA_Server *server, UA_Session *session, void *context,
                 const UA_WriteValue *wv, UA_StatusCode *result) {
     UA_assert(session != NULL);
+
+    /* Registered nodes are edited in-situ without a lookup. With immutable
+     * nodes, the copy-and-replace goes through the registered NodeId. */
+    if(UA_Session_isRegisteredNodeHandle(session, &wv->nodeId)) {
+        UA_RegisteredNode *rn = UA_Session_getRegisteredNode(session, &wv->nodeId);
+        if(rn) {
+#ifndef UA_ENABLE_IMMUTABLE_NODES
+            const UA_Node *node =
+                UA_Session_getRegisteredNodePtr(server, session, &wv->nodeId);
+            if(!node) {
+                *result = UA_STATUSCODE_BADNODEIDUNKNOWN;
+                return;
+            }
+            UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_NODESTORE);
+            *result = UA_Node_unshareValue((UA_Node*)(uintptr_t)node);
+            if(*result == UA_STATUSCODE_GOOD)
+                *result = copyAttributeIntoNode(server, session,
+                                                (UA_Node*)(uintptr_t)node, wv);
+            UA_MEMORYTAG_END();
+#else
+            *result = UA_Server_editNode(server, session, &rn->nodeId,
+                                         (UA_EditNodeCallback)copyAttributeIntoNode,
+                                         (void*)(uintptr_t)wv);
+#endif
+            return;
+        }
+    }
+
     *result = UA_Server_editNode(server, session, &wv->nodeId,
                                  (UA_EditNodeCallback)copyAttributeIntoNode,
                                  (void*)(uintptr_t)wv);
 }
 
+static void
+prefetchWrite(UA_Server *server, UA_Session *session,
+              const UA_WriteValue *wvs, size_t wvsSize) {
+    prefetchOperationNodes(server, session, wvs, wvsSize,
+                           &UA_TYPES[UA_TYPES_WRITEVALUE],
+                           offsetof(UA_WriteValue, nodeId));
+}
+
 void
 Service_Write(UA_Server *server, UA_Session *session,
               const UA_WriteRequest *request,
@@ -1648,7 +1781,8 @@ Service_Write(UA_Server *server, UA_Session *session,
                                            &request->nodesToWriteSize,
                                            &UA_TYPES[UA_TYPES_WRITEVALUE],
                                            &response->resultsSize,
-                                           &UA_TYPES[UA_TYPES_STATUSCODE]);
+                                           &UA_TYPES[UA_TYPES_STATUSCODE],
+                                           (UA_ServiceOperationsPrefetch)prefetchWrite);
 }
 
 UA_StatusCode
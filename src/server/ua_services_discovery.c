@@ -83,6 +83,56 @@ setApplicationDescriptionFromRegisteredServer(const UA_FindServersRequest *reque
 
     return retval;
 }
+
+static UA_UInt32
+registeredServerHash(const UA_String *serverUri) {
+    return UA_ByteString_hash(0, serverUri->data, serverUri->length) %
+        REGISTERED_SERVER_HASH_SIZE;
+}
+
+static registeredServer_list_entry *
+findRegisteredServer(UA_DiscoveryManager *dm, const UA_String *serverUri) {
+    registeredServer_list_entry *current =
+        dm->registeredServersHash[registeredServerHash(serverUri)];
+    for(; current; current = current->hashNext) {
+        if(UA_String_equal(&current->registeredServer.serverUri, serverUri))
+            return current;
+    }
+    return NULL;
+}
+
+static void
+removeRegisteredServer(UA_Server *server, registeredServer_list_entry *entry) {
+    UA_DiscoveryManager *dm = &server->discoveryManager;
+    registeredServer_list_entry **prev =
+        &dm->registeredServersHash[registeredServerHash(&entry->registeredServer.serverUri)];
+    while(*prev != entry)
+        prev = &(*prev)->hashNext;
+    *prev = entry->hashNext;
+#ifdef UA_ENABLE_DISCOVERY_SEMAPHORE
+    if(entry->registeredServer.semaphoreFilePath.length > 0)
+        LIST_REMOVE(entry, semaphorePointers);
+#endif
+    TAILQ_REMOVE(&dm->registeredServers, entry, pointers);
+    UA_RegisteredServer_clear(&entry->registeredServer);
+    UA_free(entry);
+    dm->registeredServersSize--;
+    UA_DiscoveryCache_clear(&server->discoveryCache);
+}
+
+/* Compare the encoding. Re-registrations mostly come with the same content. */
+static UA_Boolean
+registeredServerEqual(const UA_RegisteredServer *a, const UA_RegisteredServer *b) {
+    UA_ByteString encA = UA_BYTESTRING_NULL;
+    UA_ByteString encB = UA_BYTESTRING_NULL;
+    UA_Boolean equal =
+        (UA_encodeBinary(a, &UA_TYPES[UA_TYPES_REGISTEREDSERVER], &encA) == UA_STATUSCODE_GOOD &&
+         UA_encodeBinary(b, &UA_TYPES[UA_TYPES_REGISTEREDSERVER], &encB) == UA_STATUSCODE_GOOD &&
+         UA_ByteString_equal(&encA, &encB));
+    UA_ByteString_clear(&encA);
+    UA_ByteString_clear(&encB);
+    return equal;
+}
 #endif
 
 static UA_StatusCode
@@ -168,20 +218,26 @@ void Service_FindServers(UA_Server *server, UA_Session *session,
     if(foundSelf)
         setApplicationDescriptionFromServer(&response->servers[pos++], server);
 
+    /* Return all registered servers. The most recently seen first. */
     registeredServer_list_entry* current;
-    LIST_FOREACH(current, &server->discoveryManager.registeredServers, pointers) {
-        UA_Boolean usable = (request->serverUrisSize == 0);
-        if(!usable) {
-            /* If client only requested a specific set of servers */
-            for(size_t i = 0; i < request->serverUrisSize; i++) {
-                if(UA_String_equal(&current->registeredServer.serverUri, &request->serverUris[i])) {
-                    usable = true;
-                    break;
-                }
-            }
+    if(request->serverUrisSize == 0) {
+        TAILQ_FOREACH_REVERSE(current, &server->discoveryManager.registeredServers,
+                              registeredServer_list, pointers) {
+            setApplicationDescriptionFromRegisteredServer(request, &response->servers[pos++],
+                                                          &current->registeredServer);
         }
+    }
 
-        if(usable)
+    /* If client only requested a specific set of servers. Look them up by
+     * hash. Skip duplicates in the request. */
+    for(size_t i = 0; i < request->serverUrisSize && pos < maxResults; i++) {
+        UA_Boolean duplicate = false;
+        for(size_t j = 0; j < i && !duplicate; j++)
+            duplicate = UA_String_equal(&request->serverUris[i], &request->serverUris[j]);
+        if(duplicate)
+            continue;
+        current = findRegisteredServer(&server->discoveryManager, &request->serverUris[i]);
+        if(current)
             setApplicationDescriptionFromRegisteredServer(request, &response->servers[pos++],
                                                           &current->registeredServer);
     }
@@ -280,6 +336,158 @@ error:
     response->endpointsSize = 0;
 }
 
+/*******************/
+/* Discovery Cache */
+/*******************/
+
+/* Requests with a larger filter are not cached */
+#define UA_DISCOVERYCACHE_MAXKEYSIZE 512
+
+void
+UA_DiscoveryCache_clear(UA_DiscoveryCache *dc) {
+    for(size_t i = 0; i < UA_DISCOVERYCACHE_SIZE; i++) {
+        UA_DiscoveryCacheEntry *entry = &dc->entries[i];
+        UA_ByteString_clear(&entry->key);
+        UA_ByteString_clear(&entry->body);
+        entry->requestType = NULL;
+    }
+    dc->next = 0;
+}
+
+/* Encode the request into the (stack-allocated) key buffer and strip the
+ * RequestHeader */
+static UA_StatusCode
+encodeDiscoveryCacheKey(const UA_Request *request, const UA_DataType *requestType,
+                        UA_ByteString *key) {
+    UA_StatusCode res = UA_encodeBinary(request, requestType, key);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    size_t headerSize = UA_calcSizeBinary(&request->requestHeader,
+                                          &UA_TYPES[UA_TYPES_REQUESTHEADER]);
+    key->data += headerSize;
+    key->length -= headerSize;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Encode the response without the ResponseHeader */
+static UA_StatusCode
+encodeDiscoveryCacheBody(const UA_Response *response, const UA_DataType *responseType,
+                         UA_ByteString *body) {
+    UA_ByteString encoded = UA_BYTESTRING_NULL;
+    UA_StatusCode res = UA_encodeBinary(response, responseType, &encoded);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    size_t headerSize = UA_calcSizeBinary(&response->responseHeader,
+                                          &UA_TYPES[UA_TYPES_RESPONSEHEADER]);
+    res = UA_ByteString_allocBuffer(body, encoded.length - headerSize);
+    if(res == UA_STATUSCODE_GOOD)
+        memcpy(body->data, &encoded.data[headerSize], body->length);
+    UA_ByteString_clear(&encoded);
+    return res;
+}
+
+static UA_UInt32
+hashString(UA_UInt32 h, const UA_String *s) {
+    h = UA_ByteString_hash(h, (const UA_Byte*)&s->length, sizeof(size_t));
+    return UA_ByteString_hash(h, s->data, s->length);
+}
+
+/* Hash the parts of the config that end up in the responses besides the
+ * endpoints. The endpoints contain the certificates and are compared by the
+ * pointer. */
+static UA_UInt32
+hashDiscoveryConfig(const UA_ServerConfig *config) {
+    const UA_ApplicationDescription *ad = &config->applicationDescription;
+    UA_UInt32 h = hashString(0, &ad->applicationUri);
+    h = hashString(h, &ad->productUri);
+    h = hashString(h, &ad->applicationName.locale);
+    h = hashString(h, &ad->applicationName.text);
+    h = UA_ByteString_hash(h, (const UA_Byte*)&ad->applicationType,
+                           sizeof(UA_ApplicationType));
+    h = hashString(h, &ad->gatewayServerUri);
+    h = hashString(h, &ad->discoveryProfileUri);
+    for(size_t i = 0; i < ad->discoveryUrlsSize; i++)
+        h = hashString(h, &ad->discoveryUrls[i]);
+    for(size_t i = 0; i < config->networkLayersSize; i++)
+        h = hashString(h, &config->networkLayers[i].discoveryUrl);
+    return h;
+}
+
+UA_Boolean
+UA_DiscoveryCache_get(UA_Server *server, UA_Session *session,
+                      const UA_Request *request, const UA_DataType *requestType,
+                      UA_Response *response, const UA_DataType *responseType,
+                      UA_ByteString *body) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    UA_assert(requestType == &UA_TYPES[UA_TYPES_GETENDPOINTSREQUEST] ||
+              requestType == &UA_TYPES[UA_TYPES_FINDSERVERSREQUEST]);
+
+    /* The endpoints or the ApplicationDescription were reconfigured. Drop the
+     * cached responses. */
+    UA_DiscoveryCache *dc = &server->discoveryCache;
+    UA_UInt32 descriptionHash = hashDiscoveryConfig(&server->config);
+    if(dc->endpoints != server->config.endpoints ||
+       dc->endpointsSize != server->config.endpointsSize ||
+       dc->networkLayersSize != server->config.networkLayersSize ||
+       dc->descriptionHash != descriptionHash) {
+        UA_DiscoveryCache_clear(dc);
+        dc->endpoints = server->config.endpoints;
+        dc->endpointsSize = server->config.endpointsSize;
+        dc->networkLayersSize = server->config.networkLayersSize;
+        dc->descriptionHash = descriptionHash;
+    }
+
+    /* Look up the cached response */
+    UA_Byte keyBuf[UA_DISCOVERYCACHE_MAXKEYSIZE];
+    UA_ByteString key = {UA_DISCOVERYCACHE_MAXKEYSIZE, keyBuf};
+    UA_Boolean cacheable =
+        (encodeDiscoveryCacheKey(request, requestType, &key) == UA_STATUSCODE_GOOD);
+    if(cacheable) {
+        for(size_t i = 0; i < UA_DISCOVERYCACHE_SIZE; i++) {
+            UA_DiscoveryCacheEntry *entry = &dc->entries[i];
+            if(entry->requestType == requestType &&
+               UA_ByteString_equal(&entry->key, &key)) {
+                if(UA_ByteString_copy(&entry->body, body) != UA_STATUSCODE_GOOD)
+                    break;
+                dc->hits++;
+                return true;
+            }
+        }
+    }
+
+    /* Cache miss. Call the service. */
+    if(requestType == &UA_TYPES[UA_TYPES_GETENDPOINTSREQUEST])
+        Service_GetEndpoints(server, session, &request->getEndpointsRequest,
+                             &response->getEndpointsResponse);
+    else
+        Service_FindServers(server, session, &request->findServersRequest,
+                            &response->findServersResponse);
+    if(!cacheable || response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+        return false;
+
+    /* Encode into the cache. Replace the oldest entry. */
+    UA_ByteString ownBody, ownKey;
+    if(encodeDiscoveryCacheBody(response, responseType, &ownBody) != UA_STATUSCODE_GOOD)
+        return false;
+    if(UA_ByteString_copy(&key, &ownKey) != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&ownBody);
+        return false;
+    }
+    if(UA_ByteString_copy(&ownBody, body) != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&ownBody);
+        UA_ByteString_clear(&ownKey);
+        return false;
+    }
+    UA_DiscoveryCacheEntry *entry = &dc->entries[dc->next];
+    UA_ByteString_clear(&entry->key);
+    UA_ByteString_clear(&entry->body);
+    entry->requestType = requestType;
+    entry->key = ownKey;
+    entry->body = ownBody;
+    dc->next = (dc->next + 1) % UA_DISCOVERYCACHE_SIZE;
+    return true;
+}
+
 #ifdef UA_ENABLE_DISCOVERY
 
 static void
@@ -296,14 +504,9 @@ process_RegisterServer(UA_Server *server, UA_Session *session,
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     /* Find the server from the request in the registered list */
-    registeredServer_list_entry* current;
-    registeredServer_list_entry *registeredServer_entry = NULL;
-    LIST_FOREACH(current, &server->discoveryManager.registeredServers, pointers) {
-        if(UA_String_equal(&current->registeredServer.serverUri, &requestServer->serverUri)) {
-            registeredServer_entry = current;
-            break;
-        }
-    }
+    UA_DiscoveryManager *dm = &server->discoveryManager;
+    registeredServer_list_entry *registeredServer_entry =
+        findRegisteredServer(dm, &requestServer->serverUri);
 
     UA_MdnsDiscoveryConfiguration *mdnsConfig = NULL;
 
@@ -402,11 +605,11 @@ process_RegisterServer(UA_Server *server, UA_Session *session,
             UA_LOCK(&server->serviceMutex);
         }
 
-        // server found, remove from list
-        LIST_REMOVE(registeredServer_entry, pointers);
-        UA_RegisteredServer_clear(&registeredServer_entry->registeredServer);
-        UA_free(registeredServer_entry);
-        server->discoveryManager.registeredServersSize--;
+        // server found, remove from list. Look up again, the lock was released
+        // during the callback.
+        registeredServer_entry = findRegisteredServer(dm, &requestServer->serverUri);
+        if(registeredServer_entry)
+            removeRegisteredServer(server, registeredServer_entry);
         responseHeader->serviceResult = UA_STATUSCODE_GOOD;
         return;
     }
@@ -424,11 +627,48 @@ process_RegisterServer(UA_Server *server, UA_Session *session,
             return;
         }
 
-        LIST_INSERT_HEAD(&server->discoveryManager.registeredServers, registeredServer_entry, pointers);
-        UA_atomic_addSize(&server->discoveryManager.registeredServersSize, 1);
+        // copy the data from the request into the list
+        retval = UA_RegisteredServer_copy(requestServer, &registeredServer_entry->registeredServer);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_free(registeredServer_entry);
+            responseHeader->serviceResult = retval;
+            return;
+        }
+
+        UA_UInt32 hashIdx = registeredServerHash(&requestServer->serverUri);
+        registeredServer_entry->hashNext = dm->registeredServersHash[hashIdx];
+        dm->registeredServersHash[hashIdx] = registeredServer_entry;
+#ifdef UA_ENABLE_DISCOVERY_SEMAPHORE
+        if(requestServer->semaphoreFilePath.length > 0)
+            LIST_INSERT_HEAD(&dm->semaphoreServers, registeredServer_entry, semaphorePointers);
+#endif
+        UA_atomic_addSize(&dm->registeredServersSize, 1);
+        UA_DiscoveryCache_clear(&server->discoveryCache);
     } else {
-        UA_RegisteredServer_clear(&registeredServer_entry->registeredServer);
+        // Move to the end of the list sorted by lastSeen
+        TAILQ_REMOVE(&dm->registeredServers, registeredServer_entry, pointers);
+
+        // Replace the data only if it has changed. Keep the precomputed
+        // FindServers responses otherwise.
+        UA_RegisteredServer changed;
+        if(!registeredServerEqual(requestServer, &registeredServer_entry->registeredServer) &&
+           (retval = UA_RegisteredServer_copy(requestServer, &changed)) == UA_STATUSCODE_GOOD) {
+#ifdef UA_ENABLE_DISCOVERY_SEMAPHORE
+            if(registeredServer_entry->registeredServer.semaphoreFilePath.length > 0)
+                LIST_REMOVE(registeredServer_entry, semaphorePointers);
+#endif
+            UA_RegisteredServer_clear(&registeredServer_entry->registeredServer);
+            registeredServer_entry->registeredServer = changed;
+#ifdef UA_ENABLE_DISCOVERY_SEMAPHORE
+            if(registeredServer_entry->registeredServer.semaphoreFilePath.length > 0)
+                LIST_INSERT_HEAD(&dm->semaphoreServers, registeredServer_entry,
+                                 semaphorePointers);
+#endif
+            UA_DiscoveryCache_clear(&server->discoveryCache);
+        }
     }
+    registeredServer_entry->lastSeen = UA_DateTime_nowMonotonic();
+    TAILQ_INSERT_TAIL(&dm->registeredServers, registeredServer_entry, pointers);
 
     // Always call the callback, if it is set.
     // Previously we only called it if it was a new register call. It may be the case that this endpoint
@@ -442,9 +682,6 @@ process_RegisterServer(UA_Server *server, UA_Session *session,
         UA_LOCK(&server->serviceMutex);
     }
 
-    // copy the data from the request into the list
-    UA_RegisteredServer_copy(requestServer, &registeredServer_entry->registeredServer);
-    registeredServer_entry->lastSeen = UA_DateTime_nowMonotonic();
     responseHeader->serviceResult = retval;
 }
 
@@ -474,58 +711,59 @@ void Service_RegisterServer2(UA_Server *server, UA_Session *session,
 /* Cleanup server registration: If the semaphore file path is set, then it just
  * checks the existence of the file. When it is deleted, the registration is
  * removed. If there is no semaphore file, then the registration will be removed
- * if it is older than 60 minutes. */
+ * if it is older than 60 minutes. Only the registrations with a semaphore file
+ * and the expired registrations at the front of the list are visited. */
 void UA_Discovery_cleanupTimedOut(UA_Server *server, UA_DateTime nowMonotonic) {
-    UA_DateTime timedOut = nowMonotonic;
-    // registration is timed out if lastSeen is older than 60 minutes (default
-    // value, can be modified by user).
-    if(server->config.discoveryCleanupTimeout)
-        timedOut -= server->config.discoveryCleanupTimeout * UA_DATETIME_SEC;
-
-    registeredServer_list_entry* current, *temp;
-    LIST_FOREACH_SAFE(current, &server->discoveryManager.registeredServers, pointers, temp) {
-        UA_Boolean semaphoreDeleted = false;
+    UA_DiscoveryManager *dm = &server->discoveryManager;
+    registeredServer_list_entry* current;
 
 #ifdef UA_ENABLE_DISCOVERY_SEMAPHORE
-        if(current->registeredServer.semaphoreFilePath.length) {
-            size_t fpSize = sizeof(char)*current->registeredServer.semaphoreFilePath.length+1;
-            // todo: malloc may fail: return a statuscode
-            char* filePath = (char *)UA_malloc(fpSize);
-            if(filePath) {
-                memcpy(filePath, current->registeredServer.semaphoreFilePath.data,
-                       current->registeredServer.semaphoreFilePath.length );
-                filePath[current->registeredServer.semaphoreFilePath.length] = '\0';
-                semaphoreDeleted = UA_fileExists(filePath) == false;
-                UA_free(filePath);
-            } else {
-                UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_SERVER,
-                             "Cannot check registration semaphore. Out of memory");
-            }
+    registeredServer_list_entry *temp;
+    LIST_FOREACH_SAFE(current, &dm->semaphoreServers, semaphorePointers, temp) {
+        size_t fpSize = sizeof(char)*current->registeredServer.semaphoreFilePath.length+1;
+        // todo: malloc may fail: return a statuscode
+        char* filePath = (char *)UA_malloc(fpSize);
+        if(!filePath) {
+            UA_LOG_ERROR(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                         "Cannot check registration semaphore. Out of memory");
+            continue;
         }
+        memcpy(filePath, current->registeredServer.semaphoreFilePath.data,
+               current->registeredServer.semaphoreFilePath.length );
+        filePath[current->registeredServer.semaphoreFilePath.length] = '\0';
+        UA_Boolean semaphoreDeleted = UA_fileExists(filePath) == false;
+        UA_free(filePath);
+        if(!semaphoreDeleted)
+            continue;
+
+        UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                    "Registration of server with URI %.*s is removed because "
+                    "the semaphore file '%.*s' was deleted.",
+                    (int)current->registeredServer.serverUri.length,
+                    current->registeredServer.serverUri.data,
+                    (int)current->registeredServer.semaphoreFilePath.length,
+                    current->registeredServer.semaphoreFilePath.data);
+        removeRegisteredServer(server, current);
+    }
 #endif
 
-        if(semaphoreDeleted || (server->config.discoveryCleanupTimeout &&
-                                current->lastSeen < timedOut)) {
-            if(semaphoreDeleted) {
-                UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
-                            "Registration of server with URI %.*s is removed because "
-                            "the semaphore file '%.*s' was deleted.",
-                            (int)current->registeredServer.serverUri.length,
-                            current->registeredServer.serverUri.data,
-                            (int)current->registeredServer.semaphoreFilePath.length,
-                            current->registeredServer.semaphoreFilePath.data);
-            } else {
-                // cppcheck-suppress unreadVariable
-                UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
-                            "Registration of server with URI %.*s has timed out and is removed.",
-                            (int)current->registeredServer.serverUri.length,
-                            current->registeredServer.serverUri.data);
-            }
-            LIST_REMOVE(current, pointers);
-            UA_RegisteredServer_clear(&current->registeredServer);
-            UA_free(current);
-            server->discoveryManager.registeredServersSize--;
-        }
+    // registration is timed out if lastSeen is older than 60 minutes (default
+    // value, can be modified by user).
+    if(!server->config.discoveryCleanupTimeout)
+        return;
+    UA_DateTime timedOut = nowMonotonic -
+        server->config.discoveryCleanupTimeout * UA_DATETIME_SEC;
+
+    // The list is sorted by lastSeen. Stop at the first registration that has
+    // not timed out.
+    while((current = TAILQ_FIRST(&dm->registeredServers)) &&
+          current->lastSeen < timedOut) {
+        // cppcheck-suppress unreadVariable
+        UA_LOG_INFO(&server->config.logger, UA_LOGCATEGORY_SERVER,
+                    "Registration of server with URI %.*s has timed out and is removed.",
+                    (int)current->registeredServer.serverUri.length,
+                    current->registeredServer.serverUri.data);
+        removeRegisteredServer(server, current);
     }
 }
 
@@ -253,10 +253,12 @@ callWithMethodAndObject(UA_Server *server, UA_Session *session,
     UA_Boolean executable = method->executable;
     if(session != &server->adminSession) {
         UA_UNLOCK(&server->serviceMutex);
+        UA_TRACE_BEGIN(UA_TRACESTAGE_ACCESSCONTROL, "getUserExecutableOnObject");
         executable = executable && server->config.accessControl.
             getUserExecutableOnObject(server, &server->config.accessControl, &session->sessionId,
                                       session->sessionHandle, &request->methodId, method->head.context,
                                       &request->objectId, object->head.context);
+        UA_TRACE_END();
         UA_LOCK(&server->serviceMutex);
     }
 
@@ -449,7 +451,7 @@ void Service_Call(UA_Server *server, UA_Session *session,
         UA_Server_processServiceOperations(server, session,
                   (UA_ServiceOperation)Operation_CallMethod, NULL,
                   &request->methodsToCallSize, &UA_TYPES[UA_TYPES_CALLMETHODREQUEST],
-                  &response->resultsSize, &UA_TYPES[UA_TYPES_CALLMETHODRESULT]);
+                  &response->resultsSize, &UA_TYPES[UA_TYPES_CALLMETHODRESULT], NULL);
 }
 
 UA_CallMethodResult
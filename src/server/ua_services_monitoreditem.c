@@ -458,7 +458,8 @@ Service_CreateMonitoredItems(UA_Server *server, UA_Session *session,
     response->responseHeader.serviceResult =
         UA_Server_processServiceOperations(server, session, (UA_ServiceOperation)Operation_CreateMonitoredItem, &cmc,
                                            &request->itemsToCreateSize, &UA_TYPES[UA_TYPES_MONITOREDITEMCREATEREQUEST],
-                                           &response->resultsSize, &UA_TYPES[UA_TYPES_MONITOREDITEMCREATERESULT]);
+                                           &response->resultsSize, &UA_TYPES[UA_TYPES_MONITOREDITEMCREATERESULT],
+                                           NULL);
 }
 
 UA_MonitoredItemCreateResult
@@ -578,7 +579,8 @@ Service_ModifyMonitoredItems(UA_Server *server, UA_Session *session,
         UA_Server_processServiceOperations(server, session,
                   (UA_ServiceOperation)Operation_ModifyMonitoredItem, sub,
                   &request->itemsToModifySize, &UA_TYPES[UA_TYPES_MONITOREDITEMMODIFYREQUEST],
-                  &response->resultsSize, &UA_TYPES[UA_TYPES_MONITOREDITEMMODIFYRESULT]);
+                  &response->resultsSize, &UA_TYPES[UA_TYPES_MONITOREDITEMMODIFYRESULT],
+                  NULL);
 }
 
 struct setMonitoringContext {
@@ -626,7 +628,7 @@ Service_SetMonitoringMode(UA_Server *server, UA_Session *session,
         UA_Server_processServiceOperations(server, session,
                   (UA_ServiceOperation)Operation_SetMonitoringMode, &smc,
                   &request->monitoredItemIdsSize, &UA_TYPES[UA_TYPES_UINT32],
-                  &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+                  &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE], NULL);
 }
 
 static void
@@ -669,7 +671,7 @@ Service_DeleteMonitoredItems(UA_Server *server, UA_Session *session,
         UA_Server_processServiceOperations(server, session,
                   (UA_ServiceOperation)Operation_DeleteMonitoredItem, sub,
                   &request->monitoredItemIdsSize, &UA_TYPES[UA_TYPES_UINT32],
-                  &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+                  &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE], NULL);
 }
 
 UA_StatusCode
@@ -76,8 +76,9 @@ UA_StatusCode
 UA_Server_setNodeContext(UA_Server *server, UA_NodeId nodeId,
                          void *nodeContext) {
     UA_LOCK(&server->serviceMutex);
-    UA_StatusCode retval = UA_Server_editNode(server, &server->adminSession, &nodeId,
-                              (UA_EditNodeCallback)editNodeContext, nodeContext);
+    UA_StatusCode retval =
+        UA_Server_editNodeKeepShared(server, &server->adminSession, &nodeId,
+                                     (UA_EditNodeCallback)editNodeContext, nodeContext);
     UA_UNLOCK(&server->serviceMutex);
     return retval;
 }
@@ -539,6 +540,31 @@ static UA_StatusCode
 copyAllChildren(UA_Server *server, UA_Session *session,
                 const UA_NodeId *source, const UA_NodeId *destination);
 
+static UA_StatusCode
+shareValueCallback(UA_Server *server, UA_Session *session,
+                   UA_VariableNode *node, void *_) {
+    return UA_VariableNode_shareValue(node);
+}
+
+/* Move the value of the variable in the type definition into a shared value.
+ * The copies made for the instances then share the value (copy-on-write). */
+static void
+shareTypeChildValue(UA_Server *server, UA_Session *session,
+                    const UA_NodeId *nodeId) {
+    const UA_Node *node = UA_NODESTORE_GET(server, nodeId);
+    if(!node)
+        return;
+    const UA_VariableNode *vn = &node->variableNode;
+    UA_Boolean share = (node->head.nodeClass == UA_NODECLASS_VARIABLE &&
+                        vn->valueSource == UA_VALUESOURCE_DATA &&
+                        vn->value.data.value.value.storageType == UA_VARIANT_DATA &&
+                        vn->value.data.value.value.type != NULL);
+    UA_NODESTORE_RELEASE(server, node);
+    if(share) /* Ignore errors. The instance then gets a deep copy. */
+        UA_Server_editNode(server, session, nodeId,
+                           (UA_EditNodeCallback)shareValueCallback, NULL);
+}
+
 static UA_StatusCode
 recursiveTypeCheckAddChildren(UA_Server *server, UA_Session *session,
                               const UA_Node **node, const UA_Node *type);
@@ -604,6 +630,11 @@ copyChild(UA_Server *server, UA_Session *session,
     /* Child is a variable or object */
     if(rd->nodeClass == UA_NODECLASS_VARIABLE ||
        rd->nodeClass == UA_NODECLASS_OBJECT) {
+        /* Share the value instead of a deep copy */
+        if(rd->nodeClass == UA_NODECLASS_VARIABLE &&
+           server->config.shareTypeChildValues)
+            shareTypeChildValue(server, session, &rd->nodeId.nodeId);
+
         /* Make a copy of the node */
         UA_Node *node;
         retval = UA_NODESTORE_GETCOPY(server, &rd->nodeId.nodeId, &node);
@@ -758,6 +789,20 @@ addInterfaceChildren(UA_Server *server, UA_Session *session,
     return retval;
 }
 
+struct AddNodeInfo {
+    UA_Byte refTypeIndex;
+    UA_Boolean isForward;
+    const UA_ExpandedNodeId *targetNodeId;
+    UA_UInt32 targetBrowseNameHash;
+};
+
+static UA_StatusCode
+addOneWayReference(UA_Server *server, UA_Session *session, UA_Node *node,
+                   const struct AddNodeInfo *info) {
+    return UA_Node_addReference(node, info->refTypeIndex, info->isForward,
+                                info->targetNodeId, info->targetBrowseNameHash);
+}
+
 static UA_StatusCode
 addRef(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
        const UA_NodeId *referenceTypeId, const UA_NodeId *parentNodeId,
@@ -774,16 +819,74 @@ addRef(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
     return retval;
 }
 
+/* Forward references from a common parent to the nodes of an AddNodes batch.
+ * The new nodes get their inverse reference to the parent right away. The
+ * forward references are collected and added to the parent in a single edit
+ * with UA_Node_addReferences. */
+typedef struct {
+    UA_Byte refTypeIndex;
+    UA_ExpandedNodeId parentNodeId;
+    UA_UInt32 parentNameHash;
+
+    /* Set for the current node when its forward reference is pending */
+    UA_Boolean pending;
+    UA_UInt32 nameHash;
+
+    /* The pending forward references and the position of their item */
+    size_t targetsSize;
+    UA_ExpandedNodeId *targets;
+    UA_UInt32 *nameHashes;
+    size_t *positions;
+} UA_ParentReferences;
+
+static UA_StatusCode
+addParentRefDeferred(UA_Server *server, UA_Session *session, const UA_NodeHead *head,
+                     const UA_NodeId *referenceTypeId, UA_ParentReferences *pr) {
+    /* Check access rights */
+    if(session != &server->adminSession &&
+       server->config.accessControl.allowAddReference) {
+        UA_AddReferencesItem item;
+        UA_AddReferencesItem_init(&item);
+        item.sourceNodeId = head->nodeId;
+        item.referenceTypeId = *referenceTypeId;
+        item.isForward = false;
+        item.targetNodeId = pr->parentNodeId;
+        UA_UNLOCK(&server->serviceMutex);
+        UA_Boolean allowed = server->config.accessControl.
+            allowAddReference(server, &server->config.accessControl,
+                              &session->sessionId, session->sessionHandle, &item);
+        UA_LOCK(&server->serviceMutex);
+        if(!allowed)
+            return UA_STATUSCODE_BADUSERACCESSDENIED;
+    }
+
+    struct AddNodeInfo info;
+    info.refTypeIndex = pr->refTypeIndex;
+    info.isForward = false;
+    info.targetNodeId = &pr->parentNodeId;
+    info.targetBrowseNameHash = pr->parentNameHash;
+    UA_StatusCode retval =
+        UA_Server_editNodeKeepShared(server, session, &head->nodeId,
+                                     (UA_EditNodeCallback)addOneWayReference, &info);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    pr->pending = true;
+    pr->nameHash = UA_QualifiedName_hash(&head->browseName);
+    return UA_STATUSCODE_GOOD;
+}
+
 /************/
 /* Add Node */
 /************/
 
 static const UA_NodeId hasSubtype = {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_HASSUBTYPE}};
 
-UA_StatusCode
-AddNode_addRefs(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
-                const UA_NodeId *parentNodeId, const UA_NodeId *referenceTypeId,
-                const UA_NodeId *typeDefinitionId) {
+/* If parentRefs is set, the forward reference from the parent is deferred */
+static UA_StatusCode
+addNodeRefs(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
+            const UA_NodeId *parentNodeId, const UA_NodeId *referenceTypeId,
+            const UA_NodeId *typeDefinitionId, UA_ParentReferences *parentRefs) {
     /* Get the node */
     const UA_Node *type = NULL;
     const UA_Node *node = UA_NODESTORE_GET(server, nodeId);
@@ -950,8 +1053,12 @@ AddNode_addRefs(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
             goto cleanup;
         }
 
-        retval = addRef(server, session, &head->nodeId, referenceTypeId,
-                        parentNodeId, false);
+        if(parentRefs)
+            retval = addParentRefDeferred(server, session, head,
+                                          referenceTypeId, parentRefs);
+        else
+            retval = addRef(server, session, &head->nodeId, referenceTypeId,
+                            parentNodeId, false);
         if(retval != UA_STATUSCODE_GOOD) {
             logAddNode(&server->config.logger, session, nodeId,
                        "Adding reference to parent failed");
@@ -977,6 +1084,14 @@ AddNode_addRefs(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
     return retval;
 }
 
+UA_StatusCode
+AddNode_addRefs(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
+                const UA_NodeId *parentNodeId, const UA_NodeId *referenceTypeId,
+                const UA_NodeId *typeDefinitionId) {
+    return addNodeRefs(server, session, nodeId, parentNodeId, referenceTypeId,
+                       typeDefinitionId, NULL);
+}
+
 /* Create the node and add it to the nodestore. But don't typecheck and add
  * references so far */
 UA_StatusCode
@@ -1122,7 +1237,8 @@ checkSetBrowseName(UA_Server *server, UA_Session *session, UA_AddNodesItem *item
 static UA_StatusCode
 Operation_addNode_begin(UA_Server *server, UA_Session *session, void *nodeContext,
                         const UA_AddNodesItem *item, const UA_NodeId *parentNodeId,
-                        const UA_NodeId *referenceTypeId, UA_NodeId *outNewNodeId) {
+                        const UA_NodeId *referenceTypeId, UA_NodeId *outNewNodeId,
+                        UA_ParentReferences *parentRefs) {
     /* Create a temporary NodeId if none is returned */
     UA_NodeId newId;
     if(!outNewNodeId) {
@@ -1143,10 +1259,13 @@ Operation_addNode_begin(UA_Server *server, UA_Session *session, void *nodeContex
         goto cleanup;
 
     /* Typecheck and add references to parent and type definition */
-    retval = AddNode_addRefs(server, session, outNewNodeId, parentNodeId,
-                             referenceTypeId, &item->typeDefinition.nodeId);
-    if(retval != UA_STATUSCODE_GOOD)
+    retval = addNodeRefs(server, session, outNewNodeId, parentNodeId,
+                         referenceTypeId, &item->typeDefinition.nodeId, parentRefs);
+    if(retval != UA_STATUSCODE_GOOD) {
         deleteNode(server, *outNewNodeId, true);
+        if(parentRefs)
+            parentRefs->pending = false;
+    }
 
     if(outNewNodeId == &newId)
         UA_NodeId_clear(&newId);
@@ -1330,8 +1449,10 @@ recursiveCallConstructors(UA_Server *server, UA_Session *session,
     }
 
     /* Set the context *and* mark the node as constructed */
-    retval = UA_Server_editNode(server, &server->adminSession, &head->nodeId,
-                                (UA_EditNodeCallback)setConstructedNodeContext, context);
+    retval = UA_Server_editNodeKeepShared(server, &server->adminSession,
+                                          &head->nodeId,
+                                          (UA_EditNodeCallback)setConstructedNodeContext,
+                                          context);
     if(retval != UA_STATUSCODE_GOOD)
         goto local_destructor;
 
@@ -1385,8 +1506,9 @@ setReferenceTypeSubtypes(UA_Server *server, const UA_ReferenceTypeNode *node) {
     /* Add the ReferenceTypeIndex of this node */
     const UA_ReferenceTypeSet *newRefSet = &node->subTypes;
     for(size_t i = 0; i < parentsSize; i++) {
-        UA_Server_editNode(server, &server->adminSession, &parents[i].nodeId,
-                           addReferenceTypeSubtype, (void*)(uintptr_t)newRefSet);
+        UA_Server_editNodeKeepShared(server, &server->adminSession,
+                                     &parents[i].nodeId, addReferenceTypeSubtype,
+                                     (void*)(uintptr_t)newRefSet);
     }
 
     UA_Array_delete(parents, parentsSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
@@ -1443,8 +1565,8 @@ checkSetIsDynamicVariable(UA_Server *server, UA_Session *session,
         return UA_STATUSCODE_GOOD;
 
     /* Set the variable to "dynamic" */
-    UA_Server_editNode(server, session, nodeId,
-                       (UA_EditNodeCallback)setVariableNodeDynamic, NULL);
+    UA_Server_editNodeKeepShared(server, session, nodeId,
+                                 (UA_EditNodeCallback)setVariableNodeDynamic, NULL);
     
     return UA_STATUSCODE_GOOD;
 }
@@ -1521,18 +1643,141 @@ AddNode_finish(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId)
 static void
 Operation_addNode(UA_Server *server, UA_Session *session, void *nodeContext,
                   const UA_AddNodesItem *item, UA_AddNodesResult *result) {
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_NODESTORE);
     result->statusCode =
         Operation_addNode_begin(server, session, nodeContext, item, &item->parentNodeId.nodeId,
-                                &item->referenceTypeId, &result->addedNodeId);
-    if(result->statusCode != UA_STATUSCODE_GOOD)
-        return;
+                                &item->referenceTypeId, &result->addedNodeId, NULL);
 
     /* AddNodes_finish */
-    result->statusCode = AddNode_finish(server, session, &result->addedNodeId);
+    if(result->statusCode == UA_STATUSCODE_GOOD) {
+        result->statusCode = AddNode_finish(server, session, &result->addedNodeId);
 
-    /* If finishing failed, the node was deleted */
-    if(result->statusCode != UA_STATUSCODE_GOOD)
-        UA_NodeId_clear(&result->addedNodeId);
+        /* If finishing failed, the node was deleted */
+        if(result->statusCode != UA_STATUSCODE_GOOD)
+            UA_NodeId_clear(&result->addedNodeId);
+    }
+    UA_MEMORYTAG_END();
+}
+
+static UA_StatusCode
+addParentReferences(UA_Server *server, UA_Session *session, UA_Node *node,
+                    const UA_ParentReferences *pr) {
+    return UA_Node_addReferences(node, pr->refTypeIndex, true, pr->targetsSize,
+                                 pr->targets, pr->nameHashes);
+}
+
+static UA_Boolean
+sameParentReference(const UA_AddNodesItem *a, const UA_AddNodesItem *b) {
+    return UA_NodeId_equal(&a->parentNodeId.nodeId, &b->parentNodeId.nodeId) &&
+        UA_NodeId_equal(&a->referenceTypeId, &b->referenceTypeId);
+}
+
+static UA_StatusCode
+UA_ParentReferences_init(UA_Server *server, UA_ParentReferences *pr,
+                         const UA_NodeId *parentNodeId,
+                         const UA_NodeId *referenceTypeId, size_t itemsSize) {
+    memset(pr, 0, sizeof(UA_ParentReferences));
+    if(UA_NodeId_isNull(parentNodeId) || UA_NodeId_isNull(referenceTypeId))
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    const UA_Node *refType = UA_NODESTORE_GET(server, referenceTypeId);
+    if(!refType)
+        return UA_STATUSCODE_BADREFERENCETYPEIDINVALID;
+    UA_NodeClass refTypeClass = refType->head.nodeClass;
+    pr->refTypeIndex = refType->referenceTypeNode.referenceTypeIndex;
+    UA_NODESTORE_RELEASE(server, refType);
+    if(refTypeClass != UA_NODECLASS_REFERENCETYPE)
+        return UA_STATUSCODE_BADREFERENCETYPEIDINVALID;
+
+    const UA_Node *parent = UA_NODESTORE_GET(server, parentNodeId);
+    if(!parent)
+        return UA_STATUSCODE_BADPARENTNODEIDINVALID;
+    pr->parentNameHash = UA_QualifiedName_hash(&parent->head.browseName);
+    UA_NODESTORE_RELEASE(server, parent);
+    pr->parentNodeId.nodeId = *parentNodeId;
+
+    pr->targets = (UA_ExpandedNodeId*)
+        UA_calloc(itemsSize, sizeof(UA_ExpandedNodeId));
+    pr->nameHashes = (UA_UInt32*)UA_malloc(itemsSize * sizeof(UA_UInt32));
+    pr->positions = (size_t*)UA_malloc(itemsSize * sizeof(size_t));
+    if(!pr->targets || !pr->nameHashes || !pr->positions)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+UA_ParentReferences_clear(UA_ParentReferences *pr) {
+    UA_free(pr->targets);
+    UA_free(pr->nameHashes);
+    UA_free(pr->positions);
+}
+
+/* Add consecutive items with the same parent and ReferenceType. The nodes are
+ * first created with their references. Then the forward references of the
+ * parent are added in a single edit. Last, the nodes are finished (children,
+ * constructors) one by one. If the parent or the ReferenceType cannot be
+ * resolved, the items are added individually and return the matching error. */
+static void
+Operation_addNodes(UA_Server *server, UA_Session *session,
+                   const UA_AddNodesItem *items, UA_AddNodesResult *results,
+                   size_t itemsSize) {
+    const UA_NodeId *parentNodeId = &items[0].parentNodeId.nodeId;
+    const UA_NodeId *referenceTypeId = &items[0].referenceTypeId;
+    UA_ParentReferences pr;
+    UA_StatusCode retval = UA_ParentReferences_init(server, &pr, parentNodeId,
+                                                    referenceTypeId, itemsSize);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_ParentReferences_clear(&pr);
+        for(size_t i = 0; i < itemsSize; i++)
+            Operation_addNode(server, session, NULL, &items[i], &results[i]);
+        return;
+    }
+
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_NODESTORE);
+
+    /* Create the nodes. The targets point to the NodeIds in the results. */
+    for(size_t i = 0; i < itemsSize; i++) {
+        pr.pending = false;
+        results[i].statusCode =
+            Operation_addNode_begin(server, session, NULL, &items[i], parentNodeId,
+                                    referenceTypeId, &results[i].addedNodeId, &pr);
+        if(results[i].statusCode != UA_STATUSCODE_GOOD || !pr.pending)
+            continue;
+        pr.targets[pr.targetsSize].nodeId = results[i].addedNodeId;
+        pr.nameHashes[pr.targetsSize] = pr.nameHash;
+        pr.positions[pr.targetsSize] = i;
+        pr.targetsSize++;
+    }
+
+    /* Add the forward references of the parent. Remove the new nodes if that
+     * fails. */
+    if(pr.targetsSize > 0)
+        retval = UA_Server_editNodeKeepShared(server, session, parentNodeId,
+                                              (UA_EditNodeCallback)addParentReferences,
+                                              &pr);
+    if(retval != UA_STATUSCODE_GOOD) {
+        logAddNode(&server->config.logger, session, parentNodeId,
+                   "Adding the references from the parent failed");
+        for(size_t i = 0; i < pr.targetsSize; i++) {
+            UA_AddNodesResult *result = &results[pr.positions[i]];
+            deleteNode(server, result->addedNodeId, true);
+            UA_NodeId_clear(&result->addedNodeId);
+            result->statusCode = retval;
+        }
+    }
+
+    /* Finish the nodes */
+    for(size_t i = 0; i < itemsSize; i++) {
+        UA_AddNodesResult *result = &results[i];
+        if(result->statusCode != UA_STATUSCODE_GOOD)
+            continue;
+        result->statusCode = AddNode_finish(server, session, &result->addedNodeId);
+        if(result->statusCode != UA_STATUSCODE_GOOD)
+            UA_NodeId_clear(&result->addedNodeId);
+    }
+
+    UA_MEMORYTAG_END();
+    UA_ParentReferences_clear(&pr);
 }
 
 void
@@ -1548,11 +1793,34 @@ Service_AddNodes(UA_Server *server, UA_Session *session,
         return;
     }
 
-    response->responseHeader.serviceResult =
-        UA_Server_processServiceOperations(server, session,
-                                           (UA_ServiceOperation)Operation_addNode, NULL,
-                                           &request->nodesToAddSize, &UA_TYPES[UA_TYPES_ADDNODESITEM],
-                                           &response->resultsSize, &UA_TYPES[UA_TYPES_ADDNODESRESULT]);
+    size_t ops = request->nodesToAddSize;
+    if(ops == 0) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADNOTHINGTODO;
+        return;
+    }
+
+    response->results = (UA_AddNodesResult*)
+        UA_Array_new(ops, &UA_TYPES[UA_TYPES_ADDNODESRESULT]);
+    if(!response->results) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    response->resultsSize = ops;
+
+    /* Consecutive items below the same parent are added as a batch */
+    for(size_t i = 0; i < ops;) {
+        size_t n = 1;
+        while(i + n < ops &&
+              sameParentReference(&request->nodesToAdd[i], &request->nodesToAdd[i + n]))
+            n++;
+        if(n == 1)
+            Operation_addNode(server, session, NULL, &request->nodesToAdd[i],
+                              &response->results[i]);
+        else
+            Operation_addNodes(server, session, &request->nodesToAdd[i],
+                               &response->results[i], n);
+        i += n;
+    }
 }
 
 UA_StatusCode
@@ -1622,9 +1890,11 @@ UA_Server_addNode_begin(UA_Server *server, const UA_NodeClass nodeClass,
                                         (void*)(uintptr_t)attr, attributeType);
 
     UA_LOCK(&server->serviceMutex);
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_NODESTORE);
     UA_StatusCode retval =
         Operation_addNode_begin(server, &server->adminSession, nodeContext, &item,
-                                &parentNodeId, &referenceTypeId, outNewNodeId);
+                                &parentNodeId, &referenceTypeId, outNewNodeId, NULL);
+    UA_MEMORYTAG_END();
     UA_UNLOCK(&server->serviceMutex);
     return retval;
 }
@@ -1632,7 +1902,9 @@ UA_Server_addNode_begin(UA_Server *server, const UA_NodeClass nodeClass,
 UA_StatusCode
 UA_Server_addNode_finish(UA_Server *server, const UA_NodeId nodeId) {
     UA_LOCK(&server->serviceMutex);
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_NODESTORE);
     UA_StatusCode retval = AddNode_finish(server, &server->adminSession, &nodeId);
+    UA_MEMORYTAG_END();
     UA_UNLOCK(&server->serviceMutex);
     return retval;
 }
@@ -1646,7 +1918,7 @@ Operation_deleteReference(UA_Server *server, UA_Session *session, void *context,
                           const UA_DeleteReferencesItem *item, UA_StatusCode *retval);
 
 /* Remove references to this node (in the other nodes) */
-static void
+void
 removeIncomingReferences(UA_Server *server, UA_Session *session, const UA_NodeHead *head) {
     UA_DeleteReferencesItem item;
     UA_DeleteReferencesItem_init(&item);
@@ -1742,8 +2014,9 @@ deconstructNodeSet(UA_Server *server, UA_Session *session,
         UA_NODESTORE_RELEASE(server, member);
 
         /* Set the constructed flag to false */
-        UA_Server_editNode(server, &server->adminSession, &refTree->targets[i].nodeId,
-                           (UA_EditNodeCallback)setDeconstructedNode, NULL);
+        UA_Server_editNodeKeepShared(server, &server->adminSession,
+                                     &refTree->targets[i].nodeId,
+                                     (UA_EditNodeCallback)setDeconstructedNode, NULL);
     }
 }
 
@@ -1917,7 +2190,8 @@ Service_DeleteNodes(UA_Server *server, UA_Session *session,
                                            (UA_ServiceOperation)deleteNodeOperation,
                                            NULL, &request->nodesToDeleteSize,
                                            &UA_TYPES[UA_TYPES_DELETENODESITEM],
-                                           &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+                                           &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE],
+                                           NULL);
 }
 
 UA_StatusCode
@@ -1945,20 +2219,6 @@ deleteNode(UA_Server *server, const UA_NodeId nodeId,
 /* Add References */
 /******************/
 
-struct AddNodeInfo {
-    UA_Byte refTypeIndex;
-    UA_Boolean isForward;
-    const UA_ExpandedNodeId *targetNodeId;
-    UA_UInt32 targetBrowseNameHash;
-};
-
-static UA_StatusCode
-addOneWayReference(UA_Server *server, UA_Session *session, UA_Node *node,
-                   const struct AddNodeInfo *info) {
-    return UA_Node_addReference(node, info->refTypeIndex, info->isForward,
-                                info->targetNodeId, info->targetBrowseNameHash);
-}
-
 static UA_StatusCode
 deleteOneWayReference(UA_Server *server, UA_Session *session, UA_Node *node,
                       const UA_DeleteReferencesItem *item) {
@@ -2038,8 +2298,9 @@ Operation_addReference(UA_Server *server, UA_Session *session, void *context,
     info.targetBrowseNameHash = targetNameHash;
 
     /* Add the first direction */
-    *retval = UA_Server_editNode(server, session, &item->sourceNodeId,
-                                 (UA_EditNodeCallback)addOneWayReference, &info);
+    *retval = UA_Server_editNodeKeepShared(server, session, &item->sourceNodeId,
+                                           (UA_EditNodeCallback)addOneWayReference,
+                                           &info);
     UA_Boolean firstExisted = false;
     if(*retval == UA_STATUSCODE_BADDUPLICATEREFERENCENOTALLOWED) {
         *retval = UA_STATUSCODE_GOOD;
@@ -2055,8 +2316,10 @@ Operation_addReference(UA_Server *server, UA_Session *session, void *context,
     info.targetNodeId = &target2;
     info.isForward = !info.isForward;
     info.targetBrowseNameHash = sourceNameHash;
-    *retval = UA_Server_editNode(server, session, &item->targetNodeId.nodeId,
-                                 (UA_EditNodeCallback)addOneWayReference, &info);
+    *retval = UA_Server_editNodeKeepShared(server, session,
+                                           &item->targetNodeId.nodeId,
+                                           (UA_EditNodeCallback)addOneWayReference,
+                                           &info);
 
     /* Second direction existed already */
     if(*retval == UA_STATUSCODE_BADDUPLICATEREFERENCENOTALLOWED) {
@@ -2078,8 +2341,9 @@ Operation_addReference(UA_Server *server, UA_Session *session, void *context,
         deleteItem.targetNodeId = item->targetNodeId;
         deleteItem.deleteBidirectional = false;
         /* Ignore status code */
-        UA_Server_editNode(server, session, &item->sourceNodeId,
-                           (UA_EditNodeCallback)deleteOneWayReference, &deleteItem);
+        UA_Server_editNodeKeepShared(server, session, &item->sourceNodeId,
+                                     (UA_EditNodeCallback)deleteOneWayReference,
+                                     &deleteItem);
     }
 }
 
@@ -2103,7 +2367,8 @@ Service_AddReferences(UA_Server *server, UA_Session *session,
                                            (UA_ServiceOperation)Operation_addReference,
                                            NULL, &request->referencesToAddSize,
                                            &UA_TYPES[UA_TYPES_ADDREFERENCESITEM],
-                                           &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+                                           &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE],
+                                           NULL);
 }
 
 UA_StatusCode
@@ -2146,10 +2411,11 @@ Operation_deleteReference(UA_Server *server, UA_Session *session, void *context,
     }
 
     // TODO: Check consistency constraints, remove the references.
-    *retval = UA_Server_editNode(server, session, &item->sourceNodeId,
-                                 (UA_EditNodeCallback)deleteOneWayReference,
-                                 /* cast away const qualifier because callback uses it anyway */
-                                 (UA_DeleteReferencesItem *)(uintptr_t)item);
+    *retval =
+        UA_Server_editNodeKeepShared(server, session, &item->sourceNodeId,
+                                     (UA_EditNodeCallback)deleteOneWayReference,
+                                     /* cast away const qualifier, callback uses it anyway */
+                                     (UA_DeleteReferencesItem *)(uintptr_t)item);
     if(*retval != UA_STATUSCODE_GOOD)
         return;
 
@@ -2162,9 +2428,9 @@ Operation_deleteReference(UA_Server *server, UA_Session *session, void *context,
     secondItem.sourceNodeId = item->targetNodeId.nodeId;
     secondItem.targetNodeId.nodeId = item->sourceNodeId;
     secondItem.referenceTypeId = item->referenceTypeId;
-    *retval = UA_Server_editNode(server, session, &secondItem.sourceNodeId,
-                                 (UA_EditNodeCallback)deleteOneWayReference,
-                                 &secondItem);
+    *retval = UA_Server_editNodeKeepShared(server, session, &secondItem.sourceNodeId,
+                                           (UA_EditNodeCallback)deleteOneWayReference,
+                                           &secondItem);
 }
 
 void
@@ -2186,7 +2452,8 @@ Service_DeleteReferences(UA_Server *server, UA_Session *session,
                                            (UA_ServiceOperation)Operation_deleteReference,
                                            NULL, &request->referencesToDeleteSize,
                                            &UA_TYPES[UA_TYPES_DELETEREFERENCESITEM],
-                                           &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+                                           &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE],
+                                           NULL);
 }
 
 UA_StatusCode
@@ -2295,8 +2562,7 @@ setDataSource(UA_Server *server, UA_Session *session,
               UA_VariableNode *node, const UA_DataSource *dataSource) {
     if(node->head.nodeClass != UA_NODECLASS_VARIABLE)
         return UA_STATUSCODE_BADNODECLASSINVALID;
-    if(node->valueSource == UA_VALUESOURCE_DATA)
-        UA_DataValue_clear(&node->value.data.value);
+    UA_VariableNode_releaseValue(node);
     node->value.dataSource = *dataSource;
     node->valueSource = UA_VALUESOURCE_DATASOURCE;
     return UA_STATUSCODE_GOOD;
@@ -2517,9 +2783,11 @@ UA_Server_addMethodNode_finish(UA_Server *server, const UA_NodeId nodeId,
                                size_t inputArgumentsSize, const UA_Argument* inputArguments,
                                size_t outputArgumentsSize, const UA_Argument* outputArguments) {
     UA_LOCK(&server->serviceMutex);
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_NODESTORE);
     UA_StatusCode retval = UA_Server_addMethodNodeEx_finish(server, nodeId, method,
                                             inputArgumentsSize, inputArguments, UA_NODEID_NULL, NULL,
                                             outputArgumentsSize, outputArguments, UA_NODEID_NULL, NULL);
+    UA_MEMORYTAG_END();
     UA_UNLOCK(&server->serviceMutex);
     return retval;
 }
@@ -2550,10 +2818,12 @@ UA_Server_addMethodNodeEx(UA_Server *server, const UA_NodeId requestedNewNodeId,
         outNewNodeId = &newId;
     }
     UA_LOCK(&server->serviceMutex);
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_NODESTORE);
     UA_StatusCode retval = Operation_addNode_begin(server, &server->adminSession,
                                                    nodeContext, &item, &parentNodeId,
-                                                   &referenceTypeId, outNewNodeId);
+                                                   &referenceTypeId, outNewNodeId, NULL);
     if(retval != UA_STATUSCODE_GOOD) {
+        UA_MEMORYTAG_END();
         UA_UNLOCK(&server->serviceMutex);
         return retval;
     }
@@ -2565,6 +2835,7 @@ UA_Server_addMethodNodeEx(UA_Server *server, const UA_NodeId requestedNewNodeId,
                                               outputArgumentsSize, outputArguments,
                                               outputArgumentsRequestedNewNodeId,
                                               outputArgumentsOutNewNodeId);
+    UA_MEMORYTAG_END();
     UA_UNLOCK(&server->serviceMutex);
     if(outNewNodeId == &newId)
         UA_NodeId_clear(&newId);
@@ -2585,9 +2856,9 @@ setMethodNode_callback(UA_Server *server,
                        const UA_NodeId methodNodeId,
                        UA_MethodCallback methodCallback) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
-    return UA_Server_editNode(server, &server->adminSession, &methodNodeId,
-                              (UA_EditNodeCallback)editMethodCallback,
-                              (void*)(uintptr_t)methodCallback);
+    return UA_Server_editNodeKeepShared(server, &server->adminSession, &methodNodeId,
+                                        (UA_EditNodeCallback)editMethodCallback,
+                                        (void*)(uintptr_t)methodCallback);
 }
 
 UA_StatusCode
@@ -2652,9 +2923,10 @@ UA_StatusCode
 UA_Server_setNodeTypeLifecycle(UA_Server *server, UA_NodeId nodeId,
                                UA_NodeTypeLifecycle lifecycle) {
     UA_LOCK(&server->serviceMutex);
-    UA_StatusCode retval = UA_Server_editNode(server, &server->adminSession, &nodeId,
-                                             (UA_EditNodeCallback)setNodeTypeLifecycle,
-                                              &lifecycle);
+    UA_StatusCode retval =
+        UA_Server_editNodeKeepShared(server, &server->adminSession, &nodeId,
+                                     (UA_EditNodeCallback)setNodeTypeLifecycle,
+                                     &lifecycle);
     UA_UNLOCK(&server->serviceMutex);
     return retval;
 }
@@ -426,7 +426,8 @@ decryptPassword(UA_SecurityPolicy *securityPolicy, void *tempChannelContext,
                 const UA_ByteString *serverNonce, UA_UserNameIdentityToken *userToken) {
     UA_SecurityPolicyEncryptionAlgorithm *asymEnc =
         &securityPolicy->asymmetricModule.cryptoModule.encryptionAlgorithm;
-    if(!UA_String_equal(&userToken->encryptionAlgorithm, &asymEnc->uri))
+    if(!asymEnc->decrypt ||
+       !UA_String_equal(&userToken->encryptionAlgorithm, &asymEnc->uri))
         return UA_STATUSCODE_BADIDENTITYTOKENINVALID;
 
     UA_UInt32 tokenSecretLength;
@@ -683,9 +684,11 @@ Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
 
     /* Callback into userland access control */
     UA_UNLOCK(&server->serviceMutex);
+    UA_TRACE_BEGIN(UA_TRACESTAGE_ACCESSCONTROL, "activateSession");
     response->responseHeader.serviceResult = server->config.accessControl.
         activateSession(server, &server->config.accessControl, ed, &channel->remoteCertificate,
                         &session->sessionId, &request->userIdentityToken, &session->sessionHandle);
+    UA_TRACE_END();
     UA_LOCK(&server->serviceMutex);
     if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_SESSION(&server->config.logger, session, "ActivateSession: The AccessControl "
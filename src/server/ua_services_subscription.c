@@ -177,7 +177,8 @@ Service_SetPublishingMode(UA_Server *server, UA_Session *session,
         UA_Server_processServiceOperations(server, session, (UA_ServiceOperation)Operation_SetPublishingMode,
                                            &publishingEnabled,
                                            &request->subscriptionIdsSize, &UA_TYPES[UA_TYPES_UINT32],
-                                           &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+                                           &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE],
+                                           NULL);
 }
 
 void
@@ -308,7 +309,7 @@ Service_DeleteSubscriptions(UA_Server *server, UA_Session *session,
         UA_Server_processServiceOperations(server, session,
                   (UA_ServiceOperation)Operation_DeleteSubscription, NULL,
                   &request->subscriptionIdsSize, &UA_TYPES[UA_TYPES_UINT32],
-                  &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+                  &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE], NULL);
 }
 
 void
@@ -530,7 +531,7 @@ void Service_TransferSubscriptions(UA_Server *server, UA_Session *session,
                   (UA_ServiceOperation)Operation_TransferSubscription,
                   &request->sendInitialValues,
                   &request->subscriptionIdsSize, &UA_TYPES[UA_TYPES_UINT32],
-                  &response->resultsSize, &UA_TYPES[UA_TYPES_TRANSFERRESULT]);
+                  &response->resultsSize, &UA_TYPES[UA_TYPES_TRANSFERRESULT], NULL);
 }
 
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
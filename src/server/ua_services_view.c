@@ -513,7 +513,7 @@ addReferenceDescription(UA_Server *server, RefResult *rr,
     if(mask & UA_BROWSERESULTMASK_BROWSENAME)
         retval |= UA_QualifiedName_copy(&curr->head.browseName, &descr->browseName);
     if(mask & UA_BROWSERESULTMASK_DISPLAYNAME)
-        retval |= UA_LocalizedText_copy(&curr->head.displayName, &descr->displayName);
+        retval |= UA_Node_readDisplayName(curr, &descr->displayName);
     if(mask & UA_BROWSERESULTMASK_TYPEDEFINITION) {
         if(curr->head.nodeClass == UA_NODECLASS_OBJECT ||
            curr->head.nodeClass == UA_NODECLASS_VARIABLE) {
@@ -669,14 +669,18 @@ browseWithContinuation(UA_Server *server, UA_Session *session,
         return true;
     }
 
-    if(session != &server->adminSession &&
-       !server->config.accessControl.
-         allowBrowseNode(server, &server->config.accessControl,
-                         &session->sessionId, session->sessionHandle,
-                         &descr->nodeId, node->head.context)) {
-        result->statusCode = UA_STATUSCODE_BADUSERACCESSDENIED;
-        UA_NODESTORE_RELEASE(server, node);
-        return true;
+    if(session != &server->adminSession) {
+        UA_TRACE_BEGIN(UA_TRACESTAGE_ACCESSCONTROL, "allowBrowseNode");
+        UA_Boolean allowed = server->config.accessControl.
+            allowBrowseNode(server, &server->config.accessControl,
+                            &session->sessionId, session->sessionHandle,
+                            &descr->nodeId, node->head.context);
+        UA_TRACE_END();
+        if(!allowed) {
+            result->statusCode = UA_STATUSCODE_BADUSERACCESSDENIED;
+            UA_NODESTORE_RELEASE(server, node);
+            return true;
+        }
     }
 
     RefResult rr;
@@ -833,7 +837,7 @@ void Service_Browse(UA_Server *server, UA_Session *session,
                                            &request->nodesToBrowseSize,
                                            &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION],
                                            &response->resultsSize,
-                                           &UA_TYPES[UA_TYPES_BROWSERESULT]);
+                                           &UA_TYPES[UA_TYPES_BROWSERESULT], NULL);
 }
 
 UA_BrowseResult
@@ -908,7 +912,7 @@ Service_BrowseNext(UA_Server *server, UA_Session *session,
                                            &request->continuationPointsSize,
                                            &UA_TYPES[UA_TYPES_BYTESTRING],
                                            &response->resultsSize,
-                                           &UA_TYPES[UA_TYPES_BROWSERESULT]);
+                                           &UA_TYPES[UA_TYPES_BROWSERESULT], NULL);
 }
 
 UA_BrowseResult
@@ -1037,6 +1041,18 @@ walkBrowsePathElement(UA_Server *server, UA_Session *session,
                 res = recursiveAddBrowseHashTarget(next, &_refNameTree, rt);
                 if(res != UA_STATUSCODE_GOOD)
                     break;
+            } else if(rk->hasRefIndex) {
+                /* Retrieve from the sorted BrowseName hash index */
+                size_t cursor = 0;
+                const UA_ReferenceTarget *rt;
+                while((rt = UA_NodeReferenceKind_iterateName(rk, browseNameHash,
+                                                             &cursor))) {
+                    res = RefTree_add(next, rt->targetId, NULL);
+                    if(res != UA_STATUSCODE_GOOD)
+                        break;
+                }
+                if(res != UA_STATUSCODE_GOOD)
+                    break;
             } else {
                 /* The array entries don't have a BrowseName hash. Add all of
                  * them at this level to be checked with a full string
@@ -1220,7 +1236,8 @@ Service_TranslateBrowsePathsToNodeIds(UA_Server *server, UA_Session *session,
                                            (UA_ServiceOperation)Operation_TranslateBrowsePathToNodeIds,
                                            &nodeClassMask,
                                            &request->browsePathsSize, &UA_TYPES[UA_TYPES_BROWSEPATH],
-                                           &response->resultsSize, &UA_TYPES[UA_TYPES_BROWSEPATHRESULT]);
+                                           &response->resultsSize, &UA_TYPES[UA_TYPES_BROWSEPATHRESULT],
+                                           NULL);
 }
 
 UA_BrowsePathResult
@@ -1282,7 +1299,6 @@ void Service_RegisterNodes(UA_Server *server, UA_Session *session,
                          "Processing RegisterNodesRequest");
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
-    //TODO: hang the nodeids to the session if really needed
     if(request->nodesToRegisterSize == 0) {
         response->responseHeader.serviceResult = UA_STATUSCODE_BADNOTHINGTODO;
         return;
@@ -1295,11 +1311,50 @@ void Service_RegisterNodes(UA_Server *server, UA_Session *session,
         return;
     }
 
-    response->responseHeader.serviceResult =
-        UA_Array_copy(request->nodesToRegister, request->nodesToRegisterSize,
-                      (void**)&response->registeredNodeIds, &UA_TYPES[UA_TYPES_NODEID]);
-    if(response->responseHeader.serviceResult == UA_STATUSCODE_GOOD)
-        response->registeredNodeIdsSize = request->nodesToRegisterSize;
+    /* Return the NodeIds unchanged if registered nodes are disabled */
+    if(server->config.maxRegisteredNodesPerSession == 0) {
+        response->responseHeader.serviceResult =
+            UA_Array_copy(request->nodesToRegister, request->nodesToRegisterSize,
+                          (void**)&response->registeredNodeIds,
+                          &UA_TYPES[UA_TYPES_NODEID]);
+        if(response->responseHeader.serviceResult == UA_STATUSCODE_GOOD)
+            response->registeredNodeIdsSize = request->nodesToRegisterSize;
+        return;
+    }
+
+    response->registeredNodeIds = (UA_NodeId*)
+        UA_Array_new(request->nodesToRegisterSize, &UA_TYPES[UA_TYPES_NODEID]);
+    if(!response->registeredNodeIds) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    response->registeredNodeIdsSize = request->nodesToRegisterSize;
+
+    /* Unknown nodes and nodes beyond the limit are returned unchanged. They
+     * are still valid for all services, only without the shortcut. */
+    for(size_t i = 0; i < request->nodesToRegisterSize; i++) {
+        UA_StatusCode res =
+            UA_Session_registerNode(server, session, &request->nodesToRegister[i],
+                                    &response->registeredNodeIds[i]);
+        if(res == UA_STATUSCODE_GOOD)
+            continue;
+        if(res != UA_STATUSCODE_BADOUTOFMEMORY)
+            res = UA_NodeId_copy(&request->nodesToRegister[i],
+                                 &response->registeredNodeIds[i]);
+        if(res != UA_STATUSCODE_GOOD) {
+            /* Release the handles that were already created */
+            for(size_t j = 0; j < i; j++)
+                UA_Session_unregisterNode(server, session,
+                                          &response->registeredNodeIds[j]);
+            UA_Array_delete(response->registeredNodeIds,
+                            response->registeredNodeIdsSize,
+                            &UA_TYPES[UA_TYPES_NODEID]);
+            response->registeredNodeIds = NULL;
+            response->registeredNodeIdsSize = 0;
+            response->responseHeader.serviceResult = res;
+            return;
+        }
+    }
 }
 
 void Service_UnregisterNodes(UA_Server *server, UA_Session *session,
@@ -1309,7 +1364,6 @@ void Service_UnregisterNodes(UA_Server *server, UA_Session *session,
                          "Processing UnRegisterNodesRequest");
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
-    //TODO: remove the nodeids from the session if really needed
     if(request->nodesToUnregisterSize == 0)
         response->responseHeader.serviceResult = UA_STATUSCODE_BADNOTHINGTODO;
 
@@ -1319,4 +1373,8 @@ void Service_UnregisterNodes(UA_Server *server, UA_Session *session,
         response->responseHeader.serviceResult = UA_STATUSCODE_BADTOOMANYOPERATIONS;
         return;
     }
+
+    /* Release the handles. NodeIds that were returned unchanged are ignored. */
+    for(size_t i = 0; i < request->nodesToUnregisterSize; i++)
+        UA_Session_unregisterNode(server, session, &request->nodesToUnregister[i]);
 }
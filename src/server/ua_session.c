@@ -24,6 +24,9 @@ void UA_Session_init(UA_Session *session) {
 #endif
 }
 
+static void
+clearRegisteredNodes(UA_Session *session, UA_Server *server);
+
 void UA_Session_clear(UA_Session *session, UA_Server* server) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
@@ -37,6 +40,7 @@ void UA_Session_clear(UA_Session *session, UA_Server* server) {
 #endif
 
     UA_Session_detachFromSecureChannel(session);
+    clearRegisteredNodes(session, server);
     UA_ApplicationDescription_clear(&session->clientDescription);
     UA_NodeId_clear(&session->header.authenticationToken);
     UA_NodeId_clear(&session->sessionId);
@@ -102,6 +106,190 @@ void UA_Session_updateLifetime(UA_Session *session) {
         (UA_DateTime)(session->timeout * UA_DATETIME_MSEC);
 }
 
+/********************/
+/* Registered Nodes */
+/********************/
+
+static void
+clearRegisteredNodes(UA_Session *session, UA_Server *server) {
+    for(size_t i = 0; i < session->registeredNodesSize; i++) {
+        UA_RegisteredNode *rn = &session->registeredNodes[i];
+        if(rn->node)
+            UA_NODESTORE_RELEASE(server, rn->node);
+        UA_NodeId_clear(&rn->nodeId);
+    }
+    UA_free(session->registeredNodes);
+    session->registeredNodes = NULL;
+    session->registeredNodesSize = 0;
+    session->registeredNodesCount = 0;
+    session->registeredNodesFree = 0;
+}
+
+UA_StatusCode
+UA_Session_registerNode(UA_Server *server, UA_Session *session,
+                        const UA_NodeId *nodeId, UA_NodeId *outHandle) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
+    if(session->registeredNodesCount >= server->config.maxRegisteredNodesPerSession)
+        return UA_STATUSCODE_BADTOOMANYOPERATIONS;
+
+    /* Pin the node */
+    const UA_Node *node = UA_NODESTORE_GET(server, nodeId);
+    if(!node)
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+
+    /* Grow the table if no free slot is left */
+    if(session->registeredNodesFree == 0) {
+        size_t newSize = session->registeredNodesSize * 2;
+        if(newSize < 8)
+            newSize = 8;
+        UA_RegisteredNode *rns = (UA_RegisteredNode*)
+            UA_realloc(session->registeredNodes, newSize * sizeof(UA_RegisteredNode));
+        if(!rns) {
+            UA_NODESTORE_RELEASE(server, node);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        memset(&rns[session->registeredNodesSize], 0,
+               (newSize - session->registeredNodesSize) * sizeof(UA_RegisteredNode));
+        for(size_t i = session->registeredNodesSize; i < newSize - 1; i++)
+            rns[i].nextFree = i + 2;
+        session->registeredNodesFree = session->registeredNodesSize + 1;
+        session->registeredNodes = rns;
+        session->registeredNodesSize = newSize;
+    }
+
+    size_t index = session->registeredNodesFree - 1;
+    UA_RegisteredNode *rn = &session->registeredNodes[index];
+    UA_StatusCode res = UA_NodeId_copy(&node->head.nodeId, &rn->nodeId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_NODESTORE_RELEASE(server, node);
+        return res;
+    }
+    rn->node = node;
+    rn->nodestoreVersion = server->nodestoreVersion;
+    session->registeredNodesFree = rn->nextFree;
+    rn->nextFree = 0;
+    session->registeredNodesCount++;
+
+    *outHandle = UA_NODEID_NUMERIC(UA_REGISTEREDNODES_NSINDEX, (UA_UInt32)index + 1);
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_RegisteredNode *
+UA_Session_getRegisteredNode(UA_Session *session, const UA_NodeId *handle) {
+    if(!UA_Session_isRegisteredNodeHandle(session, handle))
+        return NULL;
+    size_t index = (size_t)handle->identifier.numeric - 1;
+    if(handle->identifier.numeric == 0 || index >= session->registeredNodesSize)
+        return NULL;
+    UA_RegisteredNode *rn = &session->registeredNodes[index];
+    if(UA_NodeId_isNull(&rn->nodeId))
+        return NULL;
+    return rn;
+}
+
+void
+UA_Session_unregisterNode(UA_Server *server, UA_Session *session,
+                          const UA_NodeId *handle) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    UA_RegisteredNode *rn = UA_Session_getRegisteredNode(session, handle);
+    if(!rn)
+        return;
+    if(rn->node)
+        UA_NODESTORE_RELEASE(server, rn->node);
+    UA_NodeId_clear(&rn->nodeId);
+    rn->node = NULL;
+    rn->nextFree = session->registeredNodesFree;
+    session->registeredNodesFree = (size_t)(rn - session->registeredNodes) + 1;
+    session->registeredNodesCount--;
+}
+
+static void
+resolveRegisteredNodeId(UA_Session *session, UA_NodeId *nodeId) {
+    UA_RegisteredNode *rn = UA_Session_getRegisteredNode(session, nodeId);
+    if(!rn)
+        return;
+    /* The handle is numeric. Nothing to clean up before overwriting. If the
+     * copy fails, the unresolved handle leads to BadNodeIdUnknown. */
+    UA_NodeId resolved;
+    if(UA_NodeId_copy(&rn->nodeId, &resolved) == UA_STATUSCODE_GOOD)
+        *nodeId = resolved;
+}
+
+static void
+resolveRegisteredStructure(UA_Session *session, void *p, const UA_DataType *type);
+
+static void
+resolveRegisteredMember(UA_Session *session, void *p, const UA_DataType *type) {
+    switch(type->typeKind) {
+    case UA_DATATYPEKIND_NODEID:
+        resolveRegisteredNodeId(session, (UA_NodeId*)p);
+        break;
+    case UA_DATATYPEKIND_EXPANDEDNODEID: {
+        UA_ExpandedNodeId *en = (UA_ExpandedNodeId*)p;
+        if(en->serverIndex == 0 && en->namespaceUri.length == 0)
+            resolveRegisteredNodeId(session, &en->nodeId);
+        break;
+    }
+    case UA_DATATYPEKIND_STRUCTURE:
+        resolveRegisteredStructure(session, p, type);
+        break;
+    default:
+        break; /* Values (Variant, DataValue, ExtensionObject) are user data */
+    }
+}
+
+static void
+resolveRegisteredStructure(UA_Session *session, void *p, const UA_DataType *type) {
+    uintptr_t ptr = (uintptr_t)p;
+    for(size_t i = 0; i < type->membersSize; ++i) {
+        const UA_DataTypeMember *m = &type->members[i];
+        const UA_DataType *mt = m->memberType;
+        ptr += m->padding;
+        if(!m->isArray) {
+            /* The authentication token is no alias */
+            if(mt != &UA_TYPES[UA_TYPES_REQUESTHEADER])
+                resolveRegisteredMember(session, (void*)ptr, mt);
+            ptr += mt->memSize;
+            continue;
+        }
+        size_t length = *(size_t*)ptr;
+        ptr += sizeof(size_t);
+        uintptr_t elem = *(uintptr_t*)ptr;
+        for(size_t j = 0; j < length; j++) {
+            resolveRegisteredMember(session, (void*)elem, mt);
+            elem += mt->memSize;
+        }
+        ptr += sizeof(void*);
+    }
+}
+
+void
+UA_Session_resolveRegisteredNodeIds(UA_Session *session, void *request,
+                                    const UA_DataType *requestType) {
+    if(session->registeredNodesCount == 0)
+        return;
+    resolveRegisteredStructure(session, request, requestType);
+}
+
+const UA_Node *
+UA_Session_getRegisteredNodePtr(UA_Server *server, UA_Session *session,
+                                const UA_NodeId *handle) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    UA_RegisteredNode *rn = UA_Session_getRegisteredNode(session, handle);
+    if(!rn)
+        return NULL;
+
+    /* A node was replaced or removed in the meantime. Resolve again. */
+    if(rn->nodestoreVersion != server->nodestoreVersion) {
+        if(rn->node)
+            UA_NODESTORE_RELEASE(server, rn->node);
+        rn->node = UA_NODESTORE_GET(server, &rn->nodeId);
+        rn->nodestoreVersion = server->nodestoreVersion;
+    }
+    return rn->node;
+}
+
 #ifdef UA_ENABLE_SUBSCRIPTIONS
 
 void
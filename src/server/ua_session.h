@@ -10,6 +10,7 @@
 #define UA_SESSION_H_
 
 #include <open62541/util.h>
+#include <open62541/plugin/nodestore.h>
 
 #include "ua_securechannel.h"
 
@@ -35,6 +36,19 @@ typedef struct UA_PublishResponseEntry {
 } UA_PublishResponseEntry;
 #endif
 
+/* Aliases returned from RegisterNodes are numeric NodeIds in a reserved
+ * namespace. The identifier is the index into the session table plus one. */
+#define UA_REGISTEREDNODES_NSINDEX 0xFFFF
+
+/* Keeps the node pinned in the Nodestore until it is unregistered. The node is
+ * resolved again when the Nodestore version has changed. */
+typedef struct {
+    UA_NodeId nodeId;       /* The registered NodeId. Null for a free slot. */
+    const UA_Node *node;    /* Can be NULL if the node was removed */
+    UA_UInt64 nodestoreVersion;
+    size_t nextFree;        /* Next free slot plus one (0 -> end of the list) */
+} UA_RegisteredNode;
+
 typedef struct {
     UA_SessionHeader  header;
     UA_ApplicationDescription clientDescription;
@@ -54,6 +68,11 @@ typedef struct {
     size_t paramsSize;
     UA_KeyValuePair *params;
 
+    size_t registeredNodesSize;  /* Allocated slots */
+    size_t registeredNodesCount; /* Used slots */
+    size_t registeredNodesFree;  /* First free slot plus one */
+    UA_RegisteredNode *registeredNodes;
+
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     size_t subscriptionsSize;
     TAILQ_HEAD(, UA_Subscription) subscriptions; /* Late subscriptions that do eventually
@@ -79,6 +98,49 @@ UA_StatusCode UA_Session_generateNonce(UA_Session *session);
 /* If any activity on a session happens, the timeout is extended */
 void UA_Session_updateLifetime(UA_Session *session);
 
+/**
+ * Registered Nodes
+ * ---------------- */
+
+/* Returns the alias in outHandle. Returns UA_STATUSCODE_BADNODEIDUNKNOWN if the
+ * node does not exist and UA_STATUSCODE_BADTOOMANYOPERATIONS if the limit of
+ * registered nodes for the session is reached. */
+UA_StatusCode
+UA_Session_registerNode(UA_Server *server, UA_Session *session,
+                        const UA_NodeId *nodeId, UA_NodeId *outHandle);
+
+/* Unknown handles are ignored */
+void
+UA_Session_unregisterNode(UA_Server *server, UA_Session *session,
+                          const UA_NodeId *handle);
+
+static UA_INLINE UA_Boolean
+UA_Session_isRegisteredNodeHandle(const UA_Session *session,
+                                  const UA_NodeId *nodeId) {
+    return (session->registeredNodesCount > 0 &&
+            nodeId->namespaceIndex == UA_REGISTEREDNODES_NSINDEX &&
+            nodeId->identifierType == UA_NODEIDTYPE_NUMERIC);
+}
+
+/* Returns NULL if the handle is unknown */
+UA_RegisteredNode *
+UA_Session_getRegisteredNode(UA_Session *session, const UA_NodeId *handle);
+
+/* Replaces the handles in the NodeIds and local ExpandedNodeIds of a service
+ * request with the registered NodeIds. Called once before the service is
+ * dispatched, so the handles never reach the Nodestore or end up in stored
+ * references. Values (Variants etc.) are not traversed. Only plain structures
+ * without optional fields are supported, as used by the service requests. */
+void
+UA_Session_resolveRegisteredNodeIds(UA_Session *session, void *request,
+                                    const UA_DataType *requestType);
+
+/* Returns the pinned node for the handle or NULL. The node must not be
+ * released by the caller. */
+const UA_Node *
+UA_Session_getRegisteredNodePtr(UA_Server *server, UA_Session *session,
+                                const UA_NodeId *handle);
+
 /**
  * Subscription handling
  * --------------------- */
@@ -326,8 +326,10 @@ UA_Subscription_nextSequenceNumber(UA_UInt32 sequenceNumber) {
 static void
 publishCallback(UA_Server *server, UA_Subscription *sub) {
     UA_LOCK(&server->serviceMutex);
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_SUBSCRIPTION);
     sub->readyNotifications = sub->notificationQueueSize;
     UA_Subscription_publish(server, sub);
+    UA_MEMORYTAG_END();
     UA_UNLOCK(&server->serviceMutex);
 }
 
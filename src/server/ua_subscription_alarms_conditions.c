@@ -2275,8 +2275,9 @@ addOptionalVariableField(UA_Server *server, const UA_NodeId *originCondition,
                          UA_NodeId *outOptionalVariable) {
     UA_VariableAttributes vAttr = UA_VariableAttributes_default;
     vAttr.valueRank = optionalVariableFieldNode->valueRank;
-    UA_StatusCode retval = UA_LocalizedText_copy(&optionalVariableFieldNode->head.displayName,
-                                                 &vAttr.displayName);
+    UA_StatusCode retval =
+        UA_Node_readDisplayName((const UA_Node*)optionalVariableFieldNode,
+                                &vAttr.displayName);
     CONDITION_ASSERT_RETURN_RETVAL(retval, "Copying LocalizedText failed",);
 
     retval = UA_NodeId_copy(&optionalVariableFieldNode->dataType, &vAttr.dataType);
@@ -2316,8 +2317,9 @@ addOptionalObjectField(UA_Server *server, const UA_NodeId *originCondition,
                        const UA_ObjectNode *optionalObjectFieldNode,
                        UA_NodeId *outOptionalObject) {
     UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
-    UA_StatusCode retval = UA_LocalizedText_copy(&optionalObjectFieldNode->head.displayName,
-                                                 &oAttr.displayName);
+    UA_StatusCode retval =
+        UA_Node_readDisplayName((const UA_Node*)optionalObjectFieldNode,
+                                &oAttr.displayName);
     CONDITION_ASSERT_RETURN_RETVAL(retval, "Copying LocalizedText failed",);
 
     /* Get typedefintion */
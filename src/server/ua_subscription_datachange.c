@@ -297,7 +297,9 @@ sampleCallbackWithValue(UA_Server *server, UA_Session *session,
 void
 UA_MonitoredItem_sampleCallback(UA_Server *server, UA_MonitoredItem *monitoredItem) {
     UA_LOCK(&server->serviceMutex);
+    UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_SUBSCRIPTION);
     monitoredItem_sampleCallback(server, monitoredItem);
+    UA_MEMORYTAG_END();
     UA_UNLOCK(&server->serviceMutex);
 }
 
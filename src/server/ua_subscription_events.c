@@ -499,9 +499,12 @@ setHistoricalEvent(UA_Server *server, const UA_NodeId *origin,
     UA_EventFieldList efl;
     retval = UA_Server_filterEvent(server, &server->adminSession,
                                    eventNodeId, filter, &efl);
-    if(retval == UA_STATUSCODE_GOOD)
+    if(retval == UA_STATUSCODE_GOOD) {
+        UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_HISTORY);
         server->config.historyDatabase.setEvent(server, server->config.historyDatabase.context,
                                                 origin, emitNodeId, filter, &efl);
+        UA_MEMORYTAG_END();
+    }
     UA_Variant_clear(&historicalEventFilterValue);
     UA_EventFieldList_clear(&efl);
 }
@@ -639,6 +642,7 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
         }
 
         /* Add event to monitoreditems */
+        UA_MEMORYTAG_BEGIN(UA_MEMORYTAG_SUBSCRIPTION);
         for(UA_MonitoredItem *mi = node->monitoredItemQueue; mi != NULL; mi = mi->next) {
             retval = UA_Event_addEventToMonitoredItem(server, &eventNodeId, mi);
             if(retval != UA_STATUSCODE_GOOD) {
@@ -648,6 +652,7 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
                 retval = UA_STATUSCODE_GOOD; /* Only log problems with individual emit nodes */
             }
         }
+        UA_MEMORYTAG_END();
 
         UA_NODESTORE_RELEASE(server, (const UA_Node*)node);
 
@@ -389,8 +389,9 @@ UA_Server_registerMonitoredItem(UA_Server *server, UA_MonitoredItem *mon) {
     /* Attach to the Node */
 #ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
     if(sub && mon->itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER) {
-        UA_StatusCode res = UA_Server_editNode(server, NULL, &mon->itemToMonitor.nodeId,
-                                               addMonitoredItemNodeCallback, mon);
+        UA_StatusCode res =
+            UA_Server_editNodeKeepShared(server, NULL, &mon->itemToMonitor.nodeId,
+                                         addMonitoredItemNodeCallback, mon);
         if(res != UA_STATUSCODE_GOOD)
             return res;
     }
@@ -451,8 +452,8 @@ UA_Server_unregisterMonitoredItem(UA_Server *server, UA_MonitoredItem *mon) {
     /* Remove from the node */
 #ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
     if(sub && mon->itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER) {
-        UA_Server_editNode(server, session, &mon->itemToMonitor.nodeId,
-                           removeMonitoredItemNodeCallback, mon);
+        UA_Server_editNodeKeepShared(server, session, &mon->itemToMonitor.nodeId,
+                                     removeMonitoredItemNodeCallback, mon);
     }
 #endif
 
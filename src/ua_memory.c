@@ -0,0 +1,135 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ua_util_internal.h"
+
+#ifdef UA_ENABLE_MEMORY_ACCOUNTING
+
+#include <stdlib.h>
+
+/* The accounting layer sits on top of the malloc singletons or the C library */
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+# define rawMalloc UA_mallocSingleton
+# define rawFree UA_freeSingleton
+# define rawRealloc UA_reallocSingleton
+#else
+# define rawMalloc malloc
+# define rawFree free
+# define rawRealloc realloc
+#endif
+
+UA_THREAD_LOCAL UA_MemoryTag UA_memoryTag = UA_MEMORYTAG_OTHER;
+
+static UA_MemoryStatistics memoryStatistics[UA_MEMORYTAGSSIZE];
+
+/* Prepended to every allocation. The union keeps the memory after the header
+ * aligned for all basic types. */
+typedef union {
+    struct {
+        size_t size;
+        UA_MemoryTag tag;
+    } h;
+    void *p;
+    UA_UInt64 u;
+    UA_Double d;
+    long double ld;
+} MemoryHeader;
+
+static void
+countAlloc(UA_MemoryTag tag, size_t size) {
+    UA_MemoryStatistics *ms = &memoryStatistics[tag];
+    UA_atomic_addSize((volatile size_t*)&ms->currentBytes, size);
+    UA_atomic_addSize((volatile size_t*)&ms->cumulatedBytes, size);
+    UA_atomic_addSize((volatile size_t*)&ms->cumulatedAllocCount, 1);
+}
+
+static void
+countFree(UA_MemoryTag tag, size_t size) {
+    UA_MemoryStatistics *ms = &memoryStatistics[tag];
+    UA_atomic_subSize((volatile size_t*)&ms->currentBytes, size);
+    UA_atomic_addSize((volatile size_t*)&ms->cumulatedFreeCount, 1);
+}
+
+void *
+UA_mallocAccounted(size_t size) {
+    if(size > SIZE_MAX - sizeof(MemoryHeader))
+        return NULL;
+    MemoryHeader *mh = (MemoryHeader*)rawMalloc(sizeof(MemoryHeader) + size);
+    if(!mh)
+        return NULL;
+    UA_MemoryTag tag = UA_memoryTag;
+    mh->h.size = size;
+    mh->h.tag = tag;
+    countAlloc(tag, size);
+    return &mh[1];
+}
+
+void
+UA_freeAccounted(void *ptr) {
+    if(!ptr)
+        return;
+    MemoryHeader *mh = &((MemoryHeader*)ptr)[-1];
+    countFree(mh->h.tag, mh->h.size);
+    rawFree(mh);
+}
+
+void *
+UA_callocAccounted(size_t nelem, size_t elsize) {
+    if(elsize > 0 && nelem > SIZE_MAX / elsize)
+        return NULL;
+    size_t size = nelem * elsize;
+    void *ptr = UA_mallocAccounted(size);
+    if(ptr)
+        memset(ptr, 0, size);
+    return ptr;
+}
+
+/* The reallocated memory stays with the subsystem that made the first
+ * allocation */
+void *
+UA_reallocAccounted(void *ptr, size_t size) {
+    if(!ptr)
+        return UA_mallocAccounted(size);
+    if(size == 0) {
+        UA_freeAccounted(ptr);
+        return NULL;
+    }
+    if(size > SIZE_MAX - sizeof(MemoryHeader))
+        return NULL;
+    MemoryHeader *mh = &((MemoryHeader*)ptr)[-1];
+    UA_MemoryTag tag = mh->h.tag;
+    size_t oldSize = mh->h.size;
+    mh = (MemoryHeader*)rawRealloc(mh, sizeof(MemoryHeader) + size);
+    if(!mh)
+        return NULL;
+    mh->h.size = size;
+    UA_MemoryStatistics *ms = &memoryStatistics[tag];
+    if(size > oldSize) {
+        UA_atomic_addSize((volatile size_t*)&ms->currentBytes, size - oldSize);
+        UA_atomic_addSize((volatile size_t*)&ms->cumulatedBytes, size - oldSize);
+    } else {
+        UA_atomic_subSize((volatile size_t*)&ms->currentBytes, oldSize - size);
+    }
+    return &mh[1];
+}
+
+void
+UA_getMemoryStatistics(UA_MemoryStatistics stats[UA_MEMORYTAGSSIZE]) {
+    UA_atomic_sync();
+    memcpy(stats, memoryStatistics, sizeof(memoryStatistics));
+}
+
+static const char *memoryTagNames[UA_MEMORYTAGSSIZE] = {
+    "other", "securechannel", "service", "session",
+    "nodestore", "subscription", "history", "pubsub"};
+
+const char *
+UA_MemoryTag_name(UA_MemoryTag tag) {
+    if((size_t)tag >= UA_MEMORYTAGSSIZE)
+        return "unknown";
+    return memoryTagNames[tag];
+}
+
+#endif /* UA_ENABLE_MEMORY_ACCOUNTING */
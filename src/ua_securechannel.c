@@ -195,7 +195,7 @@ UA_SecureChannel_sendAsymmetricOPNMessage(UA_SecureChannel *channel,
     /* Add padding to the chunk. Also pad if the securityMode is SIGN_ONLY,
      * since we are using asymmetric communication to exchange keys and thus
      * need to encrypt. */
-    if(channel->securityMode != UA_MESSAGESECURITYMODE_NONE)
+    if(UA_SecureChannel_isAsymEncrypted(channel))
         padChunk(channel, &channel->securityPolicy->asymmetricModule.cryptoModule,
                  &buf.data[UA_SECURECHANNEL_CHANNELHEADER_LENGTH + securityHeaderLength],
                  &buf_pos);
@@ -418,6 +418,30 @@ UA_MessageContext_encode(UA_MessageContext *mc, const void *content,
     return res;
 }
 
+UA_StatusCode
+UA_MessageContext_encodeRaw(UA_MessageContext *mc, const UA_ByteString *encoded) {
+    const UA_Byte *pos = encoded->data;
+    size_t remaining = encoded->length;
+    while(true) {
+        size_t space = (uintptr_t)mc->buf_end - (uintptr_t)mc->buf_pos;
+        size_t len = (remaining < space) ? remaining : space;
+        memcpy(mc->buf_pos, pos, len);
+        mc->buf_pos += len;
+        pos += len;
+        remaining -= len;
+        if(remaining == 0)
+            return UA_STATUSCODE_GOOD;
+
+        /* Send the full chunk and continue in a new buffer */
+        UA_StatusCode res = sendSymmetricEncodingCallback(mc, &mc->buf_pos, &mc->buf_end);
+        if(res != UA_STATUSCODE_GOOD) {
+            if(mc->messageBuffer.length > 0)
+                UA_MessageContext_abort(mc);
+            return res;
+        }
+    }
+}
+
 UA_StatusCode
 UA_MessageContext_finish(UA_MessageContext *mc) {
     mc->final = true;
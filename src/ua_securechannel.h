@@ -234,6 +234,11 @@ UA_StatusCode
 UA_MessageContext_encode(UA_MessageContext *mc, const void *content,
                          const UA_DataType *contentType);
 
+/* Append already encoded content and send out full chunks. Same semantics for
+ * the return code as for _encode. */
+UA_StatusCode
+UA_MessageContext_encodeRaw(UA_MessageContext *mc, const UA_ByteString *encoded);
+
 /* Sends a symmetric message already encoded in the context. The context is
  * cleaned up, also in case of errors. */
 UA_StatusCode
@@ -281,6 +286,15 @@ UA_SecureChannel_receive(UA_SecureChannel *channel, void *application,
 
 /* Internal methods in ua_securechannel_crypto.h */
 
+/* The OPN messages are encrypted with the asymmetric algorithm unless the
+ * SecurityPolicy exchanges keys without asymmetric encryption (ECC). */
+static UA_INLINE UA_Boolean
+UA_SecureChannel_isAsymEncrypted(const UA_SecureChannel *channel) {
+    return (channel->securityMode != UA_MESSAGESECURITYMODE_NONE &&
+            channel->securityPolicy->asymmetricModule.cryptoModule.
+            encryptionAlgorithm.encrypt != NULL);
+}
+
 void
 hideBytesAsym(const UA_SecureChannel *channel, UA_Byte **buf_start,
               const UA_Byte **buf_end);
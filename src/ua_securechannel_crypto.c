@@ -31,7 +31,11 @@ UA_SecureChannel_generateLocalNonce(UA_SecureChannel *channel) {
         UA_CHECK_STATUS(res, return res);
     }
 
-    /* Generate the nonce */
+    /* Generate the nonce. Policies with an ephemeral key exchange keep the
+     * private key in the channel context. */
+    if(sp->channelModule.generateNonce)
+        return sp->channelModule.generateNonce(channel->channelContext,
+                                               &channel->localNonce);
     return sp->symmetricModule.generateNonce(sp->policyContext, &channel->localNonce);
 }
 
@@ -62,8 +66,11 @@ UA_SecureChannel_generateLocalKeys(const UA_SecureChannel *channel) {
     UA_ByteString localIv = {encrBS, &buf.data[signKL + encrKL]};
 
     /* Generate key */
-    retval = sm->generateKey(sp->policyContext, &channel->remoteNonce,
-                             &channel->localNonce, &buf);
+    if(cm->generateKey)
+        retval = cm->generateKey(cc, &channel->remoteNonce, &channel->localNonce, &buf);
+    else
+        retval = sm->generateKey(sp->policyContext, &channel->remoteNonce,
+                                 &channel->localNonce, &buf);
     UA_CHECK_STATUS(retval, goto error);
 
     /* Set the channel context */
@@ -105,8 +112,11 @@ generateRemoteKeys(const UA_SecureChannel *channel) {
     UA_ByteString remoteIv = {encrBS, &buf.data[signKL + encrKL]};
 
     /* Generate key */
-    retval = sm->generateKey(sp->policyContext, &channel->localNonce,
-                             &channel->remoteNonce, &buf);
+    if(cm->generateKey)
+        retval = cm->generateKey(cc, &channel->localNonce, &channel->remoteNonce, &buf);
+    else
+        retval = sm->generateKey(sp->policyContext, &channel->localNonce,
+                                 &channel->remoteNonce, &buf);
     UA_CHECK_STATUS(retval, goto error);
 
     /* Set the channel context */
@@ -153,7 +163,7 @@ prependHeadersAsym(UA_SecureChannel *const channel, UA_Byte *header_pos,
     const UA_SecurityPolicy *sp = channel->securityPolicy;
     UA_CHECK_MEM(sp, return UA_STATUSCODE_BADINTERNALERROR);
 
-    if(channel->securityMode == UA_MESSAGESECURITYMODE_NONE) {
+    if(!UA_SecureChannel_isAsymEncrypted(channel)) {
         *encryptedLength = totalLength;
     } else {
         size_t dataToEncryptLength = totalLength -
@@ -218,6 +228,8 @@ hideBytesAsym(const UA_SecureChannel *channel, UA_Byte **buf_start,
     const UA_SecurityPolicy *sp = channel->securityPolicy;
     *buf_end -= sp->asymmetricModule.cryptoModule.signatureAlgorithm.
         getLocalSignatureSize(channel->channelContext);
+    if(!UA_SecureChannel_isAsymEncrypted(channel))
+        return;
 
     /* Block sizes depend on the remote key (certificate) */
     size_t plainTextBlockSize = sp->asymmetricModule.cryptoModule.
@@ -294,6 +306,8 @@ signAndEncryptAsym(UA_SecureChannel *channel, size_t preSignLength,
     UA_StatusCode retval = sp->asymmetricModule.cryptoModule.signatureAlgorithm.
         sign(channel->channelContext, &dataToSign, &signature);
     UA_CHECK_STATUS(retval, return retval);
+    if(!UA_SecureChannel_isAsymEncrypted(channel))
+        return UA_STATUSCODE_GOOD;
 
     /* Specification part 6, 6.7.4: The OpenSecureChannel Messages are
      * signed and encrypted if the SecurityMode is not None (even if the
@@ -439,10 +453,12 @@ decryptAndVerifyChunk(const UA_SecureChannel *channel,
                       const UA_SecurityPolicyCryptoModule *cryptoModule,
                       UA_MessageType messageType, UA_ByteString *chunk,
                       size_t offset) {
-    /* Decrypt the chunk */
+    /* Decrypt the chunk. The OPN is only signed if the SecurityPolicy has no
+     * asymmetric encryption. */
     UA_StatusCode res = UA_STATUSCODE_GOOD;
-    if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT ||
-       messageType == UA_MESSAGETYPE_OPN) {
+    if((channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT ||
+        messageType == UA_MESSAGETYPE_OPN) &&
+       cryptoModule->encryptionAlgorithm.decrypt) {
         UA_ByteString cipher = {chunk->length - offset, chunk->data + offset};
         res = cryptoModule->encryptionAlgorithm.decrypt(channel->channelContext, &cipher);
         UA_CHECK_STATUS(res, return res);
@@ -465,9 +481,10 @@ decryptAndVerifyChunk(const UA_SecureChannel *channel,
 
     /* Compute the padding if the payload as encrypted */
     size_t padSize = 0;
-    if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT ||
-       (messageType == UA_MESSAGETYPE_OPN &&
-        cryptoModule->encryptionAlgorithm.uri.length > 0)) {
+    if(cryptoModule->encryptionAlgorithm.decrypt &&
+       (channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT ||
+        (messageType == UA_MESSAGETYPE_OPN &&
+         cryptoModule->encryptionAlgorithm.uri.length > 0))) {
         padSize = decodePadding(channel, cryptoModule, chunk, sigsize);
         UA_LOG_TRACE_CHANNEL(channel->securityPolicy->logger, channel,
                              "Calculated padding size to be %lu",
@@ -47,6 +47,10 @@ extern const UA_copySignature copyJumpTable[UA_DATATYPEKINDS];
 typedef void (*UA_clearSignature)(void *p, const UA_DataType *type);
 extern const UA_clearSignature clearJumpTable[UA_DATATYPEKINDS];
 
+typedef UA_Boolean
+(*UA_equalSignature)(const void *p1, const void *p2, const UA_DataType *type);
+extern const UA_equalSignature equalJumpTable[UA_DATATYPEKINDS];
+
 const UA_DataType *
 UA_findDataTypeWithCustom(const UA_NodeId *typeId,
                           const UA_DataTypeArray *customTypes) {
@@ -581,6 +585,78 @@ UA_ExtensionObject_setValueCopy(UA_ExtensionObject *eo,
 }
 
 /* Variant */
+
+/* The payload of variants with UA_VARIANT_DATA_SHARED starts with a
+ * UA_SharedVariant header. The elements follow directly after the header. The
+ * union aligns the elements for all types. */
+typedef union {
+    UA_SharedVariant sv;
+    UA_Double alignDouble;
+    UA_UInt64 alignInt;
+    void *alignPtr;
+} SharedPayload;
+
+static SharedPayload *
+getSharedPayload(const UA_Variant *v) {
+    return (SharedPayload*)((uintptr_t)v->data - sizeof(SharedPayload));
+}
+
+UA_SharedVariant *
+UA_Variant_getShared(const UA_Variant *v) {
+    if(v->storageType != UA_VARIANT_DATA_SHARED ||
+       !v->type || v->data <= UA_EMPTY_ARRAY_SENTINEL)
+        return NULL;
+    return &getSharedPayload(v)->sv;
+}
+
+static size_t
+sharedLength(const UA_SharedVariant *sv) {
+    return (sv->value.arrayLength == 0) ? 1 : sv->value.arrayLength;
+}
+
+static void
+releaseSharedPayload(const UA_Variant *v) {
+    SharedPayload *sp = getSharedPayload(v);
+    if(UA_atomic_subSize(&sp->sv.refCount, 1) > 0)
+        return;
+    const UA_DataType *type = sp->sv.value.type;
+    if(!type->pointerFree) {
+        uintptr_t ptr = (uintptr_t)sp->sv.value.data;
+        size_t length = sharedLength(&sp->sv);
+        for(size_t i = 0; i < length; i++) {
+            clearJumpTable[type->typeKind]((void*)ptr, type);
+            ptr += type->memSize;
+        }
+    }
+    UA_free(sp);
+}
+
+/* Deep-copy the elements into preallocated memory */
+static UA_StatusCode
+copyElements(const void *src, void *dst, size_t length, const UA_DataType *type) {
+    if(type->pointerFree) {
+        memcpy(dst, src, length * type->memSize);
+        return UA_STATUSCODE_GOOD;
+    }
+    uintptr_t ptrs = (uintptr_t)src;
+    uintptr_t ptrd = (uintptr_t)dst;
+    for(size_t i = 0; i < length; i++) {
+        UA_StatusCode res = UA_copy((void*)ptrs, (void*)ptrd, type);
+        if(res != UA_STATUSCODE_GOOD) {
+            /* Clean up the elements copied so far */
+            ptrd = (uintptr_t)dst;
+            for(size_t j = 0; j < i; j++) {
+                UA_clear((void*)ptrd, type);
+                ptrd += type->memSize;
+            }
+            return res;
+        }
+        ptrs += type->memSize;
+        ptrd += type->memSize;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 static void
 Variant_clear(UA_Variant *p, const UA_DataType *_) {
     /* The content is "borrowed" */
@@ -589,9 +665,13 @@ Variant_clear(UA_Variant *p, const UA_DataType *_) {
 
     /* Delete the value */
     if(p->type && p->data > UA_EMPTY_ARRAY_SENTINEL) {
-        if(p->arrayLength == 0)
-            p->arrayLength = 1;
-        UA_Array_delete(p->data, p->arrayLength, p->type);
+        if(p->storageType == UA_VARIANT_DATA_SHARED) {
+            releaseSharedPayload(p);
+        } else {
+            if(p->arrayLength == 0)
+                p->arrayLength = 1;
+            UA_Array_delete(p->data, p->arrayLength, p->type);
+        }
         p->data = NULL;
     }
 
@@ -602,18 +682,27 @@ Variant_clear(UA_Variant *p, const UA_DataType *_) {
 
 static UA_StatusCode
 Variant_copy(UA_Variant const *src, UA_Variant *dst, const UA_DataType *_) {
-    size_t length = src->arrayLength;
-    if(UA_Variant_isScalar(src))
-        length = 1;
-    UA_StatusCode retval = UA_Array_copy(src->data, length,
-                                         &dst->data, src->type);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
+    if(src->storageType == UA_VARIANT_DATA_SHARED &&
+       src->type && src->data > UA_EMPTY_ARRAY_SENTINEL) {
+        /* Only increase the reference count of the shared payload */
+        UA_atomic_addSize(&getSharedPayload(src)->sv.refCount, 1);
+        dst->data = src->data;
+        dst->storageType = UA_VARIANT_DATA_SHARED;
+    } else {
+        size_t length = src->arrayLength;
+        if(UA_Variant_isScalar(src))
+            length = 1;
+        UA_StatusCode retval = UA_Array_copy(src->data, length,
+                                             &dst->data, src->type);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
     dst->arrayLength = src->arrayLength;
     dst->type = src->type;
     if(src->arrayDimensions) {
-        retval = UA_Array_copy(src->arrayDimensions, src->arrayDimensionsSize,
-            (void**)&dst->arrayDimensions, &UA_TYPES[UA_TYPES_INT32]);
+        UA_StatusCode retval =
+            UA_Array_copy(src->arrayDimensions, src->arrayDimensionsSize,
+                          (void**)&dst->arrayDimensions, &UA_TYPES[UA_TYPES_INT32]);
         if(retval != UA_STATUSCODE_GOOD)
             return retval;
         dst->arrayDimensionsSize = src->arrayDimensionsSize;
@@ -621,6 +710,96 @@ Variant_copy(UA_Variant const *src, UA_Variant *dst, const UA_DataType *_) {
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+UA_Variant_share(UA_Variant *v) {
+    if(v->storageType == UA_VARIANT_DATA_SHARED ||
+       !v->type || v->data <= UA_EMPTY_ARRAY_SENTINEL)
+        return UA_STATUSCODE_GOOD;
+
+    size_t length = v->arrayLength;
+    if(length == 0)
+        length = 1; /* Scalar */
+    size_t memSize = v->type->memSize;
+    if(length > (SIZE_MAX - sizeof(SharedPayload)) / memSize)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    SharedPayload *sp = (SharedPayload*)
+        UA_malloc(sizeof(SharedPayload) + (length * memSize));
+    if(!sp)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    void *payload = (void*)&sp[1];
+    sp->sv.refCount = 1;
+    UA_Variant_init(&sp->sv.value);
+    sp->sv.value.type = v->type;
+    sp->sv.value.arrayLength = v->arrayLength;
+    sp->sv.value.data = payload;
+    sp->sv.value.storageType = UA_VARIANT_DATA_NODELETE; /* Freed with the header */
+
+    /* Move the owned elements into the payload. This is a shallow copy. */
+    if(v->storageType == UA_VARIANT_DATA) {
+        memcpy(payload, v->data, length * memSize);
+        UA_free(v->data);
+        v->data = payload;
+        v->storageType = UA_VARIANT_DATA_SHARED;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Copy the borrowed array dimensions and elements */
+    UA_UInt32 *dims = NULL;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(v->arrayDimensions) {
+        res = UA_Array_copy(v->arrayDimensions, v->arrayDimensionsSize,
+                            (void**)&dims, &UA_TYPES[UA_TYPES_UINT32]);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(sp);
+            return res;
+        }
+    }
+    res = copyElements(v->data, payload, length, v->type);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(dims);
+        UA_free(sp);
+        return res;
+    }
+    v->data = payload;
+    v->arrayDimensions = dims;
+    v->storageType = UA_VARIANT_DATA_SHARED;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Variant_unshare(UA_Variant *v) {
+    if(v->storageType != UA_VARIANT_DATA_SHARED)
+        return UA_STATUSCODE_GOOD;
+    if(!v->type || v->data <= UA_EMPTY_ARRAY_SENTINEL) {
+        v->storageType = UA_VARIANT_DATA;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    SharedPayload *sp = getSharedPayload(v);
+    size_t length = sharedLength(&sp->sv);
+    void *data = UA_malloc(length * v->type->memSize);
+    if(!data)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* The payload is referenced only by this variant. Move the elements out.
+     * The reference count cannot increase concurrently as there is no other
+     * reference to copy from. */
+    if(UA_atomic_addSize(&sp->sv.refCount, 0) == 1) {
+        memcpy(data, v->data, length * v->type->memSize);
+        UA_free(sp);
+    } else {
+        UA_StatusCode res = copyElements(v->data, data, length, v->type);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(data);
+            return res;
+        }
+        releaseSharedPayload(v);
+    }
+    v->data = data;
+    v->storageType = UA_VARIANT_DATA;
+    return UA_STATUSCODE_GOOD;
+}
+
 void
 UA_Variant_setScalar(UA_Variant *v, void * UA_RESTRICT p,
                      const UA_DataType *type) {
@@ -667,16 +846,24 @@ UA_Variant_setArrayCopy(UA_Variant *v, const void * UA_RESTRICT array,
     return UA_STATUSCODE_GOOD;
 }
 
-/* Test if a range is compatible with a variant. If yes, the following values
- * are set:
- * - total: how many elements are in the range
- * - block: how big is each contiguous block of elements in the variant that
- *   maps into the range
- * - stride: how many elements are between the blocks (beginning to beginning)
- * - first: where does the first block begin */
+/* Memory layout of a range within a (multi-dimensional) array. The range is
+ * made up of contiguous blocks of elements. The blocks are arranged in nested
+ * strided dimensions (innermost first). Dimensions where the range has a single
+ * entry are dropped and neighboring dimensions that continue the stride of the
+ * inner dimension are merged. */
+typedef struct {
+    size_t total;  /* How many elements are in the range */
+    size_t block;  /* Size of the contiguous blocks */
+    size_t first;  /* Where does the first block begin */
+    size_t dimsSize;
+    size_t count[UA_MAX_ARRAY_DIMS];  /* Number of blocks in the dimension */
+    size_t stride[UA_MAX_ARRAY_DIMS]; /* Elements between the blocks */
+} RangeLayout;
+
+/* Test if a range is compatible with a variant and compute the layout */
 static UA_StatusCode
-computeStrides(const UA_Variant *v, const UA_NumericRange range,
-               size_t *total, size_t *block, size_t *stride, size_t *first) {
+computeRangeLayout(const UA_Variant *v, const UA_NumericRange range,
+                   RangeLayout *rl) {
     /* Test for max array size (64bit only) */
 #if (SIZE_MAX > 0xffffffff)
     if(v->arrayLength > UA_UINT32_MAX)
@@ -727,29 +914,116 @@ computeStrides(const UA_Variant *v, const UA_NumericRange range,
         count *= (realmax[i] - range.dimensions[i].min) + 1;
     }
 
-    *total = count;
+    rl->total = count;
+    rl->block = count; /* Assume the range describes the entire array. */
+    rl->first = 0;     /* So it can be copied as a contiguous block.   */
+    rl->dimsSize = 0;
 
-    /* Compute the stride length and the position of the first element */
-    *block = count;           /* Assume the range describes the entire array. */
-    *stride = v->arrayLength; /* So it can be copied as a contiguous block.   */
-    *first = 0;
+    /* Compute the block length, the strides and the position of the first
+     * element. Begin with the innermost dimension. */
     size_t running_dimssize = 1;
     UA_Boolean found_contiguous = false;
     for(size_t k = dims_count; k > 0;) {
         --k;
         size_t dimrange = 1 + realmax[k] - range.dimensions[k].min;
-        if(!found_contiguous && dimrange != dims[k]) {
-            /* Found the maximum block that can be copied contiguously */
-            found_contiguous = true;
-            *block = running_dimssize * dimrange;
-            *stride = running_dimssize * dims[k];
+        rl->first += running_dimssize * range.dimensions[k].min;
+        if(!found_contiguous) {
+            if(dimrange != dims[k]) {
+                /* Found the maximum block that can be copied contiguously */
+                found_contiguous = true;
+                rl->block = running_dimssize * dimrange;
+            }
+        } else if(dimrange > 1) {
+            size_t last = rl->dimsSize - 1;
+            if(rl->dimsSize > 0 &&
+               rl->count[last] * rl->stride[last] == running_dimssize) {
+                /* Continues the stride of the inner dimension */
+                rl->count[last] *= dimrange;
+            } else {
+                rl->count[rl->dimsSize] = dimrange;
+                rl->stride[rl->dimsSize] = running_dimssize;
+                rl->dimsSize++;
+            }
         }
-        *first += running_dimssize * range.dimensions[k].min;
         running_dimssize *= dims[k];
     }
+
+    /* A single block */
+    if(rl->dimsSize == 0) {
+        rl->count[0] = 1;
+        rl->stride[0] = rl->block;
+        rl->dimsSize = 1;
+    }
     return UA_STATUSCODE_GOOD;
 }
 
+/* Advance the position over the outer dimensions (after the innermost) of the
+ * range layout. Returns the element offset of the next row of blocks. */
+static size_t
+RangeLayout_nextRow(const RangeLayout *rl, size_t *idx, size_t offset) {
+    for(size_t j = 1; j < rl->dimsSize; j++) {
+        idx[j]++;
+        offset += rl->stride[j];
+        if(idx[j] < rl->count[j])
+            break;
+        offset -= rl->count[j] * rl->stride[j];
+        idx[j] = 0;
+    }
+    return offset;
+}
+
+/* Copy n blocks of blockSize bytes between strided locations. The common
+ * element sizes get fixed-size copies that the compiler turns into plain
+ * (vectorized) loads and stores instead of a memcpy call per element. */
+#define STRIDED_COPY_FIXED(SIZE)                                        \
+    for(size_t i = 0; i < n; i++) {                                     \
+        memcpy(dst, src, SIZE);                                         \
+        dst += dstStride;                                               \
+        src += srcStride;                                               \
+    }                                                                   \
+    return;
+
+static void
+stridedCopy(u8 * UA_RESTRICT dst, size_t dstStride,
+            const u8 * UA_RESTRICT src, size_t srcStride,
+            size_t n, size_t blockSize) {
+    /* Both sides contiguous */
+    if(dstStride == blockSize && srcStride == blockSize) {
+        memcpy(dst, src, n * blockSize);
+        return;
+    }
+    switch(blockSize) {
+    case 1: STRIDED_COPY_FIXED(1)
+    case 2: STRIDED_COPY_FIXED(2)
+    case 4: STRIDED_COPY_FIXED(4)
+    case 8: STRIDED_COPY_FIXED(8)
+    case 16: STRIDED_COPY_FIXED(16)
+    default: STRIDED_COPY_FIXED(blockSize)
+    }
+}
+
+/* Gather (toRange = false) or scatter (toRange = true) the range between the
+ * array and a contiguous buffer */
+static void
+copyRangePointerFree(const RangeLayout *rl, u8 *array, u8 *buf,
+                     size_t elemSize, UA_Boolean toRange) {
+    size_t blockSize = rl->block * elemSize;
+    size_t rowSize = rl->count[0] * blockSize;
+    size_t rows = rl->total / (rl->count[0] * rl->block);
+    size_t strideSize = rl->stride[0] * elemSize;
+    size_t idx[UA_MAX_ARRAY_DIMS] = {0};
+    size_t offset = rl->first;
+    for(size_t r = 0; r < rows; r++) {
+        u8 *a = array + (offset * elemSize);
+        if(toRange)
+            stridedCopy(a, strideSize, buf, blockSize, rl->count[0], blockSize);
+        else
+            stridedCopy(buf, blockSize, a, strideSize, rl->count[0], blockSize);
+        buf += rowSize;
+        offset = RangeLayout_nextRow(rl, idx, offset);
+    }
+}
+
 /* Is the type string-like? */
 static UA_Boolean
 isStringLike(const UA_DataType *type) {
@@ -820,46 +1094,37 @@ UA_Variant_copyRange(const UA_Variant *src, UA_Variant * UA_RESTRICT dst,
     }
 
     /* Compute the strides */
-    size_t count, block, stride, first;
-    UA_StatusCode retval = computeStrides(src, thisrange, &count,
-                                          &block, &stride, &first);
+    RangeLayout rl;
+    UA_StatusCode retval = computeRangeLayout(src, thisrange, &rl);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
+    size_t count = rl.total;
 
-    /* Allocate the array */
+    /* Allocate the array. Pointer-free elements are overwritten entirely and
+     * need not be zeroed first. */
     UA_Variant_init(dst);
-    dst->data = UA_Array_new(count, src->type);
+    size_t elem_size = src->type->memSize;
+    UA_Boolean pointerFreeCopy =
+        (nextrange.dimensionsSize == 0 && src->type->pointerFree);
+    if(pointerFreeCopy) {
+        if(count > SIZE_MAX / elem_size)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        dst->data = UA_malloc(count * elem_size);
+    } else {
+        dst->data = UA_Array_new(count, src->type);
+    }
     if(!dst->data)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     /* Copy the range */
-    size_t block_count = count / block;
-    size_t elem_size = src->type->memSize;
-    uintptr_t nextdst = (uintptr_t)dst->data;
-    uintptr_t nextsrc = (uintptr_t)src->data + (elem_size * first);
-    if(nextrange.dimensionsSize == 0) {
-        /* no nextrange */
-        if(src->type->pointerFree) {
-            for(size_t i = 0; i < block_count; ++i) {
-                memcpy((void*)nextdst, (void*)nextsrc, elem_size * block);
-                nextdst += block * elem_size;
-                nextsrc += stride * elem_size;
-            }
-        } else {
-            for(size_t i = 0; i < block_count; ++i) {
-                for(size_t j = 0; j < block; ++j) {
-                    retval = UA_copy((const void*)nextsrc,
-                                     (void*)nextdst, src->type);
-                    nextdst += elem_size;
-                    nextsrc += elem_size;
-                }
-                nextsrc += (stride - block) * elem_size;
-            }
-        }
+    if(pointerFreeCopy) {
+        copyRangePointerFree(&rl, (u8*)src->data, (u8*)dst->data,
+                             elem_size, false);
     } else {
-        /* nextrange can only be used for variants and stringlike with remaining
-         * range of dimension 1 */
-        if(src->type != &UA_TYPES[UA_TYPES_VARIANT]) {
+        /* nextrange can only be used for variants and stringlike with
+         * remaining range of dimension 1 */
+        if(nextrange.dimensionsSize > 0 &&
+           src->type != &UA_TYPES[UA_TYPES_VARIANT]) {
             if(!stringLike)
                 retval = UA_STATUSCODE_BADINDEXRANGENODATA;
             if(nextrange.dimensionsSize != 1)
@@ -867,20 +1132,31 @@ UA_Variant_copyRange(const UA_Variant *src, UA_Variant * UA_RESTRICT dst,
         }
 
         /* Copy the content */
-        for(size_t i = 0; i < block_count; ++i) {
-            for(size_t j = 0; j < block && retval == UA_STATUSCODE_GOOD; ++j) {
-                if(stringLike)
-                    retval = copySubString((const UA_String*)nextsrc,
-                                           (UA_String*)nextdst,
-                                           nextrange.dimensions);
-                else
-                    retval = UA_Variant_copyRange((const UA_Variant*)nextsrc,
-                                                  (UA_Variant*)nextdst,
-                                                  nextrange);
-                nextdst += elem_size;
-                nextsrc += elem_size;
+        size_t idx[UA_MAX_ARRAY_DIMS] = {0};
+        size_t offset = rl.first;
+        size_t rows = count / (rl.count[0] * rl.block);
+        uintptr_t nextdst = (uintptr_t)dst->data;
+        for(size_t r = 0; r < rows && retval == UA_STATUSCODE_GOOD; r++) {
+            for(size_t i = 0; i < rl.count[0] && retval == UA_STATUSCODE_GOOD; i++) {
+                uintptr_t nextsrc = (uintptr_t)src->data +
+                    ((offset + i * rl.stride[0]) * elem_size);
+                for(size_t j = 0; j < rl.block && retval == UA_STATUSCODE_GOOD; j++) {
+                    if(nextrange.dimensionsSize == 0)
+                        retval = UA_copy((const void*)nextsrc,
+                                         (void*)nextdst, src->type);
+                    else if(stringLike)
+                        retval = copySubString((const UA_String*)nextsrc,
+                                               (UA_String*)nextdst,
+                                               nextrange.dimensions);
+                    else
+                        retval = UA_Variant_copyRange((const UA_Variant*)nextsrc,
+                                                      (UA_Variant*)nextdst,
+                                                      nextrange);
+                    nextdst += elem_size;
+                    nextsrc += elem_size;
+                }
             }
-            nextsrc += (stride - block) * elem_size;
+            offset = RangeLayout_nextRow(&rl, idx, offset);
         }
     }
 
@@ -913,46 +1189,79 @@ UA_Variant_copyRange(const UA_Variant *src, UA_Variant * UA_RESTRICT dst,
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+UA_Variant_viewRange(const UA_Variant *src, UA_Variant *dst,
+                     const UA_NumericRange range) {
+    if(!src->type)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    /* The range must not reach into the array elements */
+    size_t dims = src->arrayDimensionsSize;
+    if(dims == 0)
+        dims = 1;
+    if(UA_Variant_isScalar(src) || range.dimensionsSize > dims)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+
+    RangeLayout rl;
+    UA_StatusCode retval = computeRangeLayout(src, range, &rl);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    if(rl.block != rl.total)
+        return UA_STATUSCODE_BADNOTSUPPORTED; /* Not contiguous */
+
+    UA_Variant_init(dst);
+    dst->type = src->type;
+    dst->storageType = UA_VARIANT_DATA_NODELETE;
+    dst->data = (void*)((uintptr_t)src->data + (rl.first * src->type->memSize));
+    dst->arrayLength = rl.total;
+    return UA_STATUSCODE_GOOD;
+}
+
 /* TODO: Allow ranges to reach inside a scalars that are array-like, e.g.
  * variant and strings. This is already possible for reading... */
 static UA_StatusCode
 Variant_setRange(UA_Variant *v, void *array, size_t arraySize,
                  const UA_NumericRange range, UA_Boolean copy) {
     /* Compute the strides */
-    size_t count, block, stride, first;
-    UA_StatusCode retval = computeStrides(v, range, &count,
-                                          &block, &stride, &first);
+    RangeLayout rl;
+    UA_StatusCode retval = computeRangeLayout(v, range, &rl);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
-    if(count != arraySize)
+    if(rl.total != arraySize)
         return UA_STATUSCODE_BADINDEXRANGEINVALID;
 
+    /* Copy-on-write for shared payloads */
+    retval = UA_Variant_unshare(v);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
     /* Move/copy the elements */
-    size_t block_count = count / block;
     size_t elem_size = v->type->memSize;
-    uintptr_t nextdst = (uintptr_t)v->data + (first * elem_size);
-    uintptr_t nextsrc = (uintptr_t)array;
     if(v->type->pointerFree || !copy) {
-        for(size_t i = 0; i < block_count; ++i) {
-            memcpy((void*)nextdst, (void*)nextsrc, elem_size * block);
-            nextsrc += block * elem_size;
-            nextdst += stride * elem_size;
-        }
+        copyRangePointerFree(&rl, (u8*)v->data, (u8*)array, elem_size, true);
     } else {
-        for(size_t i = 0; i < block_count; ++i) {
-            for(size_t j = 0; j < block; ++j) {
-                clearJumpTable[v->type->typeKind]((void*)nextdst, v->type);
-                retval |= UA_copy((void*)nextsrc, (void*)nextdst, v->type);
-                nextdst += elem_size;
-                nextsrc += elem_size;
+        size_t idx[UA_MAX_ARRAY_DIMS] = {0};
+        size_t offset = rl.first;
+        size_t rows = rl.total / (rl.count[0] * rl.block);
+        uintptr_t nextsrc = (uintptr_t)array;
+        for(size_t r = 0; r < rows; r++) {
+            for(size_t i = 0; i < rl.count[0]; i++) {
+                uintptr_t nextdst = (uintptr_t)v->data +
+                    ((offset + i * rl.stride[0]) * elem_size);
+                for(size_t j = 0; j < rl.block; j++) {
+                    clearJumpTable[v->type->typeKind]((void*)nextdst, v->type);
+                    retval |= UA_copy((void*)nextsrc, (void*)nextdst, v->type);
+                    nextdst += elem_size;
+                    nextsrc += elem_size;
+                }
             }
-            nextdst += (stride - block) * elem_size;
+            offset = RangeLayout_nextRow(&rl, idx, offset);
         }
     }
 
     /* If members were moved, initialize original array to prevent reuse */
     if(!copy && !v->type->pointerFree)
-        memset(array, 0, sizeof(elem_size)*arraySize);
+        memset(array, 0, elem_size * arraySize);
 
     return retval;
 }
@@ -1220,6 +1529,262 @@ UA_copy(const void *src, void *dst, const UA_DataType *type) {
     return retval;
 }
 
+/************/
+/* Equality */
+/************/
+
+/* Pointer-free types without padding bytes can be compared with memcmp */
+static UA_Boolean
+isMemcmpComparable(const UA_DataType *type) {
+    return (type->overlayable ||
+            type->typeKind <= UA_DATATYPEKIND_DOUBLE ||
+            type->typeKind == UA_DATATYPEKIND_DATETIME ||
+            type->typeKind == UA_DATATYPEKIND_GUID ||
+            type->typeKind == UA_DATATYPEKIND_STATUSCODE ||
+            type->typeKind == UA_DATATYPEKIND_ENUM);
+}
+
+static UA_Boolean
+arrayEqual(const void *p1, size_t size1, const void *p2, size_t size2,
+           const UA_DataType *type) {
+    if(size1 != size2)
+        return false;
+    if(size1 == 0)
+        return true;
+    if(isMemcmpComparable(type))
+        return (memcmp(p1, p2, type->memSize * size1) == 0);
+    uintptr_t ptr1 = (uintptr_t)p1;
+    uintptr_t ptr2 = (uintptr_t)p2;
+    for(size_t i = 0; i < size1; i++) {
+        if(!equalJumpTable[type->typeKind]((const void*)ptr1, (const void*)ptr2, type))
+            return false;
+        ptr1 += type->memSize;
+        ptr2 += type->memSize;
+    }
+    return true;
+}
+
+static UA_Boolean
+equalMemory(const void *p1, const void *p2, const UA_DataType *type) {
+    return (memcmp(p1, p2, type->memSize) == 0);
+}
+
+static UA_Boolean
+String_equal(const UA_String *p1, const UA_String *p2, const UA_DataType *_) {
+    return UA_String_equal(p1, p2);
+}
+
+static UA_Boolean
+NodeId_equal(const UA_NodeId *p1, const UA_NodeId *p2, const UA_DataType *_) {
+    return UA_NodeId_equal(p1, p2);
+}
+
+static UA_Boolean
+ExpandedNodeId_equal(const UA_ExpandedNodeId *p1, const UA_ExpandedNodeId *p2,
+                     const UA_DataType *_) {
+    return (p1->serverIndex == p2->serverIndex &&
+            UA_String_equal(&p1->namespaceUri, &p2->namespaceUri) &&
+            UA_NodeId_equal(&p1->nodeId, &p2->nodeId));
+}
+
+static UA_Boolean
+QualifiedName_equal(const UA_QualifiedName *p1, const UA_QualifiedName *p2,
+                    const UA_DataType *_) {
+    return (p1->namespaceIndex == p2->namespaceIndex &&
+            UA_String_equal(&p1->name, &p2->name));
+}
+
+static UA_Boolean
+LocalizedText_equal(const UA_LocalizedText *p1, const UA_LocalizedText *p2,
+                    const UA_DataType *_) {
+    return (UA_String_equal(&p1->locale, &p2->locale) &&
+            UA_String_equal(&p1->text, &p2->text));
+}
+
+static UA_Boolean
+ExtensionObject_equal(const UA_ExtensionObject *p1, const UA_ExtensionObject *p2,
+                      const UA_DataType *_) {
+    /* The NODELETE variant has the same content as DECODED */
+    UA_Boolean decoded1 = (p1->encoding >= UA_EXTENSIONOBJECT_DECODED);
+    UA_Boolean decoded2 = (p2->encoding >= UA_EXTENSIONOBJECT_DECODED);
+    if(decoded1 != decoded2)
+        return false;
+    if(!decoded1)
+        return (p1->encoding == p2->encoding &&
+                UA_NodeId_equal(&p1->content.encoded.typeId,
+                                &p2->content.encoded.typeId) &&
+                UA_ByteString_equal(&p1->content.encoded.body,
+                                    &p2->content.encoded.body));
+    const UA_DataType *type = p1->content.decoded.type;
+    if(type != p2->content.decoded.type)
+        return false;
+    if(!type || !p1->content.decoded.data || !p2->content.decoded.data)
+        return (p1->content.decoded.data == p2->content.decoded.data);
+    return equalJumpTable[type->typeKind](p1->content.decoded.data,
+                                          p2->content.decoded.data, type);
+}
+
+static UA_Boolean
+Variant_equal(const UA_Variant *p1, const UA_Variant *p2, const UA_DataType *_) {
+    if(p1->type != p2->type)
+        return false;
+    if(!p1->type)
+        return true;
+    if(!arrayEqual(p1->arrayDimensions, p1->arrayDimensionsSize,
+                   p2->arrayDimensions, p2->arrayDimensionsSize,
+                   &UA_TYPES[UA_TYPES_UINT32]))
+        return false;
+    UA_Boolean scalar1 = UA_Variant_isScalar(p1);
+    if(scalar1 != UA_Variant_isScalar(p2))
+        return false;
+    if(scalar1)
+        return equalJumpTable[p1->type->typeKind](p1->data, p2->data, p1->type);
+    return arrayEqual(p1->data, p1->arrayLength, p2->data, p2->arrayLength, p1->type);
+}
+
+static UA_Boolean
+DataValue_equal(const UA_DataValue *p1, const UA_DataValue *p2,
+                const UA_DataType *_) {
+    if(p1->hasValue != p2->hasValue ||
+       p1->hasStatus != p2->hasStatus ||
+       p1->hasSourceTimestamp != p2->hasSourceTimestamp ||
+       p1->hasServerTimestamp != p2->hasServerTimestamp ||
+       p1->hasSourcePicoseconds != p2->hasSourcePicoseconds ||
+       p1->hasServerPicoseconds != p2->hasServerPicoseconds)
+        return false;
+    if((p1->hasStatus && p1->status != p2->status) ||
+       (p1->hasSourceTimestamp && p1->sourceTimestamp != p2->sourceTimestamp) ||
+       (p1->hasServerTimestamp && p1->serverTimestamp != p2->serverTimestamp) ||
+       (p1->hasSourcePicoseconds && p1->sourcePicoseconds != p2->sourcePicoseconds) ||
+       (p1->hasServerPicoseconds && p1->serverPicoseconds != p2->serverPicoseconds))
+        return false;
+    return (!p1->hasValue || Variant_equal(&p1->value, &p2->value, NULL));
+}
+
+static UA_Boolean
+DiagnosticInfo_equal(const UA_DiagnosticInfo *p1, const UA_DiagnosticInfo *p2,
+                     const UA_DataType *_) {
+    if(p1->hasSymbolicId != p2->hasSymbolicId ||
+       p1->hasNamespaceUri != p2->hasNamespaceUri ||
+       p1->hasLocalizedText != p2->hasLocalizedText ||
+       p1->hasLocale != p2->hasLocale ||
+       p1->hasAdditionalInfo != p2->hasAdditionalInfo ||
+       p1->hasInnerStatusCode != p2->hasInnerStatusCode ||
+       p1->hasInnerDiagnosticInfo != p2->hasInnerDiagnosticInfo)
+        return false;
+    if((p1->hasSymbolicId && p1->symbolicId != p2->symbolicId) ||
+       (p1->hasNamespaceUri && p1->namespaceUri != p2->namespaceUri) ||
+       (p1->hasLocalizedText && p1->localizedText != p2->localizedText) ||
+       (p1->hasLocale && p1->locale != p2->locale) ||
+       (p1->hasAdditionalInfo &&
+        !UA_String_equal(&p1->additionalInfo, &p2->additionalInfo)) ||
+       (p1->hasInnerStatusCode && p1->innerStatusCode != p2->innerStatusCode))
+        return false;
+    if(!p1->hasInnerDiagnosticInfo ||
+       p1->innerDiagnosticInfo == p2->innerDiagnosticInfo)
+        return true;
+    if(!p1->innerDiagnosticInfo || !p2->innerDiagnosticInfo)
+        return false;
+    return DiagnosticInfo_equal(p1->innerDiagnosticInfo, p2->innerDiagnosticInfo, NULL);
+}
+
+static UA_Boolean
+Structure_equal(const void *p1, const void *p2, const UA_DataType *type) {
+    uintptr_t ptr1 = (uintptr_t)p1;
+    uintptr_t ptr2 = (uintptr_t)p2;
+    for(size_t i = 0; i < type->membersSize; ++i) {
+        const UA_DataTypeMember *m = &type->members[i];
+        const UA_DataType *mt = m->memberType;
+        ptr1 += m->padding;
+        ptr2 += m->padding;
+        if(!m->isOptional && !m->isArray) {
+            if(!equalJumpTable[mt->typeKind]((const void*)ptr1, (const void*)ptr2, mt))
+                return false;
+            ptr1 += mt->memSize;
+            ptr2 += mt->memSize;
+            continue;
+        }
+        if(!m->isArray) {
+            /* Optional scalar behind a pointer */
+            const void *o1 = *(void* const*)ptr1;
+            const void *o2 = *(void* const*)ptr2;
+            if((o1 == NULL) != (o2 == NULL))
+                return false;
+            if(o1 && !equalJumpTable[mt->typeKind](o1, o2, mt))
+                return false;
+        } else {
+            const size_t size1 = *(const size_t*)ptr1;
+            const size_t size2 = *(const size_t*)ptr2;
+            ptr1 += sizeof(size_t);
+            ptr2 += sizeof(size_t);
+            if(!arrayEqual(*(void* const*)ptr1, size1, *(void* const*)ptr2, size2, mt))
+                return false;
+        }
+        ptr1 += sizeof(void*);
+        ptr2 += sizeof(void*);
+    }
+    return true;
+}
+
+static UA_Boolean
+Union_equal(const void *p1, const void *p2, const UA_DataType *type) {
+    UA_UInt32 selection = *(const UA_UInt32*)p1;
+    if(selection != *(const UA_UInt32*)p2)
+        return false;
+    if(selection == 0)
+        return true;
+    const UA_DataTypeMember *m = &type->members[selection-1];
+    const UA_DataType *mt = m->memberType;
+    uintptr_t ptr1 = (uintptr_t)p1 + m->padding;
+    uintptr_t ptr2 = (uintptr_t)p2 + m->padding;
+    if(!m->isArray)
+        return equalJumpTable[mt->typeKind]((const void*)ptr1, (const void*)ptr2, mt);
+    const size_t size1 = *(const size_t*)ptr1;
+    const size_t size2 = *(const size_t*)ptr2;
+    ptr1 += sizeof(size_t);
+    ptr2 += sizeof(size_t);
+    return arrayEqual(*(void* const*)ptr1, size1, *(void* const*)ptr2, size2, mt);
+}
+
+const UA_equalSignature equalJumpTable[UA_DATATYPEKINDS] = {
+    (UA_equalSignature)equalMemory, /* Boolean */
+    (UA_equalSignature)equalMemory, /* SByte */
+    (UA_equalSignature)equalMemory, /* Byte */
+    (UA_equalSignature)equalMemory, /* Int16 */
+    (UA_equalSignature)equalMemory, /* UInt16 */
+    (UA_equalSignature)equalMemory, /* Int32 */
+    (UA_equalSignature)equalMemory, /* UInt32 */
+    (UA_equalSignature)equalMemory, /* Int64 */
+    (UA_equalSignature)equalMemory, /* UInt64 */
+    (UA_equalSignature)equalMemory, /* Float */
+    (UA_equalSignature)equalMemory, /* Double */
+    (UA_equalSignature)String_equal,
+    (UA_equalSignature)equalMemory, /* DateTime */
+    (UA_equalSignature)equalMemory, /* Guid */
+    (UA_equalSignature)String_equal, /* ByteString */
+    (UA_equalSignature)String_equal, /* XmlElement */
+    (UA_equalSignature)NodeId_equal,
+    (UA_equalSignature)ExpandedNodeId_equal,
+    (UA_equalSignature)equalMemory, /* StatusCode */
+    (UA_equalSignature)QualifiedName_equal,
+    (UA_equalSignature)LocalizedText_equal,
+    (UA_equalSignature)ExtensionObject_equal,
+    (UA_equalSignature)DataValue_equal,
+    (UA_equalSignature)Variant_equal,
+    (UA_equalSignature)DiagnosticInfo_equal,
+    (UA_equalSignature)equalMemory, /* Decimal */
+    (UA_equalSignature)equalMemory, /* Enumeration */
+    (UA_equalSignature)Structure_equal,
+    (UA_equalSignature)Structure_equal, /* Structure with Optional Fields */
+    (UA_equalSignature)Union_equal, /* Union */
+    (UA_equalSignature)equalMemory /* BitfieldCluster*/
+};
+
+UA_Boolean
+UA_equal(const void *p1, const void *p2, const UA_DataType *type) {
+    return equalJumpTable[type->typeKind](p1, p2, type);
+}
+
 static void
 clearStructure(void *p, const UA_DataType *type) {
     uintptr_t ptr = (uintptr_t)p;
@@ -0,0 +1,435 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <open62541/nodeids.h>
+#include <open62541/types_generated_handling.h>
+#include <open62541/util.h>
+
+#include "ua_util_internal.h"
+
+/* Generate UA_DataType descriptors at runtime from the DataTypeDefinition
+ * attribute of DataType nodes. The memory layout follows the rules of the C
+ * compiler for the structures generated by the nodeset compiler. So the
+ * generated types are handled by the standard (binary) encoding routines just
+ * like compiled types. */
+
+/* The maximum padding that fits into UA_DataTypeMember */
+#define MAX_PADDING 63
+
+/* Recursion limit for the alignment computation of nested types */
+#define MAX_ALIGNMENT_DEPTH 32
+
+/* The alignment of a type is the offset after a leading char */
+#define ALIGNOF(TYPE) offsetof(struct {char c; TYPE t;}, t)
+
+static size_t
+builtinAlignment(UA_UInt32 typeKind) {
+    switch(typeKind) {
+    case UA_DATATYPEKIND_BOOLEAN: return ALIGNOF(UA_Boolean);
+    case UA_DATATYPEKIND_SBYTE: return ALIGNOF(UA_SByte);
+    case UA_DATATYPEKIND_BYTE: return ALIGNOF(UA_Byte);
+    case UA_DATATYPEKIND_INT16: return ALIGNOF(UA_Int16);
+    case UA_DATATYPEKIND_UINT16: return ALIGNOF(UA_UInt16);
+    case UA_DATATYPEKIND_INT32: return ALIGNOF(UA_Int32);
+    case UA_DATATYPEKIND_UINT32: return ALIGNOF(UA_UInt32);
+    case UA_DATATYPEKIND_INT64: return ALIGNOF(UA_Int64);
+    case UA_DATATYPEKIND_UINT64: return ALIGNOF(UA_UInt64);
+    case UA_DATATYPEKIND_FLOAT: return ALIGNOF(UA_Float);
+    case UA_DATATYPEKIND_DOUBLE: return ALIGNOF(UA_Double);
+    case UA_DATATYPEKIND_STRING: return ALIGNOF(UA_String);
+    case UA_DATATYPEKIND_DATETIME: return ALIGNOF(UA_DateTime);
+    case UA_DATATYPEKIND_GUID: return ALIGNOF(UA_Guid);
+    case UA_DATATYPEKIND_BYTESTRING: return ALIGNOF(UA_ByteString);
+    case UA_DATATYPEKIND_XMLELEMENT: return ALIGNOF(UA_XmlElement);
+    case UA_DATATYPEKIND_NODEID: return ALIGNOF(UA_NodeId);
+    case UA_DATATYPEKIND_EXPANDEDNODEID: return ALIGNOF(UA_ExpandedNodeId);
+    case UA_DATATYPEKIND_STATUSCODE: return ALIGNOF(UA_StatusCode);
+    case UA_DATATYPEKIND_QUALIFIEDNAME: return ALIGNOF(UA_QualifiedName);
+    case UA_DATATYPEKIND_LOCALIZEDTEXT: return ALIGNOF(UA_LocalizedText);
+    case UA_DATATYPEKIND_EXTENSIONOBJECT: return ALIGNOF(UA_ExtensionObject);
+    case UA_DATATYPEKIND_DATAVALUE: return ALIGNOF(UA_DataValue);
+    case UA_DATATYPEKIND_VARIANT: return ALIGNOF(UA_Variant);
+    case UA_DATATYPEKIND_DIAGNOSTICINFO: return ALIGNOF(UA_DiagnosticInfo);
+    case UA_DATATYPEKIND_ENUM: return ALIGNOF(UA_Int32);
+    default: return 0; /* Decimal and BitfieldCluster are not supported */
+    }
+}
+
+/* An array member is stored as a size_t length followed by the pointer */
+static size_t
+arrayAlignment(void) {
+    size_t a = ALIGNOF(size_t);
+    size_t p = ALIGNOF(void*);
+    return (a > p) ? a : p;
+}
+
+typedef struct {
+    UA_DataType *types;    /* The generated types */
+    size_t typesSize;
+    size_t *alignment;     /* Alignment of the generated types, 0 if the
+                            * layout was not computed yet */
+} GenCtx;
+
+static UA_Boolean
+isGenerated(const GenCtx *ctx, const UA_DataType *type) {
+    return (type >= ctx->types && type < &ctx->types[ctx->typesSize]);
+}
+
+static size_t typeAlignment(const GenCtx *ctx, const UA_DataType *type, size_t depth);
+
+static size_t
+memberAlignment(const GenCtx *ctx, const UA_DataTypeMember *m, size_t depth) {
+    if(m->isArray)
+        return arrayAlignment();
+    if(m->isOptional)
+        return ALIGNOF(void*);
+    return typeAlignment(ctx, m->memberType, depth);
+}
+
+static size_t
+memberSize(const UA_DataTypeMember *m) {
+    if(m->isArray)
+        return sizeof(size_t) + sizeof(void*);
+    if(m->isOptional)
+        return sizeof(void*);
+    return m->memberType->memSize;
+}
+
+/* Returns zero if the alignment cannot be computed */
+static size_t
+typeAlignment(const GenCtx *ctx, const UA_DataType *type, size_t depth) {
+    if(isGenerated(ctx, type))
+        return ctx->alignment[type - ctx->types];
+    if(type->typeKind < UA_DATATYPEKIND_STRUCTURE)
+        return builtinAlignment(type->typeKind);
+    if(type->typeKind > UA_DATATYPEKIND_UNION || depth > MAX_ALIGNMENT_DEPTH)
+        return 0;
+
+    /* Derive the alignment of compiled structures from their members */
+    size_t align = 1;
+    if(type->typeKind == UA_DATATYPEKIND_UNION)
+        align = ALIGNOF(UA_UInt32);
+    for(size_t i = 0; i < type->membersSize; i++) {
+        size_t ma = memberAlignment(ctx, &type->members[i], depth + 1);
+        if(ma == 0)
+            return 0;
+        if(ma > align)
+            align = ma;
+    }
+    return align;
+}
+
+static size_t
+alignOffset(size_t offset, size_t align) {
+    return (offset + align - 1) / align * align;
+}
+
+/* Abstract DataTypes are encoded as Variant (or Int32 for enumerations) when
+ * used as the type of a structure field. Structure and BaseDataType need no
+ * mapping. ExtensionObject and Variant have their NodeIds and are found among
+ * the builtin types. */
+static const UA_DataType *
+abstractFieldType(const UA_NodeId *typeId) {
+    if(typeId->namespaceIndex != 0 ||
+       typeId->identifierType != UA_NODEIDTYPE_NUMERIC)
+        return NULL;
+    switch(typeId->identifier.numeric) {
+    case UA_NS0ID_NUMBER:
+    case UA_NS0ID_INTEGER:
+    case UA_NS0ID_UINTEGER:
+        return &UA_TYPES[UA_TYPES_VARIANT];
+    case UA_NS0ID_ENUMERATION:
+        return &UA_TYPES[UA_TYPES_INT32];
+    default:
+        return NULL;
+    }
+}
+
+static const UA_DataType *
+resolveFieldType(const GenCtx *ctx, const UA_NodeId *typeId,
+                 const UA_DataTypeArray *customTypes) {
+    for(size_t i = 0; i < ctx->typesSize; i++) {
+        if(UA_NodeId_equal(&ctx->types[i].typeId, typeId))
+            return &ctx->types[i];
+    }
+    const UA_DataType *type = UA_findDataTypeWithCustom(typeId, customTypes);
+    if(type)
+        return type;
+    return abstractFieldType(typeId);
+}
+
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+static char *
+copyName(const UA_String *name) {
+    char *out = (char*)UA_malloc(name->length + 1);
+    if(!out)
+        return NULL;
+    if(name->length > 0)
+        memcpy(out, name->data, name->length);
+    out[name->length] = 0;
+    return out;
+}
+#endif
+
+/* Set up the members. The layout is computed later on. */
+static UA_StatusCode
+prepareStructure(GenCtx *ctx, UA_DataType *type,
+                 const UA_StructureDefinition *def,
+                 const UA_DataTypeArray *customTypes) {
+    switch(def->structureType) {
+    case UA_STRUCTURETYPE_STRUCTURE:
+        type->typeKind = UA_DATATYPEKIND_STRUCTURE; break;
+    case UA_STRUCTURETYPE_STRUCTUREWITHOPTIONALFIELDS:
+        type->typeKind = UA_DATATYPEKIND_OPTSTRUCT; break;
+    case UA_STRUCTURETYPE_UNION:
+        type->typeKind = UA_DATATYPEKIND_UNION; break;
+    default:
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+
+    /* The membersSize field has 8 bit. The optional fields are flagged in a
+     * 32 bit encoding mask. */
+    if(def->fieldsSize > 255)
+        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    if(def->fieldsSize == 0 && type->typeKind == UA_DATATYPEKIND_UNION)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+
+    UA_StatusCode res = UA_NodeId_copy(&def->defaultEncodingId,
+                                       &type->binaryEncodingId);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    if(def->fieldsSize == 0)
+        return UA_STATUSCODE_GOOD;
+    type->members = (UA_DataTypeMember*)
+        UA_calloc(def->fieldsSize, sizeof(UA_DataTypeMember));
+    if(!type->members)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    type->membersSize = def->fieldsSize & 0xFF;
+
+    size_t optionals = 0;
+    for(size_t i = 0; i < def->fieldsSize; i++) {
+        const UA_StructureField *f = &def->fields[i];
+        UA_DataTypeMember *m = &type->members[i];
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+        m->memberName = copyName(&f->name);
+        if(!m->memberName)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+#endif
+        m->memberType = resolveFieldType(ctx, &f->dataType, customTypes);
+        if(!m->memberType)
+            return UA_STATUSCODE_BADDATATYPEIDUNKNOWN;
+        if(f->valueRank == UA_VALUERANK_ONE_DIMENSION)
+            m->isArray = true;
+        else if(f->valueRank != UA_VALUERANK_SCALAR)
+            return UA_STATUSCODE_BADNOTSUPPORTED;
+        if(f->isOptional && type->typeKind == UA_DATATYPEKIND_OPTSTRUCT) {
+            m->isOptional = true;
+            optionals++;
+        }
+        /* Only arrays and optional fields can contain the type itself */
+        if(m->memberType == type && !m->isArray && !m->isOptional)
+            return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+    if(optionals > 32)
+        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Can the layout be computed? Generated types that are embedded as a scalar
+ * need to have their layout computed first. */
+static UA_Boolean
+layoutReady(const GenCtx *ctx, const UA_DataType *type) {
+    for(size_t i = 0; i < type->membersSize; i++) {
+        const UA_DataTypeMember *m = &type->members[i];
+        if(m->isArray || m->isOptional || !isGenerated(ctx, m->memberType))
+            continue;
+        if(ctx->alignment[m->memberType - ctx->types] == 0)
+            return false;
+    }
+    return true;
+}
+
+/* Compute the member padding, memSize, alignment and the pointerFree and
+ * overlayable flags the same way the C compiler (and the nodeset compiler)
+ * lays out the structure in memory. */
+static UA_StatusCode
+computeLayout(GenCtx *ctx, UA_DataType *type, size_t *outAlign) {
+    size_t align = 1;
+    size_t offset = 0;
+    UA_Boolean pointerFree = true;
+    UA_Boolean overlayable = (type->typeKind == UA_DATATYPEKIND_STRUCTURE &&
+                              type->membersSize > 0);
+
+    if(type->typeKind == UA_DATATYPEKIND_UNION) {
+        /* The switchfield is followed by a C union of the members. All
+         * members start at the same offset (padding from the beginning). */
+        size_t unionAlign = 1;
+        size_t unionSize = 0;
+        for(size_t i = 0; i < type->membersSize; i++) {
+            const UA_DataTypeMember *m = &type->members[i];
+            size_t ma = memberAlignment(ctx, m, 0);
+            if(ma == 0)
+                return UA_STATUSCODE_BADNOTSUPPORTED;
+            if(ma > unionAlign)
+                unionAlign = ma;
+            size_t ms = memberSize(m);
+            if(ms > unionSize)
+                unionSize = ms;
+            if(m->isArray || !m->memberType->pointerFree)
+                pointerFree = false;
+        }
+        offset = alignOffset(sizeof(UA_UInt32), unionAlign);
+        if(offset > MAX_PADDING)
+            return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+        for(size_t i = 0; i < type->membersSize; i++)
+            type->members[i].padding = offset & MAX_PADDING;
+        offset += unionSize;
+        align = (unionAlign > ALIGNOF(UA_UInt32)) ? unionAlign : ALIGNOF(UA_UInt32);
+    } else {
+        for(size_t i = 0; i < type->membersSize; i++) {
+            UA_DataTypeMember *m = &type->members[i];
+            size_t ma = memberAlignment(ctx, m, 0);
+            if(ma == 0)
+                return UA_STATUSCODE_BADNOTSUPPORTED;
+            if(ma > align)
+                align = ma;
+            size_t padding = alignOffset(offset, ma) - offset;
+            if(padding > MAX_PADDING)
+                return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+            m->padding = padding & MAX_PADDING;
+            offset += padding + memberSize(m);
+            if(m->isArray || m->isOptional || !m->memberType->pointerFree)
+                pointerFree = false;
+            if(m->isArray || m->isOptional || padding > 0 ||
+               !m->memberType->overlayable)
+                overlayable = false;
+        }
+    }
+
+    /* Trailing padding. Empty structures still need a non-zero size. */
+    size_t memSize = alignOffset(offset, align);
+    if(memSize == 0)
+        memSize = align;
+    if(memSize != offset)
+        overlayable = false;
+    if(memSize > UA_UINT16_MAX)
+        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+
+    type->memSize = memSize & UA_UINT16_MAX;
+    type->pointerFree = pointerFree;
+    type->overlayable = overlayable;
+    *outAlign = align;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+prepareType(GenCtx *ctx, size_t index, const UA_QualifiedName *browseName, const UA_Variant *definition,
+            const UA_DataTypeArray *customTypes) {
+    UA_DataType *type = &ctx->types[index];
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+    UA_String empty = UA_STRING_NULL;
+    type->typeName = copyName(browseName ? &browseName->name : &empty);
+    if(!type->typeName)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+#else
+    (void)browseName;
+#endif
+
+    if(UA_Variant_hasScalarType(definition, &UA_TYPES[UA_TYPES_ENUMDEFINITION])) {
+        type->typeKind = UA_DATATYPEKIND_ENUM;
+        type->memSize = sizeof(UA_Int32);
+        type->pointerFree = true;
+        type->overlayable = UA_BINARY_OVERLAYABLE_INTEGER;
+        ctx->alignment[index] = ALIGNOF(UA_Int32);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    if(!UA_Variant_hasScalarType(definition, &UA_TYPES[UA_TYPES_STRUCTUREDEFINITION]))
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    return prepareStructure(ctx, type, (const UA_StructureDefinition*)
+                            definition->data, customTypes);
+}
+
+UA_StatusCode
+UA_DataTypeArray_generate(size_t typesSize, const UA_NodeId *typeIds,
+                          const UA_QualifiedName *browseNames,
+                          const UA_Variant *definitions,
+                          const UA_DataTypeArray *customTypes,
+                          UA_DataTypeArray **out) {
+    if(typesSize == 0 || !typeIds || !definitions || !out)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    GenCtx ctx;
+    ctx.typesSize = typesSize;
+    ctx.types = (UA_DataType*)UA_calloc(typesSize, sizeof(UA_DataType));
+    ctx.alignment = (size_t*)UA_calloc(typesSize, sizeof(size_t));
+    UA_DataTypeArray *arr = (UA_DataTypeArray*)UA_malloc(sizeof(UA_DataTypeArray));
+    if(!ctx.types || !ctx.alignment || !arr) {
+        UA_free(ctx.types);
+        UA_free(ctx.alignment);
+        UA_free(arr);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    /* The fields of UA_DataTypeArray are const */
+    UA_DataTypeArray init = {customTypes, typesSize, ctx.types};
+    memcpy(arr, &init, sizeof(UA_DataTypeArray));
+
+    /* Set the type ids first. The fields can reference all types. */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < typesSize && res == UA_STATUSCODE_GOOD; i++)
+        res = UA_NodeId_copy(&typeIds[i], &ctx.types[i].typeId);
+
+    for(size_t i = 0; i < typesSize && res == UA_STATUSCODE_GOOD; i++)
+        res = prepareType(&ctx, i, browseNames ? &browseNames[i] : NULL,
+                          &definitions[i], customTypes);
+
+    /* Compute the layouts. Embedded types come first. Repeat until no more
+     * progress is made (recursive embedding). */
+    size_t done = 0;
+    for(size_t i = 0; i < typesSize; i++) {
+        if(ctx.alignment[i] != 0)
+            done++;
+    }
+    while(done < typesSize && res == UA_STATUSCODE_GOOD) {
+        size_t before = done;
+        for(size_t i = 0; i < typesSize && res == UA_STATUSCODE_GOOD; i++) {
+            if(ctx.alignment[i] != 0 || !layoutReady(&ctx, &ctx.types[i]))
+                continue;
+            res = computeLayout(&ctx, &ctx.types[i], &ctx.alignment[i]);
+            done++;
+        }
+        if(done == before)
+            res = UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+
+    UA_free(ctx.alignment);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_DataTypeArray_delete(arr);
+        return res;
+    }
+    *out = arr;
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_DataTypeArray_delete(UA_DataTypeArray *types) {
+    if(!types)
+        return;
+    UA_DataType *t = (UA_DataType*)(uintptr_t)types->types;
+    for(size_t i = 0; i < types->typesSize; i++) {
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+        UA_free((void*)(uintptr_t)t[i].typeName);
+        for(size_t j = 0; j < t[i].membersSize; j++)
+            UA_free((void*)(uintptr_t)t[i].members[j].memberName);
+#endif
+        UA_free(t[i].members);
+        UA_NodeId_clear(&t[i].typeId);
+        UA_NodeId_clear(&t[i].binaryEncodingId);
+    }
+    UA_free(t);
+    UA_free(types);
+}
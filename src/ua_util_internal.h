@@ -89,6 +89,20 @@ typedef UA_UInt64 u64;
 typedef UA_Int64 i64;
 typedef UA_StatusCode status;
 
+/* Attribute the allocations between BEGIN and END to a subsystem. The macros
+ * have to be used in the same scope and the scope must not be left in
+ * between. */
+#ifdef UA_ENABLE_MEMORY_ACCOUNTING
+extern UA_THREAD_LOCAL UA_MemoryTag UA_memoryTag;
+# define UA_MEMORYTAG_BEGIN(tag)                        \
+    UA_MemoryTag memoryTagOuter = UA_memoryTag;         \
+    UA_memoryTag = (tag)
+# define UA_MEMORYTAG_END() UA_memoryTag = memoryTagOuter
+#else
+# define UA_MEMORYTAG_BEGIN(tag)
+# define UA_MEMORYTAG_END()
+#endif
+
 /**
  * Error checking macros
  */
@@ -1330,6 +1330,131 @@ START_TEST(UA_Variant_copyShallWorkOnSingleValueExample) {
 }
 END_TEST
 
+START_TEST(UA_Variant_copyShallShareSharedPayload) {
+    UA_String *srcArray = (UA_String*)UA_Array_new(3, &UA_TYPES[UA_TYPES_STRING]);
+    srcArray[0] = UA_STRING_ALLOC("__open");
+    srcArray[1] = UA_STRING_ALLOC("_62541");
+    srcArray[2] = UA_STRING_ALLOC("opc ua");
+    UA_Variant value;
+    UA_Variant_setArray(&value, srcArray, 3, &UA_TYPES[UA_TYPES_STRING]);
+    value.arrayDimensions = (UA_UInt32*)UA_malloc(sizeof(UA_UInt32));
+    value.arrayDimensions[0] = 3;
+    value.arrayDimensionsSize = 1;
+
+    /* The elements are moved into the payload */
+    UA_Byte *strData = srcArray[0].data;
+    UA_StatusCode retval = UA_Variant_share(&value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(value.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert_ptr_eq(((UA_String*)value.data)[0].data, strData);
+
+    /* Sharing twice does nothing */
+    void *payload = value.data;
+    retval = UA_Variant_share(&value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(value.data, payload);
+
+    /* Copies (also inside a DataValue) reference the same payload. The array
+     * dimensions are copied. */
+    UA_Variant copiedValue;
+    retval = UA_Variant_copy(&value, &copiedValue);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(copiedValue.data, payload);
+    ck_assert_int_eq(copiedValue.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert_uint_eq(copiedValue.arrayLength, 3);
+    ck_assert_ptr_ne(copiedValue.arrayDimensions, value.arrayDimensions);
+    ck_assert_uint_eq(copiedValue.arrayDimensions[0], 3);
+
+    UA_DataValue dv, copiedDv;
+    UA_DataValue_init(&dv);
+    dv.value = value;
+    dv.hasValue = true;
+    retval = UA_DataValue_copy(&dv, &copiedDv);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(copiedDv.value.data, payload);
+
+    /* The payload outlives the original variant */
+    UA_Variant_clear(&value);
+    UA_String expected = UA_STRING("_62541");
+    ck_assert(UA_String_equal(&((UA_String*)copiedValue.data)[1], &expected));
+
+    /* Unshare makes a private deep copy while the payload is still referenced */
+    retval = UA_Variant_unshare(&copiedValue);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(copiedValue.storageType, UA_VARIANT_DATA);
+    ck_assert_ptr_ne(copiedValue.data, payload);
+    ck_assert_ptr_ne(((UA_String*)copiedValue.data)[0].data, strData);
+    ck_assert(UA_String_equal(&((UA_String*)copiedValue.data)[1], &expected));
+    UA_Variant_clear(&copiedValue);
+
+    /* The last reference moves the elements out */
+    retval = UA_Variant_unshare(&copiedDv.value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(copiedDv.value.storageType, UA_VARIANT_DATA);
+    ck_assert_ptr_eq(((UA_String*)copiedDv.value.data)[0].data, strData);
+    UA_DataValue_clear(&copiedDv);
+}
+END_TEST
+
+START_TEST(UA_Variant_shareBorrowedScalar) {
+    UA_ByteString text = UA_BYTESTRING("My xml");
+    UA_Variant value;
+    UA_Variant_setScalar(&value, &text, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    value.storageType = UA_VARIANT_DATA_NODELETE;
+
+    /* Borrowed data is copied into the payload */
+    UA_StatusCode retval = UA_Variant_share(&value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(value.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert(UA_Variant_isScalar(&value));
+    ck_assert_ptr_ne(value.data, &text);
+    ck_assert(UA_ByteString_equal((UA_ByteString*)value.data, &text));
+
+    UA_Variant copiedValue;
+    retval = UA_Variant_copy(&value, &copiedValue);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_isScalar(&copiedValue));
+    ck_assert_ptr_eq(copiedValue.data, value.data);
+    UA_Variant_clear(&copiedValue);
+    UA_Variant_clear(&value);
+
+    /* Empty variants are not shared */
+    UA_Variant_init(&value);
+    retval = UA_Variant_share(&value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(value.storageType, UA_VARIANT_DATA);
+}
+END_TEST
+
+START_TEST(UA_Variant_setRangeShallUnsharePayload) {
+    UA_Int32 *srcArray = (UA_Int32*)UA_Array_new(6, &UA_TYPES[UA_TYPES_INT32]);
+    for(UA_Int32 i = 0; i < 6; i++)
+        srcArray[i] = i;
+    UA_Variant value;
+    UA_Variant_setArray(&value, srcArray, 6, &UA_TYPES[UA_TYPES_INT32]);
+    UA_StatusCode retval = UA_Variant_share(&value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Variant copiedValue;
+    retval = UA_Variant_copy(&value, &copiedValue);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Copy-on-write. The other variant keeps the original payload. */
+    UA_Int32 newValue = 42;
+    UA_NumericRangeDimension d = {2, 2};
+    UA_NumericRange range = {1, &d};
+    retval = UA_Variant_setRangeCopy(&value, &newValue, 1, range);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(value.storageType, UA_VARIANT_DATA);
+    ck_assert_int_eq(((UA_Int32*)value.data)[2], 42);
+    ck_assert_int_eq(((UA_Int32*)copiedValue.data)[2], 2);
+    ck_assert_int_eq(copiedValue.storageType, UA_VARIANT_DATA_SHARED);
+
+    UA_Variant_clear(&value);
+    UA_Variant_clear(&copiedValue);
+}
+END_TEST
+
 START_TEST(UA_Variant_copyShallWorkOnByteStringIndexRange) {
     UA_ByteString text = UA_BYTESTRING("My xml");
     UA_Variant src;
@@ -1594,6 +1719,9 @@ static Suite *testSuite_builtin(void) {
     tcase_add_test(tc_copy, UA_Variant_copyShallWorkOn1DArrayExample);
     tcase_add_test(tc_copy, UA_Variant_copyShallWorkOn2DArrayExample);
     tcase_add_test(tc_copy, UA_Variant_copyShallWorkOnByteStringIndexRange);
+    tcase_add_test(tc_copy, UA_Variant_copyShallShareSharedPayload);
+    tcase_add_test(tc_copy, UA_Variant_shareBorrowedScalar);
+    tcase_add_test(tc_copy, UA_Variant_setRangeShallUnsharePayload);
 
     tcase_add_test(tc_copy, UA_DiagnosticInfo_copyShallWorkOnExample);
     tcase_add_test(tc_copy, UA_ApplicationDescription_copyShallWorkOnExample);
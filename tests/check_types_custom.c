@@ -2,8 +2,10 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <open62541/nodeids.h>
 #include <open62541/types.h>
 #include <open62541/types_generated_handling.h>
+#include <open62541/util.h>
 
 #include "ua_types_encoding_binary.h"
 
@@ -667,6 +669,300 @@ START_TEST(parseSelfContainingUnionSelfMember) {
         UA_ByteString_clear(&buf);
     } END_TEST
 
+/* Generate a type at runtime from the StructureDefinition of a compiled type */
+static UA_StatusCode
+generateFromCompiled(const UA_DataType *type, const UA_DataTypeArray *customTypes,
+                     UA_DataTypeArray **out) {
+    UA_StructureDefinition def;
+    UA_StructureDefinition_init(&def);
+    def.defaultEncodingId = type->binaryEncodingId;
+    if(type->typeKind == UA_DATATYPEKIND_OPTSTRUCT)
+        def.structureType = UA_STRUCTURETYPE_STRUCTUREWITHOPTIONALFIELDS;
+    else if(type->typeKind == UA_DATATYPEKIND_UNION)
+        def.structureType = UA_STRUCTURETYPE_UNION;
+    def.fieldsSize = type->membersSize;
+    def.fields = (UA_StructureField*)
+        UA_Array_new(def.fieldsSize, &UA_TYPES[UA_TYPES_STRUCTUREFIELD]);
+    for(size_t i = 0; i < type->membersSize; i++) {
+        const UA_DataTypeMember *m = &type->members[i];
+        def.fields[i].dataType = m->memberType->typeId;
+        def.fields[i].valueRank = m->isArray ? UA_VALUERANK_ONE_DIMENSION : UA_VALUERANK_SCALAR;
+        def.fields[i].isOptional = m->isOptional;
+    }
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &def, &UA_TYPES[UA_TYPES_STRUCTUREDEFINITION]);
+    UA_StatusCode res = UA_DataTypeArray_generate(1, &type->typeId, NULL, &v,
+                                                  customTypes, out);
+    UA_free(def.fields); /* Shallow copies in the fields */
+    return res;
+}
+
+static void
+assertSameLayout(const UA_DataType *gen, const UA_DataType *type) {
+    ck_assert_uint_eq(gen->memSize, type->memSize);
+    ck_assert_uint_eq(gen->typeKind, type->typeKind);
+    ck_assert_uint_eq(gen->pointerFree, type->pointerFree);
+    ck_assert_uint_eq(gen->membersSize, type->membersSize);
+    ck_assert(UA_NodeId_equal(&gen->binaryEncodingId, &type->binaryEncodingId));
+    for(size_t i = 0; i < type->membersSize; i++) {
+        ck_assert_uint_eq(gen->members[i].padding, type->members[i].padding);
+        ck_assert_uint_eq(gen->members[i].isArray, type->members[i].isArray);
+        ck_assert_uint_eq(gen->members[i].isOptional, type->members[i].isOptional);
+        if(type->members[i].memberType == type)
+            ck_assert_ptr_eq(gen->members[i].memberType, gen);
+        else
+            ck_assert(UA_NodeId_equal(&gen->members[i].memberType->typeId,
+                                      &type->members[i].memberType->typeId));
+    }
+
+    /* Overlayable types have the same size in memory and on the wire */
+    if(gen->overlayable) {
+        void *p = UA_new(gen);
+        ck_assert_uint_eq(UA_calcSizeBinary(p, gen), gen->memSize);
+        UA_delete(p, gen);
+    }
+}
+
+START_TEST(generateStandardTypes) {
+    size_t generated = 0;
+    for(size_t i = 0; i < UA_TYPES_COUNT; i++) {
+        const UA_DataType *type = &UA_TYPES[i];
+        if(type->typeKind < UA_DATATYPEKIND_STRUCTURE ||
+           type->typeKind > UA_DATATYPEKIND_UNION)
+            continue;
+        UA_DataTypeArray *arr = NULL;
+        UA_StatusCode res = generateFromCompiled(type, NULL, &arr);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(arr->typesSize, 1);
+        assertSameLayout(&arr->types[0], type);
+        UA_DataTypeArray_delete(arr);
+        generated++;
+    }
+    ck_assert_uint_gt(generated, 0);
+} END_TEST
+
+START_TEST(generateCustomTypes) {
+    const UA_DataType *types[5] = {&PointType, &OptType, &ArrayOptType,
+                                   &UniType, &selfContainingUnionType};
+    for(size_t i = 0; i < 5; i++) {
+        UA_DataTypeArray *arr = NULL;
+        UA_StatusCode res = generateFromCompiled(types[i], &customDataTypesUnion, &arr);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        assertSameLayout(&arr->types[0], types[i]);
+        UA_DataTypeArray_delete(arr);
+    }
+} END_TEST
+
+START_TEST(decodeGeneratedType) {
+    UA_DataTypeArray *arr = NULL;
+    UA_StatusCode retval = generateFromCompiled(&PointType, NULL, &arr);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Encode with the compiled type */
+    Point p = {1.0, 2.0, 3.0};
+    UA_Variant var;
+    UA_Variant_init(&var);
+    UA_Variant_setScalar(&var, &p, &PointType);
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    retval = UA_encodeBinary(&var, &UA_TYPES[UA_TYPES_VARIANT], &buf);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Decode with the generated type */
+    UA_Variant var2;
+    size_t offset = 0;
+    retval = UA_decodeBinaryInternal(&buf, &offset, &var2,
+                                     &UA_TYPES[UA_TYPES_VARIANT], arr);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(var2.type, &arr->types[0]);
+    ck_assert(memcmp(var2.data, &p, sizeof(Point)) == 0);
+
+    UA_Variant_clear(&var2);
+    UA_ByteString_clear(&buf);
+    UA_DataTypeArray_delete(arr);
+} END_TEST
+
+/* Nested types that are generated together. The embedded type comes after the
+ * structure that contains it. */
+typedef struct {
+    UA_Double value;
+    UA_Byte quality;
+} Sample;
+
+typedef struct {
+    UA_Int32 mode; /* Enumeration */
+    Sample last;
+    size_t historySize;
+    Sample *history;
+    UA_Boolean valid;
+} Series;
+
+START_TEST(generateNestedTypes) {
+    UA_NodeId ids[3] = {UA_NODEID_NUMERIC(1, 5000), UA_NODEID_NUMERIC(1, 5001),
+                        UA_NODEID_NUMERIC(1, 5002)};
+    UA_QualifiedName names[3] = {UA_QUALIFIEDNAME(1, "Series"),
+                                 UA_QUALIFIEDNAME(1, "Mode"),
+                                 UA_QUALIFIEDNAME(1, "Sample")};
+
+    UA_StructureField seriesFields[4];
+    memset(seriesFields, 0, sizeof(seriesFields));
+    seriesFields[0].dataType = ids[1];
+    seriesFields[0].valueRank = UA_VALUERANK_SCALAR;
+    seriesFields[1].dataType = ids[2];
+    seriesFields[1].valueRank = UA_VALUERANK_SCALAR;
+    seriesFields[2].dataType = ids[2];
+    seriesFields[2].valueRank = UA_VALUERANK_ONE_DIMENSION;
+    seriesFields[3].dataType = UA_TYPES[UA_TYPES_BOOLEAN].typeId;
+    seriesFields[3].valueRank = UA_VALUERANK_SCALAR;
+    UA_StructureDefinition series;
+    UA_StructureDefinition_init(&series);
+    series.defaultEncodingId = UA_NODEID_NUMERIC(1, 5100);
+    series.fieldsSize = 4;
+    series.fields = seriesFields;
+
+    UA_EnumDefinition mode;
+    UA_EnumDefinition_init(&mode);
+
+    UA_StructureField sampleFields[2];
+    memset(sampleFields, 0, sizeof(sampleFields));
+    sampleFields[0].dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+    sampleFields[0].valueRank = UA_VALUERANK_SCALAR;
+    sampleFields[1].dataType = UA_TYPES[UA_TYPES_BYTE].typeId;
+    sampleFields[1].valueRank = UA_VALUERANK_SCALAR;
+    UA_StructureDefinition sample;
+    UA_StructureDefinition_init(&sample);
+    sample.defaultEncodingId = UA_NODEID_NUMERIC(1, 5102);
+    sample.fieldsSize = 2;
+    sample.fields = sampleFields;
+
+    UA_Variant defs[3];
+    UA_Variant_setScalar(&defs[0], &series, &UA_TYPES[UA_TYPES_STRUCTUREDEFINITION]);
+    UA_Variant_setScalar(&defs[1], &mode, &UA_TYPES[UA_TYPES_ENUMDEFINITION]);
+    UA_Variant_setScalar(&defs[2], &sample, &UA_TYPES[UA_TYPES_STRUCTUREDEFINITION]);
+
+    UA_DataTypeArray *arr = NULL;
+    UA_StatusCode res = UA_DataTypeArray_generate(3, ids, names, defs, NULL, &arr);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    const UA_DataType *s = &arr->types[0];
+    ck_assert_uint_eq(s->memSize, sizeof(Series));
+    ck_assert_uint_eq(s->pointerFree, false);
+    ck_assert_ptr_eq(s->members[0].memberType, &arr->types[1]);
+    ck_assert_ptr_eq(s->members[1].memberType, &arr->types[2]);
+    ck_assert_uint_eq(s->members[1].padding,
+                      offsetof(Series, last) - sizeof(UA_Int32));
+    ck_assert_uint_eq(s->members[2].padding,
+                      offsetof(Series, historySize) - offsetof(Series, last) - sizeof(Sample));
+    ck_assert_uint_eq(s->members[3].padding,
+                      offsetof(Series, valid) - offsetof(Series, history) - sizeof(void*));
+    ck_assert_uint_eq(arr->types[1].typeKind, UA_DATATYPEKIND_ENUM);
+    ck_assert_uint_eq(arr->types[2].memSize, sizeof(Sample));
+    ck_assert_uint_eq(arr->types[2].pointerFree, true);
+    ck_assert_uint_eq(arr->types[2].overlayable, false); /* Trailing padding */
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+    ck_assert_str_eq(s->typeName, "Series");
+#endif
+
+    /* Roundtrip a value */
+    Sample history[2] = {{1.5, 1}, {2.5, 2}};
+    Series v;
+    memset(&v, 0, sizeof(Series));
+    v.mode = 2;
+    v.last.value = 3.5;
+    v.last.quality = 3;
+    v.historySize = 2;
+    v.history = history;
+    v.valid = true;
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    res = UA_encodeBinary(&v, s, &buf);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(buf.length, 4 + 9 + 4 + 2 * 9 + 1);
+    Series v2;
+    size_t offset = 0;
+    res = UA_decodeBinaryInternal(&buf, &offset, &v2, s, arr);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(v2.mode, 2);
+    ck_assert(v2.last.value == 3.5);
+    ck_assert_uint_eq(v2.last.quality, 3);
+    ck_assert_uint_eq(v2.historySize, 2);
+    ck_assert(v2.history[1].value == 2.5);
+    ck_assert_uint_eq(v2.history[1].quality, 2);
+    ck_assert(v2.valid);
+    UA_clear(&v2, s);
+    UA_ByteString_clear(&buf);
+    UA_DataTypeArray_delete(arr);
+
+    /* A type that embeds itself (not as an array) cannot be generated */
+    seriesFields[1].dataType = ids[0];
+    res = UA_DataTypeArray_generate(3, ids, names, defs, NULL, &arr);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNOTSUPPORTED);
+
+    /* Unknown field type */
+    seriesFields[1].dataType = UA_NODEID_NUMERIC(1, 6000);
+    res = UA_DataTypeArray_generate(3, ids, names, defs, NULL, &arr);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADDATATYPEIDUNKNOWN);
+} END_TEST
+
+/* Fields with an abstract DataType */
+typedef struct {
+    UA_ExtensionObject body;
+    UA_Variant value;
+    UA_Int32 kind;
+} Envelope;
+
+START_TEST(generateAbstractFields) {
+    UA_StructureField fields[3];
+    memset(fields, 0, sizeof(fields));
+    fields[0].dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_STRUCTURE);
+    fields[0].valueRank = UA_VALUERANK_SCALAR;
+    fields[1].dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATATYPE);
+    fields[1].valueRank = UA_VALUERANK_SCALAR;
+    fields[2].dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_ENUMERATION);
+    fields[2].valueRank = UA_VALUERANK_SCALAR;
+    UA_StructureDefinition def;
+    UA_StructureDefinition_init(&def);
+    def.defaultEncodingId = UA_NODEID_NUMERIC(1, 5200);
+    def.fieldsSize = 3;
+    def.fields = fields;
+
+    UA_NodeId id = UA_NODEID_NUMERIC(1, 5201);
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &def, &UA_TYPES[UA_TYPES_STRUCTUREDEFINITION]);
+    UA_DataTypeArray *arr = NULL;
+    UA_StatusCode res = UA_DataTypeArray_generate(1, &id, NULL, &v, NULL, &arr);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    const UA_DataType *t = &arr->types[0];
+    ck_assert_ptr_eq(t->members[0].memberType, &UA_TYPES[UA_TYPES_EXTENSIONOBJECT]);
+    ck_assert_ptr_eq(t->members[1].memberType, &UA_TYPES[UA_TYPES_VARIANT]);
+    ck_assert_ptr_eq(t->members[2].memberType, &UA_TYPES[UA_TYPES_INT32]);
+    ck_assert_uint_eq(t->memSize, sizeof(Envelope));
+    ck_assert_uint_eq(t->pointerFree, false);
+
+    /* Roundtrip a value */
+    Point p = {1.0, 2.0, 3.0};
+    UA_Double d = 4.0;
+    Envelope e;
+    memset(&e, 0, sizeof(Envelope));
+    UA_ExtensionObject_setValue(&e.body, &p, &PointType);
+    UA_Variant_setScalar(&e.value, &d, &UA_TYPES[UA_TYPES_DOUBLE]);
+    e.kind = 5;
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    res = UA_encodeBinary(&e, t, &buf);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    Envelope e2;
+    size_t offset = 0;
+    res = UA_decodeBinaryInternal(&buf, &offset, &e2, t, &customDataTypes);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(e2.body.content.decoded.type, &PointType);
+    ck_assert(memcmp(e2.body.content.decoded.data, &p, sizeof(Point)) == 0);
+    ck_assert(UA_Variant_hasScalarType(&e2.value, &UA_TYPES[UA_TYPES_DOUBLE]));
+    ck_assert(*(UA_Double*)e2.value.data == 4.0);
+    ck_assert_int_eq(e2.kind, 5);
+    UA_clear(&e2, t);
+    UA_ByteString_clear(&buf);
+    UA_DataTypeArray_delete(arr);
+} END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test Custom DataType Encoding");
     TCase *tc = tcase_create("test cases");
@@ -681,6 +977,14 @@ int main(void) {
     tcase_add_test(tc, parseCustomStructureWithOptionalFieldsWithArrayContained);
     suite_add_tcase(s, tc);
 
+    TCase *tc_gen = tcase_create("runtime generated types");
+    tcase_add_test(tc_gen, generateStandardTypes);
+    tcase_add_test(tc_gen, generateCustomTypes);
+    tcase_add_test(tc_gen, decodeGeneratedType);
+    tcase_add_test(tc_gen, generateNestedTypes);
+    tcase_add_test(tc_gen, generateAbstractFields);
+    suite_add_tcase(s, tc_gen);
+
     SRunner *sr = srunner_create(s);
     srunner_set_fork_status(sr, CK_NOFORK);
     srunner_run_all (sr, CK_NORMAL);
@@ -256,6 +256,83 @@ START_TEST(decodeComplexTypeFromRandomBufferShallSurvive) {
 }
 END_TEST
 
+START_TEST(copyShallBeEqual) {
+    UA_ByteString msg1;
+    UA_StatusCode retval = UA_ByteString_allocBuffer(&msg1, 256);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+#ifdef _WIN32
+    srand(42);
+#else
+    srandom(42);
+#endif
+    for(int n = 0; n < 100; n++) {
+        for(UA_UInt32 i = 0; i < msg1.length; i++) {
+#ifdef _WIN32
+            msg1.data[i] = (UA_Byte)rand();
+#else
+            msg1.data[i] = (UA_Byte)random();
+#endif
+        }
+        size_t pos = 0;
+        void *obj1 = UA_new(&UA_TYPES[_i]);
+        retval = UA_decodeBinaryInternal(&msg1, &pos, obj1, &UA_TYPES[_i], NULL);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_delete(obj1, &UA_TYPES[_i]);
+            continue;
+        }
+        void *obj2 = UA_new(&UA_TYPES[_i]);
+        retval = UA_copy(obj1, obj2, &UA_TYPES[_i]);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_msg(UA_equal(obj1, obj2, &UA_TYPES[_i]),
+                      "copy differs idx=%d,nodeid=%i", _i,
+                      UA_TYPES[_i].typeId.identifier.numeric);
+        UA_delete(obj1, &UA_TYPES[_i]);
+        UA_delete(obj2, &UA_TYPES[_i]);
+    }
+    UA_ByteString_clear(&msg1);
+}
+END_TEST
+
+START_TEST(variantEqualShallDetectChanges) {
+    UA_Double a1[3] = {1.0, 2.0, 3.0};
+    UA_Double a2[3] = {1.0, 2.0, 3.0};
+    UA_Variant v1, v2;
+    UA_Variant_setArray(&v1, a1, 3, &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_Variant_setArray(&v2, a2, 3, &UA_TYPES[UA_TYPES_DOUBLE]);
+    ck_assert(UA_equal(&v1, &v2, &UA_TYPES[UA_TYPES_VARIANT]));
+    a2[2] = 4.0;
+    ck_assert(!UA_equal(&v1, &v2, &UA_TYPES[UA_TYPES_VARIANT]));
+    v2.arrayLength = 2;
+    ck_assert(!UA_equal(&v1, &v2, &UA_TYPES[UA_TYPES_VARIANT]));
+
+    /* Different types with the same memory are not equal */
+    UA_Int64 i1 = 0;
+    UA_Double d1 = 0.0;
+    UA_Variant_setScalar(&v1, &i1, &UA_TYPES[UA_TYPES_INT64]);
+    UA_Variant_setScalar(&v2, &d1, &UA_TYPES[UA_TYPES_DOUBLE]);
+    ck_assert(!UA_equal(&v1, &v2, &UA_TYPES[UA_TYPES_VARIANT]));
+
+    /* Scalar and array of length one are not equal */
+    UA_Variant_setArray(&v2, &i1, 1, &UA_TYPES[UA_TYPES_INT64]);
+    ck_assert(!UA_equal(&v1, &v2, &UA_TYPES[UA_TYPES_VARIANT]));
+
+    /* Strings are compared by content */
+    UA_String s1 = UA_STRING("open62541");
+    UA_String s2 = UA_STRING_ALLOC("open62541");
+    UA_Variant_setScalar(&v1, &s1, &UA_TYPES[UA_TYPES_STRING]);
+    UA_Variant_setScalar(&v2, &s2, &UA_TYPES[UA_TYPES_STRING]);
+    ck_assert(UA_equal(&v1, &v2, &UA_TYPES[UA_TYPES_VARIANT]));
+    s2.data[0] = 'O';
+    ck_assert(!UA_equal(&v1, &v2, &UA_TYPES[UA_TYPES_VARIANT]));
+    UA_String_clear(&s2);
+
+    /* Empty variants are equal */
+    UA_Variant_init(&v1);
+    UA_Variant_init(&v2);
+    ck_assert(UA_equal(&v1, &v2, &UA_TYPES[UA_TYPES_VARIANT]));
+}
+END_TEST
+
 START_TEST(calcSizeBinaryShallBeCorrect) {
     void *obj = UA_new(&UA_TYPES[_i]);
     size_t predicted_size = UA_calcSizeBinary(obj, &UA_TYPES[_i]);
@@ -297,6 +374,11 @@ int main(void) {
                         UA_TYPES_NODEID, UA_TYPES_COUNT - 1);
     suite_add_tcase(s, tc);
 
+    tc = tcase_create("Equality");
+    tcase_add_loop_test(tc, copyShallBeEqual, UA_TYPES_BOOLEAN, UA_TYPES_COUNT - 1);
+    tcase_add_test(tc, variantEqualShallDetectChanges);
+    suite_add_tcase(s, tc);
+
     tc = tcase_create("Test calcSizeBinary");
     tcase_add_loop_test(tc, calcSizeBinaryShallBeCorrect, UA_TYPES_BOOLEAN, UA_TYPES_COUNT - 1);
     suite_add_tcase(s, tc);
@@ -88,6 +88,156 @@ START_TEST(copyIntoStringArrayRange) {
 }
 END_TEST
 
+/* Reference implementation: the flat indices of the range in row-major order */
+static size_t
+rangeIndices(const UA_UInt32 *dims, size_t dimsSize,
+             const UA_NumericRangeDimension *r, size_t *out) {
+    size_t idx[4];
+    size_t n = 0;
+    for(size_t k = 0; k < dimsSize; k++)
+        idx[k] = r[k].min;
+    while(true) {
+        size_t flat = 0;
+        for(size_t k = 0; k < dimsSize; k++)
+            flat = flat * dims[k] + idx[k];
+        out[n++] = flat;
+        size_t k = dimsSize;
+        while(k > 0) {
+            k--;
+            if(idx[k] < r[k].max) {
+                idx[k]++;
+                break;
+            }
+            idx[k] = r[k].min;
+            if(k == 0)
+                return n;
+        }
+    }
+}
+
+#define MD_DIMS 4
+static const UA_UInt32 mdDims[MD_DIMS] = {3, 4, 5, 6};
+#define MD_SIZE (3 * 4 * 5 * 6)
+
+static void
+randomRange(UA_NumericRangeDimension *r) {
+    for(size_t k = 0; k < MD_DIMS; k++) {
+        UA_UInt32 a = UA_UInt32_random() % mdDims[k];
+        UA_UInt32 b = UA_UInt32_random() % mdDims[k];
+        /* Often use the full dimension to get contiguous blocks */
+        if(UA_UInt32_random() % 3 == 0) {
+            a = 0;
+            b = mdDims[k] - 1;
+        }
+        r[k].min = (a < b) ? a : b;
+        r[k].max = (a < b) ? b : a;
+    }
+}
+
+START_TEST(copyMultiDimRange) {
+    UA_UInt32 arr[MD_SIZE];
+    for(size_t i = 0; i < MD_SIZE; i++)
+        arr[i] = (UA_UInt32)i;
+    UA_Variant v;
+    UA_Variant_setArray(&v, arr, MD_SIZE, &UA_TYPES[UA_TYPES_UINT32]);
+    v.arrayDimensions = (UA_UInt32*)(uintptr_t)mdDims;
+    v.arrayDimensionsSize = MD_DIMS;
+
+    UA_random_seed(42);
+    size_t expected[MD_SIZE];
+    UA_NumericRangeDimension rd[MD_DIMS];
+    UA_NumericRange r = {MD_DIMS, rd};
+    for(size_t t = 0; t < 500; t++) {
+        randomRange(rd);
+        size_t n = rangeIndices(mdDims, MD_DIMS, rd, expected);
+
+        UA_Variant v2;
+        UA_StatusCode retval = UA_Variant_copyRange(&v, &v2, r);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(v2.arrayLength, n);
+        ck_assert_uint_eq(v2.arrayDimensionsSize, MD_DIMS);
+        UA_UInt32 *out = (UA_UInt32*)v2.data;
+        for(size_t i = 0; i < n; i++)
+            ck_assert_uint_eq(out[i], expected[i]);
+
+        /* Write back negated values */
+        for(size_t i = 0; i < n; i++)
+            out[i] = ~out[i];
+        retval = UA_Variant_setRangeCopy(&v, out, n, r);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        for(size_t i = 0; i < n; i++) {
+            ck_assert_uint_eq(arr[expected[i]], ~(UA_UInt32)expected[i]);
+            arr[expected[i]] = (UA_UInt32)expected[i];
+        }
+        for(size_t i = 0; i < MD_SIZE; i++)
+            ck_assert_uint_eq(arr[i], i);
+        UA_Variant_clear(&v2);
+    }
+} END_TEST
+
+START_TEST(copyMultiDimStringRange) {
+    UA_String arr[MD_SIZE];
+    char buf[MD_SIZE][8];
+    for(size_t i = 0; i < MD_SIZE; i++) {
+        snprintf(buf[i], 8, "%u", (unsigned)i);
+        arr[i] = UA_STRING(buf[i]);
+    }
+    UA_Variant v;
+    UA_Variant_setArray(&v, arr, MD_SIZE, &UA_TYPES[UA_TYPES_STRING]);
+    v.arrayDimensions = (UA_UInt32*)(uintptr_t)mdDims;
+    v.arrayDimensionsSize = MD_DIMS;
+
+    UA_random_seed(23);
+    size_t expected[MD_SIZE];
+    UA_NumericRangeDimension rd[MD_DIMS];
+    UA_NumericRange r = {MD_DIMS, rd};
+    for(size_t t = 0; t < 100; t++) {
+        randomRange(rd);
+        size_t n = rangeIndices(mdDims, MD_DIMS, rd, expected);
+        UA_Variant v2;
+        UA_StatusCode retval = UA_Variant_copyRange(&v, &v2, r);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(v2.arrayLength, n);
+        UA_String *out = (UA_String*)v2.data;
+        for(size_t i = 0; i < n; i++)
+            ck_assert(UA_String_equal(&out[i], &arr[expected[i]]));
+        UA_Variant_clear(&v2);
+    }
+} END_TEST
+
+START_TEST(viewRange) {
+    UA_Double arr[MD_SIZE];
+    for(size_t i = 0; i < MD_SIZE; i++)
+        arr[i] = (UA_Double)i;
+    UA_Variant v;
+    UA_Variant_setArray(&v, arr, MD_SIZE, &UA_TYPES[UA_TYPES_DOUBLE]);
+    v.arrayDimensions = (UA_UInt32*)(uintptr_t)mdDims;
+    v.arrayDimensionsSize = MD_DIMS;
+
+    /* Contiguous: a single index in the outer dimensions, the inner
+     * dimensions are complete */
+    UA_NumericRangeDimension rd[MD_DIMS] = {{1, 1}, {1, 2}, {0, 4}, {0, 5}};
+    UA_NumericRange r = {MD_DIMS, rd};
+    UA_Variant view;
+    UA_StatusCode retval = UA_Variant_viewRange(&v, &view, r);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(view.storageType, UA_VARIANT_DATA_NODELETE);
+    ck_assert_uint_eq(view.arrayLength, 2 * 5 * 6);
+    ck_assert_ptr_eq(view.data, &arr[1 * 120 + 1 * 30]);
+    UA_Variant_clear(&view);
+
+    /* Not contiguous */
+    rd[3].max = 4;
+    retval = UA_Variant_viewRange(&v, &view, r);
+    ck_assert_int_eq(retval, UA_STATUSCODE_BADNOTSUPPORTED);
+
+    /* Reaches into the elements */
+    UA_NumericRangeDimension rd2[MD_DIMS + 1] = {{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}};
+    UA_NumericRange r2 = {MD_DIMS + 1, rd2};
+    retval = UA_Variant_viewRange(&v, &view, r2);
+    ck_assert_int_eq(retval, UA_STATUSCODE_BADNOTSUPPORTED);
+} END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test Variant Range Access");
     TCase *tc = tcase_create("test cases");
@@ -95,6 +245,9 @@ int main(void) {
     tcase_add_test(tc, parseRangeMinEqualMax);
     tcase_add_test(tc, copySimpleArrayRange);
     tcase_add_test(tc, copyIntoStringArrayRange);
+    tcase_add_test(tc, copyMultiDimRange);
+    tcase_add_test(tc, copyMultiDimStringRange);
+    tcase_add_test(tc, viewRange);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
@@ -0,0 +1,150 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* IndexRange access to a 4k x 4k matrix of doubles (128MB) */
+
+#include <open62541/types.h>
+#include <open62541/types_generated_handling.h>
+
+#include "check.h"
+#include <stdio.h>
+#include <time.h>
+
+#define DIM 4096
+#define RUNS 10
+
+static UA_Variant matrix;
+static UA_UInt32 matrixDims[2] = {DIM, DIM};
+
+static void setup(void) {
+    UA_Double *data = (UA_Double*)UA_Array_new(DIM * DIM, &UA_TYPES[UA_TYPES_DOUBLE]);
+    ck_assert_ptr_ne(data, NULL);
+    for(size_t i = 0; i < DIM * DIM; i++)
+        data[i] = (UA_Double)i;
+    UA_Variant_setArray(&matrix, data, DIM * DIM, &UA_TYPES[UA_TYPES_DOUBLE]);
+    matrix.arrayDimensions = matrixDims;
+    matrix.arrayDimensionsSize = 2;
+}
+
+static void teardown(void) {
+    matrix.arrayDimensions = NULL;
+    matrix.arrayDimensionsSize = 0;
+    UA_Variant_clear(&matrix);
+}
+
+static void
+report(const char *name, clock_t begin, size_t elements) {
+    double time_spent = (double)(clock() - begin) / CLOCKS_PER_SEC / RUNS;
+    printf("%-22s %9lu elements: %10.3f ms, %8.2f GB/s\n", name,
+           (unsigned long)elements, time_spent * 1000.0,
+           (double)(elements * sizeof(UA_Double)) / 1e9 / time_spent);
+}
+
+static void
+benchCopy(const char *name, UA_NumericRangeDimension *dims) {
+    UA_NumericRange range = {2, dims};
+    UA_Variant out;
+    size_t elements = 0;
+    clock_t begin = clock();
+    for(size_t i = 0; i < RUNS; i++) {
+        UA_StatusCode res = UA_Variant_copyRange(&matrix, &out, range);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        elements = out.arrayLength;
+        UA_Variant_clear(&out);
+    }
+    report(name, begin, elements);
+}
+
+START_TEST(copySubMatrix) {
+    UA_NumericRangeDimension dims[2] = {{1024, 3071}, {1024, 3071}};
+    benchCopy("copy 2k x 2k block", dims);
+} END_TEST
+
+START_TEST(copyColumn) {
+    UA_NumericRangeDimension dims[2] = {{0, DIM - 1}, {100, 100}};
+    benchCopy("copy column", dims);
+} END_TEST
+
+START_TEST(copyColumns) {
+    UA_NumericRangeDimension dims[2] = {{0, DIM - 1}, {100, 101}};
+    benchCopy("copy 2 columns", dims);
+} END_TEST
+
+START_TEST(copyRows) {
+    UA_NumericRangeDimension dims[2] = {{1000, 1999}, {0, DIM - 1}};
+    benchCopy("copy 1k rows", dims);
+} END_TEST
+
+START_TEST(viewRows) {
+    UA_NumericRangeDimension dims[2] = {{1000, 1999}, {0, DIM - 1}};
+    UA_NumericRange range = {2, dims};
+    UA_Variant out;
+    size_t elements = 0;
+    clock_t begin = clock();
+    for(size_t i = 0; i < RUNS; i++) {
+        UA_StatusCode res = UA_Variant_viewRange(&matrix, &out, range);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        elements = out.arrayLength;
+        UA_Variant_clear(&out);
+    }
+    /* No data is copied. Report only the time. */
+    double time_spent = (double)(clock() - begin) / CLOCKS_PER_SEC / RUNS;
+    printf("%-22s %9lu elements: %10.3f ms\n", "view 1k rows",
+           (unsigned long)elements, time_spent * 1000.0);
+} END_TEST
+
+START_TEST(setSubMatrix) {
+    UA_NumericRangeDimension dims[2] = {{1024, 3071}, {1024, 3071}};
+    UA_NumericRange range = {2, dims};
+    size_t elements = 2048 * 2048;
+    UA_Double *block = (UA_Double*)
+        UA_Array_new(elements, &UA_TYPES[UA_TYPES_DOUBLE]);
+    ck_assert_ptr_ne(block, NULL);
+    clock_t begin = clock();
+    for(size_t i = 0; i < RUNS; i++) {
+        UA_StatusCode res = UA_Variant_setRangeCopy(&matrix, block, elements, range);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    report("set 2k x 2k block", begin, elements);
+    UA_Array_delete(block, elements, &UA_TYPES[UA_TYPES_DOUBLE]);
+} END_TEST
+
+START_TEST(setColumn) {
+    UA_NumericRangeDimension dims[2] = {{0, DIM - 1}, {100, 100}};
+    UA_NumericRange range = {2, dims};
+    UA_Double column[DIM];
+    memset(column, 0, sizeof(column));
+    clock_t begin = clock();
+    for(size_t i = 0; i < RUNS; i++) {
+        UA_StatusCode res = UA_Variant_setRangeCopy(&matrix, column, DIM, range);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    report("set column", begin, DIM);
+} END_TEST
+
+static Suite *testSuite_rangeSpeed(void) {
+    Suite *s = suite_create("Variant Range Speed");
+    TCase *tc = tcase_create("4k x 4k");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_set_timeout(tc, 0);
+    tcase_add_test(tc, copySubMatrix);
+    tcase_add_test(tc, copyColumn);
+    tcase_add_test(tc, copyColumns);
+    tcase_add_test(tc, copyRows);
+    tcase_add_test(tc, viewRows);
+    tcase_add_test(tc, setSubMatrix);
+    tcase_add_test(tc, setColumn);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_rangeSpeed();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -147,6 +147,92 @@ START_TEST(Client_endpoints_empty) {
 }
 END_TEST
 
+START_TEST(Client_endpoints_cached) {
+    UA_Client *client = UA_Client_new();
+    UA_ClientConfig_setDefault(UA_Client_getConfig(client));
+
+    /* The second response comes from the cache */
+    UA_EndpointDescription *first = NULL, *second = NULL;
+    size_t firstSize = 0, secondSize = 0;
+    UA_StatusCode retval = UA_Client_getEndpoints(client, "opc.tcp://localhost:4840",
+                                                  &firstSize, &first);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    size_t hits = server->discoveryCache.hits;
+    retval = UA_Client_getEndpoints(client, "opc.tcp://localhost:4840",
+                                    &secondSize, &second);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(server->discoveryCache.hits, hits + 1);
+    ck_assert_uint_eq(firstSize, secondSize);
+    for(size_t i = 0; i < firstSize; i++) {
+        UA_ByteString a = UA_BYTESTRING_NULL, b = UA_BYTESTRING_NULL;
+        UA_encodeBinary(&first[i], &UA_TYPES[UA_TYPES_ENDPOINTDESCRIPTION], &a);
+        UA_encodeBinary(&second[i], &UA_TYPES[UA_TYPES_ENDPOINTDESCRIPTION], &b);
+        ck_assert(UA_ByteString_equal(&a, &b));
+        UA_ByteString_clear(&a);
+        UA_ByteString_clear(&b);
+    }
+
+    /* A new certificate invalidates the cache */
+    UA_ByteString oldCert = UA_BYTESTRING_NULL;
+    UA_ByteString_copy(&first[0].serverCertificate, &oldCert);
+    UA_ByteString newCert = UA_BYTESTRING("new certificate");
+    UA_ByteString newKey = UA_BYTESTRING("new key");
+    retval = UA_Server_updateCertificate(server, &oldCert, &newCert, &newKey,
+                                         false, false);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Array_delete(second, secondSize, &UA_TYPES[UA_TYPES_ENDPOINTDESCRIPTION]);
+    retval = UA_Client_getEndpoints(client, "opc.tcp://localhost:4840",
+                                    &secondSize, &second);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_ByteString_equal(&second[0].serverCertificate, &newCert));
+
+    /* A changed ApplicationDescription invalidates the cache */
+    UA_ApplicationDescription *servers = NULL;
+    size_t serversSize = 0;
+    retval = UA_Client_findServers(client, "opc.tcp://localhost:4840", 0, NULL,
+                                   0, NULL, &serversSize, &servers);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Array_delete(servers, serversSize, &UA_TYPES[UA_TYPES_APPLICATIONDESCRIPTION]);
+    UA_LocalizedText newName = UA_LOCALIZEDTEXT("en", "Renamed Server");
+    UA_LOCK(&server->serviceMutex);
+    UA_LocalizedText_clear(&server->config.applicationDescription.applicationName);
+    UA_LocalizedText_copy(&newName, &server->config.applicationDescription.applicationName);
+    UA_UNLOCK(&server->serviceMutex);
+    hits = server->discoveryCache.hits;
+    retval = UA_Client_findServers(client, "opc.tcp://localhost:4840", 0, NULL,
+                                   0, NULL, &serversSize, &servers);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(server->discoveryCache.hits, hits);
+    ck_assert_uint_eq(serversSize, 1);
+    ck_assert(UA_String_equal(&servers[0].applicationName.text, &newName.text));
+    UA_Array_delete(servers, serversSize, &UA_TYPES[UA_TYPES_APPLICATIONDESCRIPTION]);
+
+    /* The filter is part of the cache key */
+    retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_String profile = UA_STRING("http://opcfoundation.org/UA-Profile/Transport/invalid");
+    UA_GetEndpointsRequest request;
+    UA_GetEndpointsRequest_init(&request);
+    request.requestHeader.timestamp = UA_DateTime_now();
+    request.requestHeader.timeoutHint = 10000;
+    request.endpointUrl = UA_STRING("opc.tcp://localhost:4840");
+    request.profileUris = &profile;
+    request.profileUrisSize = 1;
+    UA_GetEndpointsResponse response;
+    __UA_Client_Service(client, &request, &UA_TYPES[UA_TYPES_GETENDPOINTSREQUEST],
+                        &response, &UA_TYPES[UA_TYPES_GETENDPOINTSRESPONSE]);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.endpointsSize, 0);
+    UA_GetEndpointsResponse_clear(&response);
+
+    UA_ByteString_clear(&oldCert);
+    UA_Array_delete(first, firstSize, &UA_TYPES[UA_TYPES_ENDPOINTDESCRIPTION]);
+    UA_Array_delete(second, secondSize, &UA_TYPES[UA_TYPES_ENDPOINTDESCRIPTION]);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
 START_TEST(Client_read) {
     UA_Client *client = UA_Client_new();
     UA_ClientConfig_setDefault(UA_Client_getConfig(client));
@@ -408,6 +494,7 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_client, Client_delete_without_connect);
     tcase_add_test(tc_client, Client_endpoints);
     tcase_add_test(tc_client, Client_endpoints_empty);
+    tcase_add_test(tc_client, Client_endpoints_cached);
     tcase_add_test(tc_client, Client_read);
     suite_add_tcase(s,tc_client);
     TCase *tc_client_reconnect = tcase_create("Client Reconnect");
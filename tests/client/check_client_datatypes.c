@@ -0,0 +1,258 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include <check.h>
+
+#include "thread_wrapper.h"
+
+/* The server knows the types at compile time. The client generates them at
+ * runtime from the DataTypeDefinition attribute. */
+
+typedef struct {
+    UA_Float x;
+    UA_Float y;
+} Point;
+
+typedef struct {
+    Point position;
+    size_t valuesSize;
+    UA_Double *values;
+    UA_String label;
+} Measurement;
+
+static UA_DataTypeMember Point_members[2] = {
+    {UA_TYPENAME("x") &UA_TYPES[UA_TYPES_FLOAT], 0, false, false},
+    {UA_TYPENAME("y") &UA_TYPES[UA_TYPES_FLOAT],
+     offsetof(Point, y) - offsetof(Point, x) - sizeof(UA_Float), false, false}
+};
+
+extern UA_DataType serverTypes[2];
+
+static UA_DataTypeMember Measurement_members[3] = {
+    {UA_TYPENAME("position") &serverTypes[0], 0, false, false},
+    {UA_TYPENAME("values") &UA_TYPES[UA_TYPES_DOUBLE],
+     offsetof(Measurement, valuesSize) - offsetof(Measurement, position) - sizeof(Point),
+     true, false},
+    {UA_TYPENAME("label") &UA_TYPES[UA_TYPES_STRING],
+     offsetof(Measurement, label) - offsetof(Measurement, values) - sizeof(void*),
+     false, false}
+};
+
+UA_DataType serverTypes[2] = {
+    {UA_TYPENAME("Point") {1, UA_NODEIDTYPE_NUMERIC, {4001}},
+     {1, UA_NODEIDTYPE_NUMERIC, {4101}}, sizeof(Point),
+     UA_DATATYPEKIND_STRUCTURE, true, false, 2, Point_members},
+    {UA_TYPENAME("Measurement") {1, UA_NODEIDTYPE_NUMERIC, {4002}},
+     {1, UA_NODEIDTYPE_NUMERIC, {4102}}, sizeof(Measurement),
+     UA_DATATYPEKIND_STRUCTURE, false, false, 3, Measurement_members}
+};
+
+static const UA_DataTypeArray serverCustomTypes = {NULL, 2, serverTypes};
+
+UA_Server *server;
+UA_Boolean running;
+THREAD_HANDLE server_thread;
+UA_Client *client;
+
+static const UA_NodeId measurementVariable = {1, UA_NODEIDTYPE_NUMERIC, {5000}};
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static void
+addDataTypeNode(const UA_DataType *type) {
+    UA_DataTypeAttributes attr = UA_DataTypeAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("", (char*)(uintptr_t)type->typeName);
+    UA_StatusCode res =
+        UA_Server_addDataTypeNode(server, type->typeId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_STRUCTURE),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                  UA_QUALIFIEDNAME(1, (char*)(uintptr_t)type->typeName),
+                                  attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void setup(void) {
+    running = true;
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setDefault(config);
+    config->customDataTypes = &serverCustomTypes;
+
+    addDataTypeNode(&serverTypes[0]);
+    addDataTypeNode(&serverTypes[1]);
+
+    UA_Double values[3] = {1.0, 2.0, 3.0};
+    Measurement m;
+    m.position.x = 1.5f;
+    m.position.y = -2.5f;
+    m.valuesSize = 3;
+    m.values = values;
+    m.label = UA_STRING("sensor");
+
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    vattr.dataType = serverTypes[1].typeId;
+    vattr.valueRank = UA_VALUERANK_SCALAR;
+    vattr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_Variant_setScalar(&vattr.value, &m, &serverTypes[1]);
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, measurementVariable,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "Measurement"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  vattr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+
+    client = UA_Client_new();
+    UA_ClientConfig_setDefault(UA_Client_getConfig(client));
+    res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void teardown(void) {
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+START_TEST(readWithoutTypes) {
+    /* Without the type, the value is an undecoded ExtensionObject */
+    UA_Variant v;
+    UA_StatusCode res = UA_Client_readValueAttribute(client, measurementVariable, &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_EXTENSIONOBJECT]));
+    UA_Variant_clear(&v);
+} END_TEST
+
+START_TEST(loadAndRead) {
+    /* The Point type is loaded as a dependency */
+    UA_StatusCode res = UA_Client_loadDataTypes(client, 1, &serverTypes[1].typeId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    const UA_DataType *mt = UA_Client_findDataType(client, &serverTypes[1].typeId);
+    const UA_DataType *pt = UA_Client_findDataType(client, &serverTypes[0].typeId);
+    ck_assert_ptr_ne(mt, NULL);
+    ck_assert_ptr_ne(pt, NULL);
+    ck_assert_ptr_ne(mt, &serverTypes[1]);
+    ck_assert_ptr_eq(mt->members[0].memberType, pt);
+    ck_assert_uint_eq(mt->memSize, sizeof(Measurement));
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+    ck_assert_str_eq(mt->typeName, "Measurement");
+    ck_assert_str_eq(mt->members[1].memberName, "values");
+#endif
+
+    /* Known types are skipped */
+    res = UA_Client_loadDataTypes(client, 1, &serverTypes[1].typeId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(UA_Client_findDataType(client, &serverTypes[1].typeId), mt);
+
+    /* The value is decoded natively */
+    UA_Variant v;
+    res = UA_Client_readValueAttribute(client, measurementVariable, &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&v, mt));
+    Measurement *m = (Measurement*)v.data;
+    ck_assert(m->position.x == 1.5f);
+    ck_assert(m->position.y == -2.5f);
+    ck_assert_uint_eq(m->valuesSize, 3);
+    ck_assert(m->values[2] == 3.0);
+    UA_String label = UA_STRING("sensor");
+    ck_assert(UA_String_equal(&m->label, &label));
+
+    /* Write back with the generated type */
+    m->values[2] = 4.0;
+    res = UA_Client_writeValueAttribute(client, measurementVariable, &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&v);
+
+    UA_Variant sv;
+    res = UA_Server_readValue(server, measurementVariable, &sv);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&sv, &serverTypes[1]));
+    ck_assert(((Measurement*)sv.data)->values[2] == 4.0);
+    UA_Variant_clear(&sv);
+} END_TEST
+
+START_TEST(loadUnknownType) {
+    UA_NodeId id = UA_NODEID_NUMERIC(1, 9999);
+    UA_StatusCode res = UA_Client_loadDataTypes(client, 1, &id);
+    ck_assert_uint_ne(res, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(UA_Client_findDataType(client, &id), NULL);
+} END_TEST
+
+/* A custom type that the client knows at compile time */
+static UA_DataType clientTypes[1] = {
+    {UA_TYPENAME("ClientPoint") {1, UA_NODEIDTYPE_NUMERIC, {4003}},
+     {1, UA_NODEIDTYPE_NUMERIC, {4103}}, sizeof(Point),
+     UA_DATATYPEKIND_STRUCTURE, true, false, 2, Point_members}
+};
+
+static const UA_DataTypeArray clientCustomTypes = {NULL, 1, clientTypes};
+
+START_TEST(customTypesAddedLater) {
+    UA_StatusCode res = UA_Client_loadDataTypes(client, 1, &serverTypes[0].typeId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    const UA_DataType *pt = UA_Client_findDataType(client, &serverTypes[0].typeId);
+    ck_assert_ptr_ne(pt, NULL);
+    ck_assert_ptr_eq(UA_Client_findDataType(client, &clientTypes[0].typeId), NULL);
+
+    /* The custom types of the configuration are set after the generation */
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    cc->customDataTypes = &clientCustomTypes;
+    ck_assert_ptr_eq(UA_Client_findDataType(client, &clientTypes[0].typeId),
+                     &clientTypes[0]);
+    ck_assert_ptr_eq(UA_Client_findDataType(client, &serverTypes[0].typeId), pt);
+
+    /* Generate more types in front */
+    res = UA_Client_loadDataTypes(client, 1, &serverTypes[1].typeId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    const UA_DataType *mt = UA_Client_findDataType(client, &serverTypes[1].typeId);
+    ck_assert_ptr_ne(mt, NULL);
+    ck_assert_ptr_eq(mt->members[0].memberType, pt);
+    ck_assert_ptr_eq(UA_Client_findDataType(client, &clientTypes[0].typeId),
+                     &clientTypes[0]);
+
+    /* The custom types of the configuration are removed again */
+    cc->customDataTypes = NULL;
+    ck_assert_ptr_eq(UA_Client_findDataType(client, &clientTypes[0].typeId), NULL);
+    ck_assert_ptr_eq(UA_Client_findDataType(client, &serverTypes[0].typeId), pt);
+    ck_assert_ptr_eq(UA_Client_findDataType(client, &serverTypes[1].typeId), mt);
+} END_TEST
+
+static Suite *testSuite_Client_DataTypes(void) {
+    Suite *s = suite_create("Client DataTypes");
+    TCase *tc = tcase_create("Runtime DataTypes");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, readWithoutTypes);
+    tcase_add_test(tc, loadAndRead);
+    tcase_add_test(tc, loadUnknownType);
+    tcase_add_test(tc, customTypesAddedLater);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_Client_DataTypes();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -348,6 +348,214 @@ START_TEST(Node_Register) {
 END_TEST
 
 
+#ifdef UA_ENABLE_NODEMANAGEMENT
+START_TEST(Node_RegisterHandles) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_UInt32 maxRegisteredNodes = config->maxRegisteredNodesPerSession;
+    config->maxRegisteredNodesPerSession = 2;
+
+    UA_NodeId varId = UA_NODEID_STRING(1, "Plant.Area1.Line7.Cell3.Temperature");
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 value = 42;
+    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_StatusCode retval =
+        UA_Client_addVariableNode(client, varId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "Temperature"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_NodeId nodes[4];
+    nodes[0] = varId;
+    nodes[1] = UA_NODEID_STRING(1, "Plant.Unknown");
+    nodes[2] = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+    nodes[3] = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+
+    UA_RegisterNodesRequest req;
+    UA_RegisterNodesRequest_init(&req);
+    req.nodesToRegister = nodes;
+    req.nodesToRegisterSize = 4;
+    UA_RegisterNodesResponse res = UA_Client_Service_registerNodes(client, req);
+    ck_assert_uint_eq(res.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(res.registeredNodeIdsSize, 4);
+
+    /* Unknown nodes and nodes beyond the limit are returned unchanged */
+    UA_NodeId handle = res.registeredNodeIds[0];
+    ck_assert_uint_eq(handle.identifierType, UA_NODEIDTYPE_NUMERIC);
+    ck_assert(!UA_NodeId_equal(&handle, &varId));
+    ck_assert(UA_NodeId_equal(&res.registeredNodeIds[1], &nodes[1]));
+    ck_assert(!UA_NodeId_equal(&res.registeredNodeIds[2], &nodes[2]));
+    ck_assert(UA_NodeId_equal(&res.registeredNodeIds[3], &nodes[3]));
+
+    /* Read and write via the handle */
+    UA_Variant val;
+    retval = UA_Client_readValueAttribute(client, handle, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(*(UA_Int32*)val.data, 42);
+    UA_Variant_clear(&val);
+
+    value = 43;
+    UA_Variant_setScalar(&val, &value, &UA_TYPES[UA_TYPES_INT32]);
+    retval = UA_Client_writeValueAttribute(client, handle, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    retval = UA_Client_readValueAttribute(client, varId, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(*(UA_Int32*)val.data, 43);
+    UA_Variant_clear(&val);
+
+    /* The handle can be used in the other services */
+    UA_BrowseRequest bReq;
+    UA_BrowseRequest_init(&bReq);
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = handle;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASTYPEDEFINITION);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bReq.nodesToBrowse = &bd;
+    bReq.nodesToBrowseSize = 1;
+    UA_BrowseResponse bResp = UA_Client_Service_browse(client, bReq);
+    ck_assert_uint_eq(bResp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bResp.resultsSize, 1);
+    ck_assert_uint_eq(bResp.results[0].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bResp.results[0].referencesSize, 1);
+    UA_BrowseResponse_clear(&bResp);
+
+    /* The handle no longer resolves after the node was removed */
+    retval = UA_Client_deleteNode(client, varId, true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Client_readValueAttribute(client, handle, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    /* Unregister and reuse the slot */
+    UA_UnregisterNodesRequest reqUn;
+    UA_UnregisterNodesRequest_init(&reqUn);
+    reqUn.nodesToUnregister = res.registeredNodeIds;
+    reqUn.nodesToUnregisterSize = res.registeredNodeIdsSize;
+    UA_UnregisterNodesResponse resUn = UA_Client_Service_unregisterNodes(client, reqUn);
+    ck_assert_uint_eq(resUn.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UnregisterNodesResponse_clear(&resUn);
+
+    retval = UA_Client_readValueAttribute(client, res.registeredNodeIds[2], &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    UA_RegisterNodesResponse_clear(&res);
+    req.nodesToRegister = &nodes[3];
+    req.nodesToRegisterSize = 1;
+    res = UA_Client_Service_registerNodes(client, req);
+    ck_assert_uint_eq(res.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert(!UA_NodeId_equal(&res.registeredNodeIds[0], &nodes[3]));
+    retval = UA_Client_readValueAttribute(client, res.registeredNodeIds[0], &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&val, &UA_TYPES[UA_TYPES_DATETIME]));
+    UA_Variant_clear(&val);
+    UA_RegisterNodesResponse_clear(&res);
+
+    config->maxRegisteredNodesPerSession = maxRegisteredNodes;
+}
+END_TEST
+
+static UA_StatusCode
+browseSingleReference(const UA_NodeId nodeId, UA_BrowseDirection direction,
+                      UA_NodeId *target) {
+    UA_BrowseRequest bReq;
+    UA_BrowseRequest_init(&bReq);
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = nodeId;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    bd.browseDirection = direction;
+    bReq.nodesToBrowse = &bd;
+    bReq.nodesToBrowseSize = 1;
+    UA_BrowseResponse bResp = UA_Client_Service_browse(client, bReq);
+    UA_StatusCode retval = bResp.responseHeader.serviceResult;
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = bResp.results[0].statusCode;
+    if(retval == UA_STATUSCODE_GOOD && bResp.results[0].referencesSize != 1)
+        retval = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = UA_NodeId_copy(&bResp.results[0].references[0].nodeId.nodeId, target);
+    UA_BrowseResponse_clear(&bResp);
+    return retval;
+}
+
+START_TEST(Node_RegisterHandlesInReferences) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_UInt32 maxRegisteredNodes = config->maxRegisteredNodesPerSession;
+    config->maxRegisteredNodesPerSession = 8;
+
+    UA_NodeId folderId = UA_NODEID_STRING(1, "Plant.Area1");
+    UA_StatusCode retval =
+        UA_Client_addObjectNode(client, folderId,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, "Area1"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE),
+                                UA_ObjectAttributes_default, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_NodeId otherFolderId = UA_NODEID_STRING(1, "Plant.Area2");
+    retval = UA_Client_addObjectNode(client, otherFolderId,
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                     UA_QUALIFIEDNAME(1, "Area2"),
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE),
+                                     UA_ObjectAttributes_default, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_NodeId nodes[2] = {folderId, otherFolderId};
+    UA_RegisterNodesRequest req;
+    UA_RegisterNodesRequest_init(&req);
+    req.nodesToRegister = nodes;
+    req.nodesToRegisterSize = 2;
+    UA_RegisterNodesResponse res = UA_Client_Service_registerNodes(client, req);
+    ck_assert_uint_eq(res.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(res.registeredNodeIdsSize, 2);
+    ck_assert(!UA_NodeId_equal(&res.registeredNodeIds[0], &folderId));
+    ck_assert(!UA_NodeId_equal(&res.registeredNodeIds[1], &otherFolderId));
+
+    /* The handle as the parent of AddNodes */
+    UA_NodeId varId = UA_NODEID_STRING(1, "Plant.Area1.Temperature");
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    retval = UA_Client_addVariableNode(client, varId, res.registeredNodeIds[0],
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                       UA_QUALIFIEDNAME(1, "Temperature"),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                       attr, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The handle as the target of AddReferences */
+    UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NULL;
+    target.nodeId = res.registeredNodeIds[1];
+    retval = UA_Client_addReference(client, varId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                    true, UA_STRING_NULL, target,
+                                    UA_NODECLASS_OBJECT);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The handles are gone with the session. The references remain. */
+    UA_RegisterNodesResponse_clear(&res);
+    UA_Client_disconnect(client);
+    retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_NodeId browsed;
+    retval = browseSingleReference(varId, UA_BROWSEDIRECTION_INVERSE, &browsed);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_NodeId_equal(&browsed, &folderId));
+    UA_NodeId_clear(&browsed);
+
+    retval = browseSingleReference(varId, UA_BROWSEDIRECTION_FORWARD, &browsed);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_NodeId_equal(&browsed, &otherFolderId));
+    UA_NodeId_clear(&browsed);
+
+    config->maxRegisteredNodesPerSession = maxRegisteredNodes;
+}
+END_TEST
+#endif
 
 // NodeIds for ReadWrite testing
 UA_NodeId nodeReadWriteUnitTest;
@@ -1045,6 +1253,10 @@ static Suite *testSuite_Client(void) {
 #endif
     tcase_add_test(tc_nodes, Node_Browse);
     tcase_add_test(tc_nodes, Node_Register);
+#ifdef UA_ENABLE_NODEMANAGEMENT
+    tcase_add_test(tc_nodes, Node_RegisterHandles);
+    tcase_add_test(tc_nodes, Node_RegisterHandlesInReferences);
+#endif
     suite_add_tcase(s, tc_nodes);
 
 #ifdef UA_ENABLE_NODEMANAGEMENT
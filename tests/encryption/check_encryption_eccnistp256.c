@@ -0,0 +1,370 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* SecurityPolicy#ECC_nistP256. The key derivation has to be symmetric between
+ * client and server. The handshake speed is compared with Aes128Sha256RsaOaep on
+ * RSA-2048 and RSA-4096 certificates. */
+
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/plugin/create_certificate.h>
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/plugin/securitypolicy_default.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "client/ua_client_internal.h"
+
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+#include <stdio.h>
+#include <time.h>
+
+#include "check.h"
+#include "testing_clock.h"
+#include "thread_wrapper.h"
+
+#define ECC_URI "http://opcfoundation.org/UA/SecurityPolicy#ECC_nistP256"
+#define HANDSHAKES 20
+
+UA_Server *server;
+UA_Boolean running;
+THREAD_HANDLE server_thread;
+
+static UA_ByteString eccCertificate;
+static UA_ByteString eccPrivateKey;
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+/* Self-signed P-256 certificate */
+static void
+createEccCertificate(UA_ByteString *certificate, UA_ByteString *privateKey) {
+    EC_KEY *ecKey = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1);
+    ck_assert_ptr_ne(ecKey, NULL);
+    ck_assert_int_eq(EC_KEY_generate_key(ecKey), 1);
+    EVP_PKEY *pkey = EVP_PKEY_new();
+    EVP_PKEY_assign_EC_KEY(pkey, ecKey);
+
+    X509 *x509 = X509_new();
+    X509_set_version(x509, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(x509), 1);
+    X509_gmtime_adj(X509_get_notBefore(x509), 0);
+    X509_gmtime_adj(X509_get_notAfter(x509), 3600L * 24);
+    X509_set_pubkey(x509, pkey);
+    X509_NAME *name = X509_get_subject_name(x509);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                               (const unsigned char *)"open62541 ECC", -1, -1, 0);
+    X509_set_issuer_name(x509, name);
+    X509_EXTENSION *ext =
+        X509V3_EXT_conf_nid(NULL, NULL, NID_subject_alt_name,
+                            "URI:urn:open62541.unconfigured.application");
+    X509_add_ext(x509, ext, -1);
+    X509_EXTENSION_free(ext);
+    ck_assert_int_ne(X509_sign(x509, pkey, EVP_sha256()), 0);
+
+    unsigned char *der = NULL;
+    int len = i2d_X509(x509, &der);
+    ck_assert_int_gt(len, 0);
+    UA_ByteString tmp = {(size_t)len, der};
+    UA_ByteString_copy(&tmp, certificate);
+    OPENSSL_free(der);
+
+    der = NULL;
+    len = i2d_PrivateKey(pkey, &der);
+    ck_assert_int_gt(len, 0);
+    tmp.length = (size_t)len;
+    tmp.data = der;
+    UA_ByteString_copy(&tmp, privateKey);
+    OPENSSL_free(der);
+
+    X509_free(x509);
+    EVP_PKEY_free(pkey);
+}
+
+static void
+createRsaCertificate(size_t keySizeBits, UA_ByteString *certificate,
+                     UA_ByteString *privateKey) {
+    UA_String subject[2] = {UA_STRING_STATIC("C=DE"),
+                            UA_STRING_STATIC("CN=open62541 RSA")};
+    UA_String subjectAltName[1] =
+        {UA_STRING_STATIC("URI:urn:open62541.unconfigured.application")};
+    UA_StatusCode res =
+        UA_CreateCertificate(UA_Log_Stdout, subject, 2, subjectAltName, 1,
+                             keySizeBits, UA_CERTIFICATEFORMAT_DER,
+                             privateKey, certificate);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void setupCertificates(void) {
+    createEccCertificate(&eccCertificate, &eccPrivateKey);
+}
+
+static void teardownCertificates(void) {
+    UA_ByteString_clear(&eccCertificate);
+    UA_ByteString_clear(&eccPrivateKey);
+}
+
+static void
+startServer(const UA_String policyUri, const UA_ByteString *certificate,
+            const UA_ByteString *privateKey) {
+    running = true;
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setDefault(config);
+    config->logger = UA_Log_Stdout_withLevel(UA_LOGLEVEL_ERROR);
+    UA_String_clear(&config->applicationDescription.applicationUri);
+    config->applicationDescription.applicationUri =
+        UA_STRING_ALLOC("urn:open62541.unconfigured.application");
+
+    UA_StatusCode res;
+    const UA_String eccUri = UA_STRING(ECC_URI);
+    if(UA_String_equal(&policyUri, &eccUri))
+        res = UA_ServerConfig_addSecurityPolicyEccNistP256(config, certificate, privateKey);
+    else
+        res = UA_ServerConfig_addSecurityPolicyAes128Sha256RsaOaep(config, certificate,
+                                                                   privateKey);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_ServerConfig_addEndpoint(config, policyUri,
+                                      UA_MESSAGESECURITYMODE_SIGNANDENCRYPT);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static void stopServer(void) {
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static UA_Client *
+newClient(const UA_String policyUri, const UA_ByteString *certificate,
+          const UA_ByteString *privateKey) {
+    UA_Client *client = UA_Client_new();
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    const UA_String eccUri = UA_STRING(ECC_URI);
+    if(UA_String_equal(&policyUri, &eccUri)) {
+        UA_ClientConfig_setDefault(cc);
+        UA_SecurityPolicy *sp = (UA_SecurityPolicy*)
+            UA_realloc(cc->securityPolicies,
+                       sizeof(UA_SecurityPolicy) * (cc->securityPoliciesSize + 1));
+        ck_assert_ptr_ne(sp, NULL);
+        cc->securityPolicies = sp;
+        UA_StatusCode res =
+            UA_SecurityPolicy_EccNistP256(&sp[cc->securityPoliciesSize],
+                                          UA_APPLICATIONTYPE_CLIENT, *certificate,
+                                          *privateKey, &cc->logger);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        cc->securityPoliciesSize++;
+    } else {
+        UA_ClientConfig_setDefaultEncryption(cc, *certificate, *privateKey,
+                                             NULL, 0, NULL, 0);
+    }
+    cc->logger = UA_Log_Stdout_withLevel(UA_LOGLEVEL_ERROR);
+    UA_String_clear(&cc->clientDescription.applicationUri);
+    cc->clientDescription.applicationUri =
+        UA_STRING_ALLOC("urn:open62541.unconfigured.application");
+    UA_String_copy(&policyUri, &cc->securityPolicyUri);
+    cc->securityMode = UA_MESSAGESECURITYMODE_SIGNANDENCRYPT;
+    return client;
+}
+
+START_TEST(ecc_deriveKeys) {
+    UA_SecurityPolicy clientPolicy, serverPolicy;
+    UA_StatusCode res =
+        UA_SecurityPolicy_EccNistP256(&clientPolicy, UA_APPLICATIONTYPE_CLIENT,
+                                      eccCertificate, eccPrivateKey, UA_Log_Stdout);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_SecurityPolicy_EccNistP256(&serverPolicy, UA_APPLICATIONTYPE_SERVER,
+                                        eccCertificate, eccPrivateKey, UA_Log_Stdout);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    void *clientContext, *serverContext;
+    res = clientPolicy.channelModule.newContext(&clientPolicy, &eccCertificate,
+                                                &clientContext);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = serverPolicy.channelModule.newContext(&serverPolicy, &eccCertificate,
+                                                &serverContext);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Exchange the ephemeral public keys */
+    UA_Byte cn[64], sn[64];
+    UA_ByteString clientNonce = {64, cn};
+    UA_ByteString serverNonce = {64, sn};
+    res = clientPolicy.channelModule.generateNonce(clientContext, &clientNonce);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = serverPolicy.channelModule.generateNonce(serverContext, &serverNonce);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* The client keys as derived on both sides (see generateLocalKeys and
+     * generateRemoteKeys in the SecureChannel) */
+    UA_Byte a[64], b[64], c[64], d[64];
+    UA_ByteString clientLocal = {64, a}, serverRemote = {64, b};
+    UA_ByteString serverLocal = {64, c}, clientRemote = {64, d};
+    res = clientPolicy.channelModule.generateKey(clientContext, &serverNonce,
+                                                 &clientNonce, &clientLocal);
+    res |= serverPolicy.channelModule.generateKey(serverContext, &serverNonce,
+                                                  &clientNonce, &serverRemote);
+    res |= serverPolicy.channelModule.generateKey(serverContext, &clientNonce,
+                                                  &serverNonce, &serverLocal);
+    res |= clientPolicy.channelModule.generateKey(clientContext, &clientNonce,
+                                                  &serverNonce, &clientRemote);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_ByteString_equal(&clientLocal, &serverRemote));
+    ck_assert(UA_ByteString_equal(&serverLocal, &clientRemote));
+    ck_assert(!UA_ByteString_equal(&clientLocal, &serverLocal));
+
+    /* A point that is not on the curve is rejected */
+    UA_Byte bad[64];
+    memset(bad, 1, sizeof(bad));
+    UA_ByteString badNonce = {64, bad};
+    res = clientPolicy.channelModule.generateKey(clientContext, &badNonce,
+                                                 &clientNonce, &clientLocal);
+    ck_assert_uint_ne(res, UA_STATUSCODE_GOOD);
+
+    clientPolicy.channelModule.deleteContext(clientContext);
+    serverPolicy.channelModule.deleteContext(serverContext);
+    clientPolicy.clear(&clientPolicy);
+    serverPolicy.clear(&serverPolicy);
+} END_TEST
+
+START_TEST(ecc_signature) {
+    UA_SecurityPolicy policy;
+    UA_StatusCode res =
+        UA_SecurityPolicy_EccNistP256(&policy, UA_APPLICATIONTYPE_SERVER,
+                                      eccCertificate, eccPrivateKey, UA_Log_Stdout);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    void *context;
+    res = policy.channelModule.newContext(&policy, &eccCertificate, &context);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    const UA_SecurityPolicySignatureAlgorithm *sig =
+        &policy.asymmetricModule.cryptoModule.signatureAlgorithm;
+    UA_ByteString message = UA_BYTESTRING("open62541");
+    UA_Byte s[64];
+    UA_ByteString signature = {sig->getLocalSignatureSize(context), s};
+    ck_assert_uint_eq(signature.length, 64);
+    res = sig->sign(context, &message, &signature);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = sig->verify(context, &message, &signature);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    s[10] ^= 1;
+    res = sig->verify(context, &message, &signature);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADSECURITYCHECKSFAILED);
+    signature.length--;
+    res = sig->verify(context, &message, &signature);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADSECURITYCHECKSFAILED);
+
+    /* No asymmetric encryption */
+    ck_assert(policy.asymmetricModule.cryptoModule.encryptionAlgorithm.encrypt == NULL);
+
+    policy.channelModule.deleteContext(context);
+    policy.clear(&policy);
+} END_TEST
+
+START_TEST(ecc_connect) {
+    const UA_String eccUri = UA_STRING(ECC_URI);
+    startServer(eccUri, &eccCertificate, &eccPrivateKey);
+    UA_Client *client = newClient(eccUri, &eccCertificate, &eccPrivateKey);
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_String_equal(&client->channel.securityPolicy->policyUri, &eccUri));
+
+    UA_Variant val;
+    UA_NodeId nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+    res = UA_Client_readValueAttribute(client, nodeId, &val);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&val);
+
+    /* Renew the SecureChannel. The keys are derived from new ephemeral keys. */
+    UA_UInt32 tokenId = client->channel.securityToken.tokenId;
+    UA_fakeSleep((UA_UInt32)(client->channel.securityToken.revisedLifetime * 0.8));
+    UA_Client_run_iterate(client, 1);
+    res = UA_Client_readValueAttribute(client, nodeId, &val);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&val);
+    ck_assert_uint_ne(tokenId, client->channel.securityToken.tokenId);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    stopServer();
+} END_TEST
+
+static void
+benchHandshake(const char *name, const UA_String policyUri,
+               const UA_ByteString *certificate, const UA_ByteString *privateKey) {
+    startServer(policyUri, certificate, privateKey);
+    UA_Client *client = newClient(policyUri, certificate, privateKey);
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for(size_t i = 0; i < HANDSHAKES; i++) {
+        UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        UA_Client_disconnect(client);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double s = (double)(end.tv_sec - begin.tv_sec) +
+        (double)(end.tv_nsec - begin.tv_nsec) / 1e9;
+    printf("%-30s %8.2f ms per connect, %8.1f connects/s\n", name,
+           s * 1000.0 / HANDSHAKES, HANDSHAKES / s);
+
+    UA_Client_delete(client);
+    stopServer();
+}
+
+START_TEST(handshakeSpeed) {
+    UA_ByteString cert2048, key2048, cert4096, key4096;
+    createRsaCertificate(2048, &cert2048, &key2048);
+    createRsaCertificate(4096, &cert4096, &key4096);
+
+    const UA_String rsaUri =
+        UA_STRING("http://opcfoundation.org/UA/SecurityPolicy#Aes128_Sha256_RsaOaep");
+    benchHandshake("ECC_nistP256", UA_STRING(ECC_URI), &eccCertificate, &eccPrivateKey);
+    benchHandshake("Aes128Sha256RsaOaep RSA-2048", rsaUri, &cert2048, &key2048);
+    benchHandshake("Aes128Sha256RsaOaep RSA-4096", rsaUri, &cert4096, &key4096);
+
+    UA_ByteString_clear(&cert2048);
+    UA_ByteString_clear(&key2048);
+    UA_ByteString_clear(&cert4096);
+    UA_ByteString_clear(&key4096);
+} END_TEST
+
+static Suite *testSuite_encryption_eccnistp256(void) {
+    Suite *s = suite_create("Encryption ECC_nistP256");
+    TCase *tc = tcase_create("ECC_nistP256");
+    tcase_add_unchecked_fixture(tc, setupCertificates, teardownCertificates);
+    tcase_add_test(tc, ecc_deriveKeys);
+    tcase_add_test(tc, ecc_signature);
+    tcase_add_test(tc, ecc_connect);
+    suite_add_tcase(s, tc);
+
+    TCase *tc_speed = tcase_create("Handshake Speed");
+    tcase_add_unchecked_fixture(tc_speed, setupCertificates, teardownCertificates);
+    tcase_set_timeout(tc_speed, 0);
+    tcase_add_test(tc_speed, handshakeSpeed);
+    suite_add_tcase(s, tc_speed);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_encryption_eccnistp256();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
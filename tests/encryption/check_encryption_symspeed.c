@@ -0,0 +1,264 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* Symmetric sign+encrypt of SecureChannel chunks with the SecurityPolicies.
+ * Known-answer tests check the HMAC (RFC 2202 / RFC 4231) and AES-CBC (NIST
+ * SP 800-38A) results before the throughput is measured. */
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/plugin/securitypolicy_default.h>
+
+#include "certificates.h"
+#include "check.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define CHUNK_SIZE 8192
+#define RUNS 20000
+
+typedef UA_StatusCode
+(*PolicyConstructor)(UA_SecurityPolicy *policy,
+                     const UA_ByteString localCertificate,
+                     const UA_ByteString localPrivateKey,
+                     const UA_Logger *logger);
+
+typedef struct {
+    const char *name;
+    PolicyConstructor constructor;
+    const char *hmacJefe; /* HMAC of "what do ya want for nothing?" */
+    const char *aesKey;
+    const char *aesCipherText; /* First block of the NIST CBC example */
+} PolicyTest;
+
+static const PolicyTest policies[4] = {
+    {"Basic128Rsa15", UA_SecurityPolicy_Basic128Rsa15,
+     "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79",
+     "2b7e151628aed2a6abf7158809cf4f3c", "7649abac8119b246cee98e9b12e9197d"},
+    {"Basic256", UA_SecurityPolicy_Basic256,
+     "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79",
+     "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+     "f58c4c04d6e5f1ba779eabfb5f7bfbd6"},
+    {"Basic256Sha256", UA_SecurityPolicy_Basic256Sha256,
+     "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843",
+     "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+     "f58c4c04d6e5f1ba779eabfb5f7bfbd6"},
+    {"Aes128Sha256RsaOaep", UA_SecurityPolicy_Aes128Sha256RsaOaep,
+     "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843",
+     "2b7e151628aed2a6abf7158809cf4f3c", "7649abac8119b246cee98e9b12e9197d"}
+};
+
+static UA_SecurityPolicy policy;
+static void *channelContext;
+
+/* Decode a hex string into a stack buffer */
+static UA_ByteString
+fromHex(const char *hex, UA_Byte *buf) {
+    UA_ByteString out = {strlen(hex) / 2, buf};
+    for(size_t i = 0; i < out.length; i++) {
+        unsigned int b;
+        sscanf(&hex[2 * i], "%2x", &b);
+        buf[i] = (UA_Byte)b;
+    }
+    return out;
+}
+
+static void
+setupPolicy(const PolicyTest *pt) {
+    UA_ByteString certificate = {CERT_DER_LENGTH, CERT_DER_DATA};
+    UA_ByteString privateKey = {KEY_DER_LENGTH, KEY_DER_DATA};
+    UA_StatusCode res = pt->constructor(&policy, certificate, privateKey,
+                                        UA_Log_Stdout);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = policy.channelModule.newContext(&policy, &certificate, &channelContext);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void
+teardownPolicy(void) {
+    policy.channelModule.deleteContext(channelContext);
+    policy.clear(&policy);
+}
+
+/* Set the same keys for both directions. So the decryption and verification of
+ * the own chunks can be tested. */
+static void
+setKeys(const UA_ByteString *signingKey, const UA_ByteString *encryptingKey,
+        const UA_ByteString *iv) {
+    const UA_SecurityPolicyChannelModule *cm = &policy.channelModule;
+    ck_assert_uint_eq(cm->setLocalSymSigningKey(channelContext, signingKey),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(cm->setRemoteSymSigningKey(channelContext, signingKey),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(cm->setLocalSymEncryptingKey(channelContext, encryptingKey),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(cm->setRemoteSymEncryptingKey(channelContext, encryptingKey),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(cm->setLocalSymIv(channelContext, iv), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(cm->setRemoteSymIv(channelContext, iv), UA_STATUSCODE_GOOD);
+}
+
+static void
+setRandomKeys(void) {
+    const UA_SecurityPolicyCryptoModule *cm = &policy.symmetricModule.cryptoModule;
+    UA_Byte sk[64], ek[32], ivBuf[16];
+    UA_ByteString signingKey = {cm->signatureAlgorithm.getLocalKeyLength(channelContext), sk};
+    UA_ByteString encryptingKey =
+        {cm->encryptionAlgorithm.getLocalKeyLength(channelContext), ek};
+    UA_ByteString iv = {cm->encryptionAlgorithm.getRemoteBlockSize(channelContext), ivBuf};
+    ck_assert_uint_le(signingKey.length, sizeof(sk));
+    ck_assert_uint_le(encryptingKey.length, sizeof(ek));
+    ck_assert_uint_le(iv.length, sizeof(ivBuf));
+    for(size_t i = 0; i < sizeof(sk); i++)
+        sk[i] = (UA_Byte)(i * 7 + 1);
+    for(size_t i = 0; i < sizeof(ek); i++)
+        ek[i] = (UA_Byte)(i * 13 + 5);
+    for(size_t i = 0; i < sizeof(ivBuf); i++)
+        ivBuf[i] = (UA_Byte)(i * 3);
+    setKeys(&signingKey, &encryptingKey, &iv);
+}
+
+START_TEST(knownAnswers) {
+    const PolicyTest *pt = &policies[_i];
+    setupPolicy(pt);
+    const UA_SecurityPolicyCryptoModule *cm = &policy.symmetricModule.cryptoModule;
+
+    UA_Byte keyBuf[32], ivBuf[16], expectedBuf[32], sigBuf[32];
+    UA_ByteString hmacKey = UA_BYTESTRING("Jefe");
+    UA_ByteString aesKey = fromHex(pt->aesKey, keyBuf);
+    UA_ByteString iv = fromHex("000102030405060708090a0b0c0d0e0f", ivBuf);
+    setKeys(&hmacKey, &aesKey, &iv);
+
+    /* HMAC */
+    UA_ByteString msg = UA_BYTESTRING("what do ya want for nothing?");
+    UA_ByteString expected = fromHex(pt->hmacJefe, expectedBuf);
+    UA_ByteString sig = {cm->signatureAlgorithm.getLocalSignatureSize(channelContext),
+                         sigBuf};
+    ck_assert_uint_eq(sig.length, expected.length);
+    UA_StatusCode res = cm->signatureAlgorithm.sign(channelContext, &msg, &sig);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_ByteString_equal(&sig, &expected));
+    res = cm->signatureAlgorithm.verify(channelContext, &msg, &sig);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    sig.data[0] ^= 1;
+    res = cm->signatureAlgorithm.verify(channelContext, &msg, &sig);
+    ck_assert_uint_ne(res, UA_STATUSCODE_GOOD);
+
+    /* AES-CBC. Encrypt twice to test that the IV is reset for every chunk. */
+    UA_Byte blockBuf[16];
+    for(size_t i = 0; i < 2; i++) {
+        UA_ByteString block = fromHex("6bc1bee22e409f96e93d7e117393172a", blockBuf);
+        res = cm->encryptionAlgorithm.encrypt(channelContext, &block);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        expected = fromHex(pt->aesCipherText, expectedBuf);
+        ck_assert_uint_eq(block.length, expected.length);
+        ck_assert(UA_ByteString_equal(&block, &expected));
+        res = cm->encryptionAlgorithm.decrypt(channelContext, &block);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        expected = fromHex("6bc1bee22e409f96e93d7e117393172a", expectedBuf);
+        ck_assert(UA_ByteString_equal(&block, &expected));
+    }
+
+    teardownPolicy();
+} END_TEST
+
+START_TEST(renewKeys) {
+    const PolicyTest *pt = &policies[_i];
+    setupPolicy(pt);
+    const UA_SecurityPolicyCryptoModule *cm = &policy.symmetricModule.cryptoModule;
+
+    /* Encrypt with the random keys */
+    setRandomKeys();
+    UA_Byte blockBuf[16];
+    UA_ByteString block = {16, blockBuf};
+    memset(blockBuf, 0, 16);
+    UA_StatusCode res = cm->encryptionAlgorithm.encrypt(channelContext, &block);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Replace the keys (token renewal). The results change accordingly. */
+    UA_Byte keyBuf[32], ivBuf[16], expectedBuf[32], sigBuf[32];
+    UA_ByteString hmacKey = UA_BYTESTRING("Jefe");
+    UA_ByteString aesKey = fromHex(pt->aesKey, keyBuf);
+    UA_ByteString iv = fromHex("000102030405060708090a0b0c0d0e0f", ivBuf);
+    setKeys(&hmacKey, &aesKey, &iv);
+
+    block = fromHex("6bc1bee22e409f96e93d7e117393172a", blockBuf);
+    res = cm->encryptionAlgorithm.encrypt(channelContext, &block);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ByteString expected = fromHex(pt->aesCipherText, expectedBuf);
+    ck_assert(UA_ByteString_equal(&block, &expected));
+
+    UA_ByteString msg = UA_BYTESTRING("what do ya want for nothing?");
+    UA_ByteString sig = {cm->signatureAlgorithm.getLocalSignatureSize(channelContext),
+                         sigBuf};
+    res = cm->signatureAlgorithm.sign(channelContext, &msg, &sig);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    expected = fromHex(pt->hmacJefe, expectedBuf);
+    ck_assert(UA_ByteString_equal(&sig, &expected));
+
+    teardownPolicy();
+} END_TEST
+
+START_TEST(signEncryptChunks) {
+    const PolicyTest *pt = &policies[_i];
+    setupPolicy(pt);
+    setRandomKeys();
+    const UA_SecurityPolicyCryptoModule *cm = &policy.symmetricModule.cryptoModule;
+    size_t sigSize = cm->signatureAlgorithm.getLocalSignatureSize(channelContext);
+
+    /* The signature is appended to the chunk. Then the chunk is encrypted. */
+    UA_Byte *chunk = (UA_Byte*)UA_malloc(CHUNK_SIZE);
+    ck_assert_ptr_ne(chunk, NULL);
+    for(size_t i = 0; i < CHUNK_SIZE; i++)
+        chunk[i] = (UA_Byte)i;
+    UA_ByteString body = {CHUNK_SIZE - sigSize, chunk};
+    UA_ByteString sig = {sigSize, &chunk[CHUNK_SIZE - sigSize]};
+    UA_ByteString all = {CHUNK_SIZE, chunk};
+
+    clock_t begin = clock();
+    for(size_t i = 0; i < RUNS; i++) {
+        UA_StatusCode res = cm->signatureAlgorithm.sign(channelContext, &body, &sig);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        res = cm->encryptionAlgorithm.encrypt(channelContext, &all);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        all.length = CHUNK_SIZE;
+    }
+    double elapsed = (double)(clock() - begin) / CLOCKS_PER_SEC;
+    printf("%-20s sign+encrypt %d byte chunks: %7.2f us/chunk, %7.1f MB/s\n",
+           pt->name, CHUNK_SIZE, elapsed * 1e6 / RUNS,
+           (double)CHUNK_SIZE * RUNS / 1e6 / elapsed);
+
+    /* Decrypt and verify the last chunk */
+    UA_StatusCode res = cm->encryptionAlgorithm.decrypt(channelContext, &all);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(all.length, CHUNK_SIZE);
+    res = cm->signatureAlgorithm.verify(channelContext, &body, &sig);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_free(chunk);
+    teardownPolicy();
+} END_TEST
+
+static Suite *testSuite_symSpeed(void) {
+    Suite *s = suite_create("Symmetric Crypto Speed");
+    TCase *tc_kat = tcase_create("Known Answers");
+    tcase_add_loop_test(tc_kat, knownAnswers, 0, 4);
+    tcase_add_loop_test(tc_kat, renewKeys, 0, 4);
+    suite_add_tcase(s, tc_kat);
+    TCase *tc_speed = tcase_create("Sign and Encrypt");
+    tcase_set_timeout(tc_speed, 0);
+    tcase_add_loop_test(tc_speed, signEncryptChunks, 0, 4);
+    suite_add_tcase(s, tc_speed);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_symSpeed();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
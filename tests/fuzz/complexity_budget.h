@@ -0,0 +1,111 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef OPEN62541_COMPLEXITY_BUDGET_H
+#define OPEN62541_COMPLEXITY_BUDGET_H
+
+/**
+ * Cost budget for the algorithmic-complexity fuzzers.
+ *
+ * The regular fuzzers only find crashes and leaks. The complexity fuzzers
+ * additionally measure the CPU time and the allocated memory for processing an
+ * input. Inputs that are cheap to send but expensive to process (deep nesting,
+ * large array lengths, browse-path explosions, ...) exceed a budget that grows
+ * linearly with the input size. The fuzzer then aborts, so that the input is
+ * stored as a crash artifact and can be added to the regression corpus.
+ *
+ * The budget is configured with environment variables:
+ *
+ * - UA_FUZZ_CPU_BASE_US: Constant CPU budget (default 20000)
+ * - UA_FUZZ_CPU_US_PER_BYTE: CPU budget per input byte (default 50)
+ * - UA_FUZZ_MEM_BASE: Constant budget for the peak memory (default 4MB)
+ * - UA_FUZZ_MEM_PER_BYTE: Peak memory budget per input byte (default 512)
+ * - UA_FUZZ_REPORT: If set, print the cost of every input to stderr
+ *
+ * The defaults are generous enough for sanitizer builds. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "custom_memory_manager.h"
+
+typedef struct {
+    unsigned long long cpuBaseUs;
+    unsigned long long cpuUsPerByte;
+    unsigned long long memBase;
+    unsigned long long memPerByte;
+    int report;
+    int initialized;
+
+    /* Measurement of the current input */
+    struct timespec start;
+} UA_ComplexityBudget;
+
+static UA_ComplexityBudget complexityBudget;
+
+static unsigned long long
+UA_ComplexityBudget_env(const char *name, unsigned long long defaultValue) {
+    const char *value = getenv(name);
+    if(!value || !*value)
+        return defaultValue;
+    return strtoull(value, NULL, 10);
+}
+
+static void
+UA_ComplexityBudget_init(void) {
+    if(complexityBudget.initialized)
+        return;
+    complexityBudget.cpuBaseUs = UA_ComplexityBudget_env("UA_FUZZ_CPU_BASE_US", 20000);
+    complexityBudget.cpuUsPerByte = UA_ComplexityBudget_env("UA_FUZZ_CPU_US_PER_BYTE", 50);
+    complexityBudget.memBase = UA_ComplexityBudget_env("UA_FUZZ_MEM_BASE", 4 * 1024 * 1024);
+    complexityBudget.memPerByte = UA_ComplexityBudget_env("UA_FUZZ_MEM_PER_BYTE", 512);
+    complexityBudget.report = (getenv("UA_FUZZ_REPORT") != NULL);
+    complexityBudget.initialized = 1;
+    UA_memoryManager_setCounting();
+}
+
+/* Start measuring. Only the processing between _start and _check is
+ * accounted. Setup costs (e.g. creating a server) are excluded. */
+static void
+UA_ComplexityBudget_start(void) {
+    UA_ComplexityBudget_init();
+    UA_memoryManager_resetStatistics();
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &complexityBudget.start);
+}
+
+/* Stop measuring and abort if the input exceeds the budget */
+static void
+UA_ComplexityBudget_check(const char *what, size_t inputSize) {
+    struct timespec end;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+    long long cpuNs = (long long)(end.tv_sec - complexityBudget.start.tv_sec) * 1000000000LL +
+        (long long)(end.tv_nsec - complexityBudget.start.tv_nsec);
+    unsigned long long cpuUs = (cpuNs > 0) ? (unsigned long long)cpuNs / 1000 : 0;
+
+    unsigned long long allocated, peak, allocations;
+    UA_memoryManager_getStatistics(&allocated, &peak, &allocations);
+
+    unsigned long long cpuBudget = complexityBudget.cpuBaseUs +
+        complexityBudget.cpuUsPerByte * (unsigned long long)inputSize;
+    unsigned long long memBudget = complexityBudget.memBase +
+        complexityBudget.memPerByte * (unsigned long long)inputSize;
+
+    if(complexityBudget.report)
+        fprintf(stderr, "%s: input %lu bytes, cpu %llu us, allocated %llu bytes "
+                "in %llu calls, peak %llu bytes\n", what, (unsigned long)inputSize,
+                cpuUs, allocated, allocations, peak);
+
+    if(cpuUs <= cpuBudget && peak <= memBudget)
+        return;
+
+    fprintf(stderr, "==COMPLEXITY== %s exceeds the budget: input %lu bytes, "
+            "cpu %llu us (budget %llu us), peak memory %llu bytes (budget %llu bytes), "
+            "allocated %llu bytes in %llu calls\n", what, (unsigned long)inputSize,
+            cpuUs, cpuBudget, peak, memBudget, allocated, allocations);
+    abort();
+}
+
+#endif /* OPEN62541_COMPLEXITY_BUDGET_H */
@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <limits.h>
+#include <string.h>
 
 #include <pthread.h>
 
@@ -33,6 +34,18 @@ struct UA_mm_entry {
 unsigned long long totalMemorySize = 0;
 unsigned long long memoryLimit = ULONG_MAX;
 
+/* Statistics since the last reset */
+unsigned long long allocatedBytes = 0;
+unsigned long long peakMemorySize = 0;
+unsigned long long allocationCount = 0;
+
+static void countAllocation(size_t size) {
+    allocatedBytes += size;
+    allocationCount++;
+    if(totalMemorySize > peakMemorySize)
+        peakMemorySize = totalMemorySize;
+}
+
 /* Head and Tail of the double linked list */
 struct UA_mm_entry *address_map_first = NULL;
 struct UA_mm_entry *address_map_last = NULL;
@@ -59,6 +72,7 @@ static int addToMap(size_t size, void *addr) {
         address_map_last->next = newEntry;
     address_map_last = newEntry;
     totalMemorySize += size;
+    countAllocation(size);
     if(address_map_first == NULL)
         address_map_first = newEntry;
     pthread_mutex_unlock(&mutex);
@@ -168,3 +182,78 @@ int UA_memoryManager_setLimitFromLast4Bytes(const uint8_t *data, size_t size) {
     memoryLimit = limit;
     return 1;
 }
+
+/**
+ * The counting memory manager stores the size in front of the allocated
+ * block. The header is padded to keep the alignment of malloc.
+ */
+#define UA_MM_HEADER_SIZE 16
+
+static void *UA_memoryManager_countingMalloc(size_t size) {
+    if(size > SIZE_MAX - UA_MM_HEADER_SIZE)
+        return NULL;
+    uint8_t *block = (uint8_t*)malloc(size + UA_MM_HEADER_SIZE);
+    if(!block)
+        return NULL;
+    memcpy(block, &size, sizeof(size_t));
+    totalMemorySize += size;
+    countAllocation(size);
+    return block + UA_MM_HEADER_SIZE;
+}
+
+static void *UA_memoryManager_countingCalloc(size_t num, size_t size) {
+    if(size > 0 && num > (SIZE_MAX - UA_MM_HEADER_SIZE) / size)
+        return NULL;
+    void *addr = UA_memoryManager_countingMalloc(num * size);
+    if(addr)
+        memset(addr, 0, num * size);
+    return addr;
+}
+
+static void UA_memoryManager_countingFree(void *ptr) {
+    if(!ptr)
+        return;
+    uint8_t *block = (uint8_t*)ptr - UA_MM_HEADER_SIZE;
+    size_t size;
+    memcpy(&size, block, sizeof(size_t));
+    totalMemorySize -= size;
+    free(block);
+}
+
+static void *UA_memoryManager_countingRealloc(void *ptr, size_t new_size) {
+    if(!ptr)
+        return UA_memoryManager_countingMalloc(new_size);
+    if(new_size > SIZE_MAX - UA_MM_HEADER_SIZE)
+        return NULL;
+    uint8_t *block = (uint8_t*)ptr - UA_MM_HEADER_SIZE;
+    size_t size;
+    memcpy(&size, block, sizeof(size_t));
+    block = (uint8_t*)realloc(block, new_size + UA_MM_HEADER_SIZE);
+    if(!block)
+        return NULL;
+    memcpy(block, &new_size, sizeof(size_t));
+    totalMemorySize = totalMemorySize - size + new_size;
+    countAllocation(new_size);
+    return block + UA_MM_HEADER_SIZE;
+}
+
+void UA_memoryManager_setCounting(void) {
+    UA_mallocSingleton = UA_memoryManager_countingMalloc;
+    UA_freeSingleton = UA_memoryManager_countingFree;
+    UA_callocSingleton = UA_memoryManager_countingCalloc;
+    UA_reallocSingleton = UA_memoryManager_countingRealloc;
+}
+
+void UA_memoryManager_resetStatistics(void) {
+    allocatedBytes = 0;
+    allocationCount = 0;
+    peakMemorySize = totalMemorySize;
+}
+
+void UA_memoryManager_getStatistics(unsigned long long *allocated,
+                                    unsigned long long *peak,
+                                    unsigned long long *allocations) {
+    *allocated = allocatedBytes;
+    *peak = peakMemorySize;
+    *allocations = allocationCount;
+}
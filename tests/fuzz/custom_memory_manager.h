@@ -31,6 +31,30 @@ void UA_EXPORT UA_memoryManager_setLimit(unsigned long long maxMemory);
  */
 int UA_EXPORT UA_memoryManager_setLimitFromLast4Bytes(const uint8_t *data, size_t size);
 
+/**
+ * Use a counting memory manager without limit. Every allocation carries a
+ * small header with its size. Unlike the limiting memory manager, this adds
+ * only constant overhead per call and can be used to measure the cost of an
+ * input.
+ */
+void UA_EXPORT UA_memoryManager_setCounting(void);
+
+/**
+ * Reset the allocation statistics. The peak is set to the memory in use.
+ */
+void UA_EXPORT UA_memoryManager_resetStatistics(void);
+
+/**
+ * Get the allocation statistics since the last reset.
+ *
+ * @param allocated Sum of all allocated bytes (including reallocations)
+ * @param peak Highest amount of memory in use at the same time
+ * @param allocations Number of allocation calls
+ */
+void UA_EXPORT UA_memoryManager_getStatistics(unsigned long long *allocated,
+                                              unsigned long long *peak,
+                                              unsigned long long *allocations);
+
 _UA_END_DECLS
 
 #endif /* OPEN62541_CUSTOM_MEMORY_MANAGER_H */
@@ -0,0 +1,68 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "complexity_budget.h"
+
+#include <open62541/types.h>
+#include <open62541/types_generated_handling.h>
+
+#include "ua_types_encoding_binary.h"
+
+/* The memory manager must be set before the first allocation */
+extern "C" int
+LLVMFuzzerInitialize(int *argc, char ***argv) {
+    (void)argc, (void)argv;
+    UA_ComplexityBudget_init();
+    return 0;
+}
+
+/* Decode a random type, then copy, encode and delete it. This is what the
+ * server does with every (decodable) message. The input format is the same as
+ * for fuzz_binary_decode, so the corpora can be exchanged. */
+extern "C" int
+LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    /* Skip the memory limit of the regular fuzzer */
+    if(size <= 6)
+        return 0;
+    size_t inputSize = size;
+    size -= 4;
+
+    uint16_t typeIndex = (uint16_t)(data[0] | data[1] << 8);
+    if(typeIndex >= UA_TYPES_COUNT)
+        return 0;
+    const UA_DataType *type = &UA_TYPES[typeIndex];
+    const UA_ByteString binary = {size - 2, (UA_Byte*)(uintptr_t)&data[2]};
+
+    UA_ComplexityBudget_start();
+
+    void *dst = UA_new(type);
+    if(!dst)
+        return 0;
+    size_t offset = 0;
+    UA_StatusCode ret = UA_decodeBinaryInternal(&binary, &offset, dst, type, NULL);
+    if(ret == UA_STATUSCODE_GOOD) {
+        void *dstCopy = UA_new(type);
+        if(dstCopy) {
+            UA_copy(dst, dstCopy, type);
+            UA_delete(dstCopy, type);
+        }
+        UA_ByteString encoded = UA_BYTESTRING_NULL;
+        if(UA_ByteString_allocBuffer(&encoded, offset) == UA_STATUSCODE_GOOD) {
+            UA_Byte *pos = encoded.data;
+            const UA_Byte *end = &encoded.data[encoded.length];
+            ret = UA_encodeBinaryInternal(dst, type, &pos, &end, NULL, NULL);
+            (void)ret;
+            UA_ByteString_clear(&encoded);
+        }
+    }
+    UA_delete(dst, type);
+
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+    UA_ComplexityBudget_check(type->typeName, inputSize);
+#else
+    UA_ComplexityBudget_check("decode", inputSize);
+#endif
+    return 0;
+}
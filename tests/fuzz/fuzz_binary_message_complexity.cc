@@ -0,0 +1,79 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "complexity_budget.h"
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/server_config_default.h>
+#include <open62541/types.h>
+
+#include "ua_server_internal.h"
+
+#include "testing_networklayers.h"
+
+#define RECEIVE_BUFFER_SIZE 65535
+
+/* The memory manager must be set before the first allocation */
+extern "C" int
+LLVMFuzzerInitialize(int *argc, char ***argv) {
+    (void)argc, (void)argv;
+    UA_ComplexityBudget_init();
+    return 0;
+}
+
+/* Process a binary message with a server and measure the cost of the decoding
+ * and the service calls. The input format is the same as for
+ * fuzz_binary_message, so the corpus is shared. */
+extern "C" int
+LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    /* Skip the memory limit of the regular fuzzer */
+    if(size <= 4)
+        return 0;
+    size_t inputSize = size;
+    size -= 4;
+
+    UA_Connection c = createDummyConnection(RECEIVE_BUFFER_SIZE, NULL);
+
+    UA_ServerConfig initialConfig;
+    memset(&initialConfig, 0, sizeof(UA_ServerConfig));
+    UA_StatusCode retval = UA_ServerConfig_setDefault(&initialConfig);
+    initialConfig.allowEmptyVariables = UA_RULEHANDLING_ACCEPT;
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_ServerConfig_clean(&initialConfig);
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER,
+                     "Could not generate the server config");
+        return 0;
+    }
+
+    UA_Server *server = UA_Server_newWithConfig(&initialConfig);
+    if(!server) {
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER,
+                     "Could not create server instance using UA_Server_new");
+        return 0;
+    }
+
+    // we need to copy the message because it will be freed in the processing function
+    UA_ByteString msg = UA_BYTESTRING_NULL;
+    retval = UA_ByteString_allocBuffer(&msg, size);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_Server_delete(server);
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_SERVER,
+                     "Could not allocate message buffer");
+        return 0;
+    }
+    memcpy(msg.data, data, size);
+
+    /* Only the processing is measured, not the server setup */
+    UA_ComplexityBudget_start();
+    UA_Server_processBinaryMessage(server, &c, &msg);
+    UA_ComplexityBudget_check("processBinaryMessage", inputSize);
+
+    // if we got an invalid chunk, the message is not deleted, so delete it here
+    UA_ByteString_clear(&msg);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+    c.close(&c);
+    return 0;
+}
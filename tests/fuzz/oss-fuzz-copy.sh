@@ -18,6 +18,7 @@ done
 
 # fuzz_binary_message and fuzz_tcp_message have the same corpus, just copy the .zip
 cp $OUT/fuzz_binary_message_seed_corpus.zip $OUT/fuzz_tcp_message_seed_corpus.zip
+cp $OUT/fuzz_binary_message_seed_corpus.zip $OUT/fuzz_binary_message_complexity_seed_corpus.zip
 
 cp $SRC/open62541/tests/fuzz/*.dict $SRC/open62541/tests/fuzz/*.options $OUT/
 
@@ -427,6 +427,98 @@ START_TEST(PublishDataSetFieldAsDeltaFrame){
             UA_WriterGroup_publishCallback(server, wg);
         } END_TEST
 
+#ifdef UA_ENABLE_PUBSUB_DELTAFRAMES
+static void
+addDeltaFrameField(char *name, const UA_DataType *type, void *value) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.dataType = type->typeId;
+    UA_Variant_setScalar(&attr.value, value, type);
+    UA_StatusCode retVal =
+        UA_Server_addVariableNode(server, UA_NODEID_STRING(1, name),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, name),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_DataSetFieldConfig dataSetFieldConfig;
+    memset(&dataSetFieldConfig, 0, sizeof(UA_DataSetFieldConfig));
+    dataSetFieldConfig.dataSetFieldType = UA_PUBSUB_DATASETFIELD_VARIABLE;
+    dataSetFieldConfig.field.variable.fieldNameAlias = UA_STRING(name);
+    dataSetFieldConfig.field.variable.publishParameters.publishedVariable =
+        UA_NODEID_STRING(1, name);
+    dataSetFieldConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+    retVal = UA_Server_addDataSetField(server, publishedDataSet1, &dataSetFieldConfig, NULL).result;
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+}
+
+static void
+checkDeltaFrame(UA_DataSetWriter *dsw, UA_UInt16 fieldCount, UA_UInt16 firstIndex) {
+    UA_DataSetMessage dsm;
+    ck_assert_int_eq(UA_DataSetWriter_generateDataSetMessage(server, &dsm, dsw),
+                     UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(dsm.header.dataSetMessageType, UA_DATASETMESSAGE_DATADELTAFRAME);
+    ck_assert_uint_eq(dsm.data.deltaFrameData.fieldCount, fieldCount);
+    if(fieldCount > 0)
+        ck_assert_uint_eq(dsm.data.deltaFrameData.deltaFrameFields[0].fieldIndex, firstIndex);
+    UA_DataSetMessage_clear(&dsm);
+}
+
+START_TEST(DeltaFrameContainsChangedFields){
+        setupDataSetFieldTestEnvironment();
+        UA_Int32 intValue = 1;
+        UA_String stringValue = UA_STRING("first");
+        addDeltaFrameField("delta int", &UA_TYPES[UA_TYPES_INT32], &intValue);
+        addDeltaFrameField("delta string", &UA_TYPES[UA_TYPES_STRING], &stringValue);
+
+        UA_DataSetWriter *dsw = UA_DataSetWriter_findDSWbyId(server, dataSetWriter1);
+        dsw->config.keyFrameCount = 10;
+
+        /* The first messages are key frames with all fields */
+        UA_DataSetMessage dsm;
+        for(size_t i = 0; i < 2; i++) {
+            ck_assert_int_eq(UA_DataSetWriter_generateDataSetMessage(server, &dsm, dsw),
+                             UA_STATUSCODE_GOOD);
+            ck_assert_int_eq(dsm.header.dataSetMessageType, UA_DATASETMESSAGE_DATAKEYFRAME);
+            ck_assert_uint_eq(dsm.data.keyFrameData.fieldCount, 2);
+            UA_DataSetMessage_clear(&dsm);
+        }
+
+        /* Unchanged values */
+        checkDeltaFrame(dsw, 0, 0);
+
+        /* Changed numeric field */
+        UA_Variant v;
+        intValue = 2;
+        UA_Variant_setScalar(&v, &intValue, &UA_TYPES[UA_TYPES_INT32]);
+        ck_assert_int_eq(UA_Server_writeValue(server, UA_NODEID_STRING(1, "delta int"), v),
+                         UA_STATUSCODE_GOOD);
+        checkDeltaFrame(dsw, 1, 0);
+        checkDeltaFrame(dsw, 0, 0);
+
+        /* Changed string field */
+        stringValue = UA_STRING("second");
+        UA_Variant_setScalar(&v, &stringValue, &UA_TYPES[UA_TYPES_STRING]);
+        ck_assert_int_eq(UA_Server_writeValue(server, UA_NODEID_STRING(1, "delta string"), v),
+                         UA_STATUSCODE_GOOD);
+        checkDeltaFrame(dsw, 1, 1);
+        checkDeltaFrame(dsw, 0, 0);
+
+        /* Both fields changed */
+        intValue = 3;
+        UA_Variant_setScalar(&v, &intValue, &UA_TYPES[UA_TYPES_INT32]);
+        ck_assert_int_eq(UA_Server_writeValue(server, UA_NODEID_STRING(1, "delta int"), v),
+                         UA_STATUSCODE_GOOD);
+        stringValue = UA_STRING("third");
+        UA_Variant_setScalar(&v, &stringValue, &UA_TYPES[UA_TYPES_STRING]);
+        ck_assert_int_eq(UA_Server_writeValue(server, UA_NODEID_STRING(1, "delta string"), v),
+                         UA_STATUSCODE_GOOD);
+        checkDeltaFrame(dsw, 2, 0);
+        checkDeltaFrame(dsw, 0, 0);
+    } END_TEST
+#endif
+
 int main(void) {
     TCase *tc_add_pubsub_writergroup = tcase_create("PubSub WriterGroup items handling");
     tcase_add_checked_fixture(tc_add_pubsub_writergroup, setup, teardown);
@@ -456,6 +548,9 @@ int main(void) {
     tcase_add_checked_fixture(tc_pubsub_publish, setup, teardown);
     tcase_add_test(tc_pubsub_publish, SinglePublishDataSetField);
     tcase_add_test(tc_pubsub_publish, PublishDataSetFieldAsDeltaFrame);
+#ifdef UA_ENABLE_PUBSUB_DELTAFRAMES
+    tcase_add_test(tc_pubsub_publish, DeltaFrameContainsChangedFields);
+#endif
 
     Suite *s = suite_create("PubSub WriterGroups/Writer/Fields handling and publishing");
     suite_add_tcase(s, tc_add_pubsub_writergroup);
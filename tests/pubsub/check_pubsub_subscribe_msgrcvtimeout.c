@@ -24,6 +24,9 @@ static UA_Boolean UseFastPath = UA_FALSE;
 static UA_DataValue *pFastPathPublisherValue = 0;
 static UA_DataValue *pFastPathSubscriberValue = 0;
 
+/* ReaderGroups receive when a message arrives instead of polling */
+static UA_Boolean UseEventDriven = UA_FALSE;
+
 /***************************************************************************************************/
 /***************************************************************************************************/
 static void setup(void) {
@@ -46,6 +49,7 @@ static void setup(void) {
     ck_assert(UA_STATUSCODE_GOOD == res);
 
     UseFastPath = UA_FALSE;
+    UseEventDriven = UA_FALSE;
 }
 
 /***************************************************************************************************/
@@ -219,6 +223,7 @@ static void AddReaderGroup(
     if (UseFastPath) {
         readerGroupConfig.rtLevel = UA_PUBSUB_RT_FIXED_SIZE;
     }
+    readerGroupConfig.enableEventDrivenReception = UseEventDriven;
     ck_assert(UA_Server_addReaderGroup(server, *pConnectionId, &readerGroupConfig,
                                        opReaderGroupId) == UA_STATUSCODE_GOOD);
 }
@@ -929,6 +934,94 @@ START_TEST(Test_wrong_timeout) {
 
 
 
+/***************************************************************************************************/
+START_TEST(Test_timeout_rearm) {
+
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "\n\nSTART: Test_timeout_rearm");
+
+    /* every message is processed when it arrives */
+    UseEventDriven = UA_TRUE;
+
+    /*
+        Connection 1: WG1 : DSW1    --> Connection 1: RG1 : DSR1
+    */
+
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    /* set custom callback triggered for specific PubSub state changes */
+    config->pubSubConfig.stateChangeCallback = PubSubStateChangeCallback_basic;
+
+    UA_NodeId ConnId_1;
+    UA_NodeId_init(&ConnId_1);
+    UA_UInt32 PublisherNo_Conn1 = 1;
+    AddConnection("Conn1", PublisherNo_Conn1, &ConnId_1);
+
+    UA_NodeId WGId_Conn1_WG1;
+    UA_NodeId_init(&WGId_Conn1_WG1);
+    UA_UInt32 WGNo_Conn1_WG1 = 1;
+    UA_Duration PublishingInterval_Conn1_WG1 = 100.0;
+    AddWriterGroup(&ConnId_1, "Conn1_WG1", WGNo_Conn1_WG1, PublishingInterval_Conn1_WG1, &WGId_Conn1_WG1);
+
+    UA_NodeId DsWId_Conn1_WG1_DS1;
+    UA_NodeId_init(&DsWId_Conn1_WG1_DS1);
+    UA_NodeId VarId_Conn1_WG1_DS1;
+    UA_NodeId_init(&VarId_Conn1_WG1_DS1);
+    UA_NodeId PDSId_Conn1_WG1_PDS1;
+    UA_NodeId_init(&PDSId_Conn1_WG1_PDS1);
+    UA_UInt32 DSWNo_Conn1_WG1 = 1;
+    AddPublishedDataSet(&WGId_Conn1_WG1, "Conn1_WG1_PDS1", "Conn1_WG1_DS1", DSWNo_Conn1_WG1, &PDSId_Conn1_WG1_PDS1,
+        &VarId_Conn1_WG1_DS1, &DsWId_Conn1_WG1_DS1);
+
+    UA_NodeId RGId_Conn1_RG1;
+    UA_NodeId_init(&RGId_Conn1_RG1);
+    AddReaderGroup(&ConnId_1, "Conn1_RG1", &RGId_Conn1_RG1);
+
+    UA_NodeId DSRId_Conn1_RG1_DSR1;
+    UA_NodeId_init(&DSRId_Conn1_RG1_DSR1);
+    UA_NodeId VarId_Conn1_RG1_DSR1;
+    UA_NodeId_init(&VarId_Conn1_RG1_DSR1);
+    UA_Duration MessageReceiveTimeout_Conn1_RG1_DSR1 = 250.0;
+    AddDataSetReader(&RGId_Conn1_RG1, "Conn1_RG1_DSR1", PublisherNo_Conn1, WGNo_Conn1_WG1, DSWNo_Conn1_WG1,
+        MessageReceiveTimeout_Conn1_RG1_DSR1, &VarId_Conn1_RG1_DSR1, &DSRId_Conn1_RG1_DSR1);
+
+    /* every state change of the reader is counted as a timeout */
+    UA_NodeId_copy(&DSRId_Conn1_RG1_DSR1, &ExpectedCallbackComponentNodeId);
+    ExpectedCallbackStateChange = UA_PUBSUBSTATE_ERROR;
+    ExpectedCallbackStatus = UA_STATUSCODE_BADTIMEOUT;
+
+    ck_assert(UA_STATUSCODE_GOOD == UA_Server_setWriterGroupOperational(server, WGId_Conn1_WG1));
+    ck_assert(UA_STATUSCODE_GOOD == UA_Server_setReaderGroupOperational(server, RGId_Conn1_RG1));
+
+    /* messages arrive for several timeout periods. The timer is re-armed from the last message
+       and does not expire. */
+    ServerDoProcess("1", (UA_UInt32) PublishingInterval_Conn1_WG1, 12);
+
+    UA_PubSubState state;
+    ck_assert_int_eq(0, CallbackCnt);
+    ck_assert(UA_Server_DataSetReader_getState(server, DSRId_Conn1_RG1_DSR1, &state) == UA_STATUSCODE_GOOD);
+    ck_assert(state == UA_PUBSUBSTATE_OPERATIONAL);
+
+    /* stop publishing. The last message was received within the last publishing interval. */
+    ck_assert(UA_Server_setWriterGroupDisabled(server, WGId_Conn1_WG1) == UA_STATUSCODE_GOOD);
+
+    ServerDoProcess("2", (UA_UInt32) PublishingInterval_Conn1_WG1, 1);
+
+    ck_assert_int_eq(0, CallbackCnt);
+    ck_assert(UA_Server_DataSetReader_getState(server, DSRId_Conn1_RG1_DSR1, &state) == UA_STATUSCODE_GOOD);
+    ck_assert(state == UA_PUBSUBSTATE_OPERATIONAL);
+
+    /* the timeout happens once, one MessageReceiveTimeout after the last message */
+    ServerDoProcess("3", (UA_UInt32) (MessageReceiveTimeout_Conn1_RG1_DSR1 - PublishingInterval_Conn1_WG1), 1);
+
+    ck_assert_int_eq(1, CallbackCnt);
+    ck_assert(UA_Server_DataSetReader_getState(server, DSRId_Conn1_RG1_DSR1, &state) == UA_STATUSCODE_GOOD);
+    ck_assert(state == UA_PUBSUBSTATE_ERROR);
+
+    ServerDoProcess("4", (UA_UInt32) MessageReceiveTimeout_Conn1_RG1_DSR1, 2);
+    ck_assert_int_eq(1, CallbackCnt);
+
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "END: Test_timeout_rearm\n\n");
+} END_TEST
+
 /***************************************************************************************************/
 /***************************************************************************************************/
 /* Test a bigger configuration */
@@ -1726,6 +1819,115 @@ START_TEST(Test_fast_path) {
 } END_TEST
 
 
+/***************************************************************************************************/
+/* 2 fast-path ReaderGroups on the same connection receive the same message */
+START_TEST(Test_fast_path_multiple_readergroups) {
+
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "\n\nSTART: Test_fast_path_multiple_readergroups");
+
+    UseFastPath = UA_TRUE;
+    /* a polling ReaderGroup takes the message from the socket for itself */
+    UseEventDriven = UA_TRUE;
+
+    /* Connection 1: Writer 1  --> Connection 2: Reader 1 (RG1) and Reader 2 (RG2) */
+
+    UA_NodeId ConnId_1;
+    UA_NodeId_init(&ConnId_1);
+    AddConnection("Conn1", 1, &ConnId_1);
+
+    UA_NodeId WGId_Conn1_WG1;
+    UA_NodeId_init(&WGId_Conn1_WG1);
+    UA_Duration PublishingInterval_Conn1WG1 = 300.0;
+    AddWriterGroup(&ConnId_1, "Conn1_WG1", 1, PublishingInterval_Conn1WG1, &WGId_Conn1_WG1);
+
+    UA_NodeId DsWId_Conn1_WG1_DS1;
+    UA_NodeId_init(&DsWId_Conn1_WG1_DS1);
+    UA_NodeId VarId_Conn1_WG1;
+    UA_NodeId_init(&VarId_Conn1_WG1);
+    UA_NodeId PDSId_Conn1_WG1_PDS1;
+    UA_NodeId_init(&PDSId_Conn1_WG1_PDS1);
+    AddPublishedDataSet(&WGId_Conn1_WG1, "Conn1_WG1_PDS1", "Conn1_WG1_DS1", 1, &PDSId_Conn1_WG1_PDS1,
+        &VarId_Conn1_WG1, &DsWId_Conn1_WG1_DS1);
+
+    UA_NodeId ConnId_2;
+    UA_NodeId_init(&ConnId_2);
+    AddConnection("Conn2", 2, &ConnId_2);
+
+    UA_Duration MessageReceiveTimeout = 400.0;
+
+    UA_NodeId RGId_Conn2_RG1;
+    UA_NodeId_init(&RGId_Conn2_RG1);
+    AddReaderGroup(&ConnId_2, "Conn2_RG1", &RGId_Conn2_RG1);
+    UA_NodeId DSRId_Conn2_RG1_DSR1;
+    UA_NodeId_init(&DSRId_Conn2_RG1_DSR1);
+    UA_NodeId VarId_Conn2_RG1_DSR1;
+    UA_NodeId_init(&VarId_Conn2_RG1_DSR1);
+    AddDataSetReader(&RGId_Conn2_RG1, "Conn2_RG1_DSR1", 1, 1, 1, MessageReceiveTimeout, &VarId_Conn2_RG1_DSR1, &DSRId_Conn2_RG1_DSR1);
+    /* the external value backend references the global pointer. Keep a pointer of our own for the
+       first reader, as the global pointer is overwritten when the second reader is added. */
+    UA_DataValue *pSubscriberValue_RG1 = pFastPathSubscriberValue;
+    UA_ValueBackend valueBackend;
+    memset(&valueBackend, 0, sizeof(valueBackend));
+    valueBackend.backendType = UA_VALUEBACKENDTYPE_EXTERNAL;
+    valueBackend.backend.external.value = &pSubscriberValue_RG1;
+    ck_assert_int_eq(UA_STATUSCODE_GOOD, UA_Server_setVariableNode_valueBackend(server, VarId_Conn2_RG1_DSR1, valueBackend));
+
+    UA_NodeId RGId_Conn2_RG2;
+    UA_NodeId_init(&RGId_Conn2_RG2);
+    AddReaderGroup(&ConnId_2, "Conn2_RG2", &RGId_Conn2_RG2);
+    UA_NodeId DSRId_Conn2_RG2_DSR1;
+    UA_NodeId_init(&DSRId_Conn2_RG2_DSR1);
+    UA_NodeId VarId_Conn2_RG2_DSR1;
+    UA_NodeId_init(&VarId_Conn2_RG2_DSR1);
+    AddDataSetReader(&RGId_Conn2_RG2, "Conn2_RG2_DSR1", 1, 1, 1, MessageReceiveTimeout, &VarId_Conn2_RG2_DSR1, &DSRId_Conn2_RG2_DSR1);
+    UA_DataValue *pSubscriberValue_RG2 = pFastPathSubscriberValue;
+
+    ck_assert(UA_Server_freezeWriterGroupConfiguration(server, WGId_Conn1_WG1) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_setWriterGroupOperational(server, WGId_Conn1_WG1) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_freezeReaderGroupConfiguration(server, RGId_Conn2_RG1) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_setReaderGroupOperational(server, RGId_Conn2_RG1) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_freezeReaderGroupConfiguration(server, RGId_Conn2_RG2) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_setReaderGroupOperational(server, RGId_Conn2_RG2) == UA_STATUSCODE_GOOD);
+
+    /* both ReaderGroups receive the published values */
+    *(UA_Int32 *) pFastPathPublisherValue->value.data = 10;
+    ServerDoProcess("1", (UA_UInt32) (PublishingInterval_Conn1WG1), 3);
+    ck_assert_int_eq(10, *(UA_Int32 *) pSubscriberValue_RG1->value.data);
+    ck_assert_int_eq(10, *(UA_Int32 *) pSubscriberValue_RG2->value.data);
+
+    *(UA_Int32 *) pFastPathPublisherValue->value.data = 33;
+    ServerDoProcess("2", (UA_UInt32) (PublishingInterval_Conn1WG1), 3);
+    ck_assert_int_eq(33, *(UA_Int32 *) pSubscriberValue_RG1->value.data);
+    ck_assert_int_eq(33, *(UA_Int32 *) pSubscriberValue_RG2->value.data);
+
+    /* no DataSetReader runs into a MessageReceiveTimeout */
+    UA_PubSubState state;
+    ck_assert(UA_Server_DataSetReader_getState(server, DSRId_Conn2_RG1_DSR1, &state) == UA_STATUSCODE_GOOD);
+    ck_assert(state == UA_PUBSUBSTATE_OPERATIONAL);
+    ck_assert(UA_Server_DataSetReader_getState(server, DSRId_Conn2_RG2_DSR1, &state) == UA_STATUSCODE_GOOD);
+    ck_assert(state == UA_PUBSUBSTATE_OPERATIONAL);
+
+    ck_assert(UA_Server_setReaderGroupDisabled(server, RGId_Conn2_RG1) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_setReaderGroupDisabled(server, RGId_Conn2_RG2) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_setWriterGroupDisabled(server, WGId_Conn1_WG1) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_unfreezeReaderGroupConfiguration(server, RGId_Conn2_RG1) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_unfreezeReaderGroupConfiguration(server, RGId_Conn2_RG2) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_unfreezeWriterGroupConfiguration(server, WGId_Conn1_WG1) == UA_STATUSCODE_GOOD);
+
+    UA_DataValue_clear(pFastPathPublisherValue);
+    UA_DataValue_delete(pFastPathPublisherValue);
+    UA_DataValue_clear(pSubscriberValue_RG1);
+    UA_DataValue_delete(pSubscriberValue_RG1);
+    UA_DataValue_clear(pSubscriberValue_RG2);
+    UA_DataValue_delete(pSubscriberValue_RG2);
+
+    UseFastPath = UA_FALSE;
+
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "END: Test_fast_path_multiple_readergroups\n\n");
+
+} END_TEST
+
+
 /***************************************************************************************************/
 int main(void) {
 
@@ -1753,6 +1955,13 @@ int main(void) {
     */
     tcase_add_test(tc_basic, Test_wrong_timeout);
 
+    /* test case description:
+        - 1 Connection, 1 DataSetWriter, 1 DataSetReader
+        - messages arrive for several timeout periods, then the writer stops
+        - check that exactly one timeout happens after the last message
+    */
+    tcase_add_test(tc_basic, Test_timeout_rearm);
+
     /* test case description:
         - configure multiple connections with multiple readers and writers
         - disable/enable and check for correct timeouts 
@@ -1775,6 +1984,11 @@ int main(void) {
     */
     tcase_add_test(tc_basic, Test_fast_path);
 
+    /* test case description:
+        - 2 fast-path ReaderGroups on the same connection receive the same message
+    */
+    tcase_add_test(tc_basic, Test_fast_path_multiple_readergroups);
+
     Suite *s = suite_create("PubSub timeout test suite: message receive timeout");
     suite_add_tcase(s, tc_basic);
 
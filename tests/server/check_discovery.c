@@ -7,6 +7,7 @@
 #include <open62541/server_config_default.h>
 
 #include "server/ua_server_internal.h"
+#include "server/ua_services.h"
 
 #include <fcntl.h>
 
@@ -144,6 +145,91 @@ START_TEST(Server_new_shutdown_delete) {
 }
 END_TEST
 
+static void
+registerDirect(UA_Server *pServer, size_t i, UA_Boolean isOnline) {
+    char uri[64];
+    snprintf(uri, 64, "urn:open62541.test.server_%u", (unsigned)i);
+    UA_LocalizedText name = UA_LOCALIZEDTEXT("en", uri);
+    UA_String discoveryUrl = UA_STRING("opc.tcp://localhost:4841");
+
+    UA_RegisterServerRequest request;
+    UA_RegisterServerRequest_init(&request);
+    request.server.serverUri = UA_STRING(uri);
+    request.server.serverNames = &name;
+    request.server.serverNamesSize = 1;
+    request.server.discoveryUrls = &discoveryUrl;
+    request.server.discoveryUrlsSize = 1;
+    request.server.isOnline = isOnline;
+
+    UA_RegisterServerResponse response;
+    UA_RegisterServerResponse_init(&response);
+    UA_LOCK(&pServer->serviceMutex);
+    Service_RegisterServer(pServer, &pServer->adminSession, &request, &response);
+    UA_UNLOCK(&pServer->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_RegisterServerResponse_clear(&response);
+}
+
+static size_t
+findDirect(UA_Server *pServer, UA_String *serverUris, size_t serverUrisSize) {
+    UA_FindServersRequest request;
+    UA_FindServersRequest_init(&request);
+    request.serverUris = serverUris;
+    request.serverUrisSize = serverUrisSize;
+
+    UA_FindServersResponse response;
+    UA_FindServersResponse_init(&response);
+    UA_LOCK(&pServer->serviceMutex);
+    Service_FindServers(pServer, &pServer->adminSession, &request, &response);
+    UA_UNLOCK(&pServer->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    size_t found = response.serversSize;
+    UA_FindServersResponse_clear(&response);
+    return found;
+}
+
+START_TEST(Server_register_many) {
+    UA_Server *pServer = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(pServer);
+    UA_ServerConfig_setMinimal(config, 16665, NULL);
+    config->discoveryCleanupTimeout = 60;
+    ck_assert_uint_eq(UA_Server_run_startup(pServer), UA_STATUSCODE_GOOD);
+
+    for(size_t i = 0; i < 1000; i++)
+        registerDirect(pServer, i, true);
+    ck_assert_uint_eq(pServer->discoveryManager.registeredServersSize, 1000);
+
+    /* Duplicate filter entries and unknown servers are ignored */
+    UA_String filter[3] = {UA_STRING("urn:open62541.test.server_5"),
+                           UA_STRING("urn:open62541.test.server_5"),
+                           UA_STRING("urn:open62541.test.unknown")};
+    ck_assert_uint_eq(findDirect(pServer, filter, 3), 1);
+    /* All registered servers and the server itself */
+    ck_assert_uint_eq(findDirect(pServer, NULL, 0), 1001);
+
+    /* Unregister */
+    registerDirect(pServer, 5, false);
+    ck_assert_uint_eq(pServer->discoveryManager.registeredServersSize, 999);
+    ck_assert_uint_eq(findDirect(pServer, filter, 3), 0);
+
+    /* Re-registration updates the deadline. Only server 0 remains after the
+     * timeout of the others. */
+    UA_fakeSleep(30 * 1000);
+    registerDirect(pServer, 0, true);
+    ck_assert_uint_eq(pServer->discoveryManager.registeredServersSize, 999);
+    UA_fakeSleep(31 * 1000);
+    UA_LOCK(&pServer->serviceMutex);
+    UA_Discovery_cleanupTimedOut(pServer, UA_DateTime_nowMonotonic());
+    UA_UNLOCK(&pServer->serviceMutex);
+    ck_assert_uint_eq(pServer->discoveryManager.registeredServersSize, 1);
+    filter[0] = UA_STRING("urn:open62541.test.server_0");
+    ck_assert_uint_eq(findDirect(pServer, filter, 1), 1);
+
+    UA_Server_run_shutdown(pServer);
+    UA_Server_delete(pServer);
+}
+END_TEST
+
 START_TEST(Server_register) {
     UA_Client *clientRegister = UA_Client_new();
     UA_ClientConfig_setDefault(UA_Client_getConfig(clientRegister));
@@ -584,6 +670,10 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_new_del, Server_new_shutdown_delete);
     suite_add_tcase(s,tc_new_del);
 
+    TCase *tc_register_many = tcase_create("RegisterServer Store");
+    tcase_add_test(tc_register_many, Server_register_many);
+    suite_add_tcase(s,tc_register_many);
+
     TCase *tc_register = tcase_create("RegisterServer");
     tcase_add_unchecked_fixture(tc_register, setup_lds, teardown_lds);
     tcase_add_unchecked_fixture(tc_register, setup_register, teardown_register);
@@ -426,6 +426,176 @@ START_TEST(Nodes_createObjectWithInterfaceOnObject) {
 }
 END_TEST
 
+#ifdef UA_GENERATED_NAMESPACE_ZERO
+#define SHAREDVALUESIZE 100
+
+static UA_SharedVariant *
+getSharedValue(const UA_NodeId id) {
+    const UA_Node *node = UA_NODESTORE_GET(server, &id);
+    ck_assert_ptr_ne(node, NULL);
+    UA_SharedVariant *sv =
+        UA_Variant_getShared(&node->variableNode.value.data.value.value);
+    UA_NODESTORE_RELEASE(server, node);
+    return sv;
+}
+
+static void
+checkArrayValue(const UA_NodeId id, UA_Double first) {
+    UA_Variant v;
+    UA_StatusCode retval = UA_Server_readValue(server, id, &v);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(v.arrayLength, SHAREDVALUESIZE);
+    ck_assert(((UA_Double*)v.data)[0] == first);
+    ck_assert(((UA_Double*)v.data)[1] == 1.0);
+    UA_Variant_clear(&v);
+}
+
+static UA_StatusCode
+editFirstValueInSitu(UA_Server *s, UA_Session *session,
+                     UA_Node *node, void *data) {
+    UA_VariableNode *vn = &node->variableNode;
+    ck_assert_uint_ne(vn->value.data.value.value.storageType,
+                      UA_VARIANT_DATA_SHARED);
+    ((UA_Double*)vn->value.data.value.value.data)[0] = *(UA_Double*)data;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+addSharedValueInstance(UA_UInt32 id) {
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    UA_StatusCode retval =
+        UA_Server_addObjectNode(server, UA_NODEID_NUMERIC(1, id),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, "SharedValueInstance"),
+                                UA_NODEID_NUMERIC(1, 8000), oAttr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+}
+#endif
+
+START_TEST(Nodes_shareTypeChildValues) {
+#ifdef UA_GENERATED_NAMESPACE_ZERO
+    /* ObjectType with a mandatory array property */
+    UA_ObjectTypeAttributes otAttr = UA_ObjectTypeAttributes_default;
+    UA_StatusCode retval =
+        UA_Server_addObjectTypeNode(server, UA_NODEID_NUMERIC(1, 8000),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(1, "SharedValueType"),
+                                    otAttr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Double values[SHAREDVALUESIZE];
+    for(size_t i = 0; i < SHAREDVALUESIZE; i++)
+        values[i] = 1.0;
+    UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+    vAttr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    vAttr.valueRank = UA_VALUERANK_ANY;
+    UA_Variant_setArray(&vAttr.value, values, SHAREDVALUESIZE,
+                        &UA_TYPES[UA_TYPES_DOUBLE]);
+    retval = UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, 8001),
+                                       UA_NODEID_NUMERIC(1, 8000),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+                                       UA_QUALIFIEDNAME(1, "Values"),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+                                       vAttr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_addReference(server, UA_NODEID_NUMERIC(1, 8001),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASMODELLINGRULE),
+                                    UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_MODELLINGRULE_MANDATORY),
+                                    true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Sharing is disabled by default. The instance gets a deep copy. */
+    ck_assert(!UA_Server_getConfig(server)->shareTypeChildValues);
+    addSharedValueInstance(8005);
+    UA_NodeId child0;
+    findChildId(UA_NODEID_NUMERIC(1, 8005), UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+                UA_QUALIFIEDNAME(1, "Values"), &child0);
+    ck_assert_ptr_eq(getSharedValue(child0), NULL);
+    ck_assert_ptr_eq(getSharedValue(UA_NODEID_NUMERIC(1, 8001)), NULL);
+    checkArrayValue(child0, 1.0);
+    UA_NodeId_clear(&child0);
+
+    /* The instances share the value of the type definition */
+    UA_Server_getConfig(server)->shareTypeChildValues = true;
+    addSharedValueInstance(8010);
+    addSharedValueInstance(8020);
+    UA_NodeId child1, child2;
+    findChildId(UA_NODEID_NUMERIC(1, 8010), UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+                UA_QUALIFIEDNAME(1, "Values"), &child1);
+    findChildId(UA_NODEID_NUMERIC(1, 8020), UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+                UA_QUALIFIEDNAME(1, "Values"), &child2);
+    UA_SharedVariant *sv = getSharedValue(UA_NODEID_NUMERIC(1, 8001));
+    ck_assert_ptr_ne(sv, NULL);
+    ck_assert_uint_eq(sv->refCount, 3);
+    ck_assert_ptr_eq(getSharedValue(child1), sv);
+    ck_assert_ptr_eq(getSharedValue(child2), sv);
+    checkArrayValue(child1, 1.0);
+
+    /* Writing the value makes a private copy */
+    values[0] = 2.0;
+    UA_Variant v;
+    UA_Variant_setArray(&v, values, SHAREDVALUESIZE, &UA_TYPES[UA_TYPES_DOUBLE]);
+    retval = UA_Server_writeValue(server, child1, v);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(getSharedValue(child1), NULL);
+    ck_assert_uint_eq(sv->refCount, 2);
+    checkArrayValue(child1, 2.0);
+    checkArrayValue(child2, 1.0);
+
+    /* Writing an IndexRange makes a private copy */
+    UA_WriteValue wv;
+    UA_WriteValue_init(&wv);
+    wv.nodeId = child2;
+    wv.attributeId = UA_ATTRIBUTEID_VALUE;
+    wv.indexRange = UA_STRING("0");
+    wv.value.hasValue = true;
+    UA_Variant_setArray(&wv.value.value, values, 1, &UA_TYPES[UA_TYPES_DOUBLE]);
+    retval = UA_Server_write(server, &wv);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(getSharedValue(child2), NULL);
+    ck_assert_uint_eq(sv->refCount, 1);
+    checkArrayValue(child2, 2.0);
+    checkArrayValue(UA_NODEID_NUMERIC(1, 8001), 1.0);
+
+    /* Editing the node in-situ makes a private copy */
+    addSharedValueInstance(8030);
+    addSharedValueInstance(8040);
+    UA_NodeId child3, child4;
+    findChildId(UA_NODEID_NUMERIC(1, 8030), UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+                UA_QUALIFIEDNAME(1, "Values"), &child3);
+    findChildId(UA_NODEID_NUMERIC(1, 8040), UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+                UA_QUALIFIEDNAME(1, "Values"), &child4);
+    ck_assert_uint_eq(sv->refCount, 3);
+    UA_Double edited = 3.0;
+    UA_LOCK(&server->serviceMutex);
+    retval = UA_Server_editNode(server, &server->adminSession, &child3,
+                                editFirstValueInSitu, &edited);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(getSharedValue(child3), NULL);
+    ck_assert_uint_eq(sv->refCount, 2);
+    checkArrayValue(child3, 3.0);
+    checkArrayValue(child4, 1.0);
+    checkArrayValue(UA_NODEID_NUMERIC(1, 8001), 1.0);
+    UA_NodeId_clear(&child3);
+    UA_NodeId_clear(&child4);
+    retval = UA_Server_deleteNode(server, UA_NODEID_NUMERIC(1, 8030), true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Deleting an instance releases the shared value */
+    ck_assert_uint_eq(sv->refCount, 2);
+    retval = UA_Server_deleteNode(server, UA_NODEID_NUMERIC(1, 8040), true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(sv->refCount, 1);
+
+    UA_NodeId_clear(&child1);
+    UA_NodeId_clear(&child2);
+#endif
+}
+END_TEST
+
 static Suite *testSuite_Client(void) {
     Suite *s = suite_create("Node inheritance");
     TCase *tc_inherit_subtype = tcase_create("Inherit subtype value");
@@ -443,6 +613,10 @@ static Suite *testSuite_Client(void) {
     tcase_add_test(tc_interface_addin, Nodes_createObjectWithInterfaceOnType);
     tcase_add_test(tc_interface_addin, Nodes_createObjectWithInterfaceOnObject);
     suite_add_tcase(s, tc_interface_addin);
+    TCase *tc_shared_values = tcase_create("Shared values");
+    tcase_add_unchecked_fixture(tc_shared_values, setup, teardown);
+    tcase_add_test(tc_shared_values, Nodes_shareTypeChildValues);
+    suite_add_tcase(s, tc_shared_values);
     return s;
 }
 
@@ -8,6 +8,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include "check.h"
 
@@ -25,6 +26,17 @@ static void setupHashMap(void) {
     UA_Nodestore_HashMap(&ns);
 }
 
+static void setupHashMapSwizzled(void) {
+    UA_Nodestore_HashMapSwizzled(&ns);
+}
+
+static void setupHashMapCompact(void) {
+    UA_NodestoreHashMapOptions options;
+    memset(&options, 0, sizeof(UA_NodestoreHashMapOptions));
+    options.compactAttributes = true;
+    UA_Nodestore_HashMapWithOptions(&ns, &options);
+}
+
 static void teardown(void) {
     ns.clear(ns.context);
 }
@@ -184,6 +196,362 @@ START_TEST(failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries) {
 }
 END_TEST
 
+/*********************/
+/* Node References   */
+/*********************/
+
+#define BULKREFS 100
+
+static void
+addBulkReferences(UA_Node *node, UA_UInt32 start, size_t count) {
+    UA_ExpandedNodeId targets[BULKREFS];
+    UA_UInt32 nameHashes[BULKREFS];
+    for(size_t i = 0; i < count; i++) {
+        targets[i] = UA_EXPANDEDNODEID_NUMERIC(1, start + (UA_UInt32)i);
+        nameHashes[i] = (UA_UInt32)i;
+    }
+    UA_StatusCode res = UA_Node_addReferences(node, 0, true, count,
+                                              targets, nameHashes);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void
+checkReferences(const UA_Node *node, UA_UInt32 start, size_t count) {
+    ck_assert_uint_eq(node->head.referencesSize, 1);
+    ck_assert_uint_eq(node->head.references[0].targetsSize, count);
+    UA_Boolean seen[BULKREFS] = {0};
+    const UA_ReferenceTarget *t = NULL;
+    while((t = UA_NodeReferenceKind_iterate(&node->head.references[0], t))) {
+        UA_NodeId id = UA_NodePointer_toNodeId(t->targetId);
+        ck_assert_uint_ge(id.identifier.numeric, start);
+        ck_assert_uint_lt(id.identifier.numeric, start + count);
+        ck_assert(!seen[id.identifier.numeric - start]);
+        seen[id.identifier.numeric - start] = true;
+    }
+}
+
+START_TEST(addReferencesBulk) {
+    UA_Node *n = createNode(0, 1);
+    addBulkReferences(n, 0, BULKREFS / 2);
+    checkReferences(n, 0, BULKREFS / 2);
+
+    /* Existing targets are skipped */
+    addBulkReferences(n, 0, BULKREFS);
+    checkReferences(n, 0, BULKREFS);
+    ns.deleteNode(ns.context, n);
+}
+END_TEST
+
+START_TEST(addReferencesBulkTree) {
+    UA_Node *n = createNode(0, 1);
+    addBulkReferences(n, 0, BULKREFS / 2);
+    UA_StatusCode res = UA_NodeReferenceKind_switch(&n->head.references[0]);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(n->head.references[0].hasRefTree);
+    addBulkReferences(n, 0, BULKREFS);
+    checkReferences(n, 0, BULKREFS);
+
+    /* Copy into a tree allocated at once */
+    UA_Node *n2 = createNode(0, 2);
+    UA_Node_clear(n2);
+    res = UA_Node_copy(n, n2);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    checkReferences(n2, 0, BULKREFS);
+
+    /* Delete the targets individually. Frees the slabs. */
+    for(size_t i = 0; i < BULKREFS; i++) {
+        UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NUMERIC(1, (UA_UInt32)i);
+        res = UA_Node_deleteReference(n, 0, true, &target);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    }
+    ck_assert_uint_eq(n->head.referencesSize, 0);
+
+    /* Back to the array */
+    res = UA_NodeReferenceKind_switch(&n2->head.references[0]);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    checkReferences(n2, 0, BULKREFS);
+
+    ns.deleteNode(ns.context, n);
+    ns.deleteNode(ns.context, n2);
+}
+END_TEST
+
+START_TEST(addDeleteReferencesGrowth) {
+    UA_Node *n = createNode(0, 1);
+    for(UA_UInt32 i = 0; i < BULKREFS; i++) {
+        UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NUMERIC(1, i);
+        UA_StatusCode res = UA_Node_addReference(n, (UA_Byte)(i % 5), true, &target, i);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    }
+    ck_assert_uint_eq(n->head.referencesSize, 5);
+    for(UA_UInt32 i = 0; i < BULKREFS; i += 2) {
+        UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NUMERIC(1, i);
+        UA_StatusCode res = UA_Node_deleteReference(n, (UA_Byte)(i % 5), true, &target);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    }
+    size_t count = 0;
+    for(size_t i = 0; i < n->head.referencesSize; i++)
+        count += n->head.references[i].targetsSize;
+    ck_assert_uint_eq(count, BULKREFS / 2);
+    ns.deleteNode(ns.context, n);
+}
+END_TEST
+
+START_TEST(addDeleteReferencesIndex) {
+    UA_Node *n = createNode(0, 1);
+    addBulkReferences(n, 0, BULKREFS / 2);
+    UA_StatusCode res = UA_NodeReferenceKind_switchIndex(&n->head.references[0]);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(n->head.references[0].hasRefIndex);
+
+    /* Grow the index. Existing targets are found and skipped. */
+    addBulkReferences(n, 0, BULKREFS);
+    checkReferences(n, 0, BULKREFS);
+
+    /* The copy gets its own index */
+    UA_Node *n2 = createNode(0, 2);
+    UA_Node_clear(n2);
+    res = UA_Node_copy(n, n2);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(n2->head.references[0].hasRefIndex);
+    checkReferences(n2, 0, BULKREFS);
+
+    /* Delete every second target. The remaining ones are still found. */
+    for(UA_UInt32 i = 0; i < BULKREFS; i += 2) {
+        UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NUMERIC(1, i);
+        res = UA_Node_deleteReference(n, 0, true, &target);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    }
+    ck_assert_uint_eq(n->head.references[0].targetsSize, BULKREFS / 2);
+    for(UA_UInt32 i = 0; i < BULKREFS; i++) {
+        UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NUMERIC(1, i);
+        res = UA_Node_deleteReference(n, 0, true, &target);
+        if(i % 2 == 0)
+            ck_assert_int_eq(res, UA_STATUSCODE_UNCERTAINREFERENCENOTDELETED);
+        else
+            ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    }
+    ck_assert_uint_eq(n->head.referencesSize, 0);
+
+    /* Switch between the representations */
+    res = UA_NodeReferenceKind_switch(&n2->head.references[0]);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(n2->head.references[0].hasRefTree);
+    ck_assert(!n2->head.references[0].hasRefIndex);
+    res = UA_NodeReferenceKind_switchIndex(&n2->head.references[0]);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(n2->head.references[0].hasRefIndex);
+    checkReferences(n2, 0, BULKREFS);
+    res = UA_NodeReferenceKind_switchIndex(&n2->head.references[0]);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(!n2->head.references[0].hasRefIndex);
+    checkReferences(n2, 0, BULKREFS);
+
+    ns.deleteNode(ns.context, n);
+    ns.deleteNode(ns.context, n2);
+}
+END_TEST
+
+/**********************/
+/* Compact Attributes */
+/**********************/
+
+static void
+checkLocalizedText(const UA_LocalizedText *lt, const char *locale,
+                   const char *text) {
+    UA_String l = UA_STRING((char*)(uintptr_t)locale);
+    UA_String t = UA_STRING((char*)(uintptr_t)text);
+    ck_assert(UA_String_equal(&lt->locale, &l));
+    ck_assert(UA_String_equal(&lt->text, &t));
+}
+
+static void
+checkAttributes(const UA_Node *n, const char *dnLocale, const char *dnText,
+                const char *descrLocale, const char *descrText) {
+    UA_LocalizedText lt;
+    UA_StatusCode res = UA_Node_readDisplayName(n, &lt);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    checkLocalizedText(&lt, dnLocale, dnText);
+    UA_LocalizedText_clear(&lt);
+    res = UA_Node_readDescription(n, &lt);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    checkLocalizedText(&lt, descrLocale, descrText);
+    UA_LocalizedText_clear(&lt);
+}
+
+START_TEST(compactAttributes) {
+    /* DisplayName equal to the BrowseName, empty Description */
+    UA_Node *n1 = createNode(0, 1);
+    n1->head.browseName = UA_QUALIFIEDNAME_ALLOC(1, "Node1");
+    n1->head.displayName = UA_LOCALIZEDTEXT_ALLOC("", "Node1");
+    ns.insertNode(ns.context, n1, NULL);
+
+    /* Distinct DisplayName and a Description */
+    UA_Node *n2 = createNode(0, 2);
+    n2->head.browseName = UA_QUALIFIEDNAME_ALLOC(1, "Node2");
+    n2->head.displayName = UA_LOCALIZEDTEXT_ALLOC("en-US", "Node 2");
+    n2->head.description = UA_LOCALIZEDTEXT_ALLOC("en-US", "The second node");
+    ns.insertNode(ns.context, n2, NULL);
+
+    UA_NodeId id1 = UA_NODEID_NUMERIC(0, 1);
+    const UA_Node *c1 = ns.getNode(ns.context, &id1);
+    ck_assert_uint_ne(c1->head.compactFlags, 0);
+    ck_assert_ptr_eq(c1->head.compactAttributes, NULL); /* Nothing to encode */
+    ck_assert_uint_eq(c1->head.displayName.text.length, 0);
+    checkAttributes(c1, "", "Node1", "", "");
+    ns.releaseNode(ns.context, c1);
+
+    UA_NodeId id2 = UA_NODEID_NUMERIC(0, 2);
+    const UA_Node *c2 = ns.getNode(ns.context, &id2);
+    ck_assert_uint_ne(c2->head.compactFlags, 0);
+    ck_assert_ptr_ne(c2->head.compactAttributes, NULL);
+    checkAttributes(c2, "en-US", "Node 2", "en-US", "The second node");
+    ns.releaseNode(ns.context, c2);
+
+    /* The copy remains compacted. Expand and edit. */
+    UA_Node *e2 = NULL;
+    UA_StatusCode res = ns.getNodeCopy(ns.context, &id2, &e2);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    checkAttributes(e2, "en-US", "Node 2", "en-US", "The second node");
+    res = UA_Node_expandAttributes(e2);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(e2->head.compactFlags, 0);
+    checkLocalizedText(&e2->head.displayName, "en-US", "Node 2");
+    UA_LocalizedText_clear(&e2->head.description);
+    res = ns.replaceNode(ns.context, e2);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Compacted again after the replace */
+    c2 = ns.getNode(ns.context, &id2);
+    ck_assert_uint_ne(c2->head.compactFlags, 0);
+    checkAttributes(c2, "en-US", "Node 2", "", "");
+    ns.releaseNode(ns.context, c2);
+}
+END_TEST
+
+/*****************************/
+/* Pointer Swizzling (Tests) */
+/*****************************/
+
+/* Insert 1 and 2 with a forward reference from 2 to 1 */
+static void insertReferencingNodes(void) {
+    UA_Node* n1 = createNode(0,1);
+    ns.insertNode(ns.context, n1, NULL);
+    UA_Node* n2 = createNode(0,2);
+    UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NUMERIC(0, 1);
+    UA_Node_addReference(n2, 0, true, &target, 0);
+    ns.insertNode(ns.context, n2, NULL);
+}
+
+static const UA_Node *getTarget(void) {
+    UA_NodeId id = UA_NODEID_NUMERIC(0, 2);
+    const UA_Node *n2 = ns.getNode(ns.context, &id);
+    ck_assert_ptr_ne(n2, NULL);
+    ck_assert_uint_eq(n2->head.referencesSize, 1);
+    const UA_ReferenceTarget *t =
+        UA_NodeReferenceKind_iterate(&n2->head.references[0], NULL);
+    ck_assert_ptr_ne(t, NULL);
+    ck_assert_ptr_ne(UA_NodePointer_toNode(t->targetId), NULL);
+    const UA_Node *target = ns.getNodeFromPtr(ns.context, t->targetId);
+    ns.releaseNode(ns.context, n2);
+    return target;
+}
+
+START_TEST(swizzledReferenceResolves) {
+    insertReferencingNodes();
+    const UA_Node *target = getTarget();
+    ck_assert_ptr_ne(target, NULL);
+    ck_assert_uint_eq(target->head.nodeId.identifier.numeric, 1);
+    ns.releaseNode(ns.context, target);
+}
+END_TEST
+
+START_TEST(swizzledReferenceAfterReplace) {
+    insertReferencingNodes();
+    UA_NodeId in1 = UA_NODEID_NUMERIC(0,1);
+    UA_Node* n1;
+    ns.getNodeCopy(ns.context, &in1, &n1);
+    n1->head.browseName = UA_QUALIFIEDNAME_ALLOC(1, "replaced");
+    UA_StatusCode retval = ns.replaceNode(ns.context, n1);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    const UA_Node *target = getTarget();
+    ck_assert_ptr_ne(target, NULL);
+    ck_assert_uint_eq(target->head.browseName.namespaceIndex, 1);
+    ns.releaseNode(ns.context, target);
+}
+END_TEST
+
+START_TEST(swizzledReferenceWhileReplacePending) {
+    insertReferencingNodes();
+    UA_NodeId in1 = UA_NODEID_NUMERIC(0,1);
+    const UA_Node *reader = ns.getNode(ns.context, &in1);
+    UA_Node* n1;
+    ns.getNodeCopy(ns.context, &in1, &n1);
+    n1->head.browseName = UA_QUALIFIEDNAME_ALLOC(1, "replaced");
+    UA_StatusCode retval = ns.replaceNode(ns.context, n1);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The reader still sees the old version. New lookups the new version. */
+    ck_assert_uint_eq(reader->head.browseName.namespaceIndex, 0);
+    const UA_Node *target = getTarget();
+    ck_assert_uint_eq(target->head.browseName.namespaceIndex, 1);
+    ns.releaseNode(ns.context, reader);
+    ns.releaseNode(ns.context, target);
+
+    target = getTarget();
+    ck_assert_uint_eq(target->head.browseName.namespaceIndex, 1);
+    ns.releaseNode(ns.context, target);
+}
+END_TEST
+
+START_TEST(swizzledReferenceToRemovedNode) {
+    insertReferencingNodes();
+    UA_NodeId in1 = UA_NODEID_NUMERIC(0,1);
+    ns.removeNode(ns.context, &in1);
+    const UA_Node *target = getTarget();
+    ck_assert_ptr_eq(target, NULL);
+
+    /* Re-added with the same NodeId */
+    UA_Node* n1 = createNode(0,1);
+    ns.insertNode(ns.context, n1, NULL);
+    target = getTarget();
+    ck_assert_ptr_ne(target, NULL);
+    ck_assert_uint_eq(target->head.nodeId.identifier.numeric, 1);
+    ns.releaseNode(ns.context, target);
+}
+END_TEST
+
+/* The reference is deleted from the node in-situ (as done by the server for
+ * mutable nodes). The removed node is then no longer kept as a tombstone. The
+ * nodestore asserts on clear that no tombstones remain. */
+START_TEST(swizzledReferenceDeletedInSitu) {
+    insertReferencingNodes();
+    UA_NodeId in2 = UA_NODEID_NUMERIC(0,2);
+    const UA_Node *n2 = ns.getNode(ns.context, &in2);
+    UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NUMERIC(0, 1);
+    UA_StatusCode retval =
+        UA_Node_deleteReference((UA_Node*)(uintptr_t)n2, 0, true, &target);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ns.releaseNode(ns.context, n2);
+
+    UA_NodeId in1 = UA_NODEID_NUMERIC(0,1);
+    retval = ns.removeNode(ns.context, &in1);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Re-added and referenced again */
+    UA_Node* n1 = createNode(0,1);
+    ns.insertNode(ns.context, n1, NULL);
+    n2 = ns.getNode(ns.context, &in2);
+    UA_Node_addReference((UA_Node*)(uintptr_t)n2, 0, true, &target, 0);
+    ns.releaseNode(ns.context, n2);
+    const UA_Node *t = getTarget();
+    ck_assert_ptr_ne(t, NULL);
+    ck_assert_uint_eq(t->head.nodeId.identifier.numeric, 1);
+    ns.releaseNode(ns.context, t);
+}
+END_TEST
+
 /************************************/
 /* Performance Profiling Test Cases */
 /************************************/
@@ -248,6 +616,22 @@ START_TEST(profileGetDelete) {
 }
 END_TEST
 
+/* The optional hooks of a previous nodestore in the same struct are reset */
+START_TEST(zipTreeResetsOptionalHooks) {
+    UA_Nodestore hns;
+    memset(&hns, 0, sizeof(UA_Nodestore));
+    UA_Nodestore_HashMapSwizzled(&hns);
+    ck_assert(hns.getNodeFromPtr != NULL);
+    ck_assert(hns.prefetchNodes != NULL);
+    hns.clear(hns.context);
+
+    UA_Nodestore_ZipTree(&hns);
+    ck_assert(hns.getNodeFromPtr == NULL);
+    ck_assert(hns.prefetchNodes == NULL);
+    hns.clear(hns.context);
+}
+END_TEST
+
 static Suite * namespace_suite (void) {
     Suite *s = suite_create ("UA_NodeStore");
 
@@ -271,6 +655,10 @@ static Suite * namespace_suite (void) {
     tcase_add_test (tc_iterate, iterateOverUA_NodeStoreShallNotVisitEmptyNodes);
     tcase_add_test (tc_iterate, iterateOverExpandedNamespaceShallNotVisitEmptyNodes);
     suite_add_tcase (s, tc_iterate);
+
+    TCase* tc_hooks = tcase_create ("Hooks-ZipTree");
+    tcase_add_test (tc_hooks, zipTreeResetsOptionalHooks);
+    suite_add_tcase (s, tc_hooks);
     
     TCase* tc_profile = tcase_create ("Profile-ZipTree");
     tcase_add_checked_fixture(tc_profile, setupZipTree, teardown);
@@ -303,6 +691,56 @@ static Suite * namespace_suite (void) {
     tcase_add_test (tc_profile_hm, profileGetDelete);
     suite_add_tcase (s, tc_profile_hm);
 
+    TCase* tc_refs = tcase_create ("References");
+    tcase_add_checked_fixture(tc_refs, setupHashMap, teardown);
+    tcase_add_test (tc_refs, addReferencesBulk);
+    tcase_add_test (tc_refs, addReferencesBulkTree);
+    tcase_add_test (tc_refs, addDeleteReferencesGrowth);
+    tcase_add_test (tc_refs, addDeleteReferencesIndex);
+    suite_add_tcase (s, tc_refs);
+
+    TCase* tc_compact = tcase_create ("Compact-HashMap");
+    tcase_add_checked_fixture(tc_compact, setupHashMapCompact, teardown);
+    tcase_add_test (tc_compact, compactAttributes);
+    tcase_add_test (tc_compact, replaceExistingNode);
+    tcase_add_test (tc_compact, iterateOverUA_NodeStoreShallNotVisitEmptyNodes);
+    suite_add_tcase (s, tc_compact);
+
+    TCase* tc_find_hms = tcase_create ("Find-HashMapSwizzled");
+    tcase_add_checked_fixture(tc_find_hms, setupHashMapSwizzled, teardown);
+    tcase_add_test (tc_find_hms, findNodeInUA_NodeStoreWithSingleEntry);
+    tcase_add_test (tc_find_hms, findNodeInUA_NodeStoreWithSeveralEntries);
+    tcase_add_test (tc_find_hms, findNodeInExpandedNamespace);
+    tcase_add_test (tc_find_hms, failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries);
+    tcase_add_test (tc_find_hms, failToFindNodeInOtherUA_NodeStore);
+    suite_add_tcase (s, tc_find_hms);
+
+    TCase *tc_replace_hms = tcase_create("Replace-HashMapSwizzled");
+    tcase_add_checked_fixture(tc_replace_hms, setupHashMapSwizzled, teardown);
+    tcase_add_test (tc_replace_hms, replaceExistingNode);
+    tcase_add_test (tc_replace_hms, replaceOldNode);
+    suite_add_tcase (s, tc_replace_hms);
+
+    TCase* tc_iterate_hms = tcase_create ("Iterate-HashMapSwizzled");
+    tcase_add_checked_fixture(tc_iterate_hms, setupHashMapSwizzled, teardown);
+    tcase_add_test (tc_iterate_hms, iterateOverUA_NodeStoreShallNotVisitEmptyNodes);
+    tcase_add_test (tc_iterate_hms, iterateOverExpandedNamespaceShallNotVisitEmptyNodes);
+    suite_add_tcase (s, tc_iterate_hms);
+
+    TCase* tc_swizzle_hms = tcase_create ("Swizzle-HashMapSwizzled");
+    tcase_add_checked_fixture(tc_swizzle_hms, setupHashMapSwizzled, teardown);
+    tcase_add_test (tc_swizzle_hms, swizzledReferenceResolves);
+    tcase_add_test (tc_swizzle_hms, swizzledReferenceAfterReplace);
+    tcase_add_test (tc_swizzle_hms, swizzledReferenceWhileReplacePending);
+    tcase_add_test (tc_swizzle_hms, swizzledReferenceToRemovedNode);
+    tcase_add_test (tc_swizzle_hms, swizzledReferenceDeletedInSitu);
+    suite_add_tcase (s, tc_swizzle_hms);
+
+    TCase* tc_profile_hms = tcase_create ("Profile-HashMapSwizzled");
+    tcase_add_checked_fixture(tc_profile_hms, setupHashMapSwizzled, teardown);
+    tcase_add_test (tc_profile_hms, profileGetDelete);
+    suite_add_tcase (s, tc_profile_hms);
+
     return s;
 }
 
@@ -0,0 +1,288 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information. */
+
+/* This example is just to see how fast we can browse the information model.
+   Compares the HashMap nodestore with and without pointer swizzling. The server
+   does not open a TCP port. */
+
+#include <open62541/server_config_default.h>
+#include <open62541/plugin/nodestore_default.h>
+
+#include "server/ua_services.h"
+#include "ua_server_internal.h"
+
+#include <check.h>
+#include <time.h>
+
+#define FOLDERS 10 /* Number of folders below the objects folder */
+#define FOLDERNODES 100 /* Number of variables in every folder */
+#define BROWSES 1000 /* Number of browse requests to perform */
+#define RECURSIVE_BROWSES 100 /* Number of recursive browses */
+#define CHAINS 1000 /* Number of view chains below the views folder */
+#define CHAINDEPTH 40 /* Number of views in every chain */
+#define TRAVERSALS 10 /* Number of traversals over all chains */
+
+static UA_Server *server;
+static UA_NodeId folderNodeIds[FOLDERS];
+static UA_NodeId chainLeafNodeIds[CHAINS];
+
+static void
+setupAddressSpace(void) {
+    UA_NodeId objectsId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_NodeId organizesId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    UA_NodeId hasComponentId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
+
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    UA_Int32 myInteger = 42;
+    UA_Variant_setScalar(&vattr.value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
+
+    for(size_t i = 0; i < FOLDERS; i++) {
+        char name[20];
+        UA_snprintf(name, 20, "Folder %u", (UA_UInt32)i);
+        UA_StatusCode retval =
+            UA_Server_addObjectNode(server, UA_NODEID_NULL, objectsId, organizesId,
+                                    UA_QUALIFIEDNAME(1, name),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE),
+                                    oattr, NULL, &folderNodeIds[i]);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        for(size_t j = 0; j < FOLDERNODES; j++) {
+            UA_snprintf(name, 20, "Variable %u", (UA_UInt32)j);
+            retval = UA_Server_addVariableNode(server, UA_NODEID_NULL,
+                                               folderNodeIds[i], hasComponentId,
+                                               UA_QUALIFIEDNAME(1, name),
+                                               UA_NODEID_NULL, vattr, NULL, NULL);
+            ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        }
+    }
+}
+
+static void setup(void) {
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_Nodestore_HashMap(&config.nodestore);
+    server = UA_Server_newWithConfig(&config);
+    setupAddressSpace();
+}
+
+static void setupSwizzled(void) {
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_Nodestore_HashMapSwizzled(&config.nodestore);
+    server = UA_Server_newWithConfig(&config);
+    setupAddressSpace();
+}
+
+/* Deep chains of views. The address space is much larger than the cache, so
+ * that the traversals are dominated by resolving the reference targets. Views
+ * have no type definition. So no type node collects an inverse reference for
+ * every node in the chains. */
+static void
+setupChains(void) {
+    UA_ViewAttributes vattr = UA_ViewAttributes_default;
+    UA_NodeId organizesId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    for(size_t i = 0; i < CHAINS; i++) {
+        UA_NodeId parentId = UA_NODEID_NUMERIC(0, UA_NS0ID_VIEWSFOLDER);
+        for(size_t j = 0; j < CHAINDEPTH; j++) {
+            UA_NodeId nodeId;
+            UA_StatusCode retval =
+                UA_Server_addViewNode(server, UA_NODEID_NULL, parentId, organizesId,
+                                      UA_QUALIFIEDNAME(1, "Chain"), vattr,
+                                      NULL, &nodeId);
+            ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+            parentId = nodeId;
+        }
+        chainLeafNodeIds[i] = parentId;
+    }
+}
+
+static void setupTraversal(void) {
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_Nodestore_HashMap(&config.nodestore);
+    server = UA_Server_newWithConfig(&config);
+    setupChains();
+}
+
+static void setupTraversalSwizzled(void) {
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_Nodestore_HashMapSwizzled(&config.nodestore);
+    server = UA_Server_newWithConfig(&config);
+    setupChains();
+}
+
+static void teardownTraversal(void) {
+    for(size_t i = 0; i < CHAINS; i++)
+        UA_NodeId_clear(&chainLeafNodeIds[i]);
+    UA_Server_delete(server);
+}
+
+static void teardown(void) {
+    for(size_t i = 0; i < FOLDERS; i++)
+        UA_NodeId_clear(&folderNodeIds[i]);
+    UA_Server_delete(server);
+}
+
+START_TEST(browseSpeed) {
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+    bd.includeSubtypes = true;
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+
+    UA_BrowseRequest request;
+    UA_BrowseRequest_init(&request);
+    request.nodesToBrowseSize = 1;
+    request.nodesToBrowse = &bd;
+
+    UA_BrowseResponse res;
+    UA_BrowseResponse_init(&res);
+
+    clock_t begin, finish;
+    begin = clock();
+
+    for(size_t i = 0; i < BROWSES; i++) {
+        bd.nodeId = folderNodeIds[i % FOLDERS];
+
+        UA_LOCK(&server->serviceMutex);
+        Service_Browse(server, &server->adminSession, &request, &res);
+        UA_UNLOCK(&server->serviceMutex);
+
+        ck_assert_uint_eq(res.resultsSize, 1);
+        ck_assert_uint_eq(res.results[0].referencesSize, FOLDERNODES);
+        UA_BrowseResponse_clear(&res);
+    }
+
+    finish = clock();
+    double time_spent = (double)(finish - begin) / CLOCKS_PER_SEC;
+    printf("duration for %u browse requests was %f s\n",
+           (unsigned)BROWSES, time_spent);
+}
+END_TEST
+
+START_TEST(browseRecursiveSpeed) {
+    UA_NodeId objectsId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_ReferenceTypeSet refTypes =
+        UA_ReferenceTypeSet_union(UA_REFTYPESET(UA_REFERENCETYPEINDEX_ORGANIZES),
+                                  UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASCOMPONENT));
+
+    clock_t begin, finish;
+    begin = clock();
+
+    for(size_t i = 0; i < RECURSIVE_BROWSES; i++) {
+        size_t resultsSize = 0;
+        UA_ExpandedNodeId *results = NULL;
+        UA_LOCK(&server->serviceMutex);
+        UA_StatusCode retval =
+            browseRecursive(server, 1, &objectsId, UA_BROWSEDIRECTION_FORWARD,
+                            &refTypes, UA_NODECLASS_UNSPECIFIED, false,
+                            &resultsSize, &results);
+        UA_UNLOCK(&server->serviceMutex);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_ge(resultsSize, FOLDERS * (FOLDERNODES + 1));
+        UA_Array_delete(results, resultsSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    }
+
+    finish = clock();
+    double time_spent = (double)(finish - begin) / CLOCKS_PER_SEC;
+    printf("duration for %u recursive browses was %f s\n",
+           (unsigned)RECURSIVE_BROWSES, time_spent);
+}
+END_TEST
+
+/* Walks the inverse references from every leaf up to the views folder */
+START_TEST(isNodeInTreeSpeed) {
+    UA_NodeId viewsId = UA_NODEID_NUMERIC(0, UA_NS0ID_VIEWSFOLDER);
+    UA_ReferenceTypeSet refTypes = UA_REFTYPESET(UA_REFERENCETYPEINDEX_ORGANIZES);
+
+    clock_t begin, finish;
+    begin = clock();
+
+    for(size_t i = 0; i < TRAVERSALS; i++) {
+        for(size_t j = 0; j < CHAINS; j++) {
+            UA_LOCK(&server->serviceMutex);
+            UA_Boolean found = isNodeInTree(server, &chainLeafNodeIds[j],
+                                            &viewsId, &refTypes);
+            UA_UNLOCK(&server->serviceMutex);
+            ck_assert(found);
+        }
+    }
+
+    finish = clock();
+    double time_spent = (double)(finish - begin) / CLOCKS_PER_SEC;
+    printf("duration for %u upwards traversals of depth %u was %f s\n",
+           (unsigned)(TRAVERSALS * CHAINS), (unsigned)CHAINDEPTH, time_spent);
+}
+END_TEST
+
+START_TEST(browseRecursiveChainsSpeed) {
+    UA_NodeId viewsId = UA_NODEID_NUMERIC(0, UA_NS0ID_VIEWSFOLDER);
+    UA_ReferenceTypeSet refTypes = UA_REFTYPESET(UA_REFERENCETYPEINDEX_ORGANIZES);
+
+    clock_t begin, finish;
+    begin = clock();
+
+    for(size_t i = 0; i < TRAVERSALS; i++) {
+        size_t resultsSize = 0;
+        UA_ExpandedNodeId *results = NULL;
+        UA_LOCK(&server->serviceMutex);
+        UA_StatusCode retval =
+            browseRecursive(server, 1, &viewsId, UA_BROWSEDIRECTION_FORWARD,
+                            &refTypes, UA_NODECLASS_UNSPECIFIED, false,
+                            &resultsSize, &results);
+        UA_UNLOCK(&server->serviceMutex);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_ge(resultsSize, CHAINS * CHAINDEPTH);
+        UA_Array_delete(results, resultsSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    }
+
+    finish = clock();
+    double time_spent = (double)(finish - begin) / CLOCKS_PER_SEC;
+    printf("duration for %u recursive browses over %u nodes was %f s\n",
+           (unsigned)TRAVERSALS, (unsigned)(CHAINS * CHAINDEPTH), time_spent);
+}
+END_TEST
+
+static Suite * service_speed_suite (void) {
+    Suite *s = suite_create ("Service Speed");
+
+    TCase* tc_browse = tcase_create ("Browse-HashMap");
+    tcase_add_checked_fixture(tc_browse, setup, teardown);
+    tcase_add_test (tc_browse, browseSpeed);
+    tcase_add_test (tc_browse, browseRecursiveSpeed);
+    suite_add_tcase (s, tc_browse);
+
+    TCase* tc_browse_swizzled = tcase_create ("Browse-HashMapSwizzled");
+    tcase_add_checked_fixture(tc_browse_swizzled, setupSwizzled, teardown);
+    tcase_add_test (tc_browse_swizzled, browseSpeed);
+    tcase_add_test (tc_browse_swizzled, browseRecursiveSpeed);
+    suite_add_tcase (s, tc_browse_swizzled);
+
+    TCase* tc_traversal = tcase_create ("Traversal-HashMap");
+    tcase_add_checked_fixture(tc_traversal, setupTraversal, teardownTraversal);
+    tcase_add_test (tc_traversal, isNodeInTreeSpeed);
+    tcase_add_test (tc_traversal, browseRecursiveChainsSpeed);
+    suite_add_tcase (s, tc_traversal);
+
+    TCase* tc_traversal_swizzled = tcase_create ("Traversal-HashMapSwizzled");
+    tcase_add_checked_fixture(tc_traversal_swizzled, setupTraversalSwizzled,
+                              teardownTraversal);
+    tcase_add_test (tc_traversal_swizzled, isNodeInTreeSpeed);
+    tcase_add_test (tc_traversal_swizzled, browseRecursiveChainsSpeed);
+    suite_add_tcase (s, tc_traversal_swizzled);
+
+    return s;
+}
+
+int main (void) {
+    int number_failed = 0;
+    Suite *s = service_speed_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr,CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed += srunner_ntests_failed (sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
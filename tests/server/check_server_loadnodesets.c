@@ -0,0 +1,413 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server_config_default.h>
+#include <open62541/plugin/nodestore_default.h>
+
+#include "server/ua_server_internal.h"
+
+#include <check.h>
+
+#define BASE_URI "urn:open62541:test:base"
+#define DERIVED_URI "urn:open62541:test:derived"
+#define OTHER_URI "urn:open62541:test:other"
+#define FOLDER_VARIABLES 200
+
+static UA_Server *server = NULL;
+
+static void setup(void) {
+    server = UA_Server_new();
+    UA_ServerConfig_setDefault(UA_Server_getConfig(server));
+}
+
+static void setupSwizzledCompact(void) {
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_NodestoreHashMapOptions options = {true, true};
+    UA_Nodestore_HashMapWithOptions(&config.nodestore, &options);
+    UA_ServerConfig_setDefault(&config);
+    server = UA_Server_newWithConfig(&config);
+}
+
+static void teardown(void) {
+    UA_Server_delete(server);
+}
+
+/* Nodeset "base": A ReferenceType with a subtype, an ObjectType with a
+ * mandatory property and a folder with many variables */
+static UA_StatusCode
+loadBase(UA_Server *s) {
+    UA_UInt16 ns = UA_Server_addNamespace(s, BASE_URI);
+
+    UA_ReferenceTypeAttributes rattr = UA_ReferenceTypeAttributes_default;
+    rattr.inverseName = UA_LOCALIZEDTEXT("", "ConnectedFrom");
+    UA_StatusCode res =
+        UA_Server_addReferenceTypeNode(s, UA_NODEID_NUMERIC(ns, 100),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_NONHIERARCHICALREFERENCES),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                       UA_QUALIFIEDNAME(ns, "ConnectsTo"), rattr, NULL, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    rattr.inverseName = UA_LOCALIZEDTEXT("", "PipedFrom");
+    res = UA_Server_addReferenceTypeNode(s, UA_NODEID_NUMERIC(ns, 101),
+                                         UA_NODEID_NUMERIC(ns, 100),
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                         UA_QUALIFIEDNAME(ns, "PipesTo"), rattr, NULL, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    UA_ObjectTypeAttributes otattr = UA_ObjectTypeAttributes_default;
+    res = UA_Server_addObjectTypeNode(s, UA_NODEID_NUMERIC(ns, 1000),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                      UA_QUALIFIEDNAME(ns, "DeviceType"), otattr, NULL, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    UA_String serial = UA_STRING("0000");
+    UA_Variant_setScalar(&vattr.value, &serial, &UA_TYPES[UA_TYPES_STRING]);
+    res = UA_Server_addVariableNode(s, UA_NODEID_NUMERIC(ns, 1001),
+                                    UA_NODEID_NUMERIC(ns, 1000),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+                                    UA_QUALIFIEDNAME(ns, "SerialNumber"),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+                                    vattr, NULL, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    res = UA_Server_addReference(s, UA_NODEID_NUMERIC(ns, 1001),
+                                 UA_NODEID_NUMERIC(0, UA_NS0ID_HASMODELLINGRULE),
+                                 UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_MODELLINGRULE_MANDATORY),
+                                 true);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    res = UA_Server_addObjectNode(s, UA_NODEID_NUMERIC(ns, 2000),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(ns, "Devices"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE),
+                                  oattr, NULL, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    UA_Int32 value = 42;
+    UA_Variant_setScalar(&vattr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    for(UA_UInt32 i = 0; i < FOLDER_VARIABLES; i++) {
+        char name[20];
+        UA_snprintf(name, 20, "Variable %u", (unsigned)i);
+        res = UA_Server_addVariableNode(s, UA_NODEID_NUMERIC(ns, 3000 + i),
+                                        UA_NODEID_NUMERIC(ns, 2000),
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                        UA_QUALIFIEDNAME(ns, name),
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                        vattr, NULL, NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Nodeset "derived": Uses the types and the folder from "base" */
+static UA_StatusCode
+loadDerived(UA_Server *s) {
+    UA_UInt16 ns = UA_Server_addNamespace(s, DERIVED_URI);
+    UA_UInt16 nsBase = UA_Server_addNamespace(s, BASE_URI);
+
+    UA_ObjectTypeAttributes otattr = UA_ObjectTypeAttributes_default;
+    UA_StatusCode res =
+        UA_Server_addObjectTypeNode(s, UA_NODEID_NUMERIC(ns, 1000),
+                                    UA_NODEID_NUMERIC(nsBase, 1000),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(ns, "PumpType"), otattr, NULL, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    res = UA_Server_addObjectNode(s, UA_NODEID_NUMERIC(ns, 2000),
+                                  UA_NODEID_NUMERIC(nsBase, 2000),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(ns, "Pump1"),
+                                  UA_NODEID_NUMERIC(ns, 1000), oattr, NULL, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    return UA_Server_addReference(s, UA_NODEID_NUMERIC(ns, 2000),
+                                  UA_NODEID_NUMERIC(nsBase, 100),
+                                  UA_EXPANDEDNODEID_NUMERIC(nsBase, 3000), true);
+}
+
+/* Nodeset "other": Independent of the others */
+static UA_StatusCode
+loadOther(UA_Server *s) {
+    UA_UInt16 ns = UA_Server_addNamespace(s, OTHER_URI);
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    return UA_Server_addObjectNode(s, UA_NODEID_STRING(ns, "Other"),
+                                   UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                   UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                   UA_QUALIFIEDNAME(ns, "Other"),
+                                   UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                   oattr, NULL, NULL);
+}
+
+static UA_StatusCode
+loadFailing(UA_Server *s) {
+    UA_StatusCode res = loadOther(s);
+    return (res != UA_STATUSCODE_GOOD) ? res : UA_STATUSCODE_BADINTERNALERROR;
+}
+
+static const char *baseDeps[1] = {BASE_URI};
+
+static size_t
+browseSize(const UA_NodeId nodeId, const UA_NodeId refType) {
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = nodeId;
+    bd.referenceTypeId = refType;
+    bd.includeSubtypes = true;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    size_t size = br.referencesSize;
+    UA_BrowseResult_clear(&br);
+    return size;
+}
+
+/* Count the reference targets stored in the node of the server nodestore.
+ * Browse hides references to unknown targets. */
+static size_t
+rawReferencesSize(const UA_NodeId nodeId) {
+    const UA_Node *node = UA_NODESTORE_GET(server, &nodeId);
+    ck_assert_ptr_ne(node, NULL);
+    size_t size = 0;
+    for(size_t i = 0; i < node->head.referencesSize; i++)
+        size += node->head.references[i].targetsSize;
+    UA_NODESTORE_RELEASE(server, node);
+    return size;
+}
+
+static UA_UInt16
+nsIndex(const char *uri) {
+    size_t index = 0;
+    UA_StatusCode res = UA_Server_getNamespaceByName(server, UA_STRING((char*)(uintptr_t)uri), &index);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    return (UA_UInt16)index;
+}
+
+/* The staged ReferenceTypes kept their index and their subtypes */
+static void
+checkReferenceTypes(UA_UInt16 nsBase) {
+    const UA_NodeId connectsTo = UA_NODEID_NUMERIC(nsBase, 100);
+    const UA_NodeId pipesTo = UA_NODEID_NUMERIC(nsBase, 101);
+    const UA_Node *parent = UA_NODESTORE_GET(server, &connectsTo);
+    const UA_Node *child = UA_NODESTORE_GET(server, &pipesTo);
+    ck_assert_ptr_ne(parent, NULL);
+    ck_assert_ptr_ne(child, NULL);
+    UA_Byte parentIndex = parent->referenceTypeNode.referenceTypeIndex;
+    UA_Byte childIndex = child->referenceTypeNode.referenceTypeIndex;
+    ck_assert_uint_eq(childIndex, parentIndex + 1);
+    ck_assert(UA_NodeId_equal(UA_NODESTORE_GETREFERENCETYPEID(server, parentIndex),
+                              &connectsTo));
+    ck_assert(UA_NodeId_equal(UA_NODESTORE_GETREFERENCETYPEID(server, childIndex),
+                              &pipesTo));
+    ck_assert(UA_ReferenceTypeSet_contains(&parent->referenceTypeNode.subTypes,
+                                           childIndex));
+
+    /* No index before is left unused */
+    ck_assert_uint_gt(parentIndex, 0);
+    const UA_NodeId *prevId = UA_NODESTORE_GETREFERENCETYPEID(server, parentIndex - 1);
+    ck_assert_ptr_ne(prevId, NULL);
+    ck_assert_uint_eq(prevId->namespaceIndex, 0);
+    UA_NODESTORE_RELEASE(server, parent);
+    UA_NODESTORE_RELEASE(server, child);
+}
+
+static void
+checkLoaded(void) {
+    UA_UInt16 nsBase = nsIndex(BASE_URI);
+    UA_UInt16 ns = nsIndex(DERIVED_URI);
+
+    /* The instance of the subtype got the mandatory property from the
+     * supertype in the other namespace */
+    UA_RelativePathElement rpe;
+    UA_RelativePathElement_init(&rpe);
+    rpe.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY);
+    rpe.targetName = UA_QUALIFIEDNAME(nsBase, "SerialNumber");
+    UA_BrowsePath bp;
+    UA_BrowsePath_init(&bp);
+    bp.startingNode = UA_NODEID_NUMERIC(ns, 2000);
+    bp.relativePath.elementsSize = 1;
+    bp.relativePath.elements = &rpe;
+    UA_BrowsePathResult bpr = UA_Server_translateBrowsePathToNodeIds(server, &bp);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bpr.targetsSize, 1);
+    UA_Variant value;
+    UA_StatusCode res = UA_Server_readValue(server, bpr.targets[0].targetId.nodeId, &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_String serial = UA_STRING("0000");
+    ck_assert(UA_String_equal((UA_String*)value.data, &serial));
+    UA_Variant_clear(&value);
+    UA_BrowsePathResult_clear(&bpr);
+
+    /* The references added to the nodes of other namespaces were published */
+    ck_assert_uint_eq(browseSize(UA_NODEID_NUMERIC(nsBase, 2000),
+                                 UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES)),
+                      FOLDER_VARIABLES + 1);
+    ck_assert_uint_eq(browseSize(UA_NODEID_NUMERIC(nsBase, 1000),
+                                 UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE)), 1);
+
+    /* The new ReferenceType is a subtype of NonHierarchicalReferences */
+    ck_assert_uint_eq(browseSize(UA_NODEID_NUMERIC(ns, 2000),
+                                 UA_NODEID_NUMERIC(0, UA_NS0ID_NONHIERARCHICALREFERENCES)), 2);
+    ck_assert_uint_eq(browseSize(UA_NODEID_NUMERIC(ns, 2000),
+                                 UA_NODEID_NUMERIC(nsBase, 100)), 1);
+
+    checkReferenceTypes(nsBase);
+}
+
+START_TEST(loadInDependencyOrder) {
+    /* The dependent loader comes first in the list */
+    UA_NodesetLoader loaders[3] = {
+        {DERIVED_URI, 1, baseDeps, loadDerived},
+        {BASE_URI, 0, NULL, loadBase},
+        {OTHER_URI, 0, NULL, loadOther}
+    };
+    UA_StatusCode res = UA_Server_loadNodesets(server, 3, loaders);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* The namespaces are added in the order of the list */
+    UA_UInt16 nsDerived = nsIndex(DERIVED_URI);
+    ck_assert_uint_eq(nsIndex(BASE_URI), nsDerived + 1);
+    ck_assert_uint_eq(nsIndex(OTHER_URI), nsDerived + 2);
+
+    checkLoaded();
+
+    UA_NodeId objectsId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_NodeId outId;
+    res = UA_Server_readNodeId(server, UA_NODEID_STRING(nsIndex(OTHER_URI), "Other"),
+                               &outId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_NodeId_clear(&outId);
+
+    /* Both loaders added a node to the objects folder */
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = objectsId;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    size_t found = 0;
+    for(size_t i = 0; i < br.referencesSize; i++) {
+        UA_UInt16 ns = br.references[i].nodeId.nodeId.namespaceIndex;
+        if(ns == nsIndex(BASE_URI) || ns == nsIndex(OTHER_URI))
+            found++;
+    }
+    ck_assert_uint_eq(found, 2);
+    UA_BrowseResult_clear(&br);
+} END_TEST
+
+START_TEST(loadAfterExistingNamespace) {
+    UA_NodesetLoader base = {BASE_URI, 0, NULL, loadBase};
+    UA_UInt64 version = server->nodestoreVersion;
+    UA_StatusCode res = UA_Server_loadNodesets(server, 1, &base);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* The ObjectsFolder was replaced. Pinned pointers are resolved again. */
+    ck_assert(server->nodestoreVersion > version);
+
+    /* The dependency is already present in the server */
+    UA_NodesetLoader derived = {DERIVED_URI, 1, baseDeps, loadDerived};
+    res = UA_Server_loadNodesets(server, 1, &derived);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    checkLoaded();
+} END_TEST
+
+START_TEST(failedWaveIsNotPublished) {
+    static const char *otherDeps[1] = {OTHER_URI};
+    UA_NodesetLoader loaders[3] = {
+        {BASE_URI, 0, NULL, loadBase},
+        {OTHER_URI, 0, NULL, loadFailing},
+        {DERIVED_URI, 1, otherDeps, loadDerived}
+    };
+    const UA_NodeId objectsId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    const UA_NodeId baseObjectTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE);
+    size_t objectsRefs = rawReferencesSize(objectsId);
+    size_t baseObjectTypeRefs = rawReferencesSize(baseObjectTypeId);
+    UA_StatusCode res = UA_Server_loadNodesets(server, 3, loaders);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADINTERNALERROR);
+
+    /* Nothing of the first wave was published. The second wave did not run. */
+    UA_NodeId outId;
+    res = UA_Server_readNodeId(server, UA_NODEID_NUMERIC(nsIndex(BASE_URI), 2000), &outId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    res = UA_Server_readNodeId(server, UA_NODEID_STRING(nsIndex(OTHER_URI), "Other"), &outId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    res = UA_Server_readNodeId(server, UA_NODEID_NUMERIC(nsIndex(DERIVED_URI), 2000), &outId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    ck_assert_uint_eq(browseSize(UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                 UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES)), 1);
+
+    /* The loaders did not add references to the nodes of the server */
+    ck_assert_uint_eq(rawReferencesSize(objectsId), objectsRefs);
+    ck_assert_uint_eq(rawReferencesSize(baseObjectTypeId), baseObjectTypeRefs);
+
+    /* The new ReferenceTypes were not published */
+    res = UA_Server_readNodeId(server, UA_NODEID_NUMERIC(nsIndex(BASE_URI), 100), &outId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    /* A later load uses the same ReferenceTypeIndex */
+    UA_NodesetLoader base = {BASE_URI, 0, NULL, loadBase};
+    res = UA_Server_loadNodesets(server, 1, &base);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    checkReferenceTypes(nsIndex(BASE_URI));
+} END_TEST
+
+START_TEST(invalidDependencies) {
+    /* Unknown namespace */
+    static const char *unknownDeps[1] = {"urn:open62541:test:unknown"};
+    UA_NodesetLoader unknown = {DERIVED_URI, 1, unknownDeps, loadDerived};
+    UA_StatusCode res = UA_Server_loadNodesets(server, 1, &unknown);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNOTFOUND);
+
+    /* Cyclic dependency */
+    static const char *derivedDeps[1] = {DERIVED_URI};
+    UA_NodesetLoader cyclic[2] = {
+        {BASE_URI, 1, derivedDeps, loadBase},
+        {DERIVED_URI, 1, baseDeps, loadDerived}
+    };
+    res = UA_Server_loadNodesets(server, 2, cyclic);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADINVALIDARGUMENT);
+} END_TEST
+
+static Suite *testSuite_loadNodesets(void) {
+    Suite *s = suite_create("Load Nodesets");
+
+    TCase *tc_load = tcase_create("Load");
+    tcase_add_checked_fixture(tc_load, setup, teardown);
+    tcase_add_test(tc_load, loadInDependencyOrder);
+    tcase_add_test(tc_load, loadAfterExistingNamespace);
+    tcase_add_test(tc_load, failedWaveIsNotPublished);
+    tcase_add_test(tc_load, invalidDependencies);
+    suite_add_tcase(s, tc_load);
+
+    TCase *tc_swizzled = tcase_create("Load into swizzled and compact nodestore");
+    tcase_add_checked_fixture(tc_swizzled, setupSwizzledCompact, teardown);
+    tcase_add_test(tc_swizzled, loadInDependencyOrder);
+    suite_add_tcase(s, tc_swizzled);
+
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_loadNodesets();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
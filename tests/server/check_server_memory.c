@@ -0,0 +1,160 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server_config_default.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+
+#include <stdlib.h>
+
+#include <check.h>
+#include "testing_clock.h"
+#include "thread_wrapper.h"
+
+UA_Server *server;
+UA_Boolean running;
+THREAD_HANDLE server_thread;
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static void setup(void) {
+    running = true;
+    server = UA_Server_new();
+    UA_ServerConfig_setDefault(UA_Server_getConfig(server));
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static void stopServerThread(void) {
+    if(!running)
+        return;
+    running = false;
+    THREAD_JOIN(server_thread);
+}
+
+static void teardown(void) {
+    stopServerThread();
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+START_TEST(Memory_counters) {
+    stopServerThread();
+
+    UA_MemoryStatistics before[UA_MEMORYTAGSSIZE];
+    UA_MemoryStatistics after[UA_MEMORYTAGSSIZE];
+    UA_getMemoryStatistics(before);
+
+    void *p = UA_malloc(100);
+    ck_assert_ptr_ne(p, NULL);
+    UA_getMemoryStatistics(after);
+    ck_assert_uint_eq(after[UA_MEMORYTAG_OTHER].currentBytes,
+                      before[UA_MEMORYTAG_OTHER].currentBytes + 100);
+    ck_assert_uint_eq(after[UA_MEMORYTAG_OTHER].cumulatedAllocCount,
+                      before[UA_MEMORYTAG_OTHER].cumulatedAllocCount + 1);
+
+    p = UA_realloc(p, 300);
+    ck_assert_ptr_ne(p, NULL);
+    UA_getMemoryStatistics(after);
+    ck_assert_uint_eq(after[UA_MEMORYTAG_OTHER].currentBytes,
+                      before[UA_MEMORYTAG_OTHER].currentBytes + 300);
+    ck_assert_uint_eq(after[UA_MEMORYTAG_OTHER].cumulatedBytes,
+                      before[UA_MEMORYTAG_OTHER].cumulatedBytes + 300);
+
+    UA_free(p);
+    UA_getMemoryStatistics(after);
+    ck_assert_uint_eq(after[UA_MEMORYTAG_OTHER].currentBytes,
+                      before[UA_MEMORYTAG_OTHER].currentBytes);
+    ck_assert_uint_eq(after[UA_MEMORYTAG_OTHER].cumulatedFreeCount,
+                      before[UA_MEMORYTAG_OTHER].cumulatedFreeCount + 1);
+
+    p = UA_calloc(10, 10);
+    ck_assert_uint_eq(((UA_Byte*)p)[99], 0);
+    UA_getMemoryStatistics(after);
+    ck_assert_uint_eq(after[UA_MEMORYTAG_OTHER].currentBytes,
+                      before[UA_MEMORYTAG_OTHER].currentBytes + 100);
+    UA_free(p);
+
+    /* Overflows are rejected */
+    ck_assert_ptr_eq(UA_calloc(SIZE_MAX / 2, 4), NULL);
+    ck_assert_ptr_eq(UA_malloc(SIZE_MAX), NULL);
+} END_TEST
+
+START_TEST(Memory_subsystems) {
+    /* Namespace zero is counted for the nodestore */
+    UA_ServerStatistics stats = UA_Server_getStatistics(server);
+    ck_assert_uint_gt(stats.ms[UA_MEMORYTAG_NODESTORE].currentBytes, 0);
+    size_t sessionBytes = stats.ms[UA_MEMORYTAG_SESSION].currentBytes;
+    size_t subscriptionBytes = stats.ms[UA_MEMORYTAG_SUBSCRIPTION].currentBytes;
+
+    UA_Client *client = UA_Client_new();
+    UA_ClientConfig_setDefault(UA_Client_getConfig(client));
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    UA_CreateSubscriptionResponse response =
+        UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+
+    UA_MonitoredItemCreateRequest item = UA_MonitoredItemCreateRequest_default(
+        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME));
+    UA_MonitoredItemCreateResult result =
+        UA_Client_MonitoredItems_createDataChange(client, response.subscriptionId,
+                                                  UA_TIMESTAMPSTORETURN_BOTH,
+                                                  item, NULL, NULL, NULL);
+    ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_GOOD);
+
+    /* The session and the subscription are attributed to their subsystems */
+    stats = UA_Server_getStatistics(server);
+    ck_assert_uint_gt(stats.ms[UA_MEMORYTAG_SESSION].currentBytes, sessionBytes);
+    ck_assert_uint_gt(stats.ms[UA_MEMORYTAG_SUBSCRIPTION].currentBytes,
+                      subscriptionBytes);
+    ck_assert_uint_gt(stats.ms[UA_MEMORYTAG_SECURECHANNEL].currentBytes, 0);
+    ck_assert_uint_gt(stats.ms[UA_MEMORYTAG_SERVICE].cumulatedAllocCount, 0);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+
+    /* Process the closing of the session and the SecureChannel. The memory is
+     * released in a delayed callback. */
+    stopServerThread();
+    for(size_t i = 0; i < 5; i++) {
+        UA_fakeSleep(1);
+        UA_Server_run_iterate(server, false);
+    }
+
+    /* The memory of the session and the subscription is released */
+    stats = UA_Server_getStatistics(server);
+    ck_assert_uint_eq(stats.ms[UA_MEMORYTAG_SESSION].currentBytes, sessionBytes);
+    ck_assert_uint_eq(stats.ms[UA_MEMORYTAG_SUBSCRIPTION].currentBytes,
+                      subscriptionBytes);
+} END_TEST
+
+static Suite* testSuite_memory(void) {
+    Suite *s = suite_create("Server Memory Accounting");
+    TCase *tc = tcase_create("Statistics");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, Memory_counters);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    tcase_add_test(tc, Memory_subsystems);
+#endif
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_memory();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,497 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server_config_default.h>
+
+#include "server/ua_server_internal.h"
+
+#include <check.h>
+
+#define TEST_URI "http://example.org/Test/"
+
+static UA_Server *server = NULL;
+static UA_UInt16 ns;
+
+/* The instance is defined before its type and before the ReferenceType it
+ * uses. The mandatory Speed variable of the type is not part of the instance
+ * and is added during the deferred instantiation. */
+static const char *nodeset =
+    "\xEF\xBB\xBF<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+    "<!-- A comment with <tags> and \"quotes -->\n"
+    "<UANodeSet xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+    " xmlns:uax=\"http://opcfoundation.org/UA/2008/02/Types.xsd\""
+    " xmlns=\"http://opcfoundation.org/UA/2011/03/UANodeSet.xsd\">\n"
+    "  <NamespaceUris>\n"
+    "    <Uri>" TEST_URI "</Uri>\n"
+    "  </NamespaceUris>\n"
+    "  <Models><Model ModelUri=\"" TEST_URI "\"/></Models>\n"
+    "  <Aliases>\n"
+    "    <Alias Alias=\"Int32\">i=6</Alias>\n"
+    "    <Alias Alias=\"Double\">i=11</Alias>\n"
+    "    <Alias Alias=\"String\">i=12</Alias>\n"
+    "    <Alias Alias=\"LocalizedText\">i=21</Alias>\n"
+    "    <Alias Alias=\"Organizes\">i=35</Alias>\n"
+    "    <Alias Alias=\"HasModellingRule\">i=37</Alias>\n"
+    "    <Alias Alias=\"HasTypeDefinition\">i=40</Alias>\n"
+    "    <Alias Alias=\"HasSubtype\">i=45</Alias>\n"
+    "    <Alias Alias=\"HasComponent\">i=47</Alias>\n"
+    "    <Alias Alias=\"FlowsTo\">ns=1;i=4001</Alias>\n"
+    "  </Aliases>\n"
+    "  <UAObject NodeId=\"ns=1;i=5001\" BrowseName=\"1:Pump1\">\n"
+    "    <DisplayName>Pump 1</DisplayName>\n"
+    "    <References>\n"
+    "      <Reference ReferenceType=\"Organizes\" IsForward=\"false\">i=85</Reference>\n"
+    "      <Reference ReferenceType=\"HasTypeDefinition\">ns=1;i=1001</Reference>\n"
+    "      <Reference ReferenceType=\"FlowsTo\">ns=1;i=5002</Reference>\n"
+    "    </References>\n"
+    "  </UAObject>\n"
+    "  <UAObject NodeId=\"ns=1;i=5002\" BrowseName=\"1:Tank1\">\n"
+    "    <References>\n"
+    "      <Reference ReferenceType=\"Organizes\" IsForward=\"false\">i=85</Reference>\n"
+    "      <Reference ReferenceType=\"HasTypeDefinition\">i=58</Reference>\n"
+    "    </References>\n"
+    "  </UAObject>\n"
+    "  <UAReferenceType NodeId=\"ns=1;i=4001\" BrowseName=\"1:FlowsTo\">\n"
+    "    <DisplayName>FlowsTo</DisplayName>\n"
+    "    <InverseName Locale=\"en\">FlowsFrom</InverseName>\n"
+    "    <References>\n"
+    "      <Reference ReferenceType=\"HasSubtype\" IsForward=\"false\">i=32</Reference>\n"
+    "    </References>\n"
+    "  </UAReferenceType>\n"
+    "  <UAObjectType NodeId=\"ns=1;i=1001\" BrowseName=\"1:PumpType\">\n"
+    "    <References>\n"
+    "      <Reference ReferenceType=\"HasSubtype\" IsForward=\"false\">i=58</Reference>\n"
+    "      <Reference ReferenceType=\"HasComponent\">ns=1;i=6001</Reference>\n"
+    "    </References>\n"
+    "  </UAObjectType>\n"
+    "  <UAVariable NodeId=\"ns=1;i=6001\" BrowseName=\"1:Speed\" ParentNodeId=\"ns=1;i=1001\""
+    " DataType=\"Double\" AccessLevel=\"3\">\n"
+    "    <References>\n"
+    "      <Reference ReferenceType=\"HasTypeDefinition\">i=63</Reference>\n"
+    "      <Reference ReferenceType=\"HasModellingRule\">i=78</Reference>\n"
+    "      <Reference ReferenceType=\"HasComponent\" IsForward=\"false\">ns=1;i=1001</Reference>\n"
+    "    </References>\n"
+    "    <Value><uax:Double>12.5</uax:Double></Value>\n"
+    "  </UAVariable>\n"
+    "  <UAVariable NodeId=\"ns=1;i=6010\" BrowseName=\"1:Values\" DataType=\"Int32\""
+    " ValueRank=\"1\" ArrayDimensions=\"3\">\n"
+    "    <References>\n"
+    "      <Reference ReferenceType=\"HasTypeDefinition\">i=63</Reference>\n"
+    "      <Reference ReferenceType=\"HasComponent\" IsForward=\"false\">ns=1;i=5001</Reference>\n"
+    "    </References>\n"
+    "    <Value>\n"
+    "      <uax:ListOfInt32>\n"
+    "        <uax:Int32>1</uax:Int32>\n"
+    "        <uax:Int32> -2 </uax:Int32>\n"
+    "        <uax:Int32>3</uax:Int32>\n"
+    "      </uax:ListOfInt32>\n"
+    "    </Value>\n"
+    "  </UAVariable>\n"
+    "  <UAVariable NodeId=\"ns=1;s=Label\" BrowseName=\"1:Label\" DataType=\"LocalizedText\">\n"
+    "    <Description Locale='en'>Label &amp; &quot;text&quot;</Description>\n"
+    "    <References>\n"
+    "      <Reference ReferenceType=\"HasTypeDefinition\">i=63</Reference>\n"
+    "      <Reference ReferenceType=\"HasComponent\" IsForward=\"false\">ns=1;i=5002</Reference>\n"
+    "    </References>\n"
+    "    <Value>\n"
+    "      <uax:LocalizedText>\n"
+    "        <uax:Locale>en</uax:Locale>\n"
+    "        <uax:Text>Tank &lt;A&gt; &#x263A;</uax:Text>\n"
+    "      </uax:LocalizedText>\n"
+    "    </Value>\n"
+    "  </UAVariable>\n"
+    "  <UAVariable NodeId=\"ns=1;i=6012\" BrowseName=\"1:Note\" DataType=\"String\">\n"
+    "    <References>\n"
+    "      <Reference ReferenceType=\"HasTypeDefinition\">i=63</Reference>\n"
+    "      <Reference ReferenceType=\"HasComponent\" IsForward=\"false\">ns=1;i=5002</Reference>\n"
+    "    </References>\n"
+    "    <Value><uax:String>a &amp; <![CDATA[<raw> &amp; text]]></uax:String></Value>\n"
+    "  </UAVariable>\n"
+    "  <UAVariable NodeId=\"ns=1;i=6013\" BrowseName=\"1:Config\" DataType=\"i=22\">\n"
+    "    <References>\n"
+    "      <Reference ReferenceType=\"HasTypeDefinition\">i=63</Reference>\n"
+    "      <Reference ReferenceType=\"HasComponent\" IsForward=\"false\">ns=1;i=5002</Reference>\n"
+    "    </References>\n"
+    "    <Value>\n"
+    "      <uax:ExtensionObject>\n"
+    "        <uax:TypeId><uax:Identifier>i=297</uax:Identifier></uax:TypeId>\n"
+    "        <uax:Body><Argument><Name>x</Name></Argument></uax:Body>\n"
+    "      </uax:ExtensionObject>\n"
+    "    </Value>\n"
+    "  </UAVariable>\n"
+    "  <UAMethod NodeId=\"ns=1;i=7001\" BrowseName=\"1:Start\" UserExecutable=\"false\">\n"
+    "    <References>\n"
+    "      <Reference ReferenceType=\"HasComponent\" IsForward=\"false\">ns=1;i=5001</Reference>\n"
+    "    </References>\n"
+    "  </UAMethod>\n"
+    "</UANodeSet>\n";
+
+typedef struct {
+    const char *data;
+    size_t length;
+    size_t pos;
+    size_t chunkSize;
+} TestReader;
+
+static size_t
+readString(void *context, UA_Byte *buf, size_t bufSize) {
+    TestReader *r = (TestReader*)context;
+    size_t len = r->length - r->pos;
+    if(len > bufSize)
+        len = bufSize;
+    if(len > r->chunkSize)
+        len = r->chunkSize;
+    memcpy(buf, &r->data[r->pos], len);
+    r->pos += len;
+    return len;
+}
+
+static UA_StatusCode
+loadString(const char *xml, size_t chunkSize) {
+    TestReader r = {xml, strlen(xml), 0, chunkSize};
+    return UA_Server_loadNodesetXml(server, readString, &r);
+}
+
+static void setup(void) {
+    server = UA_Server_new();
+    UA_ServerConfig_setDefault(UA_Server_getConfig(server));
+}
+
+static void teardown(void) {
+    UA_Server_delete(server);
+}
+
+static UA_NodeId
+findChild(const UA_NodeId parent, const char *name) {
+    UA_RelativePathElement rpe;
+    UA_RelativePathElement_init(&rpe);
+    rpe.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+    rpe.includeSubtypes = true;
+    rpe.targetName = UA_QUALIFIEDNAME(ns, (char*)(uintptr_t)name);
+    UA_BrowsePath bp;
+    UA_BrowsePath_init(&bp);
+    bp.startingNode = parent;
+    bp.relativePath.elementsSize = 1;
+    bp.relativePath.elements = &rpe;
+    UA_BrowsePathResult bpr = UA_Server_translateBrowsePathToNodeIds(server, &bp);
+    UA_NodeId result = UA_NODEID_NULL;
+    if(bpr.statusCode == UA_STATUSCODE_GOOD && bpr.targetsSize == 1)
+        UA_NodeId_copy(&bpr.targets[0].targetId.nodeId, &result);
+    UA_BrowsePathResult_clear(&bpr);
+    return result;
+}
+
+static void
+checkLoaded(void) {
+    size_t nsIndex = 0;
+    ck_assert_uint_eq(UA_Server_getNamespaceByName(server, UA_STRING(TEST_URI), &nsIndex),
+                      UA_STATUSCODE_GOOD);
+    ns = (UA_UInt16)nsIndex;
+    ck_assert_uint_gt(ns, 1);
+
+    /* Attributes */
+    UA_LocalizedText lt;
+    UA_StatusCode res =
+        UA_Server_readDisplayName(server, UA_NODEID_NUMERIC(ns, 5001), &lt);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_String expected = UA_STRING("Pump 1");
+    ck_assert(UA_String_equal(&lt.text, &expected));
+    UA_LocalizedText_clear(&lt);
+
+    /* DisplayName defaults to the BrowseName */
+    res = UA_Server_readDisplayName(server, UA_NODEID_NUMERIC(ns, 5002), &lt);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    expected = UA_STRING("Tank1");
+    ck_assert(UA_String_equal(&lt.text, &expected));
+    UA_LocalizedText_clear(&lt);
+
+    res = UA_Server_readDescription(server, UA_NODEID_STRING(ns, "Label"), &lt);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    expected = UA_STRING("Label & \"text\"");
+    ck_assert(UA_String_equal(&lt.text, &expected));
+    UA_LocalizedText_clear(&lt);
+
+    res = UA_Server_readInverseName(server, UA_NODEID_NUMERIC(ns, 4001), &lt);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    expected = UA_STRING("FlowsFrom");
+    ck_assert(UA_String_equal(&lt.text, &expected));
+    UA_LocalizedText_clear(&lt);
+
+    UA_Byte accessLevel = 0;
+    res = UA_Server_readAccessLevel(server, UA_NODEID_NUMERIC(ns, 6001), &accessLevel);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(accessLevel, 3);
+
+    UA_Boolean executable = false;
+    res = UA_Server_readExecutable(server, UA_NODEID_NUMERIC(ns, 7001), &executable);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(executable);
+
+    /* Values */
+    UA_Variant v;
+    res = UA_Server_readValue(server, UA_NODEID_NUMERIC(ns, 6010), &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(v.type == &UA_TYPES[UA_TYPES_INT32]);
+    ck_assert_uint_eq(v.arrayLength, 3);
+    ck_assert_int_eq(((UA_Int32*)v.data)[1], -2);
+    UA_Variant_clear(&v);
+
+    res = UA_Server_readValue(server, UA_NODEID_STRING(ns, "Label"), &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]));
+    expected = UA_STRING("Tank <A> \xE2\x98\xBA");
+    ck_assert(UA_String_equal(&((UA_LocalizedText*)v.data)->text, &expected));
+    expected = UA_STRING("en");
+    ck_assert(UA_String_equal(&((UA_LocalizedText*)v.data)->locale, &expected));
+    UA_Variant_clear(&v);
+
+    res = UA_Server_readValue(server, UA_NODEID_NUMERIC(ns, 6012), &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    expected = UA_STRING("a & <raw> &amp; text");
+    ck_assert(UA_String_equal((UA_String*)v.data, &expected));
+    UA_Variant_clear(&v);
+
+    /* The ExtensionObject value was skipped. The node exists (possibly with a
+     * default value from the type check). */
+    res = UA_Server_readValue(server, UA_NODEID_NUMERIC(ns, 6013), &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(v.type != &UA_TYPES[UA_TYPES_ARGUMENT]);
+    UA_Variant_clear(&v);
+
+    /* The mandatory child of the type was instantiated for Pump1 */
+    UA_NodeId speed = findChild(UA_NODEID_NUMERIC(ns, 5001), "Speed");
+    ck_assert(!UA_NodeId_isNull(&speed));
+    UA_NodeId typeSpeed = UA_NODEID_NUMERIC(ns, 6001);
+    ck_assert(!UA_NodeId_equal(&speed, &typeSpeed));
+    res = UA_Server_readValue(server, speed, &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_DOUBLE]));
+    ck_assert(*(UA_Double*)v.data == 12.5);
+    UA_Variant_clear(&v);
+    UA_NodeId_clear(&speed);
+
+    /* The forward-declared ReferenceType was added in both directions and is
+     * a subtype of NonHierarchicalReferences */
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(ns, 5002);
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_NONHIERARCHICALREFERENCES);
+    bd.includeSubtypes = true;
+    bd.browseDirection = UA_BROWSEDIRECTION_INVERSE;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(br.referencesSize, 1);
+    UA_NodeId pump = UA_NODEID_NUMERIC(ns, 5001);
+    ck_assert(UA_NodeId_equal(&br.references[0].nodeId.nodeId, &pump));
+    UA_BrowseResult_clear(&br);
+
+    /* The children were added from the reverse direction */
+    UA_NodeId label = findChild(UA_NODEID_NUMERIC(ns, 5002), "Label");
+    UA_NodeId labelId = UA_NODEID_STRING(ns, "Label");
+    ck_assert(UA_NodeId_equal(&label, &labelId));
+    UA_NodeId_clear(&label);
+}
+
+START_TEST(loadNodeset) {
+    ck_assert_uint_eq(loadString(nodeset, SIZE_MAX), UA_STATUSCODE_GOOD);
+    checkLoaded();
+} END_TEST
+
+/* Every token is split across the reads */
+START_TEST(loadNodesetByteWise) {
+    ck_assert_uint_eq(loadString(nodeset, 1), UA_STATUSCODE_GOOD);
+    checkLoaded();
+} END_TEST
+
+START_TEST(loadTwice) {
+    ck_assert_uint_eq(loadString(nodeset, SIZE_MAX), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(loadString(nodeset, SIZE_MAX), UA_STATUSCODE_BADNODEIDEXISTS);
+} END_TEST
+
+START_TEST(truncatedDocument) {
+    char *truncated = strdup(nodeset);
+    truncated[strlen(nodeset) / 2] = 0;
+    UA_StatusCode res = loadString(truncated, 100);
+    free(truncated);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADDECODINGERROR);
+} END_TEST
+
+static size_t
+organizedCount(void) {
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    size_t count = br.referencesSize;
+    UA_BrowseResult_clear(&br);
+    return count;
+}
+
+/* The document breaks off after several batches of nodes were inserted. All
+ * nodes and the references to them are removed again. */
+#define TRUNCATED_NODES 3000
+#define TRUNCATED_NODE                                                  \
+    "<UAObject NodeId=\"ns=1;i=%u\" BrowseName=\"1:Node%u\"><References>"  \
+    "<Reference ReferenceType=\"i=35\" IsForward=\"false\">i=85</Reference>" \
+    "<Reference ReferenceType=\"i=40\">i=58</Reference>"                  \
+    "<Reference ReferenceType=\"i=35\">ns=1;i=%u</Reference>"             \
+    "</References></UAObject>\n"
+
+START_TEST(truncatedDocumentRollback) {
+    size_t before = organizedCount();
+    size_t cap = 256 + TRUNCATED_NODES * 320;
+    char *xml = (char*)malloc(cap);
+    ck_assert(xml != NULL);
+    int pos = snprintf(xml, cap, "<UANodeSet><NamespaceUris><Uri>%s</Uri>"
+                       "</NamespaceUris>\n", TEST_URI);
+    for(unsigned i = 1; i <= TRUNCATED_NODES; i++)
+        pos += snprintf(&xml[pos], cap - (size_t)pos, TRUNCATED_NODE, i, i, i + 1);
+    /* Break off within the last node */
+    xml[pos - 20] = 0;
+    UA_StatusCode res = loadString(xml, SIZE_MAX);
+    free(xml);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADDECODINGERROR);
+
+    size_t nsIndex = 0;
+    ck_assert_uint_eq(UA_Server_getNamespaceByName(server, UA_STRING(TEST_URI), &nsIndex),
+                      UA_STATUSCODE_GOOD);
+    UA_NodeClass nc;
+    for(UA_UInt32 i = 1; i <= TRUNCATED_NODES; i++)
+        ck_assert_uint_eq(UA_Server_readNodeClass(server,
+                                                  UA_NODEID_NUMERIC((UA_UInt16)nsIndex, i),
+                                                  &nc),
+                          UA_STATUSCODE_BADNODEIDUNKNOWN);
+    ck_assert_uint_eq(organizedCount(), before);
+
+    /* The complete document can be loaded afterwards */
+    ck_assert_uint_eq(loadString(nodeset, SIZE_MAX), UA_STATUSCODE_GOOD);
+    checkLoaded();
+} END_TEST
+
+/* Every node references the next node, which is defined later and possibly in
+ * the next batch. And a node in a namespace that is not loaded. */
+#define CHAIN_NODES 3000
+#define CHAIN_NODE                                                      \
+    "<UAObject NodeId=\"ns=1;i=%u\" BrowseName=\"1:Node%u\"><References>"  \
+    "<Reference ReferenceType=\"i=35\" IsForward=\"false\">i=85</Reference>" \
+    "<Reference ReferenceType=\"i=40\">i=58</Reference>"                  \
+    "<Reference ReferenceType=\"i=35\">ns=1;i=%u</Reference>"             \
+    "<Reference ReferenceType=\"i=35\">ns=2;i=%u</Reference>"             \
+    "</References></UAObject>\n"
+
+START_TEST(pendingReferencesAcrossBatches) {
+    size_t cap = 256 + CHAIN_NODES * 384;
+    char *xml = (char*)malloc(cap);
+    ck_assert(xml != NULL);
+    int pos = snprintf(xml, cap, "<UANodeSet><NamespaceUris><Uri>%s</Uri>"
+                       "<Uri>%sExternal/</Uri></NamespaceUris>\n", TEST_URI, TEST_URI);
+    for(unsigned i = 1; i <= CHAIN_NODES; i++)
+        pos += snprintf(&xml[pos], cap - (size_t)pos, CHAIN_NODE, i, i,
+                        (i < CHAIN_NODES) ? i + 1 : 1, i);
+    snprintf(&xml[pos], cap - (size_t)pos, "</UANodeSet>\n");
+    UA_StatusCode res = loadString(xml, SIZE_MAX);
+    free(xml);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Each node has the reference to the next node in both directions. The
+     * references into the other namespace are dropped. */
+    size_t nsIndex = 0;
+    ck_assert_uint_eq(UA_Server_getNamespaceByName(server, UA_STRING(TEST_URI), &nsIndex),
+                      UA_STATUSCODE_GOOD);
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    bd.browseDirection = UA_BROWSEDIRECTION_BOTH;
+    bd.resultMask = UA_BROWSERESULTMASK_ISFORWARD;
+    for(UA_UInt32 i = 1; i <= CHAIN_NODES; i++) {
+        bd.nodeId = UA_NODEID_NUMERIC((UA_UInt16)nsIndex, i);
+        UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+        ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+        /* ObjectsFolder, the previous and the next node */
+        ck_assert_uint_eq(br.referencesSize, 3);
+        UA_NodeId next = UA_NODEID_NUMERIC((UA_UInt16)nsIndex,
+                                           (i < CHAIN_NODES) ? i + 1 : 1);
+        size_t found = 0;
+        for(size_t j = 0; j < br.referencesSize; j++) {
+            if(br.references[j].isForward &&
+               UA_NodeId_equal(&br.references[j].nodeId.nodeId, &next))
+                found++;
+        }
+        ck_assert_uint_eq(found, 1);
+        UA_BrowseResult_clear(&br);
+    }
+} END_TEST
+
+START_TEST(emptyDocument) {
+    ck_assert_uint_eq(loadString("", 100), UA_STATUSCODE_BADDECODINGERROR);
+    ck_assert_uint_eq(loadString("<Other/>", 100), UA_STATUSCODE_BADDECODINGERROR);
+} END_TEST
+
+START_TEST(invalidValue) {
+    const char *xml =
+        "<UANodeSet xmlns:uax=\"http://opcfoundation.org/UA/2008/02/Types.xsd\">"
+        "<UAVariable NodeId=\"i=50001\" BrowseName=\"Invalid\" DataType=\"i=6\">"
+        "<References><Reference ReferenceType=\"i=47\" IsForward=\"false\">i=85</Reference>"
+        "<Reference ReferenceType=\"i=40\">i=63</Reference></References>"
+        "<Value><uax:Int32>abc</uax:Int32></Value>"
+        "</UAVariable></UANodeSet>";
+    ck_assert_uint_eq(loadString(xml, SIZE_MAX), UA_STATUSCODE_BADDECODINGERROR);
+
+    /* The node is not added */
+    UA_NodeClass nc;
+    ck_assert_uint_eq(UA_Server_readNodeClass(server, UA_NODEID_NUMERIC(0, 50001), &nc),
+                      UA_STATUSCODE_BADNODEIDUNKNOWN);
+} END_TEST
+
+START_TEST(typeCheckFailure) {
+    /* The value does not match the DataType. The node is removed during the
+     * deferred checks. The other nodes remain. */
+    const char *xml =
+        "<UANodeSet xmlns:uax=\"http://opcfoundation.org/UA/2008/02/Types.xsd\">"
+        "<UAVariable NodeId=\"i=50001\" BrowseName=\"Mismatch\" DataType=\"i=6\">"
+        "<References><Reference ReferenceType=\"i=47\" IsForward=\"false\">i=85</Reference>"
+        "<Reference ReferenceType=\"i=40\">i=63</Reference></References>"
+        "<Value><uax:String>text</uax:String></Value></UAVariable>"
+        "<UAVariable NodeId=\"i=50002\" BrowseName=\"Match\" DataType=\"i=12\">"
+        "<References><Reference ReferenceType=\"i=47\" IsForward=\"false\">i=85</Reference>"
+        "<Reference ReferenceType=\"i=40\">i=63</Reference></References>"
+        "<Value><uax:String>text</uax:String></Value></UAVariable>"
+        "</UANodeSet>";
+    ck_assert_uint_ne(loadString(xml, SIZE_MAX), UA_STATUSCODE_GOOD);
+    UA_NodeClass nc;
+    ck_assert_uint_eq(UA_Server_readNodeClass(server, UA_NODEID_NUMERIC(0, 50001), &nc),
+                      UA_STATUSCODE_BADNODEIDUNKNOWN);
+    ck_assert_uint_eq(UA_Server_readNodeClass(server, UA_NODEID_NUMERIC(0, 50002), &nc),
+                      UA_STATUSCODE_GOOD);
+} END_TEST
+
+static Suite *testSuite_nodesetXml(void) {
+    Suite *s = suite_create("NodeSet2 XML");
+    TCase *tc = tcase_create("Load");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, loadNodeset);
+    tcase_add_test(tc, loadNodesetByteWise);
+    tcase_add_test(tc, loadTwice);
+    tcase_add_test(tc, truncatedDocument);
+    tcase_add_test(tc, truncatedDocumentRollback);
+    tcase_add_test(tc, pendingReferencesAcrossBatches);
+    tcase_add_test(tc, emptyDocument);
+    tcase_add_test(tc, invalidValue);
+    tcase_add_test(tc, typeCheckFailure);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_nodesetXml();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -72,14 +72,226 @@ START_TEST(addVariable) {
 }
 END_TEST
 
+#define INSTANCES 2000
+#define ENUMSTRINGS 50
+#define ARRAYVALUES 1000
+
+/* Sum up the size of the variable values. A shared value is counted once. */
+typedef struct {
+    size_t valueBytes;
+    size_t sharedValues;
+} ValueMemory;
+
+static void
+countValueMemory(void *visitorCtx, const UA_Node *node) {
+    ValueMemory *vm = (ValueMemory*)visitorCtx;
+    if(node->head.nodeClass != UA_NODECLASS_VARIABLE ||
+       node->variableNode.valueSource != UA_VALUESOURCE_DATA)
+        return;
+    UA_SharedVariant *sv =
+        UA_Variant_getShared(&node->variableNode.value.data.value.value);
+    if(sv) {
+        vm->sharedValues++;
+        /* Count the shared value only for the node in the type definition */
+        if(node->head.nodeId.namespaceIndex == 1 &&
+           node->head.nodeId.identifierType == UA_NODEIDTYPE_NUMERIC &&
+           node->head.nodeId.identifier.numeric > 7000 &&
+           node->head.nodeId.identifier.numeric < 7010)
+            vm->valueBytes += UA_calcSizeBinary(&sv->value, &UA_TYPES[UA_TYPES_VARIANT]);
+        return;
+    }
+    vm->valueBytes += UA_calcSizeBinary(&node->variableNode.value.data.value.value,
+                                        &UA_TYPES[UA_TYPES_VARIANT]);
+}
+
+static void
+addDeviceTypeProperty(UA_UInt32 id, const char *name, void *value, size_t size,
+                      const UA_DataType *type) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.valueRank = UA_VALUERANK_ANY;
+    if(size == 0)
+        UA_Variant_setScalar(&attr.value, value, type);
+    else
+        UA_Variant_setArray(&attr.value, value, size, type);
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, id),
+                                  UA_NODEID_NUMERIC(1, 7000),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+                                  UA_QUALIFIEDNAME(1, (char*)(uintptr_t)name),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+                                  attr, NULL, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_addReference(server, UA_NODEID_NUMERIC(1, id),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASMODELLINGRULE),
+                                    UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_MODELLINGRULE_MANDATORY),
+                                    true);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+}
+
+/* ObjectType with EngineeringUnits, EURange, EnumStrings and a calibration
+ * array property */
+static void
+addDeviceType(void) {
+    UA_ObjectTypeAttributes otAttr = UA_ObjectTypeAttributes_default;
+    UA_StatusCode retval =
+        UA_Server_addObjectTypeNode(server, UA_NODEID_NUMERIC(1, 7000),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(1, "DeviceType"),
+                                    otAttr, NULL, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_EUInformation eu;
+    UA_EUInformation_init(&eu);
+    eu.namespaceUri = UA_STRING("http://www.opcfoundation.org/UA/units/un/cefact");
+    eu.unitId = 4408652;
+    eu.displayName = UA_LOCALIZEDTEXT("en-US", "degC");
+    eu.description = UA_LOCALIZEDTEXT("en-US", "degree Celsius");
+    addDeviceTypeProperty(7001, "EngineeringUnits", &eu, 0,
+                          &UA_TYPES[UA_TYPES_EUINFORMATION]);
+
+    UA_Range range = {-40.0, 125.0};
+    addDeviceTypeProperty(7002, "EURange", &range, 0, &UA_TYPES[UA_TYPES_RANGE]);
+
+    UA_LocalizedText enumStrings[ENUMSTRINGS];
+    for(size_t i = 0; i < ENUMSTRINGS; i++)
+        enumStrings[i] = UA_LOCALIZEDTEXT("en-US", "Device operating state");
+    addDeviceTypeProperty(7003, "EnumStrings", enumStrings, ENUMSTRINGS,
+                          &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+
+    UA_Double calibration[ARRAYVALUES];
+    for(size_t i = 0; i < ARRAYVALUES; i++)
+        calibration[i] = (UA_Double)i;
+    addDeviceTypeProperty(7004, "Calibration", calibration, ARRAYVALUES,
+                          &UA_TYPES[UA_TYPES_DOUBLE]);
+}
+
+static void
+instantiateDevices(UA_Boolean share) {
+    UA_Server_getConfig(server)->shareTypeChildValues = share;
+    addDeviceType();
+
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    clock_t begin = clock();
+    for(size_t i = 0; i < INSTANCES; i++) {
+        UA_StatusCode retval =
+            UA_Server_addObjectNode(server, UA_NODEID_NULL,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                    UA_QUALIFIEDNAME(1, "Device"),
+                                    UA_NODEID_NUMERIC(1, 7000), oAttr, NULL, NULL);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    clock_t finish = clock();
+
+    ValueMemory vm;
+    memset(&vm, 0, sizeof(ValueMemory));
+    UA_Nodestore *ns = &UA_Server_getConfig(server)->nodestore;
+    ns->iterate(ns->context, countValueMemory, &vm);
+    printf("%s values: %u instances in %f s, %u shared values, "
+           "%lu bytes of (encoded) variable values\n", share ? "Shared" : "Copied",
+           (unsigned)INSTANCES, (double)(finish - begin) / CLOCKS_PER_SEC,
+           (unsigned)vm.sharedValues, (unsigned long)vm.valueBytes);
+    if(share)
+        ck_assert_uint_ge(vm.sharedValues, INSTANCES * 4);
+}
+
+START_TEST(instantiateShared) {
+    instantiateDevices(true);
+}
+END_TEST
+
+START_TEST(instantiateCopied) {
+    instantiateDevices(false);
+}
+END_TEST
+
+#define FOLDERCHILDREN 10000
+
+/* Add variables below a new folder with AddNodes requests of the given size.
+ * Items of a request that share the parent are added as a batch. */
+static void
+addFolderChildren(size_t itemsPerRequest) {
+    UA_NodeId folderId;
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    UA_StatusCode retval =
+        UA_Server_addObjectNode(server, UA_NODEID_NULL,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, "Folder"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE),
+                                oAttr, NULL, &folderId);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 myInteger = 42;
+    UA_Variant_setScalar(&attr.value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
+    UA_AddNodesItem *items = (UA_AddNodesItem*)
+        UA_calloc(itemsPerRequest, sizeof(UA_AddNodesItem));
+    ck_assert_ptr_ne(items, NULL);
+    for(size_t i = 0; i < itemsPerRequest; i++) {
+        items[i].nodeClass = UA_NODECLASS_VARIABLE;
+        items[i].browseName = UA_QUALIFIEDNAME(1, "Variable");
+        items[i].parentNodeId.nodeId = folderId;
+        items[i].referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
+        items[i].typeDefinition.nodeId =
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE);
+        UA_ExtensionObject_setValueNoDelete(&items[i].nodeAttributes, &attr,
+                                            &UA_TYPES[UA_TYPES_VARIABLEATTRIBUTES]);
+    }
+
+    UA_AddNodesRequest request;
+    UA_AddNodesRequest_init(&request);
+    request.nodesToAddSize = itemsPerRequest;
+    request.nodesToAdd = items;
+
+    clock_t begin = clock();
+    for(size_t i = 0; i < FOLDERCHILDREN; i += itemsPerRequest) {
+        UA_AddNodesResponse response;
+        UA_AddNodesResponse_init(&response);
+        UA_LOCK(&server->serviceMutex);
+        Service_AddNodes(server, &server->adminSession, &request, &response);
+        UA_UNLOCK(&server->serviceMutex);
+        ck_assert_uint_eq(response.resultsSize, itemsPerRequest);
+        for(size_t j = 0; j < response.resultsSize; j++)
+            ck_assert_uint_eq(response.results[j].statusCode, UA_STATUSCODE_GOOD);
+        UA_AddNodesResponse_clear(&response);
+    }
+    clock_t finish = clock();
+    printf("%u folder children with %u items per request in %f s\n",
+           (unsigned)FOLDERCHILDREN, (unsigned)itemsPerRequest,
+           (double)(finish - begin) / CLOCKS_PER_SEC);
+
+    UA_free(items);
+    UA_NodeId_clear(&folderId);
+}
+
+START_TEST(addFolderChildrenSingle) {
+    addFolderChildren(1);
+}
+END_TEST
+
+START_TEST(addFolderChildrenBatch) {
+    addFolderChildren(1000);
+}
+END_TEST
+
 static Suite * service_speed_suite (void) {
     Suite *s = suite_create ("Service Speed");
 
     TCase* tc_addnodes = tcase_create ("AddNodes");
     tcase_add_checked_fixture(tc_addnodes, setup, teardown);
     tcase_add_test(tc_addnodes, addVariable);
+    tcase_add_test(tc_addnodes, addFolderChildrenSingle);
+    tcase_add_test(tc_addnodes, addFolderChildrenBatch);
     suite_add_tcase(s, tc_addnodes);
 
+    TCase* tc_instantiate = tcase_create ("Instantiate");
+    tcase_add_checked_fixture(tc_instantiate, setup, teardown);
+    tcase_add_test(tc_instantiate, instantiateShared);
+    tcase_add_test(tc_instantiate, instantiateCopied);
+    suite_add_tcase(s, tc_instantiate);
+
     return s;
 }
 
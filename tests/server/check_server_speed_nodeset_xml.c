@@ -0,0 +1,162 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information. */
+
+/* Throughput of the NodeSet2 XML loader. The document is generated on the fly
+ * while it is read. So it is never held in memory as a whole. */
+
+#include <open62541/server_config_default.h>
+
+#include <check.h>
+#include <stdio.h>
+#include <time.h>
+
+#ifndef NODESET_XML_NODES
+#define NODESET_XML_NODES 200000
+#endif
+#define FOLDER_SIZE 1000
+
+static UA_Server *server;
+
+static void setup(void) {
+    server = UA_Server_new();
+    UA_ServerConfig_setDefault(UA_Server_getConfig(server));
+    UA_Server_getConfig(server)->logger.log = NULL;
+}
+
+static void teardown(void) {
+    UA_Server_delete(server);
+}
+
+typedef struct {
+    size_t nodes;    /* Number of variables to generate */
+    size_t next;     /* Next node to generate */
+    UA_Boolean done;
+    char buf[2048];
+    size_t bufLen;
+    size_t bufPos;
+    size_t total;    /* Generated bytes */
+} Generator;
+
+static const char *header =
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+    "<UANodeSet xmlns:uax=\"http://opcfoundation.org/UA/2008/02/Types.xsd\""
+    " xmlns=\"http://opcfoundation.org/UA/2011/03/UANodeSet.xsd\">\n"
+    "  <NamespaceUris><Uri>http://example.org/Speed/</Uri></NamespaceUris>\n"
+    "  <Aliases>\n"
+    "    <Alias Alias=\"Double\">i=11</Alias>\n"
+    "    <Alias Alias=\"Organizes\">i=35</Alias>\n"
+    "    <Alias Alias=\"HasTypeDefinition\">i=40</Alias>\n"
+    "    <Alias Alias=\"HasComponent\">i=47</Alias>\n"
+    "  </Aliases>\n";
+
+/* Render the next element into the buffer */
+static void
+generate(Generator *g) {
+    g->bufPos = 0;
+    if(g->next == 0 && g->total == 0) {
+        g->bufLen = (size_t)snprintf(g->buf, sizeof(g->buf), "%s", header);
+        return;
+    }
+    if(g->next == g->nodes) {
+        g->bufLen = (size_t)snprintf(g->buf, sizeof(g->buf), "</UANodeSet>\n");
+        g->done = true;
+        return;
+    }
+
+    size_t i = g->next++;
+    size_t folder = i / FOLDER_SIZE;
+    int len = 0;
+    if(i % FOLDER_SIZE == 0) {
+        len = snprintf(g->buf, sizeof(g->buf),
+                       "  <UAObject NodeId=\"ns=1;i=%lu\" BrowseName=\"1:Folder%lu\">\n"
+                       "    <DisplayName>Folder %lu</DisplayName>\n"
+                       "    <References>\n"
+                       "      <Reference ReferenceType=\"Organizes\" IsForward=\"false\">i=85</Reference>\n"
+                       "      <Reference ReferenceType=\"HasTypeDefinition\">i=61</Reference>\n"
+                       "    </References>\n"
+                       "  </UAObject>\n",
+                       (unsigned long)(100000000 + folder), (unsigned long)folder,
+                       (unsigned long)folder);
+    }
+    len += snprintf(&g->buf[len], sizeof(g->buf) - (size_t)len,
+                    "  <UAVariable NodeId=\"ns=1;i=%lu\" BrowseName=\"1:Variable%lu\""
+                    " DataType=\"Double\" AccessLevel=\"3\">\n"
+                    "    <DisplayName>Variable %lu</DisplayName>\n"
+                    "    <Description>Generated variable %lu</Description>\n"
+                    "    <References>\n"
+                    "      <Reference ReferenceType=\"HasTypeDefinition\">i=63</Reference>\n"
+                    "      <Reference ReferenceType=\"HasComponent\" IsForward=\"false\">"
+                    "ns=1;i=%lu</Reference>\n"
+                    "    </References>\n"
+                    "    <Value><uax:Double>%lu.5</uax:Double></Value>\n"
+                    "  </UAVariable>\n",
+                    (unsigned long)(i + 1), (unsigned long)i, (unsigned long)i,
+                    (unsigned long)i, (unsigned long)(100000000 + folder),
+                    (unsigned long)i);
+    g->bufLen = (size_t)len;
+}
+
+static size_t
+readGenerated(void *context, UA_Byte *buf, size_t bufSize) {
+    Generator *g = (Generator*)context;
+    size_t written = 0;
+    while(written < bufSize) {
+        if(g->bufPos == g->bufLen) {
+            if(g->done)
+                break;
+            generate(g);
+            g->total += g->bufLen;
+        }
+        size_t n = g->bufLen - g->bufPos;
+        if(n > bufSize - written)
+            n = bufSize - written;
+        memcpy(&buf[written], &g->buf[g->bufPos], n);
+        g->bufPos += n;
+        written += n;
+    }
+    return written;
+}
+
+START_TEST(loadGeneratedNodeset) {
+    Generator g;
+    memset(&g, 0, sizeof(Generator));
+    g.nodes = NODESET_XML_NODES;
+
+    clock_t begin = clock();
+    UA_StatusCode res = UA_Server_loadNodesetXml(server, readGenerated, &g);
+    clock_t finish = clock();
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    double time_spent = (double)(finish - begin) / CLOCKS_PER_SEC;
+    size_t nodes = g.nodes + (g.nodes + FOLDER_SIZE - 1) / FOLDER_SIZE;
+    printf("Loaded %lu nodes (%.1f MB XML) in %f s: %.0f nodes/s, %.1f MB/s\n",
+           (unsigned long)nodes, (double)g.total / 1e6, time_spent,
+           (double)nodes / time_spent, (double)g.total / 1e6 / time_spent);
+
+    /* Spot check of the last variable */
+    UA_Variant v;
+    res = UA_Server_readValue(server, UA_NODEID_NUMERIC(2, (UA_UInt32)g.nodes), &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_DOUBLE]));
+    UA_Variant_clear(&v);
+} END_TEST
+
+static Suite *testSuite_speedNodesetXml(void) {
+    Suite *s = suite_create("Speed NodeSet2 XML");
+    TCase *tc = tcase_create("Load");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_set_timeout(tc, 0);
+    tcase_add_test(tc, loadGeneratedNodeset);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_speedNodesetXml();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,197 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server_config_default.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <check.h>
+#include "thread_wrapper.h"
+
+UA_Server *server;
+UA_Boolean running;
+THREAD_HANDLE server_thread;
+UA_NodeId temperatureNodeId = {1, UA_NODEIDTYPE_NUMERIC, {1001}};
+
+static UA_StatusCode
+readTemperature(UA_Server *tmpServer,
+                const UA_NodeId *sessionId, void *sessionContext,
+                const UA_NodeId *nodeId, void *nodeContext,
+                UA_Boolean sourceTimeStamp, const UA_NumericRange *range,
+                UA_DataValue *dataValue) {
+    UA_Int32 temperature = 42;
+    UA_Variant_setScalarCopy(&dataValue->value, &temperature, &UA_TYPES[UA_TYPES_INT32]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static void setup(void) {
+    running = true;
+    server = UA_Server_new();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig_setDefault(config);
+    config->tracingSampleInterval = 1;
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Temperature");
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    UA_DataSource temperatureSource;
+    temperatureSource.read = readTemperature;
+    temperatureSource.write = NULL;
+    UA_StatusCode retval =
+        UA_Server_addDataSourceVariableNode(server, temperatureNodeId,
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                            UA_QUALIFIEDNAME(1, "Temperature"),
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                            attr, temperatureSource, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+/* Stop the server thread before exporting. The spans of the server thread are
+ * then complete. */
+static void stopServerThread(void) {
+    if(!running)
+        return;
+    running = false;
+    THREAD_JOIN(server_thread);
+}
+
+static void teardown(void) {
+    stopServerThread();
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static void
+readTemperatureTimes(size_t times) {
+    UA_Client *client = UA_Client_new();
+    UA_ClientConfig_setDefault(UA_Client_getConfig(client));
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < times; i++) {
+        UA_Variant val;
+        UA_Variant_init(&val);
+        retval = UA_Client_readValueAttribute(client, temperatureNodeId, &val);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        UA_Variant_clear(&val);
+    }
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+
+static size_t
+countOccurrences(const UA_ByteString *out, const char *needle) {
+    size_t count = 0;
+    size_t len = strlen(needle);
+    for(size_t i = 0; i + len <= out->length; i++) {
+        if(memcmp(&out->data[i], needle, len) == 0)
+            count++;
+    }
+    return count;
+}
+
+START_TEST(Trace_exportChrome) {
+    readTemperatureTimes(1);
+    stopServerThread();
+
+    UA_ByteString out;
+    UA_StatusCode retval = UA_Server_exportTrace(server, UA_TRACEFORMAT_CHROME, &out);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_gt(out.length, 0);
+    ck_assert_uint_eq(countOccurrences(&out, "{\"traceEvents\":["), 1);
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+    ck_assert_uint_eq(countOccurrences(&out, "\"name\":\"ReadRequest\""), 1);
+#endif
+    ck_assert_uint_eq(countOccurrences(&out, "\"cat\":\"datasource\""), 1);
+    ck_assert_uint_gt(countOccurrences(&out, "\"cat\":\"decode\""), 0);
+    ck_assert_uint_gt(countOccurrences(&out, "\"cat\":\"service\""), 0);
+    ck_assert_uint_gt(countOccurrences(&out, "\"cat\":\"nodestore\""), 0);
+    ck_assert_uint_gt(countOccurrences(&out, "\"cat\":\"encode\""), 0);
+    ck_assert_uint_gt(countOccurrences(&out, "\"cat\":\"send\""), 0);
+    UA_ByteString_clear(&out);
+} END_TEST
+
+START_TEST(Trace_exportOtlp) {
+    readTemperatureTimes(3);
+    stopServerThread();
+
+    UA_ByteString out;
+    UA_StatusCode retval = UA_Server_exportTrace(server, UA_TRACEFORMAT_OTLP, &out);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* One line per traced request. The request is the root span of every
+     * trace and has no parent. */
+    size_t lines = countOccurrences(&out, "\n");
+    ck_assert_uint_gt(lines, 3);
+    ck_assert_uint_eq(countOccurrences(&out, "{\"resourceSpans\":"), lines);
+    ck_assert_uint_eq(countOccurrences(&out, "\"kind\":2"), lines);
+    ck_assert_uint_eq(countOccurrences(&out, "\"opcua.stage\",\"value\":{\"stringValue\":"
+                                       "\"datasource\"}"), 3);
+    ck_assert_uint_eq(countOccurrences(&out, "\"parentSpanId\"") +
+                      countOccurrences(&out, "\"kind\":2"),
+                      countOccurrences(&out, "\"spanId\""));
+    UA_ByteString_clear(&out);
+
+    /* The exported spans were removed */
+    retval = UA_Server_exportTrace(server, UA_TRACEFORMAT_OTLP, &out);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(out.length, 0);
+    UA_ByteString_clear(&out);
+} END_TEST
+
+START_TEST(Trace_sampling) {
+    UA_Server_getConfig(server)->tracingSampleInterval = 0;
+    readTemperatureTimes(2);
+    UA_Server_getConfig(server)->tracingSampleInterval = 5;
+    readTemperatureTimes(20);
+    stopServerThread();
+
+    UA_ByteString out;
+    UA_StatusCode retval = UA_Server_exportTrace(server, UA_TRACEFORMAT_OTLP, &out);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    /* About every fifth of the 23 requests (CreateSession, ActivateSession,
+     * Reads, CloseSession) of the second client is traced */
+    size_t traces = countOccurrences(&out, "\n");
+    size_t reads = countOccurrences(&out, "\"opcua.stage\",\"value\":{\"stringValue\":"
+                                    "\"datasource\"}");
+    ck_assert_uint_ge(traces, 4);
+    ck_assert_uint_le(traces, 5);
+    ck_assert_uint_ge(reads, 3);
+    ck_assert_uint_le(reads, traces);
+    UA_ByteString_clear(&out);
+} END_TEST
+
+static Suite* testSuite_tracing(void) {
+    Suite *s = suite_create("Server Tracing");
+    TCase *tc = tcase_create("Export");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, Trace_exportChrome);
+    tcase_add_test(tc, Trace_exportOtlp);
+    tcase_add_test(tc, Trace_sampling);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_tracing();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -3,6 +3,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include <open62541/server_config_default.h>
+#include <open62541/plugin/nodestore_default.h>
 
 #include "server/ua_server_internal.h"
 #include "server/ua_services.h"
@@ -37,9 +38,7 @@ static void teardown(void) {
     UA_Server_delete(server);
 }
 
-static void setup(void) {
-    server = UA_Server_new();
-    UA_ServerConfig_setDefault(UA_Server_getConfig(server));
+static void addNodes(void) {
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
 
     /* VariableNode */
@@ -151,6 +150,25 @@ static void setup(void) {
 #endif
 }
 
+static void setup(void) {
+    server = UA_Server_new();
+    UA_ServerConfig_setDefault(UA_Server_getConfig(server));
+    addNodes();
+}
+
+/* DisplayName and Description are compacted in the nodestore */
+static void setupCompact(void) {
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_NodestoreHashMapOptions options;
+    memset(&options, 0, sizeof(UA_NodestoreHashMapOptions));
+    options.compactAttributes = true;
+    UA_Nodestore_HashMapWithOptions(&config.nodestore, &options);
+    UA_ServerConfig_setDefault(&config);
+    server = UA_Server_newWithConfig(&config);
+    addNodes();
+}
+
 static UA_VariableNode* makeCompareSequence(void) {
     UA_VariableNode *node = (UA_VariableNode*)
         UA_NODESTORE_NEW(server, UA_NODECLASS_VARIABLE);
@@ -634,6 +652,46 @@ START_TEST(ReadSingleAttributeDataTypeDefinitionWithoutTimestamp) {
 
 /* Tests for writeValue method */
 
+/* More operations than fit in a single nodestore batch. Every third node is
+ * unknown. The results are in the order of the request. */
+START_TEST(ReadMultipleAttributesBatched) {
+    UA_ReadValueId rvis[2 * UA_NODESTORE_BATCHSIZE + 7];
+    size_t ops = sizeof(rvis) / sizeof(UA_ReadValueId);
+    for(size_t i = 0; i < ops; i++) {
+        UA_ReadValueId_init(&rvis[i]);
+        rvis[i].nodeId = (i % 3 == 2) ?
+            UA_NODEID_NUMERIC(1, 12345) : UA_NODEID_STRING(1, "the.answer");
+        rvis[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    request.nodesToReadSize = ops;
+    request.nodesToRead = rvis;
+
+    UA_ReadResponse response;
+    UA_ReadResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_Read(server, &server->adminSession, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+
+    ck_assert_int_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, ops);
+    for(size_t i = 0; i < ops; i++) {
+        if(i % 3 == 2) {
+            ck_assert(response.results[i].hasStatus);
+            ck_assert_int_eq(response.results[i].status,
+                             UA_STATUSCODE_BADNODEIDUNKNOWN);
+            continue;
+        }
+        ck_assert(response.results[i].hasValue);
+        ck_assert_int_eq(42, *(UA_Int32*)response.results[i].value.data);
+    }
+
+    UA_ReadResponse_clear(&response);
+} END_TEST
+
 START_TEST(WriteSingleAttributeNodeId) {
     UA_WriteValue wValue;
     UA_WriteValue_init(&wValue);
@@ -874,6 +932,148 @@ START_TEST(WriteSingleAttributeValueRangeFromArray) {
     ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
 } END_TEST
 
+START_TEST(WriteSingleAttributeValueShared) {
+    UA_Server_getConfig(server)->sharedValueMinSize = 16;
+
+    UA_WriteValue wValue;
+    UA_WriteValue_init(&wValue);
+    UA_Int32 myIntegerArray[9] = {11,12,13,14,15,16,17,18,19};
+    UA_Variant_setArray(&wValue.value.value, myIntegerArray, 9, &UA_TYPES[UA_TYPES_INT32]);
+    wValue.value.hasValue = true;
+    wValue.nodeId = UA_NODEID_STRING(1, "myarray");
+    wValue.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_StatusCode retval = UA_Server_write(server, &wValue);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Reads reference the same payload */
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = UA_NODEID_STRING(1, "myarray");
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_DataValue resp1 = UA_Server_read(server, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
+    UA_DataValue resp2 = UA_Server_read(server, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
+    ck_assert(resp1.hasValue && resp2.hasValue);
+    ck_assert_int_eq(resp1.value.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert_ptr_eq(resp1.value.data, resp2.value.data);
+    ck_assert_ptr_ne(resp1.value.data, myIntegerArray);
+
+    /* Writing with an index range makes a private copy in the node */
+    UA_Int32 myInteger = 20;
+    UA_Variant_setArray(&wValue.value.value, &myInteger, 1, &UA_TYPES[UA_TYPES_INT32]);
+    wValue.indexRange = UA_STRING("0");
+    retval = UA_Server_write(server, &wValue);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_DataValue resp3 = UA_Server_read(server, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
+    ck_assert(resp3.hasValue);
+    ck_assert_int_eq(resp3.value.storageType, UA_VARIANT_DATA);
+    ck_assert_int_eq(((UA_Int32*)resp3.value.data)[0], 20);
+    ck_assert_int_eq(((UA_Int32*)resp1.value.data)[0], 11);
+
+    UA_DataValue_clear(&resp1);
+    UA_DataValue_clear(&resp2);
+    UA_DataValue_clear(&resp3);
+} END_TEST
+
+START_TEST(WriteSingleAttributeValueSharedStrings) {
+    UA_Server_getConfig(server)->sharedValueMinSize = 64;
+
+    /* Two Strings are smaller than 64 bytes. But their content is not. */
+    UA_String strings[2];
+    strings[0] = UA_STRING("0123456789012345678901234567890123456789");
+    strings[1] = UA_STRING("0123456789012345678901234567890123456789");
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    vattr.dataType = UA_TYPES[UA_TYPES_STRING].typeId;
+    vattr.valueRank = UA_VALUERANK_ANY;
+    vattr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_String empty = UA_STRING_NULL;
+    UA_Variant_setArray(&vattr.value, &empty, 1, &UA_TYPES[UA_TYPES_STRING]);
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server, UA_NODEID_STRING(1, "strings"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "strings"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  vattr, NULL, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Variant v;
+    UA_Variant_setArray(&v, strings, 2, &UA_TYPES[UA_TYPES_STRING]);
+    retval = UA_Server_writeValue(server, UA_NODEID_STRING(1, "strings"), v);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Variant out;
+    retval = UA_Server_readValue(server, UA_NODEID_STRING(1, "strings"), &out);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(out.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert(UA_String_equal(&((UA_String*)out.data)[1], &strings[1]));
+    UA_Variant_clear(&out);
+} END_TEST
+
+START_TEST(WriteSingleAttributeValueSharedByteString) {
+    UA_Server_getConfig(server)->sharedValueMinSize = 16;
+
+    UA_ByteString bs = UA_BYTESTRING("shared bytes");
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    vattr.dataType = UA_TYPES[UA_TYPES_BYTESTRING].typeId;
+    vattr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_Variant_setScalar(&vattr.value, &bs, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    UA_StatusCode retval =
+        UA_Server_addVariableNode(server, UA_NODEID_STRING(1, "bytestring"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "bytestring"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  vattr, NULL, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_VariableAttributes battr = UA_VariableAttributes_default;
+    battr.dataType = UA_TYPES[UA_TYPES_BYTE].typeId;
+    battr.valueRank = UA_VALUERANK_ANY;
+    battr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_Byte zero = 0;
+    UA_Variant_setArray(&battr.value, &zero, 1, &UA_TYPES[UA_TYPES_BYTE]);
+    retval = UA_Server_addVariableNode(server, UA_NODEID_STRING(1, "bytes"),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                       UA_QUALIFIEDNAME(1, "bytes"),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                       battr, NULL, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The ByteString scalar is stored as a shared payload */
+    UA_Variant shared;
+    UA_Variant_setScalar(&shared, &bs, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    retval = UA_Server_writeValue(server, UA_NODEID_STRING(1, "bytestring"), shared);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_readValue(server, UA_NODEID_STRING(1, "bytestring"), &shared);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(shared.storageType, UA_VARIANT_DATA_SHARED);
+
+    /* Writing the shared ByteString to a Byte array adjusts the type. This
+     * must not modify the shared payload. */
+    retval = UA_Server_writeValue(server, UA_NODEID_STRING(1, "bytes"), shared);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(shared.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert(shared.type == &UA_TYPES[UA_TYPES_BYTESTRING]);
+    ck_assert(UA_ByteString_equal((UA_ByteString*)shared.data, &bs));
+
+    UA_Variant out;
+    retval = UA_Server_readValue(server, UA_NODEID_STRING(1, "bytes"), &out);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(out.type == &UA_TYPES[UA_TYPES_BYTE]);
+    ck_assert_uint_eq(out.arrayLength, bs.length);
+    ck_assert(memcmp(out.data, bs.data, bs.length) == 0);
+    UA_Variant_clear(&out);
+
+    retval = UA_Server_readValue(server, UA_NODEID_STRING(1, "bytestring"), &out);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(out.type == &UA_TYPES[UA_TYPES_BYTESTRING]);
+    ck_assert(UA_ByteString_equal((UA_ByteString*)out.data, &bs));
+    UA_Variant_clear(&out);
+    UA_Variant_clear(&shared);
+} END_TEST
+
 START_TEST(WriteSingleAttributeDataType) {
     UA_WriteValue wValue;
     UA_WriteValue_init(&wValue);
@@ -973,6 +1173,104 @@ START_TEST(WriteSingleDataSourceAttributeValue) {
     ck_assert_int_eq(retval, UA_STATUSCODE_BADWRITENOTSUPPORTED);
 } END_TEST
 
+/* The writes of a batch are applied in the order of the request. The last
+ * write to a node wins. */
+START_TEST(WriteMultipleAttributesBatched) {
+    UA_WriteValue wvs[UA_NODESTORE_BATCHSIZE + 3];
+    UA_Int32 values[UA_NODESTORE_BATCHSIZE + 3];
+    size_t ops = sizeof(wvs) / sizeof(UA_WriteValue);
+    for(size_t i = 0; i < ops; i++) {
+        UA_WriteValue_init(&wvs[i]);
+        values[i] = (UA_Int32)i;
+        wvs[i].nodeId = (i == 1) ?
+            UA_NODEID_NUMERIC(1, 12345) : UA_NODEID_STRING(1, "the.answer");
+        wvs[i].attributeId = UA_ATTRIBUTEID_VALUE;
+        UA_Variant_setScalar(&wvs[i].value.value, &values[i],
+                             &UA_TYPES[UA_TYPES_INT32]);
+        wvs[i].value.hasValue = true;
+    }
+
+    UA_WriteRequest request;
+    UA_WriteRequest_init(&request);
+    request.nodesToWriteSize = ops;
+    request.nodesToWrite = wvs;
+
+    UA_WriteResponse response;
+    UA_WriteResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_Write(server, &server->adminSession, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+
+    ck_assert_int_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, ops);
+    for(size_t i = 0; i < ops; i++) {
+        ck_assert_int_eq(response.results[i], (i == 1) ?
+                         UA_STATUSCODE_BADNODEIDUNKNOWN : UA_STATUSCODE_GOOD);
+    }
+    UA_WriteResponse_clear(&response);
+
+    UA_Variant value;
+    UA_StatusCode retval =
+        UA_Server_readValue(server, UA_NODEID_STRING(1, "the.answer"), &value);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq((UA_Int32)ops - 1, *(UA_Int32*)value.data);
+    UA_Variant_clear(&value);
+} END_TEST
+
+START_TEST(ReadWriteCompactAttributes) {
+    /* ns0 node with the DisplayName equal to the BrowseName */
+    UA_LocalizedText lt;
+    UA_StatusCode retval =
+        UA_Server_readDisplayName(server, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER), &lt);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_String objects = UA_STRING("Objects");
+    ck_assert(UA_String_equal(&lt.text, &objects));
+    UA_LocalizedText_clear(&lt);
+
+    /* Write and read back */
+    UA_LocalizedText testValue = UA_LOCALIZEDTEXT("en-EN", "the new answer");
+    retval = UA_Server_writeDisplayName(server, UA_NODEID_STRING(1, "the.answer"),
+                                        testValue);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_readDisplayName(server, UA_NODEID_STRING(1, "the.answer"), &lt);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_String_equal(&lt.locale, &testValue.locale));
+    ck_assert(UA_String_equal(&lt.text, &testValue.text));
+    UA_LocalizedText_clear(&lt);
+
+    /* The Description is unchanged */
+    retval = UA_Server_readDescription(server, UA_NODEID_STRING(1, "the.answer"), &lt);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_String answer = UA_STRING("the answer");
+    ck_assert(UA_String_equal(&lt.text, &answer));
+    UA_LocalizedText_clear(&lt);
+
+    /* The node is compacted again */
+    UA_NodeId answerId = UA_NODEID_STRING(1, "the.answer");
+    const UA_Node *node = UA_NODESTORE_GET(server, &answerId);
+    ck_assert_ptr_ne(node, NULL);
+    ck_assert_uint_ne(node->head.compactFlags, 0);
+    ck_assert_uint_eq(node->head.displayName.text.length, 0);
+    UA_NODESTORE_RELEASE(server, node);
+
+    /* Browse returns the DisplayName */
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_DISPLAYNAME;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_int_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    UA_Boolean found = false;
+    for(size_t i = 0; i < br.referencesSize; i++) {
+        if(UA_String_equal(&br.references[i].displayName.text, &testValue.text))
+            found = true;
+    }
+    ck_assert(found);
+    UA_BrowseResult_clear(&br);
+} END_TEST
+
 static Suite * testSuite_services_attributes(void) {
     Suite *s = suite_create("services_attributes_read");
 
@@ -1007,6 +1305,7 @@ static Suite * testSuite_services_attributes(void) {
     tcase_add_test(tc_readSingleAttributes, ReadSingleDataSourceAttributeDataTypeWithoutTimestamp);
     tcase_add_test(tc_readSingleAttributes, ReadSingleDataSourceAttributeArrayDimensionsWithoutTimestamp);
     tcase_add_test(tc_readSingleAttributes, ReadSingleAttributeDataTypeDefinitionWithoutTimestamp);
+    tcase_add_test(tc_readSingleAttributes, ReadMultipleAttributesBatched);
 
     suite_add_tcase(s, tc_readSingleAttributes);
 
@@ -1029,6 +1328,9 @@ static Suite * testSuite_services_attributes(void) {
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeDataType);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueRangeFromScalar);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueRangeFromArray);
+    tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueShared);
+    tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueSharedStrings);
+    tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueSharedByteString);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueRank);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeArrayDimensions);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeAccessLevel);
@@ -1036,9 +1338,19 @@ static Suite * testSuite_services_attributes(void) {
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeHistorizing);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeExecutable);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleDataSourceAttributeValue);
+    tcase_add_test(tc_writeSingleAttributes, WriteMultipleAttributesBatched);
 
     suite_add_tcase(s, tc_writeSingleAttributes);
 
+    TCase *tc_compactAttributes = tcase_create("compactAttributes");
+    tcase_add_checked_fixture(tc_compactAttributes, setupCompact, teardown);
+    tcase_add_test(tc_compactAttributes, ReadSingleAttributeDisplayNameWithoutTimestamp);
+    tcase_add_test(tc_compactAttributes, ReadSingleAttributeDescriptionWithoutTimestamp);
+    tcase_add_test(tc_compactAttributes, WriteSingleAttributeDisplayName);
+    tcase_add_test(tc_compactAttributes, WriteSingleAttributeDescription);
+    tcase_add_test(tc_compactAttributes, ReadWriteCompactAttributes);
+    suite_add_tcase(s, tc_compactAttributes);
+
     return s;
 }
 
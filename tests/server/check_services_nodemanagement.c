@@ -308,6 +308,78 @@ START_TEST(AddNodeTwiceGivesError) {
     ck_assert_int_eq(res, UA_STATUSCODE_BADNODEIDEXISTS);
 } END_TEST
 
+/* Several items below the same parent are added in one request. The parent
+ * has forward references to the added nodes and the nodes point back. */
+START_TEST(AddNodesBelowSameParent) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 myInteger = 42;
+    UA_Variant_setScalar(&attr.value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
+
+    UA_AddNodesItem items[4];
+    UA_NodeId ids[4] = {UA_NODEID_STRING(1, "batch.0"), UA_NODEID_STRING(1, "batch.1"),
+                        UA_NODEID_STRING(1, "batch.1"), UA_NODEID_STRING(1, "batch.3")};
+    for(size_t i = 0; i < 4; i++) {
+        UA_AddNodesItem_init(&items[i]);
+        items[i].nodeClass = UA_NODECLASS_VARIABLE;
+        items[i].requestedNewNodeId.nodeId = ids[i];
+        items[i].browseName = UA_QUALIFIEDNAME(1, "batch");
+        items[i].parentNodeId.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+        items[i].referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+        items[i].typeDefinition.nodeId =
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE);
+        UA_ExtensionObject_setValueNoDelete(&items[i].nodeAttributes, &attr,
+                                            &UA_TYPES[UA_TYPES_VARIABLEATTRIBUTES]);
+    }
+
+    UA_AddNodesRequest request;
+    UA_AddNodesRequest_init(&request);
+    request.nodesToAddSize = 4;
+    request.nodesToAdd = items;
+    UA_AddNodesResponse response;
+    UA_AddNodesResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_AddNodes(server, &server->adminSession, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+
+    /* The duplicate NodeId fails, the other items are added */
+    ck_assert_uint_eq(response.resultsSize, 4);
+    ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.results[1].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.results[2].statusCode, UA_STATUSCODE_BADNODEIDEXISTS);
+    ck_assert_uint_eq(response.results[3].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert(UA_NodeId_isNull(&response.results[2].addedNodeId));
+    UA_AddNodesResponse_clear(&response);
+
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    size_t found = 0;
+    for(size_t i = 0; i < br.referencesSize; i++) {
+        const UA_NodeId *target = &br.references[i].nodeId.nodeId;
+        if(UA_NodeId_equal(target, &ids[0]) || UA_NodeId_equal(target, &ids[1]) ||
+           UA_NodeId_equal(target, &ids[3]))
+            found++;
+    }
+    ck_assert_uint_eq(found, 3);
+    UA_BrowseResult_clear(&br);
+
+    const size_t added[3] = {0, 1, 3};
+    for(size_t i = 0; i < 3; i++) {
+        bd.nodeId = ids[added[i]];
+        bd.browseDirection = UA_BROWSEDIRECTION_INVERSE;
+        br = UA_Server_browse(server, 0, &bd);
+        ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(br.referencesSize, 1);
+        UA_NodeId objectsId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+        ck_assert(UA_NodeId_equal(&br.references[0].nodeId.nodeId, &objectsId));
+        UA_BrowseResult_clear(&br);
+    }
+} END_TEST
+
 static UA_Boolean constructorCalled = false;
 
 static UA_StatusCode
@@ -672,6 +744,7 @@ int main(void) {
     tcase_add_test(tc_addnodes, InstantiateVariableTypeNodeLessDims);
     tcase_add_test(tc_addnodes, AddComplexTypeWithInheritance);
     tcase_add_test(tc_addnodes, AddNodeTwiceGivesError);
+    tcase_add_test(tc_addnodes, AddNodesBelowSameParent);
     tcase_add_test(tc_addnodes, AddObjectWithConstructor);
     tcase_add_test(tc_addnodes, InstantiateObjectType);
     suite_add_tcase(s, tc_addnodes);
@@ -387,6 +387,8 @@ TestingPolicy(UA_SecurityPolicy *policy, UA_ByteString localCertificate,
     policy->channelModule.setRemoteSymSigningKey = setRemoteSymSigningKey_testing;
     policy->channelModule.setRemoteSymIv = setRemoteSymIv_testing;
     policy->channelModule.compareCertificate = compareCertificate_testing;
+    policy->channelModule.generateNonce = NULL;
+    policy->channelModule.generateKey = NULL;
     policy->clear = policy_clear_testing;
 
     return UA_STATUSCODE_GOOD;
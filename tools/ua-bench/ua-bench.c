@@ -0,0 +1,872 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Load generator for OPC UA servers. N client sessions are distributed over M
+ * threads. Every session issues a weighted mix of Read, Write, Browse, Call and
+ * CreateMonitoredItems requests, either back-to-back or with a target rate.
+ * Writes carry the current time as their value. Sessions that subscribe to the
+ * written variable measure the end-to-end notification latency from that
+ * embedded timestamp. The latencies are recorded in log-linear histograms (in
+ * the style of HdrHistogram) and the percentiles are reported as JSON.
+ *
+ * With the server-url "local", an in-process server is started on the loopback
+ * interface. It provides a writable DateTime variable and an echo method, so
+ * that capacity planning and regression runs are reproducible. */
+
+/* Enable POSIX features */
+#if !defined(_XOPEN_SOURCE)
+# define _XOPEN_SOURCE 600
+#endif
+#ifndef _DEFAULT_SOURCE
+# define _DEFAULT_SOURCE
+#endif
+/* On older systems we need to define _BSD_SOURCE.
+ * _DEFAULT_SOURCE is an alias for that. */
+#ifndef _BSD_SOURCE
+# define _BSD_SOURCE
+#endif
+
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+#include <open62541/network_tcp.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*************/
+/* Histogram */
+/*************/
+
+/* Values below 2^HIST_SUB_BITS are recorded exactly. Above, every power of two
+ * is split into 2^(HIST_SUB_BITS-1) linear sub-buckets. This bounds the
+ * relative error to 1/64. */
+#define HIST_SUB_BITS 7
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_SUB_HALF (HIST_SUB_COUNT / 2)
+#define HIST_BUCKETS (HIST_SUB_COUNT + (64 - HIST_SUB_BITS) * HIST_SUB_HALF)
+
+typedef struct {
+    UA_UInt64 counts[HIST_BUCKETS];
+    UA_UInt64 total;
+    UA_UInt64 min;
+    UA_UInt64 max;
+    UA_Double sum;
+} Histogram;
+
+static size_t
+histIndex(UA_UInt64 v) {
+    if(v < HIST_SUB_COUNT)
+        return (size_t)v;
+    size_t msb = 0;
+    for(UA_UInt64 x = v; x > 1; x >>= 1)
+        msb++;
+    size_t shift = msb - (HIST_SUB_BITS - 1);
+    return HIST_SUB_COUNT + (shift - 1) * HIST_SUB_HALF +
+        (size_t)((v >> shift) - HIST_SUB_HALF);
+}
+
+/* The highest value that is recorded in the same bucket */
+static UA_UInt64
+histValue(size_t index) {
+    if(index < HIST_SUB_COUNT)
+        return index;
+    size_t shift = (index - HIST_SUB_COUNT) / HIST_SUB_HALF + 1;
+    UA_UInt64 sub = (UA_UInt64)((index - HIST_SUB_COUNT) % HIST_SUB_HALF) + HIST_SUB_HALF;
+    return ((sub + 1) << shift) - 1;
+}
+
+static void
+histRecord(Histogram *h, UA_UInt64 v) {
+    h->counts[histIndex(v)]++;
+    if(h->total == 0 || v < h->min)
+        h->min = v;
+    if(v > h->max)
+        h->max = v;
+    h->total++;
+    h->sum += (UA_Double)v;
+}
+
+static void
+histMerge(Histogram *h, const Histogram *other) {
+    if(other->total == 0)
+        return;
+    for(size_t i = 0; i < HIST_BUCKETS; i++)
+        h->counts[i] += other->counts[i];
+    if(h->total == 0 || other->min < h->min)
+        h->min = other->min;
+    if(other->max > h->max)
+        h->max = other->max;
+    h->total += other->total;
+    h->sum += other->sum;
+}
+
+static UA_UInt64
+histPercentile(const Histogram *h, UA_Double percentile) {
+    if(h->total == 0)
+        return 0;
+    UA_UInt64 target = (UA_UInt64)((percentile / 100.0) * (UA_Double)h->total + 0.5);
+    if(target == 0)
+        target = 1;
+    UA_UInt64 seen = 0;
+    for(size_t i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if(seen >= target) {
+            UA_UInt64 v = histValue(i);
+            return (v > h->max) ? h->max : v;
+        }
+    }
+    return h->max;
+}
+
+static void
+histPrintJson(const Histogram *h) {
+    printf("{\"min\": %llu, \"mean\": %.1f, \"p50\": %llu, \"p90\": %llu, "
+           "\"p99\": %llu, \"p99.9\": %llu, \"p99.99\": %llu, \"max\": %llu}",
+           (unsigned long long)h->min,
+           (h->total > 0) ? h->sum / (UA_Double)h->total : 0.0,
+           (unsigned long long)histPercentile(h, 50.0),
+           (unsigned long long)histPercentile(h, 90.0),
+           (unsigned long long)histPercentile(h, 99.0),
+           (unsigned long long)histPercentile(h, 99.9),
+           (unsigned long long)histPercentile(h, 99.99),
+           (unsigned long long)h->max);
+}
+
+/*****************/
+/* Configuration */
+/*****************/
+
+typedef enum {
+    OP_READ = 0,
+    OP_WRITE,
+    OP_BROWSE,
+    OP_CALL,
+    OP_MONITOR,
+    OP_COUNT
+} Operation;
+
+static const char *opNames[OP_COUNT] = {"read", "write", "browse", "call", "monitor"};
+
+static char *url = NULL;
+static UA_UInt16 localPort = 4841;
+static size_t sessionsCount = 1;
+static size_t threadsCount = 1;
+static UA_Double duration = 10.0;   /* seconds */
+static UA_Double rate = 0.0;        /* requests per second and session, 0 for
+                                     * back-to-back requests */
+static UA_UInt32 weights[OP_COUNT] = {100, 0, 0, 0, 0};
+static UA_Boolean subscribe = false;
+static UA_Double publishingInterval = 50.0; /* ms */
+static UA_Boolean verbose = false;
+static const char *captureFile = NULL;
+
+static UA_NodeId readNode;
+static UA_NodeId writeNode;
+static UA_NodeId browseNode;
+static UA_NodeId callObject;
+static UA_NodeId callMethod;
+
+static void
+usage(void) {
+    printf("Usage: ua-bench <server-url | local> [options]\n"
+           " <server-url>: opc.tcp://domain[:port]\n"
+           " local: Start an in-process server on the loopback interface\n"
+           " --port <port>: Port of the local server [default: 4841]\n"
+           " --sessions <n>: Number of client sessions [default: 1]\n"
+           " --threads <m>: Number of threads driving the sessions [default: 1]\n"
+           " --duration <s>: Duration of the measurement in seconds [default: 10]\n"
+           " --rate <r>: Target requests per second and session. "
+           "0 sends back-to-back [default: 0]\n"
+           " --mix <op=weight,...>: Weighted mix of read, write, browse, call and "
+           "monitor (CreateMonitoredItems) [default: read=100]\n"
+           " --read-node <nodeid>: [default: i=2258, local: ns=1;s=bench.value]\n"
+           " --write-node <nodeid>: DateTime variable [local: ns=1;s=bench.value]\n"
+           " --browse-node <nodeid>: [default: i=85]\n"
+           " --call-object <nodeid> --call-method <nodeid>: Method with one "
+           "DateTime input argument [local: i=85 and ns=1;s=bench.echo]\n"
+           " --subscribe: Every session monitors the write-node to measure the "
+           "notification throughput and end-to-end latency\n"
+           " --publishing-interval <ms>: [default: 50]\n"
+           " --capture <file>: Record the traffic of the local server for "
+           "ua-replay (requires UA_DEBUG_CAPTURE_PKGS)\n"
+           " --verbose: Do not silence the log output\n"
+           " --help: Print this message\n"
+           "The latencies are reported in microseconds as JSON on stdout.\n");
+}
+
+static int
+parseNodeIdArg(const char *arg, UA_NodeId *out) {
+    UA_NodeId_clear(out);
+    UA_StatusCode res = UA_NodeId_parse(out, UA_STRING((char*)(uintptr_t)arg));
+    if(res != UA_STATUSCODE_GOOD) {
+        fprintf(stderr, "Could not parse the NodeId %s\n", arg);
+        return -1;
+    }
+    return 0;
+}
+
+static int
+parseMix(char *mix) {
+    memset(weights, 0, sizeof(weights));
+    while(mix && *mix) {
+        char *next = strchr(mix, ',');
+        if(next)
+            *next++ = 0;
+        char *eq = strchr(mix, '=');
+        if(!eq)
+            return -1;
+        *eq = 0;
+        size_t op = 0;
+        for(; op < OP_COUNT; op++) {
+            if(strcmp(mix, opNames[op]) == 0)
+                break;
+        }
+        if(op == OP_COUNT)
+            return -1;
+        weights[op] = (UA_UInt32)strtoul(eq + 1, NULL, 10);
+        mix = next;
+    }
+    UA_UInt32 total = 0;
+    for(size_t op = 0; op < OP_COUNT; op++)
+        total += weights[op];
+    return (total > 0) ? 0 : -1;
+}
+
+/* Keep stdout clean for the JSON report */
+static void
+quietLog(void *context, UA_LogLevel level, UA_LogCategory category,
+         const char *msg, va_list args) {
+    (void)context, (void)level, (void)category, (void)msg, (void)args;
+}
+
+static const UA_Logger quietLogger = {quietLog, NULL, NULL};
+
+/****************/
+/* Local Server */
+/****************/
+
+static UA_Server *server = NULL;
+static volatile UA_Boolean serverRunning = false;
+static pthread_t serverThread;
+
+#ifdef UA_ENABLE_METHODCALLS
+static UA_StatusCode
+echoMethod(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+           const UA_NodeId *methodId, void *methodContext,
+           const UA_NodeId *objectId, void *objectContext,
+           size_t inputSize, const UA_Variant *input,
+           size_t outputSize, UA_Variant *output) {
+    (void)s, (void)sessionId, (void)sessionContext, (void)methodId;
+    (void)methodContext, (void)objectId, (void)objectContext;
+    if(inputSize != 1 || outputSize != 1)
+        return UA_STATUSCODE_BADARGUMENTSMISSING;
+    return UA_Variant_copy(input, output);
+}
+#endif
+
+static void *
+serverLoop(void *data) {
+    (void)data;
+    while(serverRunning)
+        UA_Server_run_iterate(server, true);
+    return NULL;
+}
+
+static int
+startLocalServer(void) {
+    server = UA_Server_new();
+    if(!server)
+        return -1;
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    if(!verbose)
+        config->logger = quietLogger; /* Retained by the default config */
+    UA_ServerConfig_setMinimal(config, localPort, NULL);
+    config->maxSecureChannels = (UA_UInt16)(sessionsCount + 10);
+    config->maxSessions = (UA_UInt16)(sessionsCount + 10);
+
+    /* The written (and monitored) DateTime variable */
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    UA_DateTime now = UA_DateTime_now();
+    UA_Variant_setScalar(&vattr.value, &now, &UA_TYPES[UA_TYPES_DATETIME]);
+    vattr.dataType = UA_TYPES[UA_TYPES_DATETIME].typeId;
+    vattr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    vattr.displayName = UA_LOCALIZEDTEXT("en-US", "bench.value");
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, UA_NODEID_STRING(1, "bench.value"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "bench.value"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  vattr, NULL, NULL);
+
+#ifdef UA_ENABLE_METHODCALLS
+    /* The echo method */
+    UA_Argument arg;
+    UA_Argument_init(&arg);
+    arg.name = UA_STRING("value");
+    arg.dataType = UA_TYPES[UA_TYPES_DATETIME].typeId;
+    arg.valueRank = UA_VALUERANK_SCALAR;
+    UA_MethodAttributes mattr = UA_MethodAttributes_default;
+    mattr.displayName = UA_LOCALIZEDTEXT("en-US", "bench.echo");
+    mattr.executable = true;
+    mattr.userExecutable = true;
+    res |= UA_Server_addMethodNode(server, UA_NODEID_STRING(1, "bench.echo"),
+                                   UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                   UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                   UA_QUALIFIEDNAME(1, "bench.echo"), mattr,
+                                   echoMethod, 1, &arg, 1, &arg, NULL, NULL);
+#endif
+
+#ifdef UA_DEBUG_CAPTURE_PKGS
+    if(captureFile && config->networkLayersSize > 0)
+        res |= UA_ServerNetworkLayerTCP_capture(&config->networkLayers[0], captureFile);
+#endif
+
+    res |= UA_Server_run_startup(server);
+    if(res != UA_STATUSCODE_GOOD) {
+        fprintf(stderr, "Could not start the local server: %s\n",
+                UA_StatusCode_name(res));
+        UA_Server_delete(server);
+        server = NULL;
+        return -1;
+    }
+
+    serverRunning = true;
+    if(pthread_create(&serverThread, NULL, serverLoop, NULL) != 0) {
+        serverRunning = false;
+        UA_Server_run_shutdown(server);
+        UA_Server_delete(server);
+        server = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static void
+stopLocalServer(void) {
+    if(!server)
+        return;
+    serverRunning = false;
+    pthread_join(serverThread, NULL);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+    server = NULL;
+}
+
+/***********/
+/* Workers */
+/***********/
+
+struct Worker;
+
+typedef struct {
+    UA_Client *client;
+    UA_UInt32 subscriptionId; /* 0 if none */
+    UA_DateTime nextDue;      /* Monotonic time of the next request */
+    struct Worker *worker;
+} Session;
+
+typedef struct Worker {
+    pthread_t thread;
+    Session *sessions;
+    size_t sessionsSize;
+    UA_UInt64 rng;
+    Histogram latency[OP_COUNT];
+    UA_UInt64 errors[OP_COUNT];
+    Histogram notification;
+} Worker;
+
+static UA_DateTime benchStart;  /* Monotonic */
+static UA_DateTime benchStartWall;
+static UA_UInt32 weightsTotal;
+
+static UA_UInt64
+nextRandom(Worker *w) {
+    /* xorshift64 */
+    w->rng ^= w->rng << 13;
+    w->rng ^= w->rng >> 7;
+    w->rng ^= w->rng << 17;
+    return w->rng;
+}
+
+static Operation
+pickOperation(Worker *w) {
+    UA_UInt32 r = (UA_UInt32)(nextRandom(w) % weightsTotal);
+    for(size_t op = 0; op < OP_COUNT; op++) {
+        if(r < weights[op])
+            return (Operation)op;
+        r -= weights[op];
+    }
+    return OP_READ;
+}
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+static void
+notificationCallback(UA_Client *client, UA_UInt32 subId, void *subContext,
+                     UA_UInt32 monId, void *monContext, UA_DataValue *value) {
+    (void)client, (void)subId, (void)subContext, (void)monId;
+    Worker *w = (Worker*)monContext;
+    if(!value->hasValue ||
+       !UA_Variant_hasScalarType(&value->value, &UA_TYPES[UA_TYPES_DATETIME]))
+        return;
+    /* Skip the initial value and values written before the start */
+    UA_DateTime sent = *(UA_DateTime*)value->value.data;
+    if(sent < benchStartWall)
+        return;
+    UA_DateTime now = UA_DateTime_now();
+    histRecord(&w->notification,
+               (now > sent) ? (UA_UInt64)((now - sent) / UA_DATETIME_USEC) : 0);
+}
+
+static void
+ignoreCallback(UA_Client *client, UA_UInt32 subId, void *subContext,
+               UA_UInt32 monId, void *monContext, UA_DataValue *value) {
+    (void)client, (void)subId, (void)subContext;
+    (void)monId, (void)monContext, (void)value;
+}
+#endif
+
+/* Sets *done when the measured part of the operation has finished */
+static UA_StatusCode
+runOperation(Session *s, Operation op, UA_DateTime *done) {
+    UA_Client *client = s->client;
+    switch(op) {
+    case OP_READ: {
+        UA_Variant v;
+        UA_Variant_init(&v);
+        UA_StatusCode res = UA_Client_readValueAttribute(client, readNode, &v);
+        UA_Variant_clear(&v);
+        return res;
+    }
+    case OP_WRITE: {
+        UA_DateTime now = UA_DateTime_now();
+        UA_Variant v;
+        UA_Variant_setScalar(&v, &now, &UA_TYPES[UA_TYPES_DATETIME]);
+        return UA_Client_writeValueAttribute(client, writeNode, &v);
+    }
+    case OP_BROWSE: {
+        UA_BrowseDescription bd;
+        UA_BrowseDescription_init(&bd);
+        bd.nodeId = browseNode;
+        bd.browseDirection = UA_BROWSEDIRECTION_BOTH;
+        bd.includeSubtypes = true;
+        bd.resultMask = UA_BROWSERESULTMASK_ALL;
+        UA_BrowseRequest req;
+        UA_BrowseRequest_init(&req);
+        req.nodesToBrowse = &bd;
+        req.nodesToBrowseSize = 1;
+        UA_BrowseResponse resp = UA_Client_Service_browse(client, req);
+        UA_StatusCode res = resp.responseHeader.serviceResult;
+        if(res == UA_STATUSCODE_GOOD && resp.resultsSize == 1)
+            res = resp.results[0].statusCode;
+        UA_BrowseResponse_clear(&resp);
+        return res;
+    }
+#ifdef UA_ENABLE_METHODCALLS
+    case OP_CALL: {
+        UA_DateTime now = UA_DateTime_now();
+        UA_Variant input;
+        UA_Variant_setScalar(&input, &now, &UA_TYPES[UA_TYPES_DATETIME]);
+        size_t outputSize = 0;
+        UA_Variant *output = NULL;
+        UA_StatusCode res = UA_Client_call(client, callObject, callMethod,
+                                           1, &input, &outputSize, &output);
+        UA_Array_delete(output, outputSize, &UA_TYPES[UA_TYPES_VARIANT]);
+        return res;
+    }
+#endif
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    case OP_MONITOR: {
+        /* Only the creation is measured. The MonitoredItem is removed right
+         * away so that the server state does not grow. */
+        UA_MonitoredItemCreateRequest item = UA_MonitoredItemCreateRequest_default(readNode);
+        UA_MonitoredItemCreateResult result =
+            UA_Client_MonitoredItems_createDataChange(client, s->subscriptionId,
+                                                      UA_TIMESTAMPSTORETURN_BOTH,
+                                                      item, NULL, ignoreCallback, NULL);
+        UA_StatusCode res = result.statusCode;
+        UA_UInt32 monId = result.monitoredItemId;
+        UA_MonitoredItemCreateResult_clear(&result);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        *done = UA_DateTime_nowMonotonic();
+        UA_Client_MonitoredItems_deleteSingle(client, s->subscriptionId, monId);
+        return UA_STATUSCODE_GOOD;
+    }
+#endif
+    default:
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+}
+
+static void *
+workerLoop(void *data) {
+    Worker *w = (Worker*)data;
+    UA_DateTime end = benchStart + (UA_DateTime)(duration * UA_DATETIME_SEC);
+    UA_DateTime interval = (rate > 0.0) ? (UA_DateTime)(UA_DATETIME_SEC / rate) : 0;
+    for(size_t i = 0; i < w->sessionsSize; i++)
+        w->sessions[i].nextDue = benchStart;
+
+    while(true) {
+        UA_DateTime now = UA_DateTime_nowMonotonic();
+        if(now >= end)
+            break;
+
+        /* Issue the requests that are due. With a target rate, the latency is
+         * measured from the intended start. So a stalled server cannot hide
+         * its queueing delay (coordinated omission). */
+        UA_DateTime nextDue = end;
+        for(size_t i = 0; i < w->sessionsSize; i++) {
+            Session *s = &w->sessions[i];
+            if(interval > 0 && now < s->nextDue) {
+                if(s->nextDue < nextDue)
+                    nextDue = s->nextDue;
+                continue;
+            }
+            UA_DateTime start = (interval > 0) ? s->nextDue : now;
+            Operation op = pickOperation(w);
+            UA_DateTime done = 0;
+            UA_StatusCode res = runOperation(s, op, &done);
+            now = UA_DateTime_nowMonotonic();
+            if(done == 0)
+                done = now;
+            histRecord(&w->latency[op], (UA_UInt64)((done - start) / UA_DATETIME_USEC));
+            if(res != UA_STATUSCODE_GOOD)
+                w->errors[op]++;
+            if(interval > 0) {
+                s->nextDue += interval;
+                if(s->nextDue < nextDue)
+                    nextDue = s->nextDue;
+            } else {
+                nextDue = now;
+            }
+        }
+
+        /* Receive the notifications */
+        for(size_t i = 0; i < w->sessionsSize; i++)
+            UA_Client_run_iterate(w->sessions[i].client, 0);
+
+        /* Sleep until the next request is due. At most 1ms to keep receiving
+         * the notifications. */
+        now = UA_DateTime_nowMonotonic();
+        if(nextDue > now) {
+            UA_DateTime wait = nextDue - now;
+            if(wait > UA_DATETIME_MSEC)
+                wait = UA_DATETIME_MSEC;
+            struct timespec ts = {0, (long)(wait * 100)};
+            nanosleep(&ts, NULL);
+        }
+    }
+    return NULL;
+}
+
+static int
+connectSession(Session *s) {
+    s->client = UA_Client_new();
+    if(!s->client)
+        return -1;
+    UA_ClientConfig *cc = UA_Client_getConfig(s->client);
+    if(!verbose)
+        cc->logger = quietLogger;
+    UA_ClientConfig_setDefault(cc);
+    UA_StatusCode res = UA_Client_connect(s->client, url);
+    if(res != UA_STATUSCODE_GOOD) {
+        fprintf(stderr, "Could not connect to %s: %s\n", url, UA_StatusCode_name(res));
+        return -1;
+    }
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    if(!subscribe && weights[OP_MONITOR] == 0)
+        return 0;
+    UA_CreateSubscriptionRequest req = UA_CreateSubscriptionRequest_default();
+    req.requestedPublishingInterval = publishingInterval;
+    UA_CreateSubscriptionResponse resp =
+        UA_Client_Subscriptions_create(s->client, req, NULL, NULL, NULL);
+    res = resp.responseHeader.serviceResult;
+    s->subscriptionId = resp.subscriptionId;
+    UA_CreateSubscriptionResponse_clear(&resp);
+    if(res != UA_STATUSCODE_GOOD) {
+        fprintf(stderr, "Could not create a subscription: %s\n", UA_StatusCode_name(res));
+        return -1;
+    }
+    if(!subscribe)
+        return 0;
+    UA_MonitoredItemCreateRequest item = UA_MonitoredItemCreateRequest_default(writeNode);
+    item.requestedParameters.samplingInterval = 0.0; /* fastest */
+    item.requestedParameters.queueSize = 100;
+    UA_MonitoredItemCreateResult result =
+        UA_Client_MonitoredItems_createDataChange(s->client, s->subscriptionId,
+                                                  UA_TIMESTAMPSTORETURN_BOTH, item,
+                                                  s->worker, notificationCallback, NULL);
+    res = result.statusCode;
+    UA_MonitoredItemCreateResult_clear(&result);
+    if(res != UA_STATUSCODE_GOOD) {
+        fprintf(stderr, "Could not monitor the write-node: %s\n", UA_StatusCode_name(res));
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+/**********/
+/* Report */
+/**********/
+
+static void
+printReport(Worker *workers, UA_Double elapsed) {
+    Histogram *h = (Histogram*)UA_calloc(1, sizeof(Histogram));
+    Histogram *all = (Histogram*)UA_calloc(1, sizeof(Histogram));
+    if(!h || !all) {
+        UA_free(h);
+        UA_free(all);
+        return;
+    }
+
+    printf("{\n  \"config\": {\"url\": \"%s\", \"sessions\": %lu, \"threads\": %lu, "
+           "\"duration\": %.1f, \"rate\": %.1f, \"subscribe\": %s, \"mix\": {",
+           url, (unsigned long)sessionsCount, (unsigned long)threadsCount,
+           duration, rate, subscribe ? "true" : "false");
+    for(size_t op = 0; op < OP_COUNT; op++)
+        printf("%s\"%s\": %u", (op > 0) ? ", " : "", opNames[op], weights[op]);
+    printf("}},\n  \"elapsed\": %.3f,\n  \"operations\": {", elapsed);
+
+    UA_UInt64 allErrors = 0;
+    UA_Boolean first = true;
+    for(size_t op = 0; op < OP_COUNT; op++) {
+        if(weights[op] == 0)
+            continue;
+        memset(h, 0, sizeof(Histogram));
+        UA_UInt64 errors = 0;
+        for(size_t t = 0; t < threadsCount; t++) {
+            histMerge(h, &workers[t].latency[op]);
+            errors += workers[t].errors[op];
+        }
+        histMerge(all, h);
+        allErrors += errors;
+        printf("%s\n    \"%s\": {\"count\": %llu, \"errors\": %llu, \"rate\": %.1f, "
+               "\"latency_us\": ", first ? "" : ",", opNames[op],
+               (unsigned long long)h->total, (unsigned long long)errors,
+               (UA_Double)h->total / elapsed);
+        histPrintJson(h);
+        printf("}");
+        first = false;
+    }
+    printf("\n  },\n  \"total\": {\"count\": %llu, \"errors\": %llu, \"rate\": %.1f, "
+           "\"latency_us\": ", (unsigned long long)all->total,
+           (unsigned long long)allErrors, (UA_Double)all->total / elapsed);
+    histPrintJson(all);
+    printf("}");
+
+    if(subscribe) {
+        memset(h, 0, sizeof(Histogram));
+        for(size_t t = 0; t < threadsCount; t++)
+            histMerge(h, &workers[t].notification);
+        printf(",\n  \"notifications\": {\"count\": %llu, \"rate\": %.1f, "
+               "\"latency_us\": ", (unsigned long long)h->total,
+               (UA_Double)h->total / elapsed);
+        histPrintJson(h);
+        printf("}");
+    }
+    printf("\n}\n");
+
+    UA_free(h);
+    UA_free(all);
+}
+
+/********/
+/* Main */
+/********/
+
+int
+main(int argc, char **argv) {
+    if(argc < 2 || strcmp(argv[1], "--help") == 0) {
+        usage();
+        return 0;
+    }
+    url = argv[1];
+    UA_Boolean local = (strcmp(url, "local") == 0);
+
+    readNode = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+    browseNode = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    if(local) {
+        readNode = UA_NODEID_STRING_ALLOC(1, "bench.value");
+        writeNode = UA_NODEID_STRING_ALLOC(1, "bench.value");
+        callObject = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+        callMethod = UA_NODEID_STRING_ALLOC(1, "bench.echo");
+    }
+
+    /* Parse the options */
+    int ret = 0;
+    for(int argpos = 2; argpos < argc && ret == 0; argpos++) {
+        const char *opt = argv[argpos];
+        if(strcmp(opt, "--help") == 0) {
+            usage();
+            return 0;
+        }
+        if(strcmp(opt, "--subscribe") == 0) {
+            subscribe = true;
+            continue;
+        }
+        if(strcmp(opt, "--verbose") == 0) {
+            verbose = true;
+            continue;
+        }
+        /* Options with an argument */
+        if(argpos + 1 == argc) {
+            ret = -1;
+            break;
+        }
+        char *arg = argv[++argpos];
+        if(strcmp(opt, "--port") == 0)
+            localPort = (UA_UInt16)atoi(arg);
+        else if(strcmp(opt, "--sessions") == 0)
+            sessionsCount = (size_t)strtoul(arg, NULL, 10);
+        else if(strcmp(opt, "--threads") == 0)
+            threadsCount = (size_t)strtoul(arg, NULL, 10);
+        else if(strcmp(opt, "--duration") == 0)
+            duration = atof(arg);
+        else if(strcmp(opt, "--rate") == 0)
+            rate = atof(arg);
+        else if(strcmp(opt, "--publishing-interval") == 0)
+            publishingInterval = atof(arg);
+        else if(strcmp(opt, "--mix") == 0)
+            ret = parseMix(arg);
+        else if(strcmp(opt, "--read-node") == 0)
+            ret = parseNodeIdArg(arg, &readNode);
+        else if(strcmp(opt, "--write-node") == 0)
+            ret = parseNodeIdArg(arg, &writeNode);
+        else if(strcmp(opt, "--browse-node") == 0)
+            ret = parseNodeIdArg(arg, &browseNode);
+        else if(strcmp(opt, "--call-object") == 0)
+            ret = parseNodeIdArg(arg, &callObject);
+        else if(strcmp(opt, "--call-method") == 0)
+            ret = parseNodeIdArg(arg, &callMethod);
+        else if(strcmp(opt, "--capture") == 0)
+            captureFile = arg;
+        else
+            ret = -1;
+    }
+    if(ret != 0 || sessionsCount == 0 || threadsCount == 0 || duration <= 0.0) {
+        usage();
+        return -1;
+    }
+    if(threadsCount > sessionsCount)
+        threadsCount = sessionsCount;
+
+    /* Check that the configured operations have their target nodes */
+    if((weights[OP_WRITE] > 0 || subscribe) && UA_NodeId_isNull(&writeNode)) {
+        fprintf(stderr, "Writes and --subscribe require the --write-node\n");
+        return -1;
+    }
+    if(weights[OP_CALL] > 0 && UA_NodeId_isNull(&callMethod)) {
+        fprintf(stderr, "Calls require the --call-object and --call-method\n");
+        return -1;
+    }
+    if(captureFile && !local) {
+        fprintf(stderr, "Only the local server can be captured\n");
+        return -1;
+    }
+#ifndef UA_DEBUG_CAPTURE_PKGS
+    if(captureFile) {
+        fprintf(stderr, "Capturing is not enabled in the build\n");
+        return -1;
+    }
+#endif
+#ifndef UA_ENABLE_METHODCALLS
+    if(weights[OP_CALL] > 0) {
+        fprintf(stderr, "Method calls are not enabled in the build\n");
+        return -1;
+    }
+#endif
+#ifndef UA_ENABLE_SUBSCRIPTIONS
+    if(weights[OP_MONITOR] > 0 || subscribe) {
+        fprintf(stderr, "Subscriptions are not enabled in the build\n");
+        return -1;
+    }
+#endif
+    weightsTotal = 0;
+    for(size_t op = 0; op < OP_COUNT; op++)
+        weightsTotal += weights[op];
+
+    /* Start the local server */
+    char localUrl[64];
+    if(local) {
+        snprintf(localUrl, sizeof(localUrl), "opc.tcp://127.0.0.1:%u",
+                 (unsigned)localPort);
+        url = localUrl;
+        if(startLocalServer() != 0)
+            return -1;
+    }
+
+    /* Distribute the sessions round-robin over the workers and connect */
+    Worker *workers = (Worker*)UA_calloc(threadsCount, sizeof(Worker));
+    Session *sessions = (Session*)UA_calloc(sessionsCount, sizeof(Session));
+    if(!workers || !sessions) {
+        ret = -1;
+        goto cleanup;
+    }
+    size_t pos = 0;
+    for(size_t t = 0; t < threadsCount; t++) {
+        Worker *w = &workers[t];
+        w->rng = 0x9E3779B97F4A7C15ULL * (t + 1);
+        w->sessions = &sessions[pos];
+        w->sessionsSize = sessionsCount / threadsCount +
+            ((t < sessionsCount % threadsCount) ? 1 : 0);
+        for(size_t i = 0; i < w->sessionsSize; i++)
+            sessions[pos + i].worker = w;
+        pos += w->sessionsSize;
+    }
+    for(size_t i = 0; i < sessionsCount && ret == 0; i++)
+        ret = connectSession(&sessions[i]);
+    if(ret != 0)
+        goto cleanup;
+
+    /* Run the workers */
+    benchStart = UA_DateTime_nowMonotonic();
+    benchStartWall = UA_DateTime_now();
+    size_t started = 0;
+    for(; started < threadsCount; started++) {
+        if(pthread_create(&workers[started].thread, NULL,
+                          workerLoop, &workers[started]) != 0)
+            break;
+    }
+    for(size_t t = 0; t < started; t++)
+        pthread_join(workers[t].thread, NULL);
+    UA_Double elapsed =
+        (UA_Double)(UA_DateTime_nowMonotonic() - benchStart) / UA_DATETIME_SEC;
+    if(started < threadsCount) {
+        fprintf(stderr, "Could not start the worker threads\n");
+        ret = -1;
+        goto cleanup;
+    }
+
+    printReport(workers, elapsed);
+
+ cleanup:
+    if(sessions) {
+        for(size_t i = 0; i < sessionsCount; i++) {
+            if(!sessions[i].client)
+                continue;
+            UA_Client_disconnect(sessions[i].client);
+            UA_Client_delete(sessions[i].client);
+        }
+    }
+    UA_free(sessions);
+    UA_free(workers);
+    stopLocalServer();
+    UA_NodeId_clear(&readNode);
+    UA_NodeId_clear(&writeNode);
+    UA_NodeId_clear(&browseNode);
+    UA_NodeId_clear(&callObject);
+    UA_NodeId_clear(&callMethod);
+    return ret;
+}
@@ -0,0 +1,1145 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Replays the client traffic from a capture file (see
+ * UA_ServerNetworkLayerTCP_capture) against a server. The recorded requests are
+ * sent at the original pace (optionally scaled) or as fast as possible. The
+ * response latencies of the replay are compared with the latencies in the
+ * capture and reported as JSON. Note that the captured latencies are taken in
+ * the server network layer (from receiving the request to sending the
+ * response), whereas the replay measures the round-trip time at the client.
+ *
+ * The server assigns new SecureChannel ids, token ids and session
+ * authentication tokens. They are taken from the live responses and rewritten
+ * in the replayed requests. Other server-assigned handles (e.g. subscription
+ * ids) are not rewritten. They are usually the same when replaying against a
+ * freshly started server. Only captures with SecurityPolicy#None can be
+ * replayed. */
+
+/* Enable POSIX features */
+#if !defined(_XOPEN_SOURCE)
+# define _XOPEN_SOURCE 600
+#endif
+#ifndef _DEFAULT_SOURCE
+# define _DEFAULT_SOURCE
+#endif
+/* On older systems we need to define _BSD_SOURCE.
+ * _DEFAULT_SOURCE is an alias for that. */
+#ifndef _BSD_SOURCE
+# define _BSD_SOURCE
+#endif
+
+#include <open62541/network_tcp.h>
+#include <open62541/plugin/securitypolicy.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/types.h>
+#include <open62541/types_generated_handling.h>
+#include <open62541/util.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* Internal headers */
+#include "ua_types_encoding_binary.h"
+
+#define WAIT_TIMEOUT (5 * UA_DATETIME_SEC) /* For responses we depend on */
+#define REQUEST_HASH_SIZE 65536
+#define UNKNOWN_TYPE UA_TYPES_COUNT
+
+static UA_Double speed = 1.0;
+static UA_Boolean fast = false;
+static UA_UInt16 localPort = 4842;
+static UA_Boolean verbose = false;
+
+/**********/
+/* Buffer */
+/**********/
+
+typedef struct {
+    UA_Byte *data;
+    size_t length;
+    size_t size;
+} Buffer;
+
+static int
+Buffer_append(Buffer *b, const UA_Byte *data, size_t length) {
+    if(b->length + length > b->size) {
+        size_t newSize = (b->size > 0) ? b->size : 4096;
+        while(newSize < b->length + length)
+            newSize *= 2;
+        UA_Byte *r = (UA_Byte*)realloc(b->data, newSize);
+        if(!r)
+            return -1;
+        b->data = r;
+        b->size = newSize;
+    }
+    memcpy(&b->data[b->length], data, length);
+    b->length += length;
+    return 0;
+}
+
+static void
+Buffer_consume(Buffer *b, size_t length) {
+    memmove(b->data, &b->data[length], b->length - length);
+    b->length -= length;
+}
+
+static UA_UInt32
+readUInt32(const UA_Byte *p) {
+    return (UA_UInt32)p[3] << 24 | (UA_UInt32)p[2] << 16 |
+        (UA_UInt32)p[1] << 8 | (UA_UInt32)p[0];
+}
+
+static void
+writeUInt32(UA_Byte *p, UA_UInt32 v) {
+    p[0] = (UA_Byte)v;
+    p[1] = (UA_Byte)(v >> 8);
+    p[2] = (UA_Byte)(v >> 16);
+    p[3] = (UA_Byte)(v >> 24);
+}
+
+static UA_Int64
+readInt64(const UA_Byte *p) {
+    return (UA_Int64)((UA_UInt64)readUInt32(p) | (UA_UInt64)readUInt32(&p[4]) << 32);
+}
+
+/**********/
+/* Chunks */
+/**********/
+
+/* Returns the length of the first complete chunk in the buffer or 0 */
+static size_t
+completeChunk(const Buffer *b) {
+    if(b->length < 8)
+        return 0;
+    size_t length = readUInt32(&b->data[4]);
+    if(length < 8 || length > b->length)
+        return 0;
+    return length;
+}
+
+static UA_Boolean
+isMessageType(const UA_ByteString *chunk, const char *type) {
+    return memcmp(chunk->data, type, 3) == 0;
+}
+
+static UA_Boolean
+skipString(const UA_ByteString *chunk, size_t *pos) {
+    if(*pos + 4 > chunk->length)
+        return false;
+    UA_Int32 len = (UA_Int32)readUInt32(&chunk->data[*pos]);
+    *pos += 4;
+    if(len <= 0)
+        return true;
+    if(*pos + (size_t)len > chunk->length)
+        return false;
+    *pos += (size_t)len;
+    return true;
+}
+
+/* Find the requestId and the start of the body in MSG, OPN and CLO chunks */
+static UA_Boolean
+chunkBody(const UA_ByteString *chunk, UA_UInt32 *requestId, size_t *body) {
+    size_t pos;
+    if(isMessageType(chunk, "OPN")) {
+        pos = 12;
+        if(!skipString(chunk, &pos) || !skipString(chunk, &pos) ||
+           !skipString(chunk, &pos))
+            return false;
+    } else if(isMessageType(chunk, "MSG") || isMessageType(chunk, "CLO")) {
+        pos = 16;
+    } else {
+        return false;
+    }
+    if(pos + 8 > chunk->length)
+        return false;
+    *requestId = readUInt32(&chunk->data[pos + 4]);
+    *body = pos + 8;
+    return true;
+}
+
+static UA_Boolean
+isSecurityPolicyNone(const UA_ByteString *chunk) {
+    if(chunk->length < 16)
+        return false;
+    UA_Int32 len = (UA_Int32)readUInt32(&chunk->data[12]);
+    if(len < 0 || 16 + (size_t)len > chunk->length)
+        return false;
+    UA_ByteString uri = {(size_t)len, &chunk->data[16]};
+    return UA_ByteString_equal(&uri, &UA_SECURITY_POLICY_NONE_URI);
+}
+
+static size_t
+findType(const UA_NodeId *encodingId) {
+    for(size_t i = 0; i < UA_TYPES_COUNT; i++) {
+        if(UA_NodeId_equal(&UA_TYPES[i].binaryEncodingId, encodingId))
+            return i;
+    }
+    return UNKNOWN_TYPE;
+}
+
+/* Decode the message type at the start of the body */
+static size_t
+bodyType(const UA_ByteString *chunk, size_t *pos) {
+    UA_NodeId id;
+    if(UA_decodeBinaryInternal(chunk, pos, &id, &UA_TYPES[UA_TYPES_NODEID],
+                               NULL) != UA_STATUSCODE_GOOD)
+        return UNKNOWN_TYPE;
+    size_t type = findType(&id);
+    UA_NodeId_clear(&id);
+    return type;
+}
+
+/* The serviceResult is the third field of the ResponseHeader */
+static UA_Boolean
+responseIsBad(const UA_ByteString *chunk, size_t pos, size_t type) {
+    if(type == UA_TYPES_SERVICEFAULT)
+        return true;
+    if(pos + 16 > chunk->length)
+        return false;
+    return (readUInt32(&chunk->data[pos + 12]) & 0x80000000) != 0;
+}
+
+/*************/
+/* Latencies */
+/*************/
+
+typedef struct {
+    UA_Double *values; /* microseconds */
+    size_t size;
+    size_t capacity;
+    size_t errors;
+} Samples;
+
+typedef struct {
+    Samples captured;
+    Samples replayed;
+    size_t lost;       /* No response in the replay */
+} ServiceStats;
+
+static ServiceStats stats[UNKNOWN_TYPE + 1];
+
+static void
+Samples_add(Samples *s, UA_DateTime latency) {
+    if(s->size == s->capacity) {
+        size_t capacity = (s->capacity > 0) ? s->capacity * 2 : 64;
+        UA_Double *r = (UA_Double*)realloc(s->values, capacity * sizeof(UA_Double));
+        if(!r)
+            return;
+        s->values = r;
+        s->capacity = capacity;
+    }
+    s->values[s->size++] = (UA_Double)latency / (UA_Double)UA_DATETIME_USEC;
+}
+
+static int
+compareDouble(const void *a, const void *b) {
+    UA_Double x = *(const UA_Double*)a;
+    UA_Double y = *(const UA_Double*)b;
+    return (x > y) - (x < y);
+}
+
+static UA_Double
+percentile(const Samples *s, UA_Double p) {
+    if(s->size == 0)
+        return 0.0;
+    size_t index = (size_t)((p / 100.0) * (UA_Double)(s->size - 1) + 0.5);
+    return s->values[index];
+}
+
+static void
+printSamples(Samples *s) {
+    qsort(s->values, s->size, sizeof(UA_Double), compareDouble);
+    UA_Double sum = 0.0;
+    for(size_t i = 0; i < s->size; i++)
+        sum += s->values[i];
+    printf("{\"count\": %lu, \"errors\": %lu, \"mean\": %.1f, \"p50\": %.1f, "
+           "\"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f}",
+           (unsigned long)s->size, (unsigned long)s->errors,
+           (s->size > 0) ? sum / (UA_Double)s->size : 0.0,
+           percentile(s, 50.0), percentile(s, 90.0), percentile(s, 99.0),
+           (s->size > 0) ? s->values[s->size - 1] : 0.0);
+}
+
+/************/
+/* Requests */
+/************/
+
+/* A request is tracked until both the captured and the live response are
+ * seen. The responses of OpenSecureChannel and CreateSession carry the values
+ * that need to be rewritten. */
+typedef struct Request {
+    struct Request *next;
+    UA_UInt64 key;      /* connection << 32 | requestId */
+    size_t type;
+    UA_DateTime capturedAt;
+    UA_DateTime sentAt;
+    UA_Boolean haveCaptured;
+    UA_Boolean haveLive;
+    UA_Boolean sent;
+
+    UA_UInt32 oldChannelId;
+    UA_UInt32 oldTokenId;
+    UA_UInt32 newChannelId;
+    UA_UInt32 newTokenId;
+    UA_NodeId oldAuthToken;
+    UA_NodeId newAuthToken;
+} Request;
+
+static Request *requests[REQUEST_HASH_SIZE];
+
+static Request *
+findRequest(UA_UInt32 connection, UA_UInt32 requestId, UA_Boolean create) {
+    UA_UInt64 key = (UA_UInt64)connection << 32 | requestId;
+    Request **bucket = &requests[(key * 0x9E3779B97F4A7C15ULL) >> 48];
+    for(Request *r = *bucket; r; r = r->next) {
+        if(r->key == key)
+            return r;
+    }
+    if(!create)
+        return NULL;
+    Request *r = (Request*)calloc(1, sizeof(Request));
+    if(!r)
+        return NULL;
+    r->key = key;
+    r->type = UNKNOWN_TYPE;
+    r->next = *bucket;
+    *bucket = r;
+    return r;
+}
+
+static void
+removeRequest(Request *r) {
+    Request **bucket = &requests[(r->key * 0x9E3779B97F4A7C15ULL) >> 48];
+    while(*bucket != r)
+        bucket = &(*bucket)->next;
+    *bucket = r->next;
+    UA_NodeId_clear(&r->oldAuthToken);
+    UA_NodeId_clear(&r->newAuthToken);
+    free(r);
+}
+
+/***************/
+/* Connections */
+/***************/
+
+typedef struct {
+    UA_UInt32 oldId;
+    UA_UInt32 newId;
+} IdMapping;
+
+typedef struct {
+    UA_UInt32 id;
+    int fd;                  /* -1 if not (or no longer) connected */
+    Buffer captured;         /* Captured client bytes, not yet a complete chunk */
+    Buffer live;             /* Bytes received from the server */
+    UA_Boolean capturedCont; /* The last chunk was an intermediate chunk */
+    UA_Boolean sentCont;
+    UA_Boolean liveCont;
+    IdMapping *channelIds;
+    size_t channelIdsSize;
+    IdMapping *tokenIds;
+    size_t tokenIdsSize;
+    size_t pending;          /* Requests sent without a live response */
+    size_t pendingOpen;      /* OpenSecureChannel requests without a response */
+    size_t pendingSessions;  /* CreateSession requests without a response */
+} Connection;
+
+static Connection **connections;
+static size_t connectionsSize;
+
+typedef struct {
+    UA_NodeId oldToken;
+    UA_NodeId newToken;
+} TokenMapping;
+
+static TokenMapping *authTokens;
+static size_t authTokensSize;
+static size_t pendingSessions; /* CreateSession requests without a response */
+
+static Connection *
+getConnection(UA_UInt32 id, UA_Boolean create) {
+    if(id < connectionsSize && connections[id])
+        return connections[id];
+    if(!create)
+        return NULL;
+    if(id >= connectionsSize) {
+        size_t newSize = (connectionsSize > 0) ? connectionsSize : 16;
+        while(newSize <= id)
+            newSize *= 2;
+        Connection **r = (Connection**)realloc(connections, newSize * sizeof(Connection*));
+        if(!r)
+            return NULL;
+        memset(&r[connectionsSize], 0, (newSize - connectionsSize) * sizeof(Connection*));
+        connections = r;
+        connectionsSize = newSize;
+    }
+    Connection *c = (Connection*)calloc(1, sizeof(Connection));
+    if(!c)
+        return NULL;
+    c->id = id;
+    c->fd = -1;
+    connections[id] = c;
+    return c;
+}
+
+static void
+addIdMapping(IdMapping **map, size_t *mapSize, UA_UInt32 oldId, UA_UInt32 newId) {
+    for(size_t i = 0; i < *mapSize; i++) {
+        if((*map)[i].oldId == oldId) {
+            (*map)[i].newId = newId;
+            return;
+        }
+    }
+    IdMapping *r = (IdMapping*)realloc(*map, (*mapSize + 1) * sizeof(IdMapping));
+    if(!r)
+        return;
+    r[*mapSize].oldId = oldId;
+    r[*mapSize].newId = newId;
+    *map = r;
+    (*mapSize)++;
+}
+
+static UA_Boolean
+lookupIdMapping(const IdMapping *map, size_t mapSize, UA_UInt32 oldId, UA_UInt32 *newId) {
+    for(size_t i = 0; i < mapSize; i++) {
+        if(map[i].oldId == oldId) {
+            *newId = map[i].newId;
+            return true;
+        }
+    }
+    return false;
+}
+
+static const UA_NodeId *
+lookupAuthToken(const UA_NodeId *oldToken) {
+    for(size_t i = 0; i < authTokensSize; i++) {
+        if(UA_NodeId_equal(&authTokens[i].oldToken, oldToken))
+            return &authTokens[i].newToken;
+    }
+    return NULL;
+}
+
+/* Add the mappings once the captured and the live response are known */
+static void
+completeMappings(Connection *c, Request *r) {
+    if(!r->haveCaptured || !r->haveLive)
+        return;
+    if(r->type == UA_TYPES_OPENSECURECHANNELREQUEST) {
+        addIdMapping(&c->channelIds, &c->channelIdsSize, r->oldChannelId, r->newChannelId);
+        addIdMapping(&c->tokenIds, &c->tokenIdsSize, r->oldTokenId, r->newTokenId);
+    } else if(r->type == UA_TYPES_CREATESESSIONREQUEST &&
+              !UA_NodeId_isNull(&r->oldAuthToken) && !lookupAuthToken(&r->oldAuthToken)) {
+        TokenMapping *m = (TokenMapping*)
+            realloc(authTokens, (authTokensSize + 1) * sizeof(TokenMapping));
+        if(!m)
+            return;
+        authTokens = m;
+        UA_NodeId_copy(&r->oldAuthToken, &m[authTokensSize].oldToken);
+        UA_NodeId_copy(&r->newAuthToken, &m[authTokensSize].newToken);
+        authTokensSize++;
+    }
+}
+
+/* Extract the values to be rewritten from an OpenSecureChannel or CreateSession
+ * response */
+static void
+parseResponse(const UA_ByteString *chunk, size_t pos, size_t type, UA_Boolean live,
+              Request *r) {
+    if(type == UA_TYPES_OPENSECURECHANNELRESPONSE) {
+        UA_OpenSecureChannelResponse resp;
+        if(UA_decodeBinaryInternal(chunk, &pos, &resp, &UA_TYPES[type], NULL) !=
+           UA_STATUSCODE_GOOD)
+            return;
+        if(live) {
+            r->newChannelId = resp.securityToken.channelId;
+            r->newTokenId = resp.securityToken.tokenId;
+        } else {
+            r->oldChannelId = resp.securityToken.channelId;
+            r->oldTokenId = resp.securityToken.tokenId;
+        }
+        UA_OpenSecureChannelResponse_clear(&resp);
+    } else if(type == UA_TYPES_CREATESESSIONRESPONSE) {
+        UA_CreateSessionResponse resp;
+        if(UA_decodeBinaryInternal(chunk, &pos, &resp, &UA_TYPES[type], NULL) !=
+           UA_STATUSCODE_GOOD)
+            return;
+        UA_NodeId *token = live ? &r->newAuthToken : &r->oldAuthToken;
+        UA_NodeId_clear(token);
+        UA_NodeId_copy(&resp.authenticationToken, token);
+        UA_CreateSessionResponse_clear(&resp);
+    }
+}
+
+/*****************/
+/* Live Response */
+/*****************/
+
+static void
+processLiveChunk(Connection *c, const UA_ByteString *chunk, UA_DateTime now) {
+    if(isMessageType(chunk, "ERR")) {
+        fprintf(stderr, "Connection %u | The server sent an error message\n",
+                (unsigned)c->id);
+        return;
+    }
+    UA_UInt32 requestId;
+    size_t pos;
+    if(!chunkBody(chunk, &requestId, &pos))
+        return; /* ACK */
+
+    UA_Boolean first = !c->liveCont;
+    c->liveCont = (chunk->data[3] == 'C');
+    if(chunk->data[3] == 'C')
+        return; /* Only the final chunk completes the response */
+
+    Request *r = findRequest(c->id, requestId, false);
+    if(!r || !r->sent || r->haveLive)
+        return;
+    r->haveLive = true;
+    c->pending--;
+    size_t respType = UNKNOWN_TYPE;
+    if(first)
+        respType = bodyType(chunk, &pos);
+    ServiceStats *st = &stats[r->type];
+    Samples_add(&st->replayed, now - r->sentAt);
+    if(chunk->data[3] == 'A' || (first && responseIsBad(chunk, pos, respType)))
+        st->replayed.errors++;
+
+    if(r->type == UA_TYPES_OPENSECURECHANNELREQUEST) {
+        c->pendingOpen--;
+    } else if(r->type == UA_TYPES_CREATESESSIONREQUEST) {
+        c->pendingSessions--;
+        pendingSessions--;
+    }
+    if(first)
+        parseResponse(chunk, pos, respType, true, r);
+    completeMappings(c, r);
+    if(r->haveCaptured)
+        removeRequest(r);
+}
+
+static void
+closeConnection(Connection *c) {
+    if(c->fd < 0)
+        return;
+    close(c->fd);
+    c->fd = -1;
+    c->live.length = 0;
+    /* Open requests will not be answered */
+    pendingSessions -= c->pendingSessions;
+    c->pendingSessions = 0;
+    c->pending = 0;
+    c->pendingOpen = 0;
+}
+
+/* Receive from all connections until the deadline. Returns early when a
+ * response was processed. */
+static void
+pump(UA_DateTime deadline) {
+    struct pollfd *fds = (struct pollfd*)calloc(connectionsSize + 1, sizeof(struct pollfd));
+    Connection **conns = (Connection**)calloc(connectionsSize + 1, sizeof(Connection*));
+    if(!fds || !conns) {
+        free(fds);
+        free(conns);
+        return;
+    }
+    nfds_t n = 0;
+    for(size_t i = 0; i < connectionsSize; i++) {
+        if(!connections[i] || connections[i]->fd < 0)
+            continue;
+        fds[n].fd = connections[i]->fd;
+        fds[n].events = POLLIN;
+        conns[n] = connections[i];
+        n++;
+    }
+
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    int timeout = (deadline > now) ? (int)((deadline - now) / UA_DATETIME_MSEC) : 0;
+    if(n == 0) {
+        if(timeout > 0)
+            usleep((useconds_t)timeout * 1000);
+        goto cleanup;
+    }
+    if(poll(fds, n, timeout) <= 0)
+        goto cleanup;
+
+    now = UA_DateTime_nowMonotonic();
+    for(nfds_t i = 0; i < n; i++) {
+        if(!fds[i].revents)
+            continue;
+        Connection *c = conns[i];
+        UA_Byte buf[65536];
+        ssize_t received = recv(c->fd, buf, sizeof(buf), 0);
+        if(received <= 0) {
+            if(received < 0 && (errno == EAGAIN || errno == EINTR))
+                continue;
+            if(verbose)
+                fprintf(stderr, "Connection %u | Closed by the server\n", (unsigned)c->id);
+            closeConnection(c);
+            continue;
+        }
+        if(Buffer_append(&c->live, buf, (size_t)received) != 0)
+            continue;
+        size_t length;
+        while((length = completeChunk(&c->live)) > 0) {
+            UA_ByteString chunk = {length, c->live.data};
+            processLiveChunk(c, &chunk, now);
+            Buffer_consume(&c->live, length);
+        }
+    }
+
+ cleanup:
+    free(fds);
+    free(conns);
+}
+
+/******************/
+/* Replay Request */
+/******************/
+
+static void
+sendAll(Connection *c, const UA_Byte *data, size_t length) {
+    while(length > 0 && c->fd >= 0) {
+        ssize_t sent = send(c->fd, data, length, MSG_NOSIGNAL);
+        if(sent < 0) {
+            if(errno != EAGAIN && errno != EINTR) {
+                closeConnection(c);
+                return;
+            }
+            /* Receive the responses while the send buffer is full */
+            pump(UA_DateTime_nowMonotonic() + UA_DATETIME_MSEC);
+            continue;
+        }
+        data += sent;
+        length -= (size_t)sent;
+    }
+}
+
+/* Wait until a pending response is received */
+static void
+waitFor(const size_t *pending) {
+    UA_DateTime deadline = UA_DateTime_nowMonotonic() + WAIT_TIMEOUT;
+    while(*pending > 0 && UA_DateTime_nowMonotonic() < deadline)
+        pump(UA_DateTime_nowMonotonic() + 10 * UA_DATETIME_MSEC);
+}
+
+/* Rewrite the server-assigned ids in a client chunk and send it */
+static int
+replayChunk(Connection *c, UA_ByteString *chunk, UA_DateTime capturedAt) {
+    UA_Byte *data = chunk->data;
+    size_t length = chunk->length;
+    UA_Byte *rebuilt = NULL;
+
+    UA_UInt32 requestId = 0;
+    size_t pos = 0;
+    UA_Boolean hasBody = chunkBody(chunk, &requestId, &pos);
+    UA_Boolean first = !c->capturedCont;
+    if(hasBody)
+        c->capturedCont = (data[3] == 'C');
+
+    if(isMessageType(chunk, "OPN") && !isSecurityPolicyNone(chunk)) {
+        fprintf(stderr, "Error: Only captures with SecurityPolicy#None can be replayed\n");
+        return -1;
+    }
+
+    /* SecureChannel and token ids */
+    UA_Boolean msg = isMessageType(chunk, "MSG") || isMessageType(chunk, "CLO");
+    if(msg && length >= 16) {
+        UA_UInt32 newId;
+        if(!lookupIdMapping(c->channelIds, c->channelIdsSize, readUInt32(&data[8]), &newId) ||
+           !lookupIdMapping(c->tokenIds, c->tokenIdsSize, readUInt32(&data[12]), &newId)) {
+            waitFor(&c->pendingOpen);
+        }
+        if(lookupIdMapping(c->channelIds, c->channelIdsSize, readUInt32(&data[8]), &newId))
+            writeUInt32(&data[8], newId);
+        if(lookupIdMapping(c->tokenIds, c->tokenIdsSize, readUInt32(&data[12]), &newId))
+            writeUInt32(&data[12], newId);
+    } else if(isMessageType(chunk, "OPN") && length >= 12 && readUInt32(&data[8]) != 0) {
+        /* Renewal of the SecureChannel */
+        UA_UInt32 newId;
+        if(!lookupIdMapping(c->channelIds, c->channelIdsSize, readUInt32(&data[8]), &newId))
+            waitFor(&c->pendingOpen);
+        if(lookupIdMapping(c->channelIds, c->channelIdsSize, readUInt32(&data[8]), &newId))
+            writeUInt32(&data[8], newId);
+    }
+
+    /* Track the request. The type is known from the first chunk. No response
+     * is sent for CloseSecureChannel. */
+    Request *r = NULL;
+    if(hasBody && !isMessageType(chunk, "CLO")) {
+        r = findRequest(c->id, requestId, true);
+        if(r && first)
+            r->type = bodyType(chunk, &pos);
+    }
+
+    /* Rewrite the authentication token in the RequestHeader */
+    if(r && first && msg && r->type != UNKNOWN_TYPE) {
+        size_t tokenStart = pos;
+        UA_NodeId token;
+        if(UA_decodeBinaryInternal(chunk, &pos, &token, &UA_TYPES[UA_TYPES_NODEID],
+                                   NULL) == UA_STATUSCODE_GOOD) {
+            const UA_NodeId *newToken = NULL;
+            if(!UA_NodeId_isNull(&token)) {
+                newToken = lookupAuthToken(&token);
+                if(!newToken && pendingSessions > 0) {
+                    waitFor(&pendingSessions);
+                    newToken = lookupAuthToken(&token);
+                }
+            }
+            if(newToken) {
+                size_t newSize = UA_calcSizeBinary(newToken, &UA_TYPES[UA_TYPES_NODEID]);
+                size_t newLength = length - (pos - tokenStart) + newSize;
+                rebuilt = (UA_Byte*)malloc(newLength);
+                if(rebuilt) {
+                    memcpy(rebuilt, data, tokenStart);
+                    UA_Byte *p = &rebuilt[tokenStart];
+                    const UA_Byte *end = &rebuilt[tokenStart + newSize];
+                    if(UA_encodeBinaryInternal(newToken, &UA_TYPES[UA_TYPES_NODEID],
+                                               &p, &end, NULL, NULL) == UA_STATUSCODE_GOOD) {
+                        memcpy(p, &data[pos], length - pos);
+                        writeUInt32(&rebuilt[4], (UA_UInt32)newLength);
+                        data = rebuilt;
+                        length = newLength;
+                    }
+                }
+            }
+            UA_NodeId_clear(&token);
+        }
+    }
+
+    /* The request is complete with the final chunk. Take the time before
+     * sending. The response may be processed before send returns. */
+    if(r && chunk->data[3] == 'F') {
+        r->sentAt = UA_DateTime_nowMonotonic();
+        r->capturedAt = capturedAt;
+        r->sent = true;
+        c->pending++;
+        if(r->type == UA_TYPES_OPENSECURECHANNELREQUEST) {
+            c->pendingOpen++;
+        } else if(r->type == UA_TYPES_CREATESESSIONREQUEST) {
+            c->pendingSessions++;
+            pendingSessions++;
+        }
+    } else if(r && chunk->data[3] == 'A') {
+        removeRequest(r); /* Aborted by the client */
+    }
+
+    sendAll(c, data, length);
+    free(rebuilt);
+    return 0;
+}
+
+/* A captured response. Gives the original latency and the old values. */
+static void
+processCapturedResponse(Connection *c, const UA_ByteString *chunk, UA_DateTime capturedAt) {
+    UA_UInt32 requestId;
+    size_t pos;
+    if(!chunkBody(chunk, &requestId, &pos))
+        return;
+    UA_Boolean first = !c->sentCont;
+    c->sentCont = (chunk->data[3] == 'C');
+    if(chunk->data[3] == 'C')
+        return;
+    Request *r = findRequest(c->id, requestId, false);
+    if(!r || !r->sent || r->haveCaptured)
+        return;
+    r->haveCaptured = true;
+    size_t respType = UNKNOWN_TYPE;
+    if(first)
+        respType = bodyType(chunk, &pos);
+    ServiceStats *st = &stats[r->type];
+    Samples_add(&st->captured, capturedAt - r->capturedAt);
+    if(chunk->data[3] == 'A' || (first && responseIsBad(chunk, pos, respType)))
+        st->captured.errors++;
+    if(first)
+        parseResponse(chunk, pos, respType, false, r);
+    completeMappings(c, r);
+    if(r->haveLive)
+        removeRequest(r);
+}
+
+/**********/
+/* Server */
+/**********/
+
+static UA_Server *server = NULL;
+static volatile UA_Boolean serverRunning = false;
+static pthread_t serverThread;
+
+static void
+quietLog(void *context, UA_LogLevel level, UA_LogCategory category,
+         const char *msg, va_list args) {
+    (void)context, (void)level, (void)category, (void)msg, (void)args;
+}
+
+static const UA_Logger quietLogger = {quietLog, NULL, NULL};
+
+static void *
+serverLoop(void *data) {
+    (void)data;
+    while(serverRunning)
+        UA_Server_run_iterate(server, true);
+    return NULL;
+}
+
+static int
+startLocalServer(void) {
+    /* Configure before creating the server to silence the startup */
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    if(!verbose)
+        config.logger = quietLogger; /* Retained by the default config */
+    UA_ServerConfig_setMinimal(&config, localPort, NULL);
+    config.maxSecureChannels = 1000;
+    config.maxSessions = 1000;
+    server = UA_Server_newWithConfig(&config);
+    if(!server)
+        return -1;
+    if(UA_Server_run_startup(server) != UA_STATUSCODE_GOOD) {
+        UA_Server_delete(server);
+        server = NULL;
+        return -1;
+    }
+    serverRunning = true;
+    if(pthread_create(&serverThread, NULL, serverLoop, NULL) != 0) {
+        serverRunning = false;
+        UA_Server_run_shutdown(server);
+        UA_Server_delete(server);
+        server = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static void
+stopLocalServer(void) {
+    if(!server)
+        return;
+    serverRunning = false;
+    pthread_join(serverThread, NULL);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+    server = NULL;
+}
+
+/* Blocking connect, then switch to non-blocking */
+static int
+connectTo(const char *host, UA_UInt16 port) {
+    char portStr[8];
+    snprintf(portStr, sizeof(portStr), "%u", (unsigned)port);
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if(getaddrinfo(host, portStr, &hints, &res) != 0)
+        return -1;
+    int fd = -1;
+    for(struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if(fd < 0)
+            continue;
+        if(connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+            break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if(fd < 0)
+        return -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+/**********/
+/* Report */
+/**********/
+
+static void
+printReport(const char *captureFile, const char *url, size_t records,
+            UA_DateTime captureDuration, UA_DateTime replayDuration) {
+    /* Requests without a live response are lost */
+    for(size_t i = 0; i < REQUEST_HASH_SIZE; i++) {
+        while(requests[i]) {
+            Request *r = requests[i];
+            if(r->sent && !r->haveLive)
+                stats[r->type].lost++;
+            removeRequest(r);
+        }
+    }
+
+    printf("{\n  \"capture\": {\"file\": \"%s\", \"records\": %lu, \"duration\": %.3f},\n",
+           captureFile, (unsigned long)records,
+           (UA_Double)captureDuration / UA_DATETIME_SEC);
+    if(fast)
+        printf("  \"replay\": {\"url\": \"%s\", \"speed\": \"fast\", ", url);
+    else
+        printf("  \"replay\": {\"url\": \"%s\", \"speed\": %.2f, ", url, speed);
+    printf("\"duration\": %.3f},\n  \"services\": {",
+           (UA_Double)replayDuration / UA_DATETIME_SEC);
+
+    ServiceStats total;
+    memset(&total, 0, sizeof(ServiceStats));
+    UA_Boolean firstEntry = true;
+    for(size_t i = 0; i <= UNKNOWN_TYPE; i++) {
+        ServiceStats *st = &stats[i];
+        if(st->captured.size == 0 && st->replayed.size == 0 && st->lost == 0)
+            continue;
+        printf("%s\n    \"%s\": {\"lost\": %lu, \"captured_us\": ",
+               firstEntry ? "" : ",",
+               (i < UA_TYPES_COUNT) ? UA_TYPES[i].typeName : "Unknown",
+               (unsigned long)st->lost);
+        firstEntry = false;
+        printSamples(&st->captured);
+        printf(", \"replay_us\": ");
+        printSamples(&st->replayed);
+        printf("}");
+
+        for(size_t j = 0; j < st->captured.size; j++)
+            Samples_add(&total.captured, (UA_DateTime)(st->captured.values[j] * UA_DATETIME_USEC));
+        for(size_t j = 0; j < st->replayed.size; j++)
+            Samples_add(&total.replayed, (UA_DateTime)(st->replayed.values[j] * UA_DATETIME_USEC));
+        total.captured.errors += st->captured.errors;
+        total.replayed.errors += st->replayed.errors;
+        total.lost += st->lost;
+        free(st->captured.values);
+        free(st->replayed.values);
+    }
+    printf("\n  },\n  \"total\": {\"lost\": %lu, \"captured_us\": ",
+           (unsigned long)total.lost);
+    printSamples(&total.captured);
+    printf(", \"replay_us\": ");
+    printSamples(&total.replayed);
+    printf("}\n}\n");
+    free(total.captured.values);
+    free(total.replayed.values);
+}
+
+/********/
+/* Main */
+/********/
+
+static void
+usage(void) {
+    printf("Usage: ua-replay <capture-file> <server-url | local> [options]\n"
+           " <capture-file>: Recorded with UA_ServerNetworkLayerTCP_capture\n"
+           " <server-url>: opc.tcp://domain[:port]\n"
+           " local: Replay against a fresh in-process server\n"
+           " --speed <factor>: Scale the original pace [default: 1.0]\n"
+           " --fast: Send the requests as fast as possible\n"
+           " --port <port>: Port of the local server [default: 4842]\n"
+           " --verbose: Print the log output and the connection events\n"
+           " --help: Print this message\n"
+           "The latencies are reported in microseconds as JSON on stdout.\n");
+}
+
+int
+main(int argc, char **argv) {
+    if(argc < 3) {
+        usage();
+        return (argc == 2 && strcmp(argv[1], "--help") == 0) ? 0 : -1;
+    }
+    const char *captureFile = argv[1];
+    const char *url = argv[2];
+
+    for(int argpos = 3; argpos < argc; argpos++) {
+        if(strcmp(argv[argpos], "--help") == 0) {
+            usage();
+            return 0;
+        }
+        if(strcmp(argv[argpos], "--fast") == 0) {
+            fast = true;
+            continue;
+        }
+        if(strcmp(argv[argpos], "--verbose") == 0) {
+            verbose = true;
+            continue;
+        }
+        if(argpos + 1 == argc) {
+            usage();
+            return -1;
+        }
+        if(strcmp(argv[argpos], "--speed") == 0) {
+            speed = atof(argv[++argpos]);
+            if(speed <= 0.0) {
+                usage();
+                return -1;
+            }
+        } else if(strcmp(argv[argpos], "--port") == 0) {
+            localPort = (UA_UInt16)atoi(argv[++argpos]);
+        } else {
+            usage();
+            return -1;
+        }
+    }
+
+    FILE *in = fopen(captureFile, "rb");
+    if(!in) {
+        fprintf(stderr, "Could not open the capture file %s\n", captureFile);
+        return -1;
+    }
+    UA_Byte header[UA_CAPTURE_HEADERSIZE];
+    if(fread(header, UA_CAPTURE_HEADERSIZE, 1, in) != 1 ||
+       readUInt32(header) != UA_CAPTURE_MAGIC ||
+       readUInt32(&header[4]) != UA_CAPTURE_VERSION) {
+        fprintf(stderr, "%s is not a capture file\n", captureFile);
+        fclose(in);
+        return -1;
+    }
+
+    /* Resolve the server */
+    char localUrl[64];
+    if(strcmp(url, "local") == 0) {
+        if(startLocalServer() != 0) {
+            fprintf(stderr, "Could not start the local server\n");
+            fclose(in);
+            return -1;
+        }
+        snprintf(localUrl, sizeof(localUrl), "opc.tcp://127.0.0.1:%u", (unsigned)localPort);
+        url = localUrl;
+    }
+    UA_String hostname = UA_STRING_NULL, path = UA_STRING_NULL;
+    UA_UInt16 port = 4840;
+    UA_String endpointUrl = UA_STRING((char*)(uintptr_t)url);
+    if(UA_parseEndpointUrl(&endpointUrl, &hostname, &port, &path) != UA_STATUSCODE_GOOD ||
+       hostname.length >= 256) {
+        fprintf(stderr, "Could not parse the server url %s\n", url);
+        stopLocalServer();
+        fclose(in);
+        return -1;
+    }
+    char host[256];
+    memcpy(host, hostname.data, hostname.length);
+    host[hostname.length] = 0;
+
+    /* Replay the records in order */
+    int ret = 0;
+    size_t records = 0;
+    UA_DateTime captureTime = 0;
+    UA_DateTime start = UA_DateTime_nowMonotonic();
+    Buffer content = {NULL, 0, 0};
+    while(ret == 0) {
+        UA_Byte rh[UA_CAPTURE_RECORDHEADERSIZE];
+        if(fread(rh, UA_CAPTURE_RECORDHEADERSIZE, 1, in) != 1)
+            break; /* End of the capture */
+        captureTime = readInt64(rh);
+        UA_UInt32 id = readUInt32(&rh[8]);
+        UA_Byte type = rh[12];
+        size_t length = readUInt32(&rh[13]);
+        content.length = 0;
+        if(length > 0) {
+            if(content.size < length) {
+                UA_Byte *r = (UA_Byte*)realloc(content.data, length);
+                if(!r) {
+                    ret = -1;
+                    break;
+                }
+                content.data = r;
+                content.size = length;
+            }
+            if(fread(content.data, length, 1, in) != 1) {
+                fprintf(stderr, "The capture file is truncated\n");
+                break;
+            }
+            content.length = length;
+        }
+        records++;
+
+        /* Keep the original pace */
+        if(!fast) {
+            UA_DateTime due = start + (UA_DateTime)((UA_Double)captureTime / speed);
+            while(UA_DateTime_nowMonotonic() < due)
+                pump(due);
+        }
+
+        Connection *c = getConnection(id, true);
+        if(!c) {
+            ret = -1;
+            break;
+        }
+
+        switch(type) {
+        case UA_CAPTURERECORDTYPE_OPENED:
+            c->fd = connectTo(host, port);
+            if(c->fd < 0)
+                fprintf(stderr, "Connection %u | Could not connect to %s\n",
+                        (unsigned)id, url);
+            break;
+        case UA_CAPTURERECORDTYPE_RECEIVED: {
+            if(c->fd < 0)
+                break;
+            if(Buffer_append(&c->captured, content.data, content.length) != 0) {
+                ret = -1;
+                break;
+            }
+            size_t chunkLength;
+            while(ret == 0 && (chunkLength = completeChunk(&c->captured)) > 0) {
+                UA_ByteString chunk = {chunkLength, c->captured.data};
+                ret = replayChunk(c, &chunk, captureTime);
+                Buffer_consume(&c->captured, chunkLength);
+            }
+            break;
+        }
+        case UA_CAPTURERECORDTYPE_SENT: {
+            UA_ByteString chunk = {content.length, content.data};
+            if(chunk.length >= 8)
+                processCapturedResponse(c, &chunk, captureTime);
+            break;
+        }
+        case UA_CAPTURERECORDTYPE_CLOSED:
+            /* Wait for the outstanding responses before closing */
+            waitFor(&c->pending);
+            closeConnection(c);
+            break;
+        default:
+            break;
+        }
+        pump(0); /* Timestamp the responses that arrived meanwhile */
+    }
+
+    /* Wait for the outstanding responses */
+    for(size_t i = 0; i < connectionsSize; i++) {
+        if(connections[i])
+            waitFor(&connections[i]->pending);
+    }
+    UA_DateTime duration = UA_DateTime_nowMonotonic() - start;
+
+    if(ret == 0)
+        printReport(captureFile, url, records, captureTime, duration);
+
+    for(size_t i = 0; i < connectionsSize; i++) {
+        Connection *c = connections[i];
+        if(!c)
+            continue;
+        closeConnection(c);
+        free(c->captured.data);
+        free(c->live.data);
+        free(c->channelIds);
+        free(c->tokenIds);
+        free(c);
+    }
+    free(connections);
+    for(size_t i = 0; i < authTokensSize; i++) {
+        UA_NodeId_clear(&authTokens[i].oldToken);
+        UA_NodeId_clear(&authTokens[i].newToken);
+    }
+    free(authTokens);
+    free(content.data);
+    fclose(in);
+    stopLocalServer();
+    return ret;
+}
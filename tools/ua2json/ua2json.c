@@ -19,22 +19,28 @@
 #endif
 
 #include <open62541/types.h>
+#include <limits.h>
 #include <stdio.h>
+#include <time.h>
 #include <open62541/types_generated.h>
 #include <open62541/types_generated_handling.h>
 
+#ifdef UA2JSON_MULTITHREADING
+#include <pthread.h>
+#endif
+
 /* Internal headers */
 #include "ua_pubsub_networkmessage.h"
 
 static UA_StatusCode
 encode(const UA_ByteString *buf, UA_ByteString *out, const UA_DataType *type) {
-    void *data = malloc(type->memSize);
+    void *data = UA_new(type);
     if(!data)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     UA_StatusCode retval = UA_decodeBinary(buf, data, type, NULL);
     if(retval != UA_STATUSCODE_GOOD) {
-        free(data);
+        UA_free(data);
         return retval;
     }
 
@@ -50,7 +56,7 @@ encode(const UA_ByteString *buf, UA_ByteString *out, const UA_DataType *type) {
 static UA_StatusCode
 decode(const UA_ByteString *buf, UA_ByteString *out, const UA_DataType *type) {
     /* Allocate memory for the type */
-    void *data = malloc(type->memSize);
+    void *data = UA_new(type);
     if(!data)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
@@ -58,7 +64,7 @@ decode(const UA_ByteString *buf, UA_ByteString *out, const UA_DataType *type) {
     const UA_DecodeJsonOptions opt = {NULL};
     UA_StatusCode retval = UA_decodeJson(buf, data, type, &opt);
     if(retval != UA_STATUSCODE_GOOD) {
-        free(data);
+        UA_free(data);
         return retval;
     }
 
@@ -76,6 +82,7 @@ static UA_StatusCode
 encodeNetworkMessage(const UA_ByteString *buf, UA_ByteString *out) {
     size_t offset = 0;
     UA_NetworkMessage msg;
+    memset(&msg, 0, sizeof(UA_NetworkMessage));
     UA_StatusCode retval = UA_NetworkMessage_decodeBinary(buf, &offset, &msg);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
@@ -109,6 +116,7 @@ encodeNetworkMessage(const UA_ByteString *buf, UA_ByteString *out) {
 static UA_StatusCode
 decodeNetworkMessage(const UA_ByteString *buf, UA_ByteString *out) {
     UA_NetworkMessage msg;
+    memset(&msg, 0, sizeof(UA_NetworkMessage));
     UA_StatusCode retval = UA_NetworkMessage_decodeJson(&msg, buf);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
@@ -135,14 +143,549 @@ decodeNetworkMessage(const UA_ByteString *buf, UA_ByteString *out) {
 
 #endif
 
+/* Converts a single record in the configured direction */
+typedef struct {
+    UA_Boolean encode;
+    UA_Boolean pubsub;
+    const UA_DataType *type;
+} Conversion;
+
+static UA_StatusCode
+convert(const Conversion *conv, const UA_ByteString *buf, UA_ByteString *out) {
+#ifdef UA_ENABLE_PUBSUB
+    if(conv->pubsub && conv->encode)
+        return encodeNetworkMessage(buf, out);
+    if(conv->pubsub)
+        return decodeNetworkMessage(buf, out);
+#endif
+    if(conv->encode)
+        return encode(buf, out, conv->type);
+    return decode(buf, out, conv->type);
+}
+
+/*************/
+/* Streaming */
+/*************/
+
+/* In the streaming mode, the input is processed record by record with bounded
+ * memory. Batches of records are converted in parallel and written in the order
+ * of the input. The record formats are:
+ *
+ * - Binary: Every record is prefixed with its length as a little-endian
+ *   UInt32. This is the binary encoding of a sequence of ByteStrings.
+ * - JSON: One record per line. The JSON encoding contains no line breaks.
+ * - pcap: The UDP payloads from a capture file (e.g. of UADP PubSub messages).
+ *   Only used as the input for the encoding. */
+
+#define STREAM_MAX_RECORD (16 * 1024 * 1024)
+#define STREAM_BATCH_RECORDS 512
+#define STREAM_BATCH_BYTES (256 * 1024)
+
+typedef enum {
+    STREAM_FORMAT_BINARY,
+    STREAM_FORMAT_JSON,
+    STREAM_FORMAT_PCAP
+} StreamFormat;
+
+typedef enum {
+    BATCH_EMPTY,
+    BATCH_READY,      /* Input read, waiting for a worker */
+    BATCH_PROCESSING,
+    BATCH_DONE        /* Output ready, waiting to be written */
+} BatchState;
+
+/* The buffers of a batch are reused to avoid allocations per record */
+typedef struct {
+    BatchState state;
+    size_t firstRecord;   /* Position of the first record in the stream */
+    UA_Byte *in;          /* Concatenated input records */
+    size_t inSize;
+    size_t inUsed;
+    size_t *offsets;      /* Start (and end) of the records in the input */
+    size_t recordsSize;
+    UA_Byte *out;         /* Concatenated output records */
+    size_t outSize;
+    size_t outUsed;
+    size_t errors;
+} Batch;
+
+typedef struct {
+    Conversion conv;
+    FILE *in;
+    FILE *out;
+    StreamFormat inFormat;
+
+    /* pcap state */
+    UA_Boolean pcapSwapped;
+    UA_UInt32 pcapLinkType;
+
+    /* Ring of batches. Only the main thread moves head and tail.
+     * [head, next) is processing or done, [next, tail) is ready. */
+    Batch *batches;
+    size_t batchesSize;
+    size_t head;
+    size_t next;
+    size_t tail;
+    UA_Boolean shutdown;
+#ifdef UA2JSON_MULTITHREADING
+    pthread_mutex_t mutex;
+    pthread_cond_t workAvailable;
+    pthread_cond_t workDone;
+#endif
+
+    /* Statistics */
+    size_t records;
+    size_t errors;
+    size_t bytesIn;
+    size_t bytesOut;
+} Stream;
+
+static UA_UInt32
+readUInt32(const UA_Byte *p, UA_Boolean bigEndian) {
+    if(bigEndian)
+        return (UA_UInt32)p[0] << 24 | (UA_UInt32)p[1] << 16 |
+            (UA_UInt32)p[2] << 8 | (UA_UInt32)p[3];
+    return (UA_UInt32)p[3] << 24 | (UA_UInt32)p[2] << 16 |
+        (UA_UInt32)p[1] << 8 | (UA_UInt32)p[0];
+}
+
+static UA_StatusCode
+reserve(UA_Byte **buf, size_t *size, size_t required) {
+    if(required <= *size)
+        return UA_STATUSCODE_GOOD;
+    size_t newSize = (*size > 0) ? *size : 4096;
+    while(newSize < required)
+        newSize *= 2;
+    UA_Byte *r = (UA_Byte*)realloc(*buf, newSize);
+    if(!r)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    *buf = r;
+    *size = newSize;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The record readers append to the input of the batch. They return
+ * UA_STATUSCODE_GOODNODATA at the end of the stream. */
+
+static UA_StatusCode
+readBinaryRecord(Stream *s, Batch *b) {
+    UA_Byte len[4];
+    size_t c = fread(len, 1, 4, s->in);
+    if(c == 0 && feof(s->in))
+        return UA_STATUSCODE_GOODNODATA;
+    if(c != 4)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    UA_UInt32 length = readUInt32(len, false);
+    if(length > STREAM_MAX_RECORD)
+        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    UA_StatusCode res = reserve(&b->in, &b->inSize, b->inUsed + length);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    if(fread(&b->in[b->inUsed], 1, length, s->in) != length)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    b->inUsed += length;
+    s->bytesIn += 4 + (size_t)length;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+readJsonRecord(Stream *s, Batch *b) {
+    size_t start = b->inUsed;
+    while(true) {
+        /* Leave room for the terminating zero of fgets */
+        if(b->inUsed + 2 > b->inSize) {
+            if(b->inUsed - start >= STREAM_MAX_RECORD)
+                return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+            UA_StatusCode res = reserve(&b->in, &b->inSize, b->inUsed + 4096);
+            if(res != UA_STATUSCODE_GOOD)
+                return res;
+        }
+        size_t space = b->inSize - b->inUsed;
+        if(space > INT_MAX)
+            space = INT_MAX;
+        char *line = (char*)&b->in[b->inUsed];
+        if(!fgets(line, (int)space, s->in)) {
+            if(ferror(s->in))
+                return UA_STATUSCODE_BADDECODINGERROR;
+            if(b->inUsed == start)
+                return UA_STATUSCODE_GOODNODATA;
+            return UA_STATUSCODE_GOOD; /* Last line without line break */
+        }
+        size_t len = strlen(line);
+        s->bytesIn += len;
+        b->inUsed += len;
+        if(len == 0 || line[len-1] != '\n')
+            continue; /* The line continues */
+
+        /* Remove the line break. Skip empty lines. */
+        b->inUsed--;
+        if(b->inUsed > start && b->in[b->inUsed-1] == '\r')
+            b->inUsed--;
+        if(b->inUsed > start)
+            return UA_STATUSCODE_GOOD;
+    }
+}
+
+#define PCAP_LINKTYPE_NULL 0
+#define PCAP_LINKTYPE_ETHERNET 1
+#define PCAP_LINKTYPE_RAW 101
+
+static UA_StatusCode
+readPcapHeader(Stream *s) {
+    UA_Byte header[24];
+    if(fread(header, 1, 24, s->in) != 24)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    s->bytesIn += 24;
+    UA_UInt32 magic = readUInt32(header, false);
+    if(magic == 0xa1b2c3d4 || magic == 0xa1b23c4d)
+        s->pcapSwapped = false;
+    else if(magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1)
+        s->pcapSwapped = true;
+    else
+        return UA_STATUSCODE_BADDECODINGERROR;
+    s->pcapLinkType = readUInt32(&header[20], s->pcapSwapped);
+    if(s->pcapLinkType != PCAP_LINKTYPE_NULL &&
+       s->pcapLinkType != PCAP_LINKTYPE_ETHERNET &&
+       s->pcapLinkType != PCAP_LINKTYPE_RAW) {
+        fprintf(stderr, "Error: Unsupported pcap link type %u\n",
+                (unsigned)s->pcapLinkType);
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Find the UDP payload in a captured frame. Returns false if the frame does not
+ * contain an unfragmented UDP datagram. */
+static UA_Boolean
+pcapUdpPayload(const Stream *s, const UA_Byte *frame, size_t length,
+               size_t *payloadPos, size_t *payloadLength) {
+    size_t pos = 0;
+    if(s->pcapLinkType == PCAP_LINKTYPE_NULL) {
+        pos = 4;
+    } else if(s->pcapLinkType == PCAP_LINKTYPE_ETHERNET) {
+        pos = 12;
+        /* Skip VLAN tags */
+        while(pos + 2 <= length && frame[pos] == 0x81 && frame[pos+1] == 0x00)
+            pos += 4;
+        pos += 2;
+    }
+    if(pos >= length)
+        return false;
+
+    UA_Byte version = frame[pos] >> 4;
+    if(version == 4) {
+        size_t ihl = (size_t)(frame[pos] & 0x0f) * 4;
+        if(pos + 20 > length || ihl < 20 || frame[pos + 9] != 17)
+            return false;
+        /* Fragmented (more fragments or fragment offset) */
+        if((frame[pos + 6] & 0x3f) != 0 || frame[pos + 7] != 0)
+            return false;
+        pos += ihl;
+    } else if(version == 6) {
+        if(pos + 40 > length || frame[pos + 6] != 17)
+            return false;
+        pos += 40;
+    } else {
+        return false;
+    }
+
+    if(pos + 8 > length)
+        return false;
+    size_t udpLength = (size_t)frame[pos + 4] << 8 | frame[pos + 5];
+    if(udpLength < 8 || pos + udpLength > length)
+        return false;
+    *payloadPos = pos + 8;
+    *payloadLength = udpLength - 8;
+    return true;
+}
+
+static UA_StatusCode
+readPcapRecord(Stream *s, Batch *b) {
+    while(true) {
+        UA_Byte header[16];
+        size_t c = fread(header, 1, 16, s->in);
+        if(c == 0 && feof(s->in))
+            return UA_STATUSCODE_GOODNODATA;
+        if(c != 16)
+            return UA_STATUSCODE_BADDECODINGERROR;
+        UA_UInt32 length = readUInt32(&header[8], s->pcapSwapped);
+        if(length > STREAM_MAX_RECORD)
+            return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+        UA_StatusCode res = reserve(&b->in, &b->inSize, b->inUsed + length);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        UA_Byte *frame = &b->in[b->inUsed];
+        if(fread(frame, 1, length, s->in) != length)
+            return UA_STATUSCODE_BADDECODINGERROR;
+        s->bytesIn += 16 + (size_t)length;
+        size_t payloadPos, payloadLength;
+        if(!pcapUdpPayload(s, frame, length, &payloadPos, &payloadLength))
+            continue;
+        memmove(frame, &frame[payloadPos], payloadLength);
+        b->inUsed += payloadLength;
+        return UA_STATUSCODE_GOOD;
+    }
+}
+
+/* Read the next batch. Returns UA_STATUSCODE_GOODNODATA if the stream ended
+ * before the first record. */
+static UA_StatusCode
+readBatch(Stream *s, Batch *b) {
+    b->inUsed = 0;
+    b->recordsSize = 0;
+    b->offsets[0] = 0;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    while(b->recordsSize < STREAM_BATCH_RECORDS && b->inUsed < STREAM_BATCH_BYTES) {
+        switch(s->inFormat) {
+        case STREAM_FORMAT_JSON: res = readJsonRecord(s, b); break;
+        case STREAM_FORMAT_PCAP: res = readPcapRecord(s, b); break;
+        default: res = readBinaryRecord(s, b); break;
+        }
+        if(res != UA_STATUSCODE_GOOD)
+            break;
+        b->recordsSize++;
+        b->offsets[b->recordsSize] = b->inUsed;
+    }
+    if(res == UA_STATUSCODE_GOODNODATA && b->recordsSize > 0)
+        return UA_STATUSCODE_GOOD; /* The next batch returns GOODNODATA */
+    return res;
+}
+
+static void
+convertBatch(const Conversion *conv, Batch *b) {
+    b->outUsed = 0;
+    b->errors = 0;
+    for(size_t i = 0; i < b->recordsSize; i++) {
+        UA_ByteString in = {b->offsets[i+1] - b->offsets[i], &b->in[b->offsets[i]]};
+        UA_ByteString out = UA_BYTESTRING_NULL;
+        UA_StatusCode res = convert(conv, &in, &out);
+        if(res == UA_STATUSCODE_GOOD)
+            res = reserve(&b->out, &b->outSize, b->outUsed + out.length + 4);
+        if(res != UA_STATUSCODE_GOOD) {
+            b->errors++;
+            fprintf(stderr, "Error: Record %lu failed with code %s\n",
+                    (unsigned long)(b->firstRecord + i), UA_StatusCode_name(res));
+            UA_ByteString_clear(&out);
+            continue;
+        }
+
+        /* Append a line break to JSON and prefix binary with the length */
+        UA_Byte *pos = &b->out[b->outUsed];
+        if(!conv->encode) {
+            UA_UInt32 length = (UA_UInt32)out.length;
+            pos[0] = (UA_Byte)length;
+            pos[1] = (UA_Byte)(length >> 8);
+            pos[2] = (UA_Byte)(length >> 16);
+            pos[3] = (UA_Byte)(length >> 24);
+            pos += 4;
+        }
+        memcpy(pos, out.data, out.length);
+        pos += out.length;
+        if(conv->encode)
+            *pos++ = '\n';
+        b->outUsed = (size_t)(pos - b->out);
+        UA_ByteString_clear(&out);
+    }
+}
+
+#ifdef UA2JSON_MULTITHREADING
+
+static void *
+streamWorker(void *data) {
+    Stream *s = (Stream*)data;
+    pthread_mutex_lock(&s->mutex);
+    while(true) {
+        while(s->next == s->tail && !s->shutdown)
+            pthread_cond_wait(&s->workAvailable, &s->mutex);
+        if(s->next == s->tail)
+            break; /* Shutdown and no more work */
+        Batch *b = &s->batches[s->next % s->batchesSize];
+        s->next++;
+        b->state = BATCH_PROCESSING;
+        pthread_mutex_unlock(&s->mutex);
+
+        convertBatch(&s->conv, b);
+
+        pthread_mutex_lock(&s->mutex);
+        b->state = BATCH_DONE;
+        pthread_cond_broadcast(&s->workDone);
+    }
+    pthread_mutex_unlock(&s->mutex);
+    return NULL;
+}
+
+#define STREAM_LOCK(s) pthread_mutex_lock(&(s)->mutex)
+#define STREAM_UNLOCK(s) pthread_mutex_unlock(&(s)->mutex)
+#else
+#define STREAM_LOCK(s)
+#define STREAM_UNLOCK(s)
+#endif
+
+/* The main thread reads the batches into the ring and writes the converted
+ * batches in order. The workers convert the batches in between. Without
+ * workers, the main thread converts the batches itself. */
+static int
+runStream(Stream *s, size_t threads) {
+#ifndef UA2JSON_MULTITHREADING
+    threads = 0;
+#endif
+    s->batchesSize = (threads > 0) ? threads * 2 : 1;
+    s->batches = (Batch*)calloc(s->batchesSize, sizeof(Batch));
+    if(!s->batches) {
+        fprintf(stderr, "Out of memory\n");
+        return -1;
+    }
+    for(size_t i = 0; i < s->batchesSize; i++) {
+        s->batches[i].offsets =
+            (size_t*)malloc((STREAM_BATCH_RECORDS + 1) * sizeof(size_t));
+        if(!s->batches[i].offsets) {
+            fprintf(stderr, "Out of memory\n");
+            s->shutdown = true;
+        }
+    }
+
+    if(!s->shutdown && s->inFormat == STREAM_FORMAT_PCAP &&
+       readPcapHeader(s) != UA_STATUSCODE_GOOD) {
+        fprintf(stderr, "Error: Could not read the pcap file header\n");
+        s->shutdown = true;
+    }
+
+#ifdef UA2JSON_MULTITHREADING
+    pthread_t *workers = NULL;
+    size_t started = 0;
+    pthread_mutex_init(&s->mutex, NULL);
+    pthread_cond_init(&s->workAvailable, NULL);
+    pthread_cond_init(&s->workDone, NULL);
+    if(threads > 0 && !s->shutdown) {
+        workers = (pthread_t*)calloc(threads, sizeof(pthread_t));
+        for(; workers && started < threads; started++) {
+            if(pthread_create(&workers[started], NULL, streamWorker, s) != 0)
+                break;
+        }
+        if(started == 0) {
+            fprintf(stderr, "Error: Could not start the worker threads\n");
+            s->shutdown = true;
+        }
+    }
+#endif
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int retcode = s->shutdown ? -1 : 0;
+    UA_Boolean eof = s->shutdown;
+    size_t record = 0;
+    STREAM_LOCK(s);
+    while(true) {
+        /* Fill the ring. The input is read without holding the lock. The
+         * batches between tail and head are owned by the main thread. */
+        while(!eof && s->tail - s->head < s->batchesSize) {
+            Batch *b = &s->batches[s->tail % s->batchesSize];
+            STREAM_UNLOCK(s);
+            UA_StatusCode res = readBatch(s, b);
+            STREAM_LOCK(s);
+            if(res != UA_STATUSCODE_GOOD) {
+                if(res != UA_STATUSCODE_GOODNODATA) {
+                    fprintf(stderr, "Error: Reading record %lu failed with code %s\n",
+                            (unsigned long)(record + b->recordsSize),
+                            UA_StatusCode_name(res));
+                    retcode = -1;
+                }
+                eof = true;
+                break;
+            }
+            b->firstRecord = record;
+            record += b->recordsSize;
+            b->state = BATCH_READY;
+            s->tail++;
+#ifdef UA2JSON_MULTITHREADING
+            pthread_cond_signal(&s->workAvailable);
+#endif
+        }
+
+        if(s->head == s->tail)
+            break; /* All done */
+
+        /* Write the next batch in order */
+        Batch *b = &s->batches[s->head % s->batchesSize];
+        if(threads == 0) {
+            convertBatch(&s->conv, b);
+            b->state = BATCH_DONE;
+            s->next++;
+        }
+#ifdef UA2JSON_MULTITHREADING
+        while(b->state != BATCH_DONE)
+            pthread_cond_wait(&s->workDone, &s->mutex);
+#endif
+        STREAM_UNLOCK(s);
+        size_t written = fwrite(b->out, 1, b->outUsed, s->out);
+        STREAM_LOCK(s);
+        s->records += b->recordsSize;
+        s->errors += b->errors;
+        s->bytesOut += written;
+        b->state = BATCH_EMPTY;
+        s->head++;
+        if(written != b->outUsed) {
+            fprintf(stderr, "Error: Writing the output failed\n");
+            retcode = -1;
+            eof = true; /* Drain the remaining batches */
+        }
+    }
+    s->shutdown = true;
+#ifdef UA2JSON_MULTITHREADING
+    pthread_cond_broadcast(&s->workAvailable);
+#endif
+    STREAM_UNLOCK(s);
+
+#ifdef UA2JSON_MULTITHREADING
+    for(size_t i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+    free(workers);
+    pthread_cond_destroy(&s->workDone);
+    pthread_cond_destroy(&s->workAvailable);
+    pthread_mutex_destroy(&s->mutex);
+#endif
+
+    fflush(s->out);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (double)(end.tv_sec - start.tv_sec) +
+        (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    if(elapsed <= 0.0)
+        elapsed = 1e-9;
+
+    /* Throughput report */
+    fprintf(stderr, "Converted %lu records (%lu failed) in %.3fs: "
+            "%.0f records/s, in %.2f MB/s, out %.2f MB/s\n",
+            (unsigned long)s->records, (unsigned long)s->errors, elapsed,
+            (double)s->records / elapsed, (double)s->bytesIn / elapsed / 1e6,
+            (double)s->bytesOut / elapsed / 1e6);
+
+    for(size_t i = 0; i < s->batchesSize; i++) {
+        free(s->batches[i].in);
+        free(s->batches[i].out);
+        free(s->batches[i].offsets);
+    }
+    free(s->batches);
+    if(s->errors > 0)
+        retcode = -1;
+    return retcode;
+}
+
 static void
 usage(void) {
-    printf("Usage: ua2json [encode|decode] [-t dataType] [-o outputFile] [inputFile]\n"
+    printf("Usage: ua2json [encode|decode] [-t dataType] [-o outputFile] "
+           "[-s [--pcap] [-j threads]] [inputFile]\n"
            "- encode/decode: Translate UA binary input to UA JSON / "
              "Translate UA JSON input to UA binary (required)\n"
            "- dataType: UA DataType of the input (default: Variant)\n"
            "- outputFile: Output target (default: write to stdout)\n"
-           "- inputFile: Input source (default: read from stdin)\n");
+           "- inputFile: Input source (default: read from stdin)\n"
+           "- s: Stream of records. Binary records are prefixed with their "
+             "length (UInt32, little-endian), JSON records are separated by line "
+             "breaks\n"
+           "- pcap: Encode the UDP payloads from a pcap capture file\n"
+           "- threads: Number of conversion threads in the streaming mode "
+             "(default: 1)\n");
 }
 
 int main(int argc, char **argv) {
@@ -153,6 +696,9 @@ int main(int argc, char **argv) {
     const char *datatype_option = "Variant";
     const char *input_option = NULL;
     const char *output_option = NULL;
+    UA_Boolean stream_option = false;
+    UA_Boolean pcap_option = false;
+    size_t threads_option = 1;
     UA_ByteString outbuf = UA_BYTESTRING_NULL;
     UA_ByteString buf = UA_BYTESTRING_NULL;
     FILE *in = stdin;
@@ -200,6 +746,26 @@ int main(int argc, char **argv) {
             continue;
         }
 
+        if(strcmp(argv[argpos], "-s") == 0) {
+            stream_option = true;
+            continue;
+        }
+
+        if(strcmp(argv[argpos], "--pcap") == 0) {
+            pcap_option = true;
+            continue;
+        }
+
+        if(strcmp(argv[argpos], "-j") == 0) {
+            if(argpos + 1 == argc) {
+                usage();
+                return -1;
+            }
+            argpos++;
+            threads_option = (size_t)strtoul(argv[argpos], NULL, 10);
+            continue;
+        }
+
         if(argpos + 1 == argc) {
             input_option = argv[argpos];
             continue;
@@ -245,13 +811,39 @@ int main(int argc, char **argv) {
         }
     }
 
+    if(pcap_option && (!stream_option || !encode_option)) {
+        fprintf(stderr, "Error: pcap input requires the streaming mode and encode\n");
+        goto cleanup;
+    }
+
+    Conversion conv;
+    conv.encode = encode_option;
+    conv.pubsub = false;
+#ifdef UA_ENABLE_PUBSUB
+    conv.pubsub = pubsub;
+#endif
+    conv.type = type;
+
+    /* Process the input as a stream of records */
+    if(stream_option) {
+        Stream s;
+        memset(&s, 0, sizeof(Stream));
+        s.conv = conv;
+        s.in = in;
+        s.out = out;
+        s.inFormat = pcap_option ? STREAM_FORMAT_PCAP :
+            (encode_option ? STREAM_FORMAT_BINARY : STREAM_FORMAT_JSON);
+        retcode = runStream(&s, threads_option);
+        goto cleanup;
+    }
+
     /* Read input until EOF */
     size_t pos = 0;
     size_t length = 128;
     while(true) {
         if(pos >= buf.length) {
             length = length * 8;
-            UA_Byte *r = (UA_Byte*)realloc(buf.data, length);
+            UA_Byte *r = (UA_Byte*)UA_realloc(buf.data, length);
             if(!r) {
                 fprintf(stderr, "Out of memory\n");
                 goto cleanup;
@@ -278,20 +870,8 @@ int main(int argc, char **argv) {
     buf.length = pos;
 
     /* Convert */
-    UA_StatusCode result = UA_STATUSCODE_BADNOTIMPLEMENTED;
-#ifdef UA_ENABLE_PUBSUB
-    if(pubsub && encode_option) {
-        result = encodeNetworkMessage(&buf, &outbuf);
-    } else if(pubsub) {
-        result = decodeNetworkMessage(&buf, &outbuf);
-    } else
-#endif
-    if(encode_option) {
-        result = encode(&buf, &outbuf, type);
-    } else {
-        result = decode(&buf, &outbuf, type);
-    }
-    
+    UA_StatusCode result = convert(&conv, &buf, &outbuf);
+
     if(result != UA_STATUSCODE_GOOD) {
         fprintf(stderr, "Error: Parsing failed with code %s\n",
                 UA_StatusCode_name(result));